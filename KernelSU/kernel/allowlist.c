@@ -2,6 +2,7 @@
 #include "linux/compiler.h"
 #include "linux/fs.h"
 #include "linux/gfp.h"
+#include "linux/hash.h"
 #include "linux/kernel.h"
 #include "linux/list.h"
 #include "linux/printk.h"
@@ -29,13 +30,63 @@ static DEFINE_MUTEX(allowlist_mutex);
 static struct root_profile default_root_profile;
 static struct non_root_profile default_non_root_profile;
 
+// open addressed hash set of allowed uids above BITMAP_UID_MAX, -1 is empty
 static int allow_list_arr[PAGE_SIZE / sizeof(int)] __read_mostly __aligned(PAGE_SIZE);
 static int allow_list_pointer __read_mostly = 0;
+#define ALLOW_LIST_ARR_BITS ilog2(ARRAY_SIZE(allow_list_arr))
+#define ALLOW_LIST_ARR_MASK (ARRAY_SIZE(allow_list_arr) - 1)
+
+unsigned int ksu_allowlist_gen __read_mostly = 1;
+
+static void allowlist_changed(void)
+{
+	unsigned int gen = ksu_allowlist_gen + 1;
+
+	// 0 is what a task starts with, never make it look valid
+	if (unlikely(!gen))
+		gen = 1;
+	smp_wmb();
+	WRITE_ONCE(ksu_allowlist_gen, gen);
+}
+
+// returns the slot holding uid, or the empty slot where it would go
+static int *uid_arr_slot(int *arr, uid_t uid)
+{
+	unsigned int i = hash_32(uid, ALLOW_LIST_ARR_BITS);
+	int n;
+
+	// bounded: a concurrent rebuild may briefly leave no empty slot
+	for (n = 0; n < ARRAY_SIZE(allow_list_arr); n++) {
+		int v = READ_ONCE(arr[i]);
+
+		if (v == uid || v == -1)
+			return &arr[i];
+		i = (i + 1) & ALLOW_LIST_ARR_MASK;
+	}
+
+	return NULL;
+}
+
+static bool add_uid_to_arr(uid_t uid)
+{
+	int *slot = uid_arr_slot(allow_list_arr, uid);
+
+	if (slot && *slot == uid)
+		return true;
+
+	// keep one slot empty so that lookups always terminate
+	if (!slot || allow_list_pointer >= ARRAY_SIZE(allow_list_arr) - 1)
+		return false;
+
+	WRITE_ONCE(*slot, uid);
+	allow_list_pointer++;
+	return true;
+}
 
 static void remove_uid_from_arr(uid_t uid)
 {
-	int *temp_arr;
-	int i, j;
+	int *temp_arr, *slot;
+	int i;
 
 	if (allow_list_pointer == 0)
 		return;
@@ -46,17 +97,19 @@ static void remove_uid_from_arr(uid_t uid)
 		return;
 	}
 
-	for (i = j = 0; i < allow_list_pointer; i++) {
-		if (allow_list_arr[i] == uid)
+	for (i = 0; i < ARRAY_SIZE(allow_list_arr); i++)
+		temp_arr[i] = -1;
+
+	// rehash the remaining uids, removing from a probe chain would break it
+	allow_list_pointer = 0;
+	for (i = 0; i < ARRAY_SIZE(allow_list_arr); i++) {
+		if (allow_list_arr[i] == -1 || allow_list_arr[i] == uid)
 			continue;
-		temp_arr[j++] = allow_list_arr[i];
+		slot = uid_arr_slot(temp_arr, allow_list_arr[i]);
+		*slot = allow_list_arr[i];
+		allow_list_pointer++;
 	}
 
-	allow_list_pointer = j;
-
-	for (; j < ARRAY_SIZE(allow_list_arr); j++)
-		temp_arr[j] = -1;
-
 	memcpy(&allow_list_arr, temp_arr, PAGE_SIZE);
 	kfree(temp_arr);
 }
@@ -229,16 +282,16 @@ out:
 			 * 1024 apps with uid higher than BITMAP_UID_MAX
 			 * registered to request superuser?
 			 */
-			if (allow_list_pointer >= ARRAY_SIZE(allow_list_arr)) {
+			if (!add_uid_to_arr(profile->current_uid)) {
 				pr_err("too many apps registered\n");
 				WARN_ON(1);
 				return false;
 			}
-			allow_list_arr[allow_list_pointer++] = profile->current_uid;
 		} else {
 			remove_uid_from_arr(profile->current_uid);
 		}
 	}
+	allowlist_changed();
 	result = true;
 
 	// check if the default profiles is changed, cache it to a single struct to accelerate access.
@@ -262,7 +315,7 @@ out:
 
 bool __ksu_is_allow_uid(uid_t uid)
 {
-	int i;
+	int *slot;
 
 	if (unlikely(uid == 0)) {
 		// already root, but only allow our domain.
@@ -277,15 +330,31 @@ bool __ksu_is_allow_uid(uid_t uid)
 	if (likely(uid <= BITMAP_UID_MAX)) {
 		return !!(allow_list_bitmap[uid / BITS_PER_BYTE] & (1 << (uid % BITS_PER_BYTE)));
 	} else {
-		for (i = 0; i < allow_list_pointer; i++) {
-			if (allow_list_arr[i] == uid)
-				return true;
-		}
+		slot = uid_arr_slot(allow_list_arr, uid);
+		return slot && READ_ONCE(*slot) == uid;
 	}
 
 	return false;
 }
 
+bool __ksu_is_current_denied(void)
+{
+	unsigned int gen = READ_ONCE(ksu_allowlist_gen);
+	uid_t uid = current_uid().val;
+
+	smp_rmb();
+	if (ksu_is_allow_uid(uid))
+		return false;
+
+	// root depends on the selinux domain too, which the cache can't see
+	if (uid != 0) {
+		current->ksu_denied_uid = uid;
+		current->ksu_denied_gen = gen;
+	}
+
+	return true;
+}
+
 bool ksu_uid_should_umount(uid_t uid)
 {
 	struct app_profile profile = { .current_uid = uid };
@@ -463,6 +532,7 @@ void ksu_prune_allowlist(bool (*is_uid_exist)(uid_t, void *), void *data)
 			remove_uid_from_arr(uid);
 			smp_mb();
 			kfree(np);
+			allowlist_changed();
 		}
 	}
 	mutex_unlock(&allowlist_mutex);
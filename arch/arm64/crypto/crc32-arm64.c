@@ -25,6 +25,9 @@
 
 #include <crypto/internal/hash.h>
 
+#include <asm/hwcap.h>
+#include <asm/neon.h>
+
 MODULE_AUTHOR("Yazen Ghannam <yazen.ghannam@linaro.org>");
 MODULE_DESCRIPTION("CRC32 and CRC32C using optional ARMv8 instructions");
 MODULE_LICENSE("GPL v2");
@@ -38,10 +41,76 @@ MODULE_LICENSE("GPL v2");
 #define CRC32CH(crc, value) __asm__("crc32ch %w[c], %w[c], %w[v]":[c]"+r"(crc):[v]"r"(value))
 #define CRC32CB(crc, value) __asm__("crc32cb %w[c], %w[c], %w[v]":[c]"+r"(crc):[v]"r"(value))
 
+/*
+ * The CRC32 instructions have a latency of several cycles but a
+ * throughput of one per cycle, so large buffers are split into three
+ * lanes of CRC_LANE_SIZE bytes whose CRCs are computed in parallel. The
+ * lane CRCs are merged by shifting them over the following lanes: a
+ * carry-less multiply by x^(8 * n - 33) mod P, followed by one CRC32
+ * instruction on the 64-bit product, equals feeding n zero bytes.
+ */
+#define CRC_LANE_SIZE		256
+
+static bool crc32_use_pmull __read_mostly;
+
+/* x^(8 * CRC_LANE_SIZE * {2, 1} - 33) mod P, bit reflected */
+static const u32 crc32_lane_shift[2] = { 0x0c30f51d, 0xe95c1271 };
+static const u32 crc32c_lane_shift[2] = { 0xdd7e3b0c, 0xb9e02b86 };
+
+static u64 crc_pmull(u64 a, u64 b)
+{
+	u64 r;
+
+	__asm__("fmov	d0, %[a]\n\t"
+		"fmov	d1, %[b]\n\t"
+		"pmull	v0.1q, v0.1d, v1.1d\n\t"
+		"fmov	%[r], d0"
+		: [r] "=r" (r) : [a] "r" (a), [b] "r" (b) : "v0", "v1");
+	return r;
+}
+
+#define CRC32_3WAY(insn, shift)						\
+static u32 insn##_3way(u32 crc, const u8 **pp, s64 *plength)		\
+{									\
+	const u8 *p = *pp;						\
+	s64 length = *plength;						\
+	u32 crc1, crc2, merged;						\
+	u64 t0, t1;							\
+	int i;								\
+									\
+	kernel_neon_begin();						\
+	while (length >= 3 * CRC_LANE_SIZE) {				\
+		crc1 = crc2 = 0;					\
+		for (i = 0; i < CRC_LANE_SIZE; i += sizeof(u64)) {	\
+			insn(crc, get_unaligned_le64(p + i));		\
+			insn(crc1, get_unaligned_le64(p + CRC_LANE_SIZE + i));	\
+			insn(crc2, get_unaligned_le64(p + 2 * CRC_LANE_SIZE + i)); \
+		}							\
+		t0 = crc_pmull(crc, shift[0]);				\
+		t1 = crc_pmull(crc1, shift[1]);				\
+		merged = 0;						\
+		insn(merged, t0 ^ t1);					\
+		crc = merged ^ crc2;					\
+		p += 3 * CRC_LANE_SIZE;					\
+		length -= 3 * CRC_LANE_SIZE;				\
+	}								\
+	kernel_neon_end();						\
+									\
+	*pp = p;							\
+	*plength = length;						\
+	return crc;							\
+}
+
+CRC32_3WAY(CRC32X, crc32_lane_shift)
+CRC32_3WAY(CRC32CX, crc32c_lane_shift)
+
 static u32 crc32_arm64_le_hw(u32 crc, const u8 *p, unsigned int len)
 {
 	s64 length = len;
 
+	if (crc32_use_pmull && length >= 3 * CRC_LANE_SIZE)
+		crc = CRC32X_3way(crc, &p, &length);
+
 	while ((length -= sizeof(u64)) >= 0) {
 		CRC32X(crc, get_unaligned_le64(p));
 		p += sizeof(u64);
@@ -66,6 +135,9 @@ static u32 crc32c_arm64_le_hw(u32 crc, const u8 *p, unsigned int len)
 {
 	s64 length = len;
 
+	if (crc32_use_pmull && length >= 3 * CRC_LANE_SIZE)
+		crc = CRC32CX_3way(crc, &p, &length);
+
 	while ((length -= sizeof(u64)) >= 0) {
 		CRC32CX(crc, get_unaligned_le64(p));
 		p += sizeof(u64);
@@ -267,6 +339,8 @@ static int __init crc32_mod_init(void)
 {
 	int err;
 
+	crc32_use_pmull = elf_hwcap & HWCAP_PMULL;
+
 	err = crypto_register_shash(&crc32_alg);
 
 	if (err)
@@ -0,0 +1,191 @@
+/*
+ * crct10dif-ce.c - CRC T10 DIF using ARMv8 PMULL instructions
+ *
+ * Buffers of 64 bytes and more are folded 64 bytes per iteration into
+ * four 128-bit accumulators with carry-less multiplies by x^512 and
+ * x^576 mod P. The accumulators are then folded into a single 128-bit
+ * remainder, which is congruent to the input modulo the CRC polynomial,
+ * and the remainder and any tail bytes are finished by the generic code.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/cpufeature.h>
+#include <linux/crc-t10dif.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+#include <crypto/internal/hash.h>
+
+#include <asm/neon.h>
+#include <asm/unaligned.h>
+
+MODULE_DESCRIPTION("CRC T10 DIF using ARMv8 PMULL instructions");
+MODULE_LICENSE("GPL v2");
+MODULE_ALIAS_CRYPTO("crct10dif");
+
+#define CRC_T10DIF_PMULL_CHUNK_SIZE	64
+
+/*
+ * x^n mod P(x), P(x) = 0x18bb7. Lane 0 multiplies the low, lane 1 the
+ * high 64 bits of an accumulator.
+ */
+static const u64 crct10dif_fold_64[2] = { 0x1069, 0xdd31 };	/* 512, 576 */
+static const u64 crct10dif_fold_16[2] = { 0xa010, 0x1faa };	/* 128, 192 */
+
+/* accumulators hold their bytes most significant first, as CRC T10 DIF */
+#define LOAD_BE128(r)					\
+	"rev64	" r ".16b, " r ".16b\n\t"		\
+	"ext	" r ".16b, " r ".16b, " r ".16b, #8\n\t"
+
+/* acc = acc.lo * k[0] ^ acc.hi * k[1] ^ data */
+#define FOLD(acc, k, data)					\
+	"pmull	v11.1q, " acc ".1d, " k ".1d\n\t"		\
+	"pmull2	v12.1q, " acc ".2d, " k ".2d\n\t"		\
+	"eor	" acc ".16b, v11.16b, v12.16b\n\t"		\
+	"eor	" acc ".16b, " acc ".16b, " data ".16b\n\t"
+
+static u16 crc_t10dif_pmull(u16 crc, const u8 *buf, size_t len)
+{
+	u8 rem[16];
+	u64 lo, hi;
+
+	len -= CRC_T10DIF_PMULL_CHUNK_SIZE;
+
+	kernel_neon_begin();
+	asm volatile(
+	"ld1	{v0.16b-v3.16b}, [%[buf]], #64\n\t"
+	LOAD_BE128("v0") LOAD_BE128("v1") LOAD_BE128("v2") LOAD_BE128("v3")
+	"movi	v8.2d, #0\n\t"
+	"mov	v8.d[1], %[crc]\n\t"
+	"eor	v0.16b, v0.16b, v8.16b\n\t"
+	"ld1	{v9.2d}, [%[k64]]\n\t"
+	"ld1	{v10.2d}, [%[k16]]\n\t"
+
+	"0:	cmp	%[len], #64\n\t"
+	"b.lo	1f\n\t"
+	"ld1	{v4.16b-v7.16b}, [%[buf]], #64\n\t"
+	LOAD_BE128("v4") LOAD_BE128("v5") LOAD_BE128("v6") LOAD_BE128("v7")
+	FOLD("v0", "v9", "v4") FOLD("v1", "v9", "v5")
+	FOLD("v2", "v9", "v6") FOLD("v3", "v9", "v7")
+	"sub	%[len], %[len], #64\n\t"
+	"b	0b\n\t"
+
+	"1:\n\t"
+	FOLD("v0", "v10", "v1")
+	FOLD("v0", "v10", "v2")
+	FOLD("v0", "v10", "v3")
+
+	"2:	cmp	%[len], #16\n\t"
+	"b.lo	3f\n\t"
+	"ld1	{v4.16b}, [%[buf]], #16\n\t"
+	LOAD_BE128("v4")
+	FOLD("v0", "v10", "v4")
+	"sub	%[len], %[len], #16\n\t"
+	"b	2b\n\t"
+
+	"3:	mov	%[lo], v0.d[0]\n\t"
+	"mov	%[hi], v0.d[1]\n\t"
+	: [buf] "+r" (buf), [len] "+r" (len), [lo] "=r" (lo), [hi] "=r" (hi)
+	: [crc] "r" ((u64)crc << 48), [k64] "r" (crct10dif_fold_64),
+	  [k16] "r" (crct10dif_fold_16)
+	: "cc", "memory", "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7",
+	  "v8", "v9", "v10", "v11", "v12");
+	kernel_neon_end();
+
+	put_unaligned_be64(hi, rem);
+	put_unaligned_be64(lo, rem + 8);
+	crc = crc_t10dif_generic(0, rem, sizeof(rem));
+
+	return crc_t10dif_generic(crc, buf, len);
+}
+
+static u16 crc_t10dif_arm64(u16 crc, const u8 *buf, unsigned int len)
+{
+	if (len < CRC_T10DIF_PMULL_CHUNK_SIZE)
+		return crc_t10dif_generic(crc, buf, len);
+
+	return crc_t10dif_pmull(crc, buf, len);
+}
+
+struct chksum_desc_ctx {
+	u16 crc;
+};
+
+static int chksum_init(struct shash_desc *desc)
+{
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	ctx->crc = 0;
+
+	return 0;
+}
+
+static int chksum_update(struct shash_desc *desc, const u8 *data,
+			 unsigned int length)
+{
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	ctx->crc = crc_t10dif_arm64(ctx->crc, data, length);
+	return 0;
+}
+
+static int chksum_final(struct shash_desc *desc, u8 *out)
+{
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	*(u16 *)out = ctx->crc;
+	return 0;
+}
+
+static int chksum_finup(struct shash_desc *desc, const u8 *data,
+			unsigned int len, u8 *out)
+{
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	*(u16 *)out = crc_t10dif_arm64(ctx->crc, data, len);
+	return 0;
+}
+
+static int chksum_digest(struct shash_desc *desc, const u8 *data,
+			 unsigned int length, u8 *out)
+{
+	*(u16 *)out = crc_t10dif_arm64(0, data, length);
+	return 0;
+}
+
+static struct shash_alg crct10dif_alg = {
+	.digestsize		=	CRC_T10DIF_DIGEST_SIZE,
+	.init			=	chksum_init,
+	.update			=	chksum_update,
+	.final			=	chksum_final,
+	.finup			=	chksum_finup,
+	.digest			=	chksum_digest,
+	.descsize		=	sizeof(struct chksum_desc_ctx),
+	.base			=	{
+		.cra_name		=	"crct10dif",
+		.cra_driver_name	=	"crct10dif-arm64-ce",
+		.cra_priority		=	200,
+		.cra_blocksize		=	CRC_T10DIF_BLOCK_SIZE,
+		.cra_module		=	THIS_MODULE,
+	}
+};
+
+static int __init crct10dif_mod_init(void)
+{
+	return crypto_register_shash(&crct10dif_alg);
+}
+
+static void __exit crct10dif_mod_exit(void)
+{
+	crypto_unregister_shash(&crct10dif_alg);
+}
+
+module_cpu_feature_match(PMULL, crct10dif_mod_init);
+module_exit(crct10dif_mod_exit);
@@ -62,7 +62,10 @@ extern unsigned long empty_zero_page[PAGE_SIZE / sizeof(unsigned long)];
 #define pfn_pte(pfn,prot)	(__pte(((phys_addr_t)(pfn) << PAGE_SHIFT) | pgprot_val(prot)))
 
 #define pte_none(pte)		(!pte_val(pte))
-#define pte_clear(mm,addr,ptep)	set_pte(ptep, __pte(0))
+#define pte_clear(mm,addr,ptep)	do {				\
+	contpte_try_unfold(mm, addr, ptep);			\
+	set_pte(ptep, __pte(0));				\
+} while (0)
 #define pte_page(pte)		(pfn_to_page(pte_pfn(pte)))
 
 /*
@@ -232,6 +235,23 @@ struct vm_area_struct;
 
 extern void __sync_icache_dcache(pte_t pteval, unsigned long addr);
 
+/*
+ * Blocks of CONT_PTES user ptes folded into a contiguous range by the fault
+ * path carry PTE_CONT_AUTO. All entries of a range must agree on their
+ * attributes, so any change to one of them first unfolds the whole range;
+ * the access and hardware dirty state may differ and are left as they are.
+ */
+extern void __contpte_unfold(struct mm_struct *mm, unsigned long addr,
+			     pte_t *ptep);
+extern void contpte_try_fold(struct vm_area_struct *vma, unsigned long addr);
+
+static inline void contpte_try_unfold(struct mm_struct *mm, unsigned long addr,
+				      pte_t *ptep)
+{
+	if (unlikely(pte_val(*ptep) & PTE_CONT_AUTO))
+		__contpte_unfold(mm, addr, ptep);
+}
+
 /*
  * PTE bits configuration in the presence of hardware Dirty Bit Management
  * (PTE_WRITE == PTE_DBM):
@@ -250,6 +270,10 @@ extern void __sync_icache_dcache(pte_t pteval, unsigned long addr);
 static inline void set_pte_at(struct mm_struct *mm, unsigned long addr,
 			      pte_t *ptep, pte_t pte)
 {
+	contpte_try_unfold(mm, addr, ptep);
+	if (pte_val(pte) & PTE_CONT_AUTO)
+		pte_val(pte) &= ~(PTE_CONT | PTE_CONT_AUTO);
+
 	if (pte_present(pte)) {
 		if (pte_sw_dirty(pte) && pte_write(pte))
 			pte_val(pte) &= ~PTE_RDONLY;
@@ -645,6 +669,7 @@ static inline int ptep_test_and_clear_young(struct vm_area_struct *vma,
 					    unsigned long address,
 					    pte_t *ptep)
 {
+	/* the access flag may differ within a contiguous range */
 	return __ptep_test_and_clear_young(ptep);
 }
 
@@ -665,6 +690,7 @@ static inline pte_t ptep_get_and_clear(struct mm_struct *mm,
 	pteval_t old_pteval;
 	unsigned int tmp;
 
+	contpte_try_unfold(mm, address, ptep);
 	asm volatile("//	ptep_get_and_clear\n"
 	"	prfm	pstl1strm, %2\n"
 	"1:	ldxr	%0, %2\n"
@@ -694,6 +720,7 @@ static inline void ptep_set_wrprotect(struct mm_struct *mm, unsigned long addres
 	pteval_t pteval;
 	unsigned long tmp;
 
+	contpte_try_unfold(mm, address, ptep);
 	asm volatile("//	ptep_set_wrprotect\n"
 	"	prfm	pstl1strm, %2\n"
 	"1:	ldxr	%0, %2\n"
@@ -18,6 +18,15 @@
 
 #ifdef __KERNEL__
 
+/*
+ * Native tasks find their cpu and node in TPIDRRO_EL0, written on every
+ * context switch. Without VDSO_CPU_VALID, e.g. after the KPTI trampoline
+ * used the register, the vDSO asks the kernel instead.
+ */
+#define VDSO_CPU_VALID		(1UL << 63)
+#define VDSO_CPU_NODE_SHIFT	32
+#define VDSO_CPU_MASK		0xffffffffUL
+
 #ifndef __ASSEMBLY__
 
 #ifndef _VDSO_WTM_CLOCK_SEC_T
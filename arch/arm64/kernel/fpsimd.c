@@ -87,9 +87,35 @@
  * - the task gets preempted after kernel_neon_end() is called; as we have not
  *   returned from the 2nd syscall yet, TIF_FOREIGN_FPSTATE is still set so
  *   whatever is in the FPSIMD registers is not saved to memory, but discarded.
+ *
+ * Kernel mode NEON in interrupt context normally saves and restores the
+ * registers it uses. When TIF_FOREIGN_FPSTATE is set the registers hold
+ * nothing that will be used again, so this can be skipped, unless they are
+ * live for a reason the flag does not show: a kernel mode NEON section or
+ * a state load that was interrupted. The per-cpu fpsimd_regs_busy counts
+ * these, see fpsimd_regs_live().
  */
 static DEFINE_PER_CPU(struct fpsimd_state *, fpsimd_last_state);
 
+#ifdef CONFIG_KERNEL_MODE_NEON
+static DEFINE_PER_CPU(int, fpsimd_regs_busy);
+
+static inline void fpsimd_regs_get(void)
+{
+	__this_cpu_inc(fpsimd_regs_busy);
+	barrier();
+}
+
+static inline void fpsimd_regs_put(void)
+{
+	barrier();
+	__this_cpu_dec(fpsimd_regs_busy);
+}
+#else
+static inline void fpsimd_regs_get(void) { }
+static inline void fpsimd_regs_put(void) { }
+#endif
+
 /*
  * Trapped FP/ASIMD access.
  */
@@ -203,6 +229,8 @@ void fpsimd_restore_current_state(void)
 void fpsimd_update_current_state(struct fpsimd_state *state)
 {
 	preempt_disable();
+	/* the registers are live before TIF_FOREIGN_FPSTATE is cleared */
+	fpsimd_regs_get();
 	fpsimd_load_state(state);
 	if (test_and_clear_thread_flag(TIF_FOREIGN_FPSTATE)) {
 		struct fpsimd_state *st = &current->thread.fpsimd_state;
@@ -210,6 +238,7 @@ void fpsimd_update_current_state(struct fpsimd_state *state)
 		this_cpu_write(fpsimd_last_state, st);
 		st->cpu = smp_processor_id();
 	}
+	fpsimd_regs_put();
 	preempt_enable();
 }
 
@@ -226,6 +255,19 @@ void fpsimd_flush_task_state(struct task_struct *t)
 static DEFINE_PER_CPU(struct fpsimd_partial_state, hardirq_fpsimdstate);
 static DEFINE_PER_CPU(struct fpsimd_partial_state, softirq_fpsimdstate);
 
+/* num_regs of a partial state that kernel_neon_end() must not load */
+#define FPSIMD_PARTIAL_UNSAVED	U32_MAX
+
+/*
+ * Whether the interrupted context may still use the FPSIMD registers.
+ * Called from interrupt context only, which nests but does not migrate.
+ */
+static bool fpsimd_regs_live(void)
+{
+	return __this_cpu_read(fpsimd_regs_busy) ||
+	       !test_thread_flag(TIF_FOREIGN_FPSTATE);
+}
+
 /*
  * Kernel-side NEON support functions
  */
@@ -236,7 +278,11 @@ void kernel_neon_begin_partial(u32 num_regs)
 			in_irq() ? &hardirq_fpsimdstate : &softirq_fpsimdstate);
 
 		BUG_ON(num_regs > 32);
-		fpsimd_save_partial_state(s, roundup(num_regs, 2));
+		if (fpsimd_regs_live())
+			fpsimd_save_partial_state(s, roundup(num_regs, 2));
+		else
+			s->num_regs = FPSIMD_PARTIAL_UNSAVED;
+		fpsimd_regs_get();
 	} else {
 		/*
 		 * Save the userland FPSIMD state if we have one and if we
@@ -245,6 +291,7 @@ void kernel_neon_begin_partial(u32 num_regs)
 		 * registers.
 		 */
 		preempt_disable();
+		fpsimd_regs_get();
 		if (current->mm &&
 		    !test_and_set_thread_flag(TIF_FOREIGN_FPSTATE))
 			fpsimd_save_state(&current->thread.fpsimd_state);
@@ -258,8 +305,12 @@ void kernel_neon_end(void)
 	if (in_interrupt()) {
 		struct fpsimd_partial_state *s = this_cpu_ptr(
 			in_irq() ? &hardirq_fpsimdstate : &softirq_fpsimdstate);
-		fpsimd_load_partial_state(s);
+
+		fpsimd_regs_put();
+		if (s->num_regs != FPSIMD_PARTIAL_UNSAVED)
+			fpsimd_load_partial_state(s);
 	} else {
+		fpsimd_regs_put();
 		preempt_enable();
 	}
 }
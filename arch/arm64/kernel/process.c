@@ -55,6 +55,7 @@
 #include <asm/mmu_context.h>
 #include <asm/processor.h>
 #include <asm/stacktrace.h>
+#include <asm/vdso_datapage.h>
 
 #ifdef CONFIG_CC_STACKPROTECTOR
 #include <linux/stackprotector.h>
@@ -373,6 +374,15 @@ int copy_thread(unsigned long clone_flags, unsigned long stack_start,
 	return 0;
 }
 
+/* For the vDSO getcpu(), see asm/vdso_datapage.h */
+static inline u64 tls_vdso_cpu(void)
+{
+	int cpu = smp_processor_id();
+
+	return VDSO_CPU_VALID | cpu |
+	       ((u64)cpu_to_node(cpu) << VDSO_CPU_NODE_SHIFT);
+}
+
 static void tls_thread_switch(struct task_struct *next)
 {
 	unsigned long tpidr;
@@ -383,7 +393,7 @@ static void tls_thread_switch(struct task_struct *next)
 	if (is_compat_thread(task_thread_info(next)))
 		write_sysreg(next->thread.tp_value, tpidrro_el0);
 	else if (!arm64_kernel_unmapped_at_el0())
-		write_sysreg(0, tpidrro_el0);
+		write_sysreg(tls_vdso_cpu(), tpidrro_el0);
 
 	write_sysreg(*task_user_tls(next), tpidr_el0);
 }
@@ -0,0 +1,39 @@
+/*
+ * Userspace implementation of getcpu()
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/compiler.h>	/* for notrace				*/
+#include <linux/getcpu.h>	/* for struct getcpu_cache		*/
+
+#include "compiler.h"
+#include "datapage.h"
+
+/* sys_getcpu() does not look at its third argument */
+DEFINE_FALLBACK(getcpu, unsigned *, cpu, unsigned *, node)
+
+notrace int __vdso_getcpu(unsigned *cpu, unsigned *node,
+			  struct getcpu_cache *unused)
+{
+	u64 id = read_sysreg(tpidrro_el0);
+
+	if (!(id & VDSO_CPU_VALID))
+		return getcpu_fallback(cpu, node);
+
+	if (cpu)
+		*cpu = id & VDSO_CPU_MASK;
+	if (node)
+		*node = (id & ~VDSO_CPU_VALID) >> VDSO_CPU_NODE_SHIFT;
+
+	return 0;
+}
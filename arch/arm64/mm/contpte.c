@@ -0,0 +1,249 @@
+/*
+ * Automatic contiguous hint for user mappings.
+ *
+ * ART heaps, JIT code caches and dma-buf mappings are often backed by
+ * physically contiguous memory, but are mapped one page at a time. After a
+ * successful fault, contpte_try_fold() checks the naturally aligned block of
+ * CONT_PTES entries around the faulting address and, when all of them map
+ * consecutive pages with identical attributes, rewrites the block with
+ * PTE_CONT so that it takes a single TLB entry.
+ *
+ * Folded entries are marked with the software bit PTE_CONT_AUTO. The pte
+ * modifiers in asm/pgtable.h unfold a marked block before changing any of
+ * its entries, so the generic mm code never sees a partially modified
+ * contiguous range. Both operations go through invalid entries as required
+ * by the architecture, under the pte lock of the page table.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#include <linux/bitmap.h>
+#include <linux/debugfs.h>
+#include <linux/hugetlb.h>
+#include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+
+#include <asm/mmu.h>
+#include <asm/pgtable.h>
+#include <asm/tlbflush.h>
+
+enum contpte_stat {
+	CONTPTE_FOLD_ATTEMPT,
+	CONTPTE_FOLD,
+	CONTPTE_UNFOLD,
+	NR_CONTPTE_STATS,
+};
+
+static const char * const contpte_stat_names[NR_CONTPTE_STATS] = {
+	[CONTPTE_FOLD_ATTEMPT]	= "fold_attempts",
+	[CONTPTE_FOLD]		= "folds",
+	[CONTPTE_UNFOLD]	= "unfolds",
+};
+
+static DEFINE_PER_CPU(unsigned long, contpte_stats[NR_CONTPTE_STATS]);
+
+static bool contpte_enabled = true;
+
+/* the access and hardware dirty state may differ within a range */
+#define CONTPTE_HW_BITS		(PTE_AF | PTE_RDONLY)
+
+static void contpte_flush_range(struct mm_struct *mm, unsigned long start)
+{
+	unsigned long asid = ASID(mm) << 48;
+	unsigned long addr, end;
+
+	addr = asid | (start >> 12);
+	end = asid | ((start + CONT_PTE_SIZE) >> 12);
+
+	dsb(ishst);
+	for (; addr < end; addr += 1 << (PAGE_SHIFT - 12)) {
+		__tlbi(vale1is, addr);
+		__tlbi_user(vale1is, addr);
+	}
+	dsb(ish);
+}
+
+void __contpte_unfold(struct mm_struct *mm, unsigned long addr, pte_t *ptep)
+{
+	DECLARE_BITMAP(hw_af, CONT_PTES);
+	DECLARE_BITMAP(hw_rdonly, CONT_PTES);
+	pte_t *first = ptep - CONT_RANGE_OFFSET(addr);
+	pteval_t val, base = 0;
+	int i;
+
+	/*
+	 * Collect the access and dirty state the hardware may have updated
+	 * while clearing the entries. Everything else is common to the range
+	 * and was checked by contpte_try_fold().
+	 */
+	bitmap_zero(hw_af, CONT_PTES);
+	bitmap_zero(hw_rdonly, CONT_PTES);
+	for (i = 0; i < CONT_PTES; i++) {
+		val = xchg_relaxed(&pte_val(first[i]), 0);
+		VM_WARN_ON_ONCE(!(val & PTE_CONT_AUTO));
+		if (!i)
+			base = val & ~(CONTPTE_HW_BITS | PTE_CONT |
+				       PTE_CONT_AUTO);
+		if (val & PTE_AF)
+			__set_bit(i, hw_af);
+		if (val & PTE_RDONLY)
+			__set_bit(i, hw_rdonly);
+	}
+
+	contpte_flush_range(mm, addr & CONT_PTE_MASK);
+
+	for (i = 0; i < CONT_PTES; i++) {
+		val = base + ((pteval_t)i << PAGE_SHIFT);
+		if (test_bit(i, hw_af))
+			val |= PTE_AF;
+		if (test_bit(i, hw_rdonly))
+			val |= PTE_RDONLY;
+		WRITE_ONCE(pte_val(first[i]), val);
+	}
+	dsb(ishst);
+
+	this_cpu_inc(contpte_stats[CONTPTE_UNFOLD]);
+}
+
+static pmd_t *contpte_pmd(struct mm_struct *mm, unsigned long addr)
+{
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd, pmdval;
+
+	pgd = pgd_offset(mm, addr);
+	if (pgd_none(*pgd) || pgd_bad(*pgd))
+		return NULL;
+
+	pud = pud_offset(pgd, addr);
+	if (pud_none(*pud) || pud_bad(*pud))
+		return NULL;
+
+	pmd = pmd_offset(pud, addr);
+	pmdval = READ_ONCE(*pmd);
+	if (pmd_none(pmdval) || pmd_bad(pmdval))
+		return NULL;
+
+	return pmd;
+}
+
+/*
+ * Every entry must be young and, if writable, dirty: the fold then never
+ * hides a state change the fault path would otherwise have recorded.
+ */
+static bool contpte_can_fold(pte_t *first)
+{
+	pteval_t val = pte_val(*first);
+	int i;
+
+	if (!pte_valid(*first) || pte_cont(*first) || !pte_young(*first))
+		return false;
+	if (pte_write(*first) && (val & PTE_RDONLY))
+		return false;
+	if (!IS_ALIGNED(pte_pfn(*first), CONT_PTES))
+		return false;
+
+	for (i = 1; i < CONT_PTES; i++)
+		if (pte_val(first[i]) != val + ((pteval_t)i << PAGE_SHIFT))
+			return false;
+
+	return true;
+}
+
+/**
+ * contpte_try_fold() - map the block around a resolved fault as contiguous
+ * @vma:  The vma of the fault, the caller holds its mmap_sem.
+ * @addr: The faulting address.
+ */
+void contpte_try_fold(struct vm_area_struct *vma, unsigned long addr)
+{
+	struct mm_struct *mm;
+	unsigned long start = addr & CONT_PTE_MASK;
+	spinlock_t *ptl;
+	pteval_t val;
+	pmd_t *pmd;
+	pte_t *first;
+	int i;
+
+	if (!READ_ONCE(contpte_enabled) || !vma || is_vm_hugetlb_page(vma))
+		return;
+	if (start < vma->vm_start || start + CONT_PTE_SIZE > vma->vm_end)
+		return;
+
+	mm = vma->vm_mm;
+	pmd = contpte_pmd(mm, start);
+	if (!pmd)
+		return;
+
+	first = pte_offset_map_lock(mm, pmd, start, &ptl);
+	this_cpu_inc(contpte_stats[CONTPTE_FOLD_ATTEMPT]);
+	if (!contpte_can_fold(first))
+		goto out;
+
+	/*
+	 * The hardware cannot update entries that are young and dirty, so
+	 * plain stores are enough to break and remake the range.
+	 */
+	val = pte_val(*first) | PTE_CONT | PTE_CONT_AUTO;
+	for (i = 0; i < CONT_PTES; i++)
+		WRITE_ONCE(pte_val(first[i]), 0);
+
+	contpte_flush_range(mm, start);
+
+	for (i = 0; i < CONT_PTES; i++)
+		WRITE_ONCE(pte_val(first[i]),
+			   val + ((pteval_t)i << PAGE_SHIFT));
+	dsb(ishst);
+
+	this_cpu_inc(contpte_stats[CONTPTE_FOLD]);
+out:
+	pte_unmap_unlock(first, ptl);
+}
+
+static int contpte_stats_show(struct seq_file *s, void *unused)
+{
+	unsigned long sum;
+	int i, cpu;
+
+	for (i = 0; i < NR_CONTPTE_STATS; i++) {
+		sum = 0;
+		for_each_possible_cpu(cpu)
+			sum += per_cpu(contpte_stats[i], cpu);
+		seq_printf(s, "%s %lu\n", contpte_stat_names[i], sum);
+	}
+
+	return 0;
+}
+
+static int contpte_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, contpte_stats_show, NULL);
+}
+
+static const struct file_operations contpte_stats_fops = {
+	.open		= contpte_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init contpte_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("contpte", NULL);
+	if (IS_ERR_OR_NULL(dir))
+		return 0;
+
+	debugfs_create_bool("enabled", 0644, dir, &contpte_enabled);
+	debugfs_create_file("stats", 0444, dir, NULL, &contpte_stats_fops);
+
+	return 0;
+}
+late_initcall(contpte_debugfs_init);
@@ -156,6 +156,8 @@ int ptep_set_access_flags(struct vm_area_struct *vma,
 	if (pte_same(*ptep, entry))
 		return 0;
 
+	contpte_try_unfold(vma->vm_mm, address, ptep);
+
 	/* only preserve the access flags and write permission */
 	pte_val(entry) &= PTE_AF | PTE_WRITE | PTE_DIRTY;
 
@@ -301,6 +303,13 @@ out:
 	return fault;
 }
 
+/* the fault installed a mapping, no retry or error */
+static inline bool fault_mapped(int fault)
+{
+	return !(fault & (VM_FAULT_ERROR | VM_FAULT_BADMAP |
+			  VM_FAULT_BADACCESS | VM_FAULT_RETRY));
+}
+
 static inline bool is_permission_fault(unsigned int esr, struct pt_regs *regs)
 {
 	unsigned int ec       = ESR_ELx_EC(esr);
@@ -372,8 +381,14 @@ static int __kprobes do_page_fault(unsigned long addr, unsigned int esr,
 	 * mmap_sem.
 	 */
 	fault = handle_speculative_fault(mm, addr, mm_flags, &vma);
-	if (fault != VM_FAULT_RETRY)
+	if (fault != VM_FAULT_RETRY) {
+		/* the fold needs a stable vma, skip it under contention */
+		if (fault_mapped(fault) && down_read_trylock(&mm->mmap_sem)) {
+			contpte_try_fold(find_vma(mm, addr), addr);
+			up_read(&mm->mmap_sem);
+		}
 		goto done;
+	}
 
 	/*
 	 * As per x86, we may deadlock here. However, since the kernel only
@@ -432,6 +447,8 @@ retry:
 		}
 	}
 
+	if (fault_mapped(fault))
+		contpte_try_fold(vma, addr);
 	up_read(&mm->mmap_sem);
 done:
 
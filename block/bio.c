@@ -28,6 +28,7 @@
 #include <linux/mempool.h>
 #include <linux/workqueue.h>
 #include <linux/cgroup.h>
+#include <linux/cpuhotplug.h>
 
 #include <trace/events/block.h>
 
@@ -239,6 +240,158 @@ fallback:
 	return bvl;
 }
 
+/*
+ * Per cpu cache of free fs_bio_set bios. A cached bio keeps the bvec array
+ * it was last allocated with, so a stream of same sized bios from f2fs or
+ * zram writeback recycles both without going through the slab allocator.
+ * Bios completed on the submitting cpu, as polled ones are, come back to
+ * the cache they were taken from.
+ *
+ * The cache never holds bios while the mempool reserves are depleted, so
+ * the forward progress guarantees of fs_bio_set are unchanged.
+ */
+#define BIO_CACHE_MAX		64
+#define BIO_CACHE_BATCH		16
+
+struct bio_cache {
+	struct bio_list		free;
+	unsigned int		nr;
+};
+
+static DEFINE_PER_CPU(struct bio_cache, bio_cache);
+
+static void bio_cache_release(struct bio *bio)
+{
+	struct bio_set *bs = fs_bio_set;
+
+	bvec_free(bs->bvec_pool, bio->bi_io_vec, BVEC_POOL_IDX(bio));
+	mempool_free(bio, bs->bio_pool);
+}
+
+static void bio_cache_refill(gfp_t gfp_mask)
+{
+	void *bios[BIO_CACHE_BATCH];
+	struct bio_cache *cache;
+	unsigned long flags;
+	int i, nr;
+
+	nr = kmem_cache_alloc_bulk(fs_bio_set->bio_slab,
+				   (gfp_mask & ~__GFP_DIRECT_RECLAIM) |
+				   __GFP_NOWARN, BIO_CACHE_BATCH, bios);
+	for (i = 0; i < nr; i++)
+		bio_init(bios[i]);
+
+	local_irq_save(flags);
+	cache = this_cpu_ptr(&bio_cache);
+	for (i = 0; i < nr && cache->nr < BIO_CACHE_MAX; i++, cache->nr++)
+		bio_list_add_head(&cache->free, bios[i]);
+	local_irq_restore(flags);
+
+	if (i < nr)
+		kmem_cache_free_bulk(fs_bio_set->bio_slab, nr - i, &bios[i]);
+}
+
+static struct bio *bio_cache_pop(void)
+{
+	struct bio_cache *cache;
+	struct bio *bio;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	cache = this_cpu_ptr(&bio_cache);
+	bio = bio_list_pop(&cache->free);
+	if (bio)
+		cache->nr--;
+	local_irq_restore(flags);
+
+	return bio;
+}
+
+static struct bio *bio_cache_alloc(gfp_t gfp_mask, int nr_iovecs)
+{
+	mempool_t *bvec_pool = fs_bio_set->bvec_pool;
+	struct bio_vec *bvl;
+	struct bio *bio;
+	unsigned long idx;
+
+	bio = bio_cache_pop();
+	if (!bio) {
+		bio_cache_refill(gfp_mask);
+		bio = bio_cache_pop();
+		if (!bio)
+			return NULL;
+	}
+
+	idx = BVEC_POOL_IDX(bio);
+	bvl = bio->bi_io_vec;
+	bio_init(bio);
+
+	if (nr_iovecs > BIO_INLINE_VECS) {
+		if (!idx || bvec_nr_vecs(idx) < nr_iovecs) {
+			bvec_free(bvec_pool, bvl, idx);
+			/* fall back to bio_alloc_bioset() rather than sleep */
+			bvl = bvec_alloc(gfp_mask & ~__GFP_DIRECT_RECLAIM,
+					 nr_iovecs, &idx, bvec_pool);
+			if (unlikely(!bvl)) {
+				mempool_free(bio, fs_bio_set->bio_pool);
+				return NULL;
+			}
+		}
+		bio->bi_flags |= idx << BVEC_POOL_OFFSET;
+	} else {
+		bvec_free(bvec_pool, bvl, idx);
+		bvl = nr_iovecs ? bio->bi_inline_vecs : NULL;
+	}
+
+	bio->bi_pool = fs_bio_set;
+	bio->bi_max_vecs = nr_iovecs;
+	bio->bi_io_vec = bvl;
+	return bio;
+}
+
+static bool bio_cache_free(struct bio *bio)
+{
+	struct bio_set *bs = bio->bi_pool;
+	struct bio_list batch;
+	struct bio_cache *cache;
+	unsigned long flags;
+	int i;
+
+	if (bs->bio_pool->curr_nr < bs->bio_pool->min_nr ||
+	    bs->bvec_pool->curr_nr < bs->bvec_pool->min_nr)
+		return false;
+
+	bio_list_init(&batch);
+
+	local_irq_save(flags);
+	cache = this_cpu_ptr(&bio_cache);
+	if (cache->nr >= BIO_CACHE_MAX) {
+		for (i = 0; i < BIO_CACHE_BATCH; i++)
+			bio_list_add(&batch, bio_list_pop(&cache->free));
+		cache->nr -= BIO_CACHE_BATCH;
+	}
+	bio_list_add_head(&cache->free, bio);
+	cache->nr++;
+	local_irq_restore(flags);
+
+	while ((bio = bio_list_pop(&batch)))
+		bio_cache_release(bio);
+
+	return true;
+}
+
+static int bio_cpu_dead(unsigned int cpu)
+{
+	struct bio_cache *cache = per_cpu_ptr(&bio_cache, cpu);
+	struct bio *bio;
+
+	while ((bio = bio_list_pop(&cache->free)))
+		bio_cache_release(bio);
+	cache->nr = 0;
+
+	return 0;
+}
+
 static void __bio_free(struct bio *bio)
 {
 	bio_disassociate_task(bio);
@@ -254,6 +407,9 @@ static void bio_free(struct bio *bio)
 
 	__bio_free(bio);
 
+	if (bs && bs == fs_bio_set && bio_cache_free(bio))
+		return;
+
 	if (bs) {
 		bvec_free(bs->bvec_pool, bio->bi_io_vec, BVEC_POOL_IDX(bio));
 
@@ -432,6 +588,12 @@ struct bio *bio_alloc_bioset(gfp_t gfp_mask, int nr_iovecs, struct bio_set *bs)
 	struct bio *bio;
 	void *p;
 
+	if (bs && bs == fs_bio_set && nr_iovecs <= BIO_MAX_PAGES) {
+		bio = bio_cache_alloc(gfp_mask, nr_iovecs);
+		if (bio)
+			return bio;
+	}
+
 	if (!bs) {
 		if (nr_iovecs > UIO_MAXIOV)
 			return NULL;
@@ -2100,6 +2262,9 @@ static int __init init_bio(void)
 	if (bioset_integrity_create(fs_bio_set, BIO_POOL_SIZE))
 		panic("bio: can't create integrity pool\n");
 
+	cpuhp_setup_state_nocalls(CPUHP_BIO_DEAD, "block/bio:dead", NULL,
+				  bio_cpu_dead);
+
 	return 0;
 }
 subsys_initcall(init_bio);
@@ -724,6 +724,35 @@ static bool crypto_not_mergeable(const struct bio *bio, const struct bio *nxt)
 	return (!pfk_allow_merge_bio(bio, nxt));
 }
 
+/*
+ * The inline crypto engine derives the IV of every 4KB data unit from the
+ * request's starting DUN, so I/O carrying a DUN may only be merged when its
+ * data units follow on from each other.
+ */
+static bool dun_contiguous(u64 dun, unsigned int bytes, u64 next_dun)
+{
+#ifdef CONFIG_PFK
+	if (!dun && !next_dun)
+		return true;
+	if (!dun || !next_dun || (bytes & 4095))
+		return false;
+	return dun + (bytes >> 12) == next_dun;
+#else
+	return true;
+#endif
+}
+
+static bool bio_dun_mergeable(struct request *rq, struct bio *bio)
+{
+	if (blk_rq_pos(rq) + blk_rq_sectors(rq) == bio->bi_iter.bi_sector)
+		return dun_contiguous(blk_rq_dun(rq), blk_rq_bytes(rq),
+				      bio_dun(bio));
+	if (blk_rq_pos(rq) - bio_sectors(bio) == bio->bi_iter.bi_sector)
+		return dun_contiguous(bio_dun(bio), bio->bi_iter.bi_size,
+				      blk_rq_dun(rq));
+	return !blk_rq_dun(rq) && !bio_dun(bio);
+}
+
 /*
  * Has to be called with the request spinlock acquired
  */
@@ -753,6 +782,10 @@ static int attempt_merge(struct request_queue *q, struct request *req,
 
 	if (crypto_not_mergeable(req->bio, next->bio))
 		return 0;
+
+	if (!dun_contiguous(blk_rq_dun(req), blk_rq_bytes(req),
+			    blk_rq_dun(next)))
+		return 0;
 	/*
 	 * If we are allowed to merge, then append bio list
 	 * from next to rq and release next. merge_requests_fn
@@ -865,15 +898,14 @@ bool blk_rq_merge_ok(struct request *rq, struct bio *bio)
 
 	if (crypto_not_mergeable(rq->bio, bio))
 		return false;
+
+	if (!bio_dun_mergeable(rq, bio))
+		return false;
 	return true;
 }
 
 int blk_try_merge(struct request *rq, struct bio *bio)
 {
-#ifdef CONFIG_PFK
-	if (blk_rq_dun(rq) || bio_dun(bio))
-		return ELEVATOR_NO_MERGE;
-#endif
 	if (blk_rq_pos(rq) + blk_rq_sectors(rq) == bio->bi_iter.bi_sector)
 		return ELEVATOR_BACK_MERGE;
 	else if (blk_rq_pos(rq) - bio_sectors(bio) == bio->bi_iter.bi_sector)
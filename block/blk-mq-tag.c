@@ -7,6 +7,7 @@
  */
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/percpu.h>
 
 #include <linux/blk-mq.h>
 #include "blk.h"
@@ -97,20 +98,130 @@ static int __bt_get(struct blk_mq_hw_ctx *hctx, struct sbitmap_queue *bt)
 	return __sbitmap_queue_get(bt);
 }
 
+static int blk_mq_tag_cache_get(struct blk_mq_tags *tags)
+{
+	struct blk_mq_tag_cache *tc;
+	unsigned long flags;
+	int tag = -1;
+
+	if (!tags->cache_batch)
+		return -1;
+
+	tc = raw_cpu_ptr(tags->pcpu_cache);
+	spin_lock_irqsave(&tc->lock, flags);
+	if (tc->nr) {
+		tc->hits++;
+	} else {
+		/* refill half a batch, leaving room for local frees */
+		while (tc->nr < tags->cache_batch / 2) {
+			int bit = __sbitmap_queue_get(&tags->bitmap_tags);
+
+			if (bit < 0)
+				break;
+			tc->tags[tc->nr++] = bit;
+		}
+	}
+	if (tc->nr)
+		tag = tc->tags[--tc->nr];
+	spin_unlock_irqrestore(&tc->lock, flags);
+
+	return tag;
+}
+
+static void __blk_mq_tag_cache_flush(struct blk_mq_tags *tags,
+				     struct blk_mq_tag_cache *tc,
+				     unsigned int nr, unsigned int cpu)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		sbitmap_queue_clear(&tags->bitmap_tags, tc->tags[i], cpu);
+	tc->nr -= nr;
+	memmove(tc->tags, tc->tags + nr, tc->nr * sizeof(tc->tags[0]));
+}
+
+/*
+ * Hand every cached tag back to the bitmap.  Called before sleeping on a
+ * tag so that tags stranded on idle cpus can't starve the waiter.
+ */
+static void blk_mq_tag_cache_drain(struct blk_mq_tags *tags)
+{
+	struct blk_mq_tag_cache *tc;
+	unsigned long flags;
+	int cpu;
+
+	if (!tags->cache_batch)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		tc = per_cpu_ptr(tags->pcpu_cache, cpu);
+		if (!READ_ONCE(tc->nr))
+			continue;
+		spin_lock_irqsave(&tc->lock, flags);
+		__blk_mq_tag_cache_flush(tags, tc, tc->nr, cpu);
+		spin_unlock_irqrestore(&tc->lock, flags);
+	}
+}
+
+static bool blk_mq_tag_cache_put(struct blk_mq_tags *tags,
+				 unsigned int tag, unsigned int cpu)
+{
+	struct blk_mq_tag_cache *tc;
+	unsigned long flags;
+
+	if (!tags->cache_batch || atomic_read(&tags->nr_waiters) ||
+	    tag >= tags->bitmap_tags.sb.depth)
+		return false;
+
+	tc = raw_cpu_ptr(tags->pcpu_cache);
+	spin_lock_irqsave(&tc->lock, flags);
+	if (tc->nr == tags->cache_batch)
+		__blk_mq_tag_cache_flush(tags, tc, tags->cache_batch / 2, cpu);
+	tc->tags[tc->nr++] = tag;
+
+	/* pairs with the barrier in bt_get(), a new waiter must see this tag */
+	smp_mb();
+	if (atomic_read(&tags->nr_waiters))
+		__blk_mq_tag_cache_flush(tags, tc, tc->nr, cpu);
+	spin_unlock_irqrestore(&tc->lock, flags);
+
+	return true;
+}
+
+static void blk_mq_tag_wait_start(struct blk_mq_tags *tags)
+{
+	atomic_inc(&tags->nr_waiters);
+	smp_mb__after_atomic();
+	blk_mq_tag_cache_drain(tags);
+}
+
 static int bt_get(struct blk_mq_alloc_data *data, struct sbitmap_queue *bt,
 		  struct blk_mq_hw_ctx *hctx, struct blk_mq_tags *tags)
 {
+	struct blk_mq_tags *wait_tags = NULL;
 	struct sbq_wait_state *ws;
 	DEFINE_WAIT(wait);
+	u64 start = 0;
 	int tag;
 
 	tag = __bt_get(hctx, bt);
 	if (tag != -1)
 		return tag;
 
-	if (data->flags & BLK_MQ_REQ_NOWAIT)
-		return -1;
+	/*
+	 * Before waiting or failing, pull back whatever other cpus have
+	 * cached and stop caching freed tags until we're served.
+	 */
+	if (hctx) {
+		wait_tags = hctx->tags;
+		blk_mq_tag_wait_start(wait_tags);
+	}
 
+	tag = __bt_get(hctx, bt);
+	if (tag != -1 || (data->flags & BLK_MQ_REQ_NOWAIT))
+		goto out;
+
+	start = ktime_get_ns();
 	ws = bt_wait_ptr(bt, hctx);
 	do {
 		prepare_to_wait(&ws->wait, &wait, TASK_UNINTERRUPTIBLE);
@@ -147,12 +258,25 @@ static int bt_get(struct blk_mq_alloc_data *data, struct sbitmap_queue *bt,
 		} else {
 			hctx = data->hctx;
 			bt = &hctx->tags->bitmap_tags;
+			if (hctx->tags != wait_tags) {
+				atomic_dec(&wait_tags->nr_waiters);
+				wait_tags = hctx->tags;
+				blk_mq_tag_wait_start(wait_tags);
+			}
 		}
 		finish_wait(&ws->wait, &wait);
 		ws = bt_wait_ptr(bt, hctx);
 	} while (1);
 
 	finish_wait(&ws->wait, &wait);
+
+	if (wait_tags) {
+		atomic_long_inc(&wait_tags->nr_waits);
+		atomic64_add(ktime_get_ns() - start, &wait_tags->wait_ns);
+	}
+out:
+	if (wait_tags)
+		atomic_dec(&wait_tags->nr_waiters);
 	return tag;
 }
 
@@ -160,6 +284,16 @@ static unsigned int __blk_mq_get_tag(struct blk_mq_alloc_data *data)
 {
 	int tag;
 
+	/*
+	 * Shared tag maps need hctx_may_queue() fairness on every
+	 * allocation, so only private maps use the per-cpu cache.
+	 */
+	if (!(data->hctx->flags & BLK_MQ_F_TAG_SHARED)) {
+		tag = blk_mq_tag_cache_get(data->hctx->tags);
+		if (tag >= 0)
+			return tag + data->hctx->tags->nr_reserved_tags;
+	}
+
 	tag = bt_get(data, &data->hctx->tags->bitmap_tags, data->hctx,
 		     data->hctx->tags);
 	if (tag >= 0)
@@ -201,6 +335,9 @@ void blk_mq_put_tag(struct blk_mq_hw_ctx *hctx, struct blk_mq_ctx *ctx,
 		const int real_tag = tag - tags->nr_reserved_tags;
 
 		BUG_ON(real_tag >= tags->nr_tags);
+		if (!(hctx->flags & BLK_MQ_F_TAG_SHARED) &&
+		    blk_mq_tag_cache_put(tags, real_tag, ctx->cpu))
+			return;
 		sbitmap_queue_clear(&tags->bitmap_tags, real_tag, ctx->cpu);
 	} else {
 		BUG_ON(tag >= tags->nr_reserved_tags);
@@ -393,6 +530,36 @@ free_tags:
 	return NULL;
 }
 
+/*
+ * Size the per-cpu batch so that all cpus together can't cache more than
+ * the whole depth, and skip caching when not even two tags per cpu fit.
+ * Round robin allocation wants tags handed out in order, so no cache
+ * there either.
+ */
+static int blk_mq_init_tag_cache(struct blk_mq_tags *tags, int alloc_policy)
+{
+	unsigned int depth = tags->nr_tags - tags->nr_reserved_tags;
+	unsigned int batch;
+	int cpu;
+
+	if (alloc_policy == BLK_TAG_ALLOC_RR)
+		return 0;
+
+	batch = min_t(unsigned int, depth / num_possible_cpus(),
+		      BLK_MQ_TAG_PCPU_BATCH);
+	if (batch < 2)
+		return 0;
+
+	tags->pcpu_cache = alloc_percpu(struct blk_mq_tag_cache);
+	if (!tags->pcpu_cache)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(tags->pcpu_cache, cpu)->lock);
+	tags->cache_batch = batch;
+	return 0;
+}
+
 struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 				     unsigned int reserved_tags,
 				     int node, int alloc_policy)
@@ -411,11 +578,19 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 	tags->nr_tags = total_tags;
 	tags->nr_reserved_tags = reserved_tags;
 
-	return blk_mq_init_bitmap_tags(tags, node, alloc_policy);
+	if (!blk_mq_init_bitmap_tags(tags, node, alloc_policy))
+		return NULL;
+
+	if (blk_mq_init_tag_cache(tags, alloc_policy)) {
+		blk_mq_free_tags(tags);
+		return NULL;
+	}
+	return tags;
 }
 
 void blk_mq_free_tags(struct blk_mq_tags *tags)
 {
+	free_percpu(tags->pcpu_cache);
 	sbitmap_queue_free(&tags->bitmap_tags);
 	sbitmap_queue_free(&tags->breserved_tags);
 	kfree(tags);
@@ -432,6 +607,7 @@ int blk_mq_tag_update_depth(struct blk_mq_tags *tags, unsigned int tdepth)
 	 * static and should never need resizing.
 	 */
 	sbitmap_queue_resize(&tags->bitmap_tags, tdepth);
+	blk_mq_tag_cache_drain(tags);
 
 	blk_mq_tag_wakeup_all(tags, false);
 	return 0;
@@ -468,11 +644,23 @@ EXPORT_SYMBOL(blk_mq_unique_tag);
 ssize_t blk_mq_tag_sysfs_show(struct blk_mq_tags *tags, char *page)
 {
 	char *orig_page = page;
-	unsigned int free, res;
+	unsigned int free, res, cached = 0;
+	unsigned long hits = 0;
+	int cpu;
 
 	if (!tags)
 		return 0;
 
+	if (tags->cache_batch) {
+		for_each_possible_cpu(cpu) {
+			struct blk_mq_tag_cache *tc;
+
+			tc = per_cpu_ptr(tags->pcpu_cache, cpu);
+			cached += READ_ONCE(tc->nr);
+			hits += READ_ONCE(tc->hits);
+		}
+	}
+
 	page += sprintf(page, "nr_tags=%u, reserved_tags=%u, "
 			"bits_per_word=%u\n",
 			tags->nr_tags, tags->nr_reserved_tags,
@@ -483,6 +671,11 @@ ssize_t blk_mq_tag_sysfs_show(struct blk_mq_tags *tags, char *page)
 
 	page += sprintf(page, "nr_free=%u, nr_reserved=%u\n", free, res);
 	page += sprintf(page, "active_queues=%u\n", atomic_read(&tags->active_queues));
+	page += sprintf(page, "cache_batch=%u, nr_cached=%u, cache_hits=%lu\n",
+			tags->cache_batch, cached, hits);
+	page += sprintf(page, "nr_waits=%lu, wait_us=%llu\n",
+			atomic_long_read(&tags->nr_waits),
+			div_u64(atomic64_read(&tags->wait_ns), NSEC_PER_USEC));
 
 	return page - orig_page;
 }
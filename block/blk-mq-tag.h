@@ -3,6 +3,22 @@
 
 #include "blk-mq.h"
 
+enum {
+	BLK_MQ_TAG_PCPU_BATCH	= 8,
+};
+
+/*
+ * Per-cpu stash of pre-allocated tags.  Tags are taken from and returned
+ * to the local cpu's stash so that steady state submission and completion
+ * on a cpu don't touch the shared bitmap words.
+ */
+struct blk_mq_tag_cache {
+	spinlock_t lock;
+	unsigned int nr;
+	unsigned long hits;
+	unsigned int tags[BLK_MQ_TAG_PCPU_BATCH];
+};
+
 /*
  * Tag address space map.
  */
@@ -17,6 +33,14 @@ struct blk_mq_tags {
 
 	struct request **rqs;
 	struct list_head page_list;
+
+	/* zero cache_batch disables the per-cpu cache */
+	struct blk_mq_tag_cache __percpu *pcpu_cache;
+	unsigned int cache_batch;
+	atomic_t nr_waiters;
+
+	atomic_long_t nr_waits;
+	atomic64_t wait_ns;
 };
 
 
@@ -27,6 +27,7 @@
 #include <trace/events/block.h>
 
 #include <linux/blk-mq.h>
+#include <linux/blk-cgroup.h>
 #include "blk.h"
 #include "blk-mq.h"
 #include "blk-mq-tag.h"
@@ -302,6 +303,11 @@ static void __blk_mq_free_request(struct blk_mq_hw_ctx *hctx,
 		atomic_dec(&hctx->nr_active);
 	rq->cmd_flags = 0;
 
+	if (test_and_clear_bit(REQ_ATOM_FG_READ, &rq->atomic_flags) &&
+	    atomic_dec_and_test(&q->mq_fg_reads) &&
+	    waitqueue_active(&q->mq_fg_wait))
+		wake_up_all(&q->mq_fg_wait);
+
 	clear_bit(REQ_ATOM_STARTED, &rq->atomic_flags);
 	blk_mq_put_tag(hctx, ctx, tag);
 	blk_queue_exit(q);
@@ -1140,13 +1146,64 @@ void blk_mq_flush_plug_list(struct blk_plug *plug, bool from_schedule)
 	}
 }
 
+/*
+ * On Android the top-app and foreground groups live in the root blkcg,
+ * background tasks in a child group, so anything outside the root counts
+ * as background.
+ */
+static bool blk_mq_bio_is_bg(struct bio *bio)
+{
+#ifdef CONFIG_BLK_CGROUP
+	bool bg;
+
+	rcu_read_lock();
+	bg = bio_blkcg(bio) != &blkcg_root;
+	rcu_read_unlock();
+
+	return bg;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Background writes yield to foreground reads already in flight, but only
+ * for a bounded time so writeback can't be starved.  Metadata and flushes
+ * are never held back since foreground tasks may be waiting on them.
+ */
+static void blk_mq_bg_throttle(struct request_queue *q, struct bio *bio)
+{
+	unsigned int wait_ms = READ_ONCE(q->mq_bg_wait_ms);
+
+	if (!wait_ms || bio_data_dir(bio) != WRITE ||
+	    (bio->bi_opf & (REQ_META | REQ_PREFLUSH | REQ_FUA)))
+		return;
+
+	if (!atomic_read(&q->mq_fg_reads) || !blk_mq_bio_is_bg(bio))
+		return;
+
+	wait_event_timeout(q->mq_fg_wait, !atomic_read(&q->mq_fg_reads),
+			   msecs_to_jiffies(wait_ms));
+}
+
 static void blk_mq_bio_to_request(struct request *rq, struct bio *bio)
 {
 	init_request_from_bio(rq, bio);
 
+	if (READ_ONCE(rq->q->mq_bg_wait_ms) && bio_data_dir(bio) == READ &&
+	    !blk_mq_bio_is_bg(bio)) {
+		set_bit(REQ_ATOM_FG_READ, &rq->atomic_flags);
+		atomic_inc(&rq->q->mq_fg_reads);
+	}
+
 	blk_account_io_start(rq, 1);
 }
 
+static inline bool blk_mq_rq_is_fg(struct request *rq)
+{
+	return test_bit(REQ_ATOM_FG_READ, &rq->atomic_flags);
+}
+
 static inline bool hctx_allow_merges(struct blk_mq_hw_ctx *hctx)
 {
 	return (hctx->flags & BLK_MQ_F_SHOULD_MERGE) &&
@@ -1161,7 +1218,7 @@ static inline bool blk_mq_merge_queue_io(struct blk_mq_hw_ctx *hctx,
 		blk_mq_bio_to_request(rq, bio);
 		spin_lock(&ctx->lock);
 insert_rq:
-		__blk_mq_insert_request(hctx, rq, false);
+		__blk_mq_insert_request(hctx, rq, blk_mq_rq_is_fg(rq));
 		spin_unlock(&ctx->lock);
 		return false;
 	} else {
@@ -1276,6 +1333,8 @@ static blk_qc_t blk_mq_make_request(struct request_queue *q, struct bio *bio)
 	    blk_attempt_plug_merge(q, bio, &request_count, &same_queue_rq))
 		return BLK_QC_T_NONE;
 
+	blk_mq_bg_throttle(q, bio);
+
 	rq = blk_mq_map_request(q, bio, &data);
 	if (unlikely(!rq))
 		return BLK_QC_T_NONE;
@@ -1323,7 +1382,8 @@ static blk_qc_t blk_mq_make_request(struct request_queue *q, struct bio *bio)
 			goto done;
 		if (test_bit(BLK_MQ_S_STOPPED, &data.hctx->state) ||
 		    blk_mq_direct_issue_request(old_rq, &cookie) != 0)
-			blk_mq_insert_request(old_rq, false, true, true);
+			blk_mq_insert_request(old_rq, blk_mq_rq_is_fg(old_rq),
+					      true, true);
 		goto done;
 	}
 
@@ -1371,6 +1431,8 @@ static blk_qc_t blk_sq_make_request(struct request_queue *q, struct bio *bio)
 	} else
 		request_count = blk_plug_queued_count(q);
 
+	blk_mq_bg_throttle(q, bio);
+
 	rq = blk_mq_map_request(q, bio, &data);
 	if (unlikely(!rq))
 		return BLK_QC_T_NONE;
@@ -2004,6 +2066,9 @@ struct request_queue *blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	INIT_LIST_HEAD(&q->requeue_list);
 	spin_lock_init(&q->requeue_lock);
 
+	atomic_set(&q->mq_fg_reads, 0);
+	init_waitqueue_head(&q->mq_fg_wait);
+
 	if (q->nr_hw_queues > 1)
 		blk_queue_make_request(q, blk_mq_make_request);
 	else
@@ -320,6 +320,31 @@ queue_rq_affinity_store(struct request_queue *q, const char *page, size_t count)
 	return ret;
 }
 
+static ssize_t queue_bg_wait_ms_show(struct request_queue *q, char *page)
+{
+	return queue_var_show(q->mq_bg_wait_ms, page);
+}
+
+static ssize_t queue_bg_wait_ms_store(struct request_queue *q,
+				      const char *page, size_t count)
+{
+	unsigned long wait_ms;
+	ssize_t ret;
+
+	if (!q->mq_ops)
+		return -EINVAL;
+
+	ret = queue_var_store(&wait_ms, page, count);
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(q->mq_bg_wait_ms, wait_ms);
+	if (!wait_ms)
+		wake_up_all(&q->mq_fg_wait);
+
+	return ret;
+}
+
 static ssize_t queue_poll_show(struct request_queue *q, char *page)
 {
 	return queue_var_show(test_bit(QUEUE_FLAG_POLL, &q->queue_flags), page);
@@ -516,6 +541,12 @@ static struct queue_sysfs_entry queue_poll_entry = {
 	.store = queue_poll_store,
 };
 
+static struct queue_sysfs_entry queue_bg_wait_ms_entry = {
+	.attr = {.name = "bg_wait_ms", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_bg_wait_ms_show,
+	.store = queue_bg_wait_ms_store,
+};
+
 static struct queue_sysfs_entry queue_wc_entry = {
 	.attr = {.name = "write_cache", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_wc_show,
@@ -552,6 +583,7 @@ static struct attribute *default_attrs[] = {
 	&queue_iostats_entry.attr,
 	&queue_random_entry.attr,
 	&queue_poll_entry.attr,
+	&queue_bg_wait_ms_entry.attr,
 	&queue_wc_entry.attr,
 	&queue_dax_entry.attr,
 	NULL,
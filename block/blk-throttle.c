@@ -21,6 +21,16 @@ static int throtl_quantum = 32;
 /* Throttling is performed over 100ms slice and after that slice is renewed */
 static unsigned long throtl_slice = HZ/10;	/* 100 ms */
 
+/*
+ * Latency target mode: while a group with throttle.latency_target_us set
+ * sees its average read latency above target, unprotected groups get an
+ * iops cap which starts here and is halved every slice down to the
+ * minimum.  Once targets are met it doubles back and is lifted above the
+ * start value.
+ */
+#define THROTL_LAT_IOPS_START	1024
+#define THROTL_LAT_IOPS_MIN	16
+
 static struct blkcg_policy blkcg_policy_throtl;
 
 /* A workqueue to queue throttle related work */
@@ -119,12 +129,19 @@ struct throtl_grp {
 	/* are there any throtl rules between this group and td? */
 	bool has_rules[2];
 
+	/* does this group or a parent have a latency target? */
+	bool lat_protected;
+
 	/* bytes per second rate limits */
 	uint64_t bps[2];
 
 	/* IOPS limits */
 	unsigned int iops[2];
 
+	/* read latency target in usecs and the average seen so far */
+	unsigned int latency_target;
+	u64 lat_avg_us;
+
 	/* Number of bytes disptached in current slice */
 	uint64_t bytes_disp[2];
 	/* Number of bio's dispatched in current slice */
@@ -147,6 +164,11 @@ struct throtl_data
 
 	/* Work for dispatching throttled bios */
 	struct work_struct dispatch_work;
+
+	/* iops cap on unprotected groups, -1 if no latency target missed */
+	unsigned int lat_iops_cap;
+	unsigned long lat_window_start;
+	bool lat_missed;
 };
 
 static void throtl_pending_timer_fn(unsigned long arg);
@@ -338,6 +360,7 @@ static struct blkg_policy_data *throtl_pd_alloc(gfp_t gfp, int node)
 	tg->bps[WRITE] = -1;
 	tg->iops[READ] = -1;
 	tg->iops[WRITE] = -1;
+	tg->latency_target = -1;
 
 	return &tg->pd;
 }
@@ -381,6 +404,26 @@ static void tg_update_has_rules(struct throtl_grp *tg)
 	for (rw = READ; rw <= WRITE; rw++)
 		tg->has_rules[rw] = (parent_tg && parent_tg->has_rules[rw]) ||
 				    (tg->bps[rw] != -1 || tg->iops[rw] != -1);
+
+	tg->lat_protected = (parent_tg && parent_tg->lat_protected) ||
+			    tg->latency_target != -1;
+}
+
+/*
+ * Is @tg subject to the latency target iops cap?  The root group is never
+ * capped as every bio passes through it on the way up.
+ */
+static bool tg_lat_capped(struct throtl_grp *tg)
+{
+	return READ_ONCE(tg->td->lat_iops_cap) != -1 && !tg->lat_protected &&
+	       tg_to_blkg(tg)->parent;
+}
+
+static unsigned int tg_iops_limit(struct throtl_grp *tg, int rw)
+{
+	if (tg_lat_capped(tg))
+		return min(tg->iops[rw], READ_ONCE(tg->td->lat_iops_cap));
+	return tg->iops[rw];
 }
 
 static void throtl_pd_online(struct blkg_policy_data *pd)
@@ -674,6 +717,7 @@ static bool tg_with_in_iops_limit(struct throtl_grp *tg, struct bio *bio,
 				  unsigned long *wait)
 {
 	bool rw = bio_data_dir(bio);
+	unsigned int iops = tg_iops_limit(tg, rw);
 	unsigned int io_allowed;
 	unsigned long jiffy_elapsed, jiffy_wait, jiffy_elapsed_rnd;
 	u64 tmp;
@@ -693,7 +737,7 @@ static bool tg_with_in_iops_limit(struct throtl_grp *tg, struct bio *bio,
 	 * have been trimmed.
 	 */
 
-	tmp = (u64)tg->iops[rw] * jiffy_elapsed_rnd;
+	tmp = (u64)iops * jiffy_elapsed_rnd;
 	do_div(tmp, HZ);
 
 	if (tmp > UINT_MAX)
@@ -708,7 +752,7 @@ static bool tg_with_in_iops_limit(struct throtl_grp *tg, struct bio *bio,
 	}
 
 	/* Calc approx time to dispatch */
-	jiffy_wait = ((tg->io_disp[rw] + 1) * HZ)/tg->iops[rw] + 1;
+	jiffy_wait = ((tg->io_disp[rw] + 1) * HZ)/iops + 1;
 
 	if (jiffy_wait > jiffy_elapsed)
 		jiffy_wait = jiffy_wait - jiffy_elapsed;
@@ -782,7 +826,7 @@ static bool tg_may_dispatch(struct throtl_grp *tg, struct bio *bio,
 	       bio != throtl_peek_queued(&tg->service_queue.queued[rw]));
 
 	/* If tg->bps = -1, then BW is unlimited */
-	if (tg->bps[rw] == -1 && tg->iops[rw] == -1) {
+	if (tg->bps[rw] == -1 && tg_iops_limit(tg, rw) == -1) {
 		if (wait)
 			*wait = 0;
 		return true;
@@ -1259,6 +1303,12 @@ static struct cftype throtl_legacy_files[] = {
 		.seq_show = tg_print_conf_uint,
 		.write = tg_set_conf_uint,
 	},
+	{
+		.name = "throttle.latency_target_us",
+		.private = offsetof(struct throtl_grp, latency_target),
+		.seq_show = tg_print_conf_uint,
+		.write = tg_set_conf_uint,
+	},
 	{
 		.name = "throttle.io_service_bytes",
 		.private = (unsigned long)&blkcg_policy_throtl,
@@ -1412,7 +1462,8 @@ bool blk_throtl_bio(struct request_queue *q, struct blkcg_gq *blkg,
 	WARN_ON_ONCE(!rcu_read_lock_held());
 
 	/* see throtl_charge_bio() */
-	if ((bio->bi_opf & REQ_THROTTLED) || !tg->has_rules[rw])
+	if ((bio->bi_opf & REQ_THROTTLED) ||
+	    (!tg->has_rules[rw] && !tg_lat_capped(tg)))
 		goto out;
 
 	spin_lock_irq(q->queue_lock);
@@ -1495,6 +1546,73 @@ out:
 	return throttled;
 }
 
+static void throtl_update_lat_cap(struct throtl_data *td)
+{
+	unsigned int cap = td->lat_iops_cap;
+
+	if (td->lat_missed) {
+		if (cap == -1)
+			cap = THROTL_LAT_IOPS_START;
+		else
+			cap = max_t(unsigned int, cap / 2, THROTL_LAT_IOPS_MIN);
+	} else if (cap != -1) {
+		cap = cap >= THROTL_LAT_IOPS_START ? -1 : cap * 2;
+	}
+	td->lat_missed = false;
+
+	if (cap != td->lat_iops_cap) {
+		throtl_log(&td->service_queue, "latency iops cap %u", cap);
+		WRITE_ONCE(td->lat_iops_cap, cap);
+	}
+}
+
+/**
+ * blk_throtl_rq_done - feed a completed request to the latency target logic
+ * @rq: the completed request
+ *
+ * Reads from groups with a latency target update that group's average
+ * latency.  Once per throtl_slice the iops cap on unprotected groups is
+ * tightened if any target was missed and relaxed otherwise.
+ */
+void blk_throtl_rq_done(struct request *rq)
+{
+	struct throtl_data *td = rq->q->td;
+	struct request_list *rl = blk_rq_rl(rq);
+	struct throtl_grp *tg;
+	unsigned long start;
+	u64 now, lat_us;
+
+	if (!td || !rl || !rl->blkg)
+		return;
+
+	tg = blkg_to_tg(rl->blkg);
+	if (tg && tg->latency_target != -1 && rq_data_dir(rq) == READ &&
+	    rq_start_time_ns(rq)) {
+		preempt_disable();
+		now = sched_clock();
+		preempt_enable();
+
+		if (now > rq_start_time_ns(rq)) {
+			lat_us = div_u64(now - rq_start_time_ns(rq),
+					 NSEC_PER_USEC);
+			tg->lat_avg_us = (7 * tg->lat_avg_us + lat_us) >> 3;
+			if (tg->lat_avg_us > tg->latency_target)
+				td->lat_missed = true;
+		}
+	}
+
+	if (!td->lat_missed && READ_ONCE(td->lat_iops_cap) == -1)
+		return;
+
+	start = READ_ONCE(td->lat_window_start);
+	if (time_before(jiffies, start + throtl_slice))
+		return;
+	if (cmpxchg(&td->lat_window_start, start, jiffies) != start)
+		return;
+
+	throtl_update_lat_cap(td);
+}
+
 /*
  * Dispatch all bios from all children tg's queued on @parent_sq.  On
  * return, @parent_sq is guaranteed to not have any active children tg's
@@ -1570,6 +1688,8 @@ int blk_throtl_init(struct request_queue *q)
 
 	INIT_WORK(&td->dispatch_work, blk_throtl_dispatch_work_fn);
 	throtl_service_queue_init(&td->service_queue);
+	td->lat_iops_cap = -1;
+	td->lat_window_start = jiffies;
 
 	q->td = td;
 	td->queue = q;
@@ -212,6 +212,26 @@ static inline void binder_stats_created(enum binder_stat_types type)
 	atomic_inc(&binder_stats.obj_created[type]);
 }
 
+/*
+ * Always-on per-proc histograms. Bucket 0 counts zero values and bucket n
+ * values in [2^(n-1), 2^n), with the last bucket open ended.
+ */
+#define BINDER_HIST_BUCKETS 16
+
+struct binder_proc_hist {
+	u32 reply_latency[BINDER_HIST_BUCKETS];	/* usecs */
+	u32 buffer_size[BINDER_HIST_BUCKETS];	/* bytes */
+	u32 async_depth[BINDER_HIST_BUCKETS];	/* queued async txns */
+};
+
+static inline int binder_hist_bucket(u64 val)
+{
+	return min_t(int, fls64(val), BINDER_HIST_BUCKETS - 1);
+}
+
+#define binder_hist_add(proc, hist, val) \
+	this_cpu_inc((proc)->hist->hist[binder_hist_bucket(val)])
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int debug_id_done;
@@ -357,6 +377,8 @@ struct binder_error {
  *                        (invariant after initialized)
  * @async_todo:           list of async work items
  *                        (protected by @proc->inner_lock)
+ * @async_todo_count:     number of items on @async_todo
+ *                        (protected by @proc->inner_lock)
  *
  * Bookkeeping structure for binder nodes.
  */
@@ -398,6 +420,7 @@ struct binder_node {
 	};
 	bool has_async_transaction;
 	struct list_head async_todo;
+	int async_todo_count;
 };
 
 struct binder_ref_death {
@@ -517,6 +540,8 @@ struct binder_priority {
  *                        (protected by @inner_lock)
  * @stats:                per-process binder statistics
  *                        (atomics, no lock needed)
+ * @hist:                 per-cpu latency, size and async depth histograms
+ *                        (this_cpu ops, no lock needed)
  * @delivered_death:      list of delivered death notification
  *                        (protected by @inner_lock)
  * @max_threads:          cap on number of binder threads
@@ -560,6 +585,7 @@ struct binder_proc {
 
 	struct list_head todo;
 	struct binder_stats stats;
+	struct binder_proc_hist __percpu *hist;
 	struct list_head delivered_death;
 	int max_threads;
 	int requested_threads;
@@ -655,6 +681,7 @@ struct binder_transaction {
 	struct binder_priority	priority;
 	struct binder_priority	saved_priority;
 	bool    set_priority_called;
+	u64	start_ns;
 	kuid_t	sender_euid;
 	binder_uintptr_t security_ctx;
 	/**
@@ -2920,6 +2947,10 @@ static bool binder_proc_transaction(struct binder_transaction *t,
 
 	binder_inner_proc_lock(proc);
 
+	if (oneway)
+		binder_hist_add(proc, async_depth, pending_async ?
+				node->async_todo_count + 1 : 0);
+
 	if (proc->is_dead || (thread && thread->is_dead)) {
 		binder_inner_proc_unlock(proc);
 		binder_node_unlock(node);
@@ -2937,6 +2968,7 @@ static bool binder_proc_transaction(struct binder_transaction *t,
 		binder_enqueue_work_ilocked(&t->work, &proc->todo);
 	} else {
 		binder_enqueue_work_ilocked(&t->work, &node->async_todo);
+		node->async_todo_count++;
 	}
 
 	if (!pending_async)
@@ -3206,6 +3238,7 @@ static void binder_transaction(struct binder_proc *proc,
 	binder_stats_created(BINDER_STAT_TRANSACTION_COMPLETE);
 
 	t->debug_id = t_debug_id;
+	t->start_ns = ktime_get_ns();
 
 	if (reply)
 		binder_debug(BINDER_DEBUG_TRANSACTION,
@@ -3284,6 +3317,8 @@ static void binder_transaction(struct binder_proc *proc,
 		t->buffer = NULL;
 		goto err_binder_alloc_buf_failed;
 	}
+	binder_hist_add(target_proc, buffer_size,
+			tr->data_size + tr->offsets_size + extra_buffers_size);
 	if (secctx) {
 		size_t buf_offset = ALIGN(tr->data_size, sizeof(void *)) +
 				    ALIGN(tr->offsets_size, sizeof(void *)) +
@@ -3555,6 +3590,9 @@ static void binder_transaction(struct binder_proc *proc,
 		binder_enqueue_thread_work_ilocked(target_thread, &t->work);
 		binder_inner_proc_unlock(target_proc);
 		wake_up_interruptible_sync(&target_thread->wait);
+		binder_hist_add(proc, reply_latency,
+				div_u64(ktime_get_ns() - in_reply_to->start_ns,
+					NSEC_PER_USEC));
 		binder_restore_priority(current, in_reply_to->saved_priority);
 		binder_free_transaction(in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
@@ -3891,6 +3929,7 @@ static int binder_thread_write(struct binder_proc *proc,
 				if (!w) {
 					buf_node->has_async_transaction = false;
 				} else {
+					buf_node->async_todo_count--;
 					binder_enqueue_work_ilocked(
 							w, &proc->todo);
 					binder_wakeup_proc_ilocked(proc);
@@ -4717,6 +4756,7 @@ static void binder_free_proc(struct binder_proc *proc)
 	put_task_struct(proc->tsk);
 	put_cred(proc->cred);
 	binder_stats_deleted(BINDER_STAT_PROC);
+	free_percpu(proc->hist);
 	kfree(proc);
 }
 
@@ -5234,6 +5274,11 @@ static int binder_open(struct inode *nodp, struct file *filp)
 	proc = kzalloc(sizeof(*proc), GFP_KERNEL);
 	if (proc == NULL)
 		return -ENOMEM;
+	proc->hist = alloc_percpu(struct binder_proc_hist);
+	if (proc->hist == NULL) {
+		kfree(proc);
+		return -ENOMEM;
+	}
 	spin_lock_init(&proc->inner_lock);
 	spin_lock_init(&proc->outer_lock);
 	atomic_set(&proc->tmp_ref, 0);
@@ -5336,6 +5381,7 @@ static int binder_node_release(struct binder_node *node, int refs)
 
 	binder_node_lock(node);
 	binder_inner_proc_lock(proc);
+	node->async_todo_count = 0;
 	binder_dequeue_work_ilocked(&node->work);
 	/*
 	 * The caller must have taken a temporary ref on the node,
@@ -5862,6 +5908,25 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 	}
 }
 
+static void print_binder_hist(struct seq_file *m, const char *name,
+			      struct binder_proc *proc, size_t offset)
+{
+	u32 counts[BINDER_HIST_BUCKETS] = { 0 };
+	struct binder_proc_hist *hist;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		hist = per_cpu_ptr(proc->hist, cpu);
+		for (i = 0; i < BINDER_HIST_BUCKETS; i++)
+			counts[i] += ((u32 *)((char *)hist + offset))[i];
+	}
+
+	seq_printf(m, "  %s:", name);
+	for (i = 0; i < BINDER_HIST_BUCKETS; i++)
+		seq_printf(m, " %u", counts[i]);
+	seq_puts(m, "\n");
+}
+
 static void print_binder_proc_stats(struct seq_file *m,
 				    struct binder_proc *proc)
 {
@@ -5923,6 +5988,13 @@ static void print_binder_proc_stats(struct seq_file *m,
 	binder_inner_proc_unlock(proc);
 	seq_printf(m, "  pending transactions: %d\n", count);
 
+	print_binder_hist(m, "reply latency log2 us", proc,
+			  offsetof(struct binder_proc_hist, reply_latency));
+	print_binder_hist(m, "buffer size log2 bytes", proc,
+			  offsetof(struct binder_proc_hist, buffer_size));
+	print_binder_hist(m, "async depth log2", proc,
+			  offsetof(struct binder_proc_hist, async_depth));
+
 	print_binder_stats(m, "  ", &proc->stats);
 }
 
@@ -48,6 +48,12 @@ static uint32_t binder_alloc_debug_mask;
 module_param_named(debug_mask, binder_alloc_debug_mask,
 		   uint, 0644);
 
+/* Max pages populated ahead of each new buffer, 0 to populate on use only */
+static uint32_t binder_alloc_warm_pages;
+
+module_param_named(warm_pages, binder_alloc_warm_pages,
+		   uint, 0644);
+
 #define binder_alloc_debug(mask, x...) \
 	do { \
 		if (binder_alloc_debug_mask & mask) \
@@ -72,6 +78,14 @@ static size_t binder_alloc_buffer_size(struct binder_alloc *alloc,
 	return binder_buffer_next(buffer)->user_data - buffer->user_data;
 }
 
+/* Buffer sizes are multiples of sizeof(void *), returns -1 for large ones */
+static int binder_alloc_size_class(size_t size)
+{
+	size_t class = size / sizeof(void *);
+
+	return class < BINDER_ALLOC_SIZE_CLASSES ? class : -1;
+}
+
 static void binder_insert_free_buffer(struct binder_alloc *alloc,
 				      struct binder_buffer *new_buffer)
 {
@@ -80,6 +94,7 @@ static void binder_insert_free_buffer(struct binder_alloc *alloc,
 	struct binder_buffer *buffer;
 	size_t buffer_size;
 	size_t new_buffer_size;
+	int class;
 
 	BUG_ON(!new_buffer->free);
 
@@ -89,6 +104,15 @@ static void binder_insert_free_buffer(struct binder_alloc *alloc,
 		     "%d: add free buffer, size %zd, at %pK\n",
 		      alloc->pid, new_buffer_size, new_buffer);
 
+	class = binder_alloc_size_class(new_buffer_size);
+	if (class >= 0) {
+		hlist_add_head(&new_buffer->class_node,
+			       &alloc->free_classes[class]);
+		__set_bit(class, alloc->free_classes_map);
+		new_buffer->in_size_class = 1;
+		return;
+	}
+
 	while (*p) {
 		parent = *p;
 		buffer = rb_entry(parent, struct binder_buffer, rb_node);
@@ -105,6 +129,76 @@ static void binder_insert_free_buffer(struct binder_alloc *alloc,
 	rb_insert_color(&new_buffer->rb_node, &alloc->free_buffers);
 }
 
+/*
+ * Must be called before the buffer's size changes, as that decides which
+ * free list it is on
+ */
+static void binder_erase_free_buffer(struct binder_alloc *alloc,
+				     struct binder_buffer *buffer)
+{
+	int class;
+
+	BUG_ON(!buffer->free);
+
+	if (!buffer->in_size_class) {
+		rb_erase(&buffer->rb_node, &alloc->free_buffers);
+		return;
+	}
+
+	class = binder_alloc_size_class(binder_alloc_buffer_size(alloc, buffer));
+	hlist_del(&buffer->class_node);
+	if (hlist_empty(&alloc->free_classes[class]))
+		__clear_bit(class, alloc->free_classes_map);
+	buffer->in_size_class = 0;
+}
+
+/*
+ * Best fit: the smallest non-empty size class that fits, otherwise the
+ * smallest buffer in the rb tree that fits. Everything in the tree is
+ * larger than every size class so this matches a single best fit search.
+ */
+static struct binder_buffer *binder_alloc_find_free_buffer(
+		struct binder_alloc *alloc, size_t size)
+{
+	struct rb_node *n = alloc->free_buffers.rb_node;
+	struct binder_buffer *buffer;
+	struct rb_node *best_fit = NULL;
+	size_t buffer_size;
+	int class;
+
+	class = binder_alloc_size_class(size);
+	if (class >= 0) {
+		class = find_next_bit(alloc->free_classes_map,
+				      BINDER_ALLOC_SIZE_CLASSES, class);
+		if (class < BINDER_ALLOC_SIZE_CLASSES) {
+			alloc->class_allocs++;
+			return hlist_entry(alloc->free_classes[class].first,
+					   struct binder_buffer, class_node);
+		}
+	}
+
+	while (n) {
+		buffer = rb_entry(n, struct binder_buffer, rb_node);
+		BUG_ON(!buffer->free);
+		buffer_size = binder_alloc_buffer_size(alloc, buffer);
+
+		if (size < buffer_size) {
+			best_fit = n;
+			n = n->rb_left;
+		} else if (size > buffer_size)
+			n = n->rb_right;
+		else {
+			best_fit = n;
+			break;
+		}
+	}
+	if (!best_fit)
+		return NULL;
+
+	alloc->tree_allocs++;
+	return rb_entry(best_fit, struct binder_buffer, rb_node);
+}
+
 static void binder_insert_allocated_buffer_locked(
 		struct binder_alloc *alloc, struct binder_buffer *new_buffer)
 {
@@ -319,6 +413,38 @@ err_no_vma:
 	return vma ? -ENOMEM : -ESRCH;
 }
 
+/*
+ * Populate the unused pages just past a new buffer, as many as recent
+ * transactions have needed, so the next buffers find them mapped. They
+ * are put straight on the lru like every other page of a free buffer,
+ * so binder_shrink_scan() trims them under memory pressure.
+ */
+static void binder_alloc_warm_range(struct binder_alloc *alloc, size_t size,
+				    void __user *start, void __user *limit)
+{
+	void __user *end, *page_addr;
+	size_t pages, index;
+
+	alloc->txn_size_avg = (alloc->txn_size_avg * 7 + size) / 8;
+	pages = DIV_ROUND_UP(alloc->txn_size_avg, PAGE_SIZE);
+	pages = min_t(size_t, pages, binder_alloc_warm_pages);
+
+	end = start + pages * PAGE_SIZE;
+	if (end > limit)
+		end = limit;
+
+	for (page_addr = start; page_addr < end; page_addr += PAGE_SIZE) {
+		index = (page_addr - alloc->buffer) / PAGE_SIZE;
+		if (!alloc->pages[index].page_ptr)
+			break;
+	}
+	if (page_addr >= end)
+		return;
+
+	if (!binder_update_page_range(alloc, 1, page_addr, end))
+		binder_update_page_range(alloc, 0, page_addr, end);
+}
+
 static void debug_low_async_space_locked(struct binder_alloc *alloc, int pid)
 {
 	/*
@@ -364,14 +490,13 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 				int is_async,
 				int pid)
 {
-	struct rb_node *n = alloc->free_buffers.rb_node;
-	struct binder_buffer *buffer;
+	struct rb_node *n;
+	struct binder_buffer *buffer, *new_buffer = NULL;
 	size_t buffer_size;
-	struct rb_node *best_fit = NULL;
 	void __user *has_page_addr;
 	void __user *end_page_addr;
 	size_t size, data_offsets_size;
-	int ret;
+	int ret, class;
 
 	if (alloc->vma == NULL) {
 		pr_err("%d: binder_alloc_buf, no vma\n",
@@ -406,22 +531,8 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	/* Pad 0-size buffers so they get assigned unique addresses */
 	size = max(size, sizeof(void *));
 
-	while (n) {
-		buffer = rb_entry(n, struct binder_buffer, rb_node);
-		BUG_ON(!buffer->free);
-		buffer_size = binder_alloc_buffer_size(alloc, buffer);
-
-		if (size < buffer_size) {
-			best_fit = n;
-			n = n->rb_left;
-		} else if (size > buffer_size)
-			n = n->rb_right;
-		else {
-			best_fit = n;
-			break;
-		}
-	}
-	if (best_fit == NULL) {
+	buffer = binder_alloc_find_free_buffer(alloc, size);
+	if (buffer == NULL) {
 		size_t allocated_buffers = 0;
 		size_t largest_alloc_size = 0;
 		size_t total_alloc_size = 0;
@@ -447,6 +558,16 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			if (buffer_size > largest_free_size)
 				largest_free_size = buffer_size;
 		}
+		for (class = 0; class < BINDER_ALLOC_SIZE_CLASSES; class++) {
+			hlist_for_each_entry(buffer, &alloc->free_classes[class],
+					     class_node) {
+				buffer_size = class * sizeof(void *);
+				free_buffers++;
+				total_free_size += buffer_size;
+				if (buffer_size > largest_free_size)
+					largest_free_size = buffer_size;
+			}
+		}
 		pr_err("%d: binder_alloc_buf size %zd failed, no address space\n",
 			alloc->pid, size);
 		pr_err("allocated: %zd (num: %zd largest: %zd), free: %zd (num: %zd largest: %zd)\n",
@@ -454,10 +575,7 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		       total_free_size, free_buffers, largest_free_size);
 		return ERR_PTR(-ENOSPC);
 	}
-	if (n == NULL) {
-		buffer = rb_entry(best_fit, struct binder_buffer, rb_node);
-		buffer_size = binder_alloc_buffer_size(alloc, buffer);
-	}
+	buffer_size = binder_alloc_buffer_size(alloc, buffer);
 
 	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
 		     "%d: binder_alloc_buf size %zd got buffer %pK size %zd\n",
@@ -465,7 +583,6 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 
 	has_page_addr = (void __user *)
 		(((uintptr_t)buffer->user_data + buffer_size) & PAGE_MASK);
-	WARN_ON(n && buffer_size != size);
 	end_page_addr =
 		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data + size);
 	if (end_page_addr > has_page_addr)
@@ -476,21 +593,22 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		return ERR_PTR(ret);
 
 	if (buffer_size != size) {
-		struct binder_buffer *new_buffer;
-
 		new_buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
 		if (!new_buffer) {
 			pr_err("%s: %d failed to alloc new buffer struct\n",
 			       __func__, alloc->pid);
 			goto err_alloc_buf_struct_failed;
 		}
+	}
+
+	binder_erase_free_buffer(alloc, buffer);
+	if (new_buffer) {
 		new_buffer->user_data = (u8 __user *)buffer->user_data + size;
 		list_add(&new_buffer->entry, &buffer->entry);
 		new_buffer->free = 1;
 		binder_insert_free_buffer(alloc, new_buffer);
 	}
 
-	rb_erase(best_fit, &alloc->free_buffers);
 	buffer->free = 0;
 	buffer->allow_user_free = 0;
 	binder_insert_allocated_buffer_locked(alloc, buffer);
@@ -516,6 +634,9 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			debug_low_async_space_locked(alloc, pid);
 		}
 	}
+	if (binder_alloc_warm_pages)
+		binder_alloc_warm_range(alloc, size, end_page_addr,
+					has_page_addr);
 	return buffer;
 
 err_alloc_buf_struct_failed:
@@ -656,7 +777,7 @@ static void binder_free_buf_locked(struct binder_alloc *alloc,
 		struct binder_buffer *next = binder_buffer_next(buffer);
 
 		if (next->free) {
-			rb_erase(&next->rb_node, &alloc->free_buffers);
+			binder_erase_free_buffer(alloc, next);
 			binder_delete_free_buffer(alloc, next);
 		}
 	}
@@ -664,8 +785,8 @@ static void binder_free_buf_locked(struct binder_alloc *alloc,
 		struct binder_buffer *prev = binder_buffer_prev(buffer);
 
 		if (prev->free) {
+			binder_erase_free_buffer(alloc, prev);
 			binder_delete_free_buffer(alloc, buffer);
-			rb_erase(&prev->rb_node, &alloc->free_buffers);
 			buffer = prev;
 		}
 	}
@@ -868,6 +989,8 @@ void binder_alloc_print_allocated(struct seq_file *m,
 	for (n = rb_first(&alloc->allocated_buffers); n != NULL; n = rb_next(n))
 		print_binder_buffer(m, "  buffer",
 				    rb_entry(n, struct binder_buffer, rb_node));
+	seq_printf(m, "  buffer allocs: size class %lu tree %lu\n",
+		   alloc->class_allocs, alloc->tree_allocs);
 	mutex_unlock(&alloc->mutex);
 }
 
@@ -1037,9 +1160,14 @@ static struct shrinker binder_shrinker = {
  */
 void binder_alloc_init(struct binder_alloc *alloc)
 {
+	int i;
+
 	alloc->pid = current->group_leader->pid;
 	mutex_init(&alloc->mutex);
 	INIT_LIST_HEAD(&alloc->buffers);
+	for (i = 0; i < BINDER_ALLOC_SIZE_CLASSES; i++)
+		INIT_HLIST_HEAD(&alloc->free_classes[i]);
+	bitmap_zero(alloc->free_classes_map, BINDER_ALLOC_SIZE_CLASSES);
 }
 
 int binder_alloc_shrinker_init(void)
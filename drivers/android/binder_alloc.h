@@ -36,11 +36,14 @@ struct binder_transaction;
  * struct binder_buffer - buffer used for binder transactions
  * @entry:              entry alloc->buffers
  * @rb_node:            node for allocated_buffers/free_buffers rb trees
+ * @class_node:         node for a free_classes list, used instead of @rb_node
+ *                      while @in_size_class is set
  * @free:               %true if buffer is free
  * @clear_on_free:      %true if buffer must be zeroed after use
  * @allow_user_free:    %true if user is allowed to free buffer
  * @async_transaction:  %true if buffer is in use for an async txn
  * @debug_id:           unique ID for debugging
+ * @in_size_class:      %true if free buffer is on a free_classes list
  * @transaction:        pointer to associated struct binder_transaction
  * @target_node:        struct binder_node associated with this buffer
  * @data_size:          size of @transaction data
@@ -53,13 +56,17 @@ struct binder_transaction;
  */
 struct binder_buffer {
 	struct list_head entry; /* free and allocated entries by address */
-	struct rb_node rb_node; /* free entry by size or allocated entry */
-				/* by address */
+	union {
+		struct rb_node rb_node; /* free entry by size or allocated */
+					/* entry by address */
+		struct hlist_node class_node; /* small free entry by size */
+	};
 	unsigned free:1;
 	unsigned clear_on_free:1;
 	unsigned allow_user_free:1;
 	unsigned async_transaction:1;
 	unsigned debug_id:28;
+	unsigned in_size_class:1;
 
 	struct binder_transaction *transaction;
 
@@ -83,6 +90,12 @@ struct binder_lru_page {
 	struct binder_alloc *alloc;
 };
 
+/*
+ * Free buffers smaller than this many pointers are kept on per-size lists
+ * rather than in the free_buffers rb tree
+ */
+#define BINDER_ALLOC_SIZE_CLASSES 64
+
 /**
  * struct binder_alloc - per-binder proc state for binder allocator
  * @vma:                vm_area_struct passed to mmap_handler
@@ -93,7 +106,13 @@ struct binder_lru_page {
  * @buffer:             base of per-proc address space mapped via mmap
  * @buffers:            list of all buffers for this proc
  * @free_buffers:       rb tree of buffers available for allocation
- *                      sorted by size
+ *                      sorted by size, for buffers too large for
+ *                      @free_classes
+ * @free_classes:       lists of free buffers, one per small size in units
+ *                      of sizeof(void *)
+ * @free_classes_map:   bitmap of non-empty @free_classes lists
+ * @class_allocs:       allocations served from @free_classes
+ * @tree_allocs:        allocations served from @free_buffers
  * @allocated_buffers:  rb tree of allocated buffers sorted by address
  * @free_async_space:   VA space available for async buffers. This is
  *                      initialized at mmap time to 1/2 the full VA space
@@ -101,6 +120,8 @@ struct binder_lru_page {
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
  * @pages_high:         high watermark of offset in @pages
+ * @txn_size_avg:       running average of buffer sizes allocated, used to
+ *                      size the warm pages populated past each new buffer
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -114,6 +135,10 @@ struct binder_alloc {
 	void __user *buffer;
 	struct list_head buffers;
 	struct rb_root free_buffers;
+	struct hlist_head free_classes[BINDER_ALLOC_SIZE_CLASSES];
+	DECLARE_BITMAP(free_classes_map, BINDER_ALLOC_SIZE_CLASSES);
+	unsigned long class_allocs;
+	unsigned long tree_allocs;
 	struct rb_root allocated_buffers;
 	size_t free_async_space;
 	struct binder_lru_page *pages;
@@ -121,6 +146,7 @@ struct binder_alloc {
 	uint32_t buffer_free;
 	int pid;
 	size_t pages_high;
+	size_t txn_size_avg;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
@@ -33,6 +33,7 @@
 #include <linux/cpufreq.h>
 #include <linux/cpuidle.h>
 #include <linux/timer.h>
+#include <linux/slab.h>
 #include <linux/wakeup_reason.h>
 
 #include "../base.h"
@@ -86,6 +87,121 @@ static char *pm_verb(int event)
 	}
 }
 
+/*
+ * Sleep dependencies between devices that are not parent and child, e.g. a
+ * touch controller and the regulator or bus it needs. A consumer resumes
+ * after its suppliers and suspends before them, which lets both be handled
+ * asynchronously without losing the order dpm_list would have imposed.
+ */
+struct dpm_dep_node {
+	struct list_head entry;
+	struct device *dev;		/* the other end of the dependency */
+};
+
+struct dpm_dependency {
+	struct dpm_dep_node supplier;	/* on consumer->power.suppliers */
+	struct dpm_dep_node consumer;	/* on supplier->power.consumers */
+};
+
+static DEFINE_MUTEX(dpm_dep_mtx);
+
+static void dpm_free_dependency(struct dpm_dependency *dep)
+{
+	list_del(&dep->supplier.entry);
+	list_del(&dep->consumer.entry);
+	kfree(dep);
+}
+
+static void dpm_remove_dependencies(struct device *dev)
+{
+	struct dpm_dep_node *node, *tmp;
+
+	mutex_lock(&dpm_dep_mtx);
+	list_for_each_entry_safe(node, tmp, &dev->power.suppliers, entry)
+		dpm_free_dependency(container_of(node, struct dpm_dependency,
+						 supplier));
+	list_for_each_entry_safe(node, tmp, &dev->power.consumers, entry)
+		dpm_free_dependency(container_of(node, struct dpm_dependency,
+						 consumer));
+	mutex_unlock(&dpm_dep_mtx);
+}
+
+/**
+ * device_pm_add_dependency - Order the system sleep transitions of two devices.
+ * @consumer: Device that needs @supplier to be functional.
+ * @supplier: Device @consumer depends on.
+ *
+ * @consumer is resumed after and suspended before @supplier, also when either
+ * of them is handled asynchronously. @supplier must have been registered
+ * before @consumer, so that devices handled synchronously keep the order too.
+ * The dependency is dropped when either device is removed.
+ */
+int device_pm_add_dependency(struct device *consumer, struct device *supplier)
+{
+	struct dpm_dependency *dep;
+	struct dpm_dep_node *node;
+	struct device *dev;
+
+	if (!consumer || !supplier || consumer == supplier)
+		return -EINVAL;
+
+	mutex_lock(&dpm_list_mtx);
+	list_for_each_entry(dev, &dpm_list, power.entry) {
+		if (dev == supplier)
+			break;
+		if (dev == consumer) {
+			mutex_unlock(&dpm_list_mtx);
+			return -EINVAL;
+		}
+	}
+	mutex_unlock(&dpm_list_mtx);
+
+	dep = kzalloc(sizeof(*dep), GFP_KERNEL);
+	if (!dep)
+		return -ENOMEM;
+
+	dep->supplier.dev = supplier;
+	dep->consumer.dev = consumer;
+
+	mutex_lock(&dpm_dep_mtx);
+	list_for_each_entry(node, &consumer->power.suppliers, entry) {
+		if (node->dev == supplier) {
+			mutex_unlock(&dpm_dep_mtx);
+			kfree(dep);
+			return 0;
+		}
+	}
+	list_add_tail(&dep->supplier.entry, &consumer->power.suppliers);
+	list_add_tail(&dep->consumer.entry, &supplier->power.consumers);
+	mutex_unlock(&dpm_dep_mtx);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(device_pm_add_dependency);
+
+/**
+ * device_pm_remove_dependency - Drop a dependency added by
+ * device_pm_add_dependency().
+ * @consumer: Device that needed @supplier.
+ * @supplier: Device @consumer depended on.
+ */
+void device_pm_remove_dependency(struct device *consumer,
+				 struct device *supplier)
+{
+	struct dpm_dep_node *node;
+
+	mutex_lock(&dpm_dep_mtx);
+	list_for_each_entry(node, &consumer->power.suppliers, entry) {
+		if (node->dev == supplier) {
+			dpm_free_dependency(container_of(node,
+					struct dpm_dependency, supplier));
+			break;
+		}
+	}
+	mutex_unlock(&dpm_dep_mtx);
+}
+EXPORT_SYMBOL_GPL(device_pm_remove_dependency);
+
 /**
  * device_pm_sleep_init - Initialize system suspend-related device fields.
  * @dev: Device object being initialized.
@@ -100,6 +216,8 @@ void device_pm_sleep_init(struct device *dev)
 	complete_all(&dev->power.completion);
 	dev->power.wakeup = NULL;
 	INIT_LIST_HEAD(&dev->power.entry);
+	INIT_LIST_HEAD(&dev->power.suppliers);
+	INIT_LIST_HEAD(&dev->power.consumers);
 }
 
 /**
@@ -147,6 +265,7 @@ void device_pm_remove(struct device *dev)
 	mutex_lock(&dpm_list_mtx);
 	list_del_init(&dev->power.entry);
 	mutex_unlock(&dpm_list_mtx);
+	dpm_remove_dependencies(dev);
 	device_wakeup_disable(dev);
 	pm_runtime_remove(dev);
 	device_pm_check_callbacks(dev);
@@ -245,6 +364,45 @@ static void dpm_wait_for_children(struct device *dev, bool async)
        device_for_each_child(dev, &async, dpm_wait_fn);
 }
 
+/*
+ * Wait for the devices on a dependency list of @dev. The list lock cannot
+ * be held while waiting, as the callbacks being waited for may add or drop
+ * dependencies, so the walk restarts after every wait.
+ */
+static void dpm_wait_for_list(struct list_head *head, bool async)
+{
+	struct dpm_dep_node *node;
+	struct device *other;
+
+	mutex_lock(&dpm_dep_mtx);
+ restart:
+	list_for_each_entry(node, head, entry) {
+		other = node->dev;
+		if (!async && !(pm_async_enabled && other->power.async_suspend))
+			continue;
+		if (completion_done(&other->power.completion))
+			continue;
+
+		get_device(other);
+		mutex_unlock(&dpm_dep_mtx);
+		dpm_wait(other, async);
+		put_device(other);
+		mutex_lock(&dpm_dep_mtx);
+		goto restart;
+	}
+	mutex_unlock(&dpm_dep_mtx);
+}
+
+static void dpm_wait_for_suppliers(struct device *dev, bool async)
+{
+	dpm_wait_for_list(&dev->power.suppliers, async);
+}
+
+static void dpm_wait_for_consumers(struct device *dev, bool async)
+{
+	dpm_wait_for_list(&dev->power.consumers, async);
+}
+
 /**
  * pm_op - Return the PM operation appropriate for given PM event.
  * @ops: PM operations to choose from.
@@ -379,7 +537,7 @@ static void dpm_show_time(ktime_t starttime, pm_message_t state, char *info)
 static int dpm_run_callback(pm_callback_t cb, struct device *dev,
 			    pm_message_t state, char *info)
 {
-	ktime_t calltime;
+	ktime_t calltime, start;
 	int error;
 
 	if (!cb)
@@ -389,7 +547,11 @@ static int dpm_run_callback(pm_callback_t cb, struct device *dev,
 
 	pm_dev_dbg(dev, state, info);
 	trace_device_pm_callback_start(dev, info, state.event);
+	start = ktime_get();
 	error = cb(dev);
+	if (state.event == PM_EVENT_RESUME)
+		log_resume_device_time(dev_name(dev), info,
+				       ktime_us_delta(ktime_get(), start));
 	trace_device_pm_callback_end(dev, error);
 	suspend_report_result(cb, error);
 
@@ -490,6 +652,7 @@ static int device_resume_noirq(struct device *dev, pm_message_t state, bool asyn
 		goto Out;
 
 	dpm_wait(dev->parent, async);
+	dpm_wait_for_suppliers(dev, async);
 
 	if (dev->pm_domain) {
 		info = "noirq power domain ";
@@ -620,6 +783,7 @@ static int device_resume_early(struct device *dev, pm_message_t state, bool asyn
 		goto Out;
 
 	dpm_wait(dev->parent, async);
+	dpm_wait_for_suppliers(dev, async);
 
 	if (dev->pm_domain) {
 		info = "early power domain ";
@@ -752,6 +916,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	}
 
 	dpm_wait(dev->parent, async);
+	dpm_wait_for_suppliers(dev, async);
 	dpm_watchdog_set(&wd, dev);
 	device_lock(dev);
 
@@ -1029,6 +1194,7 @@ static int __device_suspend_noirq(struct device *dev, pm_message_t state, bool a
 	TRACE_SUSPEND(0);
 
 	dpm_wait_for_children(dev, async);
+	dpm_wait_for_consumers(dev, async);
 
 	if (async_error)
 		goto Complete;
@@ -1176,6 +1342,7 @@ static int __device_suspend_late(struct device *dev, pm_message_t state, bool as
 	__pm_runtime_disable(dev, false);
 
 	dpm_wait_for_children(dev, async);
+	dpm_wait_for_consumers(dev, async);
 
 	if (async_error)
 		goto Complete;
@@ -1361,6 +1528,7 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	TRACE_SUSPEND(0);
 
 	dpm_wait_for_children(dev, async);
+	dpm_wait_for_consumers(dev, async);
 
 	if (async_error) {
 		dev->power.direct_complete = false;
@@ -0,0 +1,170 @@
+/*
+ * Same page deduplication for zram
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/kernel.h>
+#include <linux/highmem.h>
+#include <linux/jhash.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#include "zram_drv.h"
+
+/* One hash bucket per this many pages of disksize */
+#define ZRAM_DEDUP_PAGES_PER_BUCKET	16
+#define ZRAM_DEDUP_MIN_BUCKETS		64
+
+u32 zram_dedup_checksum(struct page *page)
+{
+	void *mem;
+	u32 checksum;
+
+	mem = kmap_atomic(page);
+	checksum = jhash2(mem, PAGE_SIZE / sizeof(u32), 0);
+	kunmap_atomic(mem);
+
+	return checksum;
+}
+
+static struct zram_dedup_bucket *zram_dedup_bucket(struct zram *zram,
+				u32 checksum)
+{
+	return &zram->hash[checksum % zram->hash_size];
+}
+
+/* A checksum match is only a hint, compare the actual contents */
+static bool zram_dedup_match(struct zram *zram,
+			struct zram_dedup_entry *entry, struct page *page)
+{
+	void *src, *mem;
+	bool match;
+
+	src = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	mem = kmap_atomic(page);
+	if (entry->len == PAGE_SIZE) {
+		match = !memcmp(mem, src, PAGE_SIZE);
+	} else {
+		struct zcomp_strm *zstrm = zcomp_stream_get(zram->comp);
+
+		match = !zcomp_decompress(zstrm, src, entry->len,
+					zstrm->buffer) &&
+			!memcmp(mem, zstrm->buffer, PAGE_SIZE);
+		zcomp_stream_put(zram->comp);
+	}
+	kunmap_atomic(mem);
+	zs_unmap_object(zram->mem_pool, entry->handle);
+
+	return match;
+}
+
+/*
+ * Look up a stored object with the same contents as @page. On a match
+ * a reference is taken on behalf of the caller's slot.
+ */
+struct zram_dedup_entry *zram_dedup_find(struct zram *zram,
+				struct page *page, u32 checksum)
+{
+	struct zram_dedup_bucket *bucket = zram_dedup_bucket(zram, checksum);
+	struct zram_dedup_entry *entry;
+
+	spin_lock(&bucket->lock);
+	hlist_for_each_entry(entry, &bucket->head, node) {
+		if (entry->checksum != checksum ||
+				!zram_dedup_match(zram, entry, page))
+			continue;
+
+		entry->refcount++;
+		spin_unlock(&bucket->lock);
+		atomic64_add(entry->len, &zram->stats.dup_data_size);
+		return entry;
+	}
+	spin_unlock(&bucket->lock);
+
+	return NULL;
+}
+
+/*
+ * Publish a freshly compressed object so later writes of the same page
+ * can share it. Returns NULL if no entry could be allocated, the caller
+ * then keeps using the bare handle.
+ */
+struct zram_dedup_entry *zram_dedup_insert(struct zram *zram,
+				unsigned long handle, unsigned int len,
+				u32 checksum)
+{
+	struct zram_dedup_bucket *bucket = zram_dedup_bucket(zram, checksum);
+	struct zram_dedup_entry *entry;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->checksum = checksum;
+	entry->refcount = 1;
+	entry->handle = handle;
+	entry->len = len;
+
+	spin_lock(&bucket->lock);
+	hlist_add_head(&entry->node, &bucket->head);
+	spin_unlock(&bucket->lock);
+	atomic64_add(sizeof(*entry), &zram->stats.meta_data_size);
+
+	return entry;
+}
+
+/*
+ * Drop a slot's reference. The object is freed with the last one,
+ * until then only the duplicate accounting changes.
+ */
+void zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry)
+{
+	struct zram_dedup_bucket *bucket;
+
+	bucket = zram_dedup_bucket(zram, entry->checksum);
+	spin_lock(&bucket->lock);
+	if (--entry->refcount) {
+		spin_unlock(&bucket->lock);
+		atomic64_sub(entry->len, &zram->stats.dup_data_size);
+		return;
+	}
+	hlist_del(&entry->node);
+	spin_unlock(&bucket->lock);
+
+	zs_free(zram->mem_pool, entry->handle);
+	atomic64_sub(entry->len, &zram->stats.compr_data_size);
+	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+	kfree(entry);
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t i;
+
+	if (!zram->use_dedup)
+		return 0;
+
+	zram->hash_size = max_t(size_t, ZRAM_DEDUP_MIN_BUCKETS,
+				num_pages / ZRAM_DEDUP_PAGES_PER_BUCKET);
+	zram->hash = vzalloc(zram->hash_size * sizeof(*zram->hash));
+	if (!zram->hash)
+		return -ENOMEM;
+
+	for (i = 0; i < zram->hash_size; i++) {
+		spin_lock_init(&zram->hash[i].lock);
+		INIT_HLIST_HEAD(&zram->hash[i].head);
+	}
+
+	return 0;
+}
+
+void zram_dedup_fini(struct zram *zram)
+{
+	vfree(zram->hash);
+	zram->hash = NULL;
+	zram->hash_size = 0;
+}
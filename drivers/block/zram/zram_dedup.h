@@ -0,0 +1,55 @@
+/*
+ * Same page deduplication for zram
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+struct zram;
+
+/* A compressed object shared by all slots holding identical pages */
+struct zram_dedup_entry {
+	struct hlist_node node;
+	u32 checksum;
+	unsigned long refcount;
+	unsigned long handle;
+	unsigned int len;
+};
+
+struct zram_dedup_bucket {
+	spinlock_t lock;
+	struct hlist_head head;
+};
+
+#ifdef CONFIG_ZRAM_DEDUP
+u32 zram_dedup_checksum(struct page *page);
+struct zram_dedup_entry *zram_dedup_find(struct zram *zram,
+				struct page *page, u32 checksum);
+struct zram_dedup_entry *zram_dedup_insert(struct zram *zram,
+				unsigned long handle, unsigned int len,
+				u32 checksum);
+void zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry);
+
+int zram_dedup_init(struct zram *zram, size_t num_pages);
+void zram_dedup_fini(struct zram *zram);
+#else
+static inline u32 zram_dedup_checksum(struct page *page) { return 0; }
+static inline struct zram_dedup_entry *zram_dedup_find(struct zram *zram,
+				struct page *page, u32 checksum) { return NULL; }
+static inline struct zram_dedup_entry *zram_dedup_insert(struct zram *zram,
+				unsigned long handle, unsigned int len,
+				u32 checksum) { return NULL; }
+static inline void zram_dedup_put(struct zram *zram,
+				struct zram_dedup_entry *entry) { }
+
+static inline int zram_dedup_init(struct zram *zram,
+				size_t num_pages) { return 0; }
+static inline void zram_dedup_fini(struct zram *zram) { }
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
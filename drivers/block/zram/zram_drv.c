@@ -49,6 +49,12 @@ static unsigned int num_devices = 1;
  * uncompressed in memory.
  */
 static size_t huge_class_size;
+/*
+ * Upper bound of pages waiting in one cpu's async staging queue. Writes
+ * beyond it are compressed synchronously, which throttles the writer.
+ */
+#define ZRAM_ASYNC_MAX_PENDING	64
+static struct workqueue_struct *zram_async_wq;
 
 static void zram_free_page(struct zram *zram, size_t index);
 static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
@@ -137,7 +143,8 @@ static inline bool zram_allocated(struct zram *zram, u32 index)
 {
 	return zram_get_obj_size(zram, index) ||
 			zram_test_flag(zram, index, ZRAM_SAME) ||
-			zram_test_flag(zram, index, ZRAM_WB);
+			zram_test_flag(zram, index, ZRAM_WB) ||
+			zram_test_flag(zram, index, ZRAM_PENDING);
 }
 
 #if PAGE_SIZE != 4096
@@ -561,26 +568,328 @@ out:
 	return err;
 }
 
-static unsigned long alloc_block_bdev(struct zram *zram)
+/*
+ * Allocate a run of up to *nr contiguous blocks on the backing device,
+ * shrinking the run when no free extent of that length is left. On
+ * success the first block is returned and *nr holds the run length.
+ */
+static unsigned long alloc_block_bdev_range(struct zram *zram,
+					unsigned int *nr)
+{
+	unsigned int want = *nr;
+	unsigned long blk_idx, i;
+
+	while (want) {
+		/* skip 0 bit to confuse zram.handle = 0 */
+		blk_idx = bitmap_find_next_zero_area(zram->bitmap,
+					zram->nr_pages, 1, want, 0);
+		if (blk_idx + want > zram->nr_pages) {
+			want >>= 1;
+			continue;
+		}
+
+		for (i = 0; i < want; i++) {
+			if (test_and_set_bit(blk_idx + i, zram->bitmap))
+				break;
+		}
+		if (i == want) {
+			atomic64_add(want, &zram->stats.bd_count);
+			*nr = want;
+			return blk_idx;
+		}
+
+		/* raced with another writeback, undo and retry */
+		while (i--)
+			clear_bit(blk_idx + i, zram->bitmap);
+	}
+
+	return 0;
+}
+
+/* Upper bound of bd_prefetch_window, in pages */
+#define ZRAM_BD_PREFETCH_MAX	32
+
+static ssize_t bd_prefetch_window_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", zram->bd_prefetch_window);
+}
+
+static ssize_t bd_prefetch_window_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val) || val > ZRAM_BD_PREFETCH_MAX)
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change prefetch window for initialized device\n");
+		return -EBUSY;
+	}
+
+	zram->bd_prefetch_window = val;
+	up_write(&zram->init_lock);
+
+	return len;
+}
+
+static int zram_bd_cache_create(struct zram *zram)
 {
-	unsigned long blk_idx = 1;
-retry:
-	/* skip 0 bit to confuse zram.handle = 0 */
-	blk_idx = find_next_zero_bit(zram->bitmap, zram->nr_pages, blk_idx);
-	if (blk_idx == zram->nr_pages)
+	struct zram_bd_cache *cache;
+	unsigned int i, nr;
+
+	if (!zram->backing_dev || !zram->bd_prefetch_window)
 		return 0;
 
-	if (test_and_set_bit(blk_idx, zram->bitmap))
-		goto retry;
+	/* room for the window being consumed and the next one */
+	nr = zram->bd_prefetch_window * 2;
+	cache = kzalloc(sizeof(*cache) + nr * sizeof(cache->entries[0]),
+			GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+
+	spin_lock_init(&cache->lock);
+	atomic_set(&cache->inflight, 0);
+	init_waitqueue_head(&cache->wait);
+	cache->nr_entries = nr;
+
+	for (i = 0; i < nr; i++) {
+		struct page *page = alloc_page(GFP_KERNEL);
+
+		if (!page)
+			goto out_free;
+		/* lets bio completion map the page back to its entry */
+		set_page_private(page, i);
+		cache->entries[i].page = page;
+	}
+
+	zram->bd_cache = cache;
+	return 0;
+
+out_free:
+	while (i--)
+		__free_page(cache->entries[i].page);
+	kfree(cache);
+	return -ENOMEM;
+}
+
+static void zram_bd_cache_destroy(struct zram *zram)
+{
+	struct zram_bd_cache *cache = zram->bd_cache;
+	unsigned int i;
+
+	if (!cache)
+		return;
+
+	wait_event(cache->wait, !atomic_read(&cache->inflight));
+	for (i = 0; i < cache->nr_entries; i++)
+		__free_page(cache->entries[i].page);
+	kfree(cache);
+	zram->bd_cache = NULL;
+}
+
+/* Caller should hold cache->lock */
+static struct zram_bd_cache_entry *zram_bd_cache_find(
+		struct zram_bd_cache *cache, unsigned long blk_idx)
+{
+	unsigned int i;
+
+	for (i = 0; i < cache->nr_entries; i++) {
+		if (cache->entries[i].blk_idx == blk_idx)
+			return &cache->entries[i];
+	}
+
+	return NULL;
+}
+
+/* Caller should hold cache->lock */
+static struct zram_bd_cache_entry *zram_bd_cache_victim(
+		struct zram_bd_cache *cache)
+{
+	unsigned int i;
+
+	for (i = 0; i < cache->nr_entries; i++) {
+		struct zram_bd_cache_entry *ent;
+
+		ent = &cache->entries[cache->next];
+		cache->next = (cache->next + 1) % cache->nr_entries;
+		if (!ent->loading)
+			return ent;
+	}
+
+	return NULL;
+}
+
+/*
+ * Serve a backing device read from the prefetch cache. The entry is
+ * consumed since the page is about to enter the swap cache anyway.
+ */
+static bool zram_bd_cache_read(struct zram *zram, struct bio_vec *bvec,
+				unsigned long blk_idx)
+{
+	struct zram_bd_cache *cache = zram->bd_cache;
+	struct zram_bd_cache_entry *ent;
+	unsigned long flags;
+	void *src, *dst;
+
+	if (!cache)
+		return false;
+
+	spin_lock_irqsave(&cache->lock, flags);
+	ent = zram_bd_cache_find(cache, blk_idx);
+	if (!ent || !ent->valid) {
+		spin_unlock_irqrestore(&cache->lock, flags);
+		atomic64_inc(&zram->stats.bd_prefetch_miss);
+		return false;
+	}
+
+	src = kmap_atomic(ent->page);
+	dst = kmap_atomic(bvec->bv_page);
+	memcpy(dst + bvec->bv_offset, src, bvec->bv_len);
+	kunmap_atomic(dst);
+	kunmap_atomic(src);
+	ent->blk_idx = 0;
+	ent->valid = false;
+	spin_unlock_irqrestore(&cache->lock, flags);
+
+	atomic64_inc(&zram->stats.bd_prefetch_hit);
+	return true;
+}
+
+/* Drop a block that is being freed, its number may be reused anytime */
+static void zram_bd_cache_invalidate(struct zram *zram, unsigned long blk_idx)
+{
+	struct zram_bd_cache *cache = zram->bd_cache;
+	struct zram_bd_cache_entry *ent;
+	unsigned long flags;
+
+	if (!cache)
+		return;
+
+	spin_lock_irqsave(&cache->lock, flags);
+	ent = zram_bd_cache_find(cache, blk_idx);
+	if (ent) {
+		ent->blk_idx = 0;
+		ent->valid = false;
+	}
+	spin_unlock_irqrestore(&cache->lock, flags);
+}
+
+static void zram_bd_prefetch_end_io(struct bio *bio)
+{
+	struct zram_bd_cache *cache = bio->bi_private;
+	struct bio_vec *bvec;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&cache->lock, flags);
+	bio_for_each_segment_all(bvec, bio, i) {
+		struct zram_bd_cache_entry *ent;
+
+		ent = &cache->entries[page_private(bvec->bv_page)];
+		ent->loading = false;
+		/* an invalidated entry has lost its blk_idx meanwhile */
+		if (ent->blk_idx && !bio->bi_error)
+			ent->valid = true;
+		else
+			ent->blk_idx = 0;
+	}
+	spin_unlock_irqrestore(&cache->lock, flags);
+
+	bio_put(bio);
+	if (atomic_dec_and_test(&cache->inflight))
+		wake_up(&cache->wait);
+}
+
+static void zram_bd_prefetch_submit(struct zram_bd_cache *cache,
+				struct bio *bio)
+{
+	if (bio->bi_vcnt) {
+		submit_bio(bio);
+		return;
+	}
 
-	atomic64_inc(&zram->stats.bd_count);
-	return blk_idx;
+	bio_put(bio);
+	if (atomic_dec_and_test(&cache->inflight))
+		wake_up(&cache->wait);
+}
+
+/*
+ * Read the written back blocks following @blk_idx into the cache.
+ * Neighbouring blocks hold neighbouring slots since writeback_store
+ * walks the table in slot order, so they are likely to fault next.
+ */
+static void zram_bd_prefetch(struct zram *zram, unsigned long blk_idx)
+{
+	struct zram_bd_cache *cache = zram->bd_cache;
+	unsigned long blk, end;
+	unsigned long flags;
+	struct bio *bio = NULL;
+
+	if (!cache)
+		return;
+
+	end = min_t(unsigned long, blk_idx + 1 + zram->bd_prefetch_window,
+			zram->nr_pages);
+	for (blk = blk_idx + 1; blk < end; blk++) {
+		struct zram_bd_cache_entry *ent = NULL;
+
+		if (test_bit(blk, zram->bitmap)) {
+			spin_lock_irqsave(&cache->lock, flags);
+			if (!zram_bd_cache_find(cache, blk))
+				ent = zram_bd_cache_victim(cache);
+			if (ent) {
+				ent->blk_idx = blk;
+				ent->valid = false;
+				ent->loading = true;
+			}
+			spin_unlock_irqrestore(&cache->lock, flags);
+		}
+
+		if (!ent) {
+			/* a hole ends the contiguous run */
+			if (bio)
+				zram_bd_prefetch_submit(cache, bio);
+			bio = NULL;
+			continue;
+		}
+
+		if (!bio) {
+			bio = bio_alloc(GFP_ATOMIC | __GFP_NOWARN, end - blk);
+			if (bio) {
+				bio->bi_iter.bi_sector = blk * (PAGE_SIZE >> 9);
+				bio->bi_bdev = zram->bdev;
+				bio_set_op_attrs(bio, REQ_OP_READ, REQ_RAHEAD);
+				bio->bi_end_io = zram_bd_prefetch_end_io;
+				bio->bi_private = cache;
+				atomic_inc(&cache->inflight);
+			}
+		}
+
+		if (!bio || !bio_add_page(bio, ent->page, PAGE_SIZE, 0)) {
+			spin_lock_irqsave(&cache->lock, flags);
+			ent->loading = false;
+			ent->blk_idx = 0;
+			spin_unlock_irqrestore(&cache->lock, flags);
+			break;
+		}
+	}
+
+	if (bio)
+		zram_bd_prefetch_submit(cache, bio);
 }
 
 static void free_block_bdev(struct zram *zram, unsigned long blk_idx)
 {
 	int was_set;
 
+	zram_bd_cache_invalidate(zram, blk_idx);
 	was_set = test_and_clear_bit(blk_idx, zram->bitmap);
 	WARN_ON_ONCE(!was_set);
 	atomic64_dec(&zram->stats.bd_count);
@@ -628,18 +937,230 @@ static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
 #define HUGE_WRITEBACK 1
 #define IDLE_WRITEBACK 2
 
+/* Pages per writeback batch and number of batches kept in flight */
+#define ZRAM_WB_BATCH_PAGES	32
+#define ZRAM_WB_NR_INFLIGHT	4
+
+struct zram_wb_ctl {
+	struct zram *zram;
+	atomic_t pending;
+	struct completion done;
+	int error;
+	bool busy;
+	unsigned int nr;
+	u32 index[ZRAM_WB_BATCH_PAGES];
+	unsigned long blk_idx[ZRAM_WB_BATCH_PAGES];
+	struct page *pages[ZRAM_WB_BATCH_PAGES];
+};
+
+/* Reserve one page from the writeback budget, if limiting is enabled */
+static bool zram_wb_limit_get(struct zram *zram)
+{
+	bool ret = true;
+
+	spin_lock(&zram->wb_limit_lock);
+	if (zram->wb_limit_enable) {
+		if (zram->bd_wb_limit < (1UL << (PAGE_SHIFT - 12)))
+			ret = false;
+		else
+			zram->bd_wb_limit -= 1UL << (PAGE_SHIFT - 12);
+	}
+	spin_unlock(&zram->wb_limit_lock);
+
+	return ret;
+}
+
+static void zram_wb_limit_put(struct zram *zram)
+{
+	spin_lock(&zram->wb_limit_lock);
+	if (zram->wb_limit_enable)
+		zram->bd_wb_limit += 1UL << (PAGE_SHIFT - 12);
+	spin_unlock(&zram->wb_limit_lock);
+}
+
+static void zram_wb_ctl_put(struct zram_wb_ctl *ctl)
+{
+	if (atomic_dec_and_test(&ctl->pending))
+		complete(&ctl->done);
+}
+
+static void zram_wb_end_io(struct bio *bio)
+{
+	struct zram_wb_ctl *ctl = bio->bi_private;
+
+	if (bio->bi_error)
+		ctl->error = bio->bi_error;
+	bio_put(bio);
+	zram_wb_ctl_put(ctl);
+}
+
+/*
+ * Write the batch out as few multi-page bios as the free extents of
+ * the backing device allow. Pages that get no block keep blk_idx 0
+ * and are reverted by zram_wb_ctl_finish.
+ */
+static int zram_wb_ctl_submit(struct zram_wb_ctl *ctl)
+{
+	struct zram *zram = ctl->zram;
+	unsigned int pos = 0;
+	int ret = 0;
+
+	atomic_set(&ctl->pending, 1);
+	reinit_completion(&ctl->done);
+	ctl->error = 0;
+	ctl->busy = true;
+
+	while (pos < ctl->nr) {
+		unsigned int i, added, nr = ctl->nr - pos;
+		unsigned long blk_idx;
+		struct bio *bio;
+
+		blk_idx = alloc_block_bdev_range(zram, &nr);
+		if (!blk_idx) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		bio = bio_alloc(GFP_KERNEL, nr);
+		bio->bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+		bio->bi_bdev = zram->bdev;
+		bio_set_op_attrs(bio, REQ_OP_WRITE, 0);
+		bio->bi_end_io = zram_wb_end_io;
+		bio->bi_private = ctl;
+
+		for (added = 0; added < nr; added++) {
+			if (!bio_add_page(bio, ctl->pages[pos + added],
+						PAGE_SIZE, 0))
+				break;
+			ctl->blk_idx[pos + added] = blk_idx + added;
+		}
+
+		/* the queue limits cut the bio short, give the rest back */
+		for (i = added; i < nr; i++)
+			free_block_bdev(zram, blk_idx + i);
+
+		if (!added) {
+			bio_put(bio);
+			ret = -EIO;
+			break;
+		}
+
+		atomic_inc(&ctl->pending);
+		atomic64_inc(&zram->stats.bd_wb_bios);
+		submit_bio(bio);
+		pos += added;
+	}
+
+	zram_wb_ctl_put(ctl);
+	return ret;
+}
+
+/* Wait for a submitted batch and commit its slots to the backing device */
+static void zram_wb_ctl_finish(struct zram_wb_ctl *ctl)
+{
+	struct zram *zram = ctl->zram;
+	unsigned int i;
+
+	if (!ctl->busy)
+		return;
+
+	wait_for_completion(&ctl->done);
+
+	for (i = 0; i < ctl->nr; i++) {
+		u32 index = ctl->index[i];
+		unsigned long blk_idx = ctl->blk_idx[i];
+
+		zram_slot_lock(zram, index);
+		if (!blk_idx || ctl->error) {
+			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+			zram_clear_flag(zram, index, ZRAM_IDLE);
+			zram_slot_unlock(zram, index);
+			if (blk_idx)
+				free_block_bdev(zram, blk_idx);
+			zram_wb_limit_put(zram);
+			continue;
+		}
+
+		atomic64_inc(&zram->stats.bd_writes);
+		/*
+		 * We released zram_slot_lock so need to check if the slot was
+		 * changed. If there is freeing for the slot, we can catch it
+		 * easily by zram_allocated.
+		 * A subtle case is the slot is freed/reallocated/marked as
+		 * ZRAM_IDLE again. To close the race, idle_store doesn't
+		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
+		 * Thus, we could close the race by checking ZRAM_IDLE bit.
+		 */
+		if (!zram_allocated(zram, index) ||
+			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
+			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+			zram_clear_flag(zram, index, ZRAM_IDLE);
+			zram_slot_unlock(zram, index);
+			free_block_bdev(zram, blk_idx);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+		zram_set_flag(zram, index, ZRAM_WB);
+		zram_set_element(zram, index, blk_idx);
+		atomic64_inc(&zram->stats.pages_stored);
+		zram_slot_unlock(zram, index);
+	}
+
+	ctl->nr = 0;
+	ctl->busy = false;
+}
+
+static void zram_wb_ctl_free(struct zram_wb_ctl *ctls)
+{
+	int i, j;
+
+	for (i = 0; i < ZRAM_WB_NR_INFLIGHT; i++) {
+		for (j = 0; j < ZRAM_WB_BATCH_PAGES; j++) {
+			if (ctls[i].pages[j])
+				__free_page(ctls[i].pages[j]);
+		}
+	}
+	kfree(ctls);
+}
+
+static struct zram_wb_ctl *zram_wb_ctl_alloc(struct zram *zram)
+{
+	struct zram_wb_ctl *ctls;
+	int i, j;
+
+	ctls = kcalloc(ZRAM_WB_NR_INFLIGHT, sizeof(*ctls), GFP_KERNEL);
+	if (!ctls)
+		return NULL;
+
+	for (i = 0; i < ZRAM_WB_NR_INFLIGHT; i++) {
+		ctls[i].zram = zram;
+		init_completion(&ctls[i].done);
+		for (j = 0; j < ZRAM_WB_BATCH_PAGES; j++) {
+			ctls[i].pages[j] = alloc_page(GFP_KERNEL);
+			if (!ctls[i].pages[j]) {
+				zram_wb_ctl_free(ctls);
+				return NULL;
+			}
+		}
+	}
+
+	return ctls;
+}
+
 static ssize_t writeback_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
 	struct zram *zram = dev_to_zram(dev);
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
 	unsigned long index;
-	struct bio bio;
-	struct page *page;
+	struct zram_wb_ctl *ctls, *ctl;
+	struct blk_plug plug;
 	ssize_t ret, sz;
 	char mode_buf[8];
 	int mode = -1;
-	unsigned long blk_idx = 0;
+	int i, cur = 0;
 
 	sz = strscpy(mode_buf, buf, sizeof(mode_buf));
 	if (sz <= 0)
@@ -668,34 +1189,22 @@ static ssize_t writeback_store(struct device *dev,
 		goto release_init_lock;
 	}
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
+	ctls = zram_wb_ctl_alloc(zram);
+	if (!ctls) {
 		ret = -ENOMEM;
 		goto release_init_lock;
 	}
 
+	ret = len;
+	ctl = &ctls[cur];
+	blk_start_plug(&plug);
 	for (index = 0; index < nr_pages; index++) {
 		struct bio_vec bvec;
 
-		bvec.bv_page = page;
-		bvec.bv_len = PAGE_SIZE;
-		bvec.bv_offset = 0;
-
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && !zram->bd_wb_limit) {
-			spin_unlock(&zram->wb_limit_lock);
+		if (!zram_wb_limit_get(zram)) {
 			ret = -EIO;
 			break;
 		}
-		spin_unlock(&zram->wb_limit_lock);
-
-		if (!blk_idx) {
-			blk_idx = alloc_block_bdev(zram);
-			if (!blk_idx) {
-				ret = -ENOSPC;
-				break;
-			}
-		}
 
 		zram_slot_lock(zram, index);
 		if (!zram_allocated(zram, index))
@@ -703,7 +1212,8 @@ static ssize_t writeback_store(struct device *dev,
 
 		if (zram_test_flag(zram, index, ZRAM_WB) ||
 				zram_test_flag(zram, index, ZRAM_SAME) ||
-				zram_test_flag(zram, index, ZRAM_UNDER_WB))
+				zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+				zram_test_flag(zram, index, ZRAM_PENDING))
 			goto next;
 
 		if (mode == IDLE_WRITEBACK &&
@@ -720,73 +1230,44 @@ static ssize_t writeback_store(struct device *dev,
 		/* Need for hugepage writeback racing */
 		zram_set_flag(zram, index, ZRAM_IDLE);
 		zram_slot_unlock(zram, index);
+
+		bvec.bv_page = ctl->pages[ctl->nr];
+		bvec.bv_len = PAGE_SIZE;
+		bvec.bv_offset = 0;
 		if (zram_bvec_read(zram, &bvec, index, 0, NULL)) {
 			zram_slot_lock(zram, index);
 			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
 			zram_clear_flag(zram, index, ZRAM_IDLE);
 			zram_slot_unlock(zram, index);
+			zram_wb_limit_put(zram);
 			continue;
 		}
 
-		bio_init(&bio);
-
-		bio.bi_max_vecs = 1;
-		bio.bi_io_vec = &bvec;
-		bio.bi_bdev = zram->bdev;
-
-		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
-		bio_set_op_attrs(&bio, REQ_OP_WRITE, REQ_SYNC);
-		bio_add_page(&bio, bvec.bv_page, bvec.bv_len,
-				bvec.bv_offset);
-		/*
-		 * XXX: A single page IO would be inefficient for write
-		 * but it would be not bad as starter.
-		 */
-		ret = submit_bio_wait(&bio);
-		if (ret) {
-			zram_slot_lock(zram, index);
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			zram_slot_unlock(zram, index);
+		ctl->index[ctl->nr] = index;
+		ctl->blk_idx[ctl->nr] = 0;
+		if (++ctl->nr < ZRAM_WB_BATCH_PAGES)
 			continue;
-		}
-
-		atomic64_inc(&zram->stats.bd_writes);
-		/*
-		 * We released zram_slot_lock so need to check if the slot was
-		 * changed. If there is freeing for the slot, we can catch it
-		 * easily by zram_allocated.
-		 * A subtle case is the slot is freed/reallocated/marked as
-		 * ZRAM_IDLE again. To close the race, idle_store doesn't
-		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
-		 * Thus, we could close the race by checking ZRAM_IDLE bit.
-		 */
-		zram_slot_lock(zram, index);
-		if (!zram_allocated(zram, index) ||
-			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			goto next;
-		}
 
-		zram_free_page(zram, index);
-		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-		zram_set_flag(zram, index, ZRAM_WB);
-		zram_set_element(zram, index, blk_idx);
-		blk_idx = 0;
-		atomic64_inc(&zram->stats.pages_stored);
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
-			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
-		spin_unlock(&zram->wb_limit_lock);
+		if (zram_wb_ctl_submit(ctl))
+			ret = -ENOSPC;
+		cur = (cur + 1) % ZRAM_WB_NR_INFLIGHT;
+		ctl = &ctls[cur];
+		zram_wb_ctl_finish(ctl);
+		if (ret != len)
+			break;
+		continue;
 next:
 		zram_slot_unlock(zram, index);
+		zram_wb_limit_put(zram);
 	}
 
-	if (blk_idx)
-		free_block_bdev(zram, blk_idx);
-	ret = len;
-	__free_page(page);
+	if (ctl->nr && zram_wb_ctl_submit(ctl))
+		ret = -ENOSPC;
+	blk_finish_plug(&plug);
+
+	for (i = 0; i < ZRAM_WB_NR_INFLIGHT; i++)
+		zram_wb_ctl_finish(&ctls[i]);
+	zram_wb_ctl_free(ctls);
 release_init_lock:
 	up_read(&zram->init_lock);
 
@@ -845,14 +1326,25 @@ static int read_from_bdev_sync(struct zram *zram, struct bio_vec *bvec,
 static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
 			unsigned long entry, struct bio *parent, bool sync)
 {
+	int ret;
+
+	if (zram_bd_cache_read(zram, bvec, entry))
+		return 0;
+
 	atomic64_inc(&zram->stats.bd_reads);
 	if (sync)
-		return read_from_bdev_sync(zram, bvec, entry, parent);
+		ret = read_from_bdev_sync(zram, bvec, entry, parent);
 	else
-		return read_from_bdev_async(zram, bvec, entry, parent);
+		ret = read_from_bdev_async(zram, bvec, entry, parent);
+
+	if (ret > 0)
+		zram_bd_prefetch(zram, entry);
+	return ret;
 }
 #else
 static inline void reset_bdev(struct zram *zram) {};
+static inline int zram_bd_cache_create(struct zram *zram) { return 0; };
+static inline void zram_bd_cache_destroy(struct zram *zram) {};
 static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
 			unsigned long entry, struct bio *parent, bool sync)
 {
@@ -999,44 +1491,287 @@ static ssize_t max_comp_streams_store(struct device *dev,
 	return len;
 }
 
-static ssize_t comp_algorithm_show(struct device *dev,
+static ssize_t comp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->compressor, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+static ssize_t comp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char compressor[ARRAY_SIZE(zram->compressor)];
+	size_t sz;
+
+	strlcpy(compressor, buf, sizeof(compressor));
+	/* ignore trailing newline */
+	sz = strlen(compressor);
+	if (sz > 0 && compressor[sz - 1] == '\n')
+		compressor[sz - 1] = 0x00;
+
+	if (!zcomp_available_algorithm(compressor))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+
+	strcpy(zram->compressor, compressor);
+	up_write(&zram->init_lock);
+	return len;
+}
+
+static ssize_t recomp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->recomp_algorithm, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+static ssize_t recomp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char compressor[ARRAY_SIZE(zram->recomp_algorithm)];
+	size_t sz;
+
+	strlcpy(compressor, buf, sizeof(compressor));
+	/* ignore trailing newline */
+	sz = strlen(compressor);
+	if (sz > 0 && compressor[sz - 1] == '\n')
+		compressor[sz - 1] = 0x00;
+
+	/* "none" disables recompression */
+	if (!strcmp(compressor, "none"))
+		compressor[0] = 0x00;
+	else if (!zcomp_available_algorithm(compressor))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+
+	strcpy(zram->recomp_algorithm, compressor);
+	up_write(&zram->init_lock);
+	return len;
+}
+
+/*
+ * Recompress one slot with the secondary algorithm. The new object is
+ * kept only if it is smaller than the current one. Caller should hold
+ * the slot's bit_spinlock; nothing here may sleep.
+ */
+static int zram_recompress_slot(struct zram *zram, u32 index,
+				struct page *page)
+{
+	struct zcomp_strm *zstrm;
+	unsigned long handle;
+	unsigned int comp_len, old_len;
+	void *src, *dst;
+	int ret;
+
+	old_len = zram_get_obj_size(zram, index);
+	ret = zram_read_from_zspool(zram, page, index);
+	if (ret)
+		return ret;
+
+	zstrm = zcomp_stream_get(zram->recomp);
+	src = kmap_atomic(page);
+	ret = zcomp_compress(zstrm, src, &comp_len);
+	kunmap_atomic(src);
+	if (ret || comp_len >= old_len || comp_len >= huge_class_size) {
+		zcomp_stream_put(zram->recomp);
+		return ret;
+	}
+
+	handle = zs_malloc(zram->mem_pool, comp_len,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE |
+			__GFP_CMA);
+	if (!handle) {
+		zcomp_stream_put(zram->recomp);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
+	memcpy(dst, zstrm->buffer, comp_len);
+	zs_unmap_object(zram->mem_pool, handle);
+	zcomp_stream_put(zram->recomp);
+
+	zs_free(zram->mem_pool, zram_get_handle(zram, index));
+	atomic64_sub(old_len, &zram->stats.compr_data_size);
+	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_test_flag(zram, index, ZRAM_HUGE)) {
+		zram_clear_flag(zram, index, ZRAM_HUGE);
+		atomic64_dec(&zram->stats.huge_pages);
+	}
+	zram_set_flag(zram, index, ZRAM_RECOMP);
+	atomic64_inc(&zram->stats.recomp_pages);
+	zram_set_handle(zram, index, handle);
+	zram_set_obj_size(zram, index, comp_len);
+
+	return 0;
+}
+
+#define HUGE_RECOMPRESS	1
+#define IDLE_RECOMPRESS	2
+
+static ssize_t recompress_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index;
+	struct page *page;
+	ssize_t ret = len, sz;
+	char mode_buf[8];
+	int mode = -1;
+
+	sz = strscpy(mode_buf, buf, sizeof(mode_buf));
+	if (sz <= 0)
+		return -EINVAL;
+
+	/* ignore trailing newline */
+	if (mode_buf[sz - 1] == '\n')
+		mode_buf[sz - 1] = 0x00;
+
+	if (!strcmp(mode_buf, "idle"))
+		mode = IDLE_RECOMPRESS;
+	else if (!strcmp(mode_buf, "huge"))
+		mode = HUGE_RECOMPRESS;
+
+	if (mode == -1)
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	if (!zram->recomp) {
+		ret = -ENODEV;
+		goto release_init_lock;
+	}
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page) {
+		ret = -ENOMEM;
+		goto release_init_lock;
+	}
+
+	for (index = 0; index < nr_pages; index++) {
+		zram_slot_lock(zram, index);
+		if (!zram_get_obj_size(zram, index))
+			goto next;
+
+		if (zram_test_flag(zram, index, ZRAM_WB) ||
+				zram_test_flag(zram, index, ZRAM_SAME) ||
+				zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+				zram_test_flag(zram, index, ZRAM_PENDING) ||
+				zram_test_flag(zram, index, ZRAM_RECOMP) ||
+				zram_test_flag(zram, index, ZRAM_DEDUP))
+			goto next;
+
+		if (mode == IDLE_RECOMPRESS &&
+			  !zram_test_flag(zram, index, ZRAM_IDLE))
+			goto next;
+		if (mode == HUGE_RECOMPRESS &&
+			  !zram_test_flag(zram, index, ZRAM_HUGE))
+			goto next;
+
+		zram_recompress_slot(zram, index, page);
+next:
+		zram_slot_unlock(zram, index);
+		cond_resched();
+	}
+
+	__free_page(page);
+release_init_lock:
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	bool val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	int val;
+	struct zram *zram = dev_to_zram(dev);
+
+	if (kstrtoint(buf, 10, &val) || (val != 0 && val != 1))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+#endif
+
+static ssize_t async_write_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
-	size_t sz;
 	struct zram *zram = dev_to_zram(dev);
 
-	down_read(&zram->init_lock);
-	sz = zcomp_available_show(zram->compressor, buf);
-	up_read(&zram->init_lock);
-
-	return sz;
+	return scnprintf(buf, PAGE_SIZE, "%d\n", READ_ONCE(zram->async_write));
 }
 
-static ssize_t comp_algorithm_store(struct device *dev,
+static ssize_t async_write_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
 	struct zram *zram = dev_to_zram(dev);
-	char compressor[ARRAY_SIZE(zram->compressor)];
-	size_t sz;
-
-	strlcpy(compressor, buf, sizeof(compressor));
-	/* ignore trailing newline */
-	sz = strlen(compressor);
-	if (sz > 0 && compressor[sz - 1] == '\n')
-		compressor[sz - 1] = 0x00;
+	bool val;
 
-	if (!zcomp_available_algorithm(compressor))
+	if (strtobool(buf, &val))
 		return -EINVAL;
 
-	down_write(&zram->init_lock);
-	if (init_done(zram)) {
-		up_write(&zram->init_lock);
-		pr_info("Can't change algorithm for initialized device\n");
-		return -EBUSY;
-	}
+	down_read(&zram->init_lock);
+	WRITE_ONCE(zram->async_write, val);
+	up_read(&zram->init_lock);
 
-	strcpy(zram->compressor, compressor);
-	up_write(&zram->init_lock);
 	return len;
 }
 
@@ -1096,7 +1831,8 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu"
+			" %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -1104,7 +1840,10 @@ static ssize_t mm_stat_show(struct device *dev,
 			max_used << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			atomic_long_read(&pool_stats.pages_compacted),
-			(u64)atomic64_read(&zram->stats.huge_pages));
+			(u64)atomic64_read(&zram->stats.huge_pages),
+			(u64)atomic64_read(&zram->stats.recomp_pages),
+			(u64)atomic64_read(&zram->stats.dup_data_size),
+			(u64)atomic64_read(&zram->stats.meta_data_size));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1116,14 +1855,23 @@ static ssize_t bd_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
 	struct zram *zram = dev_to_zram(dev);
+	u64 bd_writes, bd_wb_bios;
 	ssize_t ret;
 
 	down_read(&zram->init_lock);
+	bd_writes = atomic64_read(&zram->stats.bd_writes);
+	bd_wb_bios = atomic64_read(&zram->stats.bd_wb_bios);
+
 	ret = scnprintf(buf, PAGE_SIZE,
-		"%8llu %8llu %8llu\n",
+		"%8llu %8llu %8llu %8llu %8llu %8llu\n",
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_count)),
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_reads)),
-			FOUR_K((u64)atomic64_read(&zram->stats.bd_writes)));
+			FOUR_K(bd_writes),
+			/* average writeback bio size */
+			bd_wb_bios ?
+			FOUR_K(div64_u64(bd_writes, bd_wb_bios)) : 0,
+			(u64)atomic64_read(&zram->stats.bd_prefetch_hit),
+			(u64)atomic64_read(&zram->stats.bd_prefetch_miss));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1139,10 +1887,12 @@ static ssize_t debug_stat_show(struct device *dev,
 
 	down_read(&zram->init_lock);
 	ret = scnprintf(buf, PAGE_SIZE,
-			"version: %d\n%8llu %8llu\n",
+			"version: %d\n%8llu %8llu %8llu %8llu\n",
 			version,
 			(u64)atomic64_read(&zram->stats.writestall),
-			(u64)atomic64_read(&zram->stats.miss_free));
+			(u64)atomic64_read(&zram->stats.miss_free),
+			(u64)atomic64_read(&zram->stats.async_writes),
+			(u64)atomic64_read(&zram->stats.async_fallback));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1164,6 +1914,7 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	for (index = 0; index < num_pages; index++)
 		zram_free_page(zram, index);
 
+	zram_dedup_fini(zram);
 	zs_destroy_pool(zram->mem_pool);
 	vfree(zram->table);
 }
@@ -1183,6 +1934,12 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 		return false;
 	}
 
+	if (zram_dedup_init(zram, num_pages)) {
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		return false;
+	}
+
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 	return true;
@@ -1208,12 +1965,34 @@ static void zram_free_page(struct zram *zram, size_t index)
 		atomic64_dec(&zram->stats.huge_pages);
 	}
 
+	if (zram_test_flag(zram, index, ZRAM_RECOMP)) {
+		zram_clear_flag(zram, index, ZRAM_RECOMP);
+		atomic64_dec(&zram->stats.recomp_pages);
+	}
+
 	if (zram_test_flag(zram, index, ZRAM_WB)) {
 		zram_clear_flag(zram, index, ZRAM_WB);
 		free_block_bdev(zram, zram_get_element(zram, index));
 		goto out;
 	}
 
+	/*
+	 * The staged page stays owned by the async queue; detaching it
+	 * from the slot is enough for the worker to discard it.
+	 */
+	if (zram_test_flag(zram, index, ZRAM_PENDING)) {
+		zram_clear_flag(zram, index, ZRAM_PENDING);
+		goto out;
+	}
+
+	/* The shared object goes away with its last slot */
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		zram_dedup_put(zram, (struct zram_dedup_entry *)
+				zram_get_handle(zram, index));
+		goto out;
+	}
+
 	/*
 	 * No memory is allocated for same element filled pages.
 	 * Simply clear same page flag.
@@ -1240,28 +2019,26 @@ out:
 		~(1UL << ZRAM_LOCK | 1UL << ZRAM_UNDER_WB));
 }
 
-static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
-				struct bio *bio, bool partial_io)
+/* The compressor that encoded slot @index */
+static struct zcomp *zram_slot_comp(struct zram *zram, u32 index)
+{
+	if (zram_test_flag(zram, index, ZRAM_RECOMP))
+		return zram->recomp;
+	return zram->comp;
+}
+
+/*
+ * Decompress an in-memory slot into @page.
+ * Caller should hold the slot's bit_spinlock.
+ */
+static int zram_read_from_zspool(struct zram *zram, struct page *page,
+				u32 index)
 {
 	int ret;
 	unsigned long handle;
 	unsigned int size;
 	void *src, *dst;
 
-	zram_slot_lock(zram, index);
-	if (zram_test_flag(zram, index, ZRAM_WB)) {
-		struct bio_vec bvec;
-
-		zram_slot_unlock(zram, index);
-
-		bvec.bv_page = page;
-		bvec.bv_len = PAGE_SIZE;
-		bvec.bv_offset = 0;
-		return read_from_bdev(zram, &bvec,
-				zram_get_element(zram, index),
-				bio, partial_io);
-	}
-
 	handle = zram_get_handle(zram, index);
 	if (!handle || zram_test_flag(zram, index, ZRAM_SAME)) {
 		unsigned long value;
@@ -1271,10 +2048,12 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		mem = kmap_atomic(page);
 		zram_fill_page(mem, PAGE_SIZE, value);
 		kunmap_atomic(mem);
-		zram_slot_unlock(zram, index);
 		return 0;
 	}
 
+	if (zram_test_flag(zram, index, ZRAM_DEDUP))
+		handle = ((struct zram_dedup_entry *)handle)->handle;
+
 	size = zram_get_obj_size(zram, index);
 
 	src = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
@@ -1284,14 +2063,48 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		kunmap_atomic(dst);
 		ret = 0;
 	} else {
-		struct zcomp_strm *zstrm = zcomp_stream_get(zram->comp);
+		struct zcomp *comp = zram_slot_comp(zram, index);
+		struct zcomp_strm *zstrm = zcomp_stream_get(comp);
 
 		dst = kmap_atomic(page);
 		ret = zcomp_decompress(zstrm, src, size, dst);
 		kunmap_atomic(dst);
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(comp);
 	}
 	zs_unmap_object(zram->mem_pool, handle);
+
+	return ret;
+}
+
+static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
+				struct bio *bio, bool partial_io)
+{
+	int ret;
+
+	zram_slot_lock(zram, index);
+	if (zram_test_flag(zram, index, ZRAM_WB)) {
+		struct bio_vec bvec;
+
+		zram_slot_unlock(zram, index);
+
+		bvec.bv_page = page;
+		bvec.bv_len = PAGE_SIZE;
+		bvec.bv_offset = 0;
+		return read_from_bdev(zram, &bvec,
+				zram_get_element(zram, index),
+				bio, partial_io);
+	}
+
+	if (zram_test_flag(zram, index, ZRAM_PENDING)) {
+		struct zram_pending *pending;
+
+		pending = (struct zram_pending *)zram_get_handle(zram, index);
+		copy_highpage(page, pending->page);
+		zram_slot_unlock(zram, index);
+		return 0;
+	}
+
+	ret = zram_read_from_zspool(zram, page, index);
 	zram_slot_unlock(zram, index);
 
 	/* Should NEVER happen. Return bio error if it does. */
@@ -1334,28 +2147,20 @@ out:
 	return ret;
 }
 
-static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
-				u32 index, struct bio *bio)
+/*
+ * Compress @page and store the result in a newly allocated zsmalloc
+ * object. On success the object handle and compressed length are
+ * returned through @handlep and @comp_lenp.
+ */
+static int zram_compress_page(struct zram *zram, struct page *page,
+			unsigned long *handlep, unsigned int *comp_lenp)
 {
-	int ret = 0;
+	int ret;
 	unsigned long alloced_pages;
 	unsigned long handle = 0;
 	unsigned int comp_len = 0;
-	void *src, *dst, *mem;
+	void *src, *dst;
 	struct zcomp_strm *zstrm;
-	struct page *page = bvec->bv_page;
-	unsigned long element = 0;
-	enum zram_pageflags flags = 0;
-
-	mem = kmap_atomic(page);
-	if (page_same_filled(mem, &element)) {
-		kunmap_atomic(mem);
-		/* Free memory associated with this sector now. */
-		flags = ZRAM_SAME;
-		atomic64_inc(&zram->stats.same_pages);
-		goto out;
-	}
-	kunmap_atomic(mem);
 
 compress_again:
 	zstrm = zcomp_stream_get(zram->comp);
@@ -1423,7 +2228,284 @@ compress_again:
 
 	zcomp_stream_put(zram->comp);
 	zs_unmap_object(zram->mem_pool, handle);
+
+	*handlep = handle;
+	*comp_lenp = comp_len;
+	return 0;
+}
+
+/*
+ * Install a compressed object into a slot that is still waiting for
+ * the staged page @pending. Returns false if the slot was freed or
+ * rewritten meanwhile, in which case the caller owns @handle.
+ */
+static bool zram_async_install(struct zram *zram, struct zram_pending *pending,
+			unsigned long handle, unsigned int comp_len,
+			struct zram_dedup_entry *entry)
+{
+	u32 index = pending->index;
+
+	zram_slot_lock(zram, index);
+	if (!zram_test_flag(zram, index, ZRAM_PENDING) ||
+	    zram_get_handle(zram, index) != (unsigned long)pending) {
+		zram_slot_unlock(zram, index);
+		return false;
+	}
+
+	zram_clear_flag(zram, index, ZRAM_PENDING);
+	if (comp_len == PAGE_SIZE) {
+		zram_set_flag(zram, index, ZRAM_HUGE);
+		atomic64_inc(&zram->stats.huge_pages);
+	}
+	if (entry) {
+		zram_set_flag(zram, index, ZRAM_DEDUP);
+		zram_set_handle(zram, index, (unsigned long)entry);
+	} else {
+		zram_set_handle(zram, index, handle);
+	}
+	zram_set_obj_size(zram, index, comp_len);
+	atomic64_add(comp_len, &zram->stats.compr_data_size);
+	zram_slot_unlock(zram, index);
+
+	return true;
+}
+
+static bool zram_async_stale(struct zram *zram, struct zram_pending *pending)
+{
+	bool stale;
+
+	zram_slot_lock(zram, pending->index);
+	stale = !zram_test_flag(zram, pending->index, ZRAM_PENDING) ||
+		zram_get_handle(zram, pending->index) != (unsigned long)pending;
+	zram_slot_unlock(zram, pending->index);
+
+	return stale;
+}
+
+static void zram_async_free(struct zram_pending *pending)
+{
+	__free_page(pending->page);
+	kfree(pending);
+}
+
+static void zram_async_work(struct work_struct *work)
+{
+	struct zram_async_queue *aq = container_of(work,
+					struct zram_async_queue, work);
+	struct zram *zram = aq->zram;
+	struct zram_pending *pending, *tmp;
+	struct zram_dedup_entry *entry;
+	unsigned long handle;
+	unsigned int comp_len;
+	LIST_HEAD(batch);
+	LIST_HEAD(retry);
+
+	spin_lock(&aq->lock);
+	list_splice_init(&aq->list, &batch);
+	aq->nr_pending = 0;
+	spin_unlock(&aq->lock);
+
+	list_for_each_entry_safe(pending, tmp, &batch, list) {
+		list_del(&pending->list);
+
+		if (zram_async_stale(zram, pending)) {
+			zram_async_free(pending);
+			continue;
+		}
+
+		/*
+		 * The write was already completed towards the block layer,
+		 * so the data can't be dropped. Keep the slot pending and
+		 * retry with the next batch.
+		 */
+		if (zram_compress_page(zram, pending->page, &handle,
+					&comp_len)) {
+			atomic64_inc(&zram->stats.failed_writes);
+			list_add_tail(&pending->list, &retry);
+			continue;
+		}
+
+		entry = NULL;
+		if (zram_dedup_enabled(zram))
+			entry = zram_dedup_insert(zram, handle, comp_len,
+					zram_dedup_checksum(pending->page));
+
+		if (!zram_async_install(zram, pending, handle, comp_len,
+					entry)) {
+			if (entry) {
+				/*
+				 * Another slot may have found the entry
+				 * already; account the object as live and
+				 * let the put sort out who frees it.
+				 */
+				atomic64_add(comp_len,
+					&zram->stats.compr_data_size);
+				zram_dedup_put(zram, entry);
+			} else {
+				zs_free(zram->mem_pool, handle);
+			}
+		}
+		zram_async_free(pending);
+		cond_resched();
+	}
+
+	if (!list_empty(&retry)) {
+		spin_lock(&aq->lock);
+		list_splice_tail(&retry, &aq->list);
+		spin_unlock(&aq->lock);
+	}
+}
+
+/*
+ * Copy @page into a staging page and queue it for compression by the
+ * per-cpu worker. Returns false if the caller must compress the page
+ * synchronously.
+ */
+static bool zram_async_stage(struct zram *zram, struct page *page, u32 index)
+{
+	struct zram_async_queue *aq;
+	struct zram_pending *pending;
+	int cpu;
+
+	if (READ_ONCE(raw_cpu_ptr(zram->async_queue)->nr_pending) >=
+			ZRAM_ASYNC_MAX_PENDING)
+		goto fallback;
+
+	pending = kmalloc(sizeof(*pending),
+			GFP_NOIO | __GFP_NOWARN | __GFP_NOMEMALLOC);
+	if (!pending)
+		goto fallback;
+
+	pending->page = alloc_page(GFP_NOIO | __GFP_NOWARN |
+				__GFP_NOMEMALLOC | __GFP_HIGHMEM);
+	if (!pending->page) {
+		kfree(pending);
+		goto fallback;
+	}
+	copy_highpage(pending->page, page);
+	pending->index = index;
+
+	zram_slot_lock(zram, index);
+	zram_free_page(zram, index);
+	zram_set_flag(zram, index, ZRAM_PENDING);
+	zram_set_handle(zram, index, (unsigned long)pending);
+	zram_slot_unlock(zram, index);
+
+	atomic64_inc(&zram->stats.pages_stored);
+	atomic64_inc(&zram->stats.async_writes);
+
+	cpu = get_cpu();
+	aq = per_cpu_ptr(zram->async_queue, cpu);
+	spin_lock(&aq->lock);
+	list_add_tail(&pending->list, &aq->list);
+	aq->nr_pending++;
+	spin_unlock(&aq->lock);
+	queue_work_on(cpu, zram_async_wq, &aq->work);
+	put_cpu();
+
+	return true;
+
+fallback:
+	atomic64_inc(&zram->stats.async_fallback);
+	return false;
+}
+
+static int zram_async_init(struct zram *zram)
+{
+	int cpu;
+
+	zram->async_queue = alloc_percpu(struct zram_async_queue);
+	if (!zram->async_queue)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct zram_async_queue *aq = per_cpu_ptr(zram->async_queue,
+							cpu);
+
+		spin_lock_init(&aq->lock);
+		INIT_LIST_HEAD(&aq->list);
+		INIT_WORK(&aq->work, zram_async_work);
+		aq->zram = zram;
+	}
+
+	return 0;
+}
+
+/*
+ * Wait for the async workers to go idle. Must be called with no new
+ * writes coming in, before the table is released.
+ */
+static void zram_async_flush(struct zram *zram)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		flush_work(&per_cpu_ptr(zram->async_queue, cpu)->work);
+}
+
+/*
+ * Release staged pages the workers could not compress. The slots
+ * referring to them must already be freed.
+ */
+static void zram_async_drain(struct zram *zram)
+{
+	struct zram_pending *pending, *tmp;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct zram_async_queue *aq = per_cpu_ptr(zram->async_queue,
+							cpu);
+
+		list_for_each_entry_safe(pending, tmp, &aq->list, list) {
+			list_del(&pending->list);
+			zram_async_free(pending);
+		}
+		aq->nr_pending = 0;
+	}
+}
+
+static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
+				u32 index, struct bio *bio)
+{
+	int ret = 0;
+	unsigned long handle = 0;
+	unsigned int comp_len = 0;
+	void *mem;
+	struct page *page = bvec->bv_page;
+	struct zram_dedup_entry *entry = NULL;
+	unsigned long element = 0;
+	enum zram_pageflags flags = 0;
+	u32 checksum = 0;
+
+	mem = kmap_atomic(page);
+	if (page_same_filled(mem, &element)) {
+		kunmap_atomic(mem);
+		/* Free memory associated with this sector now. */
+		flags = ZRAM_SAME;
+		atomic64_inc(&zram->stats.same_pages);
+		goto out;
+	}
+	kunmap_atomic(mem);
+
+	if (zram_dedup_enabled(zram)) {
+		checksum = zram_dedup_checksum(page);
+		entry = zram_dedup_find(zram, page, checksum);
+		if (entry) {
+			comp_len = entry->len;
+			goto out;
+		}
+	}
+
+	if (READ_ONCE(zram->async_write) && zram_async_stage(zram, page, index))
+		return 0;
+
+	ret = zram_compress_page(zram, page, &handle, &comp_len);
+	if (ret)
+		return ret;
+
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+	if (zram_dedup_enabled(zram))
+		entry = zram_dedup_insert(zram, handle, comp_len, checksum);
 out:
 	/*
 	 * Free memory associated with this sector
@@ -1440,7 +2522,11 @@ out:
 	if (flags) {
 		zram_set_flag(zram, index, flags);
 		zram_set_element(zram, index, element);
-	}  else {
+	} else if (entry) {
+		zram_set_flag(zram, index, ZRAM_DEDUP);
+		zram_set_handle(zram, index, (unsigned long)entry);
+		zram_set_obj_size(zram, index, comp_len);
+	} else {
 		zram_set_handle(zram, index, handle);
 		zram_set_obj_size(zram, index, comp_len);
 	}
@@ -1701,7 +2787,7 @@ out:
 
 static void zram_reset_device(struct zram *zram)
 {
-	struct zcomp *comp;
+	struct zcomp *comp, *recomp;
 	u64 disksize;
 
 	down_write(&zram->init_lock);
@@ -1714,6 +2800,8 @@ static void zram_reset_device(struct zram *zram)
 	}
 
 	comp = zram->comp;
+	recomp = zram->recomp;
+	zram->recomp = NULL;
 	disksize = zram->disksize;
 	zram->disksize = 0;
 
@@ -1722,9 +2810,14 @@ static void zram_reset_device(struct zram *zram)
 
 	up_write(&zram->init_lock);
 	/* I/O operation under all of CPU are done so let's free */
+	zram_async_flush(zram);
 	zram_meta_free(zram, disksize);
+	zram_async_drain(zram);
+	zram_bd_cache_destroy(zram);
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zcomp_destroy(comp);
+	if (recomp)
+		zcomp_destroy(recomp);
 	reset_bdev(zram);
 }
 
@@ -1761,6 +2854,21 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_free_meta;
 	}
 
+	err = zram_bd_cache_create(zram);
+	if (err)
+		goto out_free_comp;
+
+	if (zram->recomp_algorithm[0]) {
+		zram->recomp = zcomp_create(zram->recomp_algorithm);
+		if (IS_ERR(zram->recomp)) {
+			pr_err("Cannot initialise %s recompressing backend\n",
+					zram->recomp_algorithm);
+			err = PTR_ERR(zram->recomp);
+			zram->recomp = NULL;
+			goto out_free_bd_cache;
+		}
+	}
+
 	zram->comp = comp;
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
@@ -1770,6 +2878,10 @@ static ssize_t disksize_store(struct device *dev,
 
 	return len;
 
+out_free_bd_cache:
+	zram_bd_cache_destroy(zram);
+out_free_comp:
+	zcomp_destroy(comp);
 out_free_meta:
 	zram_meta_free(zram, disksize);
 out_unlock:
@@ -1853,11 +2965,18 @@ static DEVICE_ATTR_WO(mem_used_max);
 static DEVICE_ATTR_WO(idle);
 static DEVICE_ATTR_RW(max_comp_streams);
 static DEVICE_ATTR_RW(comp_algorithm);
+static DEVICE_ATTR_RW(recomp_algorithm);
+static DEVICE_ATTR_WO(recompress);
+static DEVICE_ATTR_RW(async_write);
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(use_dedup);
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
 static DEVICE_ATTR_WO(writeback);
 static DEVICE_ATTR_RW(writeback_limit);
 static DEVICE_ATTR_RW(writeback_limit_enable);
+static DEVICE_ATTR_RW(bd_prefetch_window);
 #endif
 
 static struct attribute *zram_disk_attrs[] = {
@@ -1870,11 +2989,18 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_idle.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+	&dev_attr_recomp_algorithm.attr,
+	&dev_attr_recompress.attr,
+	&dev_attr_async_write.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
 	&dev_attr_writeback.attr,
 	&dev_attr_writeback_limit.attr,
 	&dev_attr_writeback_limit_enable.attr,
+	&dev_attr_bd_prefetch_window.attr,
 #endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
@@ -1917,12 +3043,16 @@ static int zram_add(void)
 #ifdef CONFIG_ZRAM_WRITEBACK
 	spin_lock_init(&zram->wb_limit_lock);
 #endif
+	ret = zram_async_init(zram);
+	if (ret)
+		goto out_free_idr;
+
 	queue = blk_alloc_queue(GFP_KERNEL);
 	if (!queue) {
 		pr_err("Error allocating disk queue for device %d\n",
 			device_id);
 		ret = -ENOMEM;
-		goto out_free_idr;
+		goto out_free_async;
 	}
 
 	blk_queue_make_request(queue, zram_make_request);
@@ -1990,6 +3120,8 @@ static int zram_add(void)
 
 out_free_queue:
 	blk_cleanup_queue(queue);
+out_free_async:
+	free_percpu(zram->async_queue);
 out_free_idr:
 	idr_remove(&zram_index_idr, device_id);
 out_free_dev:
@@ -2027,6 +3159,7 @@ static int zram_remove(struct zram *zram)
 	del_gendisk(zram->disk);
 	blk_cleanup_queue(zram->disk->queue);
 	put_disk(zram->disk);
+	free_percpu(zram->async_queue);
 	kfree(zram);
 	return 0;
 }
@@ -2108,15 +3241,21 @@ static void destroy_devices(void)
 	zram_debugfs_destroy();
 	idr_destroy(&zram_index_idr);
 	unregister_blkdev(zram_major, "zram");
+	destroy_workqueue(zram_async_wq);
 }
 
 static int __init zram_init(void)
 {
 	int ret;
 
+	zram_async_wq = alloc_workqueue("zram_async", WQ_MEM_RECLAIM, 0);
+	if (!zram_async_wq)
+		return -ENOMEM;
+
 	ret = class_register(&zram_control_class);
 	if (ret) {
 		pr_err("Unable to register zram-control class\n");
+		destroy_workqueue(zram_async_wq);
 		return ret;
 	}
 
@@ -2125,6 +3264,7 @@ static int __init zram_init(void)
 	if (zram_major <= 0) {
 		pr_err("Unable to get major number\n");
 		class_unregister(&zram_control_class);
+		destroy_workqueue(zram_async_wq);
 		return -EBUSY;
 	}
 
@@ -16,10 +16,12 @@
 #define _ZRAM_DRV_H_
 
 #include <linux/rwsem.h>
+#include <linux/workqueue.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 #define SECTORS_PER_PAGE_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
 #define SECTORS_PER_PAGE	(1 << SECTORS_PER_PAGE_SHIFT)
@@ -37,9 +39,10 @@
  * zram is mainly used for memory efficiency so we want to keep memory
  * footprint small so we can squeeze size and flags into a field.
  * The lower ZRAM_FLAG_SHIFT bits is for object size (excluding header),
- * the higher bits is for zram_pageflags.
+ * the higher bits is for zram_pageflags. An object is at most PAGE_SIZE
+ * bytes, so PAGE_SHIFT + 1 bits are enough for the size.
  */
-#define ZRAM_FLAG_SHIFT 24
+#define ZRAM_FLAG_SHIFT (PAGE_SHIFT + 1)
 
 /* Flags for zram pages (table[page_no].flags) */
 enum zram_pageflags {
@@ -50,6 +53,9 @@ enum zram_pageflags {
 	ZRAM_UNDER_WB,	/* page is under writeback */
 	ZRAM_HUGE,	/* Incompressible page */
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
+	ZRAM_PENDING,	/* page is staged for deferred compression */
+	ZRAM_RECOMP,	/* page was recompressed with the secondary algorithm */
+	ZRAM_DEDUP,	/* handle points to a shared zram_dedup_entry */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -78,21 +84,70 @@ struct zram_stats {
 	atomic64_t notify_free;	/* no. of swap slot free notifications */
 	atomic64_t same_pages;		/* no. of same element filled pages */
 	atomic64_t huge_pages;		/* no. of huge pages */
+	atomic64_t recomp_pages;	/* no. of recompressed pages */
+	atomic64_t dup_data_size;	/* compressed size of pages duplicated */
+	atomic64_t meta_data_size;	/* size of zram_dedup_entry */
 	atomic64_t pages_stored;	/* no. of pages currently stored */
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+	atomic64_t async_writes;	/* no. of writes staged for async compression */
+	atomic64_t async_fallback;	/* no. of async writes done synchronously */
 #ifdef	CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
 	atomic64_t bd_writes;		/* no. of writes from backing device */
+	atomic64_t bd_wb_bios;		/* no. of writeback bios submitted */
+	atomic64_t bd_prefetch_hit;	/* no. of bd reads served by prefetch */
+	atomic64_t bd_prefetch_miss;	/* no. of bd reads missing prefetch */
 #endif
 };
 
+/*
+ * A page staged for deferred compression. While ZRAM_PENDING is set
+ * the slot's handle points to one of these; the entry itself is owned
+ * by the per-cpu queue and is only freed by the compression worker.
+ */
+struct zram_pending {
+	struct list_head list;
+	struct page *page;
+	u32 index;
+};
+
+/* Per-cpu staging queue for async writes */
+struct zram_async_queue {
+	spinlock_t lock;
+	struct list_head list;
+	unsigned int nr_pending;
+	struct work_struct work;
+	struct zram *zram;
+};
+
+#ifdef CONFIG_ZRAM_WRITEBACK
+/* A backing device block read ahead of a fault */
+struct zram_bd_cache_entry {
+	unsigned long blk_idx;	/* 0 if the entry is unused */
+	struct page *page;
+	bool valid;		/* page holds the data of blk_idx */
+	bool loading;		/* a read into page is in flight */
+};
+
+struct zram_bd_cache {
+	spinlock_t lock;
+	atomic_t inflight;	/* no. of prefetch bios in flight */
+	wait_queue_head_t wait;
+	unsigned int next;	/* round-robin replacement cursor */
+	unsigned int nr_entries;
+	struct zram_bd_cache_entry entries[];
+};
+#endif
+
 struct zram {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
 	struct zcomp *comp;
+	/* secondary compressor used to recompress idle or huge pages */
+	struct zcomp *recomp;
 	struct gendisk *disk;
 	/* Prevent concurrent execution of device init */
 	struct rw_semaphore init_lock;
@@ -108,10 +163,13 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[CRYPTO_MAX_ALG_NAME];
+	char recomp_algorithm[CRYPTO_MAX_ALG_NAME];
 	/*
 	 * zram is claimed so open request will be failed
 	 */
 	bool claim; /* Protected by bdev->bd_mutex */
+	bool async_write;
+	struct zram_async_queue __percpu *async_queue;
 	struct file *backing_dev;
 #ifdef CONFIG_ZRAM_WRITEBACK
 	spinlock_t wb_limit_lock;
@@ -121,9 +179,25 @@ struct zram {
 	unsigned int old_block_size;
 	unsigned long *bitmap;
 	unsigned long nr_pages;
+	unsigned int bd_prefetch_window;
+	struct zram_bd_cache *bd_cache;
 #endif
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	struct dentry *debugfs_dir;
 #endif
+#ifdef CONFIG_ZRAM_DEDUP
+	bool use_dedup;
+	struct zram_dedup_bucket *hash;
+	size_t hash_size;
+#endif
 };
+
+static inline bool zram_dedup_enabled(struct zram *zram)
+{
+#ifdef CONFIG_ZRAM_DEDUP
+	return zram->use_dedup;
+#else
+	return false;
+#endif
+}
 #endif
@@ -23,6 +23,9 @@
 #include <linux/cdev.h>
 #include <linux/list.h>
 #include <linux/hash.h>
+#include <linux/hashtable.h>
+#include <linux/poll.h>
+#include <linux/seq_file.h>
 #include <linux/msm_ion.h>
 #include <soc/qcom/secure_buffer.h>
 #include <soc/qcom/glink.h>
@@ -82,6 +85,7 @@
 #define SESSION_ID_INDEX (30)
 #define FASTRPC_CTX_MAGIC (0xbeeddeed)
 #define FASTRPC_CTX_MAX (256)
+#define FASTRPC_MAP_HASH_BITS (5)
 #define FASTRPC_CTXID_MASK (0xFF0)
 #define NUM_DEVICES   2 /* adsprpc-smd, adsprpc-smd-secure */
 #define MINOR_NUM_DEV 0
@@ -133,6 +137,26 @@
 		} \
 	}
 
+/* Per method profile, phases of one invocation in the order they run */
+enum fastrpc_prof_phase {
+	PROF_GETARGS = 0,
+	PROF_FLUSH = 1,
+	PROF_SEND = 2,
+	PROF_DSP = 3,
+	PROF_INVAL = 4,
+	PROF_PUTARGS = 5,
+	PROF_PHASE_MAX = 6,
+};
+
+/* log2 buckets of total invocation latency in usecs, last one open ended */
+#define FASTRPC_PROF_BUCKETS (16)
+
+#define PROF_STAMP(fl, stamp, i) \
+	do { \
+		if ((fl)->profile) \
+			(stamp)[i] = ktime_get_ns(); \
+	} while (0)
+
 #define GET_COUNTER(perf_ptr, offset)  \
 	(perf_ptr != NULL ?\
 		(((offset >= 0) && (offset < PERF_KEY_MAX)) ?\
@@ -141,6 +165,43 @@
 
 static int fastrpc_glink_open(int cid);
 static void fastrpc_glink_close(void *chan, int cid);
+
+/*
+ * Account one successful invocation to its (handle, method) profile.
+ * @stamp holds PROF_PHASE_MAX + 1 timestamps taken around the phases.
+ */
+static void fastrpc_method_prof_update(struct fastrpc_file *fl,
+			uint32_t handle, uint32_t sc, const uint64_t *stamp)
+{
+	struct fastrpc_method_prof *prof = NULL, *p;
+	uint32_t method = REMOTE_SCALARS_METHOD(sc);
+	uint64_t us;
+	int i;
+
+	mutex_lock(&fl->perf_mutex);
+	hlist_for_each_entry(p, &fl->method_prof, hn) {
+		if (p->handle == handle && p->method == method) {
+			prof = p;
+			break;
+		}
+	}
+	if (!prof) {
+		prof = kzalloc(sizeof(*prof), GFP_KERNEL);
+		if (!prof)
+			goto bail;
+		prof->handle = handle;
+		prof->method = method;
+		hlist_add_head(&prof->hn, &fl->method_prof);
+	}
+
+	prof->count++;
+	for (i = 0; i < PROF_PHASE_MAX; i++)
+		prof->phase_ns[i] += stamp[i + 1] - stamp[i];
+	us = div_u64(stamp[PROF_PHASE_MAX] - stamp[0], NSEC_PER_USEC);
+	prof->hist[min_t(int, fls64(us), FASTRPC_PROF_BUCKETS - 1)]++;
+bail:
+	mutex_unlock(&fl->perf_mutex);
+}
 static int fastrpc_pdr_notifier_cb(struct notifier_block *nb,
 					unsigned long code,
 					void *data);
@@ -245,6 +306,10 @@ struct smq_invoke_ctx {
 	uint64_t ctxid;
 	void *handle;
 	const void *ptr;
+	bool async;			/* reaped via FASTRPC_IOCTL_ASYNC_WAIT */
+	uint64_t jobid;
+	remote_arg_t *upra;		/* user pra for put_args of async jobs */
+	struct list_head async_node;	/* fl->async_done */
 };
 
 struct fastrpc_ctx_lst {
@@ -345,6 +410,7 @@ struct fastrpc_apps {
 
 struct fastrpc_mmap {
 	struct hlist_node hn;
+	struct hlist_node hn_fd;	/* fl->map_hash, keyed by fd */
 	struct fastrpc_file *fl;
 	struct fastrpc_apps *apps;
 	int fd;
@@ -363,6 +429,9 @@ struct fastrpc_mmap {
 	int secure;
 	uintptr_t attr;
 	bool is_filemap; /*flag to indicate map used in process init*/
+	/* ion cpu access count when cache maintenance was last done */
+	unsigned int cpu_seq;
+	bool cpu_seq_valid;
 };
 
 enum fastrpc_perfkeys {
@@ -392,10 +461,25 @@ struct fastrpc_perf {
 	struct hlist_node hn;
 };
 
+struct fastrpc_method_prof {
+	struct hlist_node hn;
+	uint32_t handle;
+	uint32_t method;
+	uint64_t count;
+	uint64_t phase_ns[PROF_PHASE_MAX];
+	uint32_t hist[FASTRPC_PROF_BUCKETS];
+};
+
 struct fastrpc_file {
 	struct hlist_node hn;
 	spinlock_t hlock;
 	struct hlist_head maps;
+	DECLARE_HASHTABLE(map_hash, FASTRPC_MAP_HASH_BITS);
+	/* completed async jobs, notified from the transport rx path */
+	spinlock_t async_lock;
+	struct list_head async_done;
+	wait_queue_head_t async_wait;
+	uint64_t async_seq;
 	struct hlist_head cached_bufs;
 	struct hlist_head remote_bufs;
 	struct fastrpc_ctx_lst clst;
@@ -414,7 +498,9 @@ struct fastrpc_file {
 	int sharedcb;
 	struct fastrpc_apps *apps;
 	struct hlist_head perf;
+	struct hlist_head method_prof;	/* under perf_mutex */
 	struct dentry *debugfs_file;
+	struct dentry *debugfs_prof_file;
 	struct mutex perf_mutex;
 	struct pm_qos_request pm_qos_req;
 	int qos_request;
@@ -622,6 +708,7 @@ static void fastrpc_mmap_add(struct fastrpc_mmap *map)
 		struct fastrpc_file *fl = map->fl;
 
 		hlist_add_head(&map->hn, &fl->maps);
+		hash_add(fl->map_hash, &map->hn_fd, map->fd);
 	}
 }
 
@@ -655,7 +742,12 @@ static int fastrpc_mmap_find(struct fastrpc_file *fl, int fd,
 		}
 		spin_unlock(&me->hlock);
 	} else {
-		hlist_for_each_entry_safe(map, n, &fl->maps, hn) {
+		/*
+		 * get_args() looks every fd argument up on each invocation,
+		 * so per-process maps are also hashed by fd to keep that
+		 * cheap for clients that keep many buffers mapped.
+		 */
+		hash_for_each_possible(fl->map_hash, map, hn_fd, fd) {
 			if (va >= map->va &&
 				va + len <= map->va + map->len &&
 				map->fd == fd) {
@@ -733,6 +825,7 @@ static int fastrpc_mmap_remove(struct fastrpc_file *fl, uintptr_t va,
 			!map->is_filemap) {
 			match = map;
 			hlist_del_init(&map->hn);
+			hlist_del_init(&map->hn_fd);
 			break;
 		}
 	}
@@ -781,8 +874,10 @@ static void fastrpc_mmap_free(struct fastrpc_mmap *map, uint32_t flags)
 			return;
 	} else {
 		map->refs--;
-		if (!map->refs)
+		if (!map->refs) {
 			hlist_del_init(&map->hn);
+			hlist_del_init(&map->hn_fd);
+		}
 		if (map->refs > 0 && !flags)
 			return;
 	}
@@ -871,6 +966,7 @@ static int fastrpc_mmap_create(struct fastrpc_file *fl, int fd,
 	if (err)
 		goto bail;
 	INIT_HLIST_NODE(&map->hn);
+	INIT_HLIST_NODE(&map->hn_fd);
 	map->flags = mflags;
 	map->refs = 1;
 	map->fl = fl;
@@ -1255,6 +1351,7 @@ static int context_alloc(struct fastrpc_file *fl, uint32_t kernel,
 
 	INIT_HLIST_NODE(&ctx->hn);
 	hlist_add_fake(&ctx->hn);
+	INIT_LIST_HEAD(&ctx->async_node);
 	ctx->fl = fl;
 	ctx->maps = (struct fastrpc_mmap **)(&ctx[1]);
 	ctx->lpra = (remote_arg_t *)(&ctx->maps[bufs]);
@@ -1346,6 +1443,11 @@ static void context_free(struct smq_invoke_ctx *ctx)
 	spin_lock(&ctx->fl->hlock);
 	hlist_del_init(&ctx->hn);
 	spin_unlock(&ctx->fl->hlock);
+	if (ctx->async) {
+		spin_lock_irqsave(&ctx->fl->async_lock, irq_flags);
+		list_del_init(&ctx->async_node);
+		spin_unlock_irqrestore(&ctx->fl->async_lock, irq_flags);
+	}
 	mutex_lock(&ctx->fl->fl_map_mutex);
 	for (i = 0; i < nbufs; ++i)
 		fastrpc_mmap_free(ctx->maps[i], 0);
@@ -1374,10 +1476,30 @@ static void context_free(struct smq_invoke_ctx *ctx)
 	kfree(ctx);
 }
 
+/*
+ * Wake whoever reaps @ctx: the invoking thread for synchronous calls, the
+ * completion queue of the file for async jobs.
+ */
+static void context_complete(struct smq_invoke_ctx *ctx)
+{
+	struct fastrpc_file *fl = ctx->fl;
+	unsigned long irq_flags = 0;
+
+	complete(&ctx->work);
+	if (!ctx->async)
+		return;
+
+	spin_lock_irqsave(&fl->async_lock, irq_flags);
+	if (list_empty(&ctx->async_node))
+		list_add_tail(&ctx->async_node, &fl->async_done);
+	spin_unlock_irqrestore(&fl->async_lock, irq_flags);
+	wake_up_interruptible(&fl->async_wait);
+}
+
 static void context_notify_user(struct smq_invoke_ctx *ctx, int retval)
 {
 	ctx->retval = retval;
-	complete(&ctx->work);
+	context_complete(ctx);
 }
 
 
@@ -1388,7 +1510,7 @@ static void fastrpc_notify_users(struct fastrpc_file *me)
 
 	spin_lock(&me->hlock);
 	hlist_for_each_entry_safe(ictx, n, &me->clst.pending, hn) {
-		complete(&ictx->work);
+		context_complete(ictx);
 	}
 	hlist_for_each_entry_safe(ictx, n, &me->clst.interrupted, hn) {
 		complete(&ictx->work);
@@ -1406,7 +1528,7 @@ static void fastrpc_notify_users_staticpd_pdr(struct fastrpc_file *me)
 	spin_lock(&me->hlock);
 	hlist_for_each_entry_safe(ictx, n, &me->clst.pending, hn) {
 		if (ictx->msg.pid)
-			complete(&ictx->work);
+			context_complete(ictx);
 	}
 	hlist_for_each_entry_safe(ictx, n, &me->clst.interrupted, hn) {
 		if (ictx->msg.pid)
@@ -1502,6 +1624,37 @@ static void fastrpc_file_list_dtor(struct fastrpc_apps *me)
 	} while (free);
 }
 
+/*
+ * Buffers passed DSP to DSP are never touched by the cpu between calls.
+ * ION counts the cpu accesses it can see, so if the count didn't move since
+ * the last maintenance there is nothing in the cpu caches to clean.
+ */
+static bool fastrpc_map_cpu_untouched(struct fastrpc_file *fl,
+				      struct fastrpc_mmap *map)
+{
+	unsigned int seq;
+
+	if (!map || !map->handle || !map->cpu_seq_valid)
+		return false;
+	return ion_handle_cpu_access_seq(fl->apps->client, map->handle, &seq) &&
+		seq == map->cpu_seq;
+}
+
+/* @map was just cleaned for [pv, pv + len), only the whole of it counts */
+static void fastrpc_map_cpu_synced(struct fastrpc_file *fl,
+				   struct fastrpc_mmap *map,
+				   uint64_t pv, uint64_t len)
+{
+	if (!map || !map->handle)
+		return;
+	if (pv > map->va || pv + len < map->va + map->len) {
+		map->cpu_seq_valid = false;
+		return;
+	}
+	map->cpu_seq_valid = ion_handle_cpu_access_seq(fl->apps->client,
+						map->handle, &map->cpu_seq);
+}
+
 static int get_args(uint32_t kernel, struct smq_invoke_ctx *ctx)
 {
 	struct fastrpc_apps *me = &gfa;
@@ -1742,16 +1895,20 @@ static int get_args(uint32_t kernel, struct smq_invoke_ctx *ctx)
 			continue;
 		if (map && (map->attr & FASTRPC_ATTR_COHERENT))
 			continue;
+		if (fastrpc_map_cpu_untouched(ctx->fl, map))
+			continue;
 
 		if (rpra && lrpra && rpra[i].buf.len &&
 			ctx->overps[oix]->mstart) {
-			if (map && map->handle)
+			if (map && map->handle) {
 				msm_ion_do_cache_op(ctx->fl->apps->client,
 					map->handle,
 					uint64_to_ptr(rpra[i].buf.pv),
 					rpra[i].buf.len,
 					ION_IOC_CLEAN_INV_CACHES);
-			else
+				fastrpc_map_cpu_synced(ctx->fl, map,
+					rpra[i].buf.pv, rpra[i].buf.len);
+			} else
 				dmac_flush_range(uint64_to_ptr(rpra[i].buf.pv),
 					uint64_to_ptr(rpra[i].buf.pv
 						+ rpra[i].buf.len));
@@ -1850,6 +2007,8 @@ static void inv_args_pre(struct smq_invoke_ctx *ctx)
 			continue;
 		if (map && (map->attr & FASTRPC_ATTR_COHERENT))
 			continue;
+		if (fastrpc_map_cpu_untouched(ctx->fl, map))
+			continue;
 
 		if (buf_page_start(ptr_to_uint64((void *)rpra)) ==
 				buf_page_start(rpra[i].buf.pv))
@@ -1909,6 +2068,17 @@ static void inv_args(struct smq_invoke_ctx *ctx)
 				buf_page_start(rpra[i].buf.pv)) {
 			continue;
 		}
+		/*
+		 * Nothing dirty in the cpu caches and no way for the cpu to
+		 * reach the buffer without ion noticing: leave the invalidate
+		 * to ion's next cpu access, so a buffer going straight back
+		 * to the DSP never pays for it.
+		 */
+		if (fastrpc_map_cpu_untouched(ctx->fl, map)) {
+			ion_handle_defer_cpu_inv(ctx->fl->apps->client,
+						 map->handle);
+			continue;
+		}
 		if (map && map->handle)
 			msm_ion_do_cache_op(ctx->fl->apps->client, map->handle,
 				(char *)uint64_to_ptr(rpra[i].buf.pv),
@@ -2066,6 +2236,7 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 	int err = 0, cid = -1, interrupted = 0;
 	struct timespec invoket = {0};
 	int64_t *perf_counter = NULL;
+	uint64_t stamp[PROF_PHASE_MAX + 1] = {0};
 
 	cid = fl->cid;
 	VERIFY(err, cid >= ADSP_DOMAIN_ID && cid < NUM_CHANNELS);
@@ -2112,6 +2283,7 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 	if (err)
 		goto bail;
 
+	PROF_STAMP(fl, stamp, PROF_GETARGS);
 	if (REMOTE_SCALARS_LENGTH(ctx->sc)) {
 		PERF(fl->profile, GET_COUNTER(perf_counter, PERF_GETARGS),
 		VERIFY(err, 0 == get_args(kernel, ctx));
@@ -2120,18 +2292,21 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 			goto bail;
 	}
 
+	PROF_STAMP(fl, stamp, PROF_FLUSH);
 	if (!fl->sctx->smmu.coherent) {
 		PERF(fl->profile, GET_COUNTER(perf_counter, PERF_INVARGS),
 		inv_args_pre(ctx);
 		PERF_END);
 	}
 
+	PROF_STAMP(fl, stamp, PROF_SEND);
 	PERF(fl->profile, GET_COUNTER(perf_counter, PERF_LINK),
 	VERIFY(err, 0 == fastrpc_invoke_send(ctx, kernel, invoke->handle));
 	PERF_END);
 
 	if (err)
 		goto bail;
+	PROF_STAMP(fl, stamp, PROF_DSP);
  wait:
 	if (kernel)
 		wait_for_completion(&ctx->work);
@@ -2141,6 +2316,7 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 		if (err)
 			goto bail;
 	}
+	PROF_STAMP(fl, stamp, PROF_INVAL);
 	PERF(fl->profile, GET_COUNTER(perf_counter, PERF_INVARGS),
 	if (!fl->sctx->smmu.coherent)
 		inv_args(ctx);
@@ -2150,11 +2326,18 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 	if (err)
 		goto bail;
 
+	PROF_STAMP(fl, stamp, PROF_PUTARGS);
 	PERF(fl->profile, GET_COUNTER(perf_counter, PERF_PUTARGS),
 	VERIFY(err, 0 == put_args(kernel, ctx, invoke->pra));
 	PERF_END);
 	if (err)
 		goto bail;
+	PROF_STAMP(fl, stamp, PROF_PHASE_MAX);
+
+	/* calls restored after an interrupt miss their early stamps */
+	if (fl->profile && stamp[PROF_GETARGS])
+		fastrpc_method_prof_update(fl, invoke->handle, invoke->sc,
+					   stamp);
  bail:
 	if (ctx && interrupted == -ERESTARTSYS)
 		context_save_interrupted(ctx);
@@ -2180,6 +2363,121 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 	return err;
 }
 
+static int fastrpc_internal_invoke_async(struct fastrpc_file *fl,
+				struct fastrpc_ioctl_invoke_async *inv_async)
+{
+	struct smq_invoke_ctx *ctx = NULL;
+	struct fastrpc_ioctl_invoke_crc inv = {
+		.inv = inv_async->inv,
+		.fds = inv_async->fds,
+		.attrs = inv_async->attrs,
+	};
+	struct fastrpc_ioctl_invoke *invoke = &inv.inv;
+	unsigned long irq_flags = 0;
+	int err = 0, cid = -1;
+
+	cid = fl->cid;
+	VERIFY(err, cid >= ADSP_DOMAIN_ID && cid < NUM_CHANNELS);
+	if (err) {
+		err = -ECHRNG;
+		goto bail;
+	}
+	VERIFY(err, fl->sctx != NULL);
+	if (err) {
+		err = -EBADR;
+		goto bail;
+	}
+	VERIFY(err, invoke->handle > FASTRPC_STATIC_HANDLE_MAX);
+	if (err) {
+		err = -EINVAL;
+		goto bail;
+	}
+	if (fl->sctx->smmu.faults) {
+		err = FASTRPC_ENOSUCH;
+		goto bail;
+	}
+
+	VERIFY(err, 0 == context_alloc(fl, 0, &inv, &ctx));
+	if (err)
+		goto bail;
+
+	ctx->upra = invoke->pra;
+	spin_lock_irqsave(&fl->async_lock, irq_flags);
+	ctx->jobid = ++fl->async_seq;
+	spin_unlock_irqrestore(&fl->async_lock, irq_flags);
+	/* must be set before the DSP can see the message */
+	ctx->async = true;
+
+	if (REMOTE_SCALARS_LENGTH(ctx->sc)) {
+		VERIFY(err, 0 == get_args(0, ctx));
+		if (err)
+			goto bail;
+	}
+
+	if (!fl->sctx->smmu.coherent)
+		inv_args_pre(ctx);
+
+	VERIFY(err, 0 == fastrpc_invoke_send(ctx, 0, invoke->handle));
+	if (err)
+		goto bail;
+
+	inv_async->jobid = ctx->jobid;
+	return 0;
+ bail:
+	if (ctx)
+		context_free(ctx);
+	return err;
+}
+
+static int fastrpc_async_wait(struct fastrpc_file *fl,
+			      struct fastrpc_ioctl_async_response *resp)
+{
+	struct smq_invoke_ctx *ctx = NULL;
+	unsigned long irq_flags = 0;
+	int err = 0, cid = fl->cid;
+
+	do {
+		spin_lock_irqsave(&fl->async_lock, irq_flags);
+		ctx = list_first_entry_or_null(&fl->async_done,
+					struct smq_invoke_ctx, async_node);
+		if (ctx)
+			list_del_init(&ctx->async_node);
+		spin_unlock_irqrestore(&fl->async_lock, irq_flags);
+		if (ctx)
+			break;
+
+		if (resp->flags & FASTRPC_ASYNC_NONBLOCK)
+			return -EAGAIN;
+		err = wait_event_interruptible(fl->async_wait,
+					       !list_empty(&fl->async_done));
+		if (err)
+			return err;
+	} while (1);
+
+	/* put_args() copies results into the submitter's address space */
+	VERIFY(err, ctx->tgid == current->tgid);
+	if (err) {
+		err = -EPERM;
+		goto bail;
+	}
+
+	if (!fl->sctx->smmu.coherent)
+		inv_args(ctx);
+
+	VERIFY(err, 0 == (err = ctx->retval));
+	if (err)
+		goto bail;
+
+	VERIFY(err, 0 == put_args(0, ctx, ctx->upra));
+ bail:
+	if (fl->ssrcount != fl->apps->channel[cid].ssrcount)
+		err = ECONNRESET;
+	resp->jobid = ctx->jobid;
+	resp->result = err;
+	context_free(ctx);
+	return 0;
+}
+
 static int fastrpc_get_adsp_session(char *name, int *session)
 {
 	struct fastrpc_apps *me = &gfa;
@@ -3217,6 +3515,8 @@ static int fastrpc_file_free(struct fastrpc_file *fl)
 	struct hlist_node *n = NULL;
 	struct fastrpc_mmap *map = NULL, *lmap = NULL;
 	struct fastrpc_perf *perf = NULL, *fperf = NULL;
+	struct fastrpc_method_prof *prof;
+	struct hlist_node *nprof;
 	int cid;
 
 	if (!fl)
@@ -3246,6 +3546,7 @@ static int fastrpc_file_free(struct fastrpc_file *fl)
 		lmap = NULL;
 		hlist_for_each_entry_safe(map, n, &fl->maps, hn) {
 			hlist_del_init(&map->hn);
+			hlist_del_init(&map->hn_fd);
 			lmap = map;
 			break;
 		}
@@ -3272,6 +3573,10 @@ static int fastrpc_file_free(struct fastrpc_file *fl)
 		}
 		kfree(fperf);
 	} while (fperf);
+	hlist_for_each_entry_safe(prof, nprof, &fl->method_prof, hn) {
+		hlist_del(&prof->hn);
+		kfree(prof);
+	}
 	fastrpc_remote_buf_list_free(fl);
 	mutex_unlock(&fl->perf_mutex);
 	mutex_destroy(&fl->perf_mutex);
@@ -3291,6 +3596,7 @@ static int fastrpc_device_release(struct inode *inode, struct file *file)
 			pm_qos_remove_request(&fl->pm_qos_req);
 		if (fl->debugfs_file != NULL)
 			debugfs_remove(fl->debugfs_file);
+		debugfs_remove(fl->debugfs_prof_file);
 		fastrpc_file_free(fl);
 		file->private_data = NULL;
 	}
@@ -3666,6 +3972,56 @@ static const struct file_operations debugfs_fops = {
 	.open = fastrpc_debugfs_open,
 	.read = fastrpc_debugfs_read,
 };
+
+static int fastrpc_prof_show(struct seq_file *m, void *v)
+{
+	static const char * const phases[PROF_PHASE_MAX] = {
+		"getargs", "flush", "send", "dsp", "inval", "putargs",
+	};
+	struct fastrpc_file *fl = m->private;
+	struct fastrpc_method_prof *prof;
+	int i;
+
+	seq_printf(m, "%-10s %-6s %-10s", "handle", "method", "count");
+	for (i = 0; i < PROF_PHASE_MAX; i++)
+		seq_printf(m, " %-10s", phases[i]);
+	seq_puts(m, " (avg us)\n");
+
+	mutex_lock(&fl->perf_mutex);
+	hlist_for_each_entry(prof, &fl->method_prof, hn) {
+		seq_printf(m, "0x%-8x %-6u %-10llu", prof->handle,
+			   prof->method, prof->count);
+		for (i = 0; i < PROF_PHASE_MAX; i++)
+			seq_printf(m, " %-10llu", div64_u64(prof->phase_ns[i],
+				   prof->count * NSEC_PER_USEC));
+		seq_puts(m, "\n  latency_us");
+		for (i = 0; i < FASTRPC_PROF_BUCKETS; i++) {
+			if (!prof->hist[i])
+				continue;
+			if (i == FASTRPC_PROF_BUCKETS - 1)
+				seq_printf(m, " >=%u:%u", 1U << (i - 1),
+					   prof->hist[i]);
+			else
+				seq_printf(m, " <%u:%u", 1U << i,
+					   prof->hist[i]);
+		}
+		seq_puts(m, "\n");
+	}
+	mutex_unlock(&fl->perf_mutex);
+	return 0;
+}
+
+static int fastrpc_prof_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, fastrpc_prof_show, inode->i_private);
+}
+
+static const struct file_operations debugfs_prof_fops = {
+	.open = fastrpc_prof_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
 static int fastrpc_channel_open(struct fastrpc_file *fl)
 {
 	struct fastrpc_apps *me = &gfa;
@@ -3770,6 +4126,11 @@ static int fastrpc_device_open(struct inode *inode, struct file *filp)
 	context_list_ctor(&fl->clst);
 	spin_lock_init(&fl->hlock);
 	INIT_HLIST_HEAD(&fl->maps);
+	hash_init(fl->map_hash);
+	INIT_HLIST_HEAD(&fl->method_prof);
+	spin_lock_init(&fl->async_lock);
+	INIT_LIST_HEAD(&fl->async_done);
+	init_waitqueue_head(&fl->async_wait);
 	INIT_HLIST_HEAD(&fl->perf);
 	INIT_HLIST_HEAD(&fl->cached_bufs);
 	INIT_HLIST_HEAD(&fl->remote_bufs);
@@ -3798,6 +4159,7 @@ static int fastrpc_set_process_info(struct fastrpc_file *fl)
 	int err = 0, buf_size = 0;
 	char strpid[PID_SIZE];
 	char cur_comm[TASK_COMM_LEN];
+	char prof_name[TASK_COMM_LEN + PID_SIZE + 6];
 
 	memcpy(cur_comm, current->comm, TASK_COMM_LEN);
 	cur_comm[TASK_COMM_LEN-1] = '\0';
@@ -3817,6 +4179,11 @@ static int fastrpc_set_process_info(struct fastrpc_file *fl)
 		pr_warn("Error: %s: %s: failed to create debugfs file %s\n",
 				cur_comm, __func__, fl->debug_buf);
 
+	/* per method timings, filled in while profiling is enabled */
+	snprintf(prof_name, sizeof(prof_name), "%s_prof", fl->debug_buf);
+	fl->debugfs_prof_file = debugfs_create_file(prof_name, 0444,
+					debugfs_root, fl, &debugfs_prof_fops);
+
 	return err;
 }
 
@@ -3974,6 +4341,8 @@ static long fastrpc_device_ioctl(struct file *file, unsigned int ioctl_num,
 		struct fastrpc_ioctl_perf perf;
 		struct fastrpc_ioctl_control cp;
 		struct fastrpc_ioctl_dsp_capabilities dsp_cap;
+		struct fastrpc_ioctl_invoke_async inv_async;
+		struct fastrpc_ioctl_async_response async_resp;
 	} p;
 	union {
 		struct fastrpc_ioctl_mmap mmap;
@@ -4193,6 +4562,34 @@ static long fastrpc_device_ioctl(struct file *file, unsigned int ioctl_num,
 	case FASTRPC_IOCTL_GET_DSP_INFO:
 		err = fastrpc_get_dsp_info(&p.dsp_cap, param, fl);
 		break;
+	case FASTRPC_IOCTL_INVOKE_ASYNC:
+		K_COPY_FROM_USER(err, 0, &p.inv_async, param,
+						sizeof(p.inv_async));
+		if (err)
+			goto bail;
+		VERIFY(err, 0 == (err = fastrpc_internal_invoke_async(fl,
+							&p.inv_async)));
+		if (err)
+			goto bail;
+		K_COPY_TO_USER(err, 0, param, &p.inv_async,
+						sizeof(p.inv_async));
+		if (err)
+			goto bail;
+		break;
+	case FASTRPC_IOCTL_ASYNC_WAIT:
+		K_COPY_FROM_USER(err, 0, &p.async_resp, param,
+						sizeof(p.async_resp));
+		if (err)
+			goto bail;
+		VERIFY(err, 0 == (err = fastrpc_async_wait(fl,
+							&p.async_resp)));
+		if (err)
+			goto bail;
+		K_COPY_TO_USER(err, 0, param, &p.async_resp,
+						sizeof(p.async_resp));
+		if (err)
+			goto bail;
+		break;
 	default:
 		err = -ENOTTY;
 		pr_info("bad ioctl: %d\n", ioctl_num);
@@ -4322,9 +4719,24 @@ pdr_register:
 	return NOTIFY_DONE;
 }
 
+static unsigned int fastrpc_device_poll(struct file *file, poll_table *wait)
+{
+	struct fastrpc_file *fl = (struct fastrpc_file *)file->private_data;
+	unsigned int mask = 0;
+
+	if (!fl)
+		return POLLERR;
+
+	poll_wait(file, &fl->async_wait, wait);
+	if (!list_empty(&fl->async_done))
+		mask |= POLLIN | POLLRDNORM;
+	return mask;
+}
+
 static const struct file_operations fops = {
 	.open = fastrpc_device_open,
 	.release = fastrpc_device_release,
+	.poll = fastrpc_device_poll,
 	.unlocked_ioctl = fastrpc_device_ioctl,
 	.compat_ioctl = compat_fastrpc_device_ioctl,
 };
@@ -34,6 +34,10 @@
 #define FASTRPC_IOCTL_MUNMAP_FD _IOWR('R', 13, struct fastrpc_ioctl_munmap_fd)
 #define FASTRPC_IOCTL_GET_DSP_INFO \
 			_IOWR('R', 16, struct fastrpc_ioctl_dsp_capabilities)
+#define FASTRPC_IOCTL_INVOKE_ASYNC \
+			_IOWR('R', 17, struct fastrpc_ioctl_invoke_async)
+#define FASTRPC_IOCTL_ASYNC_WAIT \
+			_IOWR('R', 18, struct fastrpc_ioctl_async_response)
 
 #define FASTRPC_GLINK_GUID "fastrpcglink-apps-dsp"
 #define FASTRPC_SMD_GUID "fastrpcsmd-apps-dsp"
@@ -73,6 +77,9 @@
 #define FASTRPC_INIT_CREATE_STATIC  2
 #define FASTRPC_INIT_ATTACH_SENSORS 3
 
+/* Retrives method id from the scalars parameter */
+#define REMOTE_SCALARS_METHOD(sc)        (((sc) >> 24) & 0x1f)
+
 /* Retrives number of input buffers from the scalars parameter */
 #define REMOTE_SCALARS_INBUFS(sc)        (((sc) >> 16) & 0x0ff)
 
@@ -191,6 +198,27 @@ struct fastrpc_ioctl_invoke_crc {
 	unsigned int *crc;
 };
 
+/*
+ * Queue an invocation without waiting for the DSP.  The returned jobid is
+ * reported back through FASTRPC_IOCTL_ASYNC_WAIT once the call completed,
+ * the device fd polls readable while completions are pending.
+ */
+struct fastrpc_ioctl_invoke_async {
+	struct fastrpc_ioctl_invoke inv;
+	int *fds;		/* fd list */
+	unsigned int *attrs;	/* attribute list */
+	uint64_t jobid;		/* job id, returned */
+};
+
+/* Don't block in FASTRPC_IOCTL_ASYNC_WAIT if nothing has completed */
+#define FASTRPC_ASYNC_NONBLOCK	0x1
+
+struct fastrpc_ioctl_async_response {
+	uint32_t flags;		/* FASTRPC_ASYNC_* flags */
+	int result;		/* result of the completed job */
+	uint64_t jobid;		/* completed job, returned */
+};
+
 struct fastrpc_ioctl_init {
 	uint32_t flags;		/* one of FASTRPC_INIT_* macros */
 	uintptr_t file;		/* pointer to elf file */
@@ -192,6 +192,12 @@ int diag_mux_queue_read(int proc)
 	return 0;
 }
 
+/*
+ * buf is handed to the logger by reference: USB queues it as the request
+ * buffer and memory device mode parks it in its table until the logging
+ * process reads it. Either way it is given back to its owner through the
+ * logger's write_done, so the caller must not touch it until then.
+ */
 int diag_mux_write(int proc, unsigned char *buf, int len, int ctx)
 {
 	struct diag_logger_t *logger = NULL;
@@ -20,6 +20,7 @@
 #include <linux/uaccess.h>
 #include <linux/ratelimit.h>
 #include <linux/crc-ccitt.h>
+#include <asm/unaligned.h>
 #include "diagchar_hdlc.h"
 #include "diagchar.h"
 
@@ -148,6 +149,63 @@ void diag_hdlc_encode(struct diag_send_desc_type *src_desc,
 	src_desc->state = state;
 }
 
+#define HDLC_WORD_ONES		(~0UL / 0xFF)
+#define HDLC_WORD_HIGHS		(HDLC_WORD_ONES * 0x80)
+#define HDLC_WORD_HAS(w, c) \
+	((((w) ^ (HDLC_WORD_ONES * (c))) - HDLC_WORD_ONES) & \
+	 ~((w) ^ (HDLC_WORD_ONES * (c))) & HDLC_WORD_HIGHS)
+
+static inline uint8_t *hdlc_put_byte(uint8_t *dest, uint8_t c)
+{
+	if (c == CONTROL_CHAR || c == ESC_CHAR) {
+		*dest++ = ESC_CHAR;
+		c ^= ESC_MASK;
+	}
+	*dest++ = c;
+	return dest;
+}
+
+/*
+ * Encodes a complete packet in one go. Produces the same output as
+ * diag_hdlc_encode() with terminate set, but computes the CRC over the whole
+ * packet and copies the runs between bytes that need escaping, checking a
+ * word at a time for them. dest must hold HDLC_ENCODED_MAX_LEN(len) bytes.
+ * Returns the number of bytes written to dest.
+ */
+int diag_hdlc_encode_pkt(const uint8_t *src, int len, uint8_t *dest)
+{
+	const uint8_t *end = src + len;
+	const uint8_t *run;
+	uint8_t *start = dest;
+	unsigned long word;
+	uint16_t crc;
+
+	crc = ~crc_ccitt(CRC_16_L_SEED, src, len);
+
+	while (src < end) {
+		run = src;
+		while (end - src >= sizeof(word)) {
+			word = get_unaligned((const unsigned long *)src);
+			if (HDLC_WORD_HAS(word, CONTROL_CHAR) ||
+			    HDLC_WORD_HAS(word, ESC_CHAR))
+				break;
+			src += sizeof(word);
+		}
+		while (src < end && *src != CONTROL_CHAR && *src != ESC_CHAR)
+			src++;
+
+		memcpy(dest, run, src - run);
+		dest += src - run;
+		if (src < end)
+			dest = hdlc_put_byte(dest, *src++);
+	}
+
+	dest = hdlc_put_byte(dest, crc & 0xFF);
+	dest = hdlc_put_byte(dest, crc >> 8);
+	*dest++ = CONTROL_CHAR;
+
+	return dest - start;
+}
 
 int diag_hdlc_decode(struct diag_hdlc_decode_type *hdlc)
 {
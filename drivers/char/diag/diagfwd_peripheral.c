@@ -161,16 +161,22 @@ static int diag_add_hdlc_encoding(unsigned char *dest_buf, int *dest_len,
 			break;
 		}
 
-		/* Prepare for encoding the data */
-		send.state = DIAG_STATE_START;
-		send.pkt = payload;
-		send.last = (void *)(payload + header->length - 1);
-		send.terminate = 1;
-
-		enc.dest = temp_encode_buf;
-		enc.dest_last = (void *)(temp_encode_buf + max_size);
-		enc.crc = 0;
-		diag_hdlc_encode(&send, &enc);
+		if (bytes_remaining >= HDLC_ENCODED_MAX_LEN(header->length)) {
+			enc.dest = temp_encode_buf +
+				diag_hdlc_encode_pkt(payload, header->length,
+						     temp_encode_buf);
+		} else {
+			/* Prepare for encoding the data */
+			send.state = DIAG_STATE_START;
+			send.pkt = payload;
+			send.last = (void *)(payload + header->length - 1);
+			send.terminate = 1;
+
+			enc.dest = temp_encode_buf;
+			enc.dest_last = (void *)(temp_encode_buf + max_size);
+			enc.crc = 0;
+			diag_hdlc_encode(&send, &enc);
+		}
 
 		/* Prepare for next packet */
 		src_pkt_len = (header_size + header->length + 1);
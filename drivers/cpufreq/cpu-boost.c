@@ -22,6 +22,11 @@
 #include <linux/slab.h>
 #include <linux/input.h>
 #include <linux/time.h>
+#include <linux/spinlock.h>
+#include <linux/cpu_boost.h>
+#ifdef CONFIG_DRM_MSM
+#include <linux/msm_drm_notify.h>
+#endif
 
 struct cpu_sync {
 	int cpu;
@@ -48,6 +53,37 @@ static struct delayed_work input_boost_rem;
 static u64 last_input_time;
 #define MIN_INPUT_INTERVAL (150 * USEC_PER_MSEC)
 
+/*
+ * Frame paced boosting: when enabled, display commits are watched while an
+ * input boost is held. Once frame_hits consecutive frames land within
+ * frame_target_us (plus 25% slack) and no input arrived for a frame, the
+ * boost is dropped early. The boost level and duration are scaled by
+ * boost_scale, which shrinks after boosts that were released early without
+ * a late frame and grows back after boosts that saw late frames.
+ */
+static bool frame_boost;
+module_param(frame_boost, bool, 0644);
+
+static unsigned int frame_target_us = 16667;
+module_param(frame_target_us, uint, 0644);
+
+static unsigned int frame_hits = 3;
+module_param(frame_hits, uint, 0644);
+
+static unsigned int boost_scale = 100;
+module_param(boost_scale, uint, 0444);
+
+#define BOOST_SCALE_MIN 50
+#define BOOST_SCALE_STEP 10
+
+static DEFINE_SPINLOCK(frame_lock);
+static bool frame_boost_active;
+static bool frame_boost_released;
+static u64 last_frame_time;
+static u64 last_event_time;
+static unsigned int frames_on_time;
+static unsigned int frames_late;
+
 static int set_input_boost_freq(const char *buf, const struct kernel_param *kp)
 {
 	int i, ntokens = 0;
@@ -185,12 +221,25 @@ static void do_input_boost_rem(struct work_struct *work)
 			pr_err("cpu-boost: HMP boost disable failed\n");
 		sched_boost_active = false;
 	}
+
+	spin_lock(&frame_lock);
+	if (frame_boost_active) {
+		if (frames_late)
+			boost_scale = min(boost_scale + 2 * BOOST_SCALE_STEP,
+					  100U);
+		else if (frame_boost_released)
+			boost_scale = max(boost_scale - BOOST_SCALE_STEP,
+					  (unsigned int)BOOST_SCALE_MIN);
+		frame_boost_active = false;
+	}
+	spin_unlock(&frame_lock);
 }
 
 static void do_input_boost(struct work_struct *work)
 {
 	unsigned int i, ret;
 	struct cpu_sync *i_sync_info;
+	unsigned int scale = 100;
 
 	cancel_delayed_work_sync(&input_boost_rem);
 	if (sched_boost_active) {
@@ -198,11 +247,23 @@ static void do_input_boost(struct work_struct *work)
 		sched_boost_active = false;
 	}
 
+	spin_lock(&frame_lock);
+	frame_boost_active = frame_boost;
+	if (frame_boost_active) {
+		scale = boost_scale;
+		frame_boost_released = false;
+		frames_on_time = 0;
+		frames_late = 0;
+		last_frame_time = last_input_time;
+	}
+	spin_unlock(&frame_lock);
+
 	/* Set the input_boost_min for all CPUs in the system */
 	pr_debug("Setting input boost min for all CPUs\n");
 	for_each_possible_cpu(i) {
 		i_sync_info = &per_cpu(sync_info, i);
-		i_sync_info->input_boost_min = i_sync_info->input_boost_freq;
+		i_sync_info->input_boost_min =
+				i_sync_info->input_boost_freq * scale / 100;
 	}
 
 	/* Update policies for all online CPUs */
@@ -218,11 +279,61 @@ static void do_input_boost(struct work_struct *work)
 	}
 
 	queue_delayed_work(cpu_boost_wq, &input_boost_rem,
-					msecs_to_jiffies(input_boost_ms));
+				msecs_to_jiffies(input_boost_ms * scale / 100));
 }
 
-static void cpuboost_input_event(struct input_handle *handle,
-		unsigned int type, unsigned int code, int value)
+#ifdef CONFIG_DRM_MSM
+static int cpuboost_frame_notify(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	struct msm_drm_notifier *evdata = data;
+	u64 now, interval, deadline;
+	bool release = false;
+
+	if (event != MSM_DRM_EVENT_COMMIT_DONE || !evdata ||
+	    evdata->id != MSM_DRM_PRIMARY_DISPLAY)
+		return NOTIFY_DONE;
+
+	if (!READ_ONCE(frame_boost_active))
+		return NOTIFY_DONE;
+
+	now = ktime_to_us(ktime_get());
+	deadline = frame_target_us + frame_target_us / 4;
+
+	spin_lock(&frame_lock);
+	if (!frame_boost_active || frame_boost_released)
+		goto unlock;
+
+	/* the first frame is measured from the input that started the boost */
+	interval = now - last_frame_time;
+	last_frame_time = now;
+	if (interval <= deadline) {
+		frames_on_time++;
+	} else {
+		frames_on_time = 0;
+		frames_late++;
+	}
+
+	if (frames_on_time >= frame_hits &&
+	    now - READ_ONCE(last_event_time) > frame_target_us) {
+		frame_boost_released = true;
+		release = true;
+	}
+unlock:
+	spin_unlock(&frame_lock);
+
+	if (release)
+		mod_delayed_work(cpu_boost_wq, &input_boost_rem, 0);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpuboost_frame_nb = {
+	.notifier_call = cpuboost_frame_notify,
+};
+#endif
+
+static void cpuboost_input_start(void)
 {
 	u64 now;
 
@@ -230,6 +341,7 @@ static void cpuboost_input_event(struct input_handle *handle,
 		return;
 
 	now = ktime_to_us(ktime_get());
+	WRITE_ONCE(last_event_time, now);
 	if (now - last_input_time < MIN_INPUT_INTERVAL)
 		return;
 
@@ -240,6 +352,27 @@ static void cpuboost_input_event(struct input_handle *handle,
 	last_input_time = ktime_to_us(ktime_get());
 }
 
+static void cpuboost_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	cpuboost_input_start();
+}
+
+/**
+ * cpu_boost_kick - start the input boost from a driver's interrupt
+ *
+ * Touch controllers report their first event only after a bus read in
+ * the irq thread. Calling this from the primary handler starts the boost
+ * that much earlier; the events reported next then fall within
+ * MIN_INPUT_INTERVAL and do not queue it again. Safe in hardirq context.
+ */
+void cpu_boost_kick(void)
+{
+	if (cpu_boost_wq)
+		cpuboost_input_start();
+}
+EXPORT_SYMBOL(cpu_boost_kick);
+
 static int cpuboost_input_connect(struct input_handler *handler,
 		struct input_dev *dev, const struct input_device_id *id)
 {
@@ -330,6 +463,9 @@ static int cpu_boost_init(void)
 	cpufreq_register_notifier(&boost_adjust_nb, CPUFREQ_POLICY_NOTIFIER);
 
 	ret = input_register_handler(&cpuboost_input_handler);
+#ifdef CONFIG_DRM_MSM
+	msm_drm_register_client(&cpuboost_frame_nb);
+#endif
 	return 0;
 }
 late_initcall(cpu_boost_init);
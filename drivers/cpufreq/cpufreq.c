@@ -448,8 +448,10 @@ static void __cpufreq_notify_transition(struct cpufreq_policy *policy,
 		cpufreq_times_record_transition(policy, freqs->new);
 		srcu_notifier_call_chain(&cpufreq_transition_notifier_list,
 				CPUFREQ_POSTCHANGE, freqs);
-		if (likely(policy) && likely(policy->cpu == freqs->cpu))
+		if (likely(policy) && likely(policy->cpu == freqs->cpu)) {
 			policy->cur = freqs->new;
+			policy->fast_switch_notified = freqs->new;
+		}
 		break;
 	}
 }
@@ -541,36 +543,50 @@ void cpufreq_freq_transition_end(struct cpufreq_policy *policy,
 EXPORT_SYMBOL_GPL(cpufreq_freq_transition_end);
 
 /*
- * Fast frequency switching status count.  Positive means "enabled", negative
- * means "disabled" and 0 means "not decided yet".
+ * Deliver the fast switches of a policy to the transition notifiers. Any
+ * number of switches since the last run collapse into a single
+ * CPUFREQ_POSTCHANGE from the last notified to the current frequency.
  */
-static int cpufreq_fast_switch_count;
-static DEFINE_MUTEX(cpufreq_fast_switch_lock);
-
-static void cpufreq_list_transition_notifiers(void)
+static void cpufreq_fast_switch_notify(struct work_struct *work)
 {
-	struct notifier_block *nb;
+	struct cpufreq_policy *policy =
+		container_of(work, struct cpufreq_policy, fast_switch_work);
+	struct cpufreq_freqs freqs;
 
-	pr_info("Registered transition notifiers:\n");
+	freqs.old = policy->fast_switch_notified;
+	freqs.new = READ_ONCE(policy->cur);
+	if (freqs.new == freqs.old)
+		return;
 
-	mutex_lock(&cpufreq_transition_notifier_list.mutex);
+	policy->fast_switch_notified = freqs.new;
+	freqs.flags = cpufreq_driver->flags;
+	cpufreq_stats_record_transition(policy, freqs.new);
+	for_each_cpu(freqs.cpu, policy->cpus)
+		srcu_notifier_call_chain(&cpufreq_transition_notifier_list,
+					 CPUFREQ_POSTCHANGE, &freqs);
+}
 
-	for (nb = cpufreq_transition_notifier_list.head; nb; nb = nb->next)
-		pr_info("%pF\n", nb->notifier_call);
+/*
+ * Fast switches may come from the scheduler with a runqueue lock held, so
+ * the work is queued from an irq_work rather than directly.
+ */
+static void cpufreq_fast_switch_irq_work(struct irq_work *irq_work)
+{
+	struct cpufreq_policy *policy = container_of(irq_work,
+			struct cpufreq_policy, fast_switch_irq_work);
 
-	mutex_unlock(&cpufreq_transition_notifier_list.mutex);
+	schedule_work(&policy->fast_switch_work);
 }
 
 /**
  * cpufreq_enable_fast_switch - Enable fast frequency switching for policy.
  * @policy: cpufreq policy to enable fast frequency switching for.
  *
- * Try to enable fast frequency switching for @policy.
+ * Enable fast frequency switching for @policy if its driver supports it.
  *
- * The attempt will fail if there is at least one transition notifier registered
- * at this point, as fast frequency switching is quite fundamentally at odds
- * with transition notifiers.  Thus if successful, it will make registration of
- * transition notifiers fail going forward.
+ * Transition notifiers keep working: they receive a deferred
+ * CPUFREQ_POSTCHANGE, without a matching CPUFREQ_PRECHANGE, for the latest
+ * frequency set by a burst of fast switches.
  */
 void cpufreq_enable_fast_switch(struct cpufreq_policy *policy)
 {
@@ -579,32 +595,27 @@ void cpufreq_enable_fast_switch(struct cpufreq_policy *policy)
 	if (!policy->fast_switch_possible)
 		return;
 
-	mutex_lock(&cpufreq_fast_switch_lock);
-	if (cpufreq_fast_switch_count >= 0) {
-		cpufreq_fast_switch_count++;
-		policy->fast_switch_enabled = true;
-	} else {
-		pr_warn("CPU%u: Fast frequency switching not enabled\n",
-			policy->cpu);
-		cpufreq_list_transition_notifiers();
-	}
-	mutex_unlock(&cpufreq_fast_switch_lock);
+	policy->fast_switch_notified = policy->cur;
+	policy->fast_switch_enabled = true;
 }
 EXPORT_SYMBOL_GPL(cpufreq_enable_fast_switch);
 
 /**
  * cpufreq_disable_fast_switch - Disable fast frequency switching for policy.
  * @policy: cpufreq policy to disable fast frequency switching for.
+ *
+ * The governor must have stopped calling cpufreq_driver_fast_switch() for
+ * @policy. Notifications still pending for it are delivered before this
+ * returns.
  */
 void cpufreq_disable_fast_switch(struct cpufreq_policy *policy)
 {
-	mutex_lock(&cpufreq_fast_switch_lock);
-	if (policy->fast_switch_enabled) {
-		policy->fast_switch_enabled = false;
-		if (!WARN_ON(cpufreq_fast_switch_count <= 0))
-			cpufreq_fast_switch_count--;
-	}
-	mutex_unlock(&cpufreq_fast_switch_lock);
+	if (!policy->fast_switch_enabled)
+		return;
+
+	policy->fast_switch_enabled = false;
+	irq_work_sync(&policy->fast_switch_irq_work);
+	flush_work(&policy->fast_switch_work);
 }
 EXPORT_SYMBOL_GPL(cpufreq_disable_fast_switch);
 
@@ -1201,6 +1212,9 @@ static struct cpufreq_policy *cpufreq_policy_alloc(unsigned int cpu)
 	init_waitqueue_head(&policy->transition_wait);
 	init_completion(&policy->kobj_unregister);
 	INIT_WORK(&policy->update, handle_update);
+	init_irq_work(&policy->fast_switch_irq_work,
+		      cpufreq_fast_switch_irq_work);
+	INIT_WORK(&policy->fast_switch_work, cpufreq_fast_switch_notify);
 
 	policy->cpu = cpu;
 	return policy;
@@ -1864,18 +1878,8 @@ int cpufreq_register_notifier(struct notifier_block *nb, unsigned int list)
 
 	switch (list) {
 	case CPUFREQ_TRANSITION_NOTIFIER:
-		mutex_lock(&cpufreq_fast_switch_lock);
-
-		if (cpufreq_fast_switch_count > 0) {
-			mutex_unlock(&cpufreq_fast_switch_lock);
-			return -EBUSY;
-		}
 		ret = srcu_notifier_chain_register(
 				&cpufreq_transition_notifier_list, nb);
-		if (!ret)
-			cpufreq_fast_switch_count--;
-
-		mutex_unlock(&cpufreq_fast_switch_lock);
 		break;
 	case CPUFREQ_POLICY_NOTIFIER:
 		ret = blocking_notifier_chain_register(
@@ -1912,14 +1916,8 @@ int cpufreq_unregister_notifier(struct notifier_block *nb, unsigned int list)
 
 	switch (list) {
 	case CPUFREQ_TRANSITION_NOTIFIER:
-		mutex_lock(&cpufreq_fast_switch_lock);
-
 		ret = srcu_notifier_chain_unregister(
 				&cpufreq_transition_notifier_list, nb);
-		if (!ret && !WARN_ON(cpufreq_fast_switch_count >= 0))
-			cpufreq_fast_switch_count++;
-
-		mutex_unlock(&cpufreq_fast_switch_lock);
 		break;
 	case CPUFREQ_POLICY_NOTIFIER:
 		ret = blocking_notifier_chain_unregister(
@@ -1963,18 +1961,30 @@ EXPORT_SYMBOL(cpufreq_unregister_notifier);
  * If CPUFREQ_ENTRY_INVALID is returned by the driver's ->fast_switch()
  * callback to indicate an error condition, the hardware configuration must be
  * preserved.
+ *
+ * On success policy->cur is updated right away, while the transition
+ * notifiers and cpufreq-stats are updated later from process context, see
+ * cpufreq_fast_switch_notify().
  */
 unsigned int cpufreq_driver_fast_switch(struct cpufreq_policy *policy,
 					unsigned int target_freq)
 {
-	int ret;
+	unsigned int freq;
+	int cpu;
+
 	target_freq = clamp_val(target_freq, policy->min, policy->max);
 
-        ret = cpufreq_driver->fast_switch(policy, target_freq);
-	if (ret)
-		cpufreq_times_record_transition(policy, ret);
+	freq = cpufreq_driver->fast_switch(policy, target_freq);
+	if (!freq || freq == CPUFREQ_ENTRY_INVALID)
+		return freq;
 
-	return ret;
+	policy->cur = freq;
+	for_each_cpu(cpu, policy->cpus)
+		trace_cpu_frequency(freq, cpu);
+	cpufreq_times_record_transition(policy, freq);
+	irq_work_queue(&policy->fast_switch_irq_work);
+
+	return freq;
 }
 EXPORT_SYMBOL_GPL(cpufreq_driver_fast_switch);
 
@@ -62,6 +62,7 @@ struct cpufreq_interactive_policyinfo {
 	int governor_enabled;
 	struct cpufreq_interactive_tunables *cached_tunables;
 	struct sched_load *sl;
+	u64 hint_time;
 };
 
 /* Protected by per-policy load_lock */
@@ -71,6 +72,9 @@ struct cpufreq_interactive_cpuinfo {
 	u64 cputime_speedadj;
 	u64 cputime_speedadj_timestamp;
 	unsigned int loadadjfreq;
+	/* migrated-in demand, busy us per timer_rate, valid until expiry */
+	unsigned long hint_busy;
+	u64 hint_expires;
 };
 
 static DEFINE_PER_CPU(struct cpufreq_interactive_policyinfo *, polinfo);
@@ -487,6 +491,21 @@ static unsigned int sl_busy_to_laf(struct cpufreq_interactive_policyinfo *ppol,
 
 #define NEW_TASK_RATIO 75
 #define PRED_TOLERANCE_PCT 10
+/*
+ * Set target_freq straight from the calling context. target_freq_lock keeps
+ * the driver calls for a policy serialized as cpufreq_driver_fast_switch()
+ * requires.
+ */
+static void cpufreq_interactive_fast_switch(
+			struct cpufreq_interactive_policyinfo *ppol)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&ppol->target_freq_lock, flags);
+	cpufreq_driver_fast_switch(ppol->policy, ppol->target_freq);
+	spin_unlock_irqrestore(&ppol->target_freq_lock, flags);
+}
+
 static void cpufreq_interactive_timer(int data)
 {
 	s64 now;
@@ -513,6 +532,8 @@ static void cpufreq_interactive_timer(int data)
 	bool skip_hispeed_logic, skip_min_sample_time;
 	bool jump_to_max_no_ts = false;
 	bool jump_to_max = false;
+	unsigned int t_hintlaf;
+	u64 hint_time;
 
 	if (!down_read_trylock(&ppol->enable_sem))
 		return;
@@ -524,6 +545,9 @@ static void cpufreq_interactive_timer(int data)
 	spin_lock_irqsave(&ppol->target_freq_lock, flags);
 	spin_lock(&ppol->load_lock);
 
+	hint_time = ppol->hint_time;
+	ppol->hint_time = 0;
+
 	skip_hispeed_logic =
 		tunables->ignore_hispeed_on_notif && ppol->notif_pending;
 	skip_min_sample_time = tunables->fast_ramp_down && ppol->notif_pending;
@@ -562,6 +586,15 @@ static void cpufreq_interactive_timer(int data)
 			prev_l = t_prevlaf / ppol->target_freq;
 		}
 
+		/* demand that migrated in after the last sample */
+		if (pcpu->hint_busy && now < pcpu->hint_expires) {
+			t_hintlaf = sl_busy_to_laf(ppol, pcpu->hint_busy);
+			if (t_hintlaf > t_prevlaf) {
+				t_prevlaf = t_hintlaf;
+				prev_l = t_prevlaf / ppol->target_freq;
+			}
+		}
+
 		/* find max of loadadjfreq inside policy */
 		if (t_prevlaf > prev_laf) {
 			prev_laf = t_prevlaf;
@@ -692,6 +725,14 @@ static void cpufreq_interactive_timer(int data)
 
 	ppol->target_freq = new_freq;
 	spin_unlock_irqrestore(&ppol->target_freq_lock, flags);
+
+	if (ppol->policy->fast_switch_enabled) {
+		cpufreq_interactive_fast_switch(ppol);
+		trace_cpufreq_interactive_setspeed(max_cpu, new_freq,
+						   ppol->policy->cur);
+		goto rearm;
+	}
+
 	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
 	cpumask_set_cpu(max_cpu, &speedchange_cpumask);
 	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
@@ -699,6 +740,11 @@ static void cpufreq_interactive_timer(int data)
 	wake_up_process(speedchange_task);
 
 rearm:
+	if (hint_time)
+		trace_cpufreq_interactive_hint(max_cpu,
+				ktime_to_us(ktime_get()) - hint_time,
+				ppol->target_freq);
+
 	cpufreq_interactive_timer_resched(data, false);
 
 	/*
@@ -758,7 +804,9 @@ static int cpufreq_interactive_speedchange_task(void *data)
 				continue;
 			}
 
-			if (ppol->target_freq != ppol->policy->cur)
+			if (ppol->policy->fast_switch_enabled)
+				cpufreq_interactive_fast_switch(ppol);
+			else if (ppol->target_freq != ppol->policy->cur)
 				__cpufreq_driver_target(ppol->policy,
 							ppol->target_freq,
 							CPUFREQ_RELATION_H);
@@ -847,6 +895,67 @@ exit:
 	return 0;
 }
 
+/**
+ * cpufreq_interactive_load_hint - account a task migrating onto a cpu
+ * @src_cpu: cpu the task left
+ * @dst_cpu: cpu the task now runs on
+ * @busy_us: the task's recent demand, busy time per timer_rate window
+ *
+ * Carries the demand of a migrated task to the destination policy and
+ * re-evaluates it right away, instead of waiting one or two samples for
+ * the destination's own load to show it. Only honoured when
+ * use_migration_notif is set. Hints expire after one timer_rate.
+ */
+void cpufreq_interactive_load_hint(int src_cpu, int dst_cpu,
+				   unsigned long busy_us)
+{
+	struct cpufreq_interactive_policyinfo *ppol = per_cpu(polinfo, dst_cpu);
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, dst_cpu);
+	struct cpufreq_interactive_tunables *tunables;
+	unsigned long flags;
+	u64 now;
+
+	if (!ppol || ppol->reject_notification)
+		return;
+
+	if (!down_read_trylock(&ppol->enable_sem))
+		return;
+	if (!ppol->governor_enabled)
+		goto exit;
+
+	tunables = ppol->policy->governor_data;
+	if (!tunables->use_migration_notif)
+		goto exit;
+
+	/* moving within a policy does not change the policy's load */
+	if (cpumask_test_cpu(src_cpu, ppol->policy->cpus))
+		goto exit;
+
+	now = ktime_to_us(ktime_get());
+
+	spin_lock_irqsave(&ppol->load_lock, flags);
+	if (now >= pcpu->hint_expires)
+		pcpu->hint_busy = 0;
+	pcpu->hint_busy = min(pcpu->hint_busy + busy_us,
+			      tunables->timer_rate);
+	pcpu->hint_expires = now + tunables->timer_rate;
+	spin_unlock_irqrestore(&ppol->load_lock, flags);
+
+	spin_lock_irqsave(&ppol->target_freq_lock, flags);
+	ppol->notif_pending = true;
+	ppol->notif_cpu = dst_cpu;
+	if (!ppol->hint_time)
+		ppol->hint_time = now;
+	spin_unlock_irqrestore(&ppol->target_freq_lock, flags);
+
+	if (!hrtimer_is_queued(&ppol->notif_timer))
+		hrtimer_start(&ppol->notif_timer, ns_to_ktime(0),
+			      HRTIMER_MODE_REL);
+exit:
+	up_read(&ppol->enable_sem);
+}
+EXPORT_SYMBOL_GPL(cpufreq_interactive_load_hint);
+
 static enum hrtimer_restart cpufreq_interactive_hrtimer(struct hrtimer *timer)
 {
 	struct cpufreq_interactive_policyinfo *ppol = container_of(timer,
@@ -1826,6 +1935,7 @@ int cpufreq_interactive_start(struct cpufreq_policy *policy)
 	ppol->min_freq = policy->min;
 	ppol->reject_notification = true;
 	ppol->notif_pending = false;
+	cpufreq_enable_fast_switch(policy);
 	down_write(&ppol->enable_sem);
 	del_timer_sync(&ppol->policy_slack_timer);
 	ppol->last_evaluated_jiffy = get_jiffies_64();
@@ -1861,6 +1971,7 @@ void cpufreq_interactive_stop(struct cpufreq_policy *policy)
 	irq_work_sync(&ppol->irq_work);
 	ppol->work_in_progress = false;
 	del_timer_sync(&ppol->policy_slack_timer);
+	cpufreq_disable_fast_switch(policy);
 	up_write(&ppol->enable_sem);
 	ppol->reject_notification = false;
 
@@ -1880,8 +1991,11 @@ void cpufreq_interactive_limits(struct cpufreq_policy *policy)
 	BUG_ON(!tunables);
 	ppol = per_cpu(polinfo, policy->cpu);
 
-	__cpufreq_driver_target(policy,
-			ppol->target_freq, CPUFREQ_RELATION_L);
+	if (policy->fast_switch_enabled)
+		cpufreq_interactive_fast_switch(ppol);
+	else
+		__cpufreq_driver_target(policy,
+				ppol->target_freq, CPUFREQ_RELATION_L);
 
 	down_read(&ppol->enable_sem);
 	if (ppol->governor_enabled) {
@@ -18,6 +18,7 @@
 #include <linux/cputime.h>
 #include <linux/hashtable.h>
 #include <linux/init.h>
+#include <linux/percpu.h>
 #include <linux/proc_fs.h>
 #include <linux/sched.h>
 #include <linux/seq_file.h>
@@ -34,6 +35,14 @@ static  __cacheline_aligned_in_smp DEFINE_SPINLOCK(task_time_in_state_lock);
 /* uid_hash_table */
 static __cacheline_aligned_in_smp DEFINE_SPINLOCK(uid_lock);
 
+/*
+ * Bumped under uid_lock before an entry is retired with call_rcu(). A task
+ * caches the entry it accounted to last together with the generation it
+ * looked it up in, and may use it from the tick without taking uid_lock as
+ * long as the generation is unchanged.
+ */
+static unsigned int uid_gen;
+
 struct concurrent_times {
 	atomic64_t active[NR_CPUS];
 	atomic64_t policy[NR_CPUS];
@@ -45,7 +54,17 @@ struct uid_entry {
 	struct hlist_node hash;
 	struct rcu_head rcu;
 	struct concurrent_times *concurrent_times;
-	u64 time_in_state[0];
+	/* per cpu, summed on read */
+	u64 __percpu *time_in_state;
+};
+
+/*
+ * Binary record of /proc/uid_time_in_state_bin, followed by max_state
+ * times in clock_t in the frequency order of /proc/uid_time_in_state.
+ */
+struct uid_time_in_state_rec {
+	u32 uid;
+	u32 max_state;
 };
 
 /**
@@ -91,47 +110,86 @@ static struct uid_entry *find_uid_entry_locked(uid_t uid)
 	return NULL;
 }
 
+static u64 uid_entry_time(struct uid_entry *uid_entry, unsigned int state)
+{
+	u64 *times, time = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		times = per_cpu_ptr(uid_entry->time_in_state, cpu);
+		time += READ_ONCE(times[state]);
+	}
+
+	return cputime_to_clock_t(time);
+}
+
+static struct uid_entry *alloc_uid_entry(uid_t uid, unsigned int max_state)
+{
+	struct uid_entry *uid_entry;
+
+	uid_entry = kzalloc(sizeof(*uid_entry), GFP_ATOMIC);
+	if (!uid_entry)
+		return NULL;
+	uid_entry->time_in_state = __alloc_percpu_gfp(max_state * sizeof(u64),
+						      sizeof(u64), GFP_ATOMIC);
+	if (!uid_entry->time_in_state) {
+		kfree(uid_entry);
+		return NULL;
+	}
+
+	uid_entry->uid = uid;
+	uid_entry->max_state = max_state;
+
+	return uid_entry;
+}
+
+static void uid_entry_resize_reclaim(struct rcu_head *rcu)
+{
+	struct uid_entry *uid_entry = container_of(rcu, struct uid_entry, rcu);
+
+	free_percpu(uid_entry->time_in_state);
+	kfree(uid_entry);
+}
+
 /* Caller must hold uid lock */
 static struct uid_entry *find_or_register_uid_locked(uid_t uid)
 {
 	struct uid_entry *uid_entry, *temp;
 	struct concurrent_times *times;
 	unsigned int max_state = READ_ONCE(next_offset);
-	size_t alloc_size = sizeof(*uid_entry) + max_state *
-		sizeof(uid_entry->time_in_state[0]);
+	int cpu;
 
 	uid_entry = find_uid_entry_locked(uid);
 	if (uid_entry) {
 		if (uid_entry->max_state == max_state)
 			return uid_entry;
 		/* uid_entry->time_in_state is too small to track all freqs, so
-		 * expand it.
+		 * replace it with a larger one. Ticks accounted to the old
+		 * array by other cpus while it is copied are lost, which is
+		 * acceptable as this only happens when a policy is added.
 		 */
-		temp = __krealloc(uid_entry, alloc_size, GFP_ATOMIC);
+		temp = alloc_uid_entry(uid, max_state);
 		if (!temp)
 			return uid_entry;
-		temp->max_state = max_state;
-		memset(temp->time_in_state + uid_entry->max_state, 0,
-		       (max_state - uid_entry->max_state) *
-		       sizeof(uid_entry->time_in_state[0]));
-		if (temp != uid_entry) {
-			hlist_replace_rcu(&uid_entry->hash, &temp->hash);
-			kfree_rcu(uid_entry, rcu);
-		}
+		temp->concurrent_times = uid_entry->concurrent_times;
+		for_each_possible_cpu(cpu)
+			memcpy(per_cpu_ptr(temp->time_in_state, cpu),
+			       per_cpu_ptr(uid_entry->time_in_state, cpu),
+			       uid_entry->max_state * sizeof(u64));
+		hlist_replace_rcu(&uid_entry->hash, &temp->hash);
+		WRITE_ONCE(uid_gen, uid_gen + 1);
+		call_rcu(&uid_entry->rcu, uid_entry_resize_reclaim);
 		return temp;
 	}
 
-	uid_entry = kzalloc(alloc_size, GFP_ATOMIC);
+	uid_entry = alloc_uid_entry(uid, max_state);
 	if (!uid_entry)
 		return NULL;
 	times = kzalloc(sizeof(*times), GFP_ATOMIC);
 	if (!times) {
-		kfree(uid_entry);
+		uid_entry_resize_reclaim(&uid_entry->rcu);
 		return NULL;
 	}
-
-	uid_entry->uid = uid;
-	uid_entry->max_state = max_state;
 	uid_entry->concurrent_times = times;
 
 	hash_add_rcu(uid_hash_table, &uid_entry->hash, uid);
@@ -139,6 +197,30 @@ static struct uid_entry *find_or_register_uid_locked(uid_t uid)
 	return uid_entry;
 }
 
+/*
+ * Returns the entry of uid for accounting p, from the cache in p when it is
+ * still valid. Caller must hold rcu_read_lock() and be the only one
+ * accounting p.
+ */
+static struct uid_entry *task_uid_entry_rcu(struct task_struct *p, uid_t uid)
+{
+	struct uid_entry *uid_entry = p->time_in_state_uid;
+	unsigned long flags;
+
+	if (uid_entry && p->time_in_state_uid_gen == READ_ONCE(uid_gen) &&
+	    uid_entry->uid == uid &&
+	    uid_entry->max_state == READ_ONCE(next_offset))
+		return uid_entry;
+
+	spin_lock_irqsave(&uid_lock, flags);
+	uid_entry = find_or_register_uid_locked(uid);
+	p->time_in_state_uid = uid_entry;
+	p->time_in_state_uid_gen = uid_gen;
+	spin_unlock_irqrestore(&uid_lock, flags);
+
+	return uid_entry;
+}
+
 static int single_uid_time_in_state_show(struct seq_file *m, void *ptr)
 {
 	struct uid_entry *uid_entry;
@@ -157,7 +239,7 @@ static int single_uid_time_in_state_show(struct seq_file *m, void *ptr)
 	}
 
 	for (i = 0; i < uid_entry->max_state; ++i) {
-		u64 time = cputime_to_clock_t(uid_entry->time_in_state[i]);
+		u64 time = uid_entry_time(uid_entry, i);
 		seq_write(m, &time, sizeof(time));
 	}
 
@@ -217,8 +299,7 @@ static int uid_time_in_state_seq_show(struct seq_file *m, void *v)
 			seq_putc(m, ':');
 		}
 		for (i = 0; i < uid_entry->max_state; ++i) {
-			u64 time =
-				cputime_to_clock_t(uid_entry->time_in_state[i]);
+			u64 time = uid_entry_time(uid_entry, i);
 			seq_put_decimal_ull(m, " ", time);
 		}
 		if (uid_entry->max_state)
@@ -229,6 +310,29 @@ static int uid_time_in_state_seq_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+static int uid_time_in_state_bin_seq_show(struct seq_file *m, void *v)
+{
+	struct uid_time_in_state_rec rec;
+	struct uid_entry *uid_entry;
+	unsigned int i;
+	u64 time;
+
+	rcu_read_lock();
+
+	hlist_for_each_entry_rcu(uid_entry, (struct hlist_head *)v, hash) {
+		rec.uid = uid_entry->uid;
+		rec.max_state = uid_entry->max_state;
+		seq_write(m, &rec, sizeof(rec));
+		for (i = 0; i < uid_entry->max_state; ++i) {
+			time = uid_entry_time(uid_entry, i);
+			seq_write(m, &time, sizeof(time));
+		}
+	}
+
+	rcu_read_unlock();
+	return 0;
+}
+
 static int concurrent_time_seq_show(struct seq_file *m, void *v,
 	atomic64_t *(*get_times)(struct concurrent_times *))
 {
@@ -317,6 +421,7 @@ void cpufreq_task_times_init(struct task_struct *p)
 	p->time_in_state = NULL;
 	spin_unlock_irqrestore(&task_time_in_state_lock, flags);
 	p->max_state = 0;
+	p->time_in_state_uid = NULL;
 }
 
 void cpufreq_task_times_alloc(struct task_struct *p)
@@ -415,25 +520,30 @@ void cpufreq_acct_update_power(struct task_struct *p, cputime_t cputime)
 
 	state = freqs->offset + READ_ONCE(freqs->last_index);
 
-	spin_lock_irqsave(&task_time_in_state_lock, flags);
-	if ((state < p->max_state || !cpufreq_task_times_realloc_locked(p)) &&
-	    p->time_in_state)
+	/*
+	 * Only p's own accounting writes or resizes its array, so the lock is
+	 * needed only to resize it under readers.
+	 */
+	if (state < p->max_state && p->time_in_state) {
 		p->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&task_time_in_state_lock, flags);
-
-	spin_lock_irqsave(&uid_lock, flags);
-	uid_entry = find_or_register_uid_locked(uid);
-	if (uid_entry && state < uid_entry->max_state)
-		uid_entry->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&uid_lock, flags);
+	} else {
+		spin_lock_irqsave(&task_time_in_state_lock, flags);
+		if ((state < p->max_state ||
+		     !cpufreq_task_times_realloc_locked(p)) && p->time_in_state)
+			p->time_in_state[state] += cputime;
+		spin_unlock_irqrestore(&task_time_in_state_lock, flags);
+	}
 
 	rcu_read_lock();
-	uid_entry = find_uid_entry_rcu(uid);
+	uid_entry = task_uid_entry_rcu(p, uid);
 	if (!uid_entry) {
 		rcu_read_unlock();
 		return;
 	}
 
+	if (state < uid_entry->max_state)
+		this_cpu_add(uid_entry->time_in_state[state], cputime);
+
 	for_each_possible_cpu(cpu)
 		if (!idle_cpu(cpu))
 			++active_cpu_cnt;
@@ -518,6 +628,7 @@ static void uid_entry_reclaim(struct rcu_head *rcu)
 	struct uid_entry *uid_entry = container_of(rcu, struct uid_entry, rcu);
 
 	kfree(uid_entry->concurrent_times);
+	free_percpu(uid_entry->time_in_state);
 	kfree(uid_entry);
 }
 
@@ -534,6 +645,7 @@ void cpufreq_task_times_remove_uids(uid_t uid_start, uid_t uid_end)
 			hash, uid_start) {
 			if (uid_start == uid_entry->uid) {
 				hash_del_rcu(&uid_entry->hash);
+				WRITE_ONCE(uid_gen, uid_gen + 1);
 				call_rcu(&uid_entry->rcu, uid_entry_reclaim);
 			}
 		}
@@ -580,6 +692,25 @@ static const struct file_operations uid_time_in_state_fops = {
 	.release	= seq_release,
 };
 
+static const struct seq_operations uid_time_in_state_bin_seq_ops = {
+	.start = uid_seq_start,
+	.next = uid_seq_next,
+	.stop = uid_seq_stop,
+	.show = uid_time_in_state_bin_seq_show,
+};
+
+static int uid_time_in_state_bin_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &uid_time_in_state_bin_seq_ops);
+}
+
+static const struct file_operations uid_time_in_state_bin_fops = {
+	.open		= uid_time_in_state_bin_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
 static const struct seq_operations concurrent_active_time_seq_ops = {
 	.start = uid_seq_start,
 	.next = uid_seq_next,
@@ -623,6 +754,9 @@ static int __init cpufreq_times_init(void)
 	proc_create_data("uid_time_in_state", 0444, NULL,
 			 &uid_time_in_state_fops, NULL);
 
+	proc_create_data("uid_time_in_state_bin", 0444, NULL,
+			 &uid_time_in_state_bin_fops, NULL);
+
 	proc_create_data("uid_concurrent_active_time", 0444, NULL,
 			 &concurrent_active_time_fops, NULL);
 
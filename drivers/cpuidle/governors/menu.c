@@ -16,6 +16,7 @@
 #include <linux/time.h>
 #include <linux/ktime.h>
 #include <linux/hrtimer.h>
+#include <linux/interrupt.h>
 #include <linux/tick.h>
 #include <linux/sched.h>
 #include <linux/sched/loadavg.h>
@@ -275,6 +276,21 @@ again:
 	goto again;
 }
 
+/*
+ * Time until the next periodic device interrupt predicted by the irq
+ * timings, UINT_MAX if none is predicted.
+ */
+static unsigned int next_irq_us(void)
+{
+	u64 now = local_clock();
+	u64 next = irq_timings_next_event(now);
+
+	if (next == U64_MAX)
+		return UINT_MAX;
+
+	return min_t(u64, div_u64(next - now, NSEC_PER_USEC), UINT_MAX);
+}
+
 /**
  * menu_select - selects the next idle state to enter
  * @drv: cpuidle driver containing state data
@@ -315,6 +331,7 @@ static int menu_select(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 
 	expected_interval = get_typical_interval(data);
 	expected_interval = min(expected_interval, data->next_timer_us);
+	expected_interval = min(expected_interval, next_irq_us());
 
 	if (CPUIDLE_DRIVER_STATE_START > 0) {
 		struct cpuidle_state *s = &drv->states[CPUIDLE_DRIVER_STATE_START];
@@ -494,7 +511,13 @@ static struct cpuidle_governor menu_governor = {
  */
 static int __init init_menu(void)
 {
-	return cpuidle_register_governor(&menu_governor);
+	int ret;
+
+	ret = cpuidle_register_governor(&menu_governor);
+	if (!ret)
+		irq_timings_enable();
+
+	return ret;
 }
 
 postcore_initcall(init_menu);
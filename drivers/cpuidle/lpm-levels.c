@@ -24,6 +24,7 @@
 #include <linux/cpu.h>
 #include <linux/of.h>
 #include <linux/hrtimer.h>
+#include <linux/interrupt.h>
 #include <linux/ktime.h>
 #include <linux/tick.h>
 #include <linux/suspend.h>
@@ -35,6 +36,7 @@
 #include <linux/sched.h>
 #include <linux/cpu_pm.h>
 #include <linux/cpuhotplug.h>
+#include <linux/kernel_stat.h>
 #include <soc/qcom/pm.h>
 #include <soc/qcom/event_timer.h>
 #include <soc/qcom/lpm_levels.h>
@@ -95,6 +97,17 @@ module_param_named(lpm_prediction, lpm_prediction, bool, 0664);
 static uint32_t bias_hyst;
 module_param_named(bias_hyst, bias_hyst, uint, 0664);
 
+enum lpm_predictor_type {
+	LPM_PREDICTOR_HISTORY,	/* residency history only */
+	LPM_PREDICTOR_FEATURES,	/* history + next timer, irq rate, bias */
+};
+
+static uint32_t lpm_predictor = LPM_PREDICTOR_HISTORY;
+module_param_named(lpm_predictor, lpm_predictor, uint, 0664);
+
+#define PRED_SCALE_SHIFT 10
+#define PRED_SCALE_ONE (1 << PRED_SCALE_SHIFT)
+
 struct lpm_history {
 	uint32_t resi[MAXSAMPLES];
 	int mode[MAXSAMPLES];
@@ -103,6 +116,15 @@ struct lpm_history {
 	uint32_t hinvalid;
 	uint32_t htmr_wkup;
 	int64_t stime;
+	/* inputs and self-correction of the feature predictor */
+	uint64_t irq_cnt;
+	int64_t irq_stamp;
+	uint32_t irq_gap_us;
+	uint32_t pred_us;
+	uint32_t pred_scale;
+	/* what the last selection expected, for the residency histograms */
+	uint32_t expect_us;
+	uint64_t expect_wake_ns;
 };
 
 static DEFINE_PER_CPU(struct lpm_history, hist);
@@ -447,6 +469,17 @@ static void msm_pm_set_timer(uint32_t modified_time_us)
 	hrtimer_start(&lpm_hrtimer, modified_ktime, HRTIMER_MODE_REL_PINNED);
 }
 
+static inline bool is_cpu_biased(int cpu)
+{
+	u64 now = sched_clock();
+	u64 last = sched_get_cpu_last_busy_time(cpu);
+
+	if (!last)
+		return false;
+
+	return (now - last) < BIAS_HYST;
+}
+
 static uint64_t lpm_cpuidle_predict(struct cpuidle_device *dev,
 		struct lpm_cpu *cpu, int *idx_restrict,
 		uint32_t *idx_restrict_time)
@@ -564,6 +597,141 @@ again:
 	return 0;
 }
 
+static uint64_t lpm_cpu_irq_count(int cpu)
+{
+	uint64_t cnt = kstat_cpu_irqs_sum(cpu);
+
+#ifdef arch_irq_stat_cpu
+	cnt += arch_irq_stat_cpu(cpu);
+#endif
+	return cnt;
+}
+
+/*
+ * Track the average gap between interrupts (device IRQs and IPIs) on this
+ * cpu. An idle period with no interrupt stretches the gap to its length.
+ */
+static void update_irq_gap(struct lpm_history *history, int cpu)
+{
+	int64_t now = ktime_to_us(ktime_get());
+	uint64_t cnt = lpm_cpu_irq_count(cpu);
+	uint64_t delta = cnt - history->irq_cnt;
+	uint64_t gap;
+
+	if (!history->irq_stamp)
+		goto reset;
+
+	gap = now - history->irq_stamp;
+	if (!delta) {
+		if (gap > history->irq_gap_us)
+			history->irq_gap_us = min_t(uint64_t, gap, UINT_MAX);
+		return;
+	}
+
+	gap = div64_u64(gap, delta);
+	if (history->irq_gap_us)
+		gap = (3 * (uint64_t)history->irq_gap_us + gap) >> 2;
+	history->irq_gap_us = min_t(uint64_t, gap, UINT_MAX);
+reset:
+	history->irq_cnt = cnt;
+	history->irq_stamp = now;
+}
+
+/*
+ * Time until the next periodic device interrupt predicted by the irq
+ * timings, U64_MAX if none is predicted.
+ */
+static uint64_t lpm_next_irq_us(void)
+{
+	u64 now = local_clock();
+	u64 next = irq_timings_next_event(now);
+
+	if (next == U64_MAX)
+		return U64_MAX;
+
+	return div_u64(next - now, NSEC_PER_USEC);
+}
+
+/*
+ * Combine the residency history with the next timer distance, the recent
+ * interrupt rate, the next predicted periodic interrupt and the bias
+ * signal, then scale by a per-cpu factor that tracks how actual
+ * residencies compared with earlier predictions.
+ */
+static uint64_t lpm_cpuidle_predict_features(struct cpuidle_device *dev,
+		struct lpm_cpu *cpu, uint32_t next_wakeup_us,
+		int *idx_restrict, uint32_t *idx_restrict_time)
+{
+	struct lpm_history *history = &per_cpu(hist, dev->cpu);
+	uint32_t scale = history->pred_scale ? : PRED_SCALE_ONE;
+	uint64_t predicted, hist_us, irq_us;
+
+	if (!lpm_prediction || !cpu->lpm_prediction)
+		return 0;
+
+	hist_us = lpm_cpuidle_predict(dev, cpu, idx_restrict,
+				idx_restrict_time);
+	if (*idx_restrict_time)
+		return 0;
+
+	predicted = next_wakeup_us;
+	if (hist_us && hist_us < predicted)
+		predicted = hist_us;
+	if (history->irq_gap_us && history->irq_gap_us < predicted)
+		predicted = history->irq_gap_us;
+	irq_us = lpm_next_irq_us();
+	if (irq_us < predicted)
+		predicted = irq_us;
+
+	predicted = (predicted * scale) >> PRED_SCALE_SHIFT;
+	if (is_cpu_biased(dev->cpu))
+		predicted >>= 1;
+
+	if (!predicted || predicted >= next_wakeup_us) {
+		history->stime = 0;
+		return 0;
+	}
+
+	history->pred_us = predicted;
+	history->stime = ktime_to_us(ktime_get()) + predicted;
+	return predicted;
+}
+
+static void update_pred_scale(struct lpm_history *history, uint32_t resi)
+{
+	uint64_t target;
+	uint32_t scale = history->pred_scale ? : PRED_SCALE_ONE;
+
+	target = div64_u64((uint64_t)resi * scale, history->pred_us);
+	target = clamp_t(uint64_t, target, PRED_SCALE_ONE / 4,
+				4 * PRED_SCALE_ONE);
+	history->pred_scale = (7 * scale + target) >> 3;
+	history->pred_us = 0;
+}
+
+static enum lpm_pred_outcome lpm_pred_outcome(struct cpuidle_device *dev,
+		struct lpm_cpu *cpu, int idx)
+{
+	uint32_t *min_residency = get_per_cpu_min_residency(dev->cpu);
+	uint32_t *max_residency = get_per_cpu_max_residency(dev->cpu);
+
+	if (idx && dev->last_residency < min_residency[idx])
+		return LPM_PRED_TOO_DEEP;
+	if (idx < cpu->nlevels - 1 && dev->last_residency > max_residency[idx])
+		return LPM_PRED_TOO_SHALLOW;
+	return LPM_PRED_HIT;
+}
+
+/* Exit latency past the wakeup the selection expected, -1 if it came early */
+static int32_t lpm_exit_latency_us(uint64_t expect_wake_ns, uint64_t end_ns)
+{
+	if (!expect_wake_ns || end_ns < expect_wake_ns)
+		return -1;
+
+	return min_t(uint64_t, div_u64(end_ns - expect_wake_ns,
+				NSEC_PER_USEC), INT_MAX);
+}
+
 static inline void invalidate_predict_history(struct cpuidle_device *dev)
 {
 	struct lpm_history *history = &per_cpu(hist, dev->cpu);
@@ -603,17 +771,6 @@ static void clear_predict_history(void)
 
 static void update_history(struct cpuidle_device *dev, int idx);
 
-static inline bool is_cpu_biased(int cpu)
-{
-	u64 now = sched_clock();
-	u64 last = sched_get_cpu_last_busy_time(cpu);
-
-	if (!last)
-		return false;
-
-	return (now - last) < BIAS_HYST;
-}
-
 static int cpu_power_select(struct cpuidle_device *dev,
 		struct lpm_cpu *cpu)
 {
@@ -630,6 +787,10 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	uint32_t next_wakeup_us = (uint32_t)sleep_us;
 	uint32_t *min_residency = get_per_cpu_min_residency(dev->cpu);
 	uint32_t *max_residency = get_per_cpu_max_residency(dev->cpu);
+	struct lpm_history *history = &per_cpu(hist, dev->cpu);
+
+	history->expect_us = 0;
+	history->expect_wake_ns = 0;
 
 	if (((sleep_disabled || sleep_disabled_touch) && !cpu_isolated(dev->cpu)) || sleep_us < 0)
 		return best_level;
@@ -638,7 +799,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 
 	next_event_us = (uint32_t)(ktime_to_us(get_next_event_time(dev->cpu)));
 
-	if (is_cpu_biased(dev->cpu) && (!cpu_isolated(dev->cpu)))
+	if (lpm_predictor != LPM_PREDICTOR_FEATURES &&
+			is_cpu_biased(dev->cpu) && (!cpu_isolated(dev->cpu)))
 		goto done_select;
 
 	for (i = 0; i < cpu->nlevels; i++) {
@@ -672,8 +834,15 @@ static int cpu_power_select(struct cpuidle_device *dev,
 			 * call prediction.
 			 */
 			if (next_wakeup_us > max_residency[i]) {
-				predicted = lpm_cpuidle_predict(dev, cpu,
-					&idx_restrict, &idx_restrict_time);
+				if (lpm_predictor == LPM_PREDICTOR_FEATURES)
+					predicted =
+					lpm_cpuidle_predict_features(dev, cpu,
+						next_wakeup_us, &idx_restrict,
+						&idx_restrict_time);
+				else
+					predicted = lpm_cpuidle_predict(dev,
+						cpu, &idx_restrict,
+						&idx_restrict_time);
 				if (predicted && (predicted < min_residency[i]))
 					predicted = min_residency[i];
 			} else
@@ -717,6 +886,10 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	}
 
 done_select:
+	history->expect_us = predicted ? predicted : next_wakeup_us;
+	history->expect_wake_ns = ktime_to_ns(ktime_get()) +
+					sleep_us * NSEC_PER_USEC;
+
 	trace_cpu_power_select(best_level, sleep_us, latency_us, next_event_us);
 
 	trace_cpu_pred_select(idx_restrict_time ? 2 : (predicted ? 1 : 0),
@@ -973,6 +1146,13 @@ static int cluster_select(struct lpm_cluster *cluster, bool from_idle,
 
 		if (predicted && (pred_us == cpupred_us))
 			predicted = 2;
+
+		cluster->expect_us = predicted ? pred_us : sleep_us;
+		cluster->expect_wake_ns = ktime_to_ns(ktime_get()) +
+					(uint64_t)sleep_us * NSEC_PER_USEC;
+	} else {
+		cluster->expect_us = 0;
+		cluster->expect_wake_ns = 0;
 	}
 
 	if (cpumask_and(&mask, cpu_online_mask, &cluster->child_cpus))
@@ -1214,6 +1394,12 @@ static void cluster_unprepare(struct lpm_cluster *cluster,
 		cluster->stats->sleep_time = end_time -
 			cluster->stats->sleep_time;
 	lpm_stats_cluster_exit(cluster->stats, cluster->last_level, success);
+	if (from_idle && success && cluster->stats->sleep_time > 0)
+		lpm_stats_cluster_residency(cluster->stats,
+			cluster->last_level, cluster->expect_us,
+			div_u64(cluster->stats->sleep_time, NSEC_PER_USEC),
+			lpm_exit_latency_us(cluster->expect_wake_ns,
+						end_time));
 
 	level = &cluster->levels[cluster->last_level];
 
@@ -1385,6 +1571,13 @@ static void update_history(struct cpuidle_device *dev, int idx)
 	if (!lpm_prediction || !lpm_cpu->lpm_prediction)
 		return;
 
+	if (lpm_predictor == LPM_PREDICTOR_FEATURES) {
+		update_irq_gap(history, dev->cpu);
+		if (history->pred_us && !history->htmr_wkup)
+			update_pred_scale(history, dev->last_residency);
+		history->pred_us = 0;
+	}
+
 	if (history->htmr_wkup) {
 		if (!history->hptr)
 			history->hptr = MAXSAMPLES-1;
@@ -1437,6 +1630,14 @@ exit:
 	cluster_unprepare(cpu->parent, cpumask, idx, true, end_time, success);
 	cpu_unprepare(cpu, idx, true);
 	dev->last_residency = ktime_us_delta(ktime_get(), start);
+	if (success) {
+		struct lpm_history *history = &per_cpu(hist, dev->cpu);
+
+		lpm_stats_cpu_predict(idx, lpm_pred_outcome(dev, cpu, idx));
+		lpm_stats_cpu_residency(idx, history->expect_us,
+			dev->last_residency,
+			lpm_exit_latency_us(history->expect_wake_ns, end_time));
+	}
 	update_history(dev, idx);
 	trace_cpu_idle_exit(idx, success);
 	if (lpm_prediction && cpu->lpm_prediction) {
@@ -1784,6 +1985,8 @@ static int lpm_probe(struct platform_device *pdev)
 		goto failed;
 	}
 
+	irq_timings_enable();
+
 	/* Add lpm_debug to Minidump*/
 	strlcpy(md_entry.name, "KLPMDEBUG", sizeof(md_entry.name));
 	md_entry.virt_addr = (uintptr_t)lpm_debug;
@@ -121,6 +121,8 @@ struct lpm_cluster {
 	unsigned int psci_mode_mask;
 	struct cluster_history history;
 	struct hrtimer histtimer;
+	uint32_t expect_us;
+	uint64_t expect_wake_ns;
 };
 
 struct lpm_cluster *lpm_of_parse_cluster(struct platform_device *pdev);
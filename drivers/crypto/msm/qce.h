@@ -194,5 +194,7 @@ int qce_enable_clk(void *handle);
 int qce_disable_clk(void *handle);
 void qce_get_driver_stats(void *handle);
 void qce_clear_driver_stats(void *handle);
+void qce_set_chain(void *handle, bool more);
+void qce_chain_flush(void *handle);
 
 #endif /* __CRYPTO_MSM_QCE_H */
@@ -160,6 +160,8 @@ struct qce_device {
 	atomic_t bunch_cmd_seq;
 	atomic_t last_intr_seq;
 	bool cadence_flag;
+	bool chain_more;	/* client has more requests to issue */
+	bool chain_pending;	/* a queued request is waiting for an irq */
 	uint8_t *dummyreq_in_buf;
 	struct dma_iommu_mapping *smmu_mapping;
 	bool enable_s1_smmu;
@@ -3112,6 +3114,8 @@ void qce_get_driver_stats(void *handle)
 			pce_dev->qce_stats.no_of_timeouts);
 	pr_info("Engine %d dummy request inserted %d\n", pce_dev->dev_no,
 			pce_dev->qce_stats.no_of_dummy_reqs);
+	pr_info("Engine %d chained request %d\n", pce_dev->dev_no,
+			pce_dev->qce_stats.no_of_chained_reqs);
 	if (pce_dev->mode)
 		pr_info("Engine %d is in BUNCH MODE\n", pce_dev->dev_no);
 	else
@@ -3127,9 +3131,70 @@ void qce_clear_driver_stats(void *handle)
 
 	pce_dev->qce_stats.no_of_timeouts = 0;
 	pce_dev->qce_stats.no_of_dummy_reqs = 0;
+	pce_dev->qce_stats.no_of_chained_reqs = 0;
 }
 EXPORT_SYMBOL(qce_clear_driver_stats);
 
+/**
+ * Announce whether more requests follow the next one
+ *
+ * A client that has several requests ready can issue them back to back
+ * as a chain: every request but the last is queued to the BAM pipes
+ * without the interrupt flag, and the completion interrupt of the last
+ * one completes the whole chain, as the pipes process descriptors in
+ * order. A chain that ends without a last request, because it failed to
+ * be issued, must be closed with qce_chain_flush().
+ *
+ * Engines without bunch mode support interrupt for every request and
+ * ignore @more.
+ *
+ * @handle - qce handle
+ * @more - true if another request is issued right after the next one
+ */
+void qce_set_chain(void *handle, bool more)
+{
+	struct qce_device *pce_dev = (struct qce_device *) handle;
+
+	pce_dev->chain_more = more && pce_dev->no_get_around;
+}
+EXPORT_SYMBOL(qce_set_chain);
+
+/**
+ * Close a chain whose last request was not issued
+ *
+ * A dummy request with the interrupt flag is queued behind the chain. If
+ * the dummy request is still in use, the engine falls back to bunch mode
+ * and the multi request timer inserts it once it is free.
+ *
+ * @handle - qce handle
+ */
+void qce_chain_flush(void *handle)
+{
+	struct qce_device *pce_dev = (struct qce_device *) handle;
+	unsigned long flags;
+
+	pce_dev->chain_more = false;
+	if (!pce_dev->chain_pending)
+		return;
+
+	/* as in qce_multireq_timeout(), a completion must not preempt us */
+	local_irq_save(flags);
+	while (cmpxchg(&pce_dev->owner, QCE_OWNER_NONE, QCE_OWNER_CLIENT)
+							!= QCE_OWNER_NONE)
+		ndelay(40);
+
+	pce_dev->chain_pending = false;
+	if (qce_dummy_req(pce_dev)) {
+		pce_dev->mode = IN_BUNCH_MODE;
+		atomic_set(&pce_dev->bunch_cmd_seq, 1);
+		atomic_set(&pce_dev->last_intr_seq, 0);
+		mod_timer(&(pce_dev->timer), (jiffies + DELAY_IN_JIFFIES));
+	}
+	cmpxchg(&pce_dev->owner, QCE_OWNER_CLIENT, QCE_OWNER_NONE);
+	local_irq_restore(flags);
+}
+EXPORT_SYMBOL(qce_chain_flush);
+
 static void _sps_producer_callback(struct sps_event_notify *notify)
 {
 	struct qce_device *pce_dev = (struct qce_device *)
@@ -4665,6 +4730,16 @@ again:
 		goto again;
 	}
 	no_of_queued_req = atomic_inc_return(&pce_dev->no_of_queued_req);
+	if (pce_dev->chain_more) {
+		/* the last request of the chain interrupts for this one */
+		pce_dev->chain_pending = true;
+		pce_dev->qce_stats.no_of_chained_reqs++;
+		if (pce_dev->mode == IN_BUNCH_MODE)
+			atomic_inc(&pce_dev->bunch_cmd_seq);
+		return 0;
+	}
+	pce_dev->chain_pending = false;
+
 	if (pce_dev->mode == IN_INTERRUPT_MODE) {
 		if (no_of_queued_req >= MAX_BUNCH_MODE_REQ) {
 			pce_dev->mode = IN_BUNCH_MODE;
@@ -238,6 +238,7 @@ struct ce_request_info {
 struct qce_driver_stats {
 	int no_of_timeouts;
 	int no_of_dummy_reqs;
+	int no_of_chained_reqs;
 	int current_mode;
 	int outstanding_reqs;
 };
@@ -2251,6 +2251,7 @@ static int _start_qcrypto_process(struct crypto_priv *cp,
 	struct qcrypto_resp_ctx *arsp;
 	struct qcrypto_req_control *pqcrypto_req_control;
 	unsigned int cpu = MAX_SMP_CPU;
+	bool chain, chained = false;
 
 	if (READ_ONCE(cp->ce_req_proc_sts) == STOPPED)
 		return 0;
@@ -2266,10 +2267,11 @@ static int _start_qcrypto_process(struct crypto_priv *cp,
 
 again:
 	spin_lock_irqsave(&cp->lock, flags);
-	if (pengine->issue_req ||
+	/* a pending chain keeps issue_req set until it is closed */
+	if ((pengine->issue_req && !chained) ||
 		atomic_read(&pengine->req_count) >= (pengine->max_req)) {
 		spin_unlock_irqrestore(&cp->lock, flags);
-		return 0;
+		goto out;
 	}
 
 	backlog_eng = crypto_get_backlog(&pengine->req_queue);
@@ -2277,7 +2279,7 @@ again:
 	/* make sure it is in high bandwidth state */
 	if (pengine->bw_state != BUS_HAS_BANDWIDTH) {
 		spin_unlock_irqrestore(&cp->lock, flags);
-		return 0;
+		goto out;
 	}
 
 	/* try to get request from request queue of the engine first */
@@ -2291,16 +2293,23 @@ again:
 		async_req = crypto_dequeue_request(&cp->req_queue);
 		if (!async_req) {
 			spin_unlock_irqrestore(&cp->lock, flags);
-			return 0;
+			goto out;
 		}
 	}
 	pqcrypto_req_control = qcrypto_alloc_req_control(pengine);
 	if (pqcrypto_req_control == NULL) {
 		pr_err("Allocation of request failed\n");
 		spin_unlock_irqrestore(&cp->lock, flags);
-		return 0;
+		goto out;
 	}
 
+	/*
+	 * If the engine can take the next queued request as well, issue
+	 * both back to back and have only the last one interrupt.
+	 */
+	chain = atomic_read(&pengine->req_count) < pengine->max_req &&
+		(pengine->req_queue.qlen || cp->req_queue.qlen);
+
 	/* add associated rsp entry to tfm response queue */
 	type = crypto_tfm_alg_type(async_req->tfm);
 	tfm_ctx = crypto_tfm_ctx(async_req->tfm);
@@ -2355,6 +2364,7 @@ again:
 		backlog_eng->complete(backlog_eng, -EINPROGRESS);
 	if (backlog_cp)
 		backlog_cp->complete(backlog_cp, -EINPROGRESS);
+	qce_set_chain(pengine->qce, chain);
 	switch (type) {
 	case CRYPTO_ALG_TYPE_ABLKCIPHER:
 		ret = _qcrypto_process_ablkcipher(pengine,
@@ -2370,8 +2380,12 @@ again:
 		ret = -EINVAL;
 	};
 
-	pengine->issue_req = false;
-	smp_mb(); /* make it visible */
+	if (!ret)
+		chained = chain;
+	if (!chained) {
+		pengine->issue_req = false;
+		smp_mb(); /* make it visible */
+	}
 
 	pengine->total_req++;
 	if (ret) {
@@ -2389,7 +2403,17 @@ again:
 		_qcrypto_tfm_complete(pengine, type, tfm_ctx, arsp, ret);
 		goto again;
 	};
-	return ret;
+	if (chained)
+		goto again;
+	return 0;
+
+out:
+	if (chained) {
+		qce_chain_flush(pengine->qce);
+		pengine->issue_req = false;
+		smp_mb(); /* make it visible */
+	}
+	return 0;
 }
 
 static inline struct crypto_engine *_next_eng(struct crypto_priv *cp,
@@ -2408,24 +2432,29 @@ static struct crypto_engine *_avail_eng(struct crypto_priv *cp)
 	/* call this function with spinlock set */
 	struct crypto_engine *q = NULL;
 	struct crypto_engine *p = cp->scheduled_eng;
-	struct crypto_engine *q1;
 	int eng_cnt = cp->total_units;
+	unsigned int load, min_load = UINT_MAX;
 
 	if (unlikely(list_empty(&cp->engine_list))) {
 		pr_err("%s: no valid ce to schedule\n", __func__);
 		return NULL;
 	}
 
+	/*
+	 * Take the engine with the fewest outstanding requests. The search
+	 * starts after the engine scheduled last, so that equally loaded
+	 * engines take turns.
+	 */
 	p = _next_eng(cp, p);
-	q1 = p;
 	while (eng_cnt-- > 0) {
-		if (!p->issue_req && atomic_read(&p->req_count) < p->max_req) {
+		load = atomic_read(&p->req_count);
+		if (!p->issue_req && load < p->max_req && load < min_load) {
 			q = p;
-			break;
+			min_load = load;
+			if (!load)
+				break;
 		}
 		p = _next_eng(cp, p);
-		if (q1 == p)
-			break;
 	}
 	cp->scheduled_eng = q;
 	return q;
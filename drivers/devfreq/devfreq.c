@@ -316,6 +316,19 @@ int update_devfreq(struct devfreq *devfreq)
 }
 EXPORT_SYMBOL(update_devfreq);
 
+/*
+ * All devices poll on one jiffies timeline: the next poll is due at the next
+ * multiple of the polling interval rather than one interval from now. Devices
+ * using the same or multiple intervals then expire in the same tick, and the
+ * deferrable timers wake the system once for all of them.
+ */
+static unsigned long devfreq_poll_delay(struct devfreq *devfreq)
+{
+	unsigned long period = msecs_to_jiffies(devfreq->profile->polling_ms);
+
+	return period - jiffies % period;
+}
+
 /**
  * devfreq_monitor() - Periodically poll devfreq objects.
  * @work:	the work struct used to run devfreq_monitor periodically.
@@ -328,12 +341,14 @@ static void devfreq_monitor(struct work_struct *work)
 					struct devfreq, work.work);
 
 	mutex_lock(&devfreq->lock);
+	devfreq->poll_parked = false;
 	err = update_devfreq(devfreq);
 	if (err)
 		dev_err(&devfreq->dev, "dvfs failed with (%d) error\n", err);
 
-	queue_delayed_work(devfreq_wq, &devfreq->work,
-				msecs_to_jiffies(devfreq->profile->polling_ms));
+	if (!devfreq->poll_parked)
+		queue_delayed_work(devfreq_wq, &devfreq->work,
+				   devfreq_poll_delay(devfreq));
 	mutex_unlock(&devfreq->lock);
 }
 
@@ -349,9 +364,10 @@ static void devfreq_monitor(struct work_struct *work)
 void devfreq_monitor_start(struct devfreq *devfreq)
 {
 	INIT_DEFERRABLE_WORK(&devfreq->work, devfreq_monitor);
+	devfreq->poll_parked = false;
 	if (devfreq->profile->polling_ms)
 		queue_delayed_work(devfreq_wq, &devfreq->work,
-			msecs_to_jiffies(devfreq->profile->polling_ms));
+			devfreq_poll_delay(devfreq));
 }
 EXPORT_SYMBOL(devfreq_monitor_start);
 
@@ -415,7 +431,7 @@ void devfreq_monitor_resume(struct devfreq *devfreq)
 	if (!delayed_work_pending(&devfreq->work) &&
 			devfreq->profile->polling_ms)
 		queue_delayed_work(devfreq_wq, &devfreq->work,
-			msecs_to_jiffies(devfreq->profile->polling_ms));
+			devfreq_poll_delay(devfreq));
 
 	devfreq->last_stat_updated = jiffies;
 	devfreq->stop_polling = false;
@@ -458,7 +474,7 @@ void devfreq_interval_update(struct devfreq *devfreq, unsigned int *delay)
 	/* if current delay is zero, start polling with new delay */
 	if (!cur_delay) {
 		queue_delayed_work(devfreq_wq, &devfreq->work,
-			msecs_to_jiffies(devfreq->profile->polling_ms));
+			devfreq_poll_delay(devfreq));
 		goto out;
 	}
 
@@ -469,13 +485,31 @@ void devfreq_interval_update(struct devfreq *devfreq, unsigned int *delay)
 		mutex_lock(&devfreq->lock);
 		if (!devfreq->stop_polling)
 			queue_delayed_work(devfreq_wq, &devfreq->work,
-			      msecs_to_jiffies(devfreq->profile->polling_ms));
+			      devfreq_poll_delay(devfreq));
 	}
 out:
 	mutex_unlock(&devfreq->lock);
 }
 EXPORT_SYMBOL(devfreq_interval_update);
 
+/**
+ * devfreq_monitor_park() - Skip polling until the governor is woken up
+ * @devfreq:    the devfreq instance.
+ *
+ * Helper function for governors whose hardware monitor interrupts on new
+ * activity. Called from ->get_target_freq() while the device is idle, it
+ * stops the poll from being requeued. Polling restarts with the next
+ * devfreq_monitor_start(), typically from the interrupt handling path.
+ * The caller must hold devfreq->lock.
+ */
+void devfreq_monitor_park(struct devfreq *devfreq)
+{
+	lockdep_assert_held(&devfreq->lock);
+
+	devfreq->poll_parked = true;
+}
+EXPORT_SYMBOL(devfreq_monitor_park);
+
 /**
  * devfreq_notifier_call() - Notify that the device frequency requirements
  *			   has been changed out of devfreq framework.
@@ -37,6 +37,31 @@ TRACE_EVENT(devfreq_msg,
 	)
 );
 
+TRACE_EVENT(adreno_tz_frame,
+	TP_PROTO(unsigned long freq, unsigned long next_freq, u64 busy_us,
+		 s64 budget_us, s64 slack_us),
+	TP_ARGS(freq, next_freq, busy_us, budget_us, slack_us),
+	TP_STRUCT__entry(
+		__field(unsigned long, freq)
+		__field(unsigned long, next_freq)
+		__field(u64, busy_us)
+		__field(s64, budget_us)
+		__field(s64, slack_us)
+	),
+	TP_fast_assign(
+		__entry->freq = freq;
+		__entry->next_freq = next_freq;
+		__entry->busy_us = busy_us;
+		__entry->budget_us = budget_us;
+		__entry->slack_us = slack_us;
+	),
+	TP_printk(
+		"freq=%lu next_freq=%lu busy_us=%llu budget_us=%lld slack_us=%lld",
+		__entry->freq, __entry->next_freq, __entry->busy_us,
+		__entry->budget_us, __entry->slack_us
+	)
+);
+
 #endif /* _DEVFREQ_TRACE_H */
 
 /* This part must be outside protection */
@@ -29,6 +29,8 @@
 #include <linux/platform_device.h>
 #include <linux/of.h>
 #include <linux/devfreq.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <trace/events/power.h>
 #include "governor.h"
 #include "governor_bw_hwmon.h"
@@ -49,6 +51,9 @@ struct hwmon_node {
 	unsigned int hyst_length;
 	unsigned int idle_mbps;
 	unsigned int mbps_zones[NUM_MBPS_ZONES];
+	unsigned int burst_mbps;
+	unsigned int burst_tol_pct;
+	unsigned int burst_lead_ms;
 
 	unsigned long prev_ab;
 	unsigned long *dev_ab;
@@ -67,6 +72,21 @@ struct hwmon_node {
 	unsigned int down_cnt;
 	ktime_t prev_ts;
 	ktime_t hist_max_ts;
+
+	/* Periodic burst predictor state, protected by irq_lock */
+	bool in_burst;
+	bool burst_prevoted;
+	unsigned int burst_conf;
+	unsigned long burst_period_us;
+	unsigned long burst_peak_mbps;
+	unsigned long burst_cur_peak;
+	ktime_t burst_last_ts;
+	ktime_t burst_pred_ts;
+	unsigned long burst_cnt;
+	unsigned long burst_hits;
+	unsigned long burst_misses;
+	unsigned long burst_unpredicted;
+
 	bool sampled;
 	bool mon_started;
 	struct list_head list;
@@ -87,6 +107,8 @@ static DEFINE_MUTEX(list_lock);
 static int use_cnt;
 static DEFINE_MUTEX(state_lock);
 
+static struct dentry *bw_hwmon_debugfs_root;
+
 #define show_attr(name) \
 static ssize_t show_##name(struct device *dev,				\
 			struct device_attribute *attr, char *buf)	\
@@ -305,13 +327,121 @@ unsigned long to_mbps_zone(struct hwmon_node *node, unsigned long mbps)
 	return node->hw->df->max_freq;
 }
 
+/*
+ * Periods shorter than this are not treated as a cadence: they are more
+ * likely to be sub-bursts of the same frame than distinct bursts.
+ */
+#define BURST_MIN_PERIOD_US	5000UL
+#define BURST_MAX_PERIOD_US	(MAX_MS * USEC_PER_MSEC)
+#define BURST_CONF_MIN		3
+#define BURST_CONF_MAX		16
+
+static unsigned long burst_tol_us(struct hwmon_node *node)
+{
+	return max((node->burst_period_us * node->burst_tol_pct) / 100,
+			USEC_PER_MSEC);
+}
+
+/*
+ * Learn the inter-burst period of periodic clients (display refresh,
+ * camera frames) from the rising edges of the measured bandwidth. Once
+ * the same period has been seen BURST_CONF_MIN times in a row, the start
+ * of the next burst is predicted and accounted for when it arrives, or
+ * fails to arrive, within the jitter tolerance.
+ */
+static void burst_track(struct hwmon_node *node, unsigned long meas_mbps,
+			ktime_t now)
+{
+	unsigned long period, tol;
+
+	if (!node->burst_mbps)
+		return;
+
+	tol = burst_tol_us(node);
+
+	if (node->burst_prevoted &&
+	    ktime_after(now, ktime_add_us(node->burst_pred_ts, tol))) {
+		/* Voted ahead of a burst that never came; stop predicting */
+		node->burst_misses++;
+		node->burst_prevoted = false;
+		node->burst_conf = 0;
+	}
+
+	if (meas_mbps < node->burst_mbps) {
+		if (node->in_burst) {
+			node->in_burst = false;
+			node->burst_peak_mbps = node->burst_cur_peak;
+		}
+		return;
+	}
+
+	if (node->in_burst) {
+		node->burst_cur_peak = max(node->burst_cur_peak, meas_mbps);
+		return;
+	}
+
+	node->in_burst = true;
+	node->burst_cur_peak = meas_mbps;
+	node->burst_cnt++;
+
+	if (node->burst_prevoted)
+		node->burst_hits++;
+	else if (node->burst_conf >= BURST_CONF_MIN)
+		node->burst_unpredicted++;
+	node->burst_prevoted = false;
+
+	period = ktime_us_delta(now, node->burst_last_ts);
+	node->burst_last_ts = now;
+
+	if (period < BURST_MIN_PERIOD_US || period > BURST_MAX_PERIOD_US) {
+		node->burst_conf = 0;
+		return;
+	}
+
+	if (node->burst_period_us &&
+	    abs((long)(period - node->burst_period_us)) <= (long)tol) {
+		node->burst_period_us = (node->burst_period_us * 3 + period) / 4;
+		if (node->burst_conf < BURST_CONF_MAX)
+			node->burst_conf++;
+	} else {
+		node->burst_period_us = period;
+		node->burst_conf = 0;
+	}
+
+	node->burst_pred_ts = ktime_add_us(now, node->burst_period_us);
+}
+
+/*
+ * Returns the bandwidth to vote ahead of time if the next predicted burst
+ * is expected to start before the governor gets to make another decision.
+ */
+static unsigned long burst_prevote(struct hwmon_node *node, ktime_t now)
+{
+	unsigned long window_us;
+	s64 until_us;
+
+	if (!node->burst_mbps || node->in_burst ||
+	    node->burst_conf < BURST_CONF_MIN)
+		return 0;
+
+	window_us = (node->hw->df->profile->polling_ms + node->burst_lead_ms)
+			* USEC_PER_MSEC;
+	until_us = ktime_us_delta(node->burst_pred_ts, now);
+	if (until_us > (s64)window_us ||
+	    until_us < -(s64)burst_tol_us(node))
+		return 0;
+
+	node->burst_prevoted = true;
+	return node->burst_peak_mbps;
+}
+
 #define MIN_MBPS	500UL
 #define HIST_PEAK_TOL	60
 static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 					unsigned long *freq, unsigned long *ab)
 {
 	unsigned long meas_mbps, thres, flags, req_mbps, adj_mbps;
-	unsigned long meas_mbps_zone;
+	unsigned long meas_mbps_zone, prevote_mbps;
 	unsigned long hist_lo_tol, hyst_lo_tol;
 	struct bw_hwmon *hw = node->hw;
 	unsigned int new_bw, io_percent = node->io_percent;
@@ -320,10 +450,8 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 
 	spin_lock_irqsave(&irq_lock, flags);
 
-	if (!hw->set_hw_events) {
-		ts = ktime_get();
-		ms = ktime_to_ms(ktime_sub(ts, node->prev_ts));
-	}
+	if (!hw->set_hw_events)
+		ms = ktime_to_ms(ktime_sub(ktime_get(), node->prev_ts));
 	if (!node->sampled || ms >= node->sample_ms)
 		__bw_hwmon_sample_end(node->hw);
 	node->sampled = false;
@@ -331,6 +459,10 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 	req_mbps = meas_mbps = node->max_mbps;
 	node->max_mbps = 0;
 
+	ts = ktime_get();
+	burst_track(node, meas_mbps, ts);
+	prevote_mbps = burst_prevote(node, ts);
+
 	hist_lo_tol = (node->hist_max_mbps * HIST_PEAK_TOL) / 100;
 	/* Remember historic peak in the past hist_mem decision windows. */
 	if (meas_mbps > node->hist_max_mbps || !node->hist_mem) {
@@ -456,7 +588,11 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 
 	spin_unlock_irqrestore(&irq_lock, flags);
 
-	adj_mbps = req_mbps + node->guard_band_mbps;
+	/*
+	 * The pre-vote only raises the vote. IRQ thresholds stay based on
+	 * req_mbps so that the start of the burst is still caught promptly.
+	 */
+	adj_mbps = max(req_mbps, prevote_mbps) + node->guard_band_mbps;
 
 	if (adj_mbps > node->prev_ab) {
 		new_bw = adj_mbps;
@@ -466,6 +602,15 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 		new_bw /= 100;
 	}
 
+	/*
+	 * With no traffic, no pending hysteresis or pre-vote and the decay
+	 * done, a poll can only repeat this vote. The up wake interrupt
+	 * reports new traffic, so stop polling until it fires.
+	 */
+	if (meas_mbps < MIN_MBPS && !prevote_mbps && !node->hyst_en &&
+	    new_bw == node->prev_ab)
+		devfreq_monitor_park(hw->df);
+
 	node->prev_ab = new_bw;
 	if (ab)
 		*ab = roundup(new_bw, node->bw_step);
@@ -552,6 +697,10 @@ static int start_monitor(struct devfreq *df, bool init)
 		hw->up_wake_mbps = mbps;
 		hw->down_wake_mbps = MIN_MBPS;
 		hw->undo_over_req_mbps = 0;
+		node->in_burst = false;
+		node->burst_prevoted = false;
+		node->burst_conf = 0;
+		node->burst_period_us = 0;
 		ret = hw->start_hwmon(hw, mbps);
 	} else {
 		ret = hw->resume_hwmon(hw);
@@ -778,6 +927,9 @@ gov_attr(hyst_trigger_count, 0U, 90U);
 gov_attr(hyst_length, 0U, 90U);
 gov_attr(idle_mbps, 0U, 2000U);
 gov_list_attr(mbps_zones, NUM_MBPS_ZONES, 0U, UINT_MAX);
+gov_attr(burst_mbps, 0U, UINT_MAX);
+gov_attr(burst_tol_pct, 1U, 50U);
+gov_attr(burst_lead_ms, 0U, 50U);
 
 static struct attribute *dev_attr[] = {
 	&dev_attr_guard_band_mbps.attr,
@@ -794,6 +946,9 @@ static struct attribute *dev_attr[] = {
 	&dev_attr_hyst_length.attr,
 	&dev_attr_idle_mbps.attr,
 	&dev_attr_mbps_zones.attr,
+	&dev_attr_burst_mbps.attr,
+	&dev_attr_burst_tol_pct.attr,
+	&dev_attr_burst_lead_ms.attr,
 	&dev_attr_throttle_adj.attr,
 	NULL,
 };
@@ -887,6 +1042,49 @@ out:
 	return ret;
 }
 
+static int burst_stats_show(struct seq_file *s, void *unused)
+{
+	struct hwmon_node *node = s->private;
+	unsigned long flags, predicted, hits, misses, unpredicted;
+	unsigned long period, peak, cnt;
+	unsigned int conf;
+
+	spin_lock_irqsave(&irq_lock, flags);
+	period = node->burst_period_us;
+	peak = node->burst_peak_mbps;
+	conf = node->burst_conf;
+	cnt = node->burst_cnt;
+	hits = node->burst_hits;
+	misses = node->burst_misses;
+	unpredicted = node->burst_unpredicted;
+	spin_unlock_irqrestore(&irq_lock, flags);
+
+	predicted = hits + misses;
+	seq_printf(s, "period_us: %lu\n", period);
+	seq_printf(s, "confidence: %u\n", conf);
+	seq_printf(s, "peak_mbps: %lu\n", peak);
+	seq_printf(s, "bursts: %lu\n", cnt);
+	seq_printf(s, "hits: %lu\n", hits);
+	seq_printf(s, "misses: %lu\n", misses);
+	seq_printf(s, "unpredicted: %lu\n", unpredicted);
+	seq_printf(s, "accuracy_pct: %lu\n",
+			predicted ? (hits * 100) / predicted : 0);
+
+	return 0;
+}
+
+static int burst_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, burst_stats_show, inode->i_private);
+}
+
+static const struct file_operations burst_stats_fops = {
+	.open = burst_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static struct devfreq_governor devfreq_gov_bw_hwmon = {
 	.name = "bw_hwmon",
 	.get_target_freq = devfreq_bw_hwmon_get_freq,
@@ -937,12 +1135,20 @@ int register_bw_hwmon(struct device *dev, struct bw_hwmon *hwmon)
 	node->hyst_length = 0;
 	node->idle_mbps = 400;
 	node->mbps_zones[0] = 0;
+	node->burst_mbps = 0;
+	node->burst_tol_pct = 10;
+	node->burst_lead_ms = 2;
 	node->hw = hwmon;
 
 	mutex_init(&node->mon_lock);
 
 	mutex_lock(&list_lock);
 	list_add_tail(&node->list, &hwmon_list);
+	if (!bw_hwmon_debugfs_root)
+		bw_hwmon_debugfs_root = debugfs_create_dir("bw_hwmon", NULL);
+	if (!IS_ERR_OR_NULL(bw_hwmon_debugfs_root))
+		debugfs_create_file(dev_name(dev), 0444, bw_hwmon_debugfs_root,
+					node, &burst_stats_fops);
 	mutex_unlock(&list_lock);
 
 	if (hwmon->gov) {
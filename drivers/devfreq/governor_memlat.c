@@ -28,6 +28,7 @@
 #include <linux/platform_device.h>
 #include <linux/of.h>
 #include <linux/devfreq.h>
+#include <linux/soc/qcom/llcc-qcom.h>
 #include "governor.h"
 #include "governor_memlat.h"
 
@@ -36,8 +37,15 @@
 struct memlat_node {
 	unsigned int ratio_ceil;
 	unsigned int stall_floor;
+	unsigned int llcc_miss_ceil;
+	unsigned int llcc_scale_floor;
 	bool mon_started;
 	bool already_zero;
+	bool llcc_events;
+	u32 llcc_access_ev[2];
+	u32 llcc_miss_ev[2];
+	u64 llcc_prev_access;
+	u64 llcc_prev_miss;
 	struct list_head list;
 	void *orig_data;
 	struct memlat_hwmon *hw;
@@ -224,6 +232,53 @@ static void gov_stop(struct devfreq *df)
 	hw->df = NULL;
 }
 
+/*
+ * Return the LLCC miss ratio, in percent, seen since the previous sample.
+ * 100 means nothing is known and the memlat vote should stand as is.
+ */
+static unsigned int llcc_miss_pct(struct memlat_node *node)
+{
+	u64 access, miss, d_access, d_miss;
+
+	if (!node->llcc_events || !node->llcc_miss_ceil)
+		return 100;
+
+	if (llcc_perfmon_event_count(node->llcc_access_ev[0],
+				     node->llcc_access_ev[1], &access) ||
+	    llcc_perfmon_event_count(node->llcc_miss_ev[0],
+				     node->llcc_miss_ev[1], &miss))
+		return 100;
+
+	d_access = access - node->llcc_prev_access;
+	d_miss = miss - node->llcc_prev_miss;
+	node->llcc_prev_access = access;
+	node->llcc_prev_miss = miss;
+
+	if (!d_access || d_miss >= d_access)
+		return 100;
+
+	return div64_u64(d_miss * 100, d_access);
+}
+
+/*
+ * When the LLCC absorbs most of the traffic the CPUs are not waiting on
+ * DDR, so scale the vote down with the miss ratio below llcc_miss_ceil.
+ */
+static unsigned long llcc_scale_freq(struct memlat_node *node,
+				     unsigned long freq, unsigned int miss_pct)
+{
+	unsigned int scale;
+
+	if (!freq || miss_pct >= node->llcc_miss_ceil)
+		return freq;
+
+	scale = miss_pct * 100 / node->llcc_miss_ceil;
+	scale = max(scale, node->llcc_scale_floor);
+
+	pr_debug("llcc miss %u%%, scale %lu by %u%%\n", miss_pct, freq, scale);
+	return mult_frac(freq, scale, 100);
+}
+
 static int devfreq_memlat_get_freq(struct devfreq *df,
 					unsigned long *freq)
 {
@@ -231,9 +286,10 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 	struct memlat_node *node = df->data;
 	struct memlat_hwmon *hw = node->hw;
 	unsigned long max_freq = 0;
-	unsigned int ratio;
+	unsigned int ratio, miss_pct;
 
 	hw->get_cnt(hw);
+	miss_pct = llcc_miss_pct(node);
 
 	for (i = 0; i < hw->num_cores; i++) {
 		ratio = hw->core_stats[i].inst_count;
@@ -262,6 +318,8 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 	if (max_freq)
 		max_freq = core_to_dev_freq(node, max_freq);
 
+	max_freq = llcc_scale_freq(node, max_freq, miss_pct);
+
 	if (max_freq || !node->already_zero) {
 		trace_memlat_dev_update(dev_name(df->dev.parent),
 					hw->core_stats[lat_dev].id,
@@ -279,10 +337,14 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 
 gov_attr(ratio_ceil, 1U, 10000U);
 gov_attr(stall_floor, 0U, 100U);
+gov_attr(llcc_miss_ceil, 0U, 100U);
+gov_attr(llcc_scale_floor, 0U, 100U);
 
 static struct attribute *memlat_dev_attr[] = {
 	&dev_attr_ratio_ceil.attr,
 	&dev_attr_stall_floor.attr,
+	&dev_attr_llcc_miss_ceil.attr,
+	&dev_attr_llcc_scale_floor.attr,
 	&dev_attr_freq_map.attr,
 	NULL,
 };
@@ -409,8 +471,16 @@ static struct memlat_node *register_common(struct device *dev,
 		return ERR_PTR(-ENOMEM);
 
 	node->ratio_ceil = 10;
+	node->llcc_scale_floor = 50;
 	node->hw = hw;
 
+	/* optional <port event> pairs of LLCC perfmon access/miss counters */
+	if (!of_property_read_u32_array(dev->of_node, "qcom,llcc-access-event",
+					node->llcc_access_ev, 2) &&
+	    !of_property_read_u32_array(dev->of_node, "qcom,llcc-miss-event",
+					node->llcc_miss_ev, 2))
+		node->llcc_events = true;
+
 	hw->freq_map = init_core_dev_map(dev, "qcom,core-dev-table");
 	if (!hw->freq_map) {
 		dev_err(dev, "Couldn't find the core-dev freq table!\n");
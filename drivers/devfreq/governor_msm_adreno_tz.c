@@ -24,6 +24,9 @@
 #include <soc/qcom/scm.h>
 #include "governor.h"
 
+#define CREATE_TRACE_POINTS
+#include "devfreq_trace.h"
+
 static DEFINE_SPINLOCK(tz_lock);
 static DEFINE_SPINLOCK(sample_lock);
 static DEFINE_SPINLOCK(suspend_lock);
@@ -56,6 +59,18 @@ static DEFINE_SPINLOCK(suspend_lock);
 #define TZ_V2_INIT_CA_ID_64        0xC
 #define TZ_V2_UPDATE_WITH_CA_ID_64 0xD
 
+/*
+ * In frame aware mode a frame is the work from the first submit until the
+ * gpu goes idle or its deadline, the first vsync at least FRAME_MIN_BUDGET
+ * percent of a period away, passes. The next frame runs at the lowest
+ * frequency that would have finished this one with FRAME_HEADROOM percent
+ * of its budget. Without vsync information for VSYNC_STALE_MS the TZ
+ * algorithm is used.
+ */
+#define FRAME_HEADROOM		90
+#define FRAME_MIN_BUDGET	25
+#define VSYNC_STALE_MS		500
+
 #define TAG "msm_adreno_tz: "
 
 static u64 suspend_time;
@@ -70,6 +85,125 @@ static void do_partner_resume_event(struct work_struct *work);
 
 static struct workqueue_struct *workqueue;
 
+static DEFINE_SPINLOCK(vsync_lock);
+static ktime_t vsync_time;
+static unsigned int vsync_period_us;
+
+/**
+ * devfreq_msm_adreno_vsync() - report a vsync of the primary display
+ * @timestamp: The time of the vsync.
+ * @period_us: The refresh period of the display.
+ *
+ * Provides the frame deadlines of the frame aware mode, may be called from
+ * interrupt context.
+ */
+void devfreq_msm_adreno_vsync(ktime_t timestamp, unsigned int period_us)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&vsync_lock, flags);
+	vsync_time = timestamp;
+	vsync_period_us = period_us;
+	spin_unlock_irqrestore(&vsync_lock, flags);
+}
+EXPORT_SYMBOL(devfreq_msm_adreno_vsync);
+
+/* Returns the deadline of a frame that starts at @start, or 0 if unknown */
+static ktime_t frame_deadline(ktime_t start)
+{
+	unsigned long flags;
+	ktime_t vsync;
+	s64 period, delta;
+
+	spin_lock_irqsave(&vsync_lock, flags);
+	vsync = vsync_time;
+	period = (s64)vsync_period_us * NSEC_PER_USEC;
+	spin_unlock_irqrestore(&vsync_lock, flags);
+
+	if (!period || ktime_ms_delta(start, vsync) > VSYNC_STALE_MS)
+		return ktime_set(0, 0);
+
+	/* the vsyncs continue at the same rate after the last one seen */
+	delta = ktime_to_ns(ktime_sub(start, vsync));
+	if (delta >= 0)
+		vsync = ktime_add_ns(vsync,
+				     (div64_s64(delta, period) + 1) * period);
+
+	if (ktime_to_ns(ktime_sub(vsync, start)) <
+	    div_s64(period * FRAME_MIN_BUDGET, 100))
+		vsync = ktime_add_ns(vsync, period);
+
+	return vsync;
+}
+
+static void frame_start(struct devfreq_msm_adreno_tz_data *priv, ktime_t now)
+{
+	priv->frame.deadline = frame_deadline(now);
+	priv->frame.active = ktime_to_ns(priv->frame.deadline) != 0;
+	priv->frame.start = now;
+	priv->frame.work = 0;
+}
+
+/* Returns the lowest frequency of at least @freq, or the highest one */
+static unsigned long frame_pick_freq(struct devfreq *devfreq, u64 freq)
+{
+	unsigned long best = 0, max = 0, f;
+	int lev;
+
+	for (lev = 0; lev < devfreq->profile->max_state; lev++) {
+		f = devfreq->profile->freq_table[lev];
+		max = max(max, f);
+		if (f >= freq && (!best || f < best))
+			best = f;
+	}
+
+	return best ? best : max;
+}
+
+/*
+ * Frame aware target selection, returns false when the TZ algorithm has
+ * to be used instead.
+ */
+static bool frame_get_target_freq(struct devfreq *devfreq,
+		struct devfreq_dev_status *stats, unsigned long *freq)
+{
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+	ktime_t now = ktime_get();
+	s64 budget, slack;
+	u64 need;
+
+	if (!priv->frame.active)
+		frame_start(priv, now);
+	if (!priv->frame.active)
+		return false;
+
+	/* busy time scaled by frequency, stays valid across changes */
+	priv->frame.work += (u64)stats->busy_time * stats->current_frequency;
+	*freq = stats->current_frequency;
+
+	if (priv->frame.event != ADRENO_DEVFREQ_NOTIFY_IDLE &&
+	    ktime_before(now, priv->frame.deadline))
+		return true;
+
+	budget = ktime_us_delta(priv->frame.deadline, priv->frame.start);
+	slack = ktime_us_delta(priv->frame.deadline, now);
+	need = div64_u64(priv->frame.work * 100,
+			 max_t(s64, budget, 1) * FRAME_HEADROOM);
+	*freq = frame_pick_freq(devfreq, need);
+
+	trace_adreno_tz_frame(stats->current_frequency, *freq,
+			div64_u64(priv->frame.work,
+				  max_t(u64, stats->current_frequency, 1)),
+			budget, slack);
+
+	/* a frame interrupted by its deadline goes on as the next one */
+	priv->frame.active = false;
+	if (priv->frame.event != ADRENO_DEVFREQ_NOTIFY_IDLE)
+		frame_start(priv, now);
+
+	return true;
+}
+
 /*
  * Returns GPU suspend time in millisecond.
  */
@@ -134,8 +268,42 @@ static ssize_t suspend_time_show(struct device *dev,
 	return snprintf(buf, PAGE_SIZE, "%llu\n", time_diff);
 }
 
+static ssize_t frame_aware_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", priv && priv->frame.enable);
+}
+
+static ssize_t frame_aware_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool(buf, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&devfreq->lock);
+	priv = devfreq->data;
+	if (priv) {
+		priv->frame.enable = enable;
+		priv->frame.active = false;
+	}
+	mutex_unlock(&devfreq->lock);
+
+	return priv ? count : -ENODEV;
+}
+
 static DEVICE_ATTR(gpu_load, 0444, gpu_load_show, NULL);
 
+static DEVICE_ATTR(frame_aware, 0644, frame_aware_show, frame_aware_store);
+
 static DEVICE_ATTR(suspend_time, 0444,
 		suspend_time_show,
 		NULL);
@@ -143,6 +311,7 @@ static DEVICE_ATTR(suspend_time, 0444,
 static const struct device_attribute *adreno_tz_attr_list[] = {
 		&dev_attr_gpu_load,
 		&dev_attr_suspend_time,
+		&dev_attr_frame_aware,
 		NULL
 };
 
@@ -381,6 +550,13 @@ static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
 
 	/* Update the GPU load statistics */
 	compute_work_load(&stats, priv, devfreq);
+
+	if (priv->frame.enable &&
+	    frame_get_target_freq(devfreq, &stats, freq)) {
+		priv->bin.total_time = 0;
+		priv->bin.busy_time = 0;
+		return 0;
+	}
 	/*
 	 * Do not waste CPU cycles running this algorithm if
 	 * the GPU just started, or if less than FLOOR time
@@ -436,11 +612,15 @@ static int tz_notify(struct notifier_block *nb, unsigned long type, void *devp)
 {
 	int result = 0;
 	struct devfreq *devfreq = devp;
+	struct devfreq_msm_adreno_tz_data *priv;
 
 	switch (type) {
 	case ADRENO_DEVFREQ_NOTIFY_IDLE:
 	case ADRENO_DEVFREQ_NOTIFY_RETIRE:
 		mutex_lock(&devfreq->lock);
+		priv = devfreq->data;
+		if (priv)
+			priv->frame.event = type;
 		result = update_devfreq(devfreq);
 		mutex_unlock(&devfreq->lock);
 		/* Nofifying partner bus governor if any */
@@ -450,8 +630,14 @@ static int tz_notify(struct notifier_block *nb, unsigned long type, void *devp)
 			mutex_unlock(&partner_gpu_profile->bus_devfreq->lock);
 		}
 		break;
-	/* ignored by this governor */
 	case ADRENO_DEVFREQ_NOTIFY_SUBMIT:
+		/* the first submit after idle starts a frame */
+		mutex_lock(&devfreq->lock);
+		priv = devfreq->data;
+		if (priv && priv->frame.enable && !priv->frame.active)
+			frame_start(priv, ktime_get());
+		mutex_unlock(&devfreq->lock);
+		break;
 	default:
 		break;
 	}
@@ -541,6 +727,7 @@ static int tz_suspend(struct devfreq *devfreq)
 
 	priv->bin.total_time = 0;
 	priv->bin.busy_time = 0;
+	priv->frame.active = false;
 	return 0;
 }
 
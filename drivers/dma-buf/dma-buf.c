@@ -528,6 +528,9 @@ void dma_buf_detach(struct dma_buf *dmabuf, struct dma_buf_attachment *attach)
 	if (WARN_ON(!dmabuf || !attach))
 		return;
 
+	if (attach->sgt)
+		dmabuf->ops->unmap_dma_buf(attach, attach->sgt, attach->dir);
+
 	mutex_lock(&dmabuf->lock);
 	list_del(&attach->node);
 	if (dmabuf->ops->detach)
@@ -547,6 +550,9 @@ EXPORT_SYMBOL_GPL(dma_buf_detach);
  *
  * Returns sg_table containing the scatterlist to be returned; returns ERR_PTR
  * on error.
+ *
+ * If the exporter sets cache_sgt_mapping, the mapping is kept on the
+ * attachment and repeated calls in the same direction return it directly.
  */
 struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 					enum dma_data_direction direction)
@@ -558,10 +564,25 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 	if (WARN_ON(!attach || !attach->dmabuf))
 		return ERR_PTR(-EINVAL);
 
+	if (attach->sgt) {
+		if (attach->dir == direction) {
+			attach->map_hits++;
+			return attach->sgt;
+		}
+		attach->dmabuf->ops->unmap_dma_buf(attach, attach->sgt,
+						   attach->dir);
+		attach->sgt = NULL;
+	}
+
 	sg_table = attach->dmabuf->ops->map_dma_buf(attach, direction);
 	if (!sg_table)
 		sg_table = ERR_PTR(-ENOMEM);
 
+	if (!IS_ERR(sg_table) && attach->dmabuf->ops->cache_sgt_mapping) {
+		attach->sgt = sg_table;
+		attach->dir = direction;
+	}
+
 	return sg_table;
 }
 EXPORT_SYMBOL_GPL(dma_buf_map_attachment);
@@ -584,6 +605,10 @@ void dma_buf_unmap_attachment(struct dma_buf_attachment *attach,
 	if (WARN_ON(!attach || !attach->dmabuf || !sg_table))
 		return;
 
+	/* cached mapping is released on detach */
+	if (attach->sgt == sg_table)
+		return;
+
 	attach->dmabuf->ops->unmap_dma_buf(attach, sg_table,
 						direction);
 }
@@ -662,6 +687,79 @@ int dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 }
 EXPORT_SYMBOL_GPL(dma_buf_end_cpu_access);
 
+static bool dma_buf_range_valid(struct dma_buf *dmabuf, unsigned int offset,
+				unsigned int len)
+{
+	return len && offset < dmabuf->size && len <= dmabuf->size - offset;
+}
+
+/**
+ * dma_buf_begin_cpu_access_partial - Like dma_buf_begin_cpu_access(), for a
+ * cpu access limited to [offset, offset + len) of the buffer. Exporters
+ * without a begin_cpu_access_partial callback get the whole-buffer call.
+ * @dmabuf:	[in]	buffer to prepare cpu access for.
+ * @direction:	[in]	direction of the cpu access.
+ * @offset:	[in]	start of the range in bytes.
+ * @len:	[in]	length of the range in bytes.
+ *
+ * Can return negative error values, returns 0 on success.
+ */
+int dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
+				     enum dma_data_direction direction,
+				     unsigned int offset, unsigned int len)
+{
+	int ret = 0;
+
+	if (WARN_ON(!dmabuf))
+		return -EINVAL;
+
+	if (!dma_buf_range_valid(dmabuf, offset, len))
+		return -EINVAL;
+
+	if (dmabuf->ops->begin_cpu_access_partial)
+		ret = dmabuf->ops->begin_cpu_access_partial(dmabuf, direction,
+							    offset, len);
+	else if (dmabuf->ops->begin_cpu_access)
+		ret = dmabuf->ops->begin_cpu_access(dmabuf, direction);
+
+	if (ret == 0)
+		ret = __dma_buf_begin_cpu_access(dmabuf, direction);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(dma_buf_begin_cpu_access_partial);
+
+/**
+ * dma_buf_end_cpu_access_partial - Like dma_buf_end_cpu_access(), for a range
+ * prepared with dma_buf_begin_cpu_access_partial().
+ * @dmabuf:	[in]	buffer to complete cpu access for.
+ * @direction:	[in]	direction of the cpu access.
+ * @offset:	[in]	start of the range in bytes.
+ * @len:	[in]	length of the range in bytes.
+ *
+ * Can return negative error values, returns 0 on success.
+ */
+int dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
+				   enum dma_data_direction direction,
+				   unsigned int offset, unsigned int len)
+{
+	int ret = 0;
+
+	WARN_ON(!dmabuf);
+
+	if (!dma_buf_range_valid(dmabuf, offset, len))
+		return -EINVAL;
+
+	if (dmabuf->ops->end_cpu_access_partial)
+		ret = dmabuf->ops->end_cpu_access_partial(dmabuf, direction,
+							  offset, len);
+	else if (dmabuf->ops->end_cpu_access)
+		ret = dmabuf->ops->end_cpu_access(dmabuf, direction);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(dma_buf_end_cpu_access_partial);
+
 /**
  * dma_buf_kmap_atomic - Map a page of the buffer object into kernel address
  * space. The same restrictions as for kmap_atomic and friends apply.
@@ -894,7 +992,12 @@ static int dma_buf_debug_show(struct seq_file *s, void *unused)
 		list_for_each_entry(attach_obj, &buf_obj->attachments, node) {
 			seq_puts(s, "\t");
 
-			seq_printf(s, "%s\n", dev_name(attach_obj->dev));
+			if (attach_obj->sgt)
+				seq_printf(s, "%s (cached map, %lu hits)\n",
+					   dev_name(attach_obj->dev),
+					   attach_obj->map_hits);
+			else
+				seq_printf(s, "%s\n", dev_name(attach_obj->dev));
 			attach_count++;
 		}
 
@@ -108,9 +108,13 @@ reservation_object_add_shared_inplace(struct reservation_object *obj,
 
 	fence_get(fence);
 
-	preempt_disable();
-	write_seqcount_begin(&obj->seq);
-
+	/*
+	 * Replacing the fence of a context already in the list is a single
+	 * pointer store: rcu readers see either fence, and one that finds the
+	 * old fence released already fails fence_get_rcu() and restarts. So
+	 * the common resubmit of a bo on the same ring needs no seqcount
+	 * write, and does not force concurrent readers to retry.
+	 */
 	for (i = 0; i < fobj->shared_count; ++i) {
 		struct fence *old_fence;
 
@@ -118,16 +122,15 @@ reservation_object_add_shared_inplace(struct reservation_object *obj,
 						reservation_object_held(obj));
 
 		if (old_fence->context == fence->context) {
-			/* memory barrier is added by write_seqcount_begin */
-			RCU_INIT_POINTER(fobj->shared[i], fence);
-			write_seqcount_end(&obj->seq);
-			preempt_enable();
-
+			rcu_assign_pointer(fobj->shared[i], fence);
 			fence_put(old_fence);
 			return;
 		}
 	}
 
+	preempt_disable();
+	write_seqcount_begin(&obj->seq);
+
 	/*
 	 * memory barrier is added by write_seqcount_begin,
 	 * fobj->shared_count is protected by this lock too
@@ -299,8 +302,12 @@ int reservation_object_get_fences_rcu(struct reservation_object *obj,
 		if (fence_excl && !fence_get_rcu(fence_excl))
 			goto unlock;
 
+		/*
+		 * An exclusive fence replaces the shared ones without freeing
+		 * the list, so an empty list is common and needs no array.
+		 */
 		fobj = rcu_dereference(obj->fence);
-		if (fobj) {
+		if (fobj && READ_ONCE(fobj->shared_count)) {
 			struct fence **nshared;
 			size_t sz = sizeof(*shared) * fobj->shared_max;
 
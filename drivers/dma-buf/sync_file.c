@@ -180,10 +180,22 @@ static void add_fence(struct fence **fences, int *i, struct fence *fence)
 {
 	fences[*i] = fence;
 
-	if (!fence_is_signaled(fence)) {
-		fence_get(fence);
+	if (!fence_is_signaled(fence))
 		(*i)++;
-	}
+}
+
+/* merges up to this many fences are resolved without a scratch allocation */
+#define SYNC_FILE_MERGE_STACK	8
+
+static bool sync_file_has_fences(struct sync_file *sync_file,
+				 struct fence **fences, int num_fences)
+{
+	struct fence **own;
+	int num;
+
+	own = get_fences(sync_file, &num);
+	return num == num_fences &&
+	       !memcmp(own, fences, num * sizeof(*fences));
 }
 
 /**
@@ -200,7 +212,8 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 					 struct sync_file *b)
 {
 	struct sync_file *sync_file;
-	struct fence **fences, **nfences, **a_fences, **b_fences;
+	struct fence *stack[SYNC_FILE_MERGE_STACK];
+	struct fence **fences = stack, **a_fences, **b_fences;
 	int i, i_a, i_b, num_fences, a_num_fences, b_num_fences;
 
 	sync_file = sync_file_alloc();
@@ -214,9 +227,11 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 
 	num_fences = a_num_fences + b_num_fences;
 
-	fences = kcalloc(num_fences, sizeof(*fences), GFP_KERNEL);
-	if (!fences)
-		goto err;
+	if (num_fences > ARRAY_SIZE(stack)) {
+		fences = kcalloc(num_fences, sizeof(*fences), GFP_KERNEL);
+		if (!fences)
+			goto err;
+	}
 
 	/*
 	 * Assume sync_file a and b are both ordered and have no
@@ -255,26 +270,53 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 		add_fence(fences, &i, b_fences[i_b]);
 
 	if (i == 0)
-		fences[i++] = fence_get(a_fences[0]);
+		fences[i++] = a_fences[0];
 
-	if (num_fences > i) {
-		nfences = krealloc(fences, i * sizeof(*fences),
-				  GFP_KERNEL);
-		if (!nfences)
-			goto err;
+	/*
+	 * A lone fence needs no array, and when one side already covers the
+	 * result (the other side is signaled or older on every context) its
+	 * fence is shared rather than wrapped in an identical new array.
+	 */
+	if (i == 1) {
+		sync_file->fence = fence_get(fences[0]);
+	} else if (sync_file_has_fences(a, fences, i)) {
+		sync_file->fence = fence_get(a->fence);
+	} else if (sync_file_has_fences(b, fences, i)) {
+		sync_file->fence = fence_get(b->fence);
+	} else {
+		struct fence **array_fences = fences;
+		int j;
+
+		/* the fence array takes ownership of the table */
+		if (fences == stack) {
+			array_fences = kmemdup(stack, i * sizeof(*fences),
+					       GFP_KERNEL);
+			if (!array_fences)
+				goto err;
+		}
+
+		for (j = 0; j < i; j++)
+			fence_get(array_fences[j]);
 
-		fences = nfences;
+		if (sync_file_set_fence(sync_file, array_fences, i) < 0) {
+			for (j = 0; j < i; j++)
+				fence_put(array_fences[j]);
+			kfree(array_fences);
+			fences = stack;
+			goto err;
+		}
+		fences = stack;
 	}
 
-	if (sync_file_set_fence(sync_file, fences, i) < 0) {
+	if (fences != stack)
 		kfree(fences);
-		goto err;
-	}
 
 	strlcpy(sync_file->name, name, sizeof(sync_file->name));
 	return sync_file;
 
 err:
+	if (fences != stack)
+		kfree(fences);
 	fput(sync_file->file);
 	return NULL;
 
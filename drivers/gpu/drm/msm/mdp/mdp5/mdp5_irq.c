@@ -16,6 +16,7 @@
  */
 
 #include <linux/irq.h>
+#include <linux/msm_adreno_devfreq.h>
 
 #include "msm_drv.h"
 #include "mdp5_kms.h"
@@ -90,6 +91,15 @@ irqreturn_t mdp5_irq(struct msm_kms *kms)
 		if (status & mdp5_crtc_vblank(priv->crtcs[id]))
 			drm_handle_vblank(dev, id);
 
+	/* the primary display paces the gpu frames: */
+	if (priv->num_crtcs && (status & mdp5_crtc_vblank(priv->crtcs[0]))) {
+		int vrefresh = drm_mode_vrefresh(&priv->crtcs[0]->mode);
+
+		if (vrefresh > 0)
+			devfreq_msm_adreno_vsync(ktime_get(),
+						 USEC_PER_SEC / vrefresh);
+	}
+
 	return IRQ_HANDLED;
 }
 
@@ -27,11 +27,17 @@
 
 #define MULTIPLE_CONN_DETECTED(x) (x > 1)
 
+static bool commit_pipeline;
+MODULE_PARM_DESC(commit_pipeline, "Let the next commit on a crtc swap in while the current one waits for its frame");
+module_param(commit_pipeline, bool, 0600);
+
 struct msm_commit {
 	struct drm_device *dev;
 	struct drm_atomic_state *state;
 	uint32_t crtc_mask;
+	uint32_t wait_mask;	/* crtcs enabled by this commit */
 	bool nonblock;
+	bool pipelined;
 	struct kthread_work commit_work;
 };
 
@@ -68,7 +74,8 @@ EXPORT_SYMBOL(msm_drm_unregister_client);
 
 /**
  * msm_drm_notifier_call_chain - notify clients of drm_events
- * @val: event MSM_DRM_EARLY_EVENT_BLANK or MSM_DRM_EVENT_BLANK
+ * @val: event MSM_DRM_EARLY_EVENT_BLANK, MSM_DRM_EVENT_BLANK or
+ *       MSM_DRM_EVENT_COMMIT_DONE
  * @v: notifier data, inculde display id and display blank
  *     event(unblank or power down).
  */
@@ -110,7 +117,8 @@ static void end_atomic(struct msm_drm_private *priv, uint32_t crtc_mask)
 
 static void commit_destroy(struct msm_commit *c)
 {
-	end_atomic(c->dev->dev_private, c->crtc_mask);
+	if (!c->pipelined)
+		end_atomic(c->dev->dev_private, c->crtc_mask);
 	if (c->nonblock)
 		kfree(c);
 }
@@ -182,7 +190,8 @@ static inline bool _msm_seamless_for_conn(struct drm_connector *connector,
 
 static void msm_atomic_wait_for_commit_done(
 		struct drm_device *dev,
-		struct drm_atomic_state *old_state)
+		struct drm_atomic_state *old_state,
+		uint32_t wait_mask)
 {
 	struct drm_crtc *crtc;
 	struct drm_crtc_state *crtc_state;
@@ -191,7 +200,8 @@ static void msm_atomic_wait_for_commit_done(
 	int i;
 
 	for_each_crtc_in_state(old_state, crtc, crtc_state, i) {
-		if (!crtc->state->enable)
+		/* crtc->state may already belong to a pipelined next commit */
+		if (!(wait_mask & drm_crtc_mask(crtc)))
 			continue;
 
 		/* Legacy cursor ioctls are completely unsynced, and userspace
@@ -556,6 +566,15 @@ static void complete_commit(struct msm_commit *c)
 
 	msm_atomic_helper_commit_modeset_enables(dev, state);
 
+	/*
+	 * The hw has been programmed from this commit's state, so a pipelined
+	 * next commit may now swap in its own state and return to userspace
+	 * while this one waits for its frame.  Its work still runs after this
+	 * one on the same crtc thread.
+	 */
+	if (c->pipelined)
+		end_atomic(priv, c->crtc_mask);
+
 	/* NOTE: _wait_for_vblanks() only waits for vblank on
 	 * enabled CRTCs.  So we end up faulting when disabling
 	 * due to (potentially) unref'ing the outgoing fb's
@@ -569,7 +588,16 @@ static void complete_commit(struct msm_commit *c)
 	 * not be critical path)
 	 */
 
-	msm_atomic_wait_for_commit_done(dev, state);
+	msm_atomic_wait_for_commit_done(dev, state, c->wait_mask);
+
+	if (c->crtc_mask & BIT(MSM_DRM_PRIMARY_DISPLAY)) {
+		struct msm_drm_notifier notifier_data = {
+			.id = MSM_DRM_PRIMARY_DISPLAY,
+		};
+
+		msm_drm_notifier_call_chain(MSM_DRM_EVENT_COMMIT_DONE,
+					    &notifier_data);
+	}
 
 	drm_atomic_helper_cleanup_planes(dev, state);
 
@@ -607,6 +635,7 @@ static struct msm_commit *commit_init(struct drm_atomic_state *state,
 	c->dev = state->dev;
 	c->state = state;
 	c->nonblock = nonblock;
+	c->pipelined = commit_pipeline;
 
 	kthread_init_work(&c->commit_work, _msm_drm_commit_work_cb);
 
@@ -750,6 +779,10 @@ int msm_atomic_commit(struct drm_device *dev,
 
 	drm_atomic_helper_swap_state(state, true);
 
+	for_each_crtc_in_state(state, crtc, crtc_state, i)
+		if (crtc->state->enable)
+			c->wait_mask |= drm_crtc_mask(crtc);
+
 	/*
 	 * Provide the driver a chance to prepare for output fences. This is
 	 * done after the point of no return, but before asynchronous commits
@@ -101,6 +101,7 @@ static struct drm_info_list msm_debugfs_list[] = {
 		{"gem", show_locked, 0, msm_gem_show},
 		{ "mm", show_locked, 0, msm_mm_show },
 		{ "fb", show_locked, 0, msm_fb_show },
+		{ "perf_proc", show_locked, 0, msm_perf_proc_show },
 };
 
 static int late_init_minor(struct drm_minor *minor)
@@ -651,6 +651,8 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 
 	INIT_LIST_HEAD(&priv->client_event_list);
 	INIT_LIST_HEAD(&priv->inactive_list);
+	for (i = 0; i < MSM_BO_CACHE_BUCKETS; i++)
+		INIT_LIST_HEAD(&priv->bo_cache[i]);
 
 	ret = sde_power_resource_init(pdev, &priv->phandle);
 	if (ret) {
@@ -948,6 +950,7 @@ static int msm_open(struct drm_device *dev, struct drm_file *file)
 	if (!ctx)
 		return -ENOMEM;
 
+	idr_init(&ctx->bo_lists);
 	file->driver_priv = ctx;
 
 	if (dev && dev->dev_private) {
@@ -982,6 +985,8 @@ static void msm_postclose(struct drm_device *dev, struct drm_file *file)
 	mutex_lock(&dev->struct_mutex);
 	if (ctx == priv->lastctx)
 		priv->lastctx = NULL;
+	msm_gem_bo_lists_release(dev, ctx);
+	msm_gem_cache_release_ctx(dev, ctx);
 	mutex_unlock(&dev->struct_mutex);
 
 	kfree(ctx);
@@ -1691,6 +1696,7 @@ static const struct drm_ioctl_desc msm_ioctls[] = {
 	DRM_IOCTL_DEF_DRV(MSM_GEM_SUBMIT,   msm_ioctl_gem_submit,   DRM_AUTH|DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(MSM_WAIT_FENCE,   msm_ioctl_wait_fence,   DRM_AUTH|DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(MSM_GEM_MADVISE,  msm_ioctl_gem_madvise,  DRM_AUTH|DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(MSM_GEM_BO_LIST,  msm_ioctl_gem_bo_list,  DRM_AUTH|DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(SDE_WB_CONFIG, sde_wb_config, DRM_UNLOCKED|DRM_AUTH),
 	DRM_IOCTL_DEF_DRV(MSM_REGISTER_EVENT,  msm_ioctl_register_event,
 			  DRM_UNLOCKED|DRM_CONTROL_ALLOW),
@@ -74,6 +74,7 @@ struct msm_gem_vma;
 #define MAX_CONNECTORS 8
 
 #define TEARDOWN_DEADLOCK_RETRY_MAX 5
+#define MSM_BO_CACHE_BUCKETS 11 /* bo's up to 4MB (order 10) are cached */
 
 extern atomic_t resume_pending;
 extern wait_queue_head_t resume_wait_q;
@@ -84,6 +85,9 @@ struct msm_file_private {
 	 * the context's page-tables here.
 	 */
 	int dummy;
+
+	/* bo lists registered with MSM_GEM_BO_LIST, under struct_mutex: */
+	struct idr bo_lists;
 };
 
 enum msm_mdp_plane_property {
@@ -569,6 +573,10 @@ struct msm_drm_private {
 	/* list of GEM objects: */
 	struct list_head inactive_list;
 
+	/* freed userspace bo's kept for reuse, bucketed by order of pages: */
+	struct list_head bo_cache[MSM_BO_CACHE_BUCKETS];
+	size_t bo_cache_size;
+
 	struct workqueue_struct *wq;
 
 	/* crtcs pending async atomic updates: */
@@ -740,6 +748,10 @@ int msm_gem_address_space_unregister_cb(
 
 int msm_ioctl_gem_submit(struct drm_device *dev, void *data,
 		struct drm_file *file);
+int msm_ioctl_gem_bo_list(struct drm_device *dev, void *data,
+		struct drm_file *file);
+void msm_gem_bo_lists_release(struct drm_device *dev,
+		struct msm_file_private *ctx);
 
 void msm_gem_shrinker_init(struct drm_device *dev);
 void msm_gem_shrinker_cleanup(struct drm_device *dev);
@@ -780,6 +792,9 @@ void msm_gem_put_vaddr_locked(struct drm_gem_object *obj);
 void msm_gem_put_vaddr(struct drm_gem_object *obj);
 int msm_gem_madvise(struct drm_gem_object *obj, unsigned madv);
 void msm_gem_purge(struct drm_gem_object *obj);
+void msm_gem_swap_out(struct drm_gem_object *obj);
+void msm_gem_pin_scanout(struct drm_gem_object *obj);
+void msm_gem_unpin_scanout(struct drm_gem_object *obj);
 void msm_gem_vunmap(struct drm_gem_object *obj);
 int msm_gem_sync_object(struct drm_gem_object *obj,
 		struct msm_fence_context *fctx, bool exclusive);
@@ -789,6 +804,10 @@ void msm_gem_move_to_inactive(struct drm_gem_object *obj);
 int msm_gem_cpu_prep(struct drm_gem_object *obj, uint32_t op, ktime_t *timeout);
 int msm_gem_cpu_fini(struct drm_gem_object *obj);
 void msm_gem_free_object(struct drm_gem_object *obj);
+unsigned long msm_gem_cache_shrink(struct drm_device *dev,
+		unsigned long nr_pages);
+void msm_gem_cache_release_ctx(struct drm_device *dev,
+		struct msm_file_private *ctx);
 int msm_gem_new_handle(struct drm_device *dev, struct drm_file *file,
 		uint32_t size, uint32_t flags, uint32_t *handle);
 struct drm_gem_object *msm_gem_new(struct drm_device *dev,
@@ -894,6 +913,7 @@ void msm_rd_debugfs_cleanup(struct drm_minor *minor);
 void msm_rd_dump_submit(struct msm_gem_submit *submit);
 int msm_perf_debugfs_init(struct drm_minor *minor);
 void msm_perf_debugfs_cleanup(struct drm_minor *minor);
+int msm_perf_proc_show(struct drm_device *dev, struct seq_file *m);
 #else
 static inline int msm_debugfs_late_init(struct drm_device *dev) { return 0; }
 static inline void msm_rd_dump_submit(struct msm_gem_submit *submit) {}
@@ -212,6 +212,9 @@ int msm_framebuffer_prepare(struct drm_framebuffer *fb,
 			return ret;
 	}
 
+	for (i = 0; i < n; i++)
+		msm_gem_pin_scanout(msm_fb->planes[i]);
+
 	if (msm_fb->flags & MSM_FRAMEBUFFER_FLAG_KMAP)
 		msm_framebuffer_kmap(fb);
 
@@ -235,8 +238,10 @@ void msm_framebuffer_cleanup(struct drm_framebuffer *fb,
 	if (msm_fb->flags & MSM_FRAMEBUFFER_FLAG_KMAP)
 		msm_framebuffer_kunmap(fb);
 
-	for (i = 0; i < n; i++)
+	for (i = 0; i < n; i++) {
+		msm_gem_unpin_scanout(msm_fb->planes[i]);
 		msm_gem_put_iova(msm_fb->planes[i], aspace);
+	}
 }
 
 uint32_t msm_framebuffer_iova(struct drm_framebuffer *fb,
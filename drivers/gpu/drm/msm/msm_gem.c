@@ -26,6 +26,10 @@
 #include "msm_gpu.h"
 #include "msm_mmu.h"
 
+static unsigned int bo_cache_kb = 8192;
+MODULE_PARM_DESC(bo_cache_kb, "KB of freed bo's kept with pages and iova for reuse (0 to disable)");
+module_param_named(bo_cache_kb, bo_cache_kb, uint, 0600);
+
 static void *get_dmabuf_ptr(struct drm_gem_object *obj)
 {
 	return (obj && obj->import_attach) ? obj->import_attach->dmabuf : NULL;
@@ -686,6 +690,41 @@ void msm_gem_purge(struct drm_gem_object *obj)
 			0, (loff_t)-1);
 }
 
+/*
+ * Give the pages of an idle bo back to shmem, marked dirty, so reclaim can
+ * write them out to swap (zram).  The bo stays valid: the next get_pages(),
+ * from the submit that pins it again or from a cpu fault, reads them back
+ * in and maps a new iova.
+ */
+void msm_gem_swap_out(struct drm_gem_object *obj)
+{
+	struct drm_device *dev = obj->dev;
+	struct msm_gem_object *msm_obj = to_msm_bo(obj);
+
+	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
+	WARN_ON(!is_swappable(msm_obj));
+
+	put_iova(obj);
+	msm_gem_remove_obj_from_aspace_active_list(msm_obj->aspace, obj);
+
+	msm_gem_vunmap(obj);
+
+	drm_vma_node_unmap(&obj->vma_node, dev->anon_inode->i_mapping);
+
+	put_pages(obj);
+}
+
+/* bo's displayed by the display hw must keep their pages and iova */
+void msm_gem_pin_scanout(struct drm_gem_object *obj)
+{
+	atomic_inc(&to_msm_bo(obj)->pin_count);
+}
+
+void msm_gem_unpin_scanout(struct drm_gem_object *obj)
+{
+	WARN_ON(atomic_dec_return(&to_msm_bo(obj)->pin_count) < 0);
+}
+
 void msm_gem_vunmap(struct drm_gem_object *obj)
 {
 	struct msm_gem_object *msm_obj = to_msm_bo(obj);
@@ -884,18 +923,10 @@ void msm_gem_describe_objects(struct list_head *list, struct seq_file *m)
 }
 #endif
 
-void msm_gem_free_object(struct drm_gem_object *obj)
+static void msm_gem_destroy(struct drm_gem_object *obj)
 {
-	struct drm_device *dev = obj->dev;
 	struct msm_gem_object *msm_obj = to_msm_bo(obj);
 
-	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
-
-	/* object should not be on active list: */
-	WARN_ON(is_active(msm_obj));
-
-	list_del(&msm_obj->mm_list);
-
 	put_iova(obj);
 	msm_gem_remove_obj_from_aspace_active_list(msm_obj->aspace, obj);
 
@@ -924,6 +955,171 @@ void msm_gem_free_object(struct drm_gem_object *obj)
 	kfree(msm_obj);
 }
 
+static int msm_gem_cache_bucket(size_t size)
+{
+	return ilog2(size >> PAGE_SHIFT);
+}
+
+/*
+ * A freed bo is only recycled back into the file that allocated it, since
+ * its pages are handed out again without clearing.
+ */
+static bool msm_gem_cacheable(struct drm_gem_object *obj)
+{
+	struct msm_gem_object *msm_obj = to_msm_bo(obj);
+
+	return bo_cache_kb && msm_obj->cache_ctx && !msm_obj->vram_node &&
+		msm_obj->madv == MSM_MADV_WILLNEED &&
+		!obj->import_attach && !obj->dma_buf &&
+		msm_gem_cache_bucket(obj->size) < MSM_BO_CACHE_BUCKETS;
+}
+
+static void msm_gem_cache_drop(struct msm_gem_object *msm_obj)
+{
+	struct msm_drm_private *priv = msm_obj->base.dev->dev_private;
+
+	list_del(&msm_obj->mm_list);
+	priv->bo_cache_size -= msm_obj->base.size;
+	msm_gem_destroy(&msm_obj->base);
+}
+
+/**
+ * msm_gem_cache_shrink - free cached bo's
+ * @dev: drm device
+ * @nr_pages: number of pages to free at least
+ *
+ * Largest bo's go first, the oldest first within a bucket. Must be called
+ * with struct_mutex held. Returns the number of pages freed.
+ */
+unsigned long msm_gem_cache_shrink(struct drm_device *dev,
+		unsigned long nr_pages)
+{
+	struct msm_drm_private *priv = dev->dev_private;
+	struct msm_gem_object *msm_obj, *tmp;
+	unsigned long freed = 0;
+	int i;
+
+	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
+
+	for (i = MSM_BO_CACHE_BUCKETS - 1; i >= 0; i--) {
+		list_for_each_entry_safe(msm_obj, tmp, &priv->bo_cache[i],
+				mm_list) {
+			if (freed >= nr_pages)
+				return freed;
+			freed += msm_obj->base.size >> PAGE_SHIFT;
+			msm_gem_cache_drop(msm_obj);
+		}
+	}
+
+	return freed;
+}
+
+static bool msm_gem_cache_put(struct drm_gem_object *obj)
+{
+	struct msm_drm_private *priv = obj->dev->dev_private;
+	struct msm_gem_object *msm_obj = to_msm_bo(obj);
+	size_t budget = (size_t)bo_cache_kb << 10;
+
+	if (!msm_gem_cacheable(obj))
+		return false;
+
+	list_add_tail(&msm_obj->mm_list,
+		&priv->bo_cache[msm_gem_cache_bucket(obj->size)]);
+	priv->bo_cache_size += obj->size;
+
+	if (priv->bo_cache_size > budget)
+		msm_gem_cache_shrink(obj->dev,
+			(priv->bo_cache_size - budget) >> PAGE_SHIFT);
+
+	return true;
+}
+
+static struct drm_gem_object *msm_gem_cache_get(struct drm_device *dev,
+		struct msm_file_private *ctx, uint32_t size, uint32_t flags)
+{
+	struct msm_drm_private *priv = dev->dev_private;
+	struct msm_gem_object *msm_obj;
+	int bucket = msm_gem_cache_bucket(size);
+
+	if (bucket >= MSM_BO_CACHE_BUCKETS)
+		return NULL;
+
+	/* newest first, its pages are the most likely to still be warm */
+	list_for_each_entry_reverse(msm_obj, &priv->bo_cache[bucket],
+			mm_list) {
+		struct drm_gem_object *obj = &msm_obj->base;
+
+		if (msm_obj->cache_ctx != ctx || obj->size != size ||
+				msm_obj->flags != flags)
+			continue;
+
+		list_del(&msm_obj->mm_list);
+		priv->bo_cache_size -= size;
+
+		/* drop the fences of the previous life, all long signaled */
+		reservation_object_fini(msm_obj->resv);
+		reservation_object_init(msm_obj->resv);
+
+		kref_init(&obj->refcount);
+		list_add_tail(&msm_obj->mm_list, &priv->inactive_list);
+
+		return obj;
+	}
+
+	return NULL;
+}
+
+/**
+ * msm_gem_cache_release_ctx - forget about a file that is going away
+ * @dev: drm device
+ * @ctx: the file's private data
+ *
+ * Its cached bo's are freed, and bo's it shared that are still alive are
+ * no longer recycled. Must be called with struct_mutex held.
+ */
+void msm_gem_cache_release_ctx(struct drm_device *dev,
+		struct msm_file_private *ctx)
+{
+	struct msm_drm_private *priv = dev->dev_private;
+	struct msm_gem_object *msm_obj, *tmp;
+	int i;
+
+	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
+
+	for (i = 0; i < MSM_BO_CACHE_BUCKETS; i++)
+		list_for_each_entry_safe(msm_obj, tmp, &priv->bo_cache[i],
+				mm_list)
+			if (msm_obj->cache_ctx == ctx)
+				msm_gem_cache_drop(msm_obj);
+
+	list_for_each_entry(msm_obj, &priv->inactive_list, mm_list)
+		if (msm_obj->cache_ctx == ctx)
+			msm_obj->cache_ctx = NULL;
+
+	if (priv->gpu)
+		list_for_each_entry(msm_obj, &priv->gpu->active_list, mm_list)
+			if (msm_obj->cache_ctx == ctx)
+				msm_obj->cache_ctx = NULL;
+}
+
+void msm_gem_free_object(struct drm_gem_object *obj)
+{
+	struct drm_device *dev = obj->dev;
+	struct msm_gem_object *msm_obj = to_msm_bo(obj);
+
+	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
+
+	/* object should not be on active list: */
+	WARN_ON(is_active(msm_obj));
+
+	list_del(&msm_obj->mm_list);
+
+	if (msm_gem_cache_put(obj))
+		return;
+
+	msm_gem_destroy(obj);
+}
+
 /* convenience method to construct a GEM buffer object, and userspace handle */
 int msm_gem_new_handle(struct drm_device *dev, struct drm_file *file,
 		uint32_t size, uint32_t flags, uint32_t *handle)
@@ -935,7 +1131,12 @@ int msm_gem_new_handle(struct drm_device *dev, struct drm_file *file,
 	if (ret)
 		return ret;
 
-	obj = msm_gem_new(dev, size, flags);
+	size = PAGE_ALIGN(size);
+	obj = msm_gem_cache_get(dev, file->driver_priv, size, flags);
+	if (!obj)
+		obj = msm_gem_new(dev, size, flags);
+	if (!IS_ERR(obj))
+		to_msm_bo(obj)->cache_ctx = file->driver_priv;
 
 	mutex_unlock(&dev->struct_mutex);
 
@@ -125,6 +125,14 @@ struct msm_gem_object {
 
 	struct msm_gem_address_space *aspace;
 	bool in_active_list;
+
+	/* file that allocated the bo: its freed bo may be recycled into it,
+	 * with pages and iova intact, and only such bo's are swapped out
+	 */
+	struct msm_file_private *cache_ctx;
+
+	/* scanout references from msm_framebuffer_prepare() */
+	atomic_t pin_count;
 };
 #define to_msm_bo(x) container_of(x, struct msm_gem_object, base)
 
@@ -144,6 +152,27 @@ static inline bool is_vunmapable(struct msm_gem_object *msm_obj)
 	return (msm_obj->vmap_count == 0) && msm_obj->vaddr;
 }
 
+/* idle userspace bo whose pages can be handed back to shmem: */
+static inline bool is_swappable(struct msm_gem_object *msm_obj)
+{
+	return (msm_obj->madv == MSM_MADV_WILLNEED) && msm_obj->sgt &&
+			msm_obj->cache_ctx && !msm_obj->vram_node &&
+			!(msm_obj->flags & MSM_BO_SCANOUT) &&
+			!atomic_read(&msm_obj->pin_count) &&
+			!msm_obj->vmap_count && !is_active(msm_obj) &&
+			!msm_obj->base.dma_buf && !msm_obj->base.import_attach;
+}
+
+/* A bo table registered once and referenced by later submits: */
+struct msm_gem_bo_list {
+	unsigned int nr_bos;
+	struct {
+		uint32_t flags;
+		struct msm_gem_object *obj;
+		uint32_t iova;  /* address as of the last submit */
+	} bos[0];
+};
+
 /* Created per submit-ioctl, to track bo's and cmdstream bufs, etc,
  * associated with the cmdstream submission for synchronization (and
  * make it easier to unwind when things go wrong, etc).  This only
@@ -18,6 +18,10 @@
 #include "msm_drv.h"
 #include "msm_gem.h"
 
+static bool swap_out;
+MODULE_PARM_DESC(swap_out, "Swap out idle userspace bo's under memory pressure, not just purge");
+module_param_named(swap_out, swap_out, bool, 0600);
+
 static bool mutex_is_locked_by(struct mutex *mutex, struct task_struct *task)
 {
 	if (!mutex_is_locked(mutex))
@@ -58,8 +62,11 @@ msm_gem_shrinker_count(struct shrinker *shrinker, struct shrink_control *sc)
 	if (!msm_gem_shrinker_lock(dev, &unlock))
 		return 0;
 
+	count = priv->bo_cache_size >> PAGE_SHIFT;
+
 	list_for_each_entry(msm_obj, &priv->inactive_list, mm_list) {
-		if (is_purgeable(msm_obj))
+		if (is_purgeable(msm_obj) ||
+				(swap_out && is_swappable(msm_obj)))
 			count += msm_obj->base.size >> PAGE_SHIFT;
 	}
 
@@ -76,12 +83,15 @@ msm_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 		container_of(shrinker, struct msm_drm_private, shrinker);
 	struct drm_device *dev = priv->dev;
 	struct msm_gem_object *msm_obj;
-	unsigned long freed = 0;
+	unsigned long freed = 0, swapped = 0;
 	bool unlock;
 
 	if (!msm_gem_shrinker_lock(dev, &unlock))
 		return SHRINK_STOP;
 
+	/* recycled bo's are the cheapest to give back */
+	freed = msm_gem_cache_shrink(dev, sc->nr_to_scan);
+
 	list_for_each_entry(msm_obj, &priv->inactive_list, mm_list) {
 		if (freed >= sc->nr_to_scan)
 			break;
@@ -91,11 +101,26 @@ msm_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 		}
 	}
 
+	/* inactive_list is in order of retirement, so oldest idle go first */
+	list_for_each_entry(msm_obj, &priv->inactive_list, mm_list) {
+		if (!swap_out || freed + swapped >= sc->nr_to_scan)
+			break;
+		if (is_swappable(msm_obj)) {
+			msm_gem_swap_out(&msm_obj->base);
+			swapped += msm_obj->base.size >> PAGE_SHIFT;
+		}
+	}
+
 	if (unlock)
 		mutex_unlock(&dev->struct_mutex);
 
 	if (freed > 0)
 		pr_info_ratelimited("Purging %lu bytes\n", freed << PAGE_SHIFT);
+	if (swapped > 0)
+		pr_info_ratelimited("Swapping out %lu bytes\n",
+				swapped << PAGE_SHIFT);
+
+	freed += swapped;
 
 	return freed;
 }
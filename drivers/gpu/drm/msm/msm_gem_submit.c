@@ -156,6 +156,30 @@ out:
 	return ret;
 }
 
+/* same as submit_lookup_objects(), from a table validated at registration */
+static int submit_lookup_bo_list(struct msm_gem_submit *submit,
+		struct msm_gem_bo_list *list)
+{
+	unsigned i;
+
+	for (i = 0; i < list->nr_bos; i++) {
+		struct msm_gem_object *msm_obj = list->bos[i].obj;
+
+		submit->bos[i].flags = list->bos[i].flags;
+		submit->bos[i].iova  = list->bos[i].iova;
+
+		drm_gem_object_reference(&msm_obj->base);
+
+		submit->bos[i].obj = msm_obj;
+
+		list_add_tail(&msm_obj->submit_entry, &submit->bo_list);
+	}
+
+	submit->nr_bos = i;
+
+	return 0;
+}
+
 static void submit_unlock_unpin_bo(struct msm_gem_submit *submit, int i)
 {
 	struct msm_gem_object *msm_obj = submit->bos[i].obj;
@@ -379,6 +403,150 @@ static void submit_cleanup(struct msm_gem_submit *submit)
 	ww_acquire_fini(&submit->ticket);
 }
 
+static void bo_list_free(struct msm_gem_bo_list *list)
+{
+	unsigned i;
+
+	for (i = 0; i < list->nr_bos; i++)
+		drm_gem_object_unreference(&list->bos[i].obj->base);
+
+	kfree(list);
+}
+
+/* the table is copied in before struct_mutex is taken, see msm_gem_fault() */
+static int bo_list_create(struct drm_file *file,
+		struct drm_msm_gem_submit_bo *bos, uint32_t nr_bos, uint32_t *handle)
+{
+	struct msm_file_private *ctx = file->driver_priv;
+	struct msm_gem_bo_list *list;
+	LIST_HEAD(seen);
+	unsigned i;
+	int ret = 0;
+
+	list = kzalloc(sizeof(*list) + nr_bos * sizeof(list->bos[0]),
+			GFP_KERNEL | __GFP_NOWARN);
+	if (!list)
+		return -ENOMEM;
+
+	for (i = 0; i < nr_bos; i++) {
+		struct drm_gem_object *obj;
+
+		if ((bos[i].flags & ~MSM_SUBMIT_BO_FLAGS) ||
+			!(bos[i].flags & MSM_SUBMIT_BO_FLAGS)) {
+			DRM_ERROR("invalid flags: %x\n", bos[i].flags);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		obj = drm_gem_object_lookup(file, bos[i].handle);
+		if (!obj) {
+			DRM_ERROR("invalid handle %u at index %u\n", bos[i].handle, i);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		list->bos[i].flags = bos[i].flags;
+		list->bos[i].iova  = bos[i].presumed;
+		list->bos[i].obj   = to_msm_bo(obj);
+		list->nr_bos = i + 1;
+
+		/* submit_entry is not in use by a submit under struct_mutex: */
+		if (!list_empty(&list->bos[i].obj->submit_entry)) {
+			DRM_ERROR("handle %u at index %u already on bo list\n",
+					bos[i].handle, i);
+			ret = -EINVAL;
+			goto out;
+		}
+		list_add_tail(&list->bos[i].obj->submit_entry, &seen);
+	}
+
+	ret = idr_alloc(&ctx->bo_lists, list, 1, 0, GFP_KERNEL);
+	if (ret > 0) {
+		*handle = ret;
+		ret = 0;
+	}
+
+out:
+	for (i = 0; i < list->nr_bos; i++)
+		list_del_init(&list->bos[i].obj->submit_entry);
+	if (ret)
+		bo_list_free(list);
+
+	return ret;
+}
+
+int msm_ioctl_gem_bo_list(struct drm_device *dev, void *data,
+		struct drm_file *file)
+{
+	struct msm_file_private *ctx = file->driver_priv;
+	struct drm_msm_gem_bo_list *args = data;
+	struct drm_msm_gem_submit_bo *bos = NULL;
+	struct msm_gem_bo_list *list;
+	int ret;
+
+	if (args->pad)
+		return -EINVAL;
+
+	if (args->op == MSM_BO_LIST_CREATE) {
+		if (!args->nr_bos)
+			return -EINVAL;
+
+		bos = drm_malloc_ab(args->nr_bos, sizeof(*bos));
+		if (!bos)
+			return -ENOMEM;
+
+		if (copy_from_user(bos, u64_to_user_ptr(args->bos),
+				args->nr_bos * sizeof(*bos))) {
+			ret = -EFAULT;
+			goto out_free;
+		}
+	}
+
+	ret = mutex_lock_interruptible(&dev->struct_mutex);
+	if (ret)
+		goto out_free;
+
+	switch (args->op) {
+	case MSM_BO_LIST_CREATE:
+		ret = bo_list_create(file, bos, args->nr_bos, &args->handle);
+		break;
+	case MSM_BO_LIST_DESTROY:
+		list = idr_find(&ctx->bo_lists, args->handle);
+		if (list) {
+			idr_remove(&ctx->bo_lists, args->handle);
+			bo_list_free(list);
+		} else {
+			ret = -EINVAL;
+		}
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	mutex_unlock(&dev->struct_mutex);
+
+out_free:
+	drm_free_large(bos);
+	return ret;
+}
+
+static int bo_list_release(int id, void *p, void *data)
+{
+	bo_list_free(p);
+	return 0;
+}
+
+/* drop the bo lists of a file that is being closed, under struct_mutex */
+void msm_gem_bo_lists_release(struct drm_device *dev,
+		struct msm_file_private *ctx)
+{
+	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
+
+	idr_for_each(&ctx->bo_lists, bo_list_release, NULL);
+	idr_destroy(&ctx->bo_lists);
+}
+
 int msm_ioctl_gem_submit(struct drm_device *dev, void *data,
 		struct drm_file *file)
 {
@@ -386,6 +554,7 @@ int msm_ioctl_gem_submit(struct drm_device *dev, void *data,
 	struct drm_msm_gem_submit *args = data;
 	struct msm_file_private *ctx = file->driver_priv;
 	struct msm_gem_submit *submit;
+	struct msm_gem_bo_list *bo_list = NULL;
 	struct msm_gpu *gpu = priv->gpu;
 	struct fence *in_fence = NULL;
 	struct sync_file *sync_file = NULL;
@@ -424,7 +593,17 @@ int msm_ioctl_gem_submit(struct drm_device *dev, void *data,
 		goto out_unlock;
 	}
 
-	ret = submit_lookup_objects(submit, args, file);
+	if (args->flags & MSM_SUBMIT_BO_LIST) {
+		bo_list = idr_find(&ctx->bo_lists, (u32)args->bos);
+		if (!bo_list || bo_list->nr_bos != args->nr_bos) {
+			DRM_ERROR("invalid bo list %llu\n", args->bos);
+			ret = -EINVAL;
+			goto out;
+		}
+		ret = submit_lookup_bo_list(submit, bo_list);
+	} else {
+		ret = submit_lookup_objects(submit, args, file);
+	}
 	if (ret)
 		goto out;
 
@@ -540,6 +719,12 @@ int msm_ioctl_gem_submit(struct drm_device *dev, void *data,
 
 	msm_gpu_submit(gpu, submit, ctx);
 
+	/* the addresses the cmdstream now holds are presumed next time: */
+	if (bo_list) {
+		for (i = 0; i < submit->nr_bos; i++)
+			bo_list->bos[i].iova = submit->bos[i].iova;
+	}
+
 	args->fence = submit->fence->seqno;
 
 	if (args->flags & MSM_SUBMIT_FENCE_FD_OUT) {
@@ -354,6 +354,14 @@ static void hangcheck_handler(unsigned long data)
  * Performance Counters:
  */
 
+static void read_hw_cntrs(struct msm_gpu *gpu, uint32_t *cntrs)
+{
+	int i;
+
+	for (i = 0; i < gpu->num_perfcntrs; i++)
+		cntrs[i] = gpu_read(gpu, gpu->perfcntrs[i].sample_reg);
+}
+
 /* called under perf_lock */
 static int update_hw_cntrs(struct msm_gpu *gpu, uint32_t ncntrs, uint32_t *cntrs)
 {
@@ -361,8 +369,7 @@ static int update_hw_cntrs(struct msm_gpu *gpu, uint32_t ncntrs, uint32_t *cntrs
 	int i, n = min(ncntrs, gpu->num_perfcntrs);
 
 	/* read current values: */
-	for (i = 0; i < gpu->num_perfcntrs; i++)
-		current_cntrs[i] = gpu_read(gpu, gpu->perfcntrs[i].sample_reg);
+	read_hw_cntrs(gpu, current_cntrs);
 
 	/* update cntrs: */
 	for (i = 0; i < n; i++)
@@ -445,6 +452,78 @@ out:
 	return ret;
 }
 
+/*
+ * Per process attribution:
+ */
+
+static struct msm_gpu_proc_stats *get_proc_stats(struct msm_gpu *gpu,
+		struct msm_gem_submit *submit)
+{
+	struct msm_gpu_proc_stats *stats;
+	struct task_struct *task;
+	struct pid *tgid;
+
+	rcu_read_lock();
+	task = pid_task(submit->pid, PIDTYPE_PID);
+	tgid = get_pid(task ? task_tgid(task) : submit->pid);
+	rcu_read_unlock();
+
+	list_for_each_entry(stats, &gpu->proc_stats, node) {
+		if (stats->tgid == tgid) {
+			put_pid(tgid);
+			list_move(&stats->node, &gpu->proc_stats);
+			return stats;
+		}
+	}
+
+	/* recycle the process that was retired least recently: */
+	if (gpu->nr_proc_stats >= MSM_GPU_MAX_PROC_STATS) {
+		stats = list_last_entry(&gpu->proc_stats,
+				struct msm_gpu_proc_stats, node);
+		list_del(&stats->node);
+		put_pid(stats->tgid);
+		memset(stats, 0, sizeof(*stats));
+	} else {
+		stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+		if (!stats) {
+			put_pid(tgid);
+			return NULL;
+		}
+		gpu->nr_proc_stats++;
+	}
+
+	stats->tgid = tgid;
+	rcu_read_lock();
+	task = pid_task(tgid, PIDTYPE_PID);
+	if (task)
+		get_task_comm(stats->comm, task);
+	rcu_read_unlock();
+	list_add(&stats->node, &gpu->proc_stats);
+
+	return stats;
+}
+
+static void account_submit(struct msm_gpu *gpu, struct msm_gem_submit *submit)
+{
+	struct msm_gpu_proc_stats *stats;
+	uint32_t cntrs[ARRAY_SIZE(gpu->last_retire.cntrs)];
+	ktime_t time = ktime_get();
+	int i;
+
+	read_hw_cntrs(gpu, cntrs);
+
+	stats = get_proc_stats(gpu, submit);
+	if (stats) {
+		stats->submits++;
+		stats->busy_us += ktime_us_delta(time, gpu->last_retire.time);
+		for (i = 0; i < gpu->num_perfcntrs; i++)
+			stats->cntrs[i] += cntrs[i] - gpu->last_retire.cntrs[i];
+	}
+
+	gpu->last_retire.time = time;
+	memcpy(gpu->last_retire.cntrs, cntrs, sizeof(cntrs));
+}
+
 /*
  * Cmdstream submission/retirement:
  */
@@ -453,6 +532,8 @@ static void retire_submit(struct msm_gpu *gpu, struct msm_gem_submit *submit)
 {
 	int i;
 
+	account_submit(gpu, submit);
+
 	for (i = 0; i < submit->nr_bos; i++) {
 		struct msm_gem_object *msm_obj = submit->bos[i].obj;
 		/* move to inactive: */
@@ -522,6 +603,12 @@ void msm_gpu_submit(struct msm_gpu *gpu, struct msm_gem_submit *submit,
 
 	inactive_cancel(gpu);
 
+	/* an idle gpu starts accounting with this submit: */
+	if (list_empty(&gpu->submit_list)) {
+		gpu->last_retire.time = ktime_get();
+		read_hw_cntrs(gpu, gpu->last_retire.cntrs);
+	}
+
 	list_add_tail(&submit->node, &gpu->submit_list);
 
 	msm_rd_dump_submit(submit);
@@ -595,6 +682,7 @@ int msm_gpu_init(struct drm_device *drm, struct platform_device *pdev,
 	INIT_WORK(&gpu->recover_work, recover_worker);
 
 	INIT_LIST_HEAD(&gpu->submit_list);
+	INIT_LIST_HEAD(&gpu->proc_stats);
 
 	setup_timer(&gpu->inactive_timer, inactive_handler,
 			(unsigned long)gpu);
@@ -697,10 +785,17 @@ fail:
 
 void msm_gpu_cleanup(struct msm_gpu *gpu)
 {
+	struct msm_gpu_proc_stats *stats, *tmp;
+
 	DBG("%s", gpu->name);
 
 	WARN_ON(!list_empty(&gpu->active_list));
 
+	list_for_each_entry_safe(stats, tmp, &gpu->proc_stats, node) {
+		put_pid(stats->tgid);
+		kfree(stats);
+	}
+
 	bs_fini(gpu);
 
 	if (gpu->rb) {
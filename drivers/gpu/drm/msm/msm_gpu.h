@@ -78,6 +78,14 @@ struct msm_gpu {
 	const struct msm_gpu_perfcntr *perfcntrs;
 	uint32_t num_perfcntrs;
 
+	/* per process attribution of retired submits, under struct_mutex: */
+	struct {
+		ktime_t time;
+		uint32_t cntrs[5];
+	} last_retire;
+	struct list_head proc_stats;
+	unsigned int nr_proc_stats;
+
 	/* ringbuffer: */
 	struct msm_ringbuffer *rb;
 	uint32_t rb_iova;
@@ -143,6 +151,22 @@ struct msm_gpu_perfcntr {
 	const char *name;
 };
 
+/* Busy time and perf-counter deltas of the retired submits of a process.
+ * A submit is accounted from the later of its own submission and the
+ * retirement of the previous submit until it is retired, the ringbuffer
+ * executes submits in order.
+ */
+#define MSM_GPU_MAX_PROC_STATS 32
+
+struct msm_gpu_proc_stats {
+	struct list_head node;
+	struct pid *tgid;
+	char comm[TASK_COMM_LEN];
+	uint64_t submits;
+	uint64_t busy_us;
+	uint64_t cntrs[5];
+};
+
 static inline void gpu_write(struct msm_gpu *gpu, u32 reg, u32 data)
 {
 	msm_writel(data, gpu->mmio + (reg << 2));
@@ -21,6 +21,12 @@
  *
  * This will enable performance counters/profiling to track the busy time
  * and any gpu specific performance counters that are supported.
+ *
+ * The same busy time and counters are also attributed to the processes
+ * whose submits were running, continuously and without opening the file
+ * above:
+ *
+ *   cat /sys/kernel/debug/dri/<minor>/perf_proc
  */
 
 #ifdef CONFIG_DEBUG_FS
@@ -128,6 +134,34 @@ static int refill_buf(struct msm_perf_state *perf)
 	return 0;
 }
 
+/* called under struct_mutex */
+int msm_perf_proc_show(struct drm_device *dev, struct seq_file *m)
+{
+	struct msm_drm_private *priv = dev->dev_private;
+	struct msm_gpu *gpu = priv->gpu;
+	struct msm_gpu_proc_stats *stats;
+	int i;
+
+	if (!gpu)
+		return 0;
+
+	seq_printf(m, "%8s %-16s %10s %14s", "PID", "COMM", "SUBMITS",
+			"BUSY_US");
+	for (i = 0; i < gpu->num_perfcntrs; i++)
+		seq_printf(m, " %14s", gpu->perfcntrs[i].name);
+	seq_puts(m, "\n");
+
+	list_for_each_entry(stats, &gpu->proc_stats, node) {
+		seq_printf(m, "%8d %-16s %10llu %14llu", pid_nr(stats->tgid),
+				stats->comm, stats->submits, stats->busy_us);
+		for (i = 0; i < gpu->num_perfcntrs; i++)
+			seq_printf(m, " %14llu", stats->cntrs[i]);
+		seq_puts(m, "\n");
+	}
+
+	return 0;
+}
+
 static ssize_t perf_read(struct file *file, char __user *buf,
 		size_t sz, loff_t *ppos)
 {
@@ -32,6 +32,16 @@
  * all (non-written) buffers in the submit, rather than just cmdstream bo's.
  * This is useful to capture the contents of (for example) vbo's or textures,
  * or shader programs (if not emitted inline in cmdstream).
+ *
+ * The debugfs "rd" fifo blocks submission while the reader falls behind.
+ * For capturing production workloads, "rd_ring" can be opened and mmap'ed
+ * instead: the first page holds a struct rd_ring_hdr, followed by a data
+ * ring of hdr->size bytes holding the same section stream.  The kernel only
+ * advances hdr->head after a whole submit is written, and drops the submit
+ * (counting it in hdr->dropped) rather than waiting when it doesn't fit.
+ * The reader consumes from hdr->tail, stores the new tail back and can
+ * poll() for more data.  The module-param "rd_sample" restricts capture to
+ * every Nth submit in either mode.
  */
 
 #ifdef CONFIG_DEBUG_FS
@@ -40,6 +50,9 @@
 #include <linux/debugfs.h>
 #include <linux/circ_buf.h>
 #include <linux/wait.h>
+#include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/log2.h>
 
 #include "msm_drv.h"
 #include "msm_gpu.h"
@@ -49,6 +62,14 @@ static bool rd_full = false;
 MODULE_PARM_DESC(rd_full, "If true, $debugfs/.../rd will snapshot all buffer contents");
 module_param_named(rd_full, rd_full, bool, 0600);
 
+static uint rd_sample = 1;
+MODULE_PARM_DESC(rd_sample, "Only capture every Nth submit");
+module_param_named(rd_sample, rd_sample, uint, 0600);
+
+static uint rd_ring_kb = 4096;
+MODULE_PARM_DESC(rd_ring_kb, "Size of the $debugfs/.../rd_ring buffer in KiB");
+module_param_named(rd_ring_kb, rd_ring_kb, uint, 0600);
+
 enum rd_sect_type {
 	RD_NONE,
 	RD_TEST,       /* ascii text */
@@ -68,6 +89,14 @@ enum rd_sect_type {
 
 #define BUF_SZ 512  /* should be power of 2 */
 
+/* shared with the reader in the first page of the rd_ring mapping */
+struct rd_ring_hdr {
+	uint32_t head;		/* written by kernel once a submit is complete */
+	uint32_t tail;		/* written by reader */
+	uint32_t size;		/* size of the data ring, power of 2 */
+	uint32_t dropped;	/* submits dropped because the ring was full */
+};
+
 /* space used: */
 #define circ_count(circ) \
 	(CIRC_CNT((circ)->head, (circ)->tail, BUF_SZ))
@@ -85,6 +114,7 @@ struct msm_rd_state {
 	bool open;
 
 	struct dentry *ent;
+	struct dentry *ring_ent;
 	struct drm_info_node *node;
 
 	/* current submit to read out: */
@@ -101,8 +131,44 @@ struct msm_rd_state {
 	struct circ_buf fifo;
 
 	char buf[BUF_SZ];
+
+	/* rd_ring state, also protected by struct_mutex: */
+	void *ring;
+	uint32_t ring_size;
+	uint32_t ring_head;	/* kernel's unpublished head */
+
+	/* when set, writes only account their size into ring_need */
+	bool measure;
+	uint32_t ring_need;
+
+	uint32_t nr_submits;
 };
 
+static void rd_ring_write(struct msm_rd_state *rd, const void *buf, int sz)
+{
+	char *data = rd->ring + PAGE_SIZE;
+	const char *ptr = buf;
+
+	while (sz > 0) {
+		uint32_t off = rd->ring_head & (rd->ring_size - 1);
+		int n = min_t(int, sz, rd->ring_size - off);
+
+		memcpy(data + off, ptr, n);
+
+		rd->ring_head += n;
+		sz  -= n;
+		ptr += n;
+	}
+}
+
+static void rd_ring_publish(struct msm_rd_state *rd)
+{
+	struct rd_ring_hdr *hdr = rd->ring;
+
+	smp_store_release(&hdr->head, rd->ring_head);
+	wake_up_all(&rd->fifo_event);
+}
+
 static void rd_write(struct msm_rd_state *rd, const void *buf, int sz)
 {
 	struct circ_buf *fifo;
@@ -111,6 +177,14 @@ static void rd_write(struct msm_rd_state *rd, const void *buf, int sz)
 	if (!rd || !buf)
 		return;
 
+	if (rd->measure) {
+		rd->ring_need += sz;
+		return;
+	} else if (rd->ring) {
+		rd_ring_write(rd, buf, sz);
+		return;
+	}
+
 	fifo = &rd->fifo;
 	while (sz > 0) {
 		char *fptr = &fifo->buf[fifo->head];
@@ -179,7 +253,8 @@ out:
 	return n;
 }
 
-static int rd_open(struct inode *inode, struct file *file)
+static int rd_start(struct inode *inode, struct file *file,
+		void *ring, uint32_t ring_size)
 {
 	struct msm_rd_state *rd;
 	struct drm_device *dev;
@@ -213,10 +288,17 @@ static int rd_open(struct inode *inode, struct file *file)
 
 	file->private_data = rd;
 	rd->open = true;
+	rd->nr_submits = 0;
 
 	/* Reset fifo to clear any previously unread data: */
 	rd->fifo.head = rd->fifo.tail = 0;
 
+	rd->ring = ring;
+	rd->ring_size = ring_size;
+	rd->ring_head = 0;
+	if (ring)
+		((struct rd_ring_hdr *)ring)->size = ring_size;
+
 	/* the parsing tools need to know gpu-id to know which
 	 * register database to load.
 	 */
@@ -224,12 +306,19 @@ static int rd_open(struct inode *inode, struct file *file)
 	gpu_id = val;
 
 	rd_write_section(rd, RD_GPU_ID, &gpu_id, sizeof(gpu_id));
+	if (ring)
+		rd_ring_publish(rd);
 
 out:
 	mutex_unlock(&dev->struct_mutex);
 	return ret;
 }
 
+static int rd_open(struct inode *inode, struct file *file)
+{
+	return rd_start(inode, file, NULL, 0);
+}
+
 static int rd_release(struct inode *inode, struct file *file)
 {
 	struct msm_rd_state *rd;
@@ -245,6 +334,70 @@ static int rd_release(struct inode *inode, struct file *file)
 	return 0;
 }
 
+static int rd_ring_open(struct inode *inode, struct file *file)
+{
+	uint32_t size;
+	void *ring;
+	int ret;
+
+	size = roundup_pow_of_two(max_t(uint, rd_ring_kb, 64) * SZ_1K);
+
+	ring = vmalloc_user(PAGE_SIZE + size);
+	if (!ring)
+		return -ENOMEM;
+
+	ret = rd_start(inode, file, ring, size);
+	if (ret)
+		vfree(ring);
+
+	return ret;
+}
+
+static int rd_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct msm_rd_state *rd = file->private_data;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start > PAGE_SIZE + rd->ring_size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, rd->ring, 0);
+}
+
+static unsigned int rd_ring_poll(struct file *file, poll_table *wait)
+{
+	struct msm_rd_state *rd = file->private_data;
+	struct rd_ring_hdr *hdr = rd->ring;
+
+	poll_wait(file, &rd->fifo_event, wait);
+
+	if (READ_ONCE(hdr->head) != READ_ONCE(hdr->tail))
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
+static int rd_ring_release(struct inode *inode, struct file *file)
+{
+	struct msm_rd_state *rd;
+	void *ring;
+
+	if (!inode || !inode->i_private)
+		return -EINVAL;
+
+	rd = inode->i_private;
+
+	/* producers run under struct_mutex, so they are done with the ring */
+	mutex_lock(&rd->dev->struct_mutex);
+	ring = rd->ring;
+	rd->ring = NULL;
+	rd->open = false;
+	mutex_unlock(&rd->dev->struct_mutex);
+
+	vfree(ring);
+
+	return 0;
+}
 
 static const struct file_operations rd_debugfs_fops = {
 	.owner = THIS_MODULE,
@@ -254,6 +407,15 @@ static const struct file_operations rd_debugfs_fops = {
 	.release = rd_release,
 };
 
+static const struct file_operations rd_ring_debugfs_fops = {
+	.owner = THIS_MODULE,
+	.open = rd_ring_open,
+	.mmap = rd_ring_mmap,
+	.poll = rd_ring_poll,
+	.llseek = no_llseek,
+	.release = rd_ring_release,
+};
+
 int msm_rd_debugfs_init(struct drm_minor *minor)
 {
 	struct msm_drm_private *priv;
@@ -292,6 +454,14 @@ int msm_rd_debugfs_init(struct drm_minor *minor)
 		goto fail;
 	}
 
+	rd->ring_ent = debugfs_create_file("rd_ring", S_IFREG | S_IRUSR,
+			minor->debugfs_root, rd, &rd_ring_debugfs_fops);
+	if (!rd->ring_ent) {
+		DRM_ERROR("Cannot create /sys/kernel/debug/dri/%pd/rd_ring\n",
+				minor->debugfs_root);
+		goto fail;
+	}
+
 	rd->node->minor = minor;
 	rd->node->dent  = rd->ent;
 	rd->node->info_ent = NULL;
@@ -323,6 +493,7 @@ void msm_rd_debugfs_cleanup(struct drm_minor *minor)
 
 	priv->rd = NULL;
 
+	debugfs_remove(rd->ring_ent);
 	debugfs_remove(rd->ent);
 
 	if (rd->node) {
@@ -343,52 +514,36 @@ static void snapshot_buf(struct msm_rd_state *rd,
 {
 	struct msm_gem_object *obj = submit->bos[idx].obj;
 	const char *buf;
-
-	buf = msm_gem_get_vaddr_locked(&obj->base);
-	if (IS_ERR(buf))
-		return;
+	uint32_t offset = 0;
 
 	if (iova) {
-		buf += iova - submit->bos[idx].iova;
+		offset = iova - submit->bos[idx].iova;
 	} else {
 		iova = submit->bos[idx].iova;
 		size = obj->base.size;
 	}
 
+	/* sizing pass for the ring doesn't need the contents */
+	if (rd->measure) {
+		rd->ring_need += 16 + 8 + size;
+		return;
+	}
+
+	buf = msm_gem_get_vaddr_locked(&obj->base);
+	if (IS_ERR(buf))
+		return;
+
 	rd_write_section(rd, RD_GPUADDR,
 			(uint32_t[2]){ iova, size }, 8);
-	rd_write_section(rd, RD_BUFFER_CONTENTS, buf, size);
+	rd_write_section(rd, RD_BUFFER_CONTENTS, buf + offset, size);
 
 	msm_gem_put_vaddr_locked(&obj->base);
 }
 
-/* called under struct_mutex */
-void msm_rd_dump_submit(struct msm_gem_submit *submit)
+static void rd_write_submit(struct msm_rd_state *rd,
+		struct msm_gem_submit *submit, const char *msg, int n)
 {
-	struct drm_device *dev;
-	struct msm_drm_private *priv;
-	struct msm_rd_state *rd;
-	char msg[128];
-	int i, n;
-
-	if (!submit || !submit->dev || !submit->dev->dev_private)
-		return;
-
-	dev = submit->dev;
-	priv = dev->dev_private;
-	rd = priv->rd;
-
-	if (!rd || !rd->open)
-		return;
-
-	/* writing into fifo is serialized by caller, and
-	 * rd->read_lock is used to serialize the reads
-	 */
-	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
-
-	n = snprintf(msg, sizeof(msg), "%.*s/%d: fence=%u",
-			TASK_COMM_LEN, current->comm, task_pid_nr(current),
-			submit->fence->seqno);
+	int i;
 
 	rd_write_section(rd, RD_CMD, msg, ALIGN(n, 4));
 
@@ -429,4 +584,58 @@ void msm_rd_dump_submit(struct msm_gem_submit *submit)
 		}
 	}
 }
+
+/* called under struct_mutex */
+void msm_rd_dump_submit(struct msm_gem_submit *submit)
+{
+	struct drm_device *dev;
+	struct msm_drm_private *priv;
+	struct msm_rd_state *rd;
+	struct rd_ring_hdr *hdr;
+	char msg[128];
+	int n;
+
+	if (!submit || !submit->dev || !submit->dev->dev_private)
+		return;
+
+	dev = submit->dev;
+	priv = dev->dev_private;
+	rd = priv->rd;
+
+	if (!rd || !rd->open)
+		return;
+
+	/* writing into fifo is serialized by caller, and
+	 * rd->read_lock is used to serialize the reads
+	 */
+	WARN_ON(!mutex_is_locked(&dev->struct_mutex));
+
+	if (rd_sample > 1 && (rd->nr_submits++ % rd_sample))
+		return;
+
+	n = snprintf(msg, sizeof(msg), "%.*s/%d: fence=%u",
+			TASK_COMM_LEN, current->comm, task_pid_nr(current),
+			submit->fence->seqno);
+
+	if (!rd->ring) {
+		rd_write_submit(rd, submit, msg, n);
+		return;
+	}
+
+	/* size the submit first, so it is either logged whole or dropped */
+	hdr = rd->ring;
+	rd->measure = true;
+	rd->ring_need = 0;
+	rd_write_submit(rd, submit, msg, n);
+	rd->measure = false;
+
+	if (rd->ring_need > rd->ring_size -
+			(rd->ring_head - smp_load_acquire(&hdr->tail))) {
+		WRITE_ONCE(hdr->dropped, hdr->dropped + 1);
+		return;
+	}
+
+	rd_write_submit(rd, submit, msg, n);
+	rd_ring_publish(rd);
+}
 #endif
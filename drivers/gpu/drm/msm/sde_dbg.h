@@ -16,6 +16,8 @@
 #include <stdarg.h>
 #include <linux/debugfs.h>
 #include <linux/list.h>
+#include <linux/mutex.h>
+#include <asm/local.h>
 
 /* select an uncommon hex value for the limiter */
 #define SDE_EVTLOG_DATA_LIMITER	(0xC0DEBEEF)
@@ -49,10 +51,14 @@ enum sde_dbg_dump_flag {
 	SDE_DBG_DUMP_IN_MEM = BIT(1),
 };
 
+/*
+ * Logging is per-cpu and lock free, so critical events are cheap enough to
+ * keep on in production builds.
+ */
 #ifdef CONFIG_DRM_SDE_EVTLOG_DEBUG
 #define SDE_EVTLOG_DEFAULT_ENABLE (SDE_EVTLOG_CRITICAL | SDE_EVTLOG_IRQ)
 #else
-#define SDE_EVTLOG_DEFAULT_ENABLE 0
+#define SDE_EVTLOG_DEFAULT_ENABLE SDE_EVTLOG_CRITICAL
 #endif
 
 /*
@@ -63,11 +69,10 @@ enum sde_dbg_dump_flag {
 #define SDE_EVTLOG_PRINT_ENTRY	256
 
 /*
- * evtlog keeps this number of entries in memory for debug purpose. This
- * number must be greater than print entry to prevent out of bound evtlog
- * entry array access.
+ * evtlog keeps this number of entries in memory per cpu for debug purpose.
+ * This number must be a power of two and no less than print entry.
  */
-#define SDE_EVTLOG_ENTRY	(SDE_EVTLOG_PRINT_ENTRY * 8)
+#define SDE_EVTLOG_CPU_ENTRY	(SDE_EVTLOG_PRINT_ENTRY * 2)
 #define SDE_EVTLOG_MAX_DATA 15
 #define SDE_EVTLOG_BUF_MAX 512
 #define SDE_EVTLOG_BUF_ALIGN 32
@@ -85,21 +90,36 @@ struct sde_dbg_evtlog_log {
 	u32 data[SDE_EVTLOG_MAX_DATA];
 	u32 data_cnt;
 	int pid;
+	u32 seq;
 };
 
 /**
+ * @head: Number of entries ever reserved on this cpu
+ * @first: Index of next entry to be output during evtlog dumps
  * @last_dump: Index of last entry to be output during evtlog dumps
- * @filter_list: Linked list of currently active filter strings
+ * @limit: Oldest pending entry while trimming a dump to the print count
  */
-struct sde_dbg_evtlog {
-	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_ENTRY];
+struct sde_dbg_evtlog_ring {
+	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_CPU_ENTRY];
+	local_t head;
 	u32 first;
-	u32 last;
 	u32 last_dump;
-	u32 curr;
-	u32 next;
+	u32 limit;
+};
+
+/**
+ * @rings: Per-cpu entry rings, written without any lock
+ * @prev_time: Timestamp of the last entry output, for the dump delta
+ * @spin_lock: Serializes evtlog dumps
+ * @filter_lock: Serializes filter list updates
+ * @filter_list: RCU list of currently active filter strings
+ */
+struct sde_dbg_evtlog {
+	struct sde_dbg_evtlog_ring **rings;
+	s64 prev_time;
 	u32 enable;
 	spinlock_t spin_lock;
+	struct mutex filter_lock;
 	struct list_head filter_list;
 };
 
@@ -19,6 +19,7 @@
 #include <linux/uaccess.h>
 #include <linux/dma-buf.h>
 #include <linux/slab.h>
+#include <linux/rculist.h>
 
 #include "sde_dbg.h"
 #include "sde_trace.h"
@@ -30,8 +31,8 @@ struct sde_evtlog_filter {
 	char filter[SDE_EVTLOG_FILTER_STRSIZE];
 };
 
-static bool _sde_evtlog_is_filtered_no_lock(
-		struct sde_dbg_evtlog *evtlog, const char *str)
+static bool _sde_evtlog_is_filtered(struct sde_dbg_evtlog *evtlog,
+		const char *str)
 {
 	struct sde_evtlog_filter *filter_node;
 	size_t len;
@@ -40,18 +41,23 @@ static bool _sde_evtlog_is_filtered_no_lock(
 	if (!str)
 		return true;
 
+	if (list_empty(&evtlog->filter_list))
+		return false;
+
 	len = strlen(str);
 
 	/*
 	 * Filter the incoming string IFF the list is not empty AND
 	 * a matching entry is not in the list.
 	 */
+	rcu_read_lock();
 	rc = !list_empty(&evtlog->filter_list);
-	list_for_each_entry(filter_node, &evtlog->filter_list, list)
+	list_for_each_entry_rcu(filter_node, &evtlog->filter_list, list)
 		if (strnstr(str, filter_node->filter, len)) {
 			rc = false;
 			break;
 		}
+	rcu_read_unlock();
 
 	return rc;
 }
@@ -64,10 +70,11 @@ bool sde_evtlog_is_enabled(struct sde_dbg_evtlog *evtlog, u32 flag)
 void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 		int flag, ...)
 {
-	unsigned long flags;
+	struct sde_dbg_evtlog_ring *ring;
 	int i, val = 0;
 	va_list args;
 	struct sde_dbg_evtlog_log *log;
+	u32 idx;
 
 	if (!evtlog)
 		return;
@@ -75,13 +82,22 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	if (!sde_evtlog_is_enabled(evtlog, flag))
 		return;
 
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
+	if (_sde_evtlog_is_filtered(evtlog, name))
+		return;
 
-	if (_sde_evtlog_is_filtered_no_lock(evtlog, name))
-		goto exit;
+	/*
+	 * Each cpu only writes its own ring. An interrupt landing on top of
+	 * this writer simply reserves the next slot, and the sequence stamp
+	 * tells dumps whether a slot is complete.
+	 */
+	ring = evtlog->rings[get_cpu()];
+	idx = (u32)local_inc_return(&ring->head) - 1;
+	log = &ring->logs[idx & (SDE_EVTLOG_CPU_ENTRY - 1)];
 
-	log = &evtlog->logs[evtlog->curr];
-	log->time = ktime_to_us(ktime_get());
+	WRITE_ONCE(log->seq, 0);
+	smp_wmb();
+
+	log->time = ktime_get_ns();
 	log->name = name;
 	log->line = line;
 	log->data_cnt = 0;
@@ -98,43 +114,99 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	}
 	va_end(args);
 	log->data_cnt = i;
-	evtlog->curr = (evtlog->curr + 1) % SDE_EVTLOG_ENTRY;
-	evtlog->last++;
+
+	smp_wmb();
+	WRITE_ONCE(log->seq, idx + 1);
 
 	trace_sde_evtlog(name, line, log->data_cnt, log->data);
-exit:
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+	put_cpu();
+}
+
+/* copy out an entry, failing if it is incomplete or was overwritten */
+static bool _sde_evtlog_read(struct sde_dbg_evtlog_ring *ring, u32 idx,
+		struct sde_dbg_evtlog_log *out)
+{
+	struct sde_dbg_evtlog_log *log;
+
+	log = &ring->logs[idx & (SDE_EVTLOG_CPU_ENTRY - 1)];
+	if (READ_ONCE(log->seq) != idx + 1)
+		return false;
+
+	smp_rmb();
+	*out = *log;
+	smp_rmb();
+
+	return READ_ONCE(log->seq) == idx + 1;
+}
+
+/* keep only the newest print entry count of pending entries across cpus */
+static void _sde_evtlog_dump_trim(struct sde_dbg_evtlog *evtlog)
+{
+	struct sde_dbg_evtlog_ring *ring, *newest;
+	struct sde_dbg_evtlog_log log;
+	s64 newest_time;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
+		ring->limit = ring->first;
+		ring->first = ring->last_dump;
+	}
+
+	for (i = 0; i < SDE_EVTLOG_PRINT_ENTRY; i++) {
+		newest = NULL;
+		newest_time = S64_MIN;
+
+		for_each_possible_cpu(cpu) {
+			ring = evtlog->rings[cpu];
+			if (ring->first == ring->limit ||
+			    !_sde_evtlog_read(ring, ring->first - 1, &log))
+				continue;
+
+			if (log.time > newest_time) {
+				newest = ring;
+				newest_time = log.time;
+			}
+		}
+
+		if (!newest)
+			break;
+		newest->first--;
+	}
 }
 
 /* always dump the last entries which are not dumped yet */
 static bool _sde_evtlog_dump_calc_range(struct sde_dbg_evtlog *evtlog,
 		bool update_last_entry)
 {
+	struct sde_dbg_evtlog_ring *ring;
+	u32 pending = 0;
+	int cpu;
+
 	if (!evtlog)
 		return false;
 
-	evtlog->first = evtlog->next;
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
 
-	if (update_last_entry)
-		evtlog->last_dump = evtlog->last;
+		if (update_last_entry)
+			ring->last_dump = (u32)local_read(&ring->head);
 
-	if (evtlog->last_dump == evtlog->first)
-		return false;
+		/* older entries have already been overwritten */
+		if (ring->last_dump - ring->first > SDE_EVTLOG_CPU_ENTRY)
+			ring->first = ring->last_dump - SDE_EVTLOG_CPU_ENTRY;
 
-	if (evtlog->last_dump < evtlog->first) {
-		evtlog->first %= SDE_EVTLOG_ENTRY;
-		if (evtlog->last_dump < evtlog->first)
-			evtlog->last_dump += SDE_EVTLOG_ENTRY;
+		pending += ring->last_dump - ring->first;
 	}
 
-	if ((evtlog->last_dump - evtlog->first) > SDE_EVTLOG_PRINT_ENTRY) {
-		pr_info("evtlog skipping %d entries, last=%d\n",
-			evtlog->last_dump - evtlog->first -
-			SDE_EVTLOG_PRINT_ENTRY,
-			evtlog->last_dump - 1);
-		evtlog->first = evtlog->last_dump - SDE_EVTLOG_PRINT_ENTRY;
+	if (!pending)
+		return false;
+
+	if (pending > SDE_EVTLOG_PRINT_ENTRY) {
+		pr_info("evtlog skipping %u entries\n",
+			pending - SDE_EVTLOG_PRINT_ENTRY);
+		_sde_evtlog_dump_trim(evtlog);
 	}
-	evtlog->next = evtlog->first + 1;
 
 	return true;
 }
@@ -143,10 +215,12 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 		char *evtlog_buf, ssize_t evtlog_buf_size,
 		bool update_last_entry)
 {
-	int i;
+	int i, cpu, log_cpu = 0;
 	ssize_t off = 0;
-	struct sde_dbg_evtlog_log *log, *prev_log;
+	struct sde_dbg_evtlog_ring *ring, *oldest;
+	struct sde_dbg_evtlog_log log, oldest_log;
 	unsigned long flags;
+	u32 idx = 0;
 
 	if (!evtlog || !evtlog_buf)
 		return 0;
@@ -157,25 +231,52 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	if (!_sde_evtlog_dump_calc_range(evtlog, update_last_entry))
 		goto exit;
 
-	log = &evtlog->logs[evtlog->first % SDE_EVTLOG_ENTRY];
+	/* merge the per-cpu rings by picking the oldest pending entry */
+	oldest = NULL;
+	for_each_possible_cpu(cpu) {
+		ring = evtlog->rings[cpu];
 
-	prev_log = &evtlog->logs[(evtlog->first - 1) % SDE_EVTLOG_ENTRY];
+		/* skip entries overwritten or still being written */
+		while (ring->first != ring->last_dump &&
+		       !_sde_evtlog_read(ring, ring->first, &log))
+			ring->first++;
+
+		if (ring->first == ring->last_dump)
+			continue;
+
+		if (!oldest || log.time < oldest_log.time) {
+			oldest = ring;
+			oldest_log = log;
+			log_cpu = cpu;
+			idx = ring->first;
+		}
+	}
+
+	if (!oldest)
+		goto exit;
+	oldest->first++;
 
 	off = snprintf((evtlog_buf + off), (evtlog_buf_size - off), "%s:%-4d",
-		log->name, log->line);
+		oldest_log.name, oldest_log.line);
 
 	if (off < SDE_EVTLOG_BUF_ALIGN) {
 		memset((evtlog_buf + off), 0x20, (SDE_EVTLOG_BUF_ALIGN - off));
 		off = SDE_EVTLOG_BUF_ALIGN;
 	}
 
+	if (!evtlog->prev_time)
+		evtlog->prev_time = oldest_log.time;
+
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-		"=>[%-8d:%-11llu:%9llu][%-4d]:", evtlog->first,
-		log->time, (log->time - prev_log->time), log->pid);
+		"=>[%d:%-8u:%-11llu:%9llu][%-4d]:", log_cpu, idx,
+		div_u64(oldest_log.time, NSEC_PER_USEC),
+		div_u64(oldest_log.time - evtlog->prev_time, NSEC_PER_USEC),
+		oldest_log.pid);
+	evtlog->prev_time = oldest_log.time;
 
-	for (i = 0; i < log->data_cnt; i++)
+	for (i = 0; i < oldest_log.data_cnt; i++)
 		off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-			"%x ", log->data[i]);
+			"%x ", oldest_log.data[i]);
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off), "\n");
 exit:
@@ -199,34 +300,65 @@ void sde_evtlog_dump_all(struct sde_dbg_evtlog *evtlog)
 	}
 }
 
+static void _sde_evtlog_free_rings(struct sde_dbg_evtlog *evtlog)
+{
+	int cpu;
+
+	if (!evtlog->rings)
+		return;
+
+	for_each_possible_cpu(cpu)
+		kfree(evtlog->rings[cpu]);
+	kfree(evtlog->rings);
+}
+
 struct sde_dbg_evtlog *sde_evtlog_init(void)
 {
 	struct sde_dbg_evtlog *evtlog;
+	int cpu;
 
 	evtlog = kzalloc(sizeof(*evtlog), GFP_KERNEL);
 	if (!evtlog)
 		return ERR_PTR(-ENOMEM);
 
+	evtlog->rings = kcalloc(nr_cpu_ids, sizeof(*evtlog->rings),
+			GFP_KERNEL);
+	if (!evtlog->rings)
+		goto fail;
+
+	for_each_possible_cpu(cpu) {
+		evtlog->rings[cpu] = kzalloc_node(sizeof(**evtlog->rings),
+				GFP_KERNEL, cpu_to_node(cpu));
+		if (!evtlog->rings[cpu])
+			goto fail;
+		local_set(&evtlog->rings[cpu]->head, 0);
+	}
+
 	spin_lock_init(&evtlog->spin_lock);
+	mutex_init(&evtlog->filter_lock);
 	evtlog->enable = SDE_EVTLOG_DEFAULT_ENABLE;
 
 	INIT_LIST_HEAD(&evtlog->filter_list);
 
 	return evtlog;
+
+fail:
+	_sde_evtlog_free_rings(evtlog);
+	kfree(evtlog);
+	return ERR_PTR(-ENOMEM);
 }
 
 int sde_evtlog_get_filter(struct sde_dbg_evtlog *evtlog, int index,
 		char *buf, size_t bufsz)
 {
 	struct sde_evtlog_filter *filter_node;
-	unsigned long flags;
 	int rc = -EFAULT;
 
 	if (!evtlog || !buf || !bufsz || index < 0)
 		return -EINVAL;
 
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
-	list_for_each_entry(filter_node, &evtlog->filter_list, list) {
+	rcu_read_lock();
+	list_for_each_entry_rcu(filter_node, &evtlog->filter_list, list) {
 		if (index--)
 			continue;
 
@@ -235,7 +367,7 @@ int sde_evtlog_get_filter(struct sde_dbg_evtlog *evtlog, int index,
 		rc = 0;
 		break;
 	}
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+	rcu_read_unlock();
 
 	return rc;
 }
@@ -244,7 +376,6 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 {
 	struct sde_evtlog_filter *filter_node, *tmp;
 	struct list_head free_list;
-	unsigned long flags;
 	char *flt;
 
 	if (!evtlog)
@@ -254,14 +385,13 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 
 	/*
 	 * Clear active filter list and cache filter_nodes locally
-	 * to reduce memory fragmentation.
+	 * to reduce memory fragmentation. Loggers walk the list under
+	 * RCU, so wait for them before the nodes get reused.
 	 */
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
-	list_for_each_entry_safe(filter_node, tmp, &evtlog->filter_list, list) {
-		list_del_init(&filter_node->list);
-		list_add_tail(&filter_node->list, &free_list);
-	}
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+	mutex_lock(&evtlog->filter_lock);
+	if (!list_empty(&evtlog->filter_list))
+		list_splice_init_rcu(&evtlog->filter_list, &free_list,
+				synchronize_rcu);
 
 	/*
 	 * Parse incoming filter request string and build up a new
@@ -289,10 +419,9 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 		(void)strlcpy(filter_node->filter, flt,
 				SDE_EVTLOG_FILTER_STRSIZE);
 
-		spin_lock_irqsave(&evtlog->spin_lock, flags);
-		list_add_tail(&filter_node->list, &evtlog->filter_list);
-		spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+		list_add_tail_rcu(&filter_node->list, &evtlog->filter_list);
 	}
+	mutex_unlock(&evtlog->filter_lock);
 
 	/*
 	 * Free any unused filter_nodes back to the system.
@@ -314,5 +443,6 @@ void sde_evtlog_destroy(struct sde_dbg_evtlog *evtlog)
 		list_del(&filter_node->list);
 		kfree(filter_node);
 	}
+	_sde_evtlog_free_rings(evtlog);
 	kfree(evtlog);
 }
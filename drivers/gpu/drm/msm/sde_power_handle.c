@@ -449,16 +449,53 @@ static int _sde_power_data_bus_set_quota(
 	return rc;
 }
 
+/* called under phandle_lock */
+static int _sde_power_data_bus_vote(struct sde_power_handle *phandle,
+		u32 bus_id, int phase)
+{
+	struct sde_power_data_bus_handle *pdbus =
+		&phandle->data_bus_handle[bus_id];
+	u64 total_ab_rt = 0, total_ib_rt = 0;
+	u64 total_ab_nrt = 0, total_ib_nrt = 0;
+	struct sde_power_client *client;
+	bool raise;
+	int i;
+
+	if (!pdbus->data_bus_hdl)
+		return 0;
+
+	list_for_each_entry(client, &phandle->power_client_clist, list) {
+		for (i = 0; i < SDE_POWER_HANDLE_DATA_BUS_CLIENT_MAX; i++) {
+			if (i == SDE_POWER_HANDLE_DATA_BUS_CLIENT_NRT) {
+				total_ab_nrt += client->ab[i];
+				total_ib_nrt += client->ib[i];
+			} else {
+				total_ab_rt += client->ab[i];
+				total_ib_rt = max(total_ib_rt, client->ib[i]);
+			}
+		}
+	}
+
+	/* in a commit, raise in the first phase and lower in the second */
+	if (phase) {
+		raise = total_ab_rt > pdbus->ab_rt ||
+			total_ib_rt > pdbus->ib_rt ||
+			total_ab_nrt > pdbus->ab_nrt ||
+			total_ib_nrt > pdbus->ib_nrt;
+		if (raise != (phase == 1))
+			return 0;
+	}
+
+	return _sde_power_data_bus_set_quota(pdbus, total_ab_rt, total_ab_nrt,
+			total_ib_rt, total_ib_nrt);
+}
+
 int sde_power_data_bus_set_quota(struct sde_power_handle *phandle,
 		struct sde_power_client *pclient,
 		int bus_client, u32 bus_id,
 		u64 ab_quota, u64 ib_quota)
 {
 	int rc = 0;
-	int i;
-	u64 total_ab_rt = 0, total_ib_rt = 0;
-	u64 total_ab_nrt = 0, total_ib_nrt = 0;
-	struct sde_power_client *client;
 
 	if (!phandle || !pclient ||
 			bus_client >= SDE_POWER_HANDLE_DATA_BUS_CLIENT_MAX ||
@@ -473,24 +510,25 @@ int sde_power_data_bus_set_quota(struct sde_power_handle *phandle,
 	pclient->ib[bus_client] = ib_quota;
 	trace_sde_perf_update_bus(bus_client, bus_id, ab_quota, ib_quota);
 
-	list_for_each_entry(client, &phandle->power_client_clist, list) {
-		for (i = 0; i < SDE_POWER_HANDLE_DATA_BUS_CLIENT_MAX; i++) {
-			if (i == SDE_POWER_HANDLE_DATA_BUS_CLIENT_NRT) {
-				total_ab_nrt += client->ab[i];
-				total_ib_nrt += client->ib[i];
-			} else {
-				total_ab_rt += client->ab[i];
-				total_ib_rt = max(total_ib_rt, client->ib[i]);
-			}
-		}
-	}
+	if (READ_ONCE(phandle->txn_owner) == current)
+		phandle->dbus_dirty |= BIT(bus_id);
+	else
+		rc = _sde_power_data_bus_vote(phandle, bus_id, 0);
 
-	if (phandle->data_bus_handle[bus_id].data_bus_hdl)
-		rc = _sde_power_data_bus_set_quota(
-			&phandle->data_bus_handle[bus_id],
-			total_ab_rt, total_ab_nrt,
-			total_ib_rt, total_ib_nrt);
+	mutex_unlock(&phandle->phandle_lock);
+
+	return rc;
+}
+
+static int sde_power_data_bus_commit(struct sde_power_handle *phandle,
+		int phase)
+{
+	int i, rc = 0;
 
+	mutex_lock(&phandle->phandle_lock);
+	for (i = 0; i < SDE_POWER_HANDLE_DBUS_ID_MAX && !rc; i++)
+		if (phandle->dbus_dirty & BIT(i))
+			rc = _sde_power_data_bus_vote(phandle, i, phase);
 	mutex_unlock(&phandle->phandle_lock);
 
 	return rc;
@@ -693,6 +731,12 @@ int sde_power_data_bus_state_update(struct sde_power_handle *phandle,
 {
 	return 0;
 }
+
+static int sde_power_data_bus_commit(struct sde_power_handle *phandle,
+		int phase)
+{
+	return 0;
+}
 #endif
 
 int sde_power_resource_init(struct platform_device *pdev,
@@ -764,10 +808,22 @@ int sde_power_resource_init(struct platform_device *pdev,
 	phandle->rsc_client = NULL;
 	phandle->rsc_client_init = false;
 
+	phandle->clk_dirty = devm_kcalloc(&pdev->dev,
+			BITS_TO_LONGS(max_t(u32, mp->num_clk, 1)),
+			sizeof(*phandle->clk_dirty), GFP_KERNEL);
+	if (!phandle->clk_dirty) {
+		rc = -ENOMEM;
+		goto dirty_err;
+	}
+
 	mutex_init(&phandle->phandle_lock);
+	mutex_init(&phandle->txn_lock);
 
 	return rc;
 
+dirty_err:
+	i = SDE_POWER_HANDLE_DBUS_ID_MAX;
+
 data_bus_err:
 	for (i--; i >= 0; i--)
 		sde_power_data_bus_unregister(&phandle->data_bus_handle[i]);
@@ -1087,7 +1143,13 @@ int sde_power_clk_set_rate(struct sde_power_handle *phandle, char *clock_name,
 				rate = mp->clk_config[i].max_rate;
 
 			mp->clk_config[i].rate = rate;
-			rc = msm_dss_clk_set_rate(mp->clk_config, mp->num_clk);
+			if (READ_ONCE(phandle->txn_owner) == current) {
+				set_bit(i, phandle->clk_dirty);
+				rc = 0;
+			} else {
+				rc = msm_dss_clk_set_rate(&mp->clk_config[i],
+						1);
+			}
 			break;
 		}
 	}
@@ -1095,6 +1157,79 @@ int sde_power_clk_set_rate(struct sde_power_handle *phandle, char *clock_name,
 	return rc;
 }
 
+static int sde_power_clk_commit(struct sde_power_handle *phandle,
+		bool raise)
+{
+	struct dss_module_power *mp = &phandle->mp;
+	struct dss_clk *clk;
+	int i, rc = 0;
+
+	for_each_set_bit(i, phandle->clk_dirty, mp->num_clk) {
+		clk = &mp->clk_config[i];
+		if (clk->clk &&
+		    ((u64)clk->rate > clk_get_rate(clk->clk)) != raise)
+			continue;
+
+		clear_bit(i, phandle->clk_dirty);
+		rc = msm_dss_clk_set_rate(clk, 1);
+		if (rc)
+			break;
+	}
+
+	return rc;
+}
+
+void sde_power_txn_begin(struct sde_power_handle *phandle)
+{
+	if (!phandle)
+		return;
+
+	if (phandle->txn_owner == current) {
+		phandle->txn_depth++;
+		return;
+	}
+
+	mutex_lock(&phandle->txn_lock);
+	phandle->txn_depth = 1;
+	WRITE_ONCE(phandle->txn_owner, current);
+}
+
+int sde_power_txn_commit(struct sde_power_handle *phandle)
+{
+	struct dss_module_power *mp;
+	int rc;
+
+	if (!phandle || WARN_ON(phandle->txn_owner != current))
+		return -EINVAL;
+
+	if (--phandle->txn_depth)
+		return 0;
+
+	WRITE_ONCE(phandle->txn_owner, NULL);
+	mp = &phandle->mp;
+
+	SDE_ATRACE_BEGIN("sde_power_txn_commit");
+	rc = sde_power_data_bus_commit(phandle, 1);
+	if (!rc)
+		rc = sde_power_clk_commit(phandle, true);
+	if (!rc)
+		rc = sde_power_clk_commit(phandle, false);
+	if (!rc)
+		rc = sde_power_data_bus_commit(phandle, 2);
+	SDE_ATRACE_END("sde_power_txn_commit");
+
+	if (rc)
+		pr_err("failed to commit power votes rc=%d\n", rc);
+
+	mutex_lock(&phandle->phandle_lock);
+	phandle->dbus_dirty = 0;
+	mutex_unlock(&phandle->phandle_lock);
+	bitmap_zero(phandle->clk_dirty, mp->num_clk);
+	mutex_unlock(&phandle->txn_lock);
+
+	return rc;
+}
+
 u64 sde_power_clk_get_rate(struct sde_power_handle *phandle, char *clock_name)
 {
 	int i;
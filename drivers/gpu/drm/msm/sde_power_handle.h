@@ -165,6 +165,11 @@ struct sde_power_event {
  * @event_list: current power handle event list
  * @rsc_client: sde rsc client pointer
  * @rsc_client_init: boolean to control rsc client create
+ * @txn_lock: serializes transactions, held from begin to commit
+ * @txn_owner: task staging votes in a transaction, NULL if none
+ * @txn_depth: nesting level of the transaction of txn_owner
+ * @dbus_dirty: data bus ids with a quota staged in the transaction
+ * @clk_dirty: clocks with a rate staged in the transaction
  */
 struct sde_power_handle {
 	struct dss_module_power mp;
@@ -178,6 +183,11 @@ struct sde_power_handle {
 	struct list_head event_list;
 	struct sde_rsc_client *rsc_client;
 	bool rsc_client_init;
+	struct mutex txn_lock;
+	struct task_struct *txn_owner;
+	u32 txn_depth;
+	u32 dbus_dirty;
+	unsigned long *clk_dirty;
 };
 
 /**
@@ -360,4 +370,26 @@ void sde_power_handle_unregister_event(struct sde_power_handle *phandle,
  */
 const char *sde_power_handle_get_dbus_name(u32 bus_id);
 
+/**
+ * sde_power_txn_begin() - start staging bus and clock votes
+ * @phandle:  power handle containing the resources
+ *
+ * Until the matching sde_power_txn_commit(), sde_power_data_bus_set_quota()
+ * and sde_power_clk_set_rate() called by this task only record the new
+ * votes. Transactions nest and are serialized between tasks.
+ */
+void sde_power_txn_begin(struct sde_power_handle *phandle);
+
+/**
+ * sde_power_txn_commit() - apply the votes staged since sde_power_txn_begin()
+ * @phandle:  power handle containing the resources
+ *
+ * Bandwidth is raised before clocks and clocks are lowered before
+ * bandwidth, so the pipeline never runs faster than its bus vote allows.
+ * Every bus and clock is voted once, however often it was staged.
+ *
+ * Return: error code, the first failing vote.
+ */
+int sde_power_txn_commit(struct sde_power_handle *phandle);
+
 #endif /* _SDE_POWER_HANDLE_H_ */
@@ -334,8 +334,10 @@ static u32 sde_rsc_timer_calculate(struct sde_rsc_priv *rsc,
 	s64 total;
 	int ret = 0;
 
-	if (cmd_config)
+	if (cmd_config && cmd_config != &rsc->cmd_config)
 		memcpy(&rsc->cmd_config, cmd_config, sizeof(*cmd_config));
+	if (!rsc->frame_mult)
+		rsc->frame_mult = 1;
 
 	/* calculate for 640x480 60 fps resolution by default */
 	if (!rsc->cmd_config.fps)
@@ -366,7 +368,12 @@ static u32 sde_rsc_timer_calculate(struct sde_rsc_priv *rsc,
 	line_time_ns = div_u64(line_time_ns, rsc->cmd_config.vtotal);
 	prefill_time_ns = line_time_ns * rsc->cmd_config.prefill_lines;
 
-	total = frame_time_ns - frame_jitter - prefill_time_ns;
+	/*
+	 * The wakeup timer may span several frames when the primary client
+	 * is known to update at a fraction of the panel refresh rate.
+	 */
+	total = frame_time_ns * rsc->frame_mult - frame_jitter -
+						prefill_time_ns;
 	if (total < 0) {
 		pr_err("invalid total time period time:%llu jiter_time:%llu blanking time:%llu\n",
 			frame_time_ns, frame_jitter, prefill_time_ns);
@@ -376,8 +383,8 @@ static u32 sde_rsc_timer_calculate(struct sde_rsc_priv *rsc,
 	total = div_u64(total, cxo_period_ns);
 	rsc->timer_config.static_wakeup_time_ns = total;
 
-	pr_debug("frame time:%llu frame jiter_time:%llu\n",
-			frame_time_ns, frame_jitter);
+	pr_debug("frame time:%llu frame jiter_time:%llu frame mult:%u\n",
+			frame_time_ns, frame_jitter, rsc->frame_mult);
 	pr_debug("line time:%llu prefill time ps:%llu\n",
 			line_time_ns, prefill_time_ns);
 	pr_debug("static wakeup time:%lld cxo:%u\n", total, cxo_period_ns);
@@ -767,6 +774,65 @@ bool sde_rsc_client_is_state_update_complete(
  *
  * Return: error code.
  */
+static void sde_rsc_residency_update(struct sde_rsc_priv *rsc, u32 state)
+{
+	ktime_t now = ktime_get();
+
+	if (rsc->current_state < SDE_RSC_STATE_COUNT)
+		rsc->residency_ns[rsc->current_state] +=
+			ktime_to_ns(ktime_sub(now, rsc->state_ts));
+	rsc->state_ts = now;
+	rsc->current_state = state;
+}
+
+/**
+ * sde_rsc_cadence_update() - learn the primary client update cadence
+ * @rsc: Pointer to rsc private structure
+ *
+ * Tracks the interval between command state requests from the primary
+ * client and derives how many whole panel frames it reliably stays idle.
+ * The shortest interval of the recent window is used so a single fast
+ * update pulls the wakeup timer back to one frame right away.
+ *
+ * Return: true if the timers need to be reprogrammed.
+ */
+static bool sde_rsc_cadence_update(struct sde_rsc_priv *rsc)
+{
+	ktime_t now = ktime_get();
+	u64 frame_time_ns, min_interval = U64_MAX;
+	u32 mult = 1;
+	int i;
+
+	if (rsc->predict_idle && rsc->cmd_config.fps) {
+		if (ktime_to_ns(rsc->last_update))
+			rsc->update_intervals[rsc->update_idx++ %
+				SDE_RSC_CADENCE_SAMPLES] =
+				ktime_to_ns(ktime_sub(now, rsc->last_update));
+		rsc->last_update = now;
+
+		for (i = 0; i < SDE_RSC_CADENCE_SAMPLES; i++)
+			min_interval = min(min_interval,
+					rsc->update_intervals[i]);
+
+		frame_time_ns = div_u64(TICKS_IN_NANO_SECOND,
+					rsc->cmd_config.fps);
+		mult = clamp_t(u64, div64_u64(min_interval, frame_time_ns),
+				1, SDE_RSC_MAX_FRAME_MULT);
+	} else if (ktime_to_ns(rsc->last_update)) {
+		rsc->last_update = ktime_set(0, 0);
+		rsc->update_idx = 0;
+		memset(rsc->update_intervals, 0,
+				sizeof(rsc->update_intervals));
+	}
+
+	if (mult == rsc->frame_mult)
+		return false;
+
+	pr_debug("rsc frame mult %u -> %u\n", rsc->frame_mult, mult);
+	rsc->frame_mult = mult;
+	return true;
+}
+
 int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 	enum sde_rsc_state state,
 	struct sde_rsc_cmd_config *config, int crtc_id,
@@ -796,6 +862,12 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 	caller_client->crtc_id = crtc_id;
 	caller_client->current_state = state;
 
+	if (state == SDE_RSC_CMD_STATE && !config &&
+			caller_client == rsc->primary_client &&
+			rsc->current_state == SDE_RSC_CMD_STATE &&
+			sde_rsc_cadence_update(rsc))
+		config = &rsc->cmd_config;
+
 	if (rsc->master_drm == NULL) {
 		pr_err("invalid master component binding\n");
 		rc = -EINVAL;
@@ -864,7 +936,8 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 	}
 
 	pr_debug("state switch successfully complete: %d\n", state);
-	rsc->current_state = state;
+	if (rsc->current_state != state)
+		sde_rsc_residency_update(rsc, state);
 	SDE_EVT32(caller_client->id, caller_client->current_state,
 			state, rsc->current_state, SDE_EVTLOG_FUNC_EXIT);
 
@@ -959,7 +1032,8 @@ static int _sde_debugfs_status_show(struct seq_file *s, void *data)
 {
 	struct sde_rsc_priv *rsc;
 	struct sde_rsc_client *client;
-	int ret;
+	u64 residency;
+	int ret, i;
 
 	if (!s || !s->private)
 		return -EINVAL;
@@ -988,6 +1062,17 @@ static int _sde_debugfs_status_show(struct seq_file *s, void *data)
 			rsc->cmd_config.fps, rsc->cmd_config.jitter_numer,
 			rsc->cmd_config.jitter_denom,
 			rsc->cmd_config.vtotal, rsc->cmd_config.prefill_lines);
+	seq_printf(s, "predict idle:%d frame mult:%u\n",
+			rsc->predict_idle, rsc->frame_mult);
+
+	for (i = 0; i < SDE_RSC_STATE_COUNT; i++) {
+		residency = rsc->residency_ns[i];
+		if (i == rsc->current_state)
+			residency += ktime_to_ns(ktime_sub(ktime_get(),
+							rsc->state_ts));
+		seq_printf(s, "state:%d residency(ms):%llu\n", i,
+				div_u64(residency, NSEC_PER_MSEC));
+	}
 
 	seq_puts(s, "\n");
 
@@ -1232,6 +1317,8 @@ static void _sde_rsc_init_debugfs(struct sde_rsc_priv *rsc, char *name)
 							&mode_control_fops);
 	debugfs_create_file("vsync_mode", 0600, rsc->debugfs_root, rsc,
 							&vsync_status_fops);
+	debugfs_create_bool("predict_idle", 0600, rsc->debugfs_root,
+							&rsc->predict_idle);
 	debugfs_create_x32("debug_mode", 0600, rsc->debugfs_root,
 							&rsc->debug_mode);
 }
@@ -1410,6 +1497,7 @@ static int sde_rsc_probe(struct platform_device *pdev)
 
 	if (sde_rsc_timer_calculate(rsc, NULL))
 		goto sde_rsc_fail;
+	rsc->state_ts = ktime_get();
 
 	sde_rsc_clk_enable(&rsc->phandle, rsc->pclient, false);
 
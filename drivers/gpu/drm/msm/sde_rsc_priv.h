@@ -15,6 +15,7 @@
 #define _SDE_RSC_PRIV_H_
 
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/sde_io_util.h>
 #include <linux/sde_rsc.h>
 
@@ -32,6 +33,10 @@
 
 #define MAX_COUNT_SIZE_SUPPORTED	128
 
+#define SDE_RSC_STATE_COUNT		(SDE_RSC_VID_STATE + 1)
+#define SDE_RSC_CADENCE_SAMPLES		8
+#define SDE_RSC_MAX_FRAME_MULT		4
+
 struct sde_rsc_priv;
 
 /**
@@ -151,6 +156,14 @@ struct sde_rsc_timer_config {
  *			on crtc id
  * rsc_vsync_wait:   Refcount to indicate if we have to wait for the vsync.
  * rsc_vsync_waitq:   Queue to wait for the vsync.
+ *
+ * state_ts:		time of the last rsc state switch
+ * residency_ns:	accumulated time spent in each rsc state
+ * predict_idle:	stretch the wakeup timer to the learned update cadence
+ * last_update:		time of the previous primary client cmd state request
+ * update_intervals:	most recent primary client request intervals in ns
+ * update_idx:		next slot to fill in update_intervals
+ * frame_mult:		number of panel frames the wakeup timer spans
  */
 struct sde_rsc_priv {
 	u32 version;
@@ -181,6 +194,14 @@ struct sde_rsc_priv {
 	struct drm_device *master_drm;
 	atomic_t rsc_vsync_wait;
 	wait_queue_head_t rsc_vsync_waitq;
+
+	ktime_t state_ts;
+	u64 residency_ns[SDE_RSC_STATE_COUNT];
+	bool predict_idle;
+	ktime_t last_update;
+	u64 update_intervals[SDE_RSC_CADENCE_SAMPLES];
+	u32 update_idx;
+	u32 frame_mult;
 };
 
 /**
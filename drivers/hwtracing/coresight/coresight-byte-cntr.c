@@ -15,6 +15,10 @@
 #include <linux/of_irq.h>
 #include <linux/moduleparam.h>
 #include <linux/delay.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/coresight-byte-cntr.h>
 
 #include "coresight-byte-cntr.h"
 #include "coresight-priv.h"
@@ -118,6 +122,7 @@ static irqreturn_t etr_handler(int irq, void *data)
 	struct byte_cntr *byte_cntr_data = data;
 
 	atomic_inc(&byte_cntr_data->irq_cnt);
+	atomic64_add(byte_cntr_data->block_size, &byte_cntr_data->head);
 
 	wake_up(&byte_cntr_data->wq);
 
@@ -206,6 +211,7 @@ static ssize_t tmc_etr_byte_cntr_read(struct file *fp, char __user *data,
 		*ppos = 0;
 	else
 		*ppos += len;
+	byte_cntr_data->tail += len;
 err0:
 	mutex_unlock(&byte_cntr_data->byte_cntr_lock);
 
@@ -225,6 +231,9 @@ void tmc_etr_byte_cntr_start(struct byte_cntr *byte_cntr_data)
 	}
 
 	atomic_set(&byte_cntr_data->irq_cnt, 0);
+	atomic64_set(&byte_cntr_data->head, 0);
+	byte_cntr_data->tail = 0;
+	byte_cntr_data->lost = 0;
 	byte_cntr_data->enable = true;
 	mutex_unlock(&byte_cntr_data->byte_cntr_lock);
 }
@@ -284,10 +293,132 @@ static int tmc_etr_byte_cntr_open(struct inode *in, struct file *fp)
 	return 0;
 }
 
+static unsigned int tmc_etr_byte_cntr_poll(struct file *fp,
+					   struct poll_table_struct *wait)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+	unsigned int mask = 0;
+
+	poll_wait(fp, &byte_cntr_data->wq, wait);
+
+	mutex_lock(&byte_cntr_data->byte_cntr_lock);
+	if (atomic64_read(&byte_cntr_data->head) != byte_cntr_data->tail)
+		mask = POLLIN | POLLRDNORM;
+	mutex_unlock(&byte_cntr_data->byte_cntr_lock);
+
+	return mask;
+}
+
+static long tmc_etr_byte_cntr_ioctl(struct file *fp, unsigned int cmd,
+				    unsigned long arg)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+	struct byte_cntr_pos pos;
+	u64 tail, head;
+	long ret = 0;
+
+	mutex_lock(&byte_cntr_data->byte_cntr_lock);
+	head = atomic64_read(&byte_cntr_data->head);
+
+	switch (cmd) {
+	case BYTE_CNTR_IOC_GET_POS:
+		/* Data older than one buffer size has been overwritten */
+		if (head - byte_cntr_data->tail > tmcdrvdata->size) {
+			byte_cntr_data->lost += head - byte_cntr_data->tail -
+						tmcdrvdata->size;
+			byte_cntr_data->tail = head - tmcdrvdata->size;
+		}
+		pos.head = head;
+		pos.tail = byte_cntr_data->tail;
+		pos.lost = byte_cntr_data->lost;
+		pos.size = tmcdrvdata->size;
+		pos.block_size = byte_cntr_data->block_size;
+		if (copy_to_user((void __user *)arg, &pos, sizeof(pos)))
+			ret = -EFAULT;
+		break;
+	case BYTE_CNTR_IOC_SET_TAIL:
+		if (get_user(tail, (u64 __user *)arg)) {
+			ret = -EFAULT;
+			break;
+		}
+		if (tail < byte_cntr_data->tail || tail > head) {
+			ret = -EINVAL;
+			break;
+		}
+		byte_cntr_data->tail = tail;
+		break;
+	default:
+		ret = -ENOTTY;
+	}
+
+	mutex_unlock(&byte_cntr_data->byte_cntr_lock);
+	return ret;
+}
+
+static void tmc_etr_byte_cntr_vm_open(struct vm_area_struct *vma)
+{
+	struct byte_cntr *byte_cntr_data = vma->vm_private_data;
+
+	atomic_inc(&byte_cntr_data->mmap_cnt);
+}
+
+static void tmc_etr_byte_cntr_vm_close(struct vm_area_struct *vma)
+{
+	struct byte_cntr *byte_cntr_data = vma->vm_private_data;
+
+	atomic_dec(&byte_cntr_data->mmap_cnt);
+}
+
+static const struct vm_operations_struct byte_cntr_vm_ops = {
+	.open		= tmc_etr_byte_cntr_vm_open,
+	.close		= tmc_etr_byte_cntr_vm_close,
+};
+
+/*
+ * Only the contiguous buffer can be mapped: scatter-gather blocks are not
+ * laid out in trace order and would need the table walk done by read().
+ */
+static int tmc_etr_byte_cntr_mmap(struct file *fp, struct vm_area_struct *vma)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (vma->vm_pgoff)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	mutex_lock(&tmcdrvdata->mem_lock);
+	if (tmcdrvdata->memtype != TMC_ETR_MEM_TYPE_CONTIG ||
+	    !tmcdrvdata->vaddr || size > PAGE_ALIGN(tmcdrvdata->size)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+	ret = dma_mmap_coherent(tmcdrvdata->dev, vma, tmcdrvdata->vaddr,
+				tmcdrvdata->paddr, size);
+	if (ret)
+		goto out;
+
+	vma->vm_ops = &byte_cntr_vm_ops;
+	vma->vm_private_data = byte_cntr_data;
+	tmc_etr_byte_cntr_vm_open(vma);
+out:
+	mutex_unlock(&tmcdrvdata->mem_lock);
+	return ret;
+}
+
 static const struct file_operations byte_cntr_fops = {
 	.owner		= THIS_MODULE,
 	.open		= tmc_etr_byte_cntr_open,
 	.read		= tmc_etr_byte_cntr_read,
+	.poll		= tmc_etr_byte_cntr_poll,
+	.unlocked_ioctl	= tmc_etr_byte_cntr_ioctl,
+	.compat_ioctl	= tmc_etr_byte_cntr_ioctl,
+	.mmap		= tmc_etr_byte_cntr_mmap,
 	.release	= tmc_etr_byte_cntr_release,
 	.llseek		= no_llseek,
 };
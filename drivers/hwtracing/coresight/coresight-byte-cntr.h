@@ -14,6 +14,10 @@ struct byte_cntr {
 	uint32_t		block_size;
 	int			byte_cntr_irq;
 	atomic_t		irq_cnt;
+	atomic64_t		head;
+	u64			tail;
+	u64			lost;
+	atomic_t		mmap_cnt;
 	wait_queue_head_t	wq;
 	struct mutex		byte_cntr_lock;
 	struct coresight_csr		*csr;
@@ -22,4 +26,10 @@ struct byte_cntr {
 extern void tmc_etr_byte_cntr_start(struct byte_cntr *byte_cntr_data);
 extern void tmc_etr_byte_cntr_stop(struct byte_cntr *byte_cntr_data);
 
+/* The ETR buffer must not be freed while it is mapped to a reader */
+static inline bool tmc_etr_byte_cntr_mapped(struct byte_cntr *byte_cntr_data)
+{
+	return byte_cntr_data && atomic_read(&byte_cntr_data->mmap_cnt);
+}
+
 #endif
@@ -19,6 +19,7 @@
 #include <linux/coresight-pmu.h>
 #include <linux/cpumask.h>
 #include <linux/device.h>
+#include <linux/hrtimer.h>
 #include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/init.h>
@@ -47,16 +48,41 @@ struct etm_event_data {
 	struct list_head **path;
 };
 
+/**
+ * struct etm_sample - Periodic trace bursts of the event running on a CPU
+ * @timer:		Pinned timer ending the current burst or gap.
+ * @event:		The sampled event, NULL if there is none.
+ * @tracing:		The tracer is enabled, i.e. a burst is in progress.
+ */
+struct etm_sample {
+	struct hrtimer timer;
+	struct perf_event *event;
+	bool tracing;
+};
+
 static DEFINE_PER_CPU(struct perf_output_handle, ctx_handle);
 static DEFINE_PER_CPU(struct coresight_device *, csdev_src);
+static DEFINE_PER_CPU(struct etm_sample, etm_sample);
+
+/*
+ * Sampling mode: with a non-zero interval the tracer only runs for 'burst'
+ * out of every 'interval' microseconds, enough for branch profiles at a
+ * small fraction of the trace volume and overhead of full capture.
+ */
+#define ETM_SAMPLE_BURST_US(event)	lower_32_bits((event)->attr.config2)
+#define ETM_SAMPLE_INTERVAL_US(event)	upper_32_bits((event)->attr.config2)
 
 /* ETMv3.5/PTM's ETMCR is 'config' */
 PMU_FORMAT_ATTR(cycacc,		"config:" __stringify(ETM_OPT_CYCACC));
 PMU_FORMAT_ATTR(timestamp,	"config:" __stringify(ETM_OPT_TS));
+PMU_FORMAT_ATTR(burst_us,	"config2:0-31");
+PMU_FORMAT_ATTR(interval_us,	"config2:32-63");
 
 static struct attribute *etm_config_formats_attr[] = {
 	&format_attr_cycacc.attr,
 	&format_attr_timestamp.attr,
+	&format_attr_burst_us.attr,
+	&format_attr_interval_us.attr,
 	NULL,
 };
 
@@ -105,6 +131,13 @@ static int etm_event_init(struct perf_event *event)
 		goto out;
 	}
 
+	if (ETM_SAMPLE_INTERVAL_US(event) &&
+	    (!ETM_SAMPLE_BURST_US(event) ||
+	     ETM_SAMPLE_BURST_US(event) >= ETM_SAMPLE_INTERVAL_US(event))) {
+		ret = -EINVAL;
+		goto out;
+	}
+
 	ret = etm_addr_filters_alloc(event);
 	if (ret)
 		goto out;
@@ -260,6 +293,38 @@ err:
 	goto out;
 }
 
+static enum hrtimer_restart etm_sample_timer(struct hrtimer *timer)
+{
+	struct etm_sample *sample = container_of(timer, struct etm_sample,
+						 timer);
+	struct perf_event *event = sample->event;
+	struct coresight_device *csdev = this_cpu_read(csdev_src);
+	u64 burst_ns, gap_ns;
+
+	if (!event || !csdev)
+		return HRTIMER_NORESTART;
+
+	burst_ns = (u64)ETM_SAMPLE_BURST_US(event) * NSEC_PER_USEC;
+	gap_ns = (u64)ETM_SAMPLE_INTERVAL_US(event) * NSEC_PER_USEC - burst_ns;
+
+	/*
+	 * The sink and the path stay enabled for the whole session, only the
+	 * tracer is switched so bursts land back to back in the AUX buffer.
+	 */
+	if (sample->tracing) {
+		source_ops(csdev)->disable(csdev, event);
+		sample->tracing = false;
+		hrtimer_forward_now(timer, ns_to_ktime(gap_ns));
+	} else {
+		if (source_ops(csdev)->enable(csdev, event, CS_MODE_PERF))
+			return HRTIMER_NORESTART;
+		sample->tracing = true;
+		hrtimer_forward_now(timer, ns_to_ktime(burst_ns));
+	}
+
+	return HRTIMER_RESTART;
+}
+
 static void etm_event_start(struct perf_event *event, int flags)
 {
 	int cpu = smp_processor_id();
@@ -299,6 +364,18 @@ static void etm_event_start(struct perf_event *event, int flags)
 	if (source_ops(csdev)->enable(csdev, event, CS_MODE_PERF))
 		goto fail_end_stop;
 
+	/* In sampling mode this is the first burst */
+	if (ETM_SAMPLE_INTERVAL_US(event)) {
+		struct etm_sample *sample = this_cpu_ptr(&etm_sample);
+
+		sample->event = event;
+		sample->tracing = true;
+		hrtimer_start(&sample->timer,
+			      ns_to_ktime((u64)ETM_SAMPLE_BURST_US(event) *
+					  NSEC_PER_USEC),
+			      HRTIMER_MODE_REL_PINNED);
+	}
+
 out:
 	return;
 
@@ -328,6 +405,14 @@ static void etm_event_stop(struct perf_event *event, int mode)
 	if (!sink)
 		return;
 
+	/* end sampling, the tracer may be between two bursts */
+	if (ETM_SAMPLE_INTERVAL_US(event)) {
+		struct etm_sample *sample = this_cpu_ptr(&etm_sample);
+
+		hrtimer_cancel(&sample->timer);
+		sample->event = NULL;
+	}
+
 	/* stop tracer */
 	source_ops(csdev)->disable(csdev, event);
 
@@ -488,7 +573,14 @@ int etm_perf_symlink(struct coresight_device *csdev, bool link)
 
 static int __init etm_perf_init(void)
 {
-	int ret;
+	struct etm_sample *sample;
+	int cpu, ret;
+
+	for_each_possible_cpu(cpu) {
+		sample = per_cpu_ptr(&etm_sample, cpu);
+		hrtimer_init(&sample->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		sample->timer.function = etm_sample_timer;
+	}
 
 	etm_pmu.capabilities		= PERF_PMU_CAP_EXCLUSIVE;
 
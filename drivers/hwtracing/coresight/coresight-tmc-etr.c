@@ -816,6 +816,10 @@ static int tmc_enable_etr_sink_sysfs(struct coresight_device *csdev)
 		 */
 		if (drvdata->size != drvdata->mem_size ||
 		    drvdata->memtype != drvdata->mem_type) {
+			if (tmc_etr_byte_cntr_mapped(drvdata->byte_cntr)) {
+				mutex_unlock(&drvdata->mem_lock);
+				return -EBUSY;
+			}
 			tmc_etr_free_mem(drvdata);
 			drvdata->size = drvdata->mem_size;
 			drvdata->memtype = drvdata->mem_type;
@@ -1279,7 +1283,7 @@ int tmc_read_unprepare_etr(struct tmc_drvdata *drvdata)
 	drvdata->reading = false;
 	spin_unlock_irqrestore(&drvdata->spinlock, flags);
 
-	if (vaddr)
+	if (vaddr && !tmc_etr_byte_cntr_mapped(drvdata->byte_cntr))
 		tmc_etr_free_mem(drvdata);
 
 	mutex_unlock(&drvdata->mem_lock);
@@ -26,6 +26,7 @@
 #include <linux/major.h>
 #include <linux/device.h>
 #include <linux/cdev.h>
+#include <linux/input-mmap.h>
 #include "input-compat.h"
 
 enum evdev_clock_type {
@@ -59,10 +60,31 @@ struct evdev_client {
 	unsigned int clk_type;
 	bool revoked;
 	unsigned long *evmasks[EV_CNT];
+	struct input_mmap_header *ring; /* shared ring, see input-mmap.h */
+	unsigned int ring_head;
+	unsigned int ring_published;
+	bool ring_drop;
 	unsigned int bufsize;
 	struct input_event buffer[];
 };
 
+static inline struct input_event *
+evdev_ring_event(struct evdev_client *client, unsigned int index)
+{
+	struct input_event *events = (struct input_event *)(client->ring + 1);
+
+	return &events[index & (client->bufsize - 1)];
+}
+
+static inline bool evdev_client_empty(struct evdev_client *client)
+{
+	if (client->ring)
+		return READ_ONCE(client->ring->head) ==
+			READ_ONCE(client->ring->tail);
+
+	return client->packet_head == client->tail;
+}
+
 static size_t evdev_get_mask_cnt(unsigned int type)
 {
 	static const size_t counts[EV_CNT] = {
@@ -255,6 +277,45 @@ static void __pass_event(struct evdev_client *client,
 	}
 }
 
+/*
+ * Add an event to the shared ring. Returns true when a packet was
+ * published and a sleeping reader has to be woken up.
+ */
+static bool __pass_event_ring(struct evdev_client *client,
+			      const struct input_event *event)
+{
+	struct input_mmap_header *hdr = client->ring;
+	bool syn = event->type == EV_SYN && event->code == SYN_REPORT;
+	unsigned int tail = READ_ONCE(hdr->tail);
+
+	/* drop the whole packet if it does not fit */
+	if (client->ring_drop || client->ring_head - tail >= client->bufsize) {
+		client->ring_drop = !syn;
+		if (syn) {
+			client->ring_head = client->ring_published;
+			hdr->dropped++;
+		}
+		return false;
+	}
+
+	*evdev_ring_event(client, client->ring_head++) = *event;
+	if (!syn)
+		return false;
+
+	client->ring_published = client->ring_head;
+	smp_wmb();
+	WRITE_ONCE(hdr->head, client->ring_published);
+	kill_fasync(&client->fasync, SIGIO, POLL_IN);
+
+	/* pairs with the barrier between setting need_wake and checking head */
+	smp_mb();
+	if (!READ_ONCE(hdr->need_wake))
+		return false;
+
+	WRITE_ONCE(hdr->need_wake, 0);
+	return true;
+}
+
 static void evdev_pass_values(struct evdev_client *client,
 			const struct input_value *vals, unsigned int count,
 			ktime_t *ev_time)
@@ -276,6 +337,16 @@ static void evdev_pass_values(struct evdev_client *client,
 		if (__evdev_is_filtered(client, v->type, v->code))
 			continue;
 
+		event.type = v->type;
+		event.code = v->code;
+		event.value = v->value;
+
+		if (client->ring) {
+			if (__pass_event_ring(client, &event))
+				wakeup = true;
+			continue;
+		}
+
 		if (v->type == EV_SYN && v->code == SYN_REPORT) {
 			/* drop empty SYN_REPORT */
 			if (client->packet_head == client->head)
@@ -284,9 +355,6 @@ static void evdev_pass_values(struct evdev_client *client,
 			wakeup = true;
 		}
 
-		event.type = v->type;
-		event.code = v->code;
-		event.value = v->value;
 		__pass_event(client, &event);
 	}
 
@@ -306,7 +374,7 @@ static void evdev_events(struct input_handle *handle,
 	struct evdev_client *client;
 	ktime_t ev_time[EV_CLK_MAX];
 
-	ev_time[EV_CLK_MONO] = ktime_get();
+	ev_time[EV_CLK_MONO] = input_get_timestamp(handle->dev);
 	ev_time[EV_CLK_REAL] = ktime_mono_to_real(ev_time[EV_CLK_MONO]);
 	ev_time[EV_CLK_BOOT] = ktime_mono_to_any(ev_time[EV_CLK_MONO],
 						 TK_OFFS_BOOT);
@@ -467,6 +535,7 @@ static int evdev_release(struct inode *inode, struct file *file)
 	for (i = 0; i < EV_CNT; ++i)
 		kfree(client->evmasks[i]);
 
+	vfree(client->ring);
 	kvfree(client);
 
 	evdev_close_device(evdev);
@@ -638,12 +707,58 @@ static unsigned int evdev_poll(struct file *file, poll_table *wait)
 	else
 		mask = POLLHUP | POLLERR;
 
-	if (client->packet_head != client->tail)
+	if (!evdev_client_empty(client))
 		mask |= POLLIN | POLLRDNORM;
 
 	return mask;
 }
 
+static int evdev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct evdev_client *client = file->private_data;
+	struct evdev *evdev = client->evdev;
+	struct input_mmap_header *ring;
+	size_t size = sizeof(*ring) +
+			client->bufsize * sizeof(struct input_event);
+	int error = 0;
+
+	/* the ring holds native events only */
+	if (input_event_size() != sizeof(struct input_event))
+		return -EINVAL;
+
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != PAGE_ALIGN(size))
+		return -EINVAL;
+
+	error = mutex_lock_interruptible(&evdev->mutex);
+	if (error)
+		return error;
+
+	if (!evdev->exist || client->revoked) {
+		error = -ENODEV;
+		goto out;
+	}
+
+	ring = client->ring;
+	if (!ring) {
+		ring = vmalloc_user(PAGE_ALIGN(size));
+		if (!ring) {
+			error = -ENOMEM;
+			goto out;
+		}
+		ring->size = client->bufsize;
+
+		/* events queued for read() so far are not carried over */
+		spin_lock_irq(&client->buffer_lock);
+		client->ring = ring;
+		spin_unlock_irq(&client->buffer_lock);
+	}
+
+	error = remap_vmalloc_range(vma, ring, 0);
+out:
+	mutex_unlock(&evdev->mutex);
+	return error;
+}
+
 #ifdef CONFIG_COMPAT
 
 #define BITS_PER_LONG_COMPAT (sizeof(compat_long_t) * 8)
@@ -1314,6 +1429,7 @@ static const struct file_operations evdev_fops = {
 	.read		= evdev_read,
 	.write		= evdev_write,
 	.poll		= evdev_poll,
+	.mmap		= evdev_mmap,
 	.open		= evdev_open,
 	.release	= evdev_release,
 	.unlocked_ioctl	= evdev_ioctl,
@@ -411,6 +411,8 @@ static void input_handle_event(struct input_dev *dev,
 		if (dev->num_vals >= 2)
 			input_pass_values(dev, dev->vals, dev->num_vals);
 		dev->num_vals = 0;
+		/* a stale timestamp must not be reused by the next frame */
+		dev->timestamp = ktime_set(0, 0);
 	} else if (dev->num_vals >= dev->max_vals - 2) {
 		dev->vals[dev->num_vals++] = input_value_sync;
 		input_pass_values(dev, dev->vals, dev->num_vals);
@@ -482,6 +484,40 @@ void input_inject_event(struct input_handle *handle,
 }
 EXPORT_SYMBOL(input_inject_event);
 
+/**
+ * input_set_timestamp - set the timestamp of the current frame
+ * @dev: input device the frame belongs to
+ * @timestamp: CLOCK_MONOTONIC time the frame was captured
+ *
+ * Drivers whose events are reported from a threaded handler should take
+ * the timestamp in their hardirq handler, so that the handler latency
+ * does not show up as input latency. The timestamp applies to all events
+ * up to the next SYN_REPORT.
+ */
+void input_set_timestamp(struct input_dev *dev, ktime_t timestamp)
+{
+	dev->timestamp = timestamp;
+}
+EXPORT_SYMBOL(input_set_timestamp);
+
+/**
+ * input_get_timestamp - get the timestamp of the current frame
+ * @dev: input device the frame belongs to
+ *
+ * Returns the time set with input_set_timestamp(), or the current time
+ * if none was set.
+ */
+ktime_t input_get_timestamp(struct input_dev *dev)
+{
+	ktime_t timestamp = dev->timestamp;
+
+	if (!ktime_to_ns(timestamp))
+		timestamp = ktime_get();
+
+	return timestamp;
+}
+EXPORT_SYMBOL(input_get_timestamp);
+
 /**
  * input_alloc_absinfo - allocates array of input_absinfo structs
  * @dev: the input device emitting absolute events
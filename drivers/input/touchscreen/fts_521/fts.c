@@ -69,6 +69,7 @@
 #include <linux/uaccess.h>
 #include <linux/debugfs.h>
 #include <linux/hwinfo.h>
+#include <linux/cpu_boost.h>
 #ifdef KERNEL_ABOVE_2_6_38
 #include <linux/input/mt.h>
 #endif
@@ -163,6 +164,12 @@ extern const char *dsi_get_display_name(void);
 static irqreturn_t fts_event_handler(int irq, void *ts_info);
 bool wait_queue_complete;
 
+/*
+ * FIFO read buffer: the first event and the rest of the FIFO, each read
+ * preceded by its dummy byte
+ */
+#define FTS_FIFO_BUF_SIZE	(2 * DUMMY_FIFO + FIFO_EVENT_SIZE * FIFO_DEPTH)
+
 
 /**
 * Release all the touches in the linux input subsystem
@@ -3304,6 +3311,21 @@ static void fts_user_report_event_handler(struct fts_ts_info *info,
 
 }
 
+/**
+ * Top Half Interrupt Handler function
+ * Stamps the frame with the time the interrupt pin went low, so the
+ * latency of the bottom half does not show up in the event timestamps
+ */
+static irqreturn_t fts_hard_event_handler(int irq, void *ts_info)
+{
+	struct fts_ts_info *info = ts_info;
+
+	input_set_timestamp(info->input_dev, ktime_get());
+	cpu_boost_kick();
+
+	return IRQ_WAKE_THREAD;
+}
+
 /**
  * Bottom Half Interrupt Handler function
  * This handler is called each time there is at least one new event in the FIFO and the interrupt pin of the IC goes low.
@@ -3313,8 +3335,9 @@ static irqreturn_t fts_event_handler(int irq, void *ts_info)
 {
 	struct fts_ts_info *info = ts_info;
 	int error = 0, count = 0;
-	unsigned char regAdd = FIFO_CMD_READALL;
-	unsigned char data[FIFO_EVENT_SIZE * FIFO_DEPTH] = {0};
+	u8 regAdd = FIFO_CMD_READALL;
+	u8 *first = info->fifo_buf + DUMMY_FIFO;
+	u8 *rest = first + FIFO_EVENT_SIZE + DUMMY_FIFO;
 	unsigned char eventId;
 	const unsigned char EVENTS_REMAINING_POS = 7;
 	const unsigned char EVENTS_REMAINING_MASK = 0x1F;
@@ -3339,24 +3362,30 @@ static irqreturn_t fts_event_handler(int irq, void *ts_info)
 			}
 	}
 	info->irq_status = true;
-	error = fts_writeReadU8UX(regAdd, 0, 0, data, FIFO_EVENT_SIZE,
-				  DUMMY_FIFO);
-	events_remaining = data[EVENTS_REMAINING_POS] & EVENTS_REMAINING_MASK;
+	/*
+	 * Read straight into the preallocated, DMA safe buffer with one
+	 * write-read transfer per FIFO access, instead of bouncing every
+	 * event through the stack buffers of fts_writeReadU8UX()
+	 */
+	error = fts_writeRead(&regAdd, 1, info->fifo_buf,
+			      DUMMY_FIFO + FIFO_EVENT_SIZE);
+	events_remaining = first[EVENTS_REMAINING_POS] & EVENTS_REMAINING_MASK;
 	events_remaining = (events_remaining > FIFO_DEPTH - 1) ?
 				FIFO_DEPTH - 1 : events_remaining;
 
 	/*Drain the rest of the FIFO, up to 31 events*/
 	if (error == OK && events_remaining > 0) {
-		error = fts_writeReadU8UX(regAdd, 0, 0, &data[FIFO_EVENT_SIZE],
-					  FIFO_EVENT_SIZE * events_remaining,
-					  DUMMY_FIFO);
+		error = fts_writeRead(&regAdd, 1, rest - DUMMY_FIFO,
+				      DUMMY_FIFO +
+				      FIFO_EVENT_SIZE * events_remaining);
 	}
 	if (error != OK) {
 		pr_err("Error (%08X) while reading from FIFO in fts_event_handler\n",
 			error);
 	} else {
 		for (count = 0; count < events_remaining + 1; count++) {
-			evt_data = &data[count * FIFO_EVENT_SIZE];
+			evt_data = count ?
+				&rest[(count - 1) * FIFO_EVENT_SIZE] : first;
 
 			if (evt_data[0] == EVT_ID_NOEVENT)
 				break;
@@ -3645,7 +3674,7 @@ static int fts_interrupt_install(struct fts_ts_info *info)
 	/* disable interrupts in any case */
 	error = fts_disableInterrupt();
 	pr_info("%s Interrupt Mode\n", __func__);
-	if (request_threaded_irq(info->client->irq, NULL, fts_event_handler, info->board->irq_flags,
+	if (request_threaded_irq(info->client->irq, fts_hard_event_handler, fts_event_handler, info->board->irq_flags,
 			 FTS_TS_DRV_NAME, info)) {
 		pr_err("Request irq failed\n");
 		kfree(info->event_dispatch_table);
@@ -5119,6 +5148,14 @@ static int fts_probe(struct spi_device *client)
 	info->dev = &info->client->dev;
 	dev_set_drvdata(info->dev, info);
 
+	info->fifo_buf = devm_kzalloc(&client->dev, FTS_FIFO_BUF_SIZE,
+				      GFP_KERNEL | GFP_DMA);
+	if (!info->fifo_buf) {
+		pr_err("ERROR: fifo buffer kzalloc failed\n");
+		error = -ENOMEM;
+		goto ProbeErrorExit_1;
+	}
+
 	if (dp) {
 		info->board =
 		    devm_kzalloc(&client->dev,
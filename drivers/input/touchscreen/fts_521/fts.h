@@ -335,6 +335,7 @@ struct fts_ts_info {
 	atomic_t system_is_resetting;
 	unsigned int fod_status;
 	bool irq_status;
+	u8 *fifo_buf;
 	bool dev_pm_suspend;
 	struct completion dev_pm_suspend_completion;
 };
@@ -26,6 +26,7 @@
 #include <linux/of_irq.h>
 #include <linux/regulator/consumer.h>
 #include <linux/hwinfo.h>
+#include <linux/cpu_boost.h>
 
 #ifdef CONFIG_DRM
 #include <drm/drm_notifier.h>
@@ -1338,6 +1339,24 @@ static int mi_input_event(struct input_dev *dev, unsigned int type, unsigned int
 #endif
 
 #define POINT_DATA_LEN 65
+/*******************************************************
+Description:
+	Novatek touchscreen hard irq handler, takes the event
+	timestamp before the work function runs.
+
+return:
+	IRQ_WAKE_THREAD.
+*******************************************************/
+static irqreturn_t nvt_ts_hard_irq(int irq, void *data)
+{
+	struct nvt_ts_data *ts = data;
+
+	input_set_timestamp(ts->input_dev, ktime_get());
+	cpu_boost_kick();
+
+	return IRQ_WAKE_THREAD;
+}
+
 /*******************************************************
 Description:
 	Novatek touchscreen work function.
@@ -1813,7 +1832,8 @@ static int32_t nvt_ts_probe(struct i2c_client *client, const struct i2c_device_i
 	if (client->irq) {
 		NVT_LOG("int_trigger_type=%d\n", ts->int_trigger_type);
 		ts->irq_enabled = true;
-		ret = request_threaded_irq(client->irq, NULL, nvt_ts_work_func,
+		ret = request_threaded_irq(client->irq, nvt_ts_hard_irq,
+				nvt_ts_work_func,
 				ts->int_trigger_type | IRQF_ONESHOT, NVT_I2C_NAME, ts);
 		if (ret != 0) {
 			NVT_ERR("request irq failed. ret=%d\n", ret);
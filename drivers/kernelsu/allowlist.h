@@ -1,6 +1,8 @@
 #ifndef __KSU_H_ALLOWLIST
 #define __KSU_H_ALLOWLIST
 
+#include "linux/sched.h"
+#include "linux/cred.h"
 #include "linux/types.h"
 #include "ksu.h"
 
@@ -15,6 +17,25 @@ void ksu_show_allow_list(void);
 bool __ksu_is_allow_uid(uid_t uid);
 #define ksu_is_allow_uid(uid) unlikely(__ksu_is_allow_uid(uid))
 
+// bumped whenever a uid is added to or removed from the allowlist
+extern unsigned int ksu_allowlist_gen;
+
+bool __ksu_is_current_denied(void);
+
+/*
+ * Fast path for hooks on hot syscalls: a task remembers that its uid is not
+ * allowed until the uid or the allowlist changes. The cache is copied to
+ * children at fork, so almost every caller returns after these compares.
+ */
+static inline bool ksu_is_current_denied(void)
+{
+	if (likely(current->ksu_denied_gen == READ_ONCE(ksu_allowlist_gen) &&
+		   current->ksu_denied_uid == current_uid().val))
+		return true;
+
+	return __ksu_is_current_denied();
+}
+
 bool ksu_get_allow_list(int *array, int *length, bool allow);
 
 void ksu_prune_allowlist(bool (*is_uid_exist)(uid_t, void *), void *data);
@@ -360,6 +360,14 @@ struct cached_dev {
 	unsigned char		writeback_percent;
 	unsigned		writeback_delay;
 
+	/*
+	 * Bytes of dirty data to accumulate before writing back in one
+	 * burst, zero for the normal rate limited writeback.
+	 */
+	unsigned		writeback_coalesce;
+	bool			writeback_burst;
+	unsigned long		writeback_last_pass;
+
 	uint64_t		writeback_rate_target;
 	int64_t			writeback_rate_proportional;
 	int64_t			writeback_rate_derivative;
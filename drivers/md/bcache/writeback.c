@@ -90,7 +90,8 @@ static void update_writeback_rate(struct work_struct *work)
 static unsigned writeback_delay(struct cached_dev *dc, unsigned sectors)
 {
 	if (test_bit(BCACHE_DEV_DETACHING, &dc->disk.flags) ||
-	    !dc->writeback_percent)
+	    !dc->writeback_percent ||
+	    dc->writeback_coalesce)
 		return 0;
 
 	return bch_next_delay(&dc->writeback_rate, sectors);
@@ -413,12 +414,43 @@ static bool refill_dirty(struct cached_dev *dc)
 	return bkey_cmp(&buf->last_scanned, &start_pos) >= 0;
 }
 
+/*
+ * With writeback_coalesce set, small random writes are left to pile up
+ * in the cache until there's writeback_coalesce bytes of dirty data or
+ * writeback_delay seconds have passed since the last burst.  A burst then
+ * walks the whole index in LBA order without rate limiting, so the
+ * backing device sees large sorted writes that merge in its queue instead
+ * of a trickle of small ones - this is what a flash backing device behind a
+ * RAM cache wants.
+ */
+static bool writeback_coalesce_wait(struct cached_dev *dc)
+{
+	if (!dc->writeback_coalesce || dc->writeback_burst ||
+	    test_bit(BCACHE_DEV_DETACHING, &dc->disk.flags) ||
+	    !atomic_read(&dc->has_dirty) || !dc->writeback_running)
+		return false;
+
+	if (bcache_dev_sectors_dirty(&dc->disk) >= dc->writeback_coalesce >> 9 ||
+	    time_after_eq(jiffies, dc->writeback_last_pass +
+				   dc->writeback_delay * HZ)) {
+		dc->writeback_burst = true;
+		return false;
+	}
+
+	return true;
+}
+
 static int bch_writeback_thread(void *arg)
 {
 	struct cached_dev *dc = arg;
 	bool searched_full_index;
 
 	while (!kthread_should_stop()) {
+		if (writeback_coalesce_wait(dc)) {
+			schedule_timeout_interruptible(HZ);
+			continue;
+		}
+
 		down_write(&dc->writeback_lock);
 		set_current_state(TASK_INTERRUPTIBLE);
 		/*
@@ -467,6 +499,14 @@ static int bch_writeback_thread(void *arg)
 		bch_ratelimit_reset(&dc->writeback_rate);
 		read_dirty(dc);
 
+		if (dc->writeback_coalesce) {
+			if (searched_full_index) {
+				dc->writeback_burst = false;
+				dc->writeback_last_pass = jiffies;
+			}
+			continue;
+		}
+
 		if (searched_full_index) {
 			unsigned delay = dc->writeback_delay * HZ;
 
@@ -525,6 +565,7 @@ void bch_cached_dev_writeback_init(struct cached_dev *dc)
 	dc->writeback_running		= true;
 	dc->writeback_percent		= 10;
 	dc->writeback_delay		= 30;
+	dc->writeback_last_pass		= jiffies;
 	dc->writeback_rate.rate		= 1024;
 
 	dc->writeback_rate_update_seconds = 5;
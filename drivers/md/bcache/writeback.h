@@ -71,6 +71,14 @@ static inline bool should_writeback(struct cached_dev *dc, struct bio *bio,
 	if (bio_op(bio) == REQ_OP_DISCARD)
 		return false;
 
+	/*
+	 * When coalescing, dirty data may sit in the cache for a long time
+	 * (and the cache may well be RAM), so writes that explicitly ask for
+	 * durability go through to the backing device.
+	 */
+	if (dc->writeback_coalesce && (bio->bi_opf & (REQ_FUA|REQ_PREFLUSH)))
+		return false;
+
 	if (dc->partial_stripes_expensive &&
 	    bcache_dev_stripe_dirty(dc, bio->bi_iter.bi_sector,
 				    bio_sectors(bio)))
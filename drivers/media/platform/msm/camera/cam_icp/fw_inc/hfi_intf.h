@@ -62,6 +62,18 @@ struct hfi_mem_info {
  */
 int hfi_write_cmd(void *cmd_ptr);
 
+/**
+ * hfi_write_cmd_batch() - write several commands with a single doorbell
+ * @cmd_ptrs: array of pointers to command data
+ * @num_cmds: number of commands in @cmd_ptrs
+ *
+ * Commands are queued in order until the first failure, the firmware
+ * is interrupted once for everything that was queued.
+ *
+ * Returns success(zero)/failure(non zero)
+ */
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds);
+
 /**
  * hfi_read_message() - function for hfi read
  * @pmsg: buffer to place read message for hfi queue
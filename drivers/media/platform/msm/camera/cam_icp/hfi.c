@@ -93,34 +93,19 @@ void cam_hfi_queue_dump(void)
 		CAM_INFO(CAM_HFI, "Word: %d Data: 0x%08x ", i, read_ptr[i]);
 }
 
-int hfi_write_cmd(void *cmd_ptr)
+/* copy one command into the cmd queue, caller holds hfi_cmd_q_mutex */
+static int hfi_queue_cmd(void *cmd_ptr)
 {
 	uint32_t size_in_words, empty_space, new_write_idx, read_idx, temp;
 	uint32_t *write_q, *write_ptr;
 	struct hfi_qtbl *q_tbl;
 	struct hfi_q_hdr *q;
-	int rc = 0;
 
 	if (!cmd_ptr) {
 		CAM_ERR(CAM_HFI, "command is null");
 		return -EINVAL;
 	}
 
-	mutex_lock(&hfi_cmd_q_mutex);
-	if (!g_hfi) {
-		CAM_ERR(CAM_HFI, "HFI interface not setup");
-		rc = -ENODEV;
-		goto err;
-	}
-
-	if (g_hfi->hfi_state != HFI_READY ||
-		!g_hfi->cmd_q_state) {
-		CAM_ERR(CAM_HFI, "HFI state: %u, cmd q state: %u",
-			g_hfi->hfi_state, g_hfi->cmd_q_state);
-		rc = -ENODEV;
-		goto err;
-	}
-
 	q_tbl = (struct hfi_qtbl *)g_hfi->map.qtbl.kva;
 	q = &q_tbl->q_hdr[Q_CMD];
 
@@ -129,8 +114,7 @@ int hfi_write_cmd(void *cmd_ptr)
 	size_in_words = (*(uint32_t *)cmd_ptr) >> BYTE_WORD_SHIFT;
 	if (!size_in_words) {
 		CAM_DBG(CAM_HFI, "failed");
-		rc = -EINVAL;
-		goto err;
+		return -EINVAL;
 	}
 
 	read_idx = q->qhdr_read_idx;
@@ -140,8 +124,7 @@ int hfi_write_cmd(void *cmd_ptr)
 	if (empty_space <= size_in_words) {
 		CAM_ERR(CAM_HFI, "failed: empty space %u, size_in_words %u",
 			empty_space, size_in_words);
-		rc = -EIO;
-		goto err;
+		return -EIO;
 	}
 
 	new_write_idx = q->qhdr_write_idx + size_in_words;
@@ -166,9 +149,47 @@ int hfi_write_cmd(void *cmd_ptr)
 
 	q->qhdr_write_idx = new_write_idx;
 
+	return 0;
+}
+
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds)
+{
+	uint32_t i, queued = 0;
+	int rc = 0;
+
+	if (!cmd_ptrs || !num_cmds) {
+		CAM_ERR(CAM_HFI, "Invalid batch %pK %u", cmd_ptrs, num_cmds);
+		return -EINVAL;
+	}
+
+	mutex_lock(&hfi_cmd_q_mutex);
+	if (!g_hfi) {
+		CAM_ERR(CAM_HFI, "HFI interface not setup");
+		rc = -ENODEV;
+		goto err;
+	}
+
+	if (g_hfi->hfi_state != HFI_READY ||
+		!g_hfi->cmd_q_state) {
+		CAM_ERR(CAM_HFI, "HFI state: %u, cmd q state: %u",
+			g_hfi->hfi_state, g_hfi->cmd_q_state);
+		rc = -ENODEV;
+		goto err;
+	}
+
+	for (i = 0; i < num_cmds; i++) {
+		rc = hfi_queue_cmd(cmd_ptrs[i]);
+		if (rc)
+			break;
+		queued++;
+	}
+
+	if (!queued)
+		goto err;
+
 	/*
 	 * Before raising interrupt make sure command data is ready for
-	 * firmware to process
+	 * firmware to process, one doorbell covers the whole batch
 	 */
 	wmb();
 	cam_io_w_mb((uint32_t)INTR_ENABLE,
@@ -178,6 +199,28 @@ err:
 	return rc;
 }
 
+int hfi_write_cmd(void *cmd_ptr)
+{
+	return hfi_write_cmd_batch(&cmd_ptr, 1);
+}
+
+static uint32_t hfi_msg_whole_pkts(uint32_t *read_q, uint32_t read_idx,
+	uint32_t q_size, uint32_t avail, uint32_t max_words)
+{
+	uint32_t words = 0, pkt_words;
+
+	while (words < avail) {
+		pkt_words = read_q[read_idx] >> BYTE_WORD_SHIFT;
+		if (!pkt_words || words + pkt_words > max_words ||
+			words + pkt_words > avail)
+			break;
+		words += pkt_words;
+		read_idx = (read_idx + pkt_words) % q_size;
+	}
+
+	return words;
+}
+
 int hfi_read_message(uint32_t *pmsg, uint8_t q_id,
 	uint32_t *words_read)
 {
@@ -246,6 +289,14 @@ int hfi_read_message(uint32_t *pmsg, uint8_t q_id,
 			BYTE_WORD_SHIFT) - word_diff;
 	}
 
+	/*
+	 * Several coalesced messages may be pending, take as many whole
+	 * packets as fit in the caller buffer and leave the rest queued.
+	 */
+	if (size_in_words > size_upper_bound)
+		size_in_words = hfi_msg_whole_pkts(read_q, q->qhdr_read_idx,
+			q->qhdr_q_size, size_in_words, size_upper_bound);
+
 	if ((size_in_words == 0) ||
 		(size_in_words > size_upper_bound)) {
 		CAM_ERR(CAM_HFI, "invalid HFI message packet size - 0x%08x",
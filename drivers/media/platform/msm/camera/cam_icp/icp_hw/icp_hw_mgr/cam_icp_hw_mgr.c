@@ -1398,11 +1398,41 @@ static int cam_icp_mgr_process_cmd(void *priv, void *data)
 	hw_mgr = priv;
 	task_data = (struct hfi_cmd_work_data *)data;
 
-	rc = hfi_write_cmd(task_data->data);
+	/* staged frame commands go out first to keep submission order */
+	hw_mgr->cmd_batch[hw_mgr->num_cmd_batch++] = task_data->data;
+	rc = hfi_write_cmd_batch(hw_mgr->cmd_batch, hw_mgr->num_cmd_batch);
+	hw_mgr->num_cmd_batch = 0;
 
 	return rc;
 }
 
+static int cam_icp_mgr_process_frame_cmd(void *priv, void *data)
+{
+	struct hfi_cmd_work_data *task_data = NULL;
+	struct cam_icp_hw_mgr *hw_mgr;
+
+	if (!data || !priv) {
+		CAM_ERR(CAM_ICP, "Invalid params%pK %pK", data, priv);
+		return -EINVAL;
+	}
+
+	hw_mgr = priv;
+	task_data = (struct hfi_cmd_work_data *)data;
+
+	/*
+	 * While more frame commands sit in the cmd workq, stage this one
+	 * so a burst of requests costs one doorbell, the last command of
+	 * the burst writes the whole batch.
+	 */
+	if (atomic_dec_return(&hw_mgr->frame_cmd_pending) > 0 &&
+		hw_mgr->num_cmd_batch < ICP_CMD_BATCH_MAX - 1) {
+		hw_mgr->cmd_batch[hw_mgr->num_cmd_batch++] = task_data->data;
+		return 0;
+	}
+
+	return cam_icp_mgr_process_cmd(priv, data);
+}
+
 static int cam_icp_mgr_cleanup_ctx(struct cam_icp_hw_ctx_data *ctx_data)
 {
 	int i;
@@ -1943,11 +1973,12 @@ static int cam_icp_process_msg_pkt_type(
 
 static int32_t cam_icp_mgr_process_msg(void *priv, void *data)
 {
-	uint32_t read_len, msg_processed_len;
+	uint32_t read_len, msg_processed_len, irq_status;
 	uint32_t *msg_ptr = NULL;
 	struct hfi_msg_work_data *task_data;
 	struct cam_icp_hw_mgr *hw_mgr;
-	int rc = 0;
+	unsigned long flags;
+	int i, rc = 0;
 
 	if (!data || !priv) {
 		CAM_ERR(CAM_ICP, "Invalid data");
@@ -1957,10 +1988,23 @@ static int32_t cam_icp_mgr_process_msg(void *priv, void *data)
 	task_data = data;
 	hw_mgr = priv;
 
-	rc = hfi_read_message(icp_hw_mgr.msg_buf, Q_MSG, &read_len);
-	if (rc) {
-		CAM_DBG(CAM_ICP, "Unable to read msg q rc %d", rc);
-	} else {
+	/* irqs raised from here on need a new task to be noticed */
+	spin_lock_irqsave(&hw_mgr->hw_mgr_lock, flags);
+	irq_status = task_data->irq_status | hw_mgr->msg_irq_status;
+	hw_mgr->msg_irq_status = 0;
+	hw_mgr->msg_pending = false;
+	spin_unlock_irqrestore(&hw_mgr->hw_mgr_lock, flags);
+
+	/* acks coalesced behind one irq may not fit a single read */
+	for (i = 0; i < ICP_MSG_DRAIN_MAX; i++) {
+		rc = hfi_read_message(icp_hw_mgr.msg_buf, Q_MSG, &read_len);
+		if (rc) {
+			CAM_DBG(CAM_ICP, "Unable to read msg q rc %d", rc);
+			if (i)
+				rc = 0;
+			break;
+		}
+
 		read_len = read_len << BYTE_WORD_SHIFT;
 		msg_ptr = (uint32_t *)icp_hw_mgr.msg_buf;
 		while (true) {
@@ -1982,14 +2026,17 @@ static int32_t cam_icp_mgr_process_msg(void *priv, void *data)
 			else
 				break;
 		}
+
+		if (rc)
+			break;
 	}
 
 	if (icp_hw_mgr.a5_debug_type ==
 		HFI_DEBUG_MODE_QUEUE)
 		cam_icp_mgr_process_dbg_buf();
 
-	if ((task_data->irq_status & A5_WDT_0) ||
-		(task_data->irq_status & A5_WDT_1)) {
+	if ((irq_status & A5_WDT_0) ||
+		(irq_status & A5_WDT_1)) {
 		CAM_ERR_RATE_LIMIT(CAM_ICP, "watch dog interrupt from A5");
 
 		rc = cam_icp_mgr_trigger_recovery(hw_mgr);
@@ -2012,6 +2059,13 @@ int32_t cam_icp_hw_mgr_cb(uint32_t irq_status, void *data)
 	}
 
 	spin_lock_irqsave(&hw_mgr->hw_mgr_lock, flags);
+	/* the queued task drains the whole msg q, fold this irq into it */
+	if (hw_mgr->msg_pending) {
+		hw_mgr->msg_irq_status |= irq_status;
+		spin_unlock_irqrestore(&hw_mgr->hw_mgr_lock, flags);
+		return 0;
+	}
+
 	task = cam_req_mgr_workq_get_task(icp_hw_mgr.msg_work);
 	if (!task) {
 		CAM_ERR(CAM_ICP, "no empty task");
@@ -2026,6 +2080,8 @@ int32_t cam_icp_hw_mgr_cb(uint32_t irq_status, void *data)
 	task->process_cb = cam_icp_mgr_process_msg;
 	rc = cam_req_mgr_workq_enqueue_task(task, &icp_hw_mgr,
 		CRM_TASK_PRIORITY_0);
+	if (!rc)
+		hw_mgr->msg_pending = true;
 	spin_unlock_irqrestore(&hw_mgr->hw_mgr_lock, flags);
 
 	return rc;
@@ -3105,9 +3161,12 @@ static int cam_icp_mgr_enqueue_config(struct cam_icp_hw_mgr *hw_mgr,
 	hfi_cmd = (struct hfi_cmd_ipebps_async *)hw_update_entries->addr;
 	task_data->request_id = request_id;
 	task_data->type = ICP_WORKQ_TASK_CMD_TYPE;
-	task->process_cb = cam_icp_mgr_process_cmd;
+	task->process_cb = cam_icp_mgr_process_frame_cmd;
+	atomic_inc(&hw_mgr->frame_cmd_pending);
 	rc = cam_req_mgr_workq_enqueue_task(task, &icp_hw_mgr,
 		CRM_TASK_PRIORITY_0);
+	if (rc)
+		atomic_dec(&hw_mgr->frame_cmd_pending);
 
 	return rc;
 }
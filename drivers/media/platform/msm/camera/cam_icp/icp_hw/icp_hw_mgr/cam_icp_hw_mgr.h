@@ -47,6 +47,8 @@
 #define ICP_FRAME_PROCESS_SUCCESS 0
 #define ICP_FRAME_PROCESS_FAILURE 1
 #define ICP_MSG_BUF_SIZE        256
+#define ICP_CMD_BATCH_MAX       8
+#define ICP_MSG_DRAIN_MAX       8
 #define ICP_DBG_BUF_SIZE        102400
 
 #define ICP_CLK_HW_IPE          0x0
@@ -317,6 +319,11 @@ struct cam_icp_clk_info {
  * @recovery: Flag to validate if in previous session FW
  *            reported a fatal error or wdt. If set FW is
  *            re-downloaded for new camera session.
+ * @cmd_batch: Frame commands staged for a single doorbell
+ * @num_cmd_batch: Number of staged frame commands
+ * @frame_cmd_pending: Frame command tasks queued but not yet processed
+ * @msg_pending: A message task is queued, further irqs are coalesced
+ * @msg_irq_status: Irq status accumulated while a message task is queued
  */
 struct cam_icp_hw_mgr {
 	struct mutex hw_mgr_mutex;
@@ -365,6 +372,11 @@ struct cam_icp_hw_mgr {
 	bool ipe_clk_state;
 	bool bps_clk_state;
 	bool recovery;
+	void *cmd_batch[ICP_CMD_BATCH_MAX];
+	uint32_t num_cmd_batch;
+	atomic_t frame_cmd_pending;
+	bool msg_pending;
+	uint32_t msg_irq_status;
 };
 
 static int cam_icp_mgr_hw_close(void *hw_priv, void *hw_close_args);
@@ -49,6 +49,7 @@ static void cam_req_mgr_core_link_reset(struct cam_req_mgr_core_link *link)
 	link->sync_link_sof_skip = false;
 	link->open_req_cnt = 0;
 	link->last_flush_id = 0;
+	link->sof_rate_cnt = 0;
 }
 
 void cam_req_mgr_handle_core_shutdown(void)
@@ -1855,6 +1856,43 @@ end:
 	return rc;
 }
 
+/**
+ * __cam_req_mgr_update_rt_prio()
+ *
+ * @brief : Estimate the link frame rate from its SOFs and let the link
+ *          worker priority follow it, so faster links win contention
+ *          with slower ones in multi camera use cases.
+ * @link  : pointer to link whose SOF is being processed
+ *
+ */
+static void __cam_req_mgr_update_rt_prio(struct cam_req_mgr_core_link *link)
+{
+	ktime_t now = ktime_get();
+	s64 window_us;
+	uint32_t fps;
+
+	if (!link->workq->rt_worker)
+		return;
+
+	if (!link->sof_rate_cnt++) {
+		link->sof_rate_ts = now;
+		return;
+	}
+
+	if (link->sof_rate_cnt <= CRM_SOF_RATE_WINDOW)
+		return;
+
+	window_us = ktime_us_delta(now, link->sof_rate_ts);
+	link->sof_rate_ts = now;
+	link->sof_rate_cnt = 1;
+	if (window_us <= 0)
+		return;
+
+	fps = div64_s64((s64)CRM_SOF_RATE_WINDOW * USEC_PER_SEC, window_us);
+	cam_req_mgr_workq_set_rt_prio(link->workq,
+		CAM_WORKQ_RT_PRIO_MIN + fps / 30);
+}
+
 /**
  * cam_req_mgr_process_trigger()
  *
@@ -1889,6 +1927,8 @@ static int cam_req_mgr_process_trigger(void *priv, void *data)
 
 	in_q = link->req.in_q;
 
+	__cam_req_mgr_update_rt_prio(link);
+
 	mutex_lock(&link->req.lock);
 	/*
 	 * Check if current read index is in applied state, if yes make it free
@@ -2525,7 +2565,8 @@ int cam_req_mgr_link(struct cam_req_mgr_link_info *link_info)
 	/* Create worker for current link */
 	snprintf(buf, sizeof(buf), "%x-%x",
 		link_info->session_hdl, link->link_hdl);
-	wq_flag = CAM_WORKQ_FLAG_HIGH_PRIORITY | CAM_WORKQ_FLAG_SERIAL;
+	wq_flag = CAM_WORKQ_FLAG_HIGH_PRIORITY | CAM_WORKQ_FLAG_SERIAL |
+		CAM_WORKQ_FLAG_RT;
 	rc = cam_req_mgr_workq_create(buf, CRM_WORKQ_NUM_TASKS,
 		&link->workq, CRM_WORKQ_USAGE_NON_IRQ, wq_flag);
 	if (rc < 0) {
@@ -32,6 +32,9 @@
 
 #define MAX_SYNC_COUNT 65535
 
+/* num of SOFs over which the link frame rate is estimated */
+#define CRM_SOF_RATE_WINDOW 16
+
 #define SYNC_LINK_SOF_CNT_MAX_LMT 1
 
 #define MAXIMUM_LINKS_PER_SESSION  4
@@ -312,6 +315,8 @@ struct cam_req_mgr_connected_device {
  *                         to be serviced in the kernel.
  * @last_flush_id        : Last request to flush
  * @is_used              : 1 if link is in use else 0
+ * @sof_rate_ts          : start time of the current frame rate window
+ * @sof_rate_cnt         : num of SOFs seen in the current frame rate window
  *
  */
 struct cam_req_mgr_core_link {
@@ -339,6 +344,8 @@ struct cam_req_mgr_core_link {
 	int32_t                              open_req_cnt;
 	uint32_t                             last_flush_id;
 	atomic_t                             is_used;
+	ktime_t                              sof_rate_ts;
+	uint32_t                             sof_rate_cnt;
 };
 
 /**
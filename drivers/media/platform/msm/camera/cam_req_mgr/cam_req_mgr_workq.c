@@ -91,24 +91,27 @@ static int cam_req_mgr_process_task(struct crm_workq_task *task)
 	return 0;
 }
 
+static void cam_req_mgr_workq_update_stats(
+	struct cam_req_mgr_core_workq *workq, struct crm_workq_task *task)
+{
+	uint32_t lat = ktime_us_delta(ktime_get(), task->enq_ts);
+
+	workq->stats.lat_cnt++;
+	workq->stats.lat_total += lat;
+	if (lat > workq->stats.lat_max)
+		workq->stats.lat_max = lat;
+}
+
 /**
- * cam_req_mgr_process_workq() - main loop handling
- * @w: workqueue task pointer
+ * cam_req_mgr_process_tasks() - process pending tasks in priority order
+ * @workq: workq whose tasks shall be processed
  */
-static void cam_req_mgr_process_workq(struct work_struct *w)
+static void cam_req_mgr_process_tasks(struct cam_req_mgr_core_workq *workq)
 {
-	struct cam_req_mgr_core_workq *workq = NULL;
 	struct crm_workq_task         *task;
 	int32_t                        i = CRM_TASK_PRIORITY_0;
 	unsigned long                  flags = 0;
 
-	if (!w) {
-		CAM_ERR(CAM_CRM, "NULL task pointer can not schedule");
-		return;
-	}
-	workq = (struct cam_req_mgr_core_workq *)
-		container_of(w, struct cam_req_mgr_core_workq, work);
-
 	while (i < CRM_TASK_PRIORITY_MAX) {
 		WORKQ_ACQUIRE_LOCK(workq, flags);
 		while (!list_empty(&workq->task.process_head[i])) {
@@ -116,6 +119,7 @@ static void cam_req_mgr_process_workq(struct work_struct *w)
 				struct crm_workq_task, entry);
 			atomic_sub(1, &workq->task.pending_cnt);
 			list_del_init(&task->entry);
+			cam_req_mgr_workq_update_stats(workq, task);
 			WORKQ_RELEASE_LOCK(workq, flags);
 			cam_req_mgr_process_task(task);
 			CAM_DBG(CAM_CRM, "processed task %pK free_cnt %d",
@@ -127,6 +131,64 @@ static void cam_req_mgr_process_workq(struct work_struct *w)
 	}
 }
 
+/**
+ * cam_req_mgr_process_workq() - main loop handling
+ * @w: workqueue task pointer
+ */
+static void cam_req_mgr_process_workq(struct work_struct *w)
+{
+	if (!w) {
+		CAM_ERR(CAM_CRM, "NULL task pointer can not schedule");
+		return;
+	}
+
+	cam_req_mgr_process_tasks(container_of(w,
+		struct cam_req_mgr_core_workq, work));
+}
+
+/**
+ * cam_req_mgr_process_rt_workq() - main loop handling for RT workq
+ * @w: kthread work pointer
+ */
+static void cam_req_mgr_process_rt_workq(struct kthread_work *w)
+{
+	if (!w) {
+		CAM_ERR(CAM_CRM, "NULL task pointer can not schedule");
+		return;
+	}
+
+	cam_req_mgr_process_tasks(container_of(w,
+		struct cam_req_mgr_core_workq, rt_work));
+}
+
+int cam_req_mgr_workq_set_rt_prio(struct cam_req_mgr_core_workq *workq,
+	int32_t prio)
+{
+	struct sched_param param;
+	int rc;
+
+	if (!workq || !workq->rt_worker)
+		return -EINVAL;
+
+	prio = clamp_t(int32_t, prio, CAM_WORKQ_RT_PRIO_MIN,
+		CAM_WORKQ_RT_PRIO_MAX);
+	if (prio == workq->rt_prio)
+		return 0;
+
+	param.sched_priority = prio;
+	rc = sched_setscheduler(workq->rt_worker->task, SCHED_FIFO, &param);
+	if (rc) {
+		CAM_ERR(CAM_CRM, "failed to set rt prio %d rc %d", prio, rc);
+		return rc;
+	}
+
+	CAM_DBG(CAM_CRM, "workq %pK rt prio %d -> %d",
+		workq, workq->rt_prio, prio);
+	workq->rt_prio = prio;
+
+	return 0;
+}
+
 int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 	void *priv, int32_t prio)
 {
@@ -158,12 +220,13 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 		? prio : CRM_TASK_PRIORITY_0;
 
 	WORKQ_ACQUIRE_LOCK(workq, flags);
-		if (!workq->job) {
+		if (!workq->job && !workq->rt_worker) {
 			rc = -EINVAL;
 			WORKQ_RELEASE_LOCK(workq, flags);
 			goto end;
 		}
 
+	task->enq_ts = ktime_get();
 	list_add_tail(&task->entry,
 		&workq->task.process_head[task->priority]);
 
@@ -171,7 +234,10 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 	CAM_DBG(CAM_CRM, "enq task %pK pending_cnt %d",
 		task, atomic_read(&workq->task.pending_cnt));
 
-	queue_work(workq->job, &workq->work);
+	if (workq->rt_worker)
+		kthread_queue_work(workq->rt_worker, &workq->rt_work);
+	else
+		queue_work(workq->job, &workq->work);
 	WORKQ_RELEASE_LOCK(workq, flags);
 end:
 	return rc;
@@ -184,6 +250,7 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 	int32_t i, wq_flags = 0, max_active_tasks = 0;
 	struct crm_workq_task  *task;
 	struct cam_req_mgr_core_workq *crm_workq = NULL;
+	struct sched_param param = { .sched_priority = CAM_WORKQ_RT_PRIO_MIN };
 	char buf[128] = "crm_workq-";
 
 	if (!*workq) {
@@ -202,15 +269,33 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 
 		strlcat(buf, name, sizeof(buf));
 		CAM_DBG(CAM_CRM, "create workque crm_workq-%s", name);
-		crm_workq->job = alloc_workqueue(buf,
-			wq_flags, max_active_tasks, NULL);
-		if (!crm_workq->job) {
-			kfree(crm_workq);
-			return -ENOMEM;
+		if (flags & CAM_WORKQ_FLAG_RT) {
+			crm_workq->rt_worker = kthread_create_worker(0,
+				"%s", buf);
+			if (IS_ERR(crm_workq->rt_worker)) {
+				kfree(crm_workq);
+				return -ENOMEM;
+			}
+
+			if (sched_setscheduler(crm_workq->rt_worker->task,
+				SCHED_FIFO, &param))
+				CAM_WARN(CAM_CRM, "failed to set rt prio %s",
+					buf);
+			else
+				crm_workq->rt_prio = param.sched_priority;
+		} else {
+			crm_workq->job = alloc_workqueue(buf,
+				wq_flags, max_active_tasks, NULL);
+			if (!crm_workq->job) {
+				kfree(crm_workq);
+				return -ENOMEM;
+			}
 		}
 
 		/* Workq attributes initialization */
 		INIT_WORK(&crm_workq->work, cam_req_mgr_process_workq);
+		kthread_init_work(&crm_workq->rt_work,
+			cam_req_mgr_process_rt_workq);
 		spin_lock_init(&crm_workq->lock_bh);
 		CAM_DBG(CAM_CRM, "LOCK_DBG workq %s lock %pK",
 			name, &crm_workq->lock_bh);
@@ -231,6 +316,10 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 			CAM_WARN(CAM_CRM, "Insufficient memory %zu",
 				sizeof(struct crm_workq_task) *
 				crm_workq->task.num_task);
+			if (crm_workq->rt_worker)
+				kthread_destroy_worker(crm_workq->rt_worker);
+			else
+				destroy_workqueue(crm_workq->job);
 			kfree(crm_workq);
 			return -ENOMEM;
 		}
@@ -254,6 +343,7 @@ void cam_req_mgr_workq_destroy(struct cam_req_mgr_core_workq **crm_workq)
 {
 	unsigned long flags = 0;
 	struct workqueue_struct   *job;
+	struct kthread_worker     *rt_worker;
 	CAM_DBG(CAM_CRM, "destroy workque %pK", crm_workq);
 	if (*crm_workq) {
 		WORKQ_ACQUIRE_LOCK(*crm_workq, flags);
@@ -262,6 +352,11 @@ void cam_req_mgr_workq_destroy(struct cam_req_mgr_core_workq **crm_workq)
 			(*crm_workq)->job = NULL;
 			WORKQ_RELEASE_LOCK(*crm_workq, flags);
 			destroy_workqueue(job);
+		} else if ((*crm_workq)->rt_worker) {
+			rt_worker = (*crm_workq)->rt_worker;
+			(*crm_workq)->rt_worker = NULL;
+			WORKQ_RELEASE_LOCK(*crm_workq, flags);
+			kthread_destroy_worker(rt_worker);
 		} else
 			WORKQ_RELEASE_LOCK(*crm_workq, flags);
 		kfree((*crm_workq)->task.pool);
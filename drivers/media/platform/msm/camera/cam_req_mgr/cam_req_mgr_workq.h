@@ -20,6 +20,8 @@
 #include <linux/workqueue.h>
 #include <linux/slab.h>
 #include <linux/timer.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 
 #include "cam_req_mgr_core.h"
 
@@ -32,6 +34,13 @@
  */
 #define CAM_WORKQ_FLAG_SERIAL                    (1 << 1)
 
+/* Flag to run the workq on its own SCHED_FIFO kthread, tasks run serially */
+#define CAM_WORKQ_FLAG_RT                        (1 << 2)
+
+/* SCHED_FIFO priority range used by RT workqs */
+#define CAM_WORKQ_RT_PRIO_MIN                    10
+#define CAM_WORKQ_RT_PRIO_MAX                    30
+
 /* Task priorities, lower the number higher the priority*/
 enum crm_task_priority {
 	CRM_TASK_PRIORITY_0,
@@ -58,6 +67,7 @@ enum crm_workq_context {
  * @priv       : when task is enqueuer caller can attach priv along which
  *               it will get in process callback
  * @ret        : return value in future to use for blocking calls
+ * @enq_ts     : time the task was enqueued, for latency stats
  */
 struct crm_workq_task {
 	int32_t                  priority;
@@ -68,11 +78,15 @@ struct crm_workq_task {
 	uint8_t                  cancel;
 	void                    *priv;
 	int32_t                  ret;
+	ktime_t                  enq_ts;
 };
 
 /** struct cam_req_mgr_core_workq
  * @work       : work token used by workqueue
  * @job        : workqueue internal job struct
+ * @rt_work    : work token used by rt_worker
+ * @rt_worker  : dedicated RT kthread used instead of job, if requested
+ * @rt_prio    : current SCHED_FIFO priority of rt_worker
  * task -
  * @lock_bh    : lock for task structs
  * @in_irq     : set true if workque can be used in irq context
@@ -81,11 +95,18 @@ struct crm_workq_task {
  *               or acquired in order to enqueue a task to workq
  * @pool       : pool of tasks used for handling events in workq context
  * @num_task   : size of tasks pool
+ * stats -
+ * @lat_cnt    : num of tasks dequeued for processing
+ * @lat_total  : total enqueue to dispatch latency in us
+ * @lat_max    : worst enqueue to dispatch latency in us
  * -
  */
 struct cam_req_mgr_core_workq {
 	struct work_struct         work;
 	struct workqueue_struct   *job;
+	struct kthread_work        rt_work;
+	struct kthread_worker     *rt_worker;
+	int32_t                    rt_prio;
 	spinlock_t                 lock_bh;
 	uint32_t                   in_irq;
 
@@ -100,6 +121,13 @@ struct cam_req_mgr_core_workq {
 		struct crm_workq_task *pool;
 		uint32_t               num_task;
 	} task;
+
+	/* stats */
+	struct {
+		uint64_t               lat_cnt;
+		uint64_t               lat_total;
+		uint32_t               lat_max;
+	} stats;
 };
 
 /**
@@ -147,4 +175,14 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 struct crm_workq_task *cam_req_mgr_workq_get_task(
 	struct cam_req_mgr_core_workq *workq);
 
+/**
+ * cam_req_mgr_workq_set_rt_prio()
+ * @brief: Update SCHED_FIFO priority of an RT workq
+ * @workq: workque created with CAM_WORKQ_FLAG_RT
+ * @prio : new priority, clamped to the RT workq priority range
+ * Must be called from process context.
+ */
+int cam_req_mgr_workq_set_rt_prio(struct cam_req_mgr_core_workq *workq,
+	int32_t prio);
+
 #endif
@@ -21,6 +21,7 @@
 #include <linux/msm_dma_iommu_mapping.h>
 #include <linux/workqueue.h>
 #include <linux/genalloc.h>
+#include <linux/shrinker.h>
 #include <soc/qcom/scm.h>
 #include <soc/qcom/secure_buffer.h>
 #include <uapi/media/cam_req_mgr.h>
@@ -43,6 +44,14 @@
 static int g_num_pf_handled = 4;
 module_param(g_num_pf_handled, int, 0644);
 
+/*
+ * Upper bound, per context bank, of released IO region mappings kept
+ * attached so that a re-import of the same dma-buf skips attach, sg
+ * mapping and the iommu lookup. 0 disables the cache.
+ */
+static uint map_cache_kb = 131072;
+module_param(map_cache_kb, uint, 0644);
+
 struct firmware_alloc_info {
 	struct device *fw_dev;
 	void *fw_kva;
@@ -129,6 +138,8 @@ struct cam_context_bank_info {
 
 	struct list_head smmu_buf_list;
 	struct list_head smmu_buf_kernel_list;
+	struct list_head smmu_buf_cache_list;
+	size_t cache_len;
 	struct mutex lock;
 	int handle;
 	enum cam_smmu_ops_param state;
@@ -605,6 +616,8 @@ void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_kernel_list);
+		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_cache_list);
+		iommu_cb_set.cb_info[i].cache_len = 0;
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -967,6 +980,126 @@ static void cam_smmu_clean_kernel_buffer_list(int idx)
 	}
 }
 
+/* unmap least recently released buffers until the cache fits in target */
+static unsigned long cam_smmu_evict_cached_buffers(int idx, size_t target)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *mapping_info;
+	unsigned long freed = 0;
+
+	while (cb->cache_len > target &&
+		!list_empty(&cb->smmu_buf_cache_list)) {
+		mapping_info = list_last_entry(&cb->smmu_buf_cache_list,
+			struct cam_dma_buff_info, list);
+		cb->cache_len -= mapping_info->len;
+		freed += mapping_info->len >> PAGE_SHIFT;
+
+		CAM_DBG(CAM_SMMU, "Evict cached addr %pK, len %zu, idx = %d",
+			(void *)mapping_info->paddr, mapping_info->len, idx);
+
+		if (cam_smmu_unmap_buf_and_remove_from_list(mapping_info,
+			idx) < 0) {
+			CAM_ERR(CAM_SMMU, "Cached buffer delete failed: idx = %d",
+				idx);
+			list_del_init(&mapping_info->list);
+			kfree(mapping_info);
+		}
+	}
+
+	return freed;
+}
+
+/*
+ * Park a released user mapping on the cache list instead of tearing it
+ * down. Only IO region buffers are cached, the shared region is a small
+ * IOVA pool that must not be held by idle buffers.
+ */
+static int cam_smmu_release_user_buffer(
+	struct cam_dma_buff_info *mapping_info, int idx)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	size_t limit = (size_t)map_cache_kb << 10;
+
+	if (mapping_info->region_id != CAM_SMMU_REGION_IO ||
+		mapping_info->len > limit)
+		return cam_smmu_unmap_buf_and_remove_from_list(mapping_info,
+			idx);
+
+	mapping_info->ion_fd = -1;
+	list_move(&mapping_info->list, &cb->smmu_buf_cache_list);
+	cb->cache_len += mapping_info->len;
+	cam_smmu_evict_cached_buffers(idx, limit);
+
+	return 0;
+}
+
+static struct cam_dma_buff_info *cam_smmu_reuse_cached_buffer(int idx,
+	struct dma_buf *buf, enum dma_data_direction dma_dir,
+	enum cam_smmu_region_id region_id)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *mapping_info;
+
+	list_for_each_entry(mapping_info, &cb->smmu_buf_cache_list, list) {
+		if (mapping_info->buf == buf &&
+			mapping_info->dir == dma_dir &&
+			mapping_info->region_id == region_id) {
+			cb->cache_len -= mapping_info->len;
+			list_move(&mapping_info->list, &cb->smmu_buf_list);
+			return mapping_info;
+		}
+	}
+
+	return NULL;
+}
+
+static unsigned long cam_smmu_cache_count(struct shrinker *shrinker,
+	struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	unsigned int i;
+
+	if (!iommu_cb_set.cb_info)
+		return 0;
+
+	for (i = 0; i < iommu_cb_set.cb_num; i++)
+		count += READ_ONCE(iommu_cb_set.cb_info[i].cache_len) >>
+			PAGE_SHIFT;
+
+	return count;
+}
+
+static unsigned long cam_smmu_cache_scan(struct shrinker *shrinker,
+	struct shrink_control *sc)
+{
+	struct cam_context_bank_info *cb;
+	unsigned long freed = 0;
+	size_t want;
+	unsigned int i;
+
+	if (!iommu_cb_set.cb_info)
+		return SHRINK_STOP;
+
+	for (i = 0; i < iommu_cb_set.cb_num && freed < sc->nr_to_scan; i++) {
+		cb = &iommu_cb_set.cb_info[i];
+		/* map paths allocate under this lock, never block on it here */
+		if (!mutex_trylock(&cb->lock))
+			continue;
+		want = (size_t)(sc->nr_to_scan - freed) << PAGE_SHIFT;
+		freed += cam_smmu_evict_cached_buffers(i,
+			cb->cache_len > want ? cb->cache_len - want : 0);
+		mutex_unlock(&cb->lock);
+	}
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker cam_smmu_shrinker = {
+	.count_objects = cam_smmu_cache_count,
+	.scan_objects = cam_smmu_cache_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
 static int cam_smmu_attach(int idx)
 {
 	int ret;
@@ -999,6 +1132,7 @@ static int cam_smmu_detach_device(int idx)
 	if (iommu_cb_set.cb_info[idx].state == CAM_SMMU_DETACH) {
 		rc = -EALREADY;
 	} else if (iommu_cb_set.cb_info[idx].state == CAM_SMMU_ATTACH) {
+		cam_smmu_evict_cached_buffers(idx, 0);
 		arm_iommu_detach_device(cb->dev);
 		iommu_cb_set.cb_info[idx].state = CAM_SMMU_DETACH;
 	}
@@ -1818,6 +1952,21 @@ static int cam_smmu_map_buffer_and_add_to_list(int idx, int ion_fd,
 	/* returns the dma_buf structure related to an fd */
 	buf = dma_buf_get(ion_fd);
 
+	if (!IS_ERR_OR_NULL(buf)) {
+		mapping_info = cam_smmu_reuse_cached_buffer(idx, buf, dma_dir,
+			region_id);
+		if (mapping_info) {
+			/* the cached mapping still holds its own reference */
+			dma_buf_put(buf);
+			mapping_info->ion_fd = ion_fd;
+			*paddr_ptr = mapping_info->paddr;
+			*len_ptr = mapping_info->len;
+			CAM_DBG(CAM_SMMU, "fd %d reused cached addr %pK",
+				ion_fd, (void *)mapping_info->paddr);
+			return 0;
+		}
+	}
+
 	rc = cam_smmu_map_buffer_validate(buf, idx, dma_dir, paddr_ptr, len_ptr,
 		region_id, &mapping_info);
 
@@ -2893,7 +3042,7 @@ int cam_smmu_unmap_user_iova(int handle,
 
 	/* Unmapping one buffer from device */
 	CAM_DBG(CAM_SMMU, "SMMU: removing buffer idx = %d", idx);
-	rc = cam_smmu_unmap_buf_and_remove_from_list(mapping_info, idx);
+	rc = cam_smmu_release_user_buffer(mapping_info, idx);
 	if (rc < 0)
 		CAM_ERR(CAM_SMMU, "Error: unmap or remove list fail");
 
@@ -3033,6 +3182,8 @@ int cam_smmu_destroy_handle(int handle)
 		cam_smmu_clean_user_buffer_list(idx);
 	}
 
+	cam_smmu_evict_cached_buffers(idx, 0);
+
 	if (!list_empty_careful(
 		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list)) {
 		CAM_ERR(CAM_SMMU, "KMD %s buffer list is not clean",
@@ -3517,11 +3668,22 @@ static struct platform_driver cam_smmu_driver = {
 
 static int __init cam_smmu_init_module(void)
 {
-	return platform_driver_register(&cam_smmu_driver);
+	int rc;
+
+	rc = register_shrinker(&cam_smmu_shrinker);
+	if (rc)
+		return rc;
+
+	rc = platform_driver_register(&cam_smmu_driver);
+	if (rc)
+		unregister_shrinker(&cam_smmu_shrinker);
+
+	return rc;
 }
 
 static void __exit cam_smmu_exit_module(void)
 {
+	unregister_shrinker(&cam_smmu_shrinker);
 	platform_driver_unregister(&cam_smmu_driver);
 }
 
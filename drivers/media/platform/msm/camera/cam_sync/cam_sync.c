@@ -33,15 +33,10 @@ int cam_sync_create(int32_t *sync_obj, const char *name)
 {
 	int rc;
 	long idx;
-	bool bit;
 
-	do {
-		idx = find_first_zero_bit(sync_dev->bitmap, CAM_SYNC_MAX_OBJS);
-		if (idx >= CAM_SYNC_MAX_OBJS)
-			return -ENOMEM;
-		CAM_DBG(CAM_SYNC, "Index location available at idx: %ld", idx);
-		bit = test_and_set_bit(idx, sync_dev->bitmap);
-	} while (bit);
+	if (cam_sync_util_alloc_row(&idx))
+		return -ENOMEM;
+	CAM_DBG(CAM_SYNC, "Index location available at idx: %ld", idx);
 
 	spin_lock_bh(&sync_dev->row_spinlocks[idx]);
 	rc = cam_sync_init_row(sync_dev->sync_table, idx, name,
@@ -61,12 +56,13 @@ int cam_sync_create(int32_t *sync_obj, const char *name)
 	return rc;
 }
 
-int cam_sync_register_callback(sync_callback cb_func,
-	void *userdata, int32_t sync_obj)
+static int __cam_sync_register_callback(sync_callback cb_func,
+	void *userdata, int32_t sync_obj, bool inline_cb)
 {
 	struct sync_callback_info *sync_cb;
 	struct sync_callback_info *cb_info;
 	struct sync_table_row *row = NULL;
+	struct list_head cb_list;
 	int status = 0;
 
 	if (sync_obj >= CAM_SYNC_MAX_OBJS || sync_obj <= 0 || !cb_func)
@@ -104,7 +100,7 @@ int cam_sync_register_callback(sync_callback cb_func,
 	if ((row->state == CAM_SYNC_STATE_SIGNALED_SUCCESS ||
 		row->state == CAM_SYNC_STATE_SIGNALED_ERROR) &&
 		(!row->remaining)) {
-		if (trigger_cb_without_switch) {
+		if (trigger_cb_without_switch || inline_cb) {
 			CAM_DBG(CAM_SYNC, "Invoke callback for sync object:%d",
 				sync_obj);
 			status = row->state;
@@ -115,14 +111,13 @@ int cam_sync_register_callback(sync_callback cb_func,
 			sync_cb->callback_func = cb_func;
 			sync_cb->cb_data = userdata;
 			sync_cb->sync_obj = sync_obj;
-			INIT_WORK(&sync_cb->cb_dispatch_work,
-				cam_sync_util_cb_dispatch);
 			sync_cb->status = row->state;
 			CAM_DBG(CAM_SYNC, "Enqueue callback for sync object:%d",
 				sync_cb->sync_obj);
-			queue_work(sync_dev->work_queue,
-				&sync_cb->cb_dispatch_work);
 			spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
+			INIT_LIST_HEAD(&cb_list);
+			list_add_tail(&sync_cb->list, &cb_list);
+			cam_sync_util_run_callbacks(&cb_list);
 		}
 
 		return 0;
@@ -131,13 +126,27 @@ int cam_sync_register_callback(sync_callback cb_func,
 	sync_cb->callback_func = cb_func;
 	sync_cb->cb_data = userdata;
 	sync_cb->sync_obj = sync_obj;
-	INIT_WORK(&sync_cb->cb_dispatch_work, cam_sync_util_cb_dispatch);
+	sync_cb->inline_cb = inline_cb;
 	list_add_tail(&sync_cb->list, &row->callback_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
 
 	return 0;
 }
 
+int cam_sync_register_callback(sync_callback cb_func,
+	void *userdata, int32_t sync_obj)
+{
+	return __cam_sync_register_callback(cb_func, userdata, sync_obj,
+		false);
+}
+
+int cam_sync_register_callback_inline(sync_callback cb_func,
+	void *userdata, int32_t sync_obj)
+{
+	return __cam_sync_register_callback(cb_func, userdata, sync_obj,
+		true);
+}
+
 int cam_sync_deregister_callback(sync_callback cb_func,
 	void *userdata, int32_t sync_obj)
 {
@@ -180,6 +189,7 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status)
 	struct sync_table_row *parent_row = NULL;
 	struct sync_parent_info *parent_info, *temp_parent_info;
 	struct list_head parents_list;
+	struct list_head cb_list;
 	int rc = 0;
 
 	if (sync_obj >= CAM_SYNC_MAX_OBJS || sync_obj <= 0) {
@@ -228,19 +238,18 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status)
 	}
 
 	row->state = status;
-	cam_sync_util_dispatch_signaled_cb(sync_obj, status);
+	INIT_LIST_HEAD(&cb_list);
+	cam_sync_util_dispatch_signaled_cb(sync_obj, status, &cb_list);
 
 	/* copy parent list to local and release child lock */
 	INIT_LIST_HEAD(&parents_list);
 	list_splice_init(&row->parents_list, &parents_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
 
-	if (list_empty(&parents_list))
-		return 0;
-
 	/*
 	 * Now iterate over all parents of this object and if they too need to
-	 * be signaled dispatch cb's
+	 * be signaled collect their cb's, so the child and every merged
+	 * object it completes are dispatched as one batch below.
 	 */
 	list_for_each_entry_safe(parent_info,
 		temp_parent_info,
@@ -264,13 +273,16 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status)
 
 		if (!parent_row->remaining)
 			cam_sync_util_dispatch_signaled_cb(
-				parent_info->sync_id, parent_row->state);
+				parent_info->sync_id, parent_row->state,
+				&cb_list);
 
 		spin_unlock_bh(&sync_dev->row_spinlocks[parent_info->sync_id]);
 		list_del_init(&parent_info->list);
 		kfree(parent_info);
 	}
 
+	cam_sync_util_run_callbacks(&cb_list);
+
 	return 0;
 }
 
@@ -278,7 +290,6 @@ int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 {
 	int rc;
 	long idx = 0;
-	bool bit;
 	int i = 0;
 
 	if (!sync_obj || !merged_obj) {
@@ -306,12 +317,8 @@ int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 		}
 	}
 
-	do {
-		idx = find_first_zero_bit(sync_dev->bitmap, CAM_SYNC_MAX_OBJS);
-		if (idx >= CAM_SYNC_MAX_OBJS)
-			return -ENOMEM;
-		bit = test_and_set_bit(idx, sync_dev->bitmap);
-	} while (bit);
+	if (cam_sync_util_alloc_row(&idx))
+		return -ENOMEM;
 
 	spin_lock_bh(&sync_dev->row_spinlocks[idx]);
 	rc = cam_sync_init_group_object(sync_dev->sync_table,
@@ -1056,6 +1063,11 @@ static int cam_sync_probe(struct platform_device *pdev)
 	 * always
 	 */
 	set_bit(0, sync_dev->bitmap);
+	sync_dev->alloc_hint = 1;
+
+	INIT_LIST_HEAD(&sync_dev->cb_batch_list);
+	spin_lock_init(&sync_dev->cb_batch_lock);
+	INIT_WORK(&sync_dev->cb_batch_work, cam_sync_util_cb_batch_dispatch);
 
 	sync_dev->work_queue = alloc_workqueue(CAM_SYNC_WORKQUEUE_NAME,
 		WQ_HIGHPRI | WQ_UNBOUND, 1);
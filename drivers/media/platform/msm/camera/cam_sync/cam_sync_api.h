@@ -57,6 +57,22 @@ int cam_sync_create(int32_t *sync_obj, const char *name);
 int cam_sync_register_callback(sync_callback cb_func,
 	void *userdata, int32_t sync_obj);
 
+/**
+ * @brief: Registers a callback invoked directly in the signaling context
+ *
+ * Meant for short in-kernel callbacks that only need to record the result;
+ * the callback is called from the context of cam_sync_signal(), possibly
+ * in softirq, and must neither sleep nor call back into the same object.
+ *
+ * @param cb_func:  Pointer to callback to be registered
+ * @param userdata: Opaque pointer which will be passed back with callback.
+ * @param sync_obj: int referencing the sync object.
+ *
+ * @return Status of operation. Zero in case of success.
+ */
+int cam_sync_register_callback_inline(sync_callback cb_func,
+	void *userdata, int32_t sync_obj);
+
 /**
  * @brief: De-registers a callback with a sync object
  *
@@ -100,7 +100,7 @@ struct sync_child_info {
  * @cb_data          : Callback data, registered by client driver
  * @status........   : Status with which callback will be invoked in client
  * @sync_obj         : Sync id of the object for which callback is registered
- * @cb_dispatch_work : Work representing the call dispatch
+ * @inline_cb        : Invoke in the signaling context instead of the workq
  * @list             : List member used to append this node to a linked list
  */
 struct sync_callback_info {
@@ -108,7 +108,7 @@ struct sync_callback_info {
 	void *cb_data;
 	int status;
 	int32_t sync_obj;
-	struct work_struct cb_dispatch_work;
+	bool inline_cb;
 	struct list_head list;
 };
 
@@ -182,8 +182,12 @@ struct cam_signalable_info {
  * @open_cnt        : Count of file open calls made on the sync driver
  * @dentry          : Debugfs entry
  * @work_queue      : Work queue used for dispatching kernel callbacks
+ * @cb_batch_work   : Work dispatching all deferred kernel callbacks
+ * @cb_batch_list   : Deferred kernel callbacks, in signaling order
+ * @cb_batch_lock   : Spinlock protecting cb_batch_list
  * @cam_sync_eventq : Event queue used to dispatch user payloads to user space
  * @bitmap          : Bitmap representation of all sync objects
+ * @alloc_hint      : Bitmap position the next object search starts from
  */
 struct sync_device {
 	struct video_device *vdev;
@@ -194,9 +198,13 @@ struct sync_device {
 	int open_cnt;
 	struct dentry *dentry;
 	struct workqueue_struct *work_queue;
+	struct work_struct cb_batch_work;
+	struct list_head cb_batch_list;
+	spinlock_t cb_batch_lock;
 	struct v4l2_fh *cam_sync_eventq;
 	spinlock_t cam_sync_eventq_lock;
 	DECLARE_BITMAP(bitmap, CAM_SYNC_MAX_OBJS);
+	long alloc_hint;
 };
 
 
@@ -291,21 +291,75 @@ int cam_sync_deinit_object(struct sync_table_row *table, uint32_t idx)
 	return 0;
 }
 
-void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work)
+int cam_sync_util_alloc_row(long *idx)
 {
-	struct sync_callback_info *cb_info = container_of(cb_dispatch_work,
-		struct sync_callback_info,
-		cb_dispatch_work);
+	long start = READ_ONCE(sync_dev->alloc_hint);
+
+	do {
+		*idx = find_next_zero_bit(sync_dev->bitmap,
+			CAM_SYNC_MAX_OBJS, start);
+		if (*idx >= CAM_SYNC_MAX_OBJS) {
+			if (!start)
+				return -ENOMEM;
+			/* wrap around once, bit 0 is always set */
+			start = 0;
+			continue;
+		}
+		start = *idx;
+	} while (test_and_set_bit(*idx, sync_dev->bitmap));
+
+	WRITE_ONCE(sync_dev->alloc_hint, *idx + 1);
+
+	return 0;
+}
+
+void cam_sync_util_cb_batch_dispatch(struct work_struct *cb_batch_work)
+{
+	struct sync_callback_info *cb_info, *temp;
+	struct list_head cb_list;
+
+	INIT_LIST_HEAD(&cb_list);
+
+	spin_lock_bh(&sync_dev->cb_batch_lock);
+	list_splice_init(&sync_dev->cb_batch_list, &cb_list);
+	spin_unlock_bh(&sync_dev->cb_batch_lock);
+
+	list_for_each_entry_safe(cb_info, temp, &cb_list, list) {
+		list_del_init(&cb_info->list);
+		cb_info->callback_func(cb_info->sync_obj,
+			cb_info->status,
+			cb_info->cb_data);
+		kfree(cb_info);
+	}
+}
+
+void cam_sync_util_run_callbacks(struct list_head *cb_list)
+{
+	struct sync_callback_info *cb_info, *temp;
 
-	cb_info->callback_func(cb_info->sync_obj,
-		cb_info->status,
-		cb_info->cb_data);
+	list_for_each_entry_safe(cb_info, temp, cb_list, list) {
+		if (!cb_info->inline_cb)
+			continue;
 
-	kfree(cb_info);
+		list_del_init(&cb_info->list);
+		cb_info->callback_func(cb_info->sync_obj,
+			cb_info->status,
+			cb_info->cb_data);
+		kfree(cb_info);
+	}
+
+	if (list_empty(cb_list))
+		return;
+
+	spin_lock_bh(&sync_dev->cb_batch_lock);
+	list_splice_tail_init(cb_list, &sync_dev->cb_batch_list);
+	spin_unlock_bh(&sync_dev->cb_batch_lock);
+
+	queue_work(sync_dev->work_queue, &sync_dev->cb_batch_work);
 }
 
 void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
-	uint32_t status)
+	uint32_t status, struct list_head *cb_list)
 {
 	struct sync_callback_info  *sync_cb;
 	struct sync_user_payload   *payload_info;
@@ -320,13 +374,11 @@ void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
 		return;
 	}
 
-	/* Dispatch kernel callbacks if any were registered earlier */
+	/* Collect kernel callbacks if any were registered earlier */
 	list_for_each_entry_safe(sync_cb,
 		temp_sync_cb, &signalable_row->callback_list, list) {
 		sync_cb->status = status;
-		list_del_init(&sync_cb->list);
-		queue_work(sync_dev->work_queue,
-			&sync_cb->cb_dispatch_work);
+		list_move_tail(&sync_cb->list, cb_list);
 	}
 
 	/* Dispatch user payloads if any were registered earlier */
@@ -77,25 +77,51 @@ int cam_sync_init_group_object(struct sync_table_row *table,
 int cam_sync_deinit_object(struct sync_table_row *table, uint32_t idx);
 
 /**
- * @brief: Function to dispatch a kernel callback for a sync callback
+ * @brief: Function to allocate a free row in the sync table
  *
- * @param cb_dispatch_work : Pointer to the work_struct that needs to be
- *                           dispatched
+ * The search starts where the previous allocation ended, so concurrent
+ * creators spread over the bitmap instead of racing on its first word.
+ *
+ * @param idx : Pointer to the allocated row index
+ *
+ * @return Status of operation. Negative in case of error. Zero otherwise.
+ */
+int cam_sync_util_alloc_row(long *idx);
+
+/**
+ * @brief: Work function dispatching all batched kernel callbacks
+ *
+ * @param cb_batch_work : Pointer to the sync device batch work
+ *
+ * @return None
+ */
+void cam_sync_util_cb_batch_dispatch(struct work_struct *cb_batch_work);
+
+/**
+ * @brief: Function to run collected kernel callbacks
+ *
+ * Inline callbacks are invoked right away in the caller context, the
+ * rest are handed to the workq in a single batch. Must be called without
+ * any row lock held.
+ *
+ * @cb_list  : List of sync_callback_info to run, emptied on return
  *
  * @return None
  */
-void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work);
+void cam_sync_util_run_callbacks(struct list_head *cb_list);
 
 /**
  * @brief: Function to dispatch callbacks for a signaled sync object
  *
  * @sync_obj : Sync object that is signaled
  * @status   : Status of the signaled object
+ * @cb_list  : List collecting the kernel callbacks of the object, which
+ *             the caller runs with cam_sync_util_run_callbacks()
  *
  * @return None
  */
 void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
-	uint32_t status);
+	uint32_t status, struct list_head *cb_list);
 
 /**
  * @brief: Function to send V4L event to user space
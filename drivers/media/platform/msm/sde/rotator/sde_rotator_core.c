@@ -56,6 +56,9 @@
 /* waiting for inline hw start */
 #define ROT_INLINE_START_TIMEOUT_IN_MS	(10000 + 500)
 
+/* default waiting time for input fence before failing the entry */
+#define ROT_INPUT_FENCE_TIMEOUT_IN_MS	1000
+
 /* default pixel per clock ratio */
 #define ROT_PIXEL_PER_CLK_NUMERATOR	36
 #define ROT_PIXEL_PER_CLK_DENOMINATOR	10
@@ -1241,13 +1244,114 @@ static void sde_rotator_unassign_queue(struct sde_rot_mgr *mgr,
 	}
 }
 
+/*
+ * sde_rotator_input_fence_cb - input fence signal callback
+ * @cb: Pointer to input fence callback context
+ *
+ * Called in fence signal context. Commit work is queued here instead of
+ * blocking the commit queue on the fence, so entries of other sessions
+ * already ready for commit are not held behind this one.
+ */
+static void sde_rotator_input_fence_cb(struct sde_rot_sync_fence_cb *cb)
+{
+	struct sde_rot_entry *entry =
+			container_of(cb, struct sde_rot_entry, input_cb);
+
+	if (atomic_xchg(&entry->fence_armed, 0))
+		kthread_queue_work(&entry->commitq->rot_kw,
+				&entry->commit_work);
+}
+
+/*
+ * sde_rotator_input_fence_timeout_handler - input fence timeout handler
+ * @work: Pointer to work struct.
+ *
+ * Runs on the commit queue; commit work is queued with error status so
+ * the entry is retired through the regular failure path.
+ */
+static void sde_rotator_input_fence_timeout_handler(struct kthread_work *work)
+{
+	struct sde_rot_entry *entry = container_of(work, struct sde_rot_entry,
+			fence_work.work);
+
+	if (!atomic_xchg(&entry->fence_armed, 0))
+		return;
+
+	SDEROT_ERR("timeout waiting for input fence s:%d.%u\n",
+			entry->item.session_id, entry->item.sequence_id);
+	SDEROT_EVTLOG(entry->item.session_id, entry->item.sequence_id,
+			SDE_ROT_EVTLOG_ERROR);
+	sde_rotator_remove_sync_fence_cb(entry->input_fence, &entry->input_cb);
+	entry->fence_status = -ETIMEDOUT;
+	kthread_queue_work(&entry->commitq->rot_kw, &entry->commit_work);
+}
+
+/*
+ * sde_rotator_disarm_input_fence - stop waiting for input fence of entry
+ * @entry: Pointer to rotation entry
+ * @status: error status to commit the entry with if fence is still pending
+ *
+ * On return, no fence callback or timeout can queue commit work anymore.
+ * Caller must not hold the manager lock.
+ */
+static void sde_rotator_disarm_input_fence(struct sde_rot_entry *entry,
+		int status)
+{
+	if (!entry->input_fence || !entry->input_cb.func)
+		return;
+
+	if (atomic_xchg(&entry->fence_armed, 0)) {
+		entry->fence_status = status;
+		kthread_queue_work(&entry->commitq->rot_kw,
+				&entry->commit_work);
+	}
+
+	/* serialize with callback that could be running on fence signal */
+	sde_rotator_remove_sync_fence_cb(entry->input_fence, &entry->input_cb);
+	kthread_cancel_delayed_work_sync(&entry->fence_work);
+}
+
+/*
+ * sde_rotator_queue_commit - queue entry commit once input is available
+ * @entry: Pointer to rotation entry
+ * @timeout: maximum wait time for input fence in msec
+ */
+static void sde_rotator_queue_commit(struct sde_rot_entry *entry,
+		u32 timeout)
+{
+	struct sde_rot_queue *queue = entry->commitq;
+	int ret;
+
+	entry->fence_status = 0;
+
+	if (!entry->input_fence) {
+		kthread_queue_work(&queue->rot_kw, &entry->commit_work);
+		return;
+	}
+
+	/* timeout is armed first, it is cancelled by the commit handler */
+	atomic_set(&entry->fence_armed, 1);
+	kthread_queue_delayed_work(&queue->rot_kw, &entry->fence_work,
+			msecs_to_jiffies(timeout));
+
+	ret = sde_rotator_add_sync_fence_cb(entry->input_fence,
+			&entry->input_cb, sde_rotator_input_fence_cb);
+	if (ret && atomic_xchg(&entry->fence_armed, 0)) {
+		/* already signaled */
+		SDEROT_DBG("input fence signaled s:%d.%u r:%d\n",
+				entry->item.session_id,
+				entry->item.sequence_id, ret);
+		kthread_queue_work(&queue->rot_kw, &entry->commit_work);
+	}
+}
+
 void sde_rotator_queue_request(struct sde_rot_mgr *mgr,
 	struct sde_rot_file_private *private,
 	struct sde_rot_entry_container *req)
 {
 	struct sde_rot_entry *entry;
 	struct sde_rot_queue *queue;
-	u32 wb_idx;
+	u32 wb_idx, timeout;
 	int i;
 
 	if (!mgr || !private || !req) {
@@ -1268,14 +1372,16 @@ void sde_rotator_queue_request(struct sde_rot_mgr *mgr,
 		entry->work_assigned = true;
 	}
 
+	timeout = req->fence_timeout ? req->fence_timeout :
+			ROT_INPUT_FENCE_TIMEOUT_IN_MS;
+
 	for (i = 0; i < req->count; i++) {
 		entry = req->entries + i;
-		queue = entry->commitq;
 		entry->output_fence = NULL;
 
 		if (entry->item.ts)
 			entry->item.ts[SDE_ROTATOR_TS_QUEUE] = ktime_get();
-		kthread_queue_work(&queue->rot_kw, &entry->commit_work);
+		sde_rotator_queue_commit(entry, timeout);
 	}
 }
 
@@ -1505,6 +1611,7 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 	struct sde_rot_hw_resource *hw;
 	struct sde_rot_mgr *mgr;
 	struct sched_param param = { .sched_priority = 5 };
+	bool prepared;
 	int ret;
 
 	entry = container_of(work, struct sde_rot_entry, commit_work);
@@ -1515,6 +1622,9 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 		return;
 	}
 
+	/* input fence is resolved, drop pending timeout on this queue */
+	kthread_cancel_delayed_work_sync(&entry->fence_work);
+
 	ret = sched_setscheduler(entry->fenceq->rot_thread, SCHED_FIFO, &param);
 	if (ret) {
 		SDEROT_WARN("Fail to set kthread priority for fenceq: %d\n",
@@ -1544,10 +1654,41 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 
 	sde_rot_mgr_lock(mgr);
 
+	if (entry->fence_status) {
+		SDEROT_ERR("input fence failed s:%d.%u r:%d\n",
+				entry->item.session_id,
+				entry->item.sequence_id, entry->fence_status);
+		goto smmu_error;
+	}
+
+	ATRACE_INT("sde_smmu_ctrl", 0);
+	ret = sde_smmu_ctrl(1);
+	if (ret < 0) {
+		SDEROT_ERR("IOMMU attach failed\n");
+		goto smmu_error;
+	}
+	ATRACE_INT("sde_smmu_ctrl", 1);
+
+	/*
+	 * Map and validate buffers before waiting for hw availability, so
+	 * this entry is prepared while hw is still busy with earlier ones.
+	 * Secure camera entries switch secure context during mapping, and
+	 * wait for the hw first.
+	 */
+	prepared = !(entry->item.flags & SDE_ROTATION_SECURE_CAMERA);
+	if (prepared) {
+		ret = sde_rotator_map_and_check_data(entry);
+		if (ret) {
+			SDEROT_ERR("fail to prepare input/output data %d\n",
+					ret);
+			goto prepare_error;
+		}
+	}
+
 	hw = sde_rotator_get_hw_resource(entry->commitq, entry);
 	if (!hw) {
 		SDEROT_ERR("no hw for the queue\n");
-		goto get_hw_res_err;
+		goto prepare_error;
 	}
 
 	if (entry->item.ts)
@@ -1565,18 +1706,13 @@ static void sde_rotator_commit_handler(struct kthread_work *work)
 		entry->item.dst_rect.x, entry->item.dst_rect.y,
 		entry->item.dst_rect.w, entry->item.dst_rect.h);
 
-	ATRACE_INT("sde_smmu_ctrl", 0);
-	ret = sde_smmu_ctrl(1);
-	if (ret < 0) {
-		SDEROT_ERR("IOMMU attach failed\n");
-		goto smmu_error;
-	}
-	ATRACE_INT("sde_smmu_ctrl", 1);
-
-	ret = sde_rotator_map_and_check_data(entry);
-	if (ret) {
-		SDEROT_ERR("fail to prepare input/output data %d\n", ret);
-		goto error;
+	if (!prepared) {
+		ret = sde_rotator_map_and_check_data(entry);
+		if (ret) {
+			SDEROT_ERR("fail to prepare input/output data %d\n",
+					ret);
+			goto error;
+		}
 	}
 
 	ret = mgr->ops_config_hw(hw, entry);
@@ -1620,10 +1756,10 @@ kickoff_error:
 	sde_rotator_req_wait_for_idle(mgr, request);
 	mgr->ops_cancel_hw(hw, entry);
 error:
+	sde_rotator_put_hw_resource(entry->commitq, entry, hw);
+prepare_error:
 	sde_smmu_ctrl(0);
 smmu_error:
-	sde_rotator_put_hw_resource(entry->commitq, entry, hw);
-get_hw_res_err:
 	sde_rotator_signal_output(entry);
 	sde_rotator_release_entry(mgr, entry);
 	atomic_dec(&request->pending_count);
@@ -2046,6 +2182,10 @@ static int sde_rotator_add_request(struct sde_rot_mgr *mgr,
 		item = &entry->item;
 		entry->fenceq = private->fenceq;
 
+		/* fences are owned by the entry from here, even on failure */
+		entry->input_fence = item->input.fence;
+		entry->output_fence = item->output.fence;
+
 		ret = sde_rotator_validate_entry(mgr, private, entry);
 		if (ret) {
 			SDEROT_ERR("fail to validate the entry\n");
@@ -2058,9 +2198,6 @@ static int sde_rotator_add_request(struct sde_rot_mgr *mgr,
 			return ret;
 		}
 
-		entry->input_fence = item->input.fence;
-		entry->output_fence = item->output.fence;
-
 		ret = sde_rotator_assign_queue(mgr, entry, private);
 		if (ret) {
 			SDEROT_ERR("fail to assign queue to entry\n");
@@ -2073,6 +2210,8 @@ static int sde_rotator_add_request(struct sde_rot_mgr *mgr,
 				sde_rotator_commit_handler);
 		kthread_init_work(&entry->done_work,
 				sde_rotator_done_handler);
+		kthread_init_delayed_work(&entry->fence_work,
+				sde_rotator_input_fence_timeout_handler);
 		SDEROT_DBG(
 			"Entry added. wbidx=%u, src{%u,%u,%u,%u}f=%x dst{%u,%u,%u,%u}f=%x session_id=%u\n",
 			item->wb_idx,
@@ -2121,6 +2260,7 @@ static void sde_rotator_cancel_request(struct sde_rot_mgr *mgr,
 		sde_rot_mgr_unlock(mgr);
 		for (i = req->count - 1; i >= 0; i--) {
 			entry = req->entries + i;
+			sde_rotator_disarm_input_fence(entry, -ECANCELED);
 			kthread_cancel_work_sync(&entry->commit_work);
 			kthread_cancel_work_sync(&entry->done_work);
 		}
@@ -2543,6 +2683,7 @@ void sde_rotator_abort_inline_request(struct sde_rot_mgr *mgr,
 		mgr->ops_abort_hw(hw, entry);
 
 		sde_rot_mgr_unlock(mgr);
+		sde_rotator_disarm_input_fence(entry, -ECANCELED);
 		kthread_flush_work(commit_work);
 		kthread_flush_work(done_work);
 		sde_rot_mgr_lock(mgr);
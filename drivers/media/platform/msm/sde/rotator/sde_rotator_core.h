@@ -258,6 +258,7 @@ struct sde_rot_queue_v1 {
  * @finished: true if client is finished with the request
  * @retireq: workqueue to post completion notification
  * @retire_work: work for completion notification
+ * @fence_timeout: maximum wait time for input fences in msec, 0 for default
  * @entries: array of rotation entries
  */
 struct sde_rot_entry_container {
@@ -268,6 +269,7 @@ struct sde_rot_entry_container {
 	atomic_t failed_count;
 	struct kthread_worker *retire_kw;
 	struct kthread_work *retire_work;
+	u32 fence_timeout;
 	bool finished;
 	struct sde_rot_entry *entries;
 };
@@ -287,6 +289,10 @@ struct sde_rot_file_private;
  * @src_buf: descriptor of source buffer
  * @dst_buf: descriptor of destination buffer
  * @input_fence: pointer to input fence for when input content is available
+ * @input_cb: input fence callback used to queue commit work once signaled
+ * @fence_work: delayed work to fail the entry if input fence times out
+ * @fence_armed: 1 while commit work is pending on input fence callback
+ * @fence_status: error status of input fence wait, 0 if signaled
  * @output_fence: pointer to output fence for when output content is available
  * @output_signaled: true if output fence of this entry has been signaled
  * @dnsc_factor_w: calculated width downscale factor for this entry
@@ -308,6 +314,10 @@ struct sde_rot_entry {
 	struct sde_mdp_data dst_buf;
 
 	struct sde_rot_sync_fence *input_fence;
+	struct sde_rot_sync_fence_cb input_cb;
+	struct kthread_delayed_work fence_work;
+	atomic_t fence_armed;
+	int fence_status;
 
 	struct sde_rot_sync_fence *output_fence;
 	bool output_signaled;
@@ -3159,33 +3159,6 @@ static int sde_rotator_process_buffers(struct sde_rotator_ctx *ctx,
 		ctx->crop_cap.left, ctx->crop_cap.top,
 		ctx->crop_cap.width, ctx->crop_cap.height);
 
-	if (vbinfo_out->fence) {
-		sde_rot_mgr_unlock(rot_dev->mgr);
-		mutex_unlock(&rot_dev->lock);
-		SDEDEV_DBG(rot_dev->dev, "fence enter s:%d.%d fd:%d\n",
-			ctx->session_id, vbinfo_cap->fence_ts, vbinfo_out->fd);
-		ret = sde_rotator_wait_sync_fence(vbinfo_out->fence,
-				rot_dev->fence_timeout);
-		mutex_lock(&rot_dev->lock);
-		sde_rot_mgr_lock(rot_dev->mgr);
-		sde_rotator_put_sync_fence(vbinfo_out->fence);
-		vbinfo_out->fence = NULL;
-		if (ret) {
-			SDEDEV_ERR(rot_dev->dev,
-				"error waiting for fence s:%d.%d fd:%d r:%d\n",
-				ctx->session_id,
-				vbinfo_cap->fence_ts, vbinfo_out->fd, ret);
-			SDEROT_EVTLOG(ctx->session_id, vbinfo_cap->fence_ts,
-					vbinfo_out->fd, ret,
-					SDE_ROT_EVTLOG_ERROR);
-			goto error_fence_wait;
-		} else {
-			SDEDEV_DBG(rot_dev->dev, "fence exit s:%d.%d fd:%d\n",
-				ctx->session_id,
-				vbinfo_cap->fence_ts, vbinfo_out->fd);
-		}
-	}
-
 	/* fill in item work structure */
 	sde_rotator_get_item_from_ctx(ctx, &item);
 	item.flags |= SDE_ROTATION_EXT_DMA_BUF;
@@ -3194,7 +3167,7 @@ static int sde_rotator_process_buffers(struct sde_rotator_ctx *ctx,
 	item.input.planes[0].offset = src_handle->addr;
 	item.input.planes[0].stride = ctx->format_out.fmt.pix.bytesperline;
 	item.input.plane_count = 1;
-	item.input.fence = NULL;
+	item.input.fence = vbinfo_out->fence;
 	item.input.comp_ratio = vbinfo_out->comp_ratio;
 	item.output.planes[0].buffer = dst_handle->buffer;
 	item.output.planes[0].handle = dst_handle->handle;
@@ -3213,8 +3186,18 @@ static int sde_rotator_process_buffers(struct sde_rotator_ctx *ctx,
 		goto error_init_request;
 	}
 
+	/*
+	 * Input fence is handed over to the request, and the commit is
+	 * queued from the fence callback instead of waiting for it here.
+	 */
+	if (vbinfo_out->fence)
+		SDEDEV_DBG(rot_dev->dev, "fence queue s:%d.%d fd:%d\n",
+			ctx->session_id, vbinfo_cap->fence_ts, vbinfo_out->fd);
+	vbinfo_out->fence = NULL;
+
 	req->retire_kw = ctx->work_queue.rot_kw;
 	req->retire_work = &request->retire_work;
+	req->fence_timeout = rot_dev->fence_timeout;
 
 	ret = sde_rotator_handle_request_common(
 			rot_dev->mgr, ctx->private, req);
@@ -3232,7 +3215,10 @@ static int sde_rotator_process_buffers(struct sde_rotator_ctx *ctx,
 error_handle_request:
 	devm_kfree(rot_dev->dev, req);
 error_init_request:
-error_fence_wait:
+	if (vbinfo_out->fence) {
+		sde_rotator_put_sync_fence(vbinfo_out->fence);
+		vbinfo_out->fence = NULL;
+	}
 error_null_buffer:
 	request->req = NULL;
 	request->sequence_id = 0;
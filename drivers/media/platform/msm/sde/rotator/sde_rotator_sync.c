@@ -399,6 +399,56 @@ int sde_rotator_wait_sync_fence(struct sde_rot_sync_fence *fence,
 	return rc;
 }
 
+static void sde_rotator_sync_fence_cb(struct fence *fence, struct fence_cb *cb)
+{
+	struct sde_rot_sync_fence_cb *rot_cb =
+			container_of(cb, struct sde_rot_sync_fence_cb, base);
+
+	rot_cb->func(rot_cb);
+}
+
+/*
+ * sde_rotator_add_sync_fence_cb - Register callback for fence signal
+ * @fence: Pointer to fence object.
+ * @cb: Pointer to callback context, owned by caller until signaled/removed.
+ * @func: Callback function, invoked in fence signal context.
+ *
+ * Returns 0 if callback is registered, -ENOENT if fence is already
+ * signaled, in which case the callback is never invoked.
+ */
+int sde_rotator_add_sync_fence_cb(struct sde_rot_sync_fence *fence,
+		struct sde_rot_sync_fence_cb *cb,
+		void (*func)(struct sde_rot_sync_fence_cb *cb))
+{
+	if (!fence || !cb || !func) {
+		SDEROT_ERR("invalid parameters\n");
+		return -EINVAL;
+	}
+
+	cb->func = func;
+
+	return fence_add_callback((struct fence *) fence, &cb->base,
+			sde_rotator_sync_fence_cb);
+}
+
+/*
+ * sde_rotator_remove_sync_fence_cb - Unregister fence signal callback
+ * @fence: Pointer to fence object.
+ * @cb: Pointer to callback context registered to the fence.
+ *
+ * On return, the callback is either removed or has completed.
+ */
+void sde_rotator_remove_sync_fence_cb(struct sde_rot_sync_fence *fence,
+		struct sde_rot_sync_fence_cb *cb)
+{
+	if (!fence || !cb) {
+		SDEROT_ERR("invalid parameters\n");
+		return;
+	}
+
+	fence_remove_callback((struct fence *) fence, &cb->base);
+}
+
 /*
  * sde_rotator_get_sync_fence_fd - Get fence object of given file descriptor
  * @fd: File description of fence object.
@@ -16,10 +16,21 @@
 
 #include <linux/types.h>
 #include <linux/errno.h>
+#include <linux/fence.h>
 
 struct sde_rot_sync_fence;
 struct sde_rot_timeline;
 
+/*
+ * struct sde_rot_sync_fence_cb - fence signal callback context
+ * @base: base fence callback object
+ * @func: client callback, invoked in fence signal context
+ */
+struct sde_rot_sync_fence_cb {
+	struct fence_cb base;
+	void (*func)(struct sde_rot_sync_fence_cb *cb);
+};
+
 #if defined(CONFIG_SYNC_FILE)
 struct sde_rot_timeline *sde_rotator_create_timeline(const char *name);
 
@@ -41,6 +52,13 @@ void sde_rotator_put_sync_fence(struct sde_rot_sync_fence *fence);
 int sde_rotator_wait_sync_fence(struct sde_rot_sync_fence *fence,
 		long timeout);
 
+int sde_rotator_add_sync_fence_cb(struct sde_rot_sync_fence *fence,
+		struct sde_rot_sync_fence_cb *cb,
+		void (*func)(struct sde_rot_sync_fence_cb *cb));
+
+void sde_rotator_remove_sync_fence_cb(struct sde_rot_sync_fence *fence,
+		struct sde_rot_sync_fence_cb *cb);
+
 struct sde_rot_sync_fence *sde_rotator_get_fd_sync_fence(int fd);
 
 int sde_rotator_get_sync_fence_fd(struct sde_rot_sync_fence *fence);
@@ -99,6 +117,20 @@ int sde_rotator_wait_sync_fence(struct sde_rot_sync_fence *fence,
 	return 0;
 }
 
+static inline
+int sde_rotator_add_sync_fence_cb(struct sde_rot_sync_fence *fence,
+		struct sde_rot_sync_fence_cb *cb,
+		void (*func)(struct sde_rot_sync_fence_cb *cb))
+{
+	return -ENOENT;
+}
+
+static inline
+void sde_rotator_remove_sync_fence_cb(struct sde_rot_sync_fence *fence,
+		struct sde_rot_sync_fence_cb *cb)
+{
+}
+
 static inline
 struct sde_rot_sync_fence *sde_rotator_get_fd_sync_fence(int fd)
 {
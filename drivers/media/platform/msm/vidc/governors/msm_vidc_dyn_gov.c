@@ -436,8 +436,8 @@ static unsigned long __calculate_decoder(struct vidc_bus_vote_data *d,
 
 	llc_ref_read_l2_cache_enabled = llc_vpss_ds_line_buf_enabled = false;
 	if (d->use_sys_cache) {
-		llc_ref_read_l2_cache_enabled = true;
-		llc_vpss_ds_line_buf_enabled = true;
+		llc_ref_read_l2_cache_enabled = d->llc_ref;
+		llc_vpss_ds_line_buf_enabled = d->llc_line;
 	}
 
 	/* Derived parameters setup */
@@ -682,8 +682,9 @@ static unsigned long __calculate_encoder(struct vidc_bus_vote_data *d,
 		FP_INT(0) : FP_INT(4);
 
 	if (d->use_sys_cache) {
-		llc_dual_core_ref_read_buf_enabled = true;
-		llc_ref_chroma_cache_enabled = true;
+		llc_dual_core_ref_read_buf_enabled = d->llc_ref;
+		llc_ref_chroma_cache_enabled = d->llc_ref;
+		llc_top_line_buf_enabled = d->llc_line;
 	}
 
 	/*
@@ -919,8 +920,31 @@ static int __get_target_freq(struct devfreq *dev, unsigned long *freq)
 		}
 	}
 
-	for (c = 0; c < vidc_data->data_count; ++c)
-		ab_kbps += __calculate(&vidc_data->data[c], gov->mode);
+	if (gov->mode == GOVERNOR_DDR)
+		vidc_data->llc_saved_kbps = 0;
+
+	for (c = 0; c < vidc_data->data_count; ++c) {
+		struct vidc_bus_vote_data no_llc;
+		unsigned long kbps, no_llc_kbps;
+
+		kbps = __calculate(&vidc_data->data[c], gov->mode);
+		ab_kbps += kbps;
+
+		if (gov->mode != GOVERNOR_DDR ||
+				!vidc_data->data[c].use_sys_cache)
+			continue;
+
+		/* what this session would cost DDR without LLC placement */
+		no_llc = vidc_data->data[c];
+		no_llc.use_sys_cache = false;
+		no_llc_kbps = __calculate(&no_llc, gov->mode);
+		if (no_llc_kbps > kbps)
+			vidc_data->llc_saved_kbps += no_llc_kbps - kbps;
+	}
+
+	if (gov->mode == GOVERNOR_DDR && vidc_data->llc_saved_kbps)
+		dprintk(VIDC_PROF, "LLC saves %lu kbps of DDR bandwidth\n",
+			vidc_data->llc_saved_kbps);
 
 exit:
 	*freq = clamp(ab_kbps, dev->min_freq, dev->max_freq ?: UINT_MAX);
@@ -26,6 +26,9 @@
 #define MAX_WIDTH_VALUE 5760
 #define MAX_HEIGHT_VALUE 2880
 
+/* below 720p the DDR saving does not justify sharing the LLC slices */
+#define MSM_VIDC_LLC_MIN_MBS NUM_MBS_PER_FRAME(720, 1280)
+
 static inline void msm_dcvs_print_dcvs_stats(struct clock_data *dcvs)
 {
 	dprintk(VIDC_PROF,
@@ -39,6 +42,63 @@ static inline void msm_dcvs_print_dcvs_stats(struct clock_data *dcvs)
 		dcvs->min_threshold, dcvs->max_threshold);
 }
 
+static size_t msm_vidc_sys_cache_size(struct msm_vidc_core *core)
+{
+	struct subcache_set *subcaches = &core->resources.subcache_set;
+	size_t size = 0;
+	u32 c;
+
+	for (c = 0; c < subcaches->count; c++) {
+		if (subcaches->subcache_tbl[c].isset &&
+				subcaches->subcache_tbl[c].subcache)
+			size += subcaches->subcache_tbl[c].subcache->
+				llcc_slice_size;
+	}
+
+	return size;
+}
+
+/*
+ * Decide which buffers of each session are worth LLC placement. Line
+ * buffers are small and always fit. Reference reads only hit when the
+ * reference rows touched by one LCU row (current and next row, twice
+ * with B frames) of every eligible session fit in the slices together.
+ */
+static void msm_vidc_decide_sys_cache(struct msm_vidc_core *core,
+	struct vidc_bus_vote_data *vote_data, int count)
+{
+	size_t llc_size, ref_bytes = 0;
+	u32 mbs;
+	int i;
+
+	llc_size = msm_vidc_sys_cache_size(core);
+
+	for (i = 0; i < count; i++) {
+		struct vidc_bus_vote_data *d = &vote_data[i];
+
+		mbs = NUM_MBS_PER_FRAME(d->output_height, d->output_width);
+		d->llc_ref = d->llc_line = false;
+		if (!d->use_sys_cache || mbs < MSM_VIDC_LLC_MIN_MBS) {
+			d->use_sys_cache = false;
+			continue;
+		}
+
+		d->llc_line = true;
+		ref_bytes += (size_t)d->output_width * d->lcu_size * 2 * 3 / 2 *
+			(d->b_frames_enabled ? 2 : 1);
+	}
+
+	for (i = 0; i < count; i++) {
+		struct vidc_bus_vote_data *d = &vote_data[i];
+
+		if (d->use_sys_cache)
+			d->llc_ref = ref_bytes <= llc_size;
+	}
+
+	dprintk(VIDC_PROF, "LLC %zu bytes, ref rows %zu bytes: ref %s\n",
+		llc_size, ref_bytes, ref_bytes <= llc_size ? "on" : "off");
+}
+
 static inline unsigned long int get_ubwc_compression_ratio(
 	struct ubwc_cr_stats_info_type ubwc_stats_info)
 {
@@ -309,6 +369,10 @@ int msm_comm_vote_bus(struct msm_vidc_core *core)
 		i++;
 	}
 	mutex_unlock(&core->lock);
+
+	if (core->resources.sys_cache_res_set)
+		msm_vidc_decide_sys_cache(core, vote_data, vote_data_count);
+
 	if (vote_data_count)
 		rc = call_hfi_op(hdev, vote_bus, hdev->hfi_device_data,
 			vote_data, vote_data_count);
@@ -618,6 +682,34 @@ exit:
 
 
 
+/*
+ * Track a running average and mean deviation of the bitstream size of
+ * queued frames (1/8 and 1/4 gain). The next frame is predicted as
+ * average plus twice the deviation, so a VBR stream is clocked for its
+ * typical frame plus margin rather than for the largest frame queued.
+ */
+static void msm_vidc_update_frame_bits(struct clock_data *dcvs,
+	u32 filled_len, u32 device_addr)
+{
+	s64 bits = (s64)filled_len * 8;
+	s64 err;
+
+	/* the same ETB is seen again until it is consumed */
+	if (device_addr == dcvs->frame_bits_addr)
+		return;
+	dcvs->frame_bits_addr = device_addr;
+
+	if (!dcvs->frame_bits_avg) {
+		dcvs->frame_bits_avg = bits;
+		dcvs->frame_bits_dev = bits / 2;
+	} else {
+		err = bits - dcvs->frame_bits_avg;
+		dcvs->frame_bits_avg += div_s64(err, 8);
+		dcvs->frame_bits_dev += div_s64(abs(err) -
+			(s64)dcvs->frame_bits_dev, 4);
+	}
+}
+
 static unsigned long msm_vidc_calc_freq(struct msm_vidc_inst *inst,
 	u32 filled_len)
 {
@@ -631,6 +723,7 @@ static unsigned long msm_vidc_calc_freq(struct msm_vidc_inst *inst,
 	u64 rate = 0;
 	struct clock_data *dcvs = NULL;
 	u32 operating_rate, vsp_factor_num = 10, vsp_factor_den = 7;
+	u64 frame_bits;
 
 	core = inst->core;
 	dcvs = &inst->clk_data;
@@ -670,8 +763,14 @@ static unsigned long msm_vidc_calc_freq(struct msm_vidc_inst *inst,
 		vpp_cycles = mbs_per_second * inst->clk_data.entry->vpp_cycles;
 
 		vsp_cycles = mbs_per_second * inst->clk_data.entry->vsp_cycles;
+
+		frame_bits = (u64)filled_len * 8;
+		if (msm_vidc_dcvs_bitrate_model && dcvs->dcvs_mode &&
+			dcvs->frame_bits_avg)
+			frame_bits = dcvs->frame_bits_avg +
+				2 * dcvs->frame_bits_dev;
 		/* 10 / 7 is overhead factor */
-		vsp_cycles += ((inst->prop.fps * filled_len * 8) * 10) / 7;
+		vsp_cycles += div_u64(inst->prop.fps * frame_bits * 10, 7);
 
 	} else {
 		dprintk(VIDC_ERR, "Unknown session type = %s\n", __func__);
@@ -827,6 +926,7 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 	struct msm_vidc_buffer *temp, *next;
 	unsigned long freq = 0;
 	u32 filled_len = 0;
+	u32 last_len = 0;
 	u32 device_addr = 0;
 	bool is_turbo = false;
 
@@ -849,6 +949,7 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 				is_turbo = true;
 			}
 			device_addr = temp->smem[0].device_addr;
+			last_len = temp->vvb.vb2_buf.planes[0].bytesused;
 		}
 	}
 	mutex_unlock(&inst->registeredbufs.lock);
@@ -858,6 +959,10 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 		goto no_clock_change;
 	}
 
+	if (inst->session_type == MSM_VIDC_DECODER)
+		msm_vidc_update_frame_bits(&inst->clk_data, last_len,
+			device_addr);
+
 	freq = msm_vidc_calc_freq(inst, filled_len);
 
 	msm_vidc_update_freq_entry(inst, freq, device_addr, is_turbo);
@@ -1021,6 +1126,9 @@ void msm_clock_data_reset(struct msm_vidc_inst *inst)
 	}
 
 	dcvs->load = dcvs->load_norm = rate;
+	dcvs->frame_bits_avg = 0;
+	dcvs->frame_bits_dev = 0;
+	dcvs->frame_bits_addr = 0;
 
 	dcvs->load_low = i < (core->resources.allowed_clks_tbl_size - 1) ?
 		allowed_clks_tbl[i+1].clock_rate : dcvs->load_norm;
@@ -4289,7 +4289,7 @@ int msm_comm_qbuf(struct msm_vidc_inst *inst, struct msm_vidc_buffer *mbuf)
 		struct vidc_frame_data *data;
 		int count;
 	} etbs, ftbs;
-	bool defer = false, batch_mode;
+	bool defer = false, batch_mode, per_buffer;
 	struct msm_vidc_buffer *temp = NULL, *next = NULL;
 
 	if (!inst) {
@@ -4440,7 +4440,34 @@ int msm_comm_qbuf(struct msm_vidc_inst *inst, struct msm_vidc_buffer *mbuf)
 		}
 	}
 
-	if (!batch_mode && etbs.count) {
+	/*
+	 * Outside of batch mode all collected buffers still go down in one
+	 * call so the device lock is taken and venus interrupted only once.
+	 * HEIC tiles need per tile packets and keep the per buffer path.
+	 */
+	per_buffer = !batch_mode && is_heic_encode_session(inst);
+	if (!batch_mode && !per_buffer && (etbs.count || ftbs.count)) {
+		int c = 0;
+
+		rc = call_hfi_op(hdev, session_queue_buffers, inst->session,
+				etbs.count, etbs.data, ftbs.count, ftbs.data);
+		if (rc) {
+			dprintk(VIDC_ERR,
+				"Failed to queue %d ETBs and %d FTBs: %d\n",
+				etbs.count, ftbs.count, rc);
+			goto err_bad_input;
+		}
+
+		for (c = 0; c < etbs.count; ++c)
+			log_frame(inst, &etbs.data[c],
+					V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE);
+
+		for (c = 0; c < ftbs.count; ++c)
+			log_frame(inst, &ftbs.data[c],
+					V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+	}
+
+	if (per_buffer && etbs.count) {
 		int c = 0;
 
 		for (c = 0; c < etbs.count; ++c) {
@@ -4471,7 +4498,7 @@ int msm_comm_qbuf(struct msm_vidc_inst *inst, struct msm_vidc_buffer *mbuf)
 		}
 	}
 
-	if (!batch_mode && ftbs.count) {
+	if (per_buffer && ftbs.count) {
 		int c = 0;
 
 		for (; c < ftbs.count; ++c) {
@@ -61,6 +61,7 @@ extern bool msm_vidc_fw_coverage;
 extern bool msm_vidc_sys_idle_indicator;
 extern bool msm_vidc_thermal_mitigation_disabled;
 extern bool msm_vidc_clock_scaling;
+extern bool msm_vidc_dcvs_bitrate_model;
 extern bool msm_vidc_syscache_disable;
 
 #define VIDC_MSG_PRIO2STRING(__level) ({ \
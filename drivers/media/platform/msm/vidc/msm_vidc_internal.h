@@ -325,6 +325,9 @@ struct clock_data {
 	enum hal_work_mode work_mode;
 	bool low_latency_mode;
 	bool turbo_mode;
+	u32 frame_bits_avg;
+	u32 frame_bits_dev;
+	u32 frame_bits_addr;
 };
 
 struct profile_data {
@@ -1244,6 +1244,23 @@ err_q_null:
 	return result;
 }
 
+/*
+ * Write a packet without raising the cmdq interrupt. When pending_int is
+ * not NULL it accumulates whether the consumer asked for one, so that a
+ * batch of packets can be followed by a single interrupt.
+ */
+static int __iface_cmdq_write_batched(struct venus_hfi_device *device,
+		void *pkt, bool *pending_int)
+{
+	bool needs_interrupt = false;
+	int rc = __iface_cmdq_write_relaxed(device, pkt, &needs_interrupt);
+
+	if (!rc && pending_int)
+		*pending_int |= needs_interrupt;
+
+	return rc;
+}
+
 static int __iface_cmdq_write(struct venus_hfi_device *device, void *pkt)
 {
 	bool needs_interrupt = false;
@@ -2436,7 +2453,8 @@ static int venus_hfi_session_stop(void *session)
 }
 
 static int __session_etb(struct hal_session *session,
-		struct vidc_frame_data *input_frame, bool relaxed)
+		struct vidc_frame_data *input_frame, bool relaxed,
+		bool *pending_int)
 {
 	int rc = 0;
 	struct venus_hfi_device *device = session->device;
@@ -2458,8 +2476,8 @@ static int __session_etb(struct hal_session *session,
 		if (!relaxed)
 			rc = __iface_cmdq_write(session->device, &pkt);
 		else
-			rc = __iface_cmdq_write_relaxed(session->device,
-					&pkt, NULL);
+			rc = __iface_cmdq_write_batched(session->device,
+					&pkt, pending_int);
 		if (rc)
 			goto err_create_pkt;
 	} else {
@@ -2477,8 +2495,8 @@ static int __session_etb(struct hal_session *session,
 		if (!relaxed)
 			rc = __iface_cmdq_write(session->device, &pkt);
 		else
-			rc = __iface_cmdq_write_relaxed(session->device,
-					&pkt, NULL);
+			rc = __iface_cmdq_write_batched(session->device,
+					&pkt, pending_int);
 		if (rc)
 			goto err_create_pkt;
 	}
@@ -2501,13 +2519,14 @@ static int venus_hfi_session_etb(void *sess,
 
 	device = session->device;
 	mutex_lock(&device->lock);
-	rc = __session_etb(session, input_frame, false);
+	rc = __session_etb(session, input_frame, false, NULL);
 	mutex_unlock(&device->lock);
 	return rc;
 }
 
 static int __session_ftb(struct hal_session *session,
-		struct vidc_frame_data *output_frame, bool relaxed)
+		struct vidc_frame_data *output_frame, bool relaxed,
+		bool *pending_int)
 {
 	int rc = 0;
 	struct venus_hfi_device *device = session->device;
@@ -2526,8 +2545,8 @@ static int __session_ftb(struct hal_session *session,
 	if (!relaxed)
 		rc = __iface_cmdq_write(session->device, &pkt);
 	else
-		rc = __iface_cmdq_write_relaxed(session->device,
-				&pkt, NULL);
+		rc = __iface_cmdq_write_batched(session->device,
+				&pkt, pending_int);
 
 err_create_pkt:
 	return rc;
@@ -2547,7 +2566,7 @@ static int venus_hfi_session_ftb(void *sess,
 
 	device = session->device;
 	mutex_lock(&device->lock);
-	rc = __session_ftb(session, output_frame, false);
+	rc = __session_ftb(session, output_frame, false, NULL);
 	mutex_unlock(&device->lock);
 	return rc;
 }
@@ -2576,7 +2595,7 @@ static int venus_hfi_session_process_batch(void *sess,
 	}
 
 	for (c = 0; c < num_ftbs; ++c) {
-		rc = __session_ftb(session, &ftbs[c], true);
+		rc = __session_ftb(session, &ftbs[c], true, NULL);
 		if (rc) {
 			dprintk(VIDC_ERR, "Failed to queue batched ftb: %d\n",
 					rc);
@@ -2585,7 +2604,7 @@ static int venus_hfi_session_process_batch(void *sess,
 	}
 
 	for (c = 0; c < num_etbs; ++c) {
-		rc = __session_etb(session, &etbs[c], true);
+		rc = __session_etb(session, &etbs[c], true, NULL);
 		if (rc) {
 			dprintk(VIDC_ERR, "Failed to queue batched etb: %d\n",
 					rc);
@@ -2607,6 +2626,51 @@ err_etbs_and_ftbs:
 	return rc;
 }
 
+static int venus_hfi_session_queue_buffers(void *sess,
+		int num_etbs, struct vidc_frame_data etbs[],
+		int num_ftbs, struct vidc_frame_data ftbs[])
+{
+	int rc = 0, c = 0;
+	bool pending_int = false;
+	struct hal_session *session = sess;
+	struct venus_hfi_device *device;
+
+	if (!session || !session->device) {
+		dprintk(VIDC_ERR, "%s: Invalid Params\n", __func__);
+		return -EINVAL;
+	}
+
+	device = session->device;
+
+	mutex_lock(&device->lock);
+
+	for (c = 0; c < num_etbs; ++c) {
+		rc = __session_etb(session, &etbs[c], true, &pending_int);
+		if (rc) {
+			dprintk(VIDC_ERR, "Failed to queue etb %d: %d\n",
+					c, rc);
+			goto err_queue;
+		}
+	}
+
+	for (c = 0; c < num_ftbs; ++c) {
+		rc = __session_ftb(session, &ftbs[c], true, &pending_int);
+		if (rc) {
+			dprintk(VIDC_ERR, "Failed to queue ftb %d: %d\n",
+					c, rc);
+			goto err_queue;
+		}
+	}
+
+err_queue:
+	/* one interrupt covers everything written, even on partial failure */
+	if (pending_int)
+		__write_register(device, VIDC_CPU_IC_SOFTINT,
+				1 << VIDC_CPU_IC_SOFTINT_H2A_SHFT);
+	mutex_unlock(&device->lock);
+	return rc;
+}
+
 static int venus_hfi_session_get_buf_req(void *sess)
 {
 	struct hfi_cmd_session_get_property_packet pkt;
@@ -4645,6 +4709,7 @@ static void venus_init_hfi_callbacks(struct hfi_device *hdev)
 	hdev->session_etb = venus_hfi_session_etb;
 	hdev->session_ftb = venus_hfi_session_ftb;
 	hdev->session_process_batch = venus_hfi_session_process_batch;
+	hdev->session_queue_buffers = venus_hfi_session_queue_buffers;
 	hdev->session_get_buf_req = venus_hfi_session_get_buf_req;
 	hdev->session_flush = venus_hfi_session_flush;
 	hdev->session_set_property = venus_hfi_session_set_property;
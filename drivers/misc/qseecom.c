@@ -2996,6 +2996,26 @@ static uintptr_t __qseecom_uvirt_to_kvirt(struct qseecom_dev_handle *data,
 				(virt - data->client.user_virt_sb_base);
 }
 
+/*
+ * Cache maintenance of one request or response inside the client shared
+ * buffer. The buffer stays mapped for the life of the session, so this
+ * and the scm call are all a command costs; sessions with large shared
+ * buffers no longer pay for maintenance of the whole buffer every time.
+ */
+static int __qseecom_sb_cache_op(struct qseecom_dev_handle *data,
+				void *ubuf, uint32_t len, unsigned int op)
+{
+	unsigned long offset;
+
+	if (!len)
+		return 0;
+
+	offset = (uintptr_t)ubuf - data->client.user_virt_sb_base;
+	return msm_ion_do_cache_offset_op(qseecom.ion_clnt,
+				data->client.ihandle, data->client.sb_virt,
+				offset, len, op);
+}
+
 int __qseecom_process_rpmb_svc_cmd(struct qseecom_dev_handle *data_ptr,
 		struct qseecom_send_svc_cmd_req *req_ptr,
 		struct qseecom_client_send_service_ireq *send_svc_ireq_ptr)
@@ -3405,7 +3425,6 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 {
 	int ret = 0;
 	int ret2 = 0;
-	u32 reqd_len_sb_in = 0;
 	struct qseecom_client_send_data_ireq send_data_req = {0};
 	struct qseecom_client_send_data_64bit_ireq send_data_req_64bit = {0};
 	struct qseecom_command_scm_resp resp;
@@ -3416,7 +3435,6 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	size_t cmd_len;
 	struct sglist_info *table = data->sglistinfo_ptr;
 
-	reqd_len_sb_in = req->cmd_req_len + req->resp_len;
 	/* find app_id & img_name from list */
 	spin_lock_irqsave(&qseecom.registered_app_list_lock, flags);
 	list_for_each_entry(ptr_app, &qseecom.registered_app_list_head,
@@ -3493,10 +3511,11 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	else
 		*(uint32_t *)cmd_buf = QSEOS_CLIENT_SEND_DATA_COMMAND_WHITELIST;
 
-	ret = msm_ion_do_cache_op(qseecom.ion_clnt, data->client.ihandle,
-					data->client.sb_virt,
-					reqd_len_sb_in,
+	ret = __qseecom_sb_cache_op(data, req->cmd_req_buf, req->cmd_req_len,
 					ION_IOC_CLEAN_INV_CACHES);
+	if (!ret)
+		ret = __qseecom_sb_cache_op(data, req->resp_buf,
+					req->resp_len, ION_IOC_CLEAN_INV_CACHES);
 	if (ret) {
 		pr_err("cache operation failed %d\n", ret);
 		return ret;
@@ -3535,9 +3554,12 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 		}
 	}
 exit:
-	ret2 = msm_ion_do_cache_op(qseecom.ion_clnt, data->client.ihandle,
-				data->client.sb_virt, data->client.sb_length,
+	/* the app is only handed the request and the response */
+	ret2 = __qseecom_sb_cache_op(data, req->cmd_req_buf, req->cmd_req_len,
 				ION_IOC_INV_CACHES);
+	if (!ret2)
+		ret2 = __qseecom_sb_cache_op(data, req->resp_buf,
+				req->resp_len, ION_IOC_INV_CACHES);
 	if (ret2) {
 		pr_err("cache operation failed %d\n", ret2);
 		return ret2;
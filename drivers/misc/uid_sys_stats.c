@@ -21,6 +21,7 @@
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/mm.h>
+#include <linux/moduleparam.h>
 #include <linux/proc_fs.h>
 #include <linux/profile.h>
 #include <linux/rtmutex.h>
@@ -38,6 +39,19 @@ static struct proc_dir_entry *cpu_parent;
 static struct proc_dir_entry *io_parent;
 static struct proc_dir_entry *proc_parent;
 
+/*
+ * The live part of the stats needs a walk of all threads. It is shared
+ * by both stats files and reused for refresh_ms, unless a task exits in
+ * between: exiting tasks move their share to the dead part, which would
+ * then be counted twice.
+ */
+static unsigned int refresh_ms = 100;
+module_param(refresh_ms, uint, 0644);
+MODULE_PARM_DESC(refresh_ms, "Maximum age of the live task stats in ms");
+
+static bool stats_valid;
+static unsigned long stats_stamp;
+
 struct io_stats {
 	u64 read_bytes;
 	u64 write_bytes;
@@ -329,41 +343,22 @@ static struct uid_entry *find_or_register_uid(uid_t uid)
 	return uid_entry;
 }
 
+static int update_stats_locked(void);
+
 static int uid_cputime_show(struct seq_file *m, void *v)
 {
 	struct uid_entry *uid_entry = NULL;
-	struct task_struct *task, *temp;
-	struct user_namespace *user_ns = current_user_ns();
-	cputime_t utime;
-	cputime_t stime;
 	unsigned long bkt;
-	uid_t uid;
+	int ret;
 
 	rt_mutex_lock(&uid_lock);
 
-	hash_for_each(hash_table, bkt, uid_entry, hash) {
-		uid_entry->active_stime = 0;
-		uid_entry->active_utime = 0;
+	ret = update_stats_locked();
+	if (ret) {
+		rt_mutex_unlock(&uid_lock);
+		return ret;
 	}
 
-	rcu_read_lock();
-	do_each_thread(temp, task) {
-		uid = from_kuid_munged(user_ns, task_uid(task));
-		if (!uid_entry || uid_entry->uid != uid)
-			uid_entry = find_or_register_uid(uid);
-		if (!uid_entry) {
-			rcu_read_unlock();
-			rt_mutex_unlock(&uid_lock);
-			pr_err("%s: failed to find the uid_entry for uid %d\n",
-				__func__, uid);
-			return -ENOMEM;
-		}
-		task_cputime_adjusted(task, &utime, &stime);
-		uid_entry->active_utime += utime;
-		uid_entry->active_stime += stime;
-	} while_each_thread(temp, task);
-	rcu_read_unlock();
-
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
 		cputime_t total_utime = uid_entry->utime +
 							uid_entry->active_utime;
@@ -465,15 +460,20 @@ static void add_uid_io_stats(struct uid_entry *uid_entry,
 	add_uid_tasks_io_stats(uid_entry, task, slot);
 }
 
-static void update_io_stats_all_locked(void)
+/* cpu time and io of the live tasks, in one walk */
+static int update_stats_all_locked(void)
 {
 	struct uid_entry *uid_entry = NULL;
 	struct task_struct *task, *temp;
 	struct user_namespace *user_ns = current_user_ns();
+	cputime_t utime;
+	cputime_t stime;
 	unsigned long bkt;
 	uid_t uid;
 
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
+		uid_entry->active_stime = 0;
+		uid_entry->active_utime = 0;
 		memset(&uid_entry->io[UID_STATE_TOTAL_CURR], 0,
 			sizeof(struct io_stats));
 		set_io_uid_tasks_zero(uid_entry);
@@ -484,8 +484,15 @@ static void update_io_stats_all_locked(void)
 		uid = from_kuid_munged(user_ns, task_uid(task));
 		if (!uid_entry || uid_entry->uid != uid)
 			uid_entry = find_or_register_uid(uid);
-		if (!uid_entry)
-			continue;
+		if (!uid_entry) {
+			rcu_read_unlock();
+			pr_err("%s: failed to find the uid_entry for uid %d\n",
+				__func__, uid);
+			return -ENOMEM;
+		}
+		task_cputime_adjusted(task, &utime, &stime);
+		uid_entry->active_utime += utime;
+		uid_entry->active_stime += stime;
 		add_uid_io_stats(uid_entry, task, UID_STATE_TOTAL_CURR);
 	} while_each_thread(temp, task);
 	rcu_read_unlock();
@@ -497,6 +504,23 @@ static void update_io_stats_all_locked(void)
 					&uid_entry->io[UID_STATE_DEAD_TASKS]);
 		compute_io_uid_tasks(uid_entry);
 	}
+
+	return 0;
+}
+
+static int update_stats_locked(void)
+{
+	int ret;
+
+	if (stats_valid && time_before(jiffies, stats_stamp +
+				       msecs_to_jiffies(READ_ONCE(refresh_ms))))
+		return 0;
+
+	ret = update_stats_all_locked();
+	stats_valid = !ret;
+	stats_stamp = jiffies;
+
+	return ret;
 }
 
 static void update_io_stats_uid_locked(struct uid_entry *uid_entry)
@@ -528,10 +552,15 @@ static int uid_io_show(struct seq_file *m, void *v)
 {
 	struct uid_entry *uid_entry;
 	unsigned long bkt;
+	int ret;
 
 	rt_mutex_lock(&uid_lock);
 
-	update_io_stats_all_locked();
+	ret = update_stats_locked();
+	if (ret) {
+		rt_mutex_unlock(&uid_lock);
+		return ret;
+	}
 
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
 		seq_printf(m, "%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu\n",
@@ -646,6 +675,7 @@ static int process_notifier(struct notifier_block *self,
 	uid_entry->stime += stime;
 
 	add_uid_io_stats(uid_entry, task, UID_STATE_DEAD_TASKS);
+	stats_valid = false;
 
 exit:
 	rt_mutex_unlock(&uid_lock);
@@ -648,8 +648,12 @@ static int cmdq_prep_tran_desc(struct mmc_request *mrq,
 		return sg_count;
 	}
 
+	/*
+	 * Only the descriptors up to the one marked END are fetched by the
+	 * controller, no need to clear the whole max_segs sized table.
+	 */
 	desc = get_trans_desc(cq_host, tag);
-	memset(desc, 0, cq_host->trans_desc_len * cq_host->mmc->max_segs);
+	memset(desc, 0, cq_host->trans_desc_len * sg_count);
 
 	for_each_sg(data->sg, sg, sg_count, i) {
 		addr = sg_dma_address(sg);
@@ -175,6 +175,7 @@
 #define NUM_TUNING_PHASES		16
 #define MAX_DRV_TYPES_SUPPORTED_HS200	4
 #define MSM_AUTOSUSPEND_DELAY_MS 100
+#define MSM_AUTOSUSPEND_MAX_DELAY_MS 1600
 
 #define RCLK_TOGGLE 0x2
 
@@ -1207,6 +1208,101 @@ static void sdhci_msm_set_mmc_drv_type(struct sdhci_host *host, u32 opcode,
 			drv_type);
 }
 
+static u32 sdhci_msm_crc_errors(struct mmc_host *mmc)
+{
+	return mmc->err_stats[MMC_ERR_CMD_CRC] +
+		mmc->err_stats[MMC_ERR_DAT_CRC];
+}
+
+/*
+ * Phases found by earlier tuning are reused for the same clock and timing,
+ * so resuming the card or scaling the clock back up doesn't sweep all the
+ * phases again. The cache is dropped when a new card is initialized, which
+ * is the only time there is no card yet, and when CRC errors were seen
+ * since it was last filled, which is how a stale phase shows up.
+ */
+static int sdhci_msm_tuning_cache_lookup(struct sdhci_host *host)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	struct mmc_host *mmc = host->mmc;
+	struct sdhci_msm_tuning_cache *entry;
+	int i;
+
+	if (!mmc->card ||
+	    msm_host->tuning_cache_crc != sdhci_msm_crc_errors(mmc)) {
+		msm_host->tuning_cache_cnt = 0;
+		return -ENOENT;
+	}
+
+	for (i = 0; i < msm_host->tuning_cache_cnt; i++) {
+		entry = &msm_host->tuning_cache[i];
+		if (entry->clock == host->clock &&
+		    entry->timing == mmc->ios.timing)
+			return entry->phase;
+	}
+
+	return -ENOENT;
+}
+
+static void sdhci_msm_tuning_cache_store(struct sdhci_host *host, u8 phase)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	struct mmc_host *mmc = host->mmc;
+	struct sdhci_msm_tuning_cache *entry = NULL;
+	int i;
+
+	for (i = 0; i < msm_host->tuning_cache_cnt; i++) {
+		if (msm_host->tuning_cache[i].clock == host->clock &&
+		    msm_host->tuning_cache[i].timing == mmc->ios.timing) {
+			entry = &msm_host->tuning_cache[i];
+			break;
+		}
+	}
+
+	if (!entry) {
+		entry = &msm_host->tuning_cache[msm_host->tuning_cache_next];
+		msm_host->tuning_cache_next = (msm_host->tuning_cache_next + 1)
+			% SDHCI_MSM_TUNING_CACHE_SIZE;
+		if (msm_host->tuning_cache_cnt < SDHCI_MSM_TUNING_CACHE_SIZE)
+			msm_host->tuning_cache_cnt++;
+	}
+
+	entry->clock = host->clock;
+	entry->timing = mmc->ios.timing;
+	entry->phase = phase;
+	msm_host->tuning_cache_crc = sdhci_msm_crc_errors(mmc);
+}
+
+/* set up the DLL with a cached phase, true if the sweep can be skipped */
+static bool sdhci_msm_tuning_cache_restore(struct sdhci_host *host)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	int phase;
+
+	/* HS400 is tuned in HS200 timing, and only calibrated here */
+	if (host->mmc->ios.timing == MMC_TIMING_MMC_HS400)
+		return false;
+
+	phase = sdhci_msm_tuning_cache_lookup(host);
+	if (phase < 0)
+		return false;
+
+	if (msm_init_cm_dll(host, DLL_INIT_NORMAL) ||
+	    msm_config_cm_dll_phase(host, phase)) {
+		msm_host->tuning_cache_cnt = 0;
+		return false;
+	}
+
+	msm_host->saved_tuning_phase = phase;
+	pr_debug("%s: %s: restored tuning phase %d for %u Hz\n",
+		mmc_hostname(host->mmc), __func__, phase, host->clock);
+
+	return true;
+}
+
 int sdhci_msm_execute_tuning(struct sdhci_host *host, u32 opcode)
 {
 	unsigned long flags;
@@ -1255,6 +1351,11 @@ int sdhci_msm_execute_tuning(struct sdhci_host *host, u32 opcode)
 		goto out;
 	}
 
+	if (sdhci_msm_tuning_cache_restore(host)) {
+		rc = 0;
+		goto out;
+	}
+
 	spin_lock_irqsave(&host->lock, flags);
 
 	if ((opcode == MMC_SEND_TUNING_BLOCK_HS200) &&
@@ -1421,6 +1522,7 @@ retry:
 		if (rc)
 			goto kfree;
 		msm_host->saved_tuning_phase = phase;
+		sdhci_msm_tuning_cache_store(host, phase);
 		pr_debug("%s: %s: finally setting the tuning phase to %d\n",
 				mmc_hostname(mmc), __func__, phase);
 	} else {
@@ -4099,6 +4201,15 @@ void sdhci_msm_pm_qos_irq_vote(struct sdhci_host *host)
 		&& counter > 1)
 		return;
 
+	/*
+	 * The previous busy window ended less than QOS_REMOVE_DELAY_MS ago
+	 * and its vote is still in place: drop the pending unvote instead of
+	 * waiting for it and re-applying the same vote.
+	 */
+	if (msm_host->pm_qos_irq.latency == latency->latency[host->power_policy]
+		&& cancel_delayed_work(&msm_host->pm_qos_irq.unvote_work))
+		return;
+
 	cancel_delayed_work_sync(&msm_host->pm_qos_irq.unvote_work);
 	msm_host->pm_qos_irq.latency = latency->latency[host->power_policy];
 	pm_qos_update_request(&msm_host->pm_qos_irq.req,
@@ -4401,6 +4512,11 @@ void sdhci_msm_pm_qos_cpu_vote(struct sdhci_host *host,
 		&& counter > 1)
 		return;
 
+	/* same as for the irq vote, keep a vote still pending removal */
+	if (pm_qos_group->latency == latency->latency[host->power_policy]
+		&& cancel_delayed_work(&pm_qos_group->unvote_work))
+		return;
+
 	cancel_delayed_work_sync(&pm_qos_group->unvote_work);
 
 	pm_qos_group->latency = latency->latency[host->power_policy];
@@ -5290,6 +5406,7 @@ static int sdhci_msm_probe(struct platform_device *pdev)
 
 	pm_runtime_set_active(&pdev->dev);
 	pm_runtime_enable(&pdev->dev);
+	msm_host->autosuspend_delay = MSM_AUTOSUSPEND_DELAY_MS;
 	pm_runtime_set_autosuspend_delay(&pdev->dev, MSM_AUTOSUSPEND_DELAY_MS);
 	pm_runtime_use_autosuspend(&pdev->dev);
 
@@ -5517,11 +5634,38 @@ defer_disable_host_irq:
 			pr_err("%s: failed to suspend crypto engine %d\n",
 					mmc_hostname(host->mmc), ret);
 	}
+	msm_host->runtime_suspended_at = ktime_get();
 	trace_sdhci_msm_runtime_suspend(mmc_hostname(host->mmc), 0,
 			ktime_to_us(ktime_sub(ktime_get(), start)));
 	return 0;
 }
 
+/*
+ * Follow the request pattern with the autosuspend delay: each resume that
+ * comes within one delay of the suspend doubles it, so a stream of
+ * requests with short gaps, like a burst capture, keeps the controller
+ * up. Each idle period longer than the maximum halves it again.
+ */
+static void sdhci_msm_update_autosuspend(struct device *dev)
+{
+	struct sdhci_host *host = dev_get_drvdata(dev);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_msm_host *msm_host = pltfm_host->priv;
+	int delay = msm_host->autosuspend_delay;
+	s64 idle_ms;
+
+	idle_ms = ktime_ms_delta(ktime_get(), msm_host->runtime_suspended_at);
+	if (idle_ms < delay)
+		delay = min(delay * 2, MSM_AUTOSUSPEND_MAX_DELAY_MS);
+	else if (idle_ms > MSM_AUTOSUSPEND_MAX_DELAY_MS)
+		delay = max(delay / 2, MSM_AUTOSUSPEND_DELAY_MS);
+
+	if (delay != msm_host->autosuspend_delay) {
+		msm_host->autosuspend_delay = delay;
+		pm_runtime_set_autosuspend_delay(dev, delay);
+	}
+}
+
 static int sdhci_msm_runtime_resume(struct device *dev)
 {
 	struct sdhci_host *host = dev_get_drvdata(dev);
@@ -5552,6 +5696,7 @@ skip_ice_resume:
 defer_enable_host_irq:
 	enable_irq(msm_host->pwr_irq);
 
+	sdhci_msm_update_autosuspend(dev);
 	trace_sdhci_msm_runtime_resume(mmc_hostname(host->mmc), 0,
 			ktime_to_us(ktime_sub(ktime_get(), start)));
 	return 0;
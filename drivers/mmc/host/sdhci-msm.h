@@ -179,6 +179,15 @@ struct sdhci_msm_ice_data {
 	int state;
 };
 
+/* a phase found by tuning at one clock rate and bus timing */
+struct sdhci_msm_tuning_cache {
+	unsigned int clock;
+	unsigned char timing;
+	u8 phase;
+};
+
+#define SDHCI_MSM_TUNING_CACHE_SIZE	4
+
 struct sdhci_msm_regs_restore {
 	bool is_supported;
 	bool is_valid;
@@ -247,6 +256,12 @@ struct sdhci_msm_host {
 	bool tuning_done;
 	bool calibration_done;
 	u8 saved_tuning_phase;
+	struct sdhci_msm_tuning_cache tuning_cache[SDHCI_MSM_TUNING_CACHE_SIZE];
+	int tuning_cache_cnt;
+	int tuning_cache_next;
+	u32 tuning_cache_crc; /* CRC errors when the cache was last filled */
+	ktime_t runtime_suspended_at;
+	int autosuspend_delay;
 	bool en_auto_cmd21;
 	struct device_attribute auto_cmd21_attr;
 	bool is_sdiowakeup_enabled;
@@ -137,6 +137,12 @@ static int wil_vring_debugfs_show(struct seq_file *s, void *data)
 					   txdata->dot1x_open ? "+" : "-",
 					   used, avail, sidle);
 
+			if (txdata->tso_skbs)
+				seq_printf(s, "TSO: %lu skbs %lu segs (%lu per skb)\n",
+					   txdata->tso_skbs, txdata->tso_segs,
+					   txdata->tso_segs /
+					   txdata->tso_skbs);
+
 			wil_print_vring(s, wil, name, vring, '_', 'H');
 		}
 	}
@@ -1296,6 +1302,10 @@ static int wil_info_debugfs_show(struct seq_file *s, void *data)
 	seq_printf(s, "Tx irqs:packets : %8d : %8ld\n", tx, txf - txf_old);
 	rxf_old = rxf;
 	txf_old = txf;
+	if (wil->rx_pool.slot)
+		seq_printf(s, "Rx page pool : alloc %llu recycle %llu cached %u\n",
+			   wil->rx_pool.alloc, wil->rx_pool.recycle,
+			   wil->rx_pool.count);
 
 #define CHECK_QSTATE(x) (state & BIT(__QUEUE_STATE_ ## x)) ? \
 	" " __stringify(x) : ""
@@ -1407,9 +1417,9 @@ static void wil_print_rxtid(struct seq_file *s, struct wil_tid_ampdu_rx *r)
 			seq_printf(s, "%c", r->reorder_buf[i] ? '*' : '_');
 	}
 	seq_printf(s,
-		   "] total %llu drop %llu (dup %llu + old %llu) last 0x%03x\n",
+		   "] total %llu drop %llu (dup %llu + old %llu) last 0x%03x tmo %llu\n",
 		   r->total, drop_dup + drop_old, drop_dup, drop_old,
-		   r->ssn_last_drop);
+		   r->ssn_last_drop, r->release_tmo);
 }
 
 static void wil_print_rxtid_crypto(struct seq_file *s, int tid,
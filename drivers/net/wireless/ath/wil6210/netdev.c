@@ -83,10 +83,33 @@ static int wil_do_ioctl(struct net_device *ndev, struct ifreq *ifr, int cmd)
 	return wil_ioctl(wil, ifr->ifr_data, cmd);
 }
 
+/* HW TSO handles plain TCPv4/TCPv6 with checksum offload only, let the
+ * stack segment anything else instead of dropping it in the Tx path
+ */
+static netdev_features_t wil_features_check(struct sk_buff *skb,
+					    struct net_device *ndev,
+					    netdev_features_t features)
+{
+	unsigned int gso_type;
+
+	if (!skb_is_gso(skb))
+		return features;
+
+	gso_type = skb_shinfo(skb)->gso_type & (SKB_GSO_TCPV6 | SKB_GSO_TCPV4);
+	if (gso_type != SKB_GSO_TCPV4 && gso_type != SKB_GSO_TCPV6)
+		return features & ~NETIF_F_GSO_MASK;
+
+	if (skb->ip_summed != CHECKSUM_PARTIAL)
+		return features & ~NETIF_F_GSO_MASK;
+
+	return features;
+}
+
 static const struct net_device_ops wil_netdev_ops = {
 	.ndo_open		= wil_open,
 	.ndo_stop		= wil_stop,
 	.ndo_start_xmit		= wil_start_xmit,
+	.ndo_features_check	= wil_features_check,
 	.ndo_set_mac_address	= eth_mac_addr,
 	.ndo_validate_addr	= eth_validate_addr,
 	.ndo_change_mtu		= wil_change_mtu,
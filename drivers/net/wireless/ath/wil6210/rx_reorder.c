@@ -20,6 +20,14 @@
 #define SEQ_MODULO 0x1000
 #define SEQ_MASK   0xfff
 
+/* how long a frame may wait in the reorder buffer for a missing
+ * predecessor before the hole is skipped, 0 - wait for ever
+ */
+static uint reorder_timeout_ms = 100;
+module_param(reorder_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(reorder_timeout_ms,
+		 " Rx reorder hole timeout in msec, 0 - none, default - 100");
+
 static inline int seq_less(u16 sq1, u16 sq2)
 {
 	return ((sq1 - sq2) & SEQ_MASK) > (SEQ_MODULO >> 1);
@@ -89,6 +97,90 @@ static void wil_reorder_release(struct wil6210_priv *wil,
 	}
 }
 
+static void wil_reorder_timer_arm(struct wil_tid_ampdu_rx *r,
+				  unsigned long delay)
+{
+	hrtimer_start(&r->reorder_timer,
+		      ms_to_ktime(jiffies_to_msecs(delay)), HRTIMER_MODE_REL);
+}
+
+/* The hrtimer only flags the TID, frames are released from NAPI so that
+ * the reorder buffer keeps being handled in one context
+ */
+static enum hrtimer_restart wil_reorder_timer_fn(struct hrtimer *timer)
+{
+	struct wil_tid_ampdu_rx *r = container_of(timer,
+						  struct wil_tid_ampdu_rx,
+						  reorder_timer);
+	struct wil6210_priv *wil = r->wil;
+
+	set_bit(r->tid, wil->sta[r->cid].tid_rx_timer_expired);
+	napi_schedule(&wil->napi_rx);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Skip holes in front of frames that waited longer than the timeout.
+ * Re-arm the timer for the first frame that has not yet expired.
+ */
+static void wil_reorder_release_expired(struct wil6210_priv *wil,
+					struct wil_tid_ampdu_rx *r)
+{
+	unsigned long tmo = msecs_to_jiffies(reorder_timeout_ms);
+	unsigned long expires;
+	u16 seq;
+	int j;
+
+	while (r->stored_mpdu_num && reorder_timeout_ms) {
+		/* head slot is always empty here, find next stored frame */
+		for (j = 1; j < r->buf_size; j++) {
+			seq = (r->head_seq_num + j) & SEQ_MASK;
+			if (r->reorder_buf[reorder_index(r, seq)])
+				break;
+		}
+		if (j == r->buf_size)
+			return;
+
+		expires = r->reorder_time[reorder_index(r, seq)] + tmo;
+		if (time_before(jiffies, expires)) {
+			wil_reorder_timer_arm(r, expires - jiffies);
+			return;
+		}
+
+		wil_dbg_txrx(wil, "Rx reorder timeout: head 0x%03x -> 0x%03x\n",
+			     r->head_seq_num, seq);
+		r->release_tmo++;
+		wil_release_reorder_frames(wil, r, seq);
+		wil_reorder_release(wil, r);
+	}
+}
+
+/* called in NAPI context */
+void wil_rx_reorder_timeouts(struct wil6210_priv *wil)
+__acquires(&sta->tid_rx_lock) __releases(&sta->tid_rx_lock)
+{
+	struct wil_sta_info *sta;
+	int cid, tid;
+
+	for (cid = 0; cid < WIL6210_MAX_CID; cid++) {
+		sta = &wil->sta[cid];
+		if (likely(!sta->tid_rx_timer_expired[0]))
+			continue;
+
+		for (tid = 0; tid < WIL_STA_TID_NUM; tid++) {
+			if (!test_and_clear_bit(tid,
+						sta->tid_rx_timer_expired))
+				continue;
+
+			spin_lock(&sta->tid_rx_lock);
+			if (sta->tid_rx[tid])
+				wil_reorder_release_expired(wil,
+							    sta->tid_rx[tid]);
+			spin_unlock(&sta->tid_rx_lock);
+		}
+	}
+}
+
 /* called in NAPI context */
 void wil_rx_reorder(struct wil6210_priv *wil, struct sk_buff *skb)
 __acquires(&sta->tid_rx_lock) __releases(&sta->tid_rx_lock)
@@ -201,6 +293,10 @@ __acquires(&sta->tid_rx_lock) __releases(&sta->tid_rx_lock)
 	r->stored_mpdu_num++;
 	wil_reorder_release(wil, r);
 
+	if (r->stored_mpdu_num && reorder_timeout_ms &&
+	    !hrtimer_active(&r->reorder_timer))
+		wil_reorder_timer_arm(r, msecs_to_jiffies(reorder_timeout_ms));
+
 out:
 	spin_unlock(&sta->tid_rx_lock);
 }
@@ -232,7 +328,8 @@ out:
 }
 
 struct wil_tid_ampdu_rx *wil_tid_ampdu_rx_alloc(struct wil6210_priv *wil,
-						int size, u16 ssn)
+						int size, u16 ssn,
+						u8 cid, u8 tid)
 {
 	struct wil_tid_ampdu_rx *r = kzalloc(sizeof(*r), GFP_KERNEL);
 
@@ -255,6 +352,11 @@ struct wil_tid_ampdu_rx *wil_tid_ampdu_rx_alloc(struct wil6210_priv *wil,
 	r->buf_size = size;
 	r->stored_mpdu_num = 0;
 	r->first_time = true;
+	r->wil = wil;
+	r->cid = cid;
+	r->tid = tid;
+	hrtimer_init(&r->reorder_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	r->reorder_timer.function = wil_reorder_timer_fn;
 	return r;
 }
 
@@ -266,6 +368,8 @@ void wil_tid_ampdu_rx_free(struct wil6210_priv *wil,
 	if (!r)
 		return;
 
+	hrtimer_cancel(&r->reorder_timer);
+
 	/* Do not pass remaining frames to the network stack - it may be
 	 * not expecting to get any more Rx. Rx from here may lead to
 	 * kernel OOPS since some per-socket accounting info was already
@@ -363,7 +467,7 @@ __acquires(&sta->tid_rx_lock) __releases(&sta->tid_rx_lock)
 	}
 
 	/* apply */
-	r = wil_tid_ampdu_rx_alloc(wil, agg_wsize, ssn);
+	r = wil_tid_ampdu_rx_alloc(wil, agg_wsize, ssn, cid, tid);
 	spin_lock_bh(&sta->tid_rx_lock);
 	wil_tid_ampdu_rx_free(wil, sta->tid_rx[tid]);
 	sta->tid_rx[tid] = r;
@@ -42,6 +42,17 @@ bool rx_large_buf;
 module_param(rx_large_buf, bool, 0444);
 MODULE_PARM_DESC(rx_large_buf, " allocate 8KB RX buffers, default - no");
 
+bool rx_page_pool;
+module_param(rx_page_pool, bool, 0444);
+MODULE_PARM_DESC(rx_page_pool,
+		 " build Rx skbs around recycled pre-mapped pages, default - no");
+
+/* bytes copied to the skb linear area when Rx buffers are pages,
+ * covers the SNAP shift and protocol headers; shorter frames are copied
+ * whole and their page is reusable right away
+ */
+#define WIL_RX_HDR_LEN 128
+
 bool drop_if_ring_full;
 module_param(drop_if_ring_full, bool, 0444);
 MODULE_PARM_DESC(drop_if_ring_full,
@@ -239,6 +250,123 @@ static void wil_txdesc_unmap(struct device *dev, struct vring_tx_desc *d,
 	}
 }
 
+static void wil_rx_page_release(struct wil6210_priv *wil,
+				struct wil_rx_page *rp)
+{
+	struct device *dev = wil_to_dev(wil);
+
+	dma_unmap_page(dev, rp->pa, PAGE_SIZE << wil->rx_pool.order,
+		       DMA_FROM_DEVICE);
+	put_page(rp->page);
+	rp->page = NULL;
+}
+
+/**
+ * Get a mapped page for an Rx buffer, reusing the oldest lent out page
+ * once the stack is done with it
+ *
+ * Safe to call from IRQ
+ */
+static int wil_rx_page_get(struct wil6210_priv *wil, struct wil_rx_page *rp)
+{
+	struct device *dev = wil_to_dev(wil);
+	struct wil_rx_page_pool *pool = &wil->rx_pool;
+	size_t len = PAGE_SIZE << pool->order;
+	struct page *page;
+	dma_addr_t pa;
+
+	if (pool->count) {
+		struct wil_rx_page *c = &pool->cache[pool->head];
+
+		if (page_ref_count(c->page) == 1) {
+			*rp = *c;
+			c->page = NULL;
+			pool->head = (pool->head + 1) % pool->size;
+			pool->count--;
+			pool->recycle++;
+			dma_sync_single_for_device(dev, rp->pa, len,
+						   DMA_FROM_DEVICE);
+			return 0;
+		}
+	}
+
+	page = dev_alloc_pages(pool->order);
+	if (unlikely(!page))
+		return -ENOMEM;
+
+	pa = dma_map_page(dev, page, 0, len, DMA_FROM_DEVICE);
+	if (unlikely(dma_mapping_error(dev, pa))) {
+		put_page(page);
+		return -ENOMEM;
+	}
+
+	rp->page = page;
+	rp->pa = pa;
+	pool->alloc++;
+
+	return 0;
+}
+
+/* Park a page whose data may still be referenced by an skb */
+static void wil_rx_page_put(struct wil6210_priv *wil, struct wil_rx_page *rp)
+{
+	struct wil_rx_page_pool *pool = &wil->rx_pool;
+
+	if (pool->count == pool->size || page_is_pfmemalloc(rp->page)) {
+		wil_rx_page_release(wil, rp);
+		return;
+	}
+
+	pool->cache[(pool->head + pool->count) % pool->size] = *rp;
+	pool->count++;
+	rp->page = NULL;
+}
+
+static int wil_rx_pool_init(struct wil6210_priv *wil, u16 size)
+{
+	struct wil_rx_page_pool *pool = &wil->rx_pool;
+	unsigned int sz = wil->rx_buf_len + ETH_HLEN + wil_rx_snaplen();
+
+	memset(pool, 0, sizeof(*pool));
+	if (!rx_page_pool)
+		return 0;
+
+	pool->slot = kcalloc(size, sizeof(pool->slot[0]), GFP_KERNEL);
+	pool->cache = kcalloc(size, sizeof(pool->cache[0]), GFP_KERNEL);
+	if (!pool->slot || !pool->cache) {
+		kfree(pool->slot);
+		kfree(pool->cache);
+		pool->slot = NULL;
+		pool->cache = NULL;
+		return -ENOMEM;
+	}
+	pool->size = size;
+	pool->order = get_order(sz);
+
+	wil_dbg_misc(wil, "Rx page pool: %d entries of order %d\n",
+		     size, pool->order);
+
+	return 0;
+}
+
+static void wil_rx_pool_fini(struct wil6210_priv *wil)
+{
+	struct wil_rx_page_pool *pool = &wil->rx_pool;
+
+	if (!pool->cache)
+		return;
+
+	while (pool->count) {
+		wil_rx_page_release(wil, &pool->cache[pool->head]);
+		pool->head = (pool->head + 1) % pool->size;
+		pool->count--;
+	}
+	kfree(pool->slot);
+	kfree(pool->cache);
+	pool->slot = NULL;
+	pool->cache = NULL;
+}
+
 static void wil_vring_free(struct wil6210_priv *wil, struct vring *vring,
 			   int tx)
 {
@@ -287,6 +415,15 @@ static void wil_vring_free(struct wil6210_priv *wil, struct vring *vring,
 					&vring->va[vring->swhead].rx;
 
 			ctx = &vring->ctx[vring->swhead];
+			if (wil->rx_pool.slot) {
+				struct wil_rx_page *rp =
+					&wil->rx_pool.slot[vring->swhead];
+
+				if (rp->page)
+					wil_rx_page_release(wil, rp);
+				wil_vring_advance_head(vring, 1);
+				continue;
+			}
 			*d = *_d;
 			pa = wil_desc_addr(&d->dma.addr);
 			dmalen = le16_to_cpu(d->dma.length);
@@ -343,6 +480,77 @@ static int wil_vring_alloc_skb(struct wil6210_priv *wil, struct vring *vring,
 	return 0;
 }
 
+/**
+ * Post one pool page to Rx VRING
+ *
+ * Safe to call from IRQ
+ */
+static int wil_vring_alloc_rx_page(struct wil6210_priv *wil,
+				   struct vring *vring, u32 i)
+{
+	unsigned int sz = wil->rx_buf_len + ETH_HLEN + wil_rx_snaplen();
+	struct wil_rx_page *rp = &wil->rx_pool.slot[i];
+	struct vring_rx_desc dd, *d = &dd;
+	volatile struct vring_rx_desc *_d = &vring->va[i].rx;
+	int rc;
+
+	rc = wil_rx_page_get(wil, rp);
+	if (unlikely(rc))
+		return rc;
+
+	memset(d, 0, sizeof(*d));
+	d->dma.d0 = RX_DMA_D0_CMD_DMA_RT | RX_DMA_D0_CMD_DMA_IT;
+	wil_desc_addr_set(&d->dma.addr, rp->pa);
+	d->dma.length = cpu_to_le16(sz);
+	*_d = *d;
+
+	return 0;
+}
+
+/**
+ * Build an skb for a frame received into a pool page
+ *
+ * Headers are copied to the linear area, the rest is attached as a page
+ * fragment. The page goes back to the pool either way.
+ *
+ * Safe to call from IRQ
+ */
+static struct sk_buff *wil_rx_page_skb(struct wil6210_priv *wil,
+				       struct vring *vring, u32 i)
+{
+	struct device *dev = wil_to_dev(wil);
+	struct net_device *ndev = wil_to_ndev(wil);
+	struct wil_rx_page *rp = &wil->rx_pool.slot[i];
+	unsigned int sz = wil->rx_buf_len + ETH_HLEN + wil_rx_snaplen();
+	int headroom = ndev->type == ARPHRD_IEEE80211_RADIOTAP ?
+			WIL6210_RTAP_SIZE : 0;
+	unsigned int len, hlen;
+	struct sk_buff *skb;
+
+	if (!rp->page)
+		return NULL;
+
+	len = min_t(unsigned int, le16_to_cpu(vring->va[i].rx.dma.length), sz);
+	hlen = min_t(unsigned int, len, WIL_RX_HDR_LEN);
+
+	dma_sync_single_for_cpu(dev, rp->pa, len, DMA_FROM_DEVICE);
+
+	skb = netdev_alloc_skb(ndev, headroom + hlen);
+	if (likely(skb)) {
+		skb_reserve(skb, headroom);
+		memcpy(skb_put(skb, hlen), page_address(rp->page), hlen);
+		if (len > hlen) {
+			get_page(rp->page);
+			skb_add_rx_frag(skb, 0, rp->page, hlen, len - hlen,
+					PAGE_SIZE << wil->rx_pool.order);
+		}
+	}
+
+	wil_rx_page_put(wil, rp);
+
+	return skb;
+}
+
 /**
  * Adds radiotap header
  *
@@ -507,8 +715,12 @@ again:
 		return NULL;
 	}
 
-	skb = vring->ctx[i].skb;
-	vring->ctx[i].skb = NULL;
+	if (wil->rx_pool.slot) {
+		skb = wil_rx_page_skb(wil, vring, i);
+	} else {
+		skb = vring->ctx[i].skb;
+		vring->ctx[i].skb = NULL;
+	}
 	wil_vring_advance_head(vring, 1);
 	if (!skb) {
 		wil_err(wil, "No Rx skb at [%d]\n", i);
@@ -516,9 +728,11 @@ again:
 	}
 	d = wil_skb_rxdesc(skb);
 	*d = *_d;
-	pa = wil_desc_addr(&d->dma.addr);
 
-	dma_unmap_single(dev, pa, sz, DMA_FROM_DEVICE);
+	if (!wil->rx_pool.slot) {
+		pa = wil_desc_addr(&d->dma.addr);
+		dma_unmap_single(dev, pa, sz, DMA_FROM_DEVICE);
+	}
 	dmalen = le16_to_cpu(d->dma.length);
 
 	trace_wil6210_rx(i, d);
@@ -535,7 +749,9 @@ again:
 		kfree_skb(skb);
 		goto again;
 	}
-	skb_trim(skb, dmalen);
+	/* page backed skb is already built to dmalen */
+	if (!wil->rx_pool.slot)
+		skb_trim(skb, dmalen);
 
 	prefetch(skb->data);
 
@@ -633,6 +849,7 @@ static int wil_rx_refill(struct wil6210_priv *wil, int count)
 {
 	struct net_device *ndev = wil_to_ndev(wil);
 	struct vring *v = &wil->vring_rx;
+	u32 swtail = v->swtail;
 	u32 next_tail;
 	int rc = 0;
 	int headroom = ndev->type == ARPHRD_IEEE80211_RADIOTAP ?
@@ -641,7 +858,10 @@ static int wil_rx_refill(struct wil6210_priv *wil, int count)
 	for (; next_tail = wil_vring_next_tail(v),
 			(next_tail != v->swhead) && (count-- > 0);
 			v->swtail = next_tail) {
-		rc = wil_vring_alloc_skb(wil, v, v->swtail, headroom);
+		if (wil->rx_pool.slot)
+			rc = wil_vring_alloc_rx_page(wil, v, v->swtail);
+		else
+			rc = wil_vring_alloc_skb(wil, v, v->swtail, headroom);
 		if (unlikely(rc)) {
 			wil_err_ratelimited(wil, "Error %d in rx refill[%d]\n",
 					    rc, v->swtail);
@@ -649,6 +869,10 @@ static int wil_rx_refill(struct wil6210_priv *wil, int count)
 		}
 	}
 
+	/* nothing was posted, spare the register write */
+	if (v->swtail == swtail)
+		return rc;
+
 	/* make sure all writes to descriptors (shared memory) are done before
 	 * committing them to HW
 	 */
@@ -845,6 +1069,7 @@ void wil_rx_handle(struct wil6210_priv *wil, int *quota)
 			wil_rx_reorder(wil, skb);
 		}
 	}
+	wil_rx_reorder_timeouts(wil);
 	wil_rx_refill(wil, v->size);
 }
 
@@ -877,10 +1102,14 @@ int wil_rx_init(struct wil6210_priv *wil, u16 size)
 	wil_rx_buf_len_init(wil);
 
 	vring->size = size;
-	rc = wil_vring_alloc(wil, vring);
+	rc = wil_rx_pool_init(wil, size);
 	if (rc)
 		return rc;
 
+	rc = wil_vring_alloc(wil, vring);
+	if (rc)
+		goto err_pool;
+
 	rc = wmi_rx_chain_add(wil, vring);
 	if (rc)
 		goto err_free;
@@ -892,6 +1121,8 @@ int wil_rx_init(struct wil6210_priv *wil, u16 size)
 	return 0;
  err_free:
 	wil_vring_free(wil, vring, 0);
+ err_pool:
+	wil_rx_pool_fini(wil);
 
 	return rc;
 }
@@ -904,6 +1135,8 @@ void wil_rx_fini(struct wil6210_priv *wil)
 
 	if (vring->va)
 		wil_vring_free(wil, vring, 0);
+
+	wil_rx_pool_fini(wil);
 }
 
 static inline void wil_tx_data_init(struct vring_tx_data *txdata)
@@ -918,6 +1151,8 @@ static inline void wil_tx_data_init(struct vring_tx_data *txdata)
 	txdata->agg_timeout = 0;
 	txdata->agg_amsdu = 0;
 	txdata->addba_in_progress = false;
+	txdata->tso_skbs = 0;
+	txdata->tso_segs = 0;
 	spin_unlock_bh(&txdata->lock);
 }
 
@@ -1690,6 +1925,8 @@ static int __wil_tx_vring_tso(struct wil6210_priv *wil, struct vring *vring,
 	/* advance swhead */
 	wil_vring_advance_head(vring, descs_used);
 	wil_dbg_txrx(wil, "TSO: Tx swhead %d -> %d\n", swhead, vring->swhead);
+	txdata->tso_skbs++;
+	txdata->tso_segs += skb_shinfo(skb)->gso_segs;
 
 	/* make sure all writes to descriptors (shared memory) are done before
 	 * committing them to HW
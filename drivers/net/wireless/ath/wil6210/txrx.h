@@ -519,8 +519,10 @@ static inline struct vring_rx_desc *wil_skb_rxdesc(struct sk_buff *skb)
 void wil_netif_rx_any(struct sk_buff *skb, struct net_device *ndev);
 void wil_rx_reorder(struct wil6210_priv *wil, struct sk_buff *skb);
 void wil_rx_bar(struct wil6210_priv *wil, u8 cid, u8 tid, u16 seq);
+void wil_rx_reorder_timeouts(struct wil6210_priv *wil);
 struct wil_tid_ampdu_rx *wil_tid_ampdu_rx_alloc(struct wil6210_priv *wil,
-						int size, u16 ssn);
+						int size, u16 ssn,
+						u8 cid, u8 tid);
 void wil_tid_ampdu_rx_free(struct wil6210_priv *wil,
 			   struct wil_tid_ampdu_rx *r);
 void wil_tx_latency_calc(struct wil6210_priv *wil, struct sk_buff *skb,
@@ -23,6 +23,7 @@
 #include <linux/wireless.h>
 #include <net/cfg80211.h>
 #include <linux/timex.h>
+#include <linux/hrtimer.h>
 #include <linux/types.h>
 #include "wmi.h"
 #include "wil_platform.h"
@@ -34,6 +35,7 @@ extern unsigned short rx_ring_overflow_thrsh;
 extern int agg_wsize;
 extern bool rx_align_2;
 extern bool rx_large_buf;
+extern bool rx_page_pool;
 extern bool debug_fw;
 extern bool disable_ap_sme;
 extern bool drop_if_ring_full;
@@ -459,6 +461,32 @@ struct vring {
 	struct wil_ctx *ctx; /* ctx[size] - software context */
 };
 
+/**
+ * struct wil_rx_page - DMA mapped page backing one Rx buffer
+ */
+struct wil_rx_page {
+	struct page *page;
+	dma_addr_t pa;
+};
+
+/**
+ * struct wil_rx_page_pool - recycler for Rx buffer pages
+ *
+ * Pages stay mapped for their whole life in the pool. A page whose data
+ * was attached to an skb is parked in @cache until the stack drops its
+ * reference, then it is posted again without a new allocation or mapping.
+ */
+struct wil_rx_page_pool {
+	struct wil_rx_page *slot; /* slot[size], page posted at Rx descriptor */
+	struct wil_rx_page *cache; /* cache[size], FIFO of pages lent out */
+	u32 size;
+	u32 head; /* oldest entry in @cache */
+	u32 count; /* entries in @cache */
+	unsigned int order;
+	u64 alloc; /* pages allocated and mapped */
+	u64 recycle; /* pages reused from @cache */
+};
+
 /**
  * Additional data for Tx Vring
  */
@@ -470,6 +498,8 @@ struct vring_tx_data {
 	u16 agg_timeout;
 	u8 agg_amsdu;
 	bool addba_in_progress; /* if set, agg_xxx is for request in progress */
+	unsigned long tso_skbs; /* GSO skbs sent as TSO descriptor chains */
+	unsigned long tso_segs; /* segments built by HW for those skbs */
 	spinlock_t lock;
 };
 
@@ -515,7 +545,10 @@ struct wil_tid_ampdu_rx {
 	struct sk_buff **reorder_buf;
 	unsigned long *reorder_time;
 	struct timer_list session_timer;
-	struct timer_list reorder_timer;
+	struct hrtimer reorder_timer;
+	struct wil6210_priv *wil;
+	u8 cid;
+	u8 tid;
 	unsigned long last_rx;
 	u16 head_seq_num;
 	u16 stored_mpdu_num;
@@ -526,6 +559,7 @@ struct wil_tid_ampdu_rx {
 	unsigned long long total; /* frames processed */
 	unsigned long long drop_dup;
 	unsigned long long drop_old;
+	unsigned long long release_tmo; /* holes skipped on reorder timeout */
 	u8 dialog_token;
 	bool first_time; /* is it 1-st time this buffer used? */
 };
@@ -606,6 +640,7 @@ struct wil_sta_info {
 	/* Rx BACK */
 	struct wil_tid_ampdu_rx *tid_rx[WIL_STA_TID_NUM];
 	spinlock_t tid_rx_lock; /* guarding tid_rx array */
+	/* set from reorder hrtimer, handled in NAPI */
 	unsigned long tid_rx_timer_expired[BITS_TO_LONGS(WIL_STA_TID_NUM)];
 	unsigned long tid_rx_stop_requested[BITS_TO_LONGS(WIL_STA_TID_NUM)];
 	struct wil_tid_crypto_rx tid_crypto_rx[WIL_STA_TID_NUM];
@@ -761,6 +796,7 @@ struct wil6210_priv {
 	/* DMA related */
 	struct vring vring_rx;
 	unsigned int rx_buf_len;
+	struct wil_rx_page_pool rx_pool;
 	struct vring vring_tx[WIL6210_MAX_TX_RINGS];
 	struct vring_tx_data vring_tx_data[WIL6210_MAX_TX_RINGS];
 	u8 vring2cid_tid[WIL6210_MAX_TX_RINGS][2]; /* [0] - CID, [1] - TID */
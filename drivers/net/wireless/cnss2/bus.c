@@ -306,6 +306,8 @@ int cnss_bus_dev_powerup(struct cnss_plat_data *plat_priv)
 	if (!plat_priv)
 		return -ENODEV;
 
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_POWER_UP);
+
 	switch (plat_priv->bus_type) {
 	case CNSS_BUS_PCI:
 		return cnss_pci_dev_powerup(plat_priv->bus_priv);
@@ -118,11 +118,39 @@ static int cnss_stats_show_state(struct seq_file *s,
 	return 0;
 }
 
+static void cnss_stats_show_bringup(struct seq_file *s,
+				    struct cnss_plat_data *plat_priv)
+{
+	static const char * const stage_name[CNSS_BRINGUP_MAX] = {
+		[CNSS_BRINGUP_POWER_UP] = "POWER_UP",
+		[CNSS_BRINGUP_SERVER_ARRIVE] = "SERVER_ARRIVE",
+		[CNSS_BRINGUP_FW_MEM_READY] = "FW_MEM_READY",
+		[CNSS_BRINGUP_TGT_CAP] = "TGT_CAP",
+		[CNSS_BRINGUP_BDF] = "BDF",
+		[CNSS_BRINGUP_M3] = "M3",
+		[CNSS_BRINGUP_FW_READY] = "FW_READY",
+	};
+	ktime_t start = plat_priv->bringup_ts[CNSS_BRINGUP_POWER_UP];
+	int i;
+
+	if (!ktime_to_ns(start))
+		return;
+
+	seq_puts(s, "\nBring-up (us after POWER_UP):\n");
+	for (i = CNSS_BRINGUP_POWER_UP + 1; i < CNSS_BRINGUP_MAX; i++) {
+		if (!ktime_to_ns(plat_priv->bringup_ts[i]))
+			continue;
+		seq_printf(s, "%s: %lld\n", stage_name[i],
+			   ktime_us_delta(plat_priv->bringup_ts[i], start));
+	}
+}
+
 static int cnss_stats_show(struct seq_file *s, void *data)
 {
 	struct cnss_plat_data *plat_priv = s->private;
 
 	cnss_stats_show_state(s, plat_priv);
+	cnss_stats_show_bringup(s, plat_priv);
 
 	return 0;
 }
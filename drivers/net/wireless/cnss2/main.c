@@ -380,10 +380,18 @@ static int cnss_fw_mem_ready_hdlr(struct cnss_plat_data *plat_priv)
 		return -ENODEV;
 
 	set_bit(CNSS_FW_MEM_READY, &plat_priv->driver_state);
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_FW_MEM_READY);
+
+	/* M3 image does not depend on target capabilities, read it while
+	 * the QMI exchange and BDF download are in flight
+	 */
+	if (plat_priv->device_id != QCN7605_DEVICE_ID)
+		queue_work(system_unbound_wq, &plat_priv->m3_load_work);
 
 	ret = cnss_wlfw_tgt_cap_send_sync(plat_priv);
 	if (ret)
 		goto out;
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_TGT_CAP);
 
 	cnss_wlfw_bdf_dnld_send_sync(plat_priv, CNSS_BDF_REGDB);
 
@@ -394,17 +402,20 @@ static int cnss_fw_mem_ready_hdlr(struct cnss_plat_data *plat_priv)
 					   plat_priv->ctrl_params.bdf_type);
 	if (ret)
 		goto out;
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_BDF);
 
 	if (plat_priv->device_id == QCN7605_DEVICE_ID)
 		return 0;
 
-	ret = cnss_bus_load_m3(plat_priv);
+	flush_work(&plat_priv->m3_load_work);
+	ret = plat_priv->m3_load_ret;
 	if (ret)
 		goto out;
 
 	ret = cnss_wlfw_m3_dnld_send_sync(plat_priv);
 	if (ret)
 		goto out;
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_M3);
 
 	return 0;
 out:
@@ -421,6 +432,7 @@ static int cnss_fw_ready_hdlr(struct cnss_plat_data *plat_priv)
 	del_timer(&plat_priv->fw_boot_timer);
 	set_bit(CNSS_FW_READY, &plat_priv->driver_state);
 	clear_bit(CNSS_DEV_ERR_NOTIFY, &plat_priv->driver_state);
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_FW_READY);
 
 	if (test_bit(CNSS_FW_BOOT_RECOVERY, &plat_priv->driver_state)) {
 		clear_bit(CNSS_FW_BOOT_RECOVERY, &plat_priv->driver_state);
@@ -1163,13 +1175,17 @@ static int cnss_wlfw_server_arrive_hdlr(struct cnss_plat_data *plat_priv)
 	ret = cnss_wlfw_server_arrive(plat_priv);
 	if (ret)
 		goto out;
+	cnss_bringup_ts(plat_priv, CNSS_BRINGUP_SERVER_ARRIVE);
 
 	if (!cnss_bus_req_mem_ind_valid(plat_priv)) {
 		ret = cnss_wlfw_tgt_cap_send_sync(plat_priv);
 		if (ret)
 			goto out;
+		cnss_bringup_ts(plat_priv, CNSS_BRINGUP_TGT_CAP);
 		bdf_type = plat_priv->ctrl_params.bdf_type;
 		ret = cnss_wlfw_bdf_dnld_send_sync(plat_priv, bdf_type);
+		if (!ret)
+			cnss_bringup_ts(plat_priv, CNSS_BRINGUP_BDF);
 	}
 out:
 	return ret;
@@ -1902,6 +1918,14 @@ static void cnss_event_work_deinit(struct cnss_plat_data *plat_priv)
 	destroy_workqueue(plat_priv->event_wq);
 }
 
+static void cnss_m3_load_work(struct work_struct *work)
+{
+	struct cnss_plat_data *plat_priv =
+		container_of(work, struct cnss_plat_data, m3_load_work);
+
+	plat_priv->m3_load_ret = cnss_bus_load_m3(plat_priv);
+}
+
 static int cnss_misc_init(struct cnss_plat_data *plat_priv)
 {
 	int ret;
@@ -1921,6 +1945,7 @@ static int cnss_misc_init(struct cnss_plat_data *plat_priv)
 	init_completion(&plat_priv->rddm_complete);
 	init_completion(&plat_priv->recovery_complete);
 	mutex_init(&plat_priv->dev_lock);
+	INIT_WORK(&plat_priv->m3_load_work, cnss_m3_load_work);
 
 	return 0;
 }
@@ -1931,6 +1956,7 @@ static void cnss_misc_deinit(struct cnss_plat_data *plat_priv)
 	complete_all(&plat_priv->rddm_complete);
 	complete_all(&plat_priv->cal_complete);
 	complete_all(&plat_priv->power_up_complete);
+	cancel_work_sync(&plat_priv->m3_load_work);
 	device_init_wakeup(&plat_priv->plat_dev->dev, false);
 	unregister_pm_notifier(&cnss_pm_notifier);
 	del_timer(&plat_priv->fw_boot_timer);
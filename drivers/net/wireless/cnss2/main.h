@@ -264,6 +264,29 @@ enum cnss_ce_index {
 	CNSS_CE_COMMON,
 };
 
+enum cnss_bringup_stage {
+	CNSS_BRINGUP_POWER_UP,
+	CNSS_BRINGUP_SERVER_ARRIVE,
+	CNSS_BRINGUP_FW_MEM_READY,
+	CNSS_BRINGUP_TGT_CAP,
+	CNSS_BRINGUP_BDF,
+	CNSS_BRINGUP_M3,
+	CNSS_BRINGUP_FW_READY,
+	CNSS_BRINGUP_MAX,
+};
+
+/* board data and regdb files kept in memory across SSR */
+enum cnss_bdf_cache_id {
+	CNSS_BDF_CACHE_BOARD,
+	CNSS_BDF_CACHE_REGDB,
+	CNSS_BDF_CACHE_MAX,
+};
+
+struct cnss_bdf_cache {
+	char filename[CNSS_FW_PATH_MAX_LEN];
+	const struct firmware *fw;
+};
+
 struct cnss_plat_data {
 	struct platform_device *plat_dev;
 	void *bus_priv;
@@ -319,8 +342,21 @@ struct cnss_plat_data {
 	u32 is_converged_dt;
 	struct device_node *dev_node;
 	u8 set_wlaon_pwr_ctrl;
+	struct cnss_bdf_cache bdf_cache[CNSS_BDF_CACHE_MAX];
+	struct work_struct m3_load_work;
+	int m3_load_ret;
+	ktime_t bringup_ts[CNSS_BRINGUP_MAX];
 };
 
+static inline void cnss_bringup_ts(struct cnss_plat_data *plat_priv,
+				   enum cnss_bringup_stage stage)
+{
+	if (stage == CNSS_BRINGUP_POWER_UP)
+		memset(plat_priv->bringup_ts, 0,
+		       sizeof(plat_priv->bringup_ts));
+	plat_priv->bringup_ts[stage] = ktime_get();
+}
+
 struct cnss_plat_data *cnss_get_plat_priv(struct platform_device *plat_dev);
 int cnss_driver_event_post(struct cnss_plat_data *plat_priv,
 			   enum cnss_driver_event_type type,
@@ -51,6 +51,10 @@ module_param(bdf_type, uint, 0600);
 MODULE_PARM_DESC(bdf_type, "Type of board data file to be downloaded");
 #endif
 
+static bool bdf_cache = true;
+module_param(bdf_cache, bool, 0600);
+MODULE_PARM_DESC(bdf_cache, "Keep board data files in memory across SSR");
+
 static char *cnss_qmi_mode_to_str(enum cnss_driver_mode mode)
 {
 	switch (mode) {
@@ -515,6 +519,55 @@ out:
 	return ret;
 }
 
+/* Request a board data file, or reuse the copy kept from an earlier
+ * download. A cached file is owned by the cache and must not be released.
+ */
+static int cnss_bdf_request(struct cnss_plat_data *plat_priv, u32 bdf_type,
+			    const char *filename,
+			    const struct firmware **fw_entry, bool *cached)
+{
+	struct cnss_bdf_cache *cache;
+	int ret;
+
+	cache = &plat_priv->bdf_cache[bdf_type == CNSS_BDF_REGDB ?
+				      CNSS_BDF_CACHE_REGDB :
+				      CNSS_BDF_CACHE_BOARD];
+	*cached = false;
+
+	if (cache->fw && !strcmp(cache->filename, filename)) {
+		cnss_pr_dbg("Using cached BDF: %s\n", filename);
+		*fw_entry = cache->fw;
+		*cached = true;
+		return 0;
+	}
+
+	if (bdf_type == CNSS_BDF_REGDB)
+		ret = request_firmware_direct(fw_entry, filename,
+					      &plat_priv->plat_dev->dev);
+	else
+		ret = request_firmware(fw_entry, filename,
+				       &plat_priv->plat_dev->dev);
+	if (ret || !bdf_cache)
+		return ret;
+
+	release_firmware(cache->fw);
+	cache->fw = *fw_entry;
+	strlcpy(cache->filename, filename, sizeof(cache->filename));
+	*cached = true;
+
+	return 0;
+}
+
+static void cnss_bdf_cache_free(struct cnss_plat_data *plat_priv)
+{
+	int i;
+
+	for (i = 0; i < CNSS_BDF_CACHE_MAX; i++) {
+		release_firmware(plat_priv->bdf_cache[i].fw);
+		plat_priv->bdf_cache[i].fw = NULL;
+	}
+}
+
 int cnss_wlfw_bdf_dnld_send_sync(struct cnss_plat_data *plat_priv,
 				 u32 bdf_type)
 {
@@ -527,6 +580,7 @@ int cnss_wlfw_bdf_dnld_send_sync(struct cnss_plat_data *plat_priv,
 	unsigned int remaining;
 	int ret = 0;
 	const char *fw_path;
+	bool cached = false;
 
 	cnss_pr_dbg("Sending BDF download message, state: 0x%lx\n",
 		    plat_priv->driver_state);
@@ -583,12 +637,8 @@ int cnss_wlfw_bdf_dnld_send_sync(struct cnss_plat_data *plat_priv,
 		ret = -EINVAL;
 		goto err_req_fw;
 	}
-	if (bdf_type == CNSS_BDF_REGDB)
-		ret = request_firmware_direct(&fw_entry, filename,
-					      &plat_priv->plat_dev->dev);
-	else
-		ret = request_firmware(&fw_entry, filename,
-				       &plat_priv->plat_dev->dev);
+	ret = cnss_bdf_request(plat_priv, bdf_type, filename, &fw_entry,
+			       &cached);
 	if (ret) {
 		cnss_pr_err("Failed to load BDF: %s\n", filename);
 		goto err_req_fw;
@@ -652,14 +702,14 @@ bypass_bdf:
 		req->seg_id++;
 	}
 
-	if (bdf_type != CNSS_BDF_DUMMY)
+	if (bdf_type != CNSS_BDF_DUMMY && !cached)
 		release_firmware(fw_entry);
 
 	kfree(req);
 	return 0;
 
 err_send:
-	if (plat_priv->ctrl_params.bdf_type != CNSS_BDF_DUMMY)
+	if (bdf_type != CNSS_BDF_DUMMY && !cached)
 		release_firmware(fw_entry);
 err_req_fw:
 	if (bdf_type != CNSS_BDF_REGDB)
@@ -1262,4 +1312,5 @@ void cnss_qmi_deinit(struct cnss_plat_data *plat_priv)
 					  WLFW_SERVICE_VERS_V01,
 					  WLFW_SERVICE_INS_ID_V01,
 					  &plat_priv->qmi_wlfw_clnt_nb);
+	cnss_bdf_cache_free(plat_priv);
 }
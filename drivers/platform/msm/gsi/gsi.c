@@ -426,6 +426,7 @@ static void gsi_ring_chan_doorbell(struct gsi_chan_ctx *ctx)
 	if (ctx->evtr && ctx->props.dir == GSI_CHAN_DIR_FROM_GSI)
 		gsi_ring_evt_doorbell(ctx->evtr);
 	ctx->ring.wp = ctx->ring.wp_local;
+	ctx->stats.doorbells++;
 
 	/* write order MUST be MSB followed by LSB */
 	val = ((ctx->ring.wp_local >> 32) &
@@ -612,6 +613,7 @@ static irqreturn_t gsi_isr(int irq, void *ctxt)
 {
 	BUG_ON(ctxt != gsi_ctx);
 
+	gsi_ctx->num_isr++;
 	if (gsi_ctx->per.req_clk_cb) {
 		bool granted = false;
 
@@ -2581,7 +2583,6 @@ int gsi_queue_xfer(unsigned long chan_hdl, uint16_t num_xfers,
 	struct gsi_tre tre;
 	struct gsi_tre *tre_ptr;
 	uint16_t idx;
-	uint64_t wp_rollback;
 	int i;
 	spinlock_t *slock;
 	unsigned long flags;
@@ -2604,6 +2605,17 @@ int gsi_queue_xfer(unsigned long chan_hdl, uint16_t num_xfers,
 		return -GSI_STATUS_UNSUPPORTED_OP;
 	}
 
+	/* validate the whole batch up front so nothing has to be rolled back */
+	for (i = 0; i < num_xfers; i++) {
+		if (xfer[i].type != GSI_XFER_ELEM_DATA &&
+		    xfer[i].type != GSI_XFER_ELEM_IMME_CMD &&
+		    xfer[i].type != GSI_XFER_ELEM_NOP) {
+			GSIERR("chan_hdl=%lu bad RE type=%u\n", chan_hdl,
+				xfer[i].type);
+			return -GSI_STATUS_INVALID_PARAMS;
+		}
+	}
+
 	if (ctx->evtr)
 		slock = &ctx->evtr->ring.slock;
 	else
@@ -2619,47 +2631,49 @@ int gsi_queue_xfer(unsigned long chan_hdl, uint16_t num_xfers,
 		return -GSI_STATUS_RING_INSUFFICIENT_SPACE;
 	}
 
-	wp_rollback = ctx->ring.wp_local;
+	/*
+	 * Only the first slot needs translating from the write pointer, the
+	 * following ones are consecutive modulo the ring size. The write
+	 * pointer itself is moved once for the whole batch.
+	 */
+	idx = gsi_find_idx_from_addr(&ctx->ring, ctx->ring.wp_local);
+	tre_ptr = (struct gsi_tre *)(ctx->ring.base_va +
+			idx * ctx->ring.elem_sz);
 	for (i = 0; i < num_xfers; i++) {
 		memset(&tre, 0, sizeof(tre));
 		tre.buffer_ptr = xfer[i].addr;
 		tre.buf_len = xfer[i].len;
-		if (xfer[i].type == GSI_XFER_ELEM_DATA) {
+		if (xfer[i].type == GSI_XFER_ELEM_DATA)
 			tre.re_type = GSI_RE_XFER;
-		} else if (xfer[i].type == GSI_XFER_ELEM_IMME_CMD) {
+		else if (xfer[i].type == GSI_XFER_ELEM_IMME_CMD)
 			tre.re_type = GSI_RE_IMMD_CMD;
-		} else if (xfer[i].type == GSI_XFER_ELEM_NOP) {
+		else
 			tre.re_type = GSI_RE_NOP;
-		} else {
-			GSIERR("chan_hdl=%lu bad RE type=%u\n", chan_hdl,
-				xfer[i].type);
-			break;
-		}
 		tre.bei = (xfer[i].flags & GSI_XFER_FLAG_BEI) ? 1 : 0;
 		tre.ieot = (xfer[i].flags & GSI_XFER_FLAG_EOT) ? 1 : 0;
 		tre.ieob = (xfer[i].flags & GSI_XFER_FLAG_EOB) ? 1 : 0;
 		tre.chain = (xfer[i].flags & GSI_XFER_FLAG_CHAIN) ? 1 : 0;
 
-		idx = gsi_find_idx_from_addr(&ctx->ring, ctx->ring.wp_local);
-		tre_ptr = (struct gsi_tre *)(ctx->ring.base_va +
-				idx * ctx->ring.elem_sz);
-
 		/* write the TRE to ring */
 		*tre_ptr = tre;
 		ctx->user_data[idx] = xfer[i].xfer_user_data;
-		gsi_incr_ring_wp(&ctx->ring);
-	}
 
-	if (i != num_xfers) {
-		/* reject all the xfers */
-		ctx->ring.wp_local = wp_rollback;
-		spin_unlock_irqrestore(slock, flags);
-		return -GSI_STATUS_INVALID_PARAMS;
+		if (++idx > ctx->ring.max_num_elem) {
+			idx = 0;
+			tre_ptr = (struct gsi_tre *)ctx->ring.base_va;
+		} else {
+			tre_ptr = (struct gsi_tre *)((uintptr_t)tre_ptr +
+					ctx->ring.elem_sz);
+		}
 	}
+	ctx->ring.wp_local = ctx->ring.base + idx * ctx->ring.elem_sz;
 
 	ctx->stats.queued += num_xfers;
 
-	/* ensure TRE is set before ringing doorbell */
+	/*
+	 * The ring is coherent memory: a single barrier orders all the TREs
+	 * of the batch before the doorbell.
+	 */
 	wmb();
 
 	if (ring_db)
@@ -2761,6 +2775,81 @@ int gsi_poll_channel(unsigned long chan_hdl,
 }
 EXPORT_SYMBOL(gsi_poll_channel);
 
+int gsi_poll_n_channel(unsigned long chan_hdl,
+		struct gsi_chan_xfer_notify *notify,
+		int expected_num, int *actual_num)
+{
+	struct gsi_chan_ctx *ctx;
+	uint64_t rp;
+	int ee;
+	int i;
+	unsigned long flags;
+
+	if (!gsi_ctx) {
+		pr_err("%s:%d gsi context not allocated\n", __func__, __LINE__);
+		return -GSI_STATUS_NODEV;
+	}
+	ee = gsi_ctx->per.ee;
+
+	if (chan_hdl >= gsi_ctx->max_ch || !notify ||
+	    !actual_num || expected_num <= 0) {
+		GSIERR("bad params chan_hdl=%lu notify=%p\n", chan_hdl, notify);
+		GSIERR("actual_num=%p expected_num=%d\n", actual_num,
+			expected_num);
+		return -GSI_STATUS_INVALID_PARAMS;
+	}
+
+	ctx = &gsi_ctx->chan[chan_hdl];
+
+	if (ctx->props.prot != GSI_CHAN_PROT_GPI) {
+		GSIERR("op not supported for protocol %u\n", ctx->props.prot);
+		return -GSI_STATUS_UNSUPPORTED_OP;
+	}
+
+	if (!ctx->evtr) {
+		GSIERR("no event ring associated chan_hdl=%lu\n", chan_hdl);
+		return -GSI_STATUS_UNSUPPORTED_OP;
+	}
+
+	spin_lock_irqsave(&ctx->evtr->ring.slock, flags);
+	if (ctx->evtr->ring.rp == ctx->evtr->ring.rp_local) {
+		/* update rp to see of we have anything new to process */
+		rp = gsi_readl(gsi_ctx->base +
+			GSI_EE_n_EV_CH_k_CNTXT_4_OFFS(ctx->evtr->id, ee));
+		rp |= ctx->ring.rp & 0xFFFFFFFF00000000;
+
+		ctx->evtr->ring.rp = rp;
+	}
+
+	if (ctx->evtr->ring.rp == ctx->evtr->ring.rp_local) {
+		spin_unlock_irqrestore(&ctx->evtr->ring.slock, flags);
+		ctx->stats.poll_empty++;
+		*actual_num = 0;
+		return GSI_STATUS_POLL_EMPTY;
+	}
+
+	/*
+	 * Drain up to expected_num events with a single lock acquisition and
+	 * a single read of the event ring pointer. The event doorbell is rung
+	 * when the client replenishes the channel, as for gsi_poll_channel.
+	 */
+	for (i = 0; i < expected_num; i++) {
+		if (ctx->evtr->ring.rp == ctx->evtr->ring.rp_local)
+			break;
+		gsi_process_evt_re(ctx->evtr, &notify[i], false);
+	}
+	spin_unlock_irqrestore(&ctx->evtr->ring.slock, flags);
+
+	*actual_num = i;
+	ctx->stats.poll_n++;
+	ctx->stats.poll_n_xfers += i;
+	if (i == expected_num)
+		ctx->stats.poll_n_full++;
+
+	return GSI_STATUS_SUCCESS;
+}
+EXPORT_SYMBOL(gsi_poll_n_channel);
+
 int gsi_config_channel_mode(unsigned long chan_hdl, enum gsi_chan_mode mode)
 {
 	struct gsi_chan_ctx *ctx;
@@ -117,12 +117,16 @@ struct gsi_chan_dp_stats {
 
 struct gsi_chan_stats {
 	unsigned long queued;
+	unsigned long doorbells;
 	unsigned long completed;
 	unsigned long callback_to_poll;
 	unsigned long poll_to_callback;
 	unsigned long invalid_tre_error;
 	unsigned long poll_ok;
 	unsigned long poll_empty;
+	unsigned long poll_n;
+	unsigned long poll_n_xfers;
+	unsigned long poll_n_full;
 	struct gsi_chan_dp_stats dp;
 };
 
@@ -216,6 +220,7 @@ struct gsi_ctx {
 	u32 max_ch;
 	u32 max_ev;
 	struct completion gen_ee_cmd_compl;
+	unsigned long num_isr;
 	void *ipc_logbuf;
 	void *ipc_logbuf_low;
 	struct gsi_shared_chan_info shared_ch_info;
@@ -270,6 +270,7 @@ static void gsi_dump_ch_stats(struct gsi_chan_ctx *ctx)
 	PRT_STAT("queued=%lu compl=%lu\n",
 		ctx->stats.queued,
 		ctx->stats.completed);
+	PRT_STAT("doorbells=%lu\n", ctx->stats.doorbells);
 	PRT_STAT("cb->poll=%lu poll->cb=%lu\n",
 		ctx->stats.callback_to_poll,
 		ctx->stats.poll_to_callback);
@@ -277,6 +278,9 @@ static void gsi_dump_ch_stats(struct gsi_chan_ctx *ctx)
 		ctx->stats.invalid_tre_error);
 	PRT_STAT("poll_ok=%lu poll_empty=%lu\n",
 		ctx->stats.poll_ok, ctx->stats.poll_empty);
+	PRT_STAT("poll_n=%lu poll_n_xfers=%lu poll_n_full=%lu\n",
+		ctx->stats.poll_n, ctx->stats.poll_n_xfers,
+		ctx->stats.poll_n_full);
 	if (ctx->evtr)
 		PRT_STAT("compl_evt=%lu\n",
 			ctx->evtr->stats.completed);
@@ -158,6 +158,37 @@ enum ipa3_usb_transport_type {
 #define IPA3_USB_IS_TTYPE_DPL(__ttype) \
 	((__ttype) == IPA_USB_TRANSPORT_DPL)
 
+/**
+ * struct ipa3_usb_stats - session counters of a transport
+ *
+ * @connects: successful xDCI connects
+ * @suspends: completed suspends, with or without remote wakeup
+ * @suspend_fails: suspends that failed and left the channels connected
+ * @resumes: completed resumes
+ * @resume_fails: resumes that failed and left the channels suspended
+ * @remote_wakeups: remote wakeups sent to USB for pending DL/DPL data
+ * @suspend_us_total: time spent in successful suspend sequences
+ * @suspend_us_max: longest successful suspend sequence
+ * @resume_us_total: time spent in successful resume sequences
+ * @resume_us_max: longest successful resume sequence
+ * @suspended_ms_total: time spent suspended, up to the last resume
+ * @suspended_at: end of the last successful suspend
+ */
+struct ipa3_usb_stats {
+	u32 connects;
+	u32 suspends;
+	u32 suspend_fails;
+	u32 resumes;
+	u32 resume_fails;
+	u32 remote_wakeups;
+	u64 suspend_us_total;
+	u64 suspend_us_max;
+	u64 resume_us_total;
+	u64 resume_us_max;
+	u64 suspended_ms_total;
+	ktime_t suspended_at;
+};
+
 struct ipa3_usb_teth_prot_conn_params {
 	u32 usb_to_ipa_clnt_hdl;
 	u32 ipa_to_usb_clnt_hdl;
@@ -177,6 +208,7 @@ struct ipa3_usb_transport_type_ctx {
 	struct ipa_usb_xdci_chan_params ul_ch_params;
 	struct ipa_usb_xdci_chan_params dl_ch_params;
 	struct ipa3_usb_teth_prot_conn_params teth_conn_params;
+	struct ipa3_usb_stats stats;
 };
 
 struct ipa3_usb_smmu_reg_map {
@@ -198,6 +230,7 @@ struct ipa3_usb_context {
 	struct ipa3_usb_transport_type_ctx
 		ttype_ctx[IPA_USB_TRANSPORT_MAX];
 	struct dentry *dfile_state_info;
+	struct dentry *dfile_stats;
 	struct dentry *dent;
 	struct ipa3_usb_smmu_reg_map smmu_reg_map;
 	struct ipa3_usb_smmu_reg_map smmu_reg_map_dummy;
@@ -507,6 +540,10 @@ static void ipa3_usb_notify_do(enum ipa3_usb_transport_type ttype,
 	cb = ipa3_usb_ctx->ttype_ctx[ttype].ipa_usb_notify_cb;
 	user_data = ipa3_usb_ctx->ttype_ctx[ttype].user_data;
 
+	/* remote wakeups are only sent from the ordered ipa3_usb_ctx->wq */
+	if (event == IPA_USB_REMOTE_WAKEUP)
+		ipa3_usb_ctx->ttype_ctx[ttype].stats.remote_wakeups++;
+
 	if (cb) {
 		res = cb(event, user_data);
 		IPA_USB_DBG("Notified USB with %s. is_dpl=%d result=%d\n",
@@ -708,6 +745,39 @@ static void ipa3_usb_pm_cb(void *p, enum ipa_pm_cb_event event)
 	IPA_USB_DBG_LOW("exit\n");
 }
 
+/* Account a suspend or resume sequence. Called with general_mutex held */
+static void ipa3_usb_stats_pm_done(enum ipa3_usb_transport_type ttype,
+	enum ipa3_usb_op op, ktime_t start, int result)
+{
+	struct ipa3_usb_stats *stats = &ipa3_usb_ctx->ttype_ctx[ttype].stats;
+	ktime_t now = ktime_get();
+	u64 us = ktime_us_delta(now, start);
+
+	if (op == IPA_USB_OP_RESUME) {
+		if (result) {
+			stats->resume_fails++;
+			return;
+		}
+		stats->resumes++;
+		stats->resume_us_total += us;
+		stats->resume_us_max = max(stats->resume_us_max, us);
+		if (ktime_to_ns(stats->suspended_at))
+			stats->suspended_ms_total +=
+				ktime_ms_delta(start, stats->suspended_at);
+		stats->suspended_at = ktime_set(0, 0);
+		return;
+	}
+
+	if (result) {
+		stats->suspend_fails++;
+		return;
+	}
+	stats->suspends++;
+	stats->suspend_us_total += us;
+	stats->suspend_us_max = max(stats->suspend_us_max, us);
+	stats->suspended_at = now;
+}
+
 static char *ipa3_usb_teth_prot_to_string(enum ipa_usb_teth_prot teth_prot)
 {
 	switch (teth_prot) {
@@ -2344,6 +2414,79 @@ const struct file_operations ipa3_ipa_usb_ops = {
 	.read = ipa3_read_usb_state_info,
 };
 
+static const char *ipa3_usb_ttype_to_string(enum ipa3_usb_transport_type ttype)
+{
+	switch (ttype) {
+	case IPA_USB_TRANSPORT_TETH:
+		return "teth";
+	case IPA_USB_TRANSPORT_DPL:
+		return "dpl";
+	case IPA_USB_TRANSPORT_TETH_2:
+		return "teth_2";
+	default:
+		return "unsupported";
+	}
+}
+
+static ssize_t ipa3_read_usb_stats(struct file *file, char __user *ubuf,
+		size_t count, loff_t *ppos)
+{
+	struct ipa3_usb_stats *stats;
+	int cnt = 0;
+	int i;
+
+	mutex_lock(&ipa3_usb_ctx->general_mutex);
+	for (i = 0; i < IPA_USB_TRANSPORT_MAX; i++) {
+		stats = &ipa3_usb_ctx->ttype_ctx[i].stats;
+		cnt += scnprintf(dbg_buff + cnt, IPA_USB_MAX_MSG_LEN - cnt,
+			"%s: state=%s connects=%u remote_wakeups=%u\n"
+			"  suspends=%u fails=%u avg_us=%llu max_us=%llu\n"
+			"  resumes=%u fails=%u avg_us=%llu max_us=%llu\n"
+			"  suspended_ms=%llu\n",
+			ipa3_usb_ttype_to_string(i),
+			ipa3_usb_state_to_string(
+				ipa3_usb_ctx->ttype_ctx[i].state),
+			stats->connects, stats->remote_wakeups,
+			stats->suspends, stats->suspend_fails,
+			stats->suspends ? div_u64(stats->suspend_us_total,
+				stats->suspends) : 0,
+			stats->suspend_us_max,
+			stats->resumes, stats->resume_fails,
+			stats->resumes ? div_u64(stats->resume_us_total,
+				stats->resumes) : 0,
+			stats->resume_us_max,
+			stats->suspended_ms_total);
+	}
+	mutex_unlock(&ipa3_usb_ctx->general_mutex);
+
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, cnt);
+}
+
+/* Any write clears the counters, e.g. before a throughput run */
+static ssize_t ipa3_write_usb_stats(struct file *file,
+		const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	struct ipa3_usb_stats *stats;
+	ktime_t suspended_at;
+	int i;
+
+	mutex_lock(&ipa3_usb_ctx->general_mutex);
+	for (i = 0; i < IPA_USB_TRANSPORT_MAX; i++) {
+		stats = &ipa3_usb_ctx->ttype_ctx[i].stats;
+		suspended_at = stats->suspended_at;
+		memset(stats, 0, sizeof(*stats));
+		stats->suspended_at = suspended_at;
+	}
+	mutex_unlock(&ipa3_usb_ctx->general_mutex);
+
+	return count;
+}
+
+const struct file_operations ipa3_ipa_usb_stats_ops = {
+	.read = ipa3_read_usb_stats,
+	.write = ipa3_write_usb_stats,
+};
+
 static void ipa_usb_debugfs_init(void)
 {
 	const mode_t read_only_mode = S_IRUSR | S_IRGRP | S_IROTH;
@@ -2363,6 +2506,15 @@ static void ipa_usb_debugfs_init(void)
 		goto fail;
 	}
 
+	ipa3_usb_ctx->dfile_stats = debugfs_create_file("stats",
+			read_only_mode | S_IWUSR, ipa3_usb_ctx->dent, 0,
+			&ipa3_ipa_usb_stats_ops);
+	if (!ipa3_usb_ctx->dfile_stats ||
+		IS_ERR(ipa3_usb_ctx->dfile_stats)) {
+		pr_err("failed to create file for stats\n");
+		goto fail;
+	}
+
 	return;
 
 fail:
@@ -2444,6 +2596,8 @@ int ipa_usb_xdci_connect(struct ipa_usb_xdci_chan_params *ul_chan_params,
 		IPA_USB_ERR("failed to connect.\n");
 		goto connect_fail;
 	}
+	ipa3_usb_ctx->ttype_ctx[IPA3_USB_GET_TTYPE(conn_params.teth_prot)].
+		stats.connects++;
 
 	IPA_USB_DBG_LOW("exit\n");
 	mutex_unlock(&ipa3_usb_ctx->general_mutex);
@@ -2872,6 +3026,7 @@ int ipa_usb_xdci_suspend(u32 ul_clnt_hdl, u32 dl_clnt_hdl,
 	int result = 0;
 	unsigned long flags;
 	enum ipa3_usb_transport_type ttype;
+	ktime_t start = ktime_get();
 
 	mutex_lock(&ipa3_usb_ctx->general_mutex);
 	IPA_USB_DBG_LOW("entry\n");
@@ -2882,15 +3037,17 @@ int ipa_usb_xdci_suspend(u32 ul_clnt_hdl, u32 dl_clnt_hdl,
 		goto bad_params;
 	}
 
+	ttype = IPA3_USB_GET_TTYPE(teth_prot);
+
 	if (!with_remote_wakeup) {
 		result = ipa3_usb_suspend_no_remote_wakeup(ul_clnt_hdl,
 			dl_clnt_hdl, teth_prot);
+		ipa3_usb_stats_pm_done(ttype, IPA_USB_OP_SUSPEND, start,
+			result);
 		mutex_unlock(&ipa3_usb_ctx->general_mutex);
 		return result;
 	}
 
-	ttype = IPA3_USB_GET_TTYPE(teth_prot);
-
 	if (!ipa3_usb_check_legal_op(IPA_USB_OP_SUSPEND, ttype)) {
 		IPA_USB_ERR("Illegal operation.\n");
 		result = -EPERM;
@@ -2958,6 +3115,7 @@ int ipa_usb_xdci_suspend(u32 ul_clnt_hdl, u32 dl_clnt_hdl,
 	}
 	spin_unlock_irqrestore(&ipa3_usb_ctx->state_lock, flags);
 
+	ipa3_usb_stats_pm_done(ttype, IPA_USB_OP_SUSPEND, start, 0);
 	IPA_USB_DBG_LOW("exit\n");
 	mutex_unlock(&ipa3_usb_ctx->general_mutex);
 	return 0;
@@ -2969,6 +3127,7 @@ suspend_fail:
 	/* Change state back to CONNECTED */
 	if (!ipa3_usb_set_state(IPA_USB_CONNECTED, true, ttype))
 		IPA_USB_ERR("failed to change state back to connected\n");
+	ipa3_usb_stats_pm_done(ttype, IPA_USB_OP_SUSPEND, start, result);
 bad_params:
 	mutex_unlock(&ipa3_usb_ctx->general_mutex);
 	return result;
@@ -3056,6 +3215,7 @@ int ipa_usb_xdci_resume(u32 ul_clnt_hdl, u32 dl_clnt_hdl,
 	enum ipa3_usb_state prev_state;
 	unsigned long flags;
 	enum ipa3_usb_transport_type ttype;
+	ktime_t start = ktime_get();
 
 	mutex_lock(&ipa3_usb_ctx->general_mutex);
 	IPA_USB_DBG_LOW("entry\n");
@@ -3080,6 +3240,8 @@ int ipa_usb_xdci_resume(u32 ul_clnt_hdl, u32 dl_clnt_hdl,
 	if (prev_state == IPA_USB_SUSPENDED_NO_RWAKEUP) {
 		result = ipa3_usb_resume_no_remote_wakeup(ul_clnt_hdl,
 			dl_clnt_hdl, teth_prot);
+		ipa3_usb_stats_pm_done(ttype, IPA_USB_OP_RESUME, start,
+			result);
 		mutex_unlock(&ipa3_usb_ctx->general_mutex);
 		return result;
 	}
@@ -3127,6 +3289,7 @@ int ipa_usb_xdci_resume(u32 ul_clnt_hdl, u32 dl_clnt_hdl,
 		goto state_change_connected_fail;
 	}
 
+	ipa3_usb_stats_pm_done(ttype, IPA_USB_OP_RESUME, start, 0);
 	IPA_USB_DBG_LOW("exit\n");
 	mutex_unlock(&ipa3_usb_ctx->general_mutex);
 	return 0;
@@ -3153,6 +3316,8 @@ prod_req_fail:
 	if (!ipa3_usb_set_state(prev_state, true, ttype))
 		IPA_USB_ERR("failed to change state back to %s\n",
 			ipa3_usb_state_to_string(prev_state));
+	ipa3_usb_stats_pm_done(ttype, IPA_USB_OP_RESUME, start,
+		result ?: -EFAULT);
 bad_params:
 	mutex_unlock(&ipa3_usb_ctx->general_mutex);
 	return result;
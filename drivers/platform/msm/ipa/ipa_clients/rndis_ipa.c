@@ -170,6 +170,8 @@ enum rndis_ipa_operation {
  * @icmp_filter: allow all ICMP packet to pass through the filters
  * @rm_enable: flag that enable/disable Resource manager request prior to Tx
  * @deaggregation_enable: enable/disable IPA HW deaggregation logic
+ * @aggr_time_limit: IPA to USB aggregation time limit of the next sessions
+ * @aggr_pkt_limit: IPA to USB aggregation packet limit of the next sessions
  * @during_xmit_error: flags that indicate that the driver is in a middle
  *  of error handling in Tx path
  * @directory: holds all debug flags used by the driver to allow cleanup
@@ -205,6 +207,8 @@ struct rndis_ipa_dev {
 	bool icmp_filter;
 	bool rm_enable;
 	bool deaggregation_enable;
+	u32 aggr_time_limit;
+	u32 aggr_pkt_limit;
 	bool during_xmit_error;
 	struct dentry *directory;
 	u32 eth_ipv4_hdr_hdl;
@@ -298,7 +302,8 @@ static int rndis_ipa_ep_registers_cfg
 	u32 ipa_to_usb_hdl, u32 max_xfer_size_bytes_to_dev,
 	u32 max_xfer_size_bytes_to_host, u32 mtu,
 	bool deaggr_enable,
-	bool is_vlan_mode);
+	bool is_vlan_mode,
+	u32 aggr_time_limit, u32 aggr_pkt_limit);
 static int rndis_ipa_set_device_ethernet_addr
 	(u8 *dev_ethaddr,
 	u8 device_ethaddr[]);
@@ -564,6 +569,8 @@ int rndis_ipa_init(struct ipa_usb_init_params *params)
 	rndis_ipa_ctx->tx_dump_enable = false;
 	rndis_ipa_ctx->rx_dump_enable = false;
 	rndis_ipa_ctx->deaggregation_enable = false;
+	rndis_ipa_ctx->aggr_time_limit = DEFAULT_AGGR_TIME_LIMIT;
+	rndis_ipa_ctx->aggr_pkt_limit = DEFAULT_AGGR_PKT_LIMIT;
 	rndis_ipa_ctx->outstanding_high = DEFAULT_OUTSTANDING_HIGH;
 	rndis_ipa_ctx->outstanding_low = DEFAULT_OUTSTANDING_LOW;
 	atomic_set(&rndis_ipa_ctx->outstanding_pkts, 0);
@@ -785,7 +792,9 @@ int rndis_ipa_pipe_connect_notify(
 		max_xfer_size_bytes_to_host,
 		rndis_ipa_ctx->net->mtu,
 		rndis_ipa_ctx->deaggregation_enable,
-		rndis_ipa_ctx->is_vlan_mode);
+		rndis_ipa_ctx->is_vlan_mode,
+		rndis_ipa_ctx->aggr_time_limit,
+		rndis_ipa_ctx->aggr_pkt_limit);
 	if (result) {
 		RNDIS_IPA_ERROR("fail on ep cfg\n");
 		goto fail;
@@ -2184,6 +2193,8 @@ static bool rm_enabled(struct rndis_ipa_dev *rndis_ipa_ctx)
  * @mtu: the netdev MTU size, in bytes
  * @deaggr_enable: should deaggregation be enabled?
  * @is_vlan_mode: should driver work in vlan mode?
+ * @aggr_time_limit: aggregation time limit of the IPA to USB pipe
+ * @aggr_pkt_limit: aggregation packet limit of the IPA to USB pipe
  *
  * USB to IPA pipe:
  *  - de-aggregation
@@ -2203,7 +2214,9 @@ static int rndis_ipa_ep_registers_cfg(
 	u32 max_xfer_size_bytes_to_host,
 	u32 mtu,
 	bool deaggr_enable,
-	bool is_vlan_mode)
+	bool is_vlan_mode,
+	u32 aggr_time_limit,
+	u32 aggr_pkt_limit)
 {
 	int result;
 	struct ipa_ep_cfg *usb_to_ipa_ep_cfg;
@@ -2247,10 +2260,8 @@ static int rndis_ipa_ep_registers_cfg(
 		ipa_to_usb_ep_cfg.aggr.aggr_time_limit = 0;
 		ipa_to_usb_ep_cfg.aggr.aggr_pkt_limit = 1;
 	} else {
-		ipa_to_usb_ep_cfg.aggr.aggr_time_limit =
-			DEFAULT_AGGR_TIME_LIMIT;
-		ipa_to_usb_ep_cfg.aggr.aggr_pkt_limit =
-			DEFAULT_AGGR_PKT_LIMIT;
+		ipa_to_usb_ep_cfg.aggr.aggr_time_limit = aggr_time_limit;
+		ipa_to_usb_ep_cfg.aggr.aggr_pkt_limit = aggr_pkt_limit;
 	}
 
 	RNDIS_IPA_DEBUG(
@@ -2550,7 +2561,7 @@ static void rndis_ipa_debugfs_init(struct rndis_ipa_dev *rndis_ipa_ctx)
 	file = debugfs_create_u32
 		("aggr_time_limit", flags_read_write,
 		aggr_directory,
-		&ipa_to_usb_ep_cfg.aggr.aggr_time_limit);
+		&rndis_ipa_ctx->aggr_time_limit);
 	if (!file) {
 		RNDIS_IPA_ERROR("could not create aggr_time_limit file\n");
 		goto fail_file;
@@ -2559,7 +2570,7 @@ static void rndis_ipa_debugfs_init(struct rndis_ipa_dev *rndis_ipa_ctx)
 	file = debugfs_create_u32
 		("aggr_pkt_limit", flags_read_write,
 		aggr_directory,
-		&ipa_to_usb_ep_cfg.aggr.aggr_pkt_limit);
+		&rndis_ipa_ctx->aggr_pkt_limit);
 	if (!file) {
 		RNDIS_IPA_ERROR("could not create aggr_pkt_limit file\n");
 		goto fail_file;
@@ -2663,12 +2674,24 @@ static ssize_t rndis_ipa_debugfs_aggr_write
 		return -EFAULT;
 	rndis_ipa_ctx = file->private_data;
 
-	result = ipa_cfg_ep(rndis_ipa_ctx->usb_to_ipa_hdl, &ipa_to_usb_ep_cfg);
+	/*
+	 * Aggregation is done on the IPA to USB pipe. The time and packet
+	 * limits are kept for the next sessions, which would otherwise be
+	 * reconfigured with the defaults on connect.
+	 */
+	if (ipa_to_usb_ep_cfg.aggr.aggr_byte_limit) {
+		ipa_to_usb_ep_cfg.aggr.aggr_time_limit =
+			rndis_ipa_ctx->aggr_time_limit;
+		ipa_to_usb_ep_cfg.aggr.aggr_pkt_limit =
+			rndis_ipa_ctx->aggr_pkt_limit;
+	}
+
+	result = ipa_cfg_ep(rndis_ipa_ctx->ipa_to_usb_hdl, &ipa_to_usb_ep_cfg);
 	if (result) {
-		pr_err("failed to re-configure USB to IPA point\n");
+		pr_err("failed to re-configure IPA to USB end-point\n");
 		return result;
 	}
-	pr_info("IPA<-USB end-point re-configured\n");
+	pr_info("IPA->USB end-point re-configured\n");
 
 	return count;
 }
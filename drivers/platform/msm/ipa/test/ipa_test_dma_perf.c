@@ -0,0 +1,288 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/cpufreq.h>
+#include <linux/ipa.h>
+#include <linux/ktime.h>
+#include <linux/tick.h>
+#include <linux/wait.h>
+#include "../ipa_v3/ipa_i.h"
+#include "../../gsi/gsi.h"
+#include "ipa_ut_framework.h"
+
+#define IPA_TEST_DMA_PERF_PKTS		10000
+#define IPA_TEST_DMA_PERF_MAX_SIZE	16384
+#define IPA_TEST_DMA_PERF_WINDOW	64
+#define IPA_TEST_DMA_PERF_TIMEOUT	msecs_to_jiffies(5000)
+
+/* packet sizes of the stream, from pure ACKs to the largest DMA copy */
+static const int ipa_test_dma_perf_sizes[] = {
+	64, 576, 1500, 4096, IPA_TEST_DMA_PERF_MAX_SIZE
+};
+
+/**
+ * struct ipa_test_dma_perf_ctx - suite private data
+ * @src: source buffer shared by all copies
+ * @dest: destination buffer shared by all copies
+ * @inflight: async copies not completed yet
+ * @wq: woken by every async completion
+ */
+struct ipa_test_dma_perf_ctx {
+	struct ipa_mem_buffer src;
+	struct ipa_mem_buffer dest;
+	atomic_t inflight;
+	wait_queue_head_t wq;
+};
+
+/**
+ * struct ipa_test_dma_perf_snap - counters sampled around a run
+ * @time: wall clock
+ * @busy_us: non idle time summed over the online cpus
+ * @cycles: busy time of every cpu times its current frequency
+ * @isrs: GSI interrupts
+ * @doorbells: channel doorbells rung on all GSI channels
+ */
+struct ipa_test_dma_perf_snap {
+	ktime_t time;
+	u64 busy_us;
+	u64 cycles;
+	unsigned long isrs;
+	unsigned long doorbells;
+};
+
+static void ipa_test_dma_perf_sample(struct ipa_test_dma_perf_snap *snap)
+{
+	u64 idle, wall;
+	int cpu, i;
+
+	snap->busy_us = 0;
+	snap->cycles = 0;
+	for_each_online_cpu(cpu) {
+		idle = get_cpu_idle_time_us(cpu, &wall);
+		if (idle == -1ULL)
+			continue;
+		snap->busy_us += wall - idle;
+		snap->cycles += (wall - idle) * cpufreq_quick_get(cpu) / 1000;
+	}
+
+	snap->isrs = gsi_ctx->num_isr;
+	snap->doorbells = 0;
+	for (i = 0; i < gsi_ctx->max_ch; i++)
+		if (gsi_ctx->chan[i].allocated)
+			snap->doorbells += gsi_ctx->chan[i].stats.doorbells;
+	snap->time = ktime_get();
+}
+
+static void ipa_test_dma_perf_report(const char *mode, int size, int pkts,
+	struct ipa_test_dma_perf_snap *start)
+{
+	struct ipa_test_dma_perf_snap end;
+	s64 us;
+
+	ipa_test_dma_perf_sample(&end);
+	us = max_t(s64, ktime_us_delta(end.time, start->time), 1);
+
+	IPA_UT_INFO(
+		"%s size=%d pkts=%d pps=%llu cpu_ns/pkt=%llu cycles/pkt=%llu irqs/kpkt=%lu db/kpkt=%lu\n",
+		mode, size, pkts, div64_u64((u64)pkts * USEC_PER_SEC, us),
+		div_u64((end.busy_us - start->busy_us) * NSEC_PER_USEC, pkts),
+		div_u64(end.cycles - start->cycles, pkts),
+		(end.isrs - start->isrs) * 1000 / pkts,
+		(end.doorbells - start->doorbells) * 1000 / pkts);
+}
+
+static int ipa_test_dma_perf_suite_setup(void **ppriv)
+{
+	struct ipa_test_dma_perf_ctx *ctx;
+	int rc;
+
+	IPA_UT_DBG("Start Setup\n");
+
+	if (!ipa3_ctx || !gsi_ctx) {
+		IPA_UT_ERR("No IPA ctx\n");
+		return -EINVAL;
+	}
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	atomic_set(&ctx->inflight, 0);
+	init_waitqueue_head(&ctx->wq);
+
+	ctx->src.size = IPA_TEST_DMA_PERF_MAX_SIZE;
+	ctx->src.base = dma_alloc_coherent(ipa3_ctx->pdev, ctx->src.size,
+		&ctx->src.phys_base, GFP_KERNEL);
+	ctx->dest.size = IPA_TEST_DMA_PERF_MAX_SIZE;
+	ctx->dest.base = dma_alloc_coherent(ipa3_ctx->pdev, ctx->dest.size,
+		&ctx->dest.phys_base, GFP_KERNEL);
+	if (!ctx->src.base || !ctx->dest.base) {
+		IPA_UT_ERR("fail to alloc dma mem\n");
+		rc = -ENOMEM;
+		goto fail_free;
+	}
+	memset(ctx->src.base, 0xA5, ctx->src.size);
+
+	rc = ipa_dma_init();
+	if (rc) {
+		IPA_UT_ERR("Fail to init ipa_dma - return code %d\n", rc);
+		goto fail_free;
+	}
+
+	rc = ipa_dma_enable();
+	if (rc) {
+		IPA_UT_ERR("Fail to enable ipa_dma - return code %d\n", rc);
+		ipa_dma_destroy();
+		goto fail_free;
+	}
+
+	*ppriv = ctx;
+	return 0;
+
+fail_free:
+	if (ctx->dest.base)
+		dma_free_coherent(ipa3_ctx->pdev, ctx->dest.size,
+			ctx->dest.base, ctx->dest.phys_base);
+	if (ctx->src.base)
+		dma_free_coherent(ipa3_ctx->pdev, ctx->src.size,
+			ctx->src.base, ctx->src.phys_base);
+	kfree(ctx);
+	return rc;
+}
+
+static int ipa_test_dma_perf_suite_teardown(void *priv)
+{
+	struct ipa_test_dma_perf_ctx *ctx = priv;
+
+	IPA_UT_DBG("Start Teardown\n");
+
+	ipa_dma_disable();
+	ipa_dma_destroy();
+	dma_free_coherent(ipa3_ctx->pdev, ctx->dest.size, ctx->dest.base,
+		ctx->dest.phys_base);
+	dma_free_coherent(ipa3_ctx->pdev, ctx->src.size, ctx->src.base,
+		ctx->src.phys_base);
+	kfree(ctx);
+
+	return 0;
+}
+
+/*
+ * One copy at a time: the latency bound rate of the DMA pipe, with the
+ * cpu polling for every completion.
+ */
+static int ipa_test_dma_perf_sync(void *priv)
+{
+	struct ipa_test_dma_perf_ctx *ctx = priv;
+	struct ipa_test_dma_perf_snap start;
+	int i, j, size;
+	int rc;
+
+	for (i = 0; i < ARRAY_SIZE(ipa_test_dma_perf_sizes); i++) {
+		size = ipa_test_dma_perf_sizes[i];
+
+		ipa_test_dma_perf_sample(&start);
+		for (j = 0; j < IPA_TEST_DMA_PERF_PKTS; j++) {
+			rc = ipa_dma_sync_memcpy(ctx->dest.phys_base,
+				ctx->src.phys_base, size);
+			if (rc) {
+				IPA_UT_LOG("sync memcpy failed rc=%d\n", rc);
+				IPA_UT_TEST_FAIL_REPORT("sync memcpy failed");
+				return rc;
+			}
+		}
+		ipa_test_dma_perf_report("sync", size,
+			IPA_TEST_DMA_PERF_PKTS, &start);
+	}
+
+	return 0;
+}
+
+static void ipa_test_dma_perf_async_cb(void *user_param)
+{
+	struct ipa_test_dma_perf_ctx *ctx = user_param;
+
+	atomic_dec(&ctx->inflight);
+	wake_up(&ctx->wq);
+}
+
+static bool ipa_test_dma_perf_has_room(struct ipa_test_dma_perf_ctx *ctx)
+{
+	return atomic_read(&ctx->inflight) < IPA_TEST_DMA_PERF_WINDOW;
+}
+
+/*
+ * A stream of copies with up to IPA_TEST_DMA_PERF_WINDOW outstanding,
+ * completed through the GSI interrupt: the throughput bound rate, and
+ * the interrupts and doorbells it costs per packet.
+ */
+static int ipa_test_dma_perf_async(void *priv)
+{
+	struct ipa_test_dma_perf_ctx *ctx = priv;
+	struct ipa_test_dma_perf_snap start;
+	int i, j, size;
+	int rc = 0;
+
+	for (i = 0; i < ARRAY_SIZE(ipa_test_dma_perf_sizes); i++) {
+		size = ipa_test_dma_perf_sizes[i];
+
+		ipa_test_dma_perf_sample(&start);
+		for (j = 0; j < IPA_TEST_DMA_PERF_PKTS; j++) {
+			if (!wait_event_timeout(ctx->wq,
+				ipa_test_dma_perf_has_room(ctx),
+				IPA_TEST_DMA_PERF_TIMEOUT)) {
+				IPA_UT_TEST_FAIL_REPORT("async memcpy stuck");
+				rc = -ETIMEDOUT;
+				break;
+			}
+
+			atomic_inc(&ctx->inflight);
+			rc = ipa_dma_async_memcpy(ctx->dest.phys_base,
+				ctx->src.phys_base, size,
+				ipa_test_dma_perf_async_cb, ctx);
+			if (rc) {
+				atomic_dec(&ctx->inflight);
+				IPA_UT_LOG("async memcpy failed rc=%d\n", rc);
+				IPA_UT_TEST_FAIL_REPORT("async memcpy failed");
+				break;
+			}
+		}
+
+		/* the callbacks reference ctx, never leave with copies queued */
+		if (!wait_event_timeout(ctx->wq, !atomic_read(&ctx->inflight),
+			IPA_TEST_DMA_PERF_TIMEOUT)) {
+			IPA_UT_ERR("%d async copies did not complete\n",
+				atomic_read(&ctx->inflight));
+			wait_event(ctx->wq, !atomic_read(&ctx->inflight));
+			if (!rc)
+				rc = -ETIMEDOUT;
+		}
+		if (rc)
+			return rc;
+
+		ipa_test_dma_perf_report("async", size,
+			IPA_TEST_DMA_PERF_PKTS, &start);
+	}
+
+	return 0;
+}
+
+/* Suite definition block */
+IPA_UT_DEFINE_SUITE_START(dma_perf, "DMA data path performance",
+	ipa_test_dma_perf_suite_setup, ipa_test_dma_perf_suite_teardown)
+{
+	IPA_UT_ADD_TEST(sync, "Sync memcpy rate and cpu cost vs size",
+		ipa_test_dma_perf_sync, true, IPA_HW_v3_0, IPA_HW_MAX),
+	IPA_UT_ADD_TEST(async, "Async memcpy stream rate, irqs and doorbells",
+		ipa_test_dma_perf_async, true, IPA_HW_v3_0, IPA_HW_MAX),
+
+} IPA_UT_DEFINE_SUITE_END(dma_perf);
@@ -0,0 +1,165 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "ipa_ut_framework.h"
+#include <linux/ktime.h>
+
+#define IPA_TEST_FLTRT_PERF_TBL "V4_RT_PERF"
+#define IPA_TEST_FLTRT_PERF_PORT 10000
+
+/* number of rules installed before the commit latency is measured */
+static const u8 ipa_test_fltrt_perf_counts[] = { 1, 16, 64, 128, 254 };
+
+static int ipa_test_fltrt_perf_suite_setup(void **ppriv)
+{
+	IPA_UT_DBG("Start Setup\n");
+
+	return 0;
+}
+
+static int ipa_test_fltrt_perf_suite_teardown(void *priv)
+{
+	IPA_UT_DBG("Start Teardown\n");
+
+	return 0;
+}
+
+static void ipa_test_fltrt_perf_fill(struct ipa_ioc_add_rt_rule *rt_rule,
+	u8 num, u16 port, bool commit)
+{
+	int i;
+
+	memset(rt_rule, 0, sizeof(*rt_rule) +
+		num * sizeof(struct ipa_rt_rule_add));
+	rt_rule->commit = commit;
+	rt_rule->ip = IPA_IP_v4;
+	strlcpy(rt_rule->rt_tbl_name, IPA_TEST_FLTRT_PERF_TBL,
+		IPA_RESOURCE_NAME_MAX);
+	rt_rule->num_rules = num;
+	for (i = 0; i < num; i++) {
+		rt_rule->rules[i].at_rear = 1;
+		rt_rule->rules[i].rule.dst = IPA_CLIENT_APPS_LAN_CONS;
+		rt_rule->rules[i].rule.attrib.attrib_mask = IPA_FLT_DST_PORT;
+		rt_rule->rules[i].rule.attrib.dst_port = port + i;
+		rt_rule->rules[i].rule.hashable = true;
+	}
+}
+
+static int ipa_test_fltrt_perf_del(struct ipa_ioc_add_rt_rule *rt_rule,
+	u8 num, u32 last_hdl)
+{
+	struct ipa_ioc_del_rt_rule *del;
+	int i;
+	int ret = 0;
+
+	del = kzalloc(sizeof(*del) + (num + 1) * sizeof(struct ipa_rule_del),
+		GFP_KERNEL);
+	if (!del) {
+		IPA_UT_DBG("no mem\n");
+		return -ENOMEM;
+	}
+
+	del->commit = 1;
+	del->ip = IPA_IP_v4;
+	del->num_hdls = num + 1;
+	for (i = 0; i < num; i++)
+		del->hdl[i].hdl = rt_rule->rules[i].rt_rule_hdl;
+	del->hdl[num].hdl = last_hdl;
+
+	if (ipa_del_rt_rule(del)) {
+		IPA_UT_ERR("failed to delete rules\n");
+		ret = -EFAULT;
+	}
+
+	kfree(del);
+	return ret;
+}
+
+/*
+ * For each rule count: install the rules without committing, time a full
+ * commit of the table, then time adding one more rule with commit set,
+ * which is what a single firewall or tethering client change costs.
+ */
+static int ipa_test_fltrt_perf_rt_commit(void *priv)
+{
+	struct ipa_ioc_add_rt_rule *rt_rule;
+	struct ipa_ioc_add_rt_rule *one;
+	ktime_t start;
+	s64 commit_us, add_one_us;
+	u8 num;
+	int i;
+	int ret = 0;
+
+	rt_rule = kzalloc(sizeof(*rt_rule) + U8_MAX *
+		sizeof(struct ipa_rt_rule_add), GFP_KERNEL);
+	one = kzalloc(sizeof(*one) + sizeof(struct ipa_rt_rule_add),
+		GFP_KERNEL);
+	if (!rt_rule || !one) {
+		IPA_UT_DBG("no mem\n");
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(ipa_test_fltrt_perf_counts); i++) {
+		num = ipa_test_fltrt_perf_counts[i];
+
+		ipa_test_fltrt_perf_fill(rt_rule, num,
+			IPA_TEST_FLTRT_PERF_PORT, false);
+		if (ipa_add_rt_rule(rt_rule)) {
+			IPA_UT_TEST_FAIL_REPORT("failed to add rules");
+			ret = -EFAULT;
+			goto free;
+		}
+
+		start = ktime_get();
+		if (ipa_commit_rt(IPA_IP_v4)) {
+			IPA_UT_TEST_FAIL_REPORT("failed to commit rules");
+			ret = -EFAULT;
+			goto free;
+		}
+		commit_us = ktime_us_delta(ktime_get(), start);
+
+		ipa_test_fltrt_perf_fill(one, 1,
+			IPA_TEST_FLTRT_PERF_PORT + num, true);
+		start = ktime_get();
+		if (ipa_add_rt_rule(one) || one->rules[0].status) {
+			IPA_UT_TEST_FAIL_REPORT("failed to add one rule");
+			ret = -EFAULT;
+			goto free;
+		}
+		add_one_us = ktime_us_delta(ktime_get(), start);
+
+		IPA_UT_INFO("rules=%u commit=%lldus add_one=%lldus\n",
+			num, commit_us, add_one_us);
+
+		ret = ipa_test_fltrt_perf_del(rt_rule, num,
+			one->rules[0].rt_rule_hdl);
+		if (ret) {
+			IPA_UT_TEST_FAIL_REPORT("failed to delete rules");
+			goto free;
+		}
+	}
+
+free:
+	kfree(one);
+	kfree(rt_rule);
+	return ret;
+}
+
+/* Suite definition block */
+IPA_UT_DEFINE_SUITE_START(fltrt_perf, "FLT/RT commit latency",
+	ipa_test_fltrt_perf_suite_setup, ipa_test_fltrt_perf_suite_teardown)
+{
+	IPA_UT_ADD_TEST(rt_commit, "RT commit latency vs rule count",
+		ipa_test_fltrt_perf_rt_commit, false, IPA_HW_v3_0, IPA_HW_MAX),
+
+} IPA_UT_DEFINE_SUITE_END(fltrt_perf);
@@ -25,6 +25,8 @@ IPA_UT_DECLARE_SUITE(dma);
 IPA_UT_DECLARE_SUITE(pm);
 IPA_UT_DECLARE_SUITE(example);
 IPA_UT_DECLARE_SUITE(hw_stats);
+IPA_UT_DECLARE_SUITE(fltrt_perf);
+IPA_UT_DECLARE_SUITE(dma_perf);
 
 
 /**
@@ -38,6 +40,8 @@ IPA_UT_DEFINE_ALL_SUITES_START
 	IPA_UT_REGISTER_SUITE(pm),
 	IPA_UT_REGISTER_SUITE(example),
 	IPA_UT_REGISTER_SUITE(hw_stats),
+	IPA_UT_REGISTER_SUITE(fltrt_perf),
+	IPA_UT_REGISTER_SUITE(dma_perf),
 } IPA_UT_DEFINE_ALL_SUITES_END;
 
 #endif /* _IPA_UT_SUITE_LIST_H_ */
@@ -87,6 +87,16 @@ MODULE_PARM_DESC(mhi_net_msg_lvl, "mhi dev net dbg lvl");
 module_param(mhi_net_ipc_log_lvl, uint, 0644);
 MODULE_PARM_DESC(mhi_net_ipc_log_lvl, "mhi dev net dbg lvl");
 
+/*
+ * Completion events are flushed to the host when the ring runs empty, when
+ * the completion event buffer reaches its threshold, or when a request asks
+ * for it. A non zero budget also flushes after that many packets in a burst,
+ * bounding how long the host waits for completions under sustained load.
+ */
+static unsigned int mhi_net_cmpl_budget;
+module_param(mhi_net_cmpl_budget, uint, 0644);
+MODULE_PARM_DESC(mhi_net_cmpl_budget, "packets per completion flush, 0 = auto");
+
 struct mhi_dev_net_client {
 	/* write channel - always even*/
 	u32 out_chan;
@@ -154,6 +164,7 @@ static void mhi_dev_net_process_queue_packets(struct work_struct *work)
 	int xfer_data = 0;
 	struct sk_buff *skb = NULL;
 	struct mhi_req *wreq = NULL;
+	unsigned int burst = 0;
 
 	if (mhi_dev_channel_isempty(client->in_handle)) {
 		mhi_dev_net_log(MHI_INFO, "%s stop network xmmit\n", __func__);
@@ -181,8 +192,11 @@ static void mhi_dev_net_process_queue_packets(struct work_struct *work)
 		wreq->chan = client->in_chan;
 		wreq->mode = IPA_DMA_ASYNC;
 		if (skb_queue_empty(&client->tx_buffers) ||
-				list_empty(&client->wr_req_buffers)) {
+				list_empty(&client->wr_req_buffers) ||
+				(mhi_net_cmpl_budget &&
+				++burst >= mhi_net_cmpl_budget)) {
 			wreq->snd_cmpl = 1;
+			burst = 0;
 		} else
 			wreq->snd_cmpl = 0;
 		spin_unlock_irqrestore(&client->wrt_lock, flags);
@@ -275,6 +289,7 @@ static ssize_t mhi_dev_net_client_read(struct mhi_dev_net_client *mhi_handle)
 	struct mhi_req *req;
 	struct sk_buff *skb;
 	unsigned long   flags;
+	unsigned int burst = 0;
 
 	client_handle = mhi_handle->out_handle;
 	chan = mhi_handle->out_chan;
@@ -307,6 +322,16 @@ static ssize_t mhi_dev_net_client_read(struct mhi_dev_net_client *mhi_handle)
 		req->len = MHI_NET_DEFAULT_MTU;
 		req->context = skb;
 		req->mode = IPA_DMA_ASYNC;
+		/*
+		 * Requests are recycled and the core sets snd_cmpl whenever it
+		 * flushes, so it has to be re-armed for every read or each
+		 * completion ends up flushed on its own.
+		 */
+		req->snd_cmpl = 0;
+		if (mhi_net_cmpl_budget && ++burst >= mhi_net_cmpl_budget) {
+			req->snd_cmpl = 1;
+			burst = 0;
+		}
 		bytes_avail = mhi_dev_read_channel(req);
 
 		if (bytes_avail < 0) {
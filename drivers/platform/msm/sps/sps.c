@@ -1698,6 +1698,54 @@ int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr, u32 size,
 }
 EXPORT_SYMBOL(sps_transfer_one);
 
+/**
+ * Perform a set of independent DMA transfers on an SPS connection end point
+ *
+ */
+int sps_transfer_bulk(struct sps_pipe *h, struct sps_transfer_desc *desc,
+		      u32 num)
+{
+	struct sps_pipe *pipe = h;
+	struct sps_bam *bam;
+	int result;
+	u32 i;
+
+	if (h == NULL) {
+		SPS_ERR(sps, "sps:%s:pipe is NULL.\n", __func__);
+		return SPS_ERROR;
+	} else if (desc == NULL) {
+		SPS_ERR(sps, "sps:%s:desc list is NULL.\n", __func__);
+		return SPS_ERROR;
+	} else if (num == 0) {
+		SPS_ERR(sps, "sps:%s:desc list is empty.\n", __func__);
+		return SPS_ERROR;
+	}
+
+	for (i = 0; i < num; i++) {
+		if (desc[i].size > SPS_IOVEC_MAX_SIZE) {
+			SPS_ERR(sps,
+				"sps:%s:desc size is invalid.\n", __func__);
+			return SPS_ERROR;
+		}
+
+		if (sps_check_iovec_flags(desc[i].flags))
+			return SPS_ERROR;
+	}
+
+	bam = sps_bam_lock(pipe);
+	if (bam == NULL)
+		return SPS_ERROR;
+
+	SPS_DBG(bam, "sps:%s: %d descriptors.\n", __func__, num);
+
+	result = sps_bam_pipe_transfer_bulk(bam, pipe->pipe_index, desc, num);
+
+	sps_bam_unlock(bam);
+
+	return result;
+}
+EXPORT_SYMBOL(sps_transfer_bulk);
+
 /**
  * Read event queue for an SPS connection end point
  *
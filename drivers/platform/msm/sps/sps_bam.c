@@ -1611,6 +1611,52 @@ int sps_bam_pipe_transfer(struct sps_bam *dev,
 	return 0;
 }
 
+/**
+ * Submit a set of independent buffers to a BAM pipe
+ *
+ */
+int sps_bam_pipe_transfer_bulk(struct sps_bam *dev, u32 pipe_index,
+			       struct sps_transfer_desc *desc, u32 num)
+{
+	struct sps_pipe *pipe = dev->pipes[pipe_index];
+	u32 count;
+	u32 flags;
+	u32 n;
+	int result;
+
+	if (!pipe->sys.ack_xfers && pipe->polled) {
+		sps_bam_pipe_get_unused_desc_num(dev, pipe_index,
+					&count);
+		count = pipe->desc_size / sizeof(struct sps_iovec) - count - 1;
+	} else
+		sps_bam_get_free_count(dev, pipe_index, &count);
+
+	if (count < num) {
+		SPS_DBG1(dev,
+			"sps:Insufficient free desc for bulk: BAM %pa pipe %d: %d < %d\n",
+			BAM_ID(dev), pipe_index, count, num);
+		return SPS_ERROR;
+	}
+
+	/*
+	 * Every buffer keeps its own user pointer and completion, only the
+	 * write offset update is deferred to the last descriptor.
+	 */
+	for (n = 0; n < num; n++, desc++) {
+		flags = DESC_FLAG_WORD(desc->flags, desc->addr);
+		if (n < num - 1)
+			flags |= SPS_IOVEC_FLAG_NO_SUBMIT;
+
+		result = sps_bam_pipe_transfer_one(dev, pipe_index,
+					SPS_GET_LOWER_ADDR(desc->addr),
+					desc->size, desc->user, flags);
+		if (result)
+			return SPS_ERROR;
+	}
+
+	return 0;
+}
+
 int sps_bam_pipe_inject_zlt(struct sps_bam *dev, u32 pipe_index)
 {
 	struct sps_pipe *pipe = dev->pipes[pipe_index];
@@ -461,6 +461,27 @@ int sps_bam_pipe_transfer_one(struct sps_bam *dev, u32 pipe_index, u32 addr,
 int sps_bam_pipe_transfer(struct sps_bam *dev, u32 pipe_index,
 			 struct sps_transfer *transfer);
 
+/**
+ * Submit a set of independent buffers to a BAM pipe
+ *
+ * This function queues several buffers, each with its own user pointer,
+ * and updates the pipe write offset once after the last one. Either all
+ * of the buffers are queued or none.
+ *
+ * @dev - pointer to BAM device descriptor
+ *
+ * @pipe_index - pipe index
+ *
+ * @desc - array of buffers to queue
+ *
+ * @num - number of entries in desc
+ *
+ * @return 0 on success, negative value on error
+ *
+ */
+int sps_bam_pipe_transfer_bulk(struct sps_bam *dev, u32 pipe_index,
+			       struct sps_transfer_desc *desc, u32 num);
+
 /**
  * Get a BAM pipe event
  *
@@ -20,6 +20,7 @@
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/jhash.h>
 #include <linux/kernel.h>
 #include <linux/ktime.h>
 #include <linux/list.h>
@@ -302,6 +303,16 @@
 #define SAW_REG_AVS_CTL				0x904
 #define SAW_REG_AVS_LIMIT			0x908
 
+/*
+ * Learned voltage region layout: a header followed by the last settled
+ * closed-loop voltage in microvolts of every corner of every regulator.
+ */
+#define CPR3_LEARNED_VOLT_MAGIC			0x4C525043
+#define CPR3_LEARNED_VOLT_MAGIC_OFFSET		0x0
+#define CPR3_LEARNED_VOLT_SIG_OFFSET		0x4
+#define CPR3_LEARNED_VOLT_COUNT_OFFSET		0x8
+#define CPR3_LEARNED_VOLT_OFFSET(index)		(0xC + 0x4 * (index))
+
 /*
  * The amount of time to wait for the CPR controller to become idle when
  * performing an aging measurement.
@@ -1924,6 +1935,28 @@ static void cpr3_update_vreg_closed_loop_volt(struct cpr3_regulator *vreg,
 		   reg_last_measurement);
 }
 
+/**
+ * cpr3_regulator_learned_volt_save() - store the settled closed-loop voltage
+ *		of the last closed-loop corner of a CPR3 regulator
+ * @vreg:		Pointer to the CPR3 regulator
+ *
+ * The voltage is written straight to the learned voltage region so that it
+ * survives any kind of reset.
+ *
+ * Return: none
+ */
+static void cpr3_regulator_learned_volt_save(struct cpr3_regulator *vreg)
+{
+	struct cpr3_controller *ctrl = vreg->thread->ctrl;
+	int i = vreg->last_closed_loop_corner;
+
+	if (!ctrl->learned_volt_base || i == CPR3_REGULATOR_CORNER_INVALID)
+		return;
+
+	writel_relaxed(vreg->corner[i].last_volt, ctrl->learned_volt_base
+		+ CPR3_LEARNED_VOLT_OFFSET(vreg->learned_volt_index + i));
+}
+
 /**
  * cpr3_regulator_config_ldo_retention() - configure per-regulator LDO retention
  *		mode
@@ -3376,9 +3409,11 @@ static int _cpr3_regulator_update_ctrl_state(struct cpr3_controller *ctrl)
 		for (j = 0; j < thread->vreg_count; j++) {
 			vreg = &thread->vreg[j];
 
-			if (ctrl->cpr_enabled && ctrl->use_hw_closed_loop)
+			if (ctrl->cpr_enabled && ctrl->use_hw_closed_loop) {
 				cpr3_update_vreg_closed_loop_volt(vreg,
 						vdd_volt, reg_last_measurement);
+				cpr3_regulator_learned_volt_save(vreg);
+			}
 
 			if (!vreg->vreg_enabled
 			    || vreg->current_corner
@@ -4967,6 +5002,7 @@ static irqreturn_t cpr3_irq_handler(int irq, void *data)
 				vreg = &ctrl->thread[i].vreg[j];
 				cpr3_update_vreg_closed_loop_volt(vreg,
 					new_volt, reg_last_measurement);
+				cpr3_regulator_learned_volt_save(vreg);
 			}
 		}
 	}
@@ -6446,6 +6482,113 @@ static int cpr3_panic_callback(struct notifier_block *nfb,
 	return NOTIFY_OK;
 }
 
+/**
+ * cpr3_regulator_init_learned_volt() - map the learned voltage region and
+ *		restore the closed-loop voltages saved by a previous boot
+ * @pdev:		Platform device pointer for the CPR3 controller
+ * @ctrl:		Pointer to the CPR3 controller
+ *
+ * The optional "cpr_learned_volt" memory region, typically IMEM which is
+ * retained across warm resets, holds the last settled closed-loop voltage of
+ * every corner.  Saved voltages are only used if the region was written for
+ * the same fused and configured corner voltage limits.  They can only lower
+ * the initial closed-loop voltage of a corner, down to its floor voltage, so
+ * that CPR starts close to the converged voltage instead of the open-loop
+ * voltage.  CPR keeps raising the voltage from there as required.
+ *
+ * CPRh controllers manage the closed-loop voltage without software, so there
+ * is nothing to learn for them.
+ *
+ * Return: none
+ */
+static void cpr3_regulator_init_learned_volt(struct platform_device *pdev,
+		struct cpr3_controller *ctrl)
+{
+	struct cpr3_regulator *vreg;
+	struct cpr3_corner *corner;
+	struct resource *res;
+	void __iomem *base;
+	u32 sig = 0;
+	int i, j, k, volt, count = 0, restored = 0;
+	bool valid;
+
+	if (ctrl->ctrl_type == CPR_CTRL_TYPE_CPRH)
+		return;
+
+	res = platform_get_resource_byname(pdev, IORESOURCE_MEM,
+					   "cpr_learned_volt");
+	if (!res || !res->start)
+		return;
+
+	for (i = 0; i < ctrl->thread_count; i++) {
+		for (j = 0; j < ctrl->thread[i].vreg_count; j++) {
+			vreg = &ctrl->thread[i].vreg[j];
+			vreg->learned_volt_index = count;
+			count += vreg->corner_count;
+			sig = jhash_2words(vreg->fuse_combo, vreg->corner_count,
+					   sig);
+			for (k = 0; k < vreg->corner_count; k++) {
+				corner = &vreg->corner[k];
+				sig = jhash_3words(corner->floor_volt,
+						   corner->ceiling_volt,
+						   corner->open_loop_volt, sig);
+			}
+		}
+	}
+
+	if (CPR3_LEARNED_VOLT_OFFSET(count) > resource_size(res)) {
+		cpr3_err(ctrl, "learned voltage region too small for %d corners\n",
+			 count);
+		return;
+	}
+
+	base = devm_ioremap(&pdev->dev, res->start, resource_size(res));
+	if (!base) {
+		cpr3_err(ctrl, "could not map learned voltage region\n");
+		return;
+	}
+
+	valid = readl_relaxed(base + CPR3_LEARNED_VOLT_MAGIC_OFFSET)
+			== CPR3_LEARNED_VOLT_MAGIC
+		&& readl_relaxed(base + CPR3_LEARNED_VOLT_SIG_OFFSET) == sig
+		&& readl_relaxed(base + CPR3_LEARNED_VOLT_COUNT_OFFSET)
+			== count;
+
+	for (i = 0; i < ctrl->thread_count; i++) {
+		for (j = 0; j < ctrl->thread[i].vreg_count; j++) {
+			vreg = &ctrl->thread[i].vreg[j];
+			for (k = 0; k < vreg->corner_count; k++) {
+				corner = &vreg->corner[k];
+				volt = readl_relaxed(base +
+				    CPR3_LEARNED_VOLT_OFFSET(
+					vreg->learned_volt_index + k));
+				if (valid && volt >= corner->floor_volt
+				    && volt < corner->last_volt) {
+					corner->last_volt = volt;
+					restored++;
+				} else if (!valid) {
+					writel_relaxed(corner->last_volt, base
+					    + CPR3_LEARNED_VOLT_OFFSET(
+						vreg->learned_volt_index + k));
+				}
+			}
+		}
+	}
+
+	if (!valid) {
+		writel_relaxed(sig, base + CPR3_LEARNED_VOLT_SIG_OFFSET);
+		writel_relaxed(count, base + CPR3_LEARNED_VOLT_COUNT_OFFSET);
+		/* Only mark the region valid once it is fully initialized. */
+		wmb();
+		writel_relaxed(CPR3_LEARNED_VOLT_MAGIC,
+			       base + CPR3_LEARNED_VOLT_MAGIC_OFFSET);
+	}
+
+	ctrl->learned_volt_base = base;
+	cpr3_info(ctrl, "restored %d of %d learned corner voltages\n",
+		  restored, count);
+}
+
 /**
  * cpr3_regulator_register() - register the regulators for a CPR3 controller and
  *		perform CPR hardware initialization
@@ -6549,6 +6692,8 @@ int cpr3_regulator_register(struct platform_device *pdev,
 		}
 	}
 
+	cpr3_regulator_init_learned_volt(pdev, ctrl);
+
 	/*
 	 * Add the maximum possible aging voltage margin until it is possible
 	 * to perform an aging measurement.
@@ -287,6 +287,8 @@ enum cpr3_ldo_type {
  *			CPR closed-loop mode or less than 0 if no corner has
  *			been requested.  CPR registers are only written to when
  *			using closed-loop mode.
+ * @learned_volt_index:	Index of the first corner of this CPR3 regulator in
+ *			the learned voltage array of the controller
  * @aggregated:		Boolean flag indicating that this CPR3 regulator
  *			participated in the last aggregation event
  * @debug_corner:	Index identifying voltage corner used for displaying
@@ -373,6 +375,7 @@ struct cpr3_regulator {
 
 	int			current_corner;
 	int			last_closed_loop_corner;
+	int			learned_volt_index;
 	bool			aggregated;
 	int			debug_corner;
 	enum cpr3_ldo_type	ldo_type;
@@ -556,6 +559,9 @@ struct cpr3_panic_regs_info {
  * @aging_possible_reg:	Virtual address of an optional platform-specific
  *			register that must be ready to determine if it is
  *			possible to perform an aging measurement.
+ * @learned_volt_base:	Virtual address of an optional memory region retained
+ *			across resets which stores the last settled closed-loop
+ *			voltage of every corner
  * @list:		list head used in a global cpr3-regulator list so that
  *			cpr3-regulator structs can be found easily in RAM dumps
  * @thread:		Array of CPR3 threads managed by the CPR3 controller
@@ -793,6 +799,7 @@ struct cpr3_controller {
 	void __iomem		*fuse_base;
 	void __iomem		*saw_base;
 	void __iomem		*aging_possible_reg;
+	void __iomem		*learned_volt_base;
 	struct list_head	list;
 	struct cpr3_thread	*thread;
 	int			thread_count;
@@ -795,6 +795,12 @@ static int ufshcd_init_statistics(struct ufs_hba *hba)
 
 	memset(stats->err_stats, 0, sizeof(hba->ufs_stats.err_stats));
 
+	/* latency histograms are optional, don't fail the rest on them */
+	stats->lat_hist = alloc_percpu(struct ufshcd_lat_hist);
+	if (!stats->lat_hist)
+		dev_warn(hba->dev, "%s: Unable to allocate latency histograms",
+			__func__);
+
 	goto exit;
 
 no_mem:
@@ -1448,6 +1454,130 @@ static const struct file_operations ufsdbg_req_stats_desc = {
 	.release	= single_release,
 };
 
+static const char * const ufsdbg_lat_op_names[UFS_LAT_OP_MAX] = {
+	"read", "write", "unmap", "sync", "other",
+};
+
+static const char * const ufsdbg_lat_size_names[UFS_LAT_SIZE_BUCKETS] = {
+	"<=4K", "<=16K", "<=64K", "<=256K", ">256K",
+};
+
+static const char * const ufsdbg_lat_qd_names[UFS_LAT_QD_BUCKETS] = {
+	"1", "2-4", "5-8", "9-16", "17+",
+};
+
+static const char * const ufsdbg_pm_wait_names[UFS_PM_WAIT_MAX] = {
+	"ungate", "h8_exit",
+};
+
+static void ufsdbg_lat_hist_row(struct seq_file *file, const char *name,
+		u32 *b)
+{
+	int i;
+	u64 total = 0;
+
+	for (i = 0; i < UFS_LAT_BUCKETS; i++)
+		total += b[i];
+	if (!total)
+		return;
+
+	seq_printf(file, "%-22s", name);
+	for (i = 0; i < UFS_LAT_BUCKETS; i++)
+		seq_printf(file, " %8u", b[i]);
+	seq_puts(file, "\n");
+}
+
+static ssize_t ufsdbg_lat_hist_write(struct file *filp,
+		const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	struct ufs_hba *hba = filp->f_mapping->host->i_private;
+	int val;
+	int ret;
+	int cpu;
+
+	ret = kstrtoint_from_user(ubuf, cnt, 0, &val);
+	if (ret) {
+		dev_err(hba->dev, "%s: Invalid argument\n", __func__);
+		return ret;
+	}
+
+	if (!hba->ufs_stats.lat_hist)
+		return -ENODEV;
+
+	/* an increment racing with the reset may be lost, that's fine */
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(hba->ufs_stats.lat_hist, cpu), 0,
+			sizeof(struct ufshcd_lat_hist));
+
+	return cnt;
+}
+
+static int ufsdbg_lat_hist_show(struct seq_file *file, void *data)
+{
+	struct ufs_hba *hba = (struct ufs_hba *)file->private;
+	struct ufshcd_lat_hist *sum, *h;
+	char name[32];
+	int op, sz, qd, i, cpu;
+
+	if (!hba->ufs_stats.lat_hist)
+		return -ENODEV;
+
+	sum = kzalloc(sizeof(*sum), GFP_KERNEL);
+	if (!sum)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		h = per_cpu_ptr(hba->ufs_stats.lat_hist, cpu);
+		for (op = 0; op < UFS_LAT_OP_MAX; op++)
+			for (sz = 0; sz < UFS_LAT_SIZE_BUCKETS; sz++)
+				for (qd = 0; qd < UFS_LAT_QD_BUCKETS; qd++)
+					for (i = 0; i < UFS_LAT_BUCKETS; i++)
+						sum->req[op][sz][qd][i] +=
+							h->req[op][sz][qd][i];
+		for (op = 0; op < UFS_PM_WAIT_MAX; op++)
+			for (i = 0; i < UFS_LAT_BUCKETS; i++)
+				sum->pm_wait[op][i] += h->pm_wait[op][i];
+	}
+
+	/* Header: lower bound of each bucket in usec */
+	seq_printf(file, "%-22s %8s", "op/size/qd (us)", "0");
+	for (i = 1; i < UFS_LAT_BUCKETS; i++)
+		seq_printf(file, " %8u", 1U << (i + 3));
+	seq_puts(file, "\n");
+
+	for (op = 0; op < UFS_LAT_OP_MAX; op++)
+		for (sz = 0; sz < UFS_LAT_SIZE_BUCKETS; sz++)
+			for (qd = 0; qd < UFS_LAT_QD_BUCKETS; qd++) {
+				snprintf(name, sizeof(name), "%s/%s/%s",
+					ufsdbg_lat_op_names[op],
+					ufsdbg_lat_size_names[sz],
+					ufsdbg_lat_qd_names[qd]);
+				ufsdbg_lat_hist_row(file, name,
+					sum->req[op][sz][qd]);
+			}
+
+	for (op = 0; op < UFS_PM_WAIT_MAX; op++) {
+		snprintf(name, sizeof(name), "wait/%s",
+			ufsdbg_pm_wait_names[op]);
+		ufsdbg_lat_hist_row(file, name, sum->pm_wait[op]);
+	}
+
+	kfree(sum);
+	return 0;
+}
+
+static int ufsdbg_lat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ufsdbg_lat_hist_show, inode->i_private);
+}
+
+static const struct file_operations ufsdbg_lat_hist_desc = {
+	.open		= ufsdbg_lat_hist_open,
+	.read		= seq_read,
+	.write		= ufsdbg_lat_hist_write,
+	.release	= single_release,
+};
+
 
 static int ufsdbg_reset_controller_show(struct seq_file *file, void *data)
 {
@@ -1684,6 +1814,17 @@ void ufsdbg_add_debugfs(struct ufs_hba *hba)
 		goto err;
 	}
 
+	hba->debugfs_files.lat_hist =
+		debugfs_create_file("lat_hist", S_IRUSR | S_IWUSR,
+			hba->debugfs_files.stats_folder, hba,
+			&ufsdbg_lat_hist_desc);
+	if (!hba->debugfs_files.lat_hist) {
+		dev_err(hba->dev,
+			"%s:  failed create lat_hist debugfs entry\n",
+			__func__);
+		goto err;
+	}
+
 	hba->debugfs_files.reset_controller =
 		debugfs_create_file("reset_controller", S_IRUSR | S_IWUSR,
 			hba->debugfs_files.debugfs_root, hba,
@@ -1723,5 +1864,6 @@ void ufsdbg_remove_debugfs(struct ufs_hba *hba)
 	ufshcd_vops_remove_debugfs(hba);
 	debugfs_remove_recursive(hba->debugfs_files.debugfs_root);
 	kfree(hba->ufs_stats.tag_stats);
-
+	free_percpu(hba->ufs_stats.lat_hist);
+	hba->ufs_stats.lat_hist = NULL;
 }
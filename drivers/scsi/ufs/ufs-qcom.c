@@ -1527,6 +1527,9 @@ static void ufs_qcom_set_caps(struct ufs_hba *hba)
 	}
 	hba->caps |= UFSHCD_CAP_AUTO_BKOPS_SUSPEND;
 
+	if (of_property_read_bool(hba->dev->of_node, "qcom,compl-same-cpu"))
+		hba->caps |= UFSHCD_CAP_COMPL_SAME_CPU;
+
 	if (host->hw_ver.major >= 0x2) {
 		if (!host->disable_lpm)
 			hba->caps |= UFSHCD_CAP_POWER_COLLAPSE_DURING_HIBERN8;
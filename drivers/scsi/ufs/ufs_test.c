@@ -62,6 +62,23 @@
 /* translation mask from sectors to block */
 #define SECTOR_TO_BLOCK_MASK 0x7
 
+/* benchmark defaults, all tunable through debugfs */
+#define BENCH_DEFAULT_QD		32
+#define BENCH_DEFAULT_MAX_BIOS		1
+#define BENCH_DEFAULT_READ_PCT		70
+#define BENCH_DEFAULT_NUM_REQS		10000
+#define BENCH_MAX_QD			64
+#define BENCH_WAIT_TIMEOUT		msecs_to_jiffies(1000)
+
+/*
+ * Latencies are kept in log-linear buckets of microseconds: exact below
+ * 8us, then 8 buckets per power of two, i.e. within 12.5% of the value.
+ */
+#define BENCH_LAT_SUB_BITS		3
+#define BENCH_LAT_SUB			(1 << BENCH_LAT_SUB_BITS)
+#define BENCH_LAT_BUCKETS		((32 - BENCH_LAT_SUB_BITS + 1) * \
+					 BENCH_LAT_SUB)
+
 #define TEST_OPS(test_name, upper_case_name)				\
 static int ufs_test_ ## test_name ## _show(struct seq_file *file,	\
 		void *data)						\
@@ -100,6 +117,8 @@ enum ufs_test_testcases {
 	UFS_TEST_PARALLEL_READ_AND_WRITE,
 	UFS_TEST_LUN_DEPTH,
 
+	UFS_TEST_BENCHMARK,
+
 	NUM_TESTS,
 };
 
@@ -117,6 +136,35 @@ enum ufs_test_stage {
 /* device test */
 static struct blk_dev_test_type *ufs_bdt;
 
+struct ufs_test_lat_hist {
+	u32 bucket[BENCH_LAT_BUCKETS];
+	u32 count;
+	u32 max_us;
+	u64 total_us;
+};
+
+/**
+ * struct ufs_test_bench - state and results of one benchmark run
+ * @hba: host the benchmarked LUN belongs to
+ * @issue: insertion time of the outstanding requests, by request id
+ * @hist: latency histograms of reads and writes
+ * @inserted: requests inserted so far
+ * @errors: requests that completed with an error
+ * @scaled_up_reqs: requests that completed with the clocks scaled up
+ * @hibern8_exit_cnt: hibern8 exits at the start of the run
+ * @pwr_mode_chg_cnt: power mode changes (gear scaling) at the start
+ */
+struct ufs_test_bench {
+	struct ufs_hba *hba;
+	ktime_t issue[BENCH_MAX_QD];
+	struct ufs_test_lat_hist hist[2];
+	u32 inserted;
+	u32 errors;
+	u32 scaled_up_reqs;
+	u32 hibern8_exit_cnt;
+	u32 pwr_mode_chg_cnt;
+};
+
 struct ufs_test_data {
 	/* Data structure for debugfs dentrys */
 	struct dentry **test_list;
@@ -152,6 +200,13 @@ struct ufs_test_data {
 	/* total number of requests to be submitted in long test */
 	u32 long_test_num_reqs;
 
+	/* benchmark parameters */
+	u32 bench_qd;
+	u32 bench_max_bios;
+	u32 bench_read_pct;
+	u32 bench_num_reqs;
+	struct ufs_test_bench *bench;
+
 	struct test_iosched *test_iosched;
 };
 
@@ -255,6 +310,8 @@ static char *ufs_test_get_test_case_str(int testcase)
 		return "UFS parallel read and write test";
 	case UFS_TEST_LUN_DEPTH:
 		return "UFS LUN depth test";
+	case UFS_TEST_BENCHMARK:
+		return "UFS benchmark";
 	}
 	return "Unknown test";
 }
@@ -442,6 +499,21 @@ static int ufs_test_show(struct seq_file *file, int test_case)
 		 "The test will test for each iteration once only reads and "
 		 "once only writes.\n";
 		break;
+	case UFS_TEST_BENCHMARK:
+		test_description = "\nufs_test_benchmark\n"
+		 "=========\n"
+		 "Description:\n"
+		 "This test issues bench_num_reqs requests to random LBAs, "
+		 "keeping bench_qd of them outstanding. Each request reads "
+		 "with a probability of bench_read_pct percent and is 1 to "
+		 "bench_max_bios blocks long. The sequence only depends on "
+		 "random_test_seed, so runs with the same parameters are "
+		 "comparable.\n"
+		 "IOPS, throughput and latency percentiles per direction are "
+		 "printed at the end, with the hibern8 exits, power mode "
+		 "changes and share of requests served at scaled up clocks "
+		 "during the run.\n";
+		break;
 	default:
 		test_description = "Unknown test";
 	}
@@ -1187,6 +1259,230 @@ static int long_seq_test_calc_throughput(struct test_iosched *test_iosched)
 	return ufs_test_post(test_iosched);
 }
 
+static unsigned int ufs_test_lat_bucket(u32 us)
+{
+	unsigned int msb;
+
+	if (us < BENCH_LAT_SUB)
+		return us;
+
+	msb = fls(us) - 1;
+	return ((msb - BENCH_LAT_SUB_BITS + 1) << BENCH_LAT_SUB_BITS) +
+		((us >> (msb - BENCH_LAT_SUB_BITS)) & (BENCH_LAT_SUB - 1));
+}
+
+/* the largest latency that falls into a bucket */
+static u32 ufs_test_lat_bucket_max(unsigned int idx)
+{
+	unsigned int shift;
+
+	if (idx < BENCH_LAT_SUB)
+		return idx;
+
+	shift = (idx >> BENCH_LAT_SUB_BITS) - 1;
+	return (((idx & (BENCH_LAT_SUB - 1)) + BENCH_LAT_SUB + 1) << shift) - 1;
+}
+
+/* @q: the percentile in thousandths of a percent, 99900 for p99.9 */
+static u32 ufs_test_lat_percentile(struct ufs_test_lat_hist *h, u32 q)
+{
+	u64 target, seen = 0;
+	unsigned int i;
+
+	if (!h->count)
+		return 0;
+
+	target = div_u64((u64)h->count * q + 99999, 100000);
+	for (i = 0; i < BENCH_LAT_BUCKETS; i++) {
+		seen += h->bucket[i];
+		if (seen >= target)
+			return min(ufs_test_lat_bucket_max(i), h->max_us);
+	}
+
+	return h->max_us;
+}
+
+static void bench_end_io_fn(struct request *rq, int err)
+{
+	struct test_request *test_rq;
+	struct test_iosched *test_iosched = rq->q->elevator->elevator_data;
+	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
+	struct ufs_test_bench *bench = utd->bench;
+	struct ufs_test_lat_hist *h;
+	unsigned long flags;
+	u32 us;
+
+	test_rq = (struct test_request *)rq->elv.priv[0];
+	BUG_ON(!test_rq);
+
+	us = min_t(s64, ktime_us_delta(ktime_get(),
+		bench->issue[test_rq->req_id % BENCH_MAX_QD]), U32_MAX);
+	h = &bench->hist[rq_data_dir(rq) == WRITE];
+
+	spin_lock_irqsave(&test_iosched->lock, flags);
+	test_iosched->dispatched_count--;
+	list_del_init(&test_rq->queuelist);
+	__blk_put_request(test_iosched->req_q, test_rq->rq);
+
+	h->bucket[ufs_test_lat_bucket(us)]++;
+	h->count++;
+	h->total_us += us;
+	if (us > h->max_us)
+		h->max_us = us;
+	if (bench->hba->clk_scaling.is_scaled_up)
+		bench->scaled_up_reqs++;
+	if (err) {
+		bench->errors++;
+		utd->test_stage = UFS_TEST_ERROR;
+	}
+	utd->completed_req_count++;
+	spin_unlock_irqrestore(&test_iosched->lock, flags);
+
+	if (err)
+		pr_err("%s: request %d completed, err=%d", __func__,
+			test_rq->req_id, err);
+
+	test_iosched_free_test_req_data_buffer(test_rq);
+	kfree(test_rq);
+
+	wake_up(&utd->wait_q);
+	check_test_completion(test_iosched);
+}
+
+static bool bench_check_completion(struct test_iosched *test_iosched)
+{
+	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
+
+	return utd->completed_req_count >= utd->bench->inserted &&
+		(utd->bench->inserted == utd->bench_num_reqs ||
+		 utd->test_stage == UFS_TEST_ERROR);
+}
+
+static bool bench_can_insert(struct ufs_test_data *utd)
+{
+	return utd->bench->inserted - READ_ONCE(utd->completed_req_count) <
+		utd->bench_qd || utd->test_stage == UFS_TEST_ERROR;
+}
+
+/**
+ * ufs_test_run_benchmark - keep bench_qd random requests outstanding
+ * @test_iosched - test specific data
+ *
+ * The direction, LBA and size of every request come from a private copy
+ * of random_test_seed, the latency of a request is measured from its
+ * insertion to its completion.
+ */
+static int ufs_test_run_benchmark(struct test_iosched *test_iosched)
+{
+	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
+	struct ufs_test_bench *bench = utd->bench;
+	struct scsi_device *sdev = test_iosched->req_q->queuedata;
+	u32 seed, sector, max_sec, num_bios, sectors;
+	int direction, ret = 0;
+
+	memset(bench, 0, sizeof(*bench));
+	bench->hba = shost_priv(sdev->host);
+	bench->hibern8_exit_cnt = bench->hba->ufs_stats.hibern8_exit_cnt;
+	bench->pwr_mode_chg_cnt = bench->hba->ufs_stats.power_mode_change_cnt;
+	utd->completed_req_count = 0;
+
+	utd->bench_qd = clamp_t(u32, utd->bench_qd, 1, BENCH_MAX_QD);
+	utd->bench_max_bios = clamp_t(u32, utd->bench_max_bios, 1,
+				      TEST_MAX_BIOS_PER_REQ);
+	utd->bench_read_pct = min_t(u32, utd->bench_read_pct, 100);
+	if (!utd->bench_num_reqs)
+		utd->bench_num_reqs = BENCH_DEFAULT_NUM_REQS;
+
+	utd->sector_range = test_iosched->sector_range ?
+		test_iosched->sector_range : TEST_DEFAULT_SECTOR_RANGE;
+	max_sec = test_iosched->start_sector + utd->sector_range;
+	seed = utd->random_test_seed ? utd->random_test_seed : MAGIC_SEED;
+
+	pr_info("%s: %u requests, qd %u, 1-%u blocks, %u%% reads, seed %u",
+		__func__, utd->bench_num_reqs, utd->bench_qd,
+		utd->bench_max_bios, utd->bench_read_pct, seed);
+
+	while (bench->inserted < utd->bench_num_reqs) {
+		if (!bench_can_insert(utd)) {
+			/* have the queue dispatch what is already inserted */
+			blk_post_runtime_resume(test_iosched->req_q, 0);
+			wait_event_timeout(utd->wait_q, bench_can_insert(utd),
+					   BENCH_WAIT_TIMEOUT);
+			continue;
+		}
+		if (utd->test_stage == UFS_TEST_ERROR)
+			break;
+
+		direction = ufs_test_pseudo_random_seed(&seed, 0, 100) <
+			utd->bench_read_pct ? READ : WRITE;
+		num_bios = ufs_test_pseudo_random_seed(&seed, 1,
+					utd->bench_max_bios + 1);
+		sectors = num_bios * (TEST_BIO_SIZE / SECTOR_SIZE);
+		sector = ufs_test_pseudo_random_seed(&seed,
+				test_iosched->start_sector, max_sec - sectors);
+		sector &= ~SECTOR_TO_BLOCK_MASK;
+
+		bench->issue[test_iosched->wr_rd_next_req_id % BENCH_MAX_QD] =
+			ktime_get();
+		ret = test_iosched_add_wr_rd_test_req(test_iosched, 0,
+			direction, sector, num_bios, TEST_PATTERN_5A,
+			bench_end_io_fn);
+		if (ret) {
+			pr_err("%s: failed to create request", __func__);
+			break;
+		}
+		bench->inserted++;
+	}
+
+	blk_post_runtime_resume(test_iosched->req_q, 0);
+
+	return ret;
+}
+
+static void ufs_test_bench_report_dir(struct ufs_test_lat_hist *h,
+				      const char *dir, unsigned long mtime)
+{
+	if (!h->count)
+		return;
+
+	pr_info("%s: %u IOPS, lat avg %llu p50 %u p99 %u p99.9 %u max %u usec",
+		dir, (u32)div_u64((u64)h->count * 1000, mtime),
+		div_u64(h->total_us, h->count),
+		ufs_test_lat_percentile(h, 50000),
+		ufs_test_lat_percentile(h, 99000),
+		ufs_test_lat_percentile(h, 99900), h->max_us);
+}
+
+static int ufs_test_bench_report(struct test_iosched *test_iosched)
+{
+	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
+	struct ufs_test_bench *bench = utd->bench;
+	struct ufs_hba *hba = bench->hba;
+	unsigned long mtime, byte_count;
+
+	mtime = max_t(unsigned long,
+		      ktime_to_ms(utd->test_info.test_duration), 1);
+	byte_count = utd->test_info.test_byte_count;
+
+	pr_info("%s: %u requests in %lu msec, %lu.%lu MiB, %lu KiB/sec",
+		__func__, utd->completed_req_count, mtime,
+		LONG_TEST_SIZE_INTEGER(byte_count),
+		LONG_TEST_SIZE_FRACTION(byte_count),
+		(unsigned long)div_u64((u64)byte_count * 1000, mtime * 1024));
+	ufs_test_bench_report_dir(&bench->hist[0], "read", mtime);
+	ufs_test_bench_report_dir(&bench->hist[1], "write", mtime);
+	pr_info("%s: hibern8 exits %u, power mode changes %u, errors %u",
+		__func__,
+		hba->ufs_stats.hibern8_exit_cnt - bench->hibern8_exit_cnt,
+		hba->ufs_stats.power_mode_change_cnt - bench->pwr_mode_chg_cnt,
+		bench->errors);
+	pr_info("%s: %u%% of requests completed at scaled up clocks",
+		__func__, utd->completed_req_count ? bench->scaled_up_reqs *
+			100 / utd->completed_req_count : 0);
+
+	return ufs_test_post(test_iosched);
+}
+
 static bool ufs_data_integrity_completion(struct test_iosched *test_iosched)
 {
 	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
@@ -1356,6 +1652,12 @@ static ssize_t ufs_test_write(struct file *file, const char __user *buf,
 	case UFS_TEST_LUN_DEPTH:
 		utd->test_info.run_test_fn = ufs_test_run_lun_depth_test;
 		break;
+	case UFS_TEST_BENCHMARK:
+		utd->test_info.run_test_fn = ufs_test_run_benchmark;
+		utd->test_info.post_test_fn = ufs_test_bench_report;
+		utd->test_info.check_test_completion_fn =
+			bench_check_completion;
+		break;
 	default:
 		pr_err("%s: Unknown test-case: %d", __func__, test_case);
 		WARN_ON(true);
@@ -1393,6 +1695,7 @@ TEST_OPS(long_sequential_write, LONG_SEQUENTIAL_WRITE);
 TEST_OPS(long_sequential_mixed, LONG_SEQUENTIAL_MIXED);
 TEST_OPS(parallel_read_and_write, PARALLEL_READ_AND_WRITE);
 TEST_OPS(lun_depth, LUN_DEPTH);
+TEST_OPS(benchmark, BENCHMARK);
 
 static void ufs_test_debugfs_cleanup(struct test_iosched *test_iosched)
 {
@@ -1433,6 +1736,20 @@ static int ufs_test_debugfs_init(struct ufs_test_data *utd)
 		goto exit_err;
 	}
 
+	if (!debugfs_create_u32("bench_qd", S_IRUGO | S_IWUGO, utils_root,
+				&utd->bench_qd) ||
+	    !debugfs_create_u32("bench_max_bios", S_IRUGO | S_IWUGO,
+				utils_root, &utd->bench_max_bios) ||
+	    !debugfs_create_u32("bench_read_pct", S_IRUGO | S_IWUGO,
+				utils_root, &utd->bench_read_pct) ||
+	    !debugfs_create_u32("bench_num_reqs", S_IRUGO | S_IWUGO,
+				utils_root, &utd->bench_num_reqs)) {
+		pr_err("%s: Could not create debugfs benchmark parameters.",
+				__func__);
+		ret = -ENOMEM;
+		goto exit_err;
+	}
+
 	ret = add_test(utd, write_read_test, WRITE_READ_TEST);
 	if (ret)
 		goto exit_err;
@@ -1461,6 +1778,9 @@ static int ufs_test_debugfs_init(struct ufs_test_data *utd)
 	if (ret)
 		goto exit_err;
 	add_test(utd, lun_depth, LUN_DEPTH);
+	if (ret)
+		goto exit_err;
+	ret = add_test(utd, benchmark, BENCHMARK);
 	if (ret)
 		goto exit_err;
 
@@ -1483,14 +1803,26 @@ static int ufs_test_probe(struct test_iosched *test_iosched)
 		return -ENOMEM;
 	}
 
+	utd->bench = kzalloc(sizeof(*utd->bench), GFP_KERNEL);
+	if (!utd->bench) {
+		pr_err("%s: failed to allocate benchmark data\n", __func__);
+		kfree(utd);
+		return -ENOMEM;
+	}
+
 	init_waitqueue_head(&utd->wait_q);
 	utd->test_iosched = test_iosched;
+	utd->bench_qd = BENCH_DEFAULT_QD;
+	utd->bench_max_bios = BENCH_DEFAULT_MAX_BIOS;
+	utd->bench_read_pct = BENCH_DEFAULT_READ_PCT;
+	utd->bench_num_reqs = BENCH_DEFAULT_NUM_REQS;
 	test_iosched->blk_dev_test_data = utd;
 
 	ret = ufs_test_debugfs_init(utd);
 	if (ret) {
 		pr_err("%s: failed to init debug-fs entries, ret=%d\n",
 			__func__, ret);
+		kfree(utd->bench);
 		kfree(utd);
 	}
 
@@ -1503,6 +1835,7 @@ static void ufs_test_remove(struct test_iosched *test_iosched)
 
 	ufs_test_debugfs_cleanup(test_iosched);
 	test_iosched->blk_dev_test_data = NULL;
+	kfree(utd->bench);
 	kfree(utd);
 }
 
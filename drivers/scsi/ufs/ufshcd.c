@@ -44,6 +44,7 @@
 #include <linux/nls.h>
 #include <linux/of.h>
 #include <linux/blkdev.h>
+#include <linux/sizes.h>
 #include <linux/hwinfo.h>
 #include "ufshcd.h"
 #include "ufshci.h"
@@ -109,6 +110,98 @@ static void ufshcd_update_tag_stats_completion(struct ufs_hba *hba,
 		hba->ufs_stats.q_depth--;
 }
 
+static inline int ufshcd_lat_bucket(s64 us)
+{
+	if (us < 16)
+		return 0;
+	return min_t(int, ilog2((u64)us) - 3, UFS_LAT_BUCKETS - 1);
+}
+
+static int ufshcd_lat_op(struct scsi_cmnd *cmd)
+{
+	switch (cmd->cmnd[0]) {
+	case READ_6:
+	case READ_10:
+	case READ_16:
+		return UFS_LAT_OP_READ;
+	case WRITE_6:
+	case WRITE_10:
+	case WRITE_16:
+		return UFS_LAT_OP_WRITE;
+	case UNMAP:
+		return UFS_LAT_OP_UNMAP;
+	case SYNCHRONIZE_CACHE:
+		return UFS_LAT_OP_SYNC;
+	default:
+		return UFS_LAT_OP_OTHER;
+	}
+}
+
+static inline int ufshcd_lat_size_bucket(unsigned int len)
+{
+	if (len <= SZ_4K)
+		return 0;
+	if (len <= SZ_16K)
+		return 1;
+	if (len <= SZ_64K)
+		return 2;
+	if (len <= SZ_256K)
+		return 3;
+	return 4;
+}
+
+static inline int ufshcd_lat_qd_bucket(unsigned int qd)
+{
+	if (qd <= 1)
+		return 0;
+	if (qd <= 4)
+		return 1;
+	if (qd <= 8)
+		return 2;
+	if (qd <= 16)
+		return 3;
+	return 4;
+}
+
+/* called from the completion path; per-cpu counters need no locking */
+static void ufshcd_update_lat_hist(struct ufs_hba *hba,
+		struct ufshcd_lrb *lrbp, s64 delta)
+{
+	struct ufshcd_lat_hist __percpu *h = hba->ufs_stats.lat_hist;
+
+	if (!h || !lrbp->cmd)
+		return;
+
+	this_cpu_inc(h->req[ufshcd_lat_op(lrbp->cmd)]
+		[ufshcd_lat_size_bucket(scsi_bufflen(lrbp->cmd))]
+		[ufshcd_lat_qd_bucket(lrbp->issue_qdepth)]
+		[ufshcd_lat_bucket(delta)]);
+}
+
+/* host lock must be held */
+static inline void ufshcd_pm_wait_start(struct ufs_hba *hba, int type)
+{
+	hba->ufs_stats.pm_wait_start[type] = ktime_get();
+}
+
+static void ufshcd_pm_wait_end(struct ufs_hba *hba, int type)
+{
+	struct ufshcd_lat_hist __percpu *h = hba->ufs_stats.lat_hist;
+	unsigned long flags;
+	s64 delta = -1;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	if (ktime_to_ns(hba->ufs_stats.pm_wait_start[type])) {
+		delta = ktime_us_delta(ktime_get(),
+				hba->ufs_stats.pm_wait_start[type]);
+		hba->ufs_stats.pm_wait_start[type] = ktime_set(0, 0);
+	}
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	if (h && delta >= 0)
+		this_cpu_inc(h->pm_wait[type][ufshcd_lat_bucket(delta)]);
+}
+
 static void update_req_stats(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
 {
 	int rq_type;
@@ -116,6 +209,8 @@ static void update_req_stats(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
 	s64 delta = ktime_us_delta(lrbp->complete_time_stamp,
 		lrbp->issue_time_stamp);
 
+	ufshcd_update_lat_hist(hba, lrbp, delta);
+
 	/* update general request statistics */
 	if (hba->ufs_stats.req_stats[TS_TAG].count == 0)
 		hba->ufs_stats.req_stats[TS_TAG].min = delta;
@@ -167,6 +262,14 @@ void update_req_stats(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
 {
 }
 
+static inline void ufshcd_pm_wait_start(struct ufs_hba *hba, int type)
+{
+}
+
+static inline void ufshcd_pm_wait_end(struct ufs_hba *hba, int type)
+{
+}
+
 static inline
 void ufshcd_update_query_stats(struct ufs_hba *hba,
 			       enum query_opcode opcode, u8 idn)
@@ -1536,9 +1639,143 @@ static void ufshcd_ungate_work(struct work_struct *work)
 		hba->clk_gating.is_suspended = false;
 	}
 unblock_reqs:
+	ufshcd_pm_wait_end(hba, UFS_PM_WAIT_UNGATE);
 	ufshcd_scsi_unblock_requests(hba);
 }
 
+/*
+ * Pick the delay that minimizes, over the recorded idle gaps, the active
+ * time spent waiting for the delay to expire plus the exit cost of every
+ * gap that outlasts it. Candidate delays are the bucket edges.
+ */
+static unsigned long ufshcd_idle_pred_pick(struct ufs_idle_pred *pred)
+{
+	u64 below = 0, cost, best = U64_MAX;
+	u32 total = 0, seen = 0;
+	int i, best_i = 0;
+
+	for (i = 0; i < UFS_IDLE_PRED_BUCKETS; i++)
+		total += pred->hist[i];
+
+	for (i = 0; i < UFS_IDLE_PRED_BUCKETS - 1; i++) {
+		/* gaps in bucket i are, on average, 3/4 of its upper edge */
+		below += (u64)pred->hist[i] * (750 << i);
+		seen += pred->hist[i];
+		cost = below + (u64)(total - seen) *
+			((USEC_PER_MSEC << i) + pred->exit_cost_us);
+		if (cost < best) {
+			best = cost;
+			best_i = i;
+		}
+	}
+
+	return 1UL << best_i;
+}
+
+/* host lock must be held before calling this */
+static void ufshcd_idle_pred_sample(struct ufs_idle_pred *pred)
+{
+	s64 gap_ms;
+	int i;
+
+	if (!ktime_to_ns(pred->idle_start_t))
+		return;
+
+	gap_ms = ktime_ms_delta(ktime_get(), pred->idle_start_t);
+	pred->idle_start_t = ktime_set(0, 0);
+	if (!pred->enabled)
+		return;
+
+	i = gap_ms < 1 ? 0 : min_t(int, ilog2((u64)gap_ms) + 1,
+				  UFS_IDLE_PRED_BUCKETS - 1);
+	pred->hist[i]++;
+
+	if (++pred->samples < UFS_IDLE_PRED_WINDOW)
+		return;
+
+	pred->delay_ms = ufshcd_idle_pred_pick(pred);
+	/* age the history so the delay follows workload changes */
+	for (i = 0; i < UFS_IDLE_PRED_BUCKETS; i++)
+		pred->hist[i] >>= 1;
+	pred->samples = 0;
+}
+
+static ssize_t ufshcd_idle_pred_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_idle_pred *pred = container_of(attr, struct ufs_idle_pred,
+						  attr);
+
+	return snprintf(buf, PAGE_SIZE, "%d %u %lu\n", pred->enabled,
+			pred->exit_cost_us, pred->delay_ms);
+}
+
+/* Takes "<enable> <exit_cost_us>" */
+static ssize_t ufshcd_idle_pred_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_idle_pred *pred = container_of(attr, struct ufs_idle_pred,
+						  attr);
+	unsigned long flags;
+	u32 enable, exit_cost_us;
+
+	if (sscanf(buf, "%u %u", &enable, &exit_cost_us) != 2)
+		return -EINVAL;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	pred->exit_cost_us = exit_cost_us;
+	if (pred->enabled != !!enable) {
+		memset(pred->hist, 0, sizeof(pred->hist));
+		pred->samples = 0;
+	}
+	pred->enabled = !!enable;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
+static void ufshcd_idle_pred_init(struct ufs_hba *hba,
+		struct ufs_idle_pred *pred, const char *name,
+		unsigned long delay_ms, u32 exit_cost_us)
+{
+	pred->delay_ms = delay_ms;
+	pred->exit_cost_us = exit_cost_us;
+
+	pred->attr.show = ufshcd_idle_pred_show;
+	pred->attr.store = ufshcd_idle_pred_store;
+	sysfs_attr_init(&pred->attr.attr);
+	pred->attr.attr.name = name;
+	pred->attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &pred->attr))
+		dev_err(hba->dev, "Failed to create sysfs for %s\n", name);
+}
+
+/* host lock must be held before calling this */
+static unsigned long ufshcd_hibern8_on_idle_delay(struct ufs_hba *hba)
+{
+	struct ufs_hibern8_on_idle *h8 = &hba->hibern8_on_idle;
+
+	return h8->pred.enabled ? h8->pred.delay_ms : h8->delay_ms;
+}
+
+/* host lock must be held before calling this */
+static unsigned long ufshcd_clkgate_delay(struct ufs_hba *hba)
+{
+	struct ufs_clk_gating *gating = &hba->clk_gating;
+
+	if (!gating->pred.enabled)
+		return gating->delay_ms;
+
+	/* gating must still come after hibern8 enter on idle */
+	if (ufshcd_is_hibern8_on_idle_allowed(hba) &&
+	    hba->hibern8_on_idle.is_enabled)
+		return max(gating->pred.delay_ms,
+			   ufshcd_hibern8_on_idle_delay(hba) + 1);
+
+	return gating->pred.delay_ms;
+}
+
 /**
  * ufshcd_hold - Enable clocks that were gated earlier due to ufshcd_release.
  * Also, exit from hibern8 mode and set the link as active.
@@ -1554,6 +1791,7 @@ int ufshcd_hold(struct ufs_hba *hba, bool async)
 		goto out;
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	hba->clk_gating.active_reqs++;
+	ufshcd_idle_pred_sample(&hba->clk_gating.pred);
 
 	if (ufshcd_eh_in_progress(hba)) {
 		spin_unlock_irqrestore(hba->host->host_lock, flags);
@@ -1605,6 +1843,7 @@ start:
 		hba->clk_gating.state = REQ_CLKS_ON;
 		trace_ufshcd_clk_gating(dev_name(hba->dev),
 			hba->clk_gating.state);
+		ufshcd_pm_wait_start(hba, UFS_PM_WAIT_UNGATE);
 		queue_work(hba->clk_gating.clk_gating_workq,
 				&hba->clk_gating.ungate_work);
 		/*
@@ -1736,9 +1975,10 @@ static void __ufshcd_release(struct ufs_hba *hba, bool no_sched)
 	hba->clk_gating.state = REQ_CLKS_OFF;
 	trace_ufshcd_clk_gating(dev_name(hba->dev), hba->clk_gating.state);
 	hba->ufs_stats.clk_rel.ts = ktime_get();
+	hba->clk_gating.pred.idle_start_t = hba->ufs_stats.clk_rel.ts;
 
 	hrtimer_start(&hba->clk_gating.gate_hrtimer,
-			ms_to_ktime(hba->clk_gating.delay_ms),
+			ms_to_ktime(ufshcd_clkgate_delay(hba)),
 			HRTIMER_MODE_REL);
 }
 
@@ -1962,6 +2202,9 @@ add_clkgate_enable:
 	gating->enable_attr.attr.mode = S_IRUGO | S_IWUSR;
 	if (device_create_file(hba->dev, &gating->enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for clkgate_enable\n");
+
+	ufshcd_idle_pred_init(hba, &gating->pred, "clkgate_adaptive",
+			      gating->delay_ms, 5000);
 }
 
 static void ufshcd_exit_clk_gating(struct ufs_hba *hba)
@@ -1976,6 +2219,7 @@ static void ufshcd_exit_clk_gating(struct ufs_hba *hba)
 		device_remove_file(hba->dev, &hba->clk_gating.delay_attr);
 	}
 	device_remove_file(hba->dev, &hba->clk_gating.enable_attr);
+	device_remove_file(hba->dev, &hba->clk_gating.pred.attr);
 	ufshcd_cancel_gate_work(hba);
 	cancel_work_sync(&hba->clk_gating.ungate_work);
 	destroy_workqueue(hba->clk_gating.clk_gating_workq);
@@ -2011,6 +2255,7 @@ static int ufshcd_hibern8_hold(struct ufs_hba *hba, bool async)
 
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	hba->hibern8_on_idle.active_reqs++;
+	ufshcd_idle_pred_sample(&hba->hibern8_on_idle.pred);
 
 	if (ufshcd_eh_in_progress(hba)) {
 		spin_unlock_irqrestore(hba->host->host_lock, flags);
@@ -2038,6 +2283,7 @@ start:
 		hba->hibern8_on_idle.state = REQ_HIBERN8_EXIT;
 		trace_ufshcd_hibern8_on_idle(dev_name(hba->dev),
 			hba->hibern8_on_idle.state);
+		ufshcd_pm_wait_start(hba, UFS_PM_WAIT_H8_EXIT);
 		schedule_work(&hba->hibern8_on_idle.exit_work);
 		/*
 		 * fall through to check if we should wait for this
@@ -2095,7 +2341,8 @@ static void __ufshcd_hibern8_release(struct ufs_hba *hba, bool no_sched)
 	 * work gets scheduled atleast after 2 jiffies (any time between
 	 * 1000/HZ ms to 2000/HZ ms).
 	 */
-	delay_in_jiffies = msecs_to_jiffies(hba->hibern8_on_idle.delay_ms);
+	hba->hibern8_on_idle.pred.idle_start_t = ktime_get();
+	delay_in_jiffies = msecs_to_jiffies(ufshcd_hibern8_on_idle_delay(hba));
 	if (delay_in_jiffies == 1)
 		delay_in_jiffies++;
 
@@ -2215,6 +2462,7 @@ static void ufshcd_hibern8_exit_work(struct work_struct *work)
 		}
 	}
 unblock_reqs:
+	ufshcd_pm_wait_end(hba, UFS_PM_WAIT_H8_EXIT);
 	ufshcd_scsi_unblock_requests(hba);
 }
 
@@ -2356,6 +2604,12 @@ static void ufshcd_init_hibern8_on_idle(struct ufs_hba *hba)
 	hba->hibern8_on_idle.enable_attr.attr.mode = S_IRUGO | S_IWUSR;
 	if (device_create_file(hba->dev, &hba->hibern8_on_idle.enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for hibern8_on_idle_enable\n");
+
+	/* auto hibern8 is timed by the controller, nothing to adapt there */
+	if (!ufshcd_is_auto_hibern8_supported(hba))
+		ufshcd_idle_pred_init(hba, &hba->hibern8_on_idle.pred,
+				      "hibern8_on_idle_adaptive",
+				      hba->hibern8_on_idle.delay_ms, 2000);
 }
 
 static void ufshcd_exit_hibern8_on_idle(struct ufs_hba *hba)
@@ -2365,6 +2619,8 @@ static void ufshcd_exit_hibern8_on_idle(struct ufs_hba *hba)
 		return;
 	device_remove_file(hba->dev, &hba->hibern8_on_idle.delay_attr);
 	device_remove_file(hba->dev, &hba->hibern8_on_idle.enable_attr);
+	if (!ufshcd_is_auto_hibern8_supported(hba))
+		device_remove_file(hba->dev, &hba->hibern8_on_idle.pred.attr);
 }
 
 static void ufshcd_hold_all(struct ufs_hba *hba)
@@ -2409,6 +2665,35 @@ static void ufshcd_clk_scaling_start_busy(struct ufs_hba *hba)
 	}
 }
 
+/*
+ * Must be called with host lock acquired. Deep queues and large requests
+ * are what app launches and bulk IO look like; scale up for them right
+ * away instead of waiting for the next devfreq polling window.
+ */
+static void ufshcd_clk_scaling_predict(struct ufs_hba *hba,
+				       struct ufshcd_lrb *lrbp)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	u32 qdepth, bytes;
+
+	if (!ufshcd_is_clkscaling_supported(hba) || !lrbp->cmd)
+		return;
+
+	if (!scaling->is_allowed || scaling->is_scaled_up ||
+	    hba->pm_op_in_progress)
+		return;
+
+	qdepth = hweight_long(hba->outstanding_reqs);
+	bytes = scsi_bufflen(lrbp->cmd);
+	if ((!scaling->up_qdepth || qdepth < scaling->up_qdepth) &&
+	    (!scaling->up_req_kb || bytes < scaling->up_req_kb * 1024))
+		return;
+
+	if (queue_work(scaling->workq, &scaling->boost_work))
+		trace_ufshcd_clk_scaling_decision(dev_name(hba->dev), "boost",
+						  qdepth, bytes);
+}
+
 static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
 {
 	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
@@ -2438,6 +2723,9 @@ int ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 	hba->lrb[task_tag].complete_time_stamp = ktime_set(0, 0);
 	ufshcd_clk_scaling_start_busy(hba);
 	__set_bit(task_tag, &hba->outstanding_reqs);
+	hba->lrb[task_tag].issue_qdepth =
+		min_t(unsigned int, hweight_long(hba->outstanding_reqs), U8_MAX);
+	ufshcd_clk_scaling_predict(hba, &hba->lrb[task_tag]);
 	ufshcd_writel(hba, 1 << task_tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
 	/* Make sure that doorbell is committed immediately */
 	wmb();
@@ -5514,6 +5802,14 @@ static int ufshcd_slave_configure(struct scsi_device *sdev)
 		scsi_set_cmd_timeout_override(sdev, hba->scsi_cmd_timeout * HZ);
 	}
 
+	/*
+	 * The block softirq already steers completions to the submitting
+	 * CPU's cache group; force the exact CPU when asked to, so that
+	 * completions of parallel IO don't all pile up on the IRQ CPU.
+	 */
+	if (ufshcd_is_compl_same_cpu_allowed(hba))
+		queue_flag_set_unlocked(QUEUE_FLAG_SAME_FORCE, q);
+
 	sdev->autosuspend_delay = UFSHCD_AUTO_SUSPEND_DELAY_MS;
 	sdev->use_rpm_auto = 1;
 
@@ -5856,6 +6152,7 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 	int result;
 	int index;
 	struct request *req;
+	ktime_t completion = ktime_get();
 
 	for_each_set_bit(index, &completed_reqs, hba->nutrs) {
 		lrbp = &hba->lrb[index];
@@ -5867,7 +6164,7 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 			scsi_dma_unmap(cmd);
 			cmd->result = result;
 			clear_bit_unlock(index, &hba->lrb_in_use);
-			lrbp->complete_time_stamp = ktime_get();
+			lrbp->complete_time_stamp = completion;
 			update_req_stats(hba, lrbp);
 			/* Mark completed command as NULL in LRB */
 			lrbp->cmd = NULL;
@@ -5890,10 +6187,8 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 			if (req) {
 				/* Update IO svc time latency histogram */
 				if (req->lat_hist_enabled) {
-					ktime_t completion;
 					u_int64_t delta_us;
 
-					completion = ktime_get();
 					delta_us = ktime_us_delta(completion,
 						  req->lat_hist_io_start);
 					blk_update_latency_hist(
@@ -5911,10 +6206,11 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 				complete(hba->dev_cmd.complete);
 			}
 		}
-		if (ufshcd_is_clkscaling_supported(hba))
-			hba->clk_scaling.active_reqs--;
 	}
 
+	if (ufshcd_is_clkscaling_supported(hba))
+		hba->clk_scaling.active_reqs -= hweight_long(completed_reqs);
+
 	/* clear corresponding bits of completed commands */
 	hba->outstanding_reqs ^= completed_reqs;
 
@@ -9411,6 +9707,7 @@ static int ufshcd_suspend(struct ufs_hba *hba, enum ufs_pm_op pm_op)
 	if (hba->clk_scaling.is_allowed) {
 		cancel_work_sync(&hba->clk_scaling.suspend_work);
 		cancel_work_sync(&hba->clk_scaling.resume_work);
+		cancel_work_sync(&hba->clk_scaling.boost_work);
 		ufshcd_suspend_clkscaling(hba);
 	}
 
@@ -9943,6 +10240,7 @@ static void __ufshcd_shutdown_clkscaling(struct ufs_hba *hba)
 	if (ufshcd_is_clkscaling_supported(hba)) {
 		cancel_work_sync(&hba->clk_scaling.suspend_work);
 		cancel_work_sync(&hba->clk_scaling.resume_work);
+		cancel_work_sync(&hba->clk_scaling.boost_work);
 		if (suspend)
 			ufshcd_suspend_clkscaling(hba);
 	}
@@ -10463,6 +10761,7 @@ static ssize_t ufshcd_clkscale_enable_store(struct device *dev,
 
 	cancel_work_sync(&hba->clk_scaling.suspend_work);
 	cancel_work_sync(&hba->clk_scaling.resume_work);
+	cancel_work_sync(&hba->clk_scaling.boost_work);
 
 	hba->clk_scaling.is_allowed = value;
 
@@ -10518,6 +10817,62 @@ static void ufshcd_clk_scaling_resume_work(struct work_struct *work)
 	devfreq_resume_device(hba->devfreq);
 }
 
+static void ufshcd_clk_scaling_boost_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   clk_scaling.boost_work);
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	struct devfreq *devfreq = hba->devfreq;
+	unsigned long irq_flags;
+	ktime_t start;
+	int ret;
+
+	if (!devfreq)
+		return;
+
+	/* Serialize against ->target() and keep devfreq's view in sync */
+	mutex_lock(&devfreq->lock);
+	spin_lock_irqsave(hba->host->host_lock, irq_flags);
+	if (ufshcd_eh_in_progress(hba) || !scaling->is_allowed ||
+	    scaling->is_scaled_up) {
+		spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+		goto out;
+	}
+	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+
+	start = ktime_get();
+	ret = ufshcd_devfreq_scale(hba, true);
+	trace_ufshcd_profile_clk_scaling(dev_name(hba->dev), "boost",
+		ktime_to_us(ktime_sub(ktime_get(), start)), ret);
+	if (!ret) {
+		devfreq->previous_freq = UINT_MAX;
+		scaling->boost_t = ktime_get();
+		scaling->down_votes = 0;
+	}
+out:
+	mutex_unlock(&devfreq->lock);
+}
+
+/*
+ * Must be called with host lock acquired. Returns true if a devfreq vote
+ * to scale down should be ignored for now.
+ */
+static bool ufshcd_clk_scaling_hold_down(struct ufs_hba *hba)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+
+	if (scaling->down_hold_ms &&
+	    ktime_ms_delta(ktime_get(), scaling->boost_t) <
+	    scaling->down_hold_ms)
+		return true;
+
+	if (++scaling->down_votes < scaling->down_count)
+		return true;
+
+	scaling->down_votes = 0;
+	return false;
+}
+
 static int ufshcd_devfreq_target(struct device *dev,
 				unsigned long *freq, u32 flags)
 {
@@ -10545,11 +10900,20 @@ static int ufshcd_devfreq_target(struct device *dev,
 		sched_clk_scaling_suspend_work = true;
 
 	scale_up = (*freq == UINT_MAX) ? true : false;
+	if (scale_up)
+		hba->clk_scaling.down_votes = 0;
 	if (!ufshcd_is_devfreq_scaling_required(hba, scale_up)) {
 		spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
 		ret = 0;
 		goto out; /* no state change required */
 	}
+	if (!scale_up && ufshcd_clk_scaling_hold_down(hba)) {
+		trace_ufshcd_clk_scaling_decision(dev_name(hba->dev), "hold",
+				hweight_long(hba->outstanding_reqs), 0);
+		spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+		ret = 0;
+		goto out;
+	}
 	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
 
 	start = ktime_get();
@@ -10604,6 +10968,41 @@ start_window:
 	return 0;
 }
 
+static ssize_t ufshcd_clkscale_predict_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+
+	return snprintf(buf, PAGE_SIZE, "%u %u %u %u\n", scaling->up_qdepth,
+			scaling->up_req_kb, scaling->down_hold_ms,
+			scaling->down_count);
+}
+
+/* Takes "<up_qdepth> <up_req_kb> <down_hold_ms> <down_count>" */
+static ssize_t ufshcd_clkscale_predict_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	u32 qdepth, req_kb, hold_ms, down_count;
+	unsigned long flags;
+
+	if (sscanf(buf, "%u %u %u %u", &qdepth, &req_kb, &hold_ms,
+		   &down_count) != 4)
+		return -EINVAL;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	scaling->up_qdepth = min_t(u32, qdepth, hba->nutrs);
+	scaling->up_req_kb = req_kb;
+	scaling->down_hold_ms = hold_ms;
+	scaling->down_count = down_count;
+	scaling->down_votes = 0;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
 static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 {
 	hba->clk_scaling.enable_attr.show = ufshcd_clkscale_enable_show;
@@ -10613,6 +11012,14 @@ static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 	hba->clk_scaling.enable_attr.attr.mode = S_IRUGO | S_IWUSR;
 	if (device_create_file(hba->dev, &hba->clk_scaling.enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for clkscale_enable\n");
+
+	hba->clk_scaling.predict_attr.show = ufshcd_clkscale_predict_show;
+	hba->clk_scaling.predict_attr.store = ufshcd_clkscale_predict_store;
+	sysfs_attr_init(&hba->clk_scaling.predict_attr.attr);
+	hba->clk_scaling.predict_attr.attr.name = "clkscale_predict";
+	hba->clk_scaling.predict_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &hba->clk_scaling.predict_attr))
+		dev_err(hba->dev, "Failed to create sysfs for clkscale_predict\n");
 }
 
 static void ufshcd_init_lanes_per_dir(struct ufs_hba *hba)
@@ -10794,6 +11201,12 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 			  ufshcd_clk_scaling_suspend_work);
 		INIT_WORK(&hba->clk_scaling.resume_work,
 			  ufshcd_clk_scaling_resume_work);
+		INIT_WORK(&hba->clk_scaling.boost_work,
+			  ufshcd_clk_scaling_boost_work);
+		hba->clk_scaling.up_qdepth = 8;
+		hba->clk_scaling.up_req_kb = 512;
+		hba->clk_scaling.down_hold_ms = 100;
+		hba->clk_scaling.down_count = 2;
 
 		snprintf(wq_name, ARRAY_SIZE(wq_name), "ufs_clkscaling_%d",
 			 host->host_no);
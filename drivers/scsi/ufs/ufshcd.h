@@ -194,6 +194,7 @@ struct ufs_pm_lvl_states {
  * @intr_cmd: Interrupt command (doesn't participate in interrupt aggregation)
  * @issue_time_stamp: time stamp for debug purposes
  * @complete_time_stamp: time stamp for statistics
+ * @issue_qdepth: number of requests outstanding when this one was issued
  * @req_abort_skip: skip request abort task flag
  */
 struct ufshcd_lrb {
@@ -218,6 +219,7 @@ struct ufshcd_lrb {
 	bool intr_cmd;
 	ktime_t issue_time_stamp;
 	ktime_t complete_time_stamp;
+	u8 issue_qdepth;
 
 	bool req_abort_skip;
 };
@@ -410,6 +412,31 @@ enum clk_gating_state {
 	REQ_CLKS_ON,
 };
 
+#define UFS_IDLE_PRED_BUCKETS	10
+#define UFS_IDLE_PRED_WINDOW	64
+
+/**
+ * struct ufs_idle_pred - learns idle gaps to pick a low power entry delay
+ * @hist: idle gap histogram; bucket 0 is < 1ms and bucket n covers
+ * [2^(n-1), 2^n) ms, the last bucket being open ended
+ * @samples: gaps recorded since the delay was last picked
+ * @exit_cost_us: cost of a low power exit, expressed as the idle time
+ * (in us) worth of active power it is equivalent to
+ * @delay_ms: delay picked from the histogram
+ * @idle_start_t: start of the current idle period, zero when busy
+ * @enabled: use @delay_ms instead of the static delay
+ * @attr: sysfs attribute to enable/tune the predictor
+ */
+struct ufs_idle_pred {
+	u32 hist[UFS_IDLE_PRED_BUCKETS];
+	u32 samples;
+	u32 exit_cost_us;
+	unsigned long delay_ms;
+	ktime_t idle_start_t;
+	bool enabled;
+	struct device_attribute attr;
+};
+
 /**
  * struct ufs_clk_gating - UFS clock gating related info
  * @gate_hrtimer: hrtimer to invoke @gate_work after some delay as
@@ -430,6 +457,7 @@ enum clk_gating_state {
  * @is_enabled: Indicates the current status of clock gating
  * @active_reqs: number of requests that are pending and should be waited for
  * completion before gating clocks.
+ * @pred: adaptive gating delay
  */
 struct ufs_clk_gating {
 	struct hrtimer gate_hrtimer;
@@ -447,6 +475,7 @@ struct ufs_clk_gating {
 	bool is_enabled;
 	int active_reqs;
 	struct workqueue_struct *clk_gating_workq;
+	struct ufs_idle_pred pred;
 };
 
 /* Hibern8 state  */
@@ -472,6 +501,7 @@ enum ufshcd_hibern8_on_idle_state {
  * @delay_attr: sysfs attribute to control delay_attr
  * @enable_attr: sysfs attribute to enable/disable hibern8 on idle
  * @is_enabled: Indicates the current status of hibern8
+ * @pred: adaptive hibern8 enter delay
  */
 struct ufs_hibern8_on_idle {
 	struct delayed_work enter_work;
@@ -483,6 +513,7 @@ struct ufs_hibern8_on_idle {
 	struct device_attribute delay_attr;
 	struct device_attribute enable_attr;
 	bool is_enabled;
+	struct ufs_idle_pred pred;
 };
 
 struct ufs_saved_pwr_info {
@@ -508,6 +539,15 @@ struct ufs_saved_pwr_info {
  * @is_busy_started: tracks if busy period has started or not
  * @is_suspended: tracks if devfreq is suspended or not
  * @is_scaled_up: tracks if we are currently scaled up or scaled down
+ * @boost_work: worker to scale up ahead of devfreq on a predicted burst
+ * @predict_attr: sysfs attribute to tune the predictive scale up/down
+ * @up_qdepth: outstanding requests that trigger an immediate scale up
+ * @up_req_kb: request size (in KB) that triggers an immediate scale up
+ * @down_hold_ms: time after a predictive scale up during which devfreq
+ * can't scale down
+ * @down_count: consecutive devfreq scale down votes needed to scale down
+ * @down_votes: scale down votes seen since the last scale up
+ * @boost_t: time of the last predictive scale up
  */
 struct ufs_clk_scaling {
 	int active_reqs;
@@ -523,6 +563,14 @@ struct ufs_clk_scaling {
 	bool is_busy_started;
 	bool is_suspended;
 	bool is_scaled_up;
+	struct work_struct boost_work;
+	struct device_attribute predict_attr;
+	u32 up_qdepth;
+	u32 up_req_kb;
+	u32 down_hold_ms;
+	u32 down_count;
+	u32 down_votes;
+	ktime_t boost_t;
 };
 
 #define UIC_ERR_REG_HIST_LENGTH 20
@@ -538,6 +586,13 @@ struct ufs_uic_err_reg_hist {
 	ktime_t tstamp[UIC_ERR_REG_HIST_LENGTH];
 };
 
+/* request blocking power management transitions */
+enum ufshcd_pm_wait {
+	UFS_PM_WAIT_UNGATE,
+	UFS_PM_WAIT_H8_EXIT,
+	UFS_PM_WAIT_MAX,
+};
+
 #ifdef CONFIG_DEBUG_FS
 struct debugfs_files {
 	struct dentry *debugfs_root;
@@ -553,6 +608,7 @@ struct debugfs_files {
 	struct dentry *dbg_print_en;
 	struct dentry *req_stats;
 	struct dentry *query_stats;
+	struct dentry *lat_hist;
 	u32 dme_local_attr_id;
 	u32 dme_peer_attr_id;
 	struct dentry *reset_controller;
@@ -592,6 +648,35 @@ struct ufshcd_req_stat {
 	u64 sum;
 	u64 count;
 };
+
+enum ufshcd_lat_op {
+	UFS_LAT_OP_READ,
+	UFS_LAT_OP_WRITE,
+	UFS_LAT_OP_UNMAP,
+	UFS_LAT_OP_SYNC,
+	UFS_LAT_OP_OTHER,
+	UFS_LAT_OP_MAX,
+};
+
+/* request size buckets: <=4K, <=16K, <=64K, <=256K, larger */
+#define UFS_LAT_SIZE_BUCKETS	5
+/* queue depth at issue buckets: 1, 2-4, 5-8, 9-16, 17+ */
+#define UFS_LAT_QD_BUCKETS	5
+/* log2 latency buckets: <16us, <32us, ... , >=128ms */
+#define UFS_LAT_BUCKETS		14
+
+/**
+ * struct ufshcd_lat_hist - per-cpu latency histograms
+ * @req: issue to completion latency of each request, split by opcode,
+ *	transfer size and number of requests outstanding at issue
+ * @pm_wait: time requests were blocked waiting for the clocks to be ungated
+ *	or the link to exit hibern8
+ */
+struct ufshcd_lat_hist {
+	u32 req[UFS_LAT_OP_MAX][UFS_LAT_SIZE_BUCKETS][UFS_LAT_QD_BUCKETS]
+		[UFS_LAT_BUCKETS];
+	u32 pm_wait[UFS_PM_WAIT_MAX][UFS_LAT_BUCKETS];
+};
 #endif
 
 enum ufshcd_ctx {
@@ -636,6 +721,8 @@ struct ufs_stats {
 	int err_stats[UFS_ERR_MAX];
 	struct ufshcd_req_stat req_stats[TS_NUM_STATS];
 	int query_stats_arr[UPIU_QUERY_OPCODE_MAX][MAX_QUERY_IDN];
+	struct ufshcd_lat_hist __percpu *lat_hist;
+	ktime_t pm_wait_start[UFS_PM_WAIT_MAX];
 
 #endif
 	u32 last_intr_status;
@@ -970,6 +1057,12 @@ struct ufs_hba {
 	 * in hibern8 then enable this cap.
 	 */
 #define UFSHCD_CAP_POWER_COLLAPSE_DURING_HIBERN8 (1 << 7)
+	/*
+	 * Complete requests on the exact CPU that submitted them rather than
+	 * on any CPU sharing its cache. Helps when many cores issue IO in
+	 * parallel and the completion IRQ is affine to a single CPU.
+	 */
+#define UFSHCD_CAP_COMPL_SAME_CPU (1 << 8)
 
 	struct devfreq *devfreq;
 	struct ufs_clk_scaling clk_scaling;
@@ -1036,6 +1129,11 @@ static inline bool ufshcd_is_power_collapse_during_hibern8_allowed(
 	return !!(hba->caps & UFSHCD_CAP_POWER_COLLAPSE_DURING_HIBERN8);
 }
 
+static inline bool ufshcd_is_compl_same_cpu_allowed(struct ufs_hba *hba)
+{
+	return !!(hba->caps & UFSHCD_CAP_COMPL_SAME_CPU);
+}
+
 static inline bool ufshcd_keep_autobkops_enabled_except_suspend(
 							struct ufs_hba *hba)
 {
@@ -59,6 +59,8 @@ module_param_named(inactivity, POLLING_INACTIVITY, int, 0664);
 static int bam_adaptive_timer_enabled;
 module_param_named(adaptive_timer_enabled,
 			bam_adaptive_timer_enabled, int, 0664);
+static int rx_copybreak = 256;
+module_param(rx_copybreak, int, 0664);
 
 static struct bam_ops_if bam_default_ops = {
 	/* smsm */
@@ -79,6 +81,7 @@ static struct bam_ops_if bam_default_ops = {
 	.sps_device_reset_ptr = &sps_device_reset,
 	.sps_register_event_ptr = &sps_register_event,
 	.sps_transfer_one_ptr = &sps_transfer_one,
+	.sps_transfer_bulk_ptr = &sps_transfer_bulk,
 	.sps_get_iovec_ptr = &sps_get_iovec,
 	.sps_get_unused_desc_num_ptr = &sps_get_unused_desc_num,
 
@@ -167,6 +170,7 @@ struct bam_ch_info {
 #define A2_PHYS_BASE		0x124C2000
 #define A2_PHYS_SIZE		0x2000
 #define DEFAULT_NUM_BUFFERS	32
+#define BAM_DMUX_RX_BATCH	8
 
 #ifndef A2_BAM_IRQ
 #define A2_BAM_IRQ -1
@@ -379,82 +383,209 @@ static inline void verify_tx_queue_is_empty(const char *func)
 	spin_unlock_irqrestore(&bam_tx_pool_spinlock, flags);
 }
 
-static void __queue_rx(gfp_t alloc_flags)
+static struct rx_pkt_info *bam_dmux_rx_alloc(gfp_t alloc_flags, uint16_t len)
 {
-	void *ptr;
 	struct rx_pkt_info *info;
-	int ret;
-	int rx_len_cached;
-	uint16_t current_buffer_size;
+	void *ptr;
 
-	mutex_lock(&bam_rx_pool_mutexlock);
-	rx_len_cached = bam_rx_pool_len;
-	current_buffer_size = buffer_size;
-	mutex_unlock(&bam_rx_pool_mutexlock);
+	info = kmalloc(sizeof(*info), alloc_flags);
+	if (!info)
+		return NULL;
 
-	while (bam_connection_is_active && rx_len_cached < num_buffers) {
-		if (in_global_reset)
-			goto fail;
+	info->len = len;
 
-		info = kmalloc(sizeof(*info), alloc_flags);
-		if (!info)
-			goto fail;
+	INIT_WORK(&info->work, handle_bam_mux_cmd);
 
-		info->len = current_buffer_size;
+	info->skb = __dev_alloc_skb(info->len, alloc_flags);
+	if (info->skb == NULL)
+		goto fail_info;
 
-		INIT_WORK(&info->work, handle_bam_mux_cmd);
+	ptr = skb_put(info->skb, info->len);
 
-		info->skb = __dev_alloc_skb(info->len, alloc_flags);
-		if (info->skb == NULL)
-			goto fail_info;
+	info->dma_address = dma_map_single(dma_dev, ptr, info->len,
+						bam_ops->dma_from);
+	if (info->dma_address == 0 || info->dma_address == ~0) {
+		DMUX_LOG_KERR("%s:dma_map_single failure %pK for %pK\n",
+			__func__, (void *)info->dma_address, ptr);
+		goto fail_skb;
+	}
 
-		ptr = skb_put(info->skb, info->len);
+	return info;
 
-		info->dma_address = dma_map_single(dma_dev, ptr, info->len,
-							bam_ops->dma_from);
-		if (info->dma_address == 0 || info->dma_address == ~0) {
-			DMUX_LOG_KERR("%s:dma_map_single failure %pK for %pK\n",
-				__func__, (void *)info->dma_address, ptr);
-			goto fail_skb;
-		}
+fail_skb:
+	dev_kfree_skb_any(info->skb);
 
-		mutex_lock(&bam_rx_pool_mutexlock);
-		list_add_tail(&info->list_node, &bam_rx_pool);
-		rx_len_cached = ++bam_rx_pool_len;
-		current_buffer_size = buffer_size;
+fail_info:
+	kfree(info);
+	return NULL;
+}
+
+static void bam_dmux_rx_free(struct rx_pkt_info *info)
+{
+	dma_unmap_single(dma_dev, info->dma_address, info->len,
+				bam_ops->dma_from);
+	dev_kfree_skb_any(info->skb);
+	kfree(info);
+}
+
+/*
+ * Queue a batch of receive buffers. The whole batch goes to the BAM in one
+ * call with a single write offset update when the bulk interface is
+ * available, otherwise (or if the FIFO cannot take the whole batch) the
+ * buffers are queued one at a time. Returns the number of buffers queued;
+ * the ones that were not are freed.
+ *
+ * Must be called with bam_rx_pool_mutexlock held.
+ */
+static int bam_dmux_rx_submit(struct rx_pkt_info **batch, int num)
+{
+	struct sps_transfer_desc desc[BAM_DMUX_RX_BATCH];
+	int ret;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		list_add_tail(&batch[i]->list_node, &bam_rx_pool);
+		desc[i].addr = batch[i]->dma_address;
+		desc[i].size = batch[i]->len;
+		desc[i].user = batch[i];
+		desc[i].flags = 0;
+	}
+	bam_rx_pool_len += num;
+
+	if (num > 1 && bam_ops->sps_transfer_bulk_ptr &&
+		!bam_ops->sps_transfer_bulk_ptr(bam_rx_pipe, desc, num))
+		return num;
+
+	for (i = 0; i < num; i++) {
 		ret = bam_ops->sps_transfer_one_ptr(bam_rx_pipe,
-				info->dma_address, info->len, info, 0);
+				batch[i]->dma_address, batch[i]->len,
+				batch[i], 0);
 		if (ret) {
-			list_del(&info->list_node);
-			rx_len_cached = --bam_rx_pool_len;
-			mutex_unlock(&bam_rx_pool_mutexlock);
 			DMUX_LOG_KERR("%s: sps_transfer_one failed %d\n",
 				__func__, ret);
-
-			dma_unmap_single(dma_dev, info->dma_address,
-						info->len,
-						bam_ops->dma_from);
-
-			goto fail_skb;
+			break;
 		}
-		mutex_unlock(&bam_rx_pool_mutexlock);
+	}
 
+	if (i < num) {
+		bam_rx_pool_len -= num - i;
+		for (ret = i; ret < num; ret++) {
+			list_del(&batch[ret]->list_node);
+			bam_dmux_rx_free(batch[ret]);
+		}
 	}
-	return;
 
-fail_skb:
-	dev_kfree_skb_any(info->skb);
+	return i;
+}
 
-fail_info:
-	kfree(info);
+static void __queue_rx(gfp_t alloc_flags)
+{
+	struct rx_pkt_info *batch[BAM_DMUX_RX_BATCH];
+	int rx_len_cached;
+	uint16_t current_buffer_size;
+	bool failed = false;
+	int num;
 
-fail:
-	if (!in_global_reset) {
+	mutex_lock(&bam_rx_pool_mutexlock);
+	rx_len_cached = bam_rx_pool_len;
+	current_buffer_size = buffer_size;
+	mutex_unlock(&bam_rx_pool_mutexlock);
+
+	while (bam_connection_is_active && rx_len_cached < num_buffers &&
+		!failed) {
+		for (num = 0; num < BAM_DMUX_RX_BATCH &&
+			rx_len_cached + num < num_buffers; num++) {
+			if (in_global_reset)
+				break;
+
+			batch[num] = bam_dmux_rx_alloc(alloc_flags,
+							current_buffer_size);
+			if (!batch[num])
+				break;
+		}
+		if (in_global_reset) {
+			while (num--)
+				bam_dmux_rx_free(batch[num]);
+			return;
+		}
+		if (num < BAM_DMUX_RX_BATCH && rx_len_cached + num < num_buffers)
+			failed = true;
+		if (!num)
+			break;
+
+		mutex_lock(&bam_rx_pool_mutexlock);
+		if (bam_dmux_rx_submit(batch, num) < num)
+			failed = true;
+		rx_len_cached = bam_rx_pool_len;
+		current_buffer_size = buffer_size;
+		mutex_unlock(&bam_rx_pool_mutexlock);
+	}
+
+	if (failed && !in_global_reset) {
 		DMUX_LOG_KERR("%s: rescheduling\n", __func__);
 		schedule_work(&queue_rx_work);
 	}
 }
 
+/*
+ * Give a receive buffer that is still mapped back to the BAM. Buffers of
+ * a stale MTU and those beyond the pool size are freed instead.
+ */
+static void bam_dmux_rx_recycle(struct rx_pkt_info *info)
+{
+	mutex_lock(&bam_rx_pool_mutexlock);
+	if (!bam_connection_is_active || in_global_reset ||
+		info->len != buffer_size || bam_rx_pool_len >= num_buffers) {
+		mutex_unlock(&bam_rx_pool_mutexlock);
+		bam_dmux_rx_free(info);
+		return;
+	}
+
+	dma_sync_single_for_device(dma_dev, info->dma_address, info->len,
+					bam_ops->dma_from);
+	bam_dmux_rx_submit(&info, 1);
+	mutex_unlock(&bam_rx_pool_mutexlock);
+}
+
+/*
+ * Small data packets, TCP acks for most part, are copied into a new skb
+ * so their receive buffer goes back to the BAM without being unmapped,
+ * freed, allocated and mapped again. Returns the copy, or NULL if the
+ * buffer has to be passed up as it is.
+ */
+static struct sk_buff *bam_dmux_rx_copybreak(struct rx_pkt_info *info)
+{
+	struct bam_mux_hdr *rx_hdr;
+	struct sk_buff *skb;
+	int len;
+
+	dma_sync_single_for_cpu(dma_dev, info->dma_address, info->len,
+					bam_ops->dma_from);
+
+	rx_hdr = (struct bam_mux_hdr *)info->skb->data;
+	if (rx_hdr->magic_num != BAM_MUX_HDR_MAGIC_NO ||
+		rx_hdr->cmd != BAM_MUX_HDR_CMD_DATA ||
+		rx_hdr->ch_id >= BAM_DMUX_NUM_CHANNELS)
+		return NULL;
+
+	len = sizeof(*rx_hdr);
+	if (rx_hdr->pkt_len == 0xffff)
+		len = info->sps_size;
+	else
+		len += rx_hdr->pkt_len;
+	if (len > READ_ONCE(rx_copybreak) || len > info->len)
+		return NULL;
+
+	skb = __dev_alloc_skb(len, GFP_NOWAIT | __GFP_NOWARN);
+	if (!skb)
+		return NULL;
+
+	memcpy(skb_put(skb, len), rx_hdr, len);
+	bam_dmux_rx_recycle(info);
+
+	return skb;
+}
+
 static void queue_rx(void)
 {
 	/*
@@ -651,11 +782,14 @@ static void handle_bam_mux_cmd(struct work_struct *work)
 	uint16_t sps_size;
 
 	info = container_of(work, struct rx_pkt_info, work);
-	rx_skb = info->skb;
-	dma_unmap_single(dma_dev, info->dma_address, info->len,
-			bam_ops->dma_from);
 	sps_size = info->sps_size;
-	kfree(info);
+	rx_skb = bam_dmux_rx_copybreak(info);
+	if (!rx_skb) {
+		rx_skb = info->skb;
+		dma_unmap_single(dma_dev, info->dma_address, info->len,
+				bam_ops->dma_from);
+		kfree(info);
+	}
 
 	rx_hdr = (struct bam_mux_hdr *)rx_skb->data;
 
@@ -12,9 +12,11 @@
 #ifndef _SOC_QCOM_GLINK_CORE_IF_H_
 #define _SOC_QCOM_GLINK_CORE_IF_H_
 
+#include <linux/mm.h>
 #include <linux/of.h>
 #include <linux/types.h>
 #include <linux/sched.h>
+#include <linux/vmalloc.h>
 #include "glink_private.h"
 
 /* Local Channel state */
@@ -218,4 +220,44 @@ static inline void *rx_linear_vbuf_provider(void *iovec, size_t offset,
 	return rx_info->data + offset;
 }
 
+/**
+ * rx_linear_pbuf_provider() - Physical Buffer Provider for linear buffers
+ * iovec:	Pointer to the beginning of the linear buffer.
+ * offset:	Offset into the buffer whose address is needed.
+ * size:	Pointer to hold the length of the contiguous buffer space.
+ *
+ * Counterpart of rx_linear_vbuf_provider() for clients that hand the received
+ * data to hardware or map it elsewhere instead of copying it.  The buffer may
+ * come from kmalloc() or vmalloc(); for the latter the contiguous space ends at
+ * the page boundary.
+ *
+ * Return: Physical address of the buffer at offset "offset" from the beginning
+ *         of the buffer.
+ */
+static inline void *rx_linear_pbuf_provider(void *iovec, size_t offset,
+					    size_t *size)
+{
+	struct glink_core_rx_intent *rx_info =
+		(struct glink_core_rx_intent *)iovec;
+	void *vaddr;
+
+	if (unlikely(!iovec || !size))
+		return NULL;
+
+	if (unlikely(offset >= rx_info->pkt_size))
+		return NULL;
+
+	if (unlikely(OVERFLOW_ADD_UNSIGNED(void *, rx_info->data, offset)))
+		return NULL;
+
+	vaddr = rx_info->data + offset;
+	*size = rx_info->pkt_size - offset;
+	if (!is_vmalloc_addr(vaddr))
+		return (void *)virt_to_phys(vaddr);
+
+	*size = min_t(size_t, *size, PAGE_SIZE - offset_in_page(vaddr));
+	return (void *)(page_to_phys(vmalloc_to_page(vaddr)) +
+			offset_in_page(vaddr));
+}
+
 #endif /* _SOC_QCOM_GLINK_CORE_IF_H_ */
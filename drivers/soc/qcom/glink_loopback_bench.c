@@ -0,0 +1,544 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * G-Link loopback benchmark client.
+ *
+ * Drives a loopback server over one transport and edge with the commands
+ * of glink_loopback_commands.h and measures the round trip time of echoed
+ * packets, one packet in flight at a time. A run is started by writing
+ *
+ *   <transport> <edge> <ctl channel> <pkt size> <count> <intents> <mode>
+ *
+ * to /sys/kernel/debug/glink_lbbench/run, e.g.
+ *
+ *   echo "lloop local LOCAL_LOOPBACK_CLNT 4096 10000 4 reuse" > run
+ *   echo "smem mpss LOOPBACK_CTL_APSS 512 10000 4 prequeue" > run
+ *
+ * where mode selects the rx intent strategy of both sides:
+ *   prequeue	<intents> intents queued up front, a new one per packet
+ *   reuse	<intents> intents queued up front and reused by this side
+ *   ondemand	no intents queued, every packet requests one
+ *
+ * The results of the last run are read from the results file as one
+ * key=value pair per line.
+ */
+
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/err.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/workqueue.h>
+#include <soc/qcom/glink.h>
+#include "glink_loopback_commands.h"
+
+#define LBBENCH_ERR(x...) pr_err("<LBBENCH> " x)
+
+#define LBBENCH_DATA_CH_NAME	"LOOPBACK_BENCH_CLNT"
+#define LBBENCH_TIMEOUT		msecs_to_jiffies(5000)
+#define LBBENCH_MAX_PKT_SIZE	SZ_1M
+#define LBBENCH_MAX_INTENTS	64
+#define LBBENCH_CMD_LEN		128
+
+/* log2 histogram of round trip times, bucket n holds [2^(n-1), 2^n) usec */
+#define LBBENCH_HIST_BUCKETS	24
+
+enum lbbench_mode {
+	LBBENCH_PREQUEUE,
+	LBBENCH_REUSE,
+	LBBENCH_ONDEMAND,
+};
+
+static const char * const lbbench_mode_names[] = {
+	[LBBENCH_PREQUEUE] = "prequeue",
+	[LBBENCH_REUSE] = "reuse",
+	[LBBENCH_ONDEMAND] = "ondemand",
+};
+
+/**
+ * struct lbbench_ch - state of one channel of the benchmark
+ * @handle:		handle returned by glink_open()
+ * @connected:		completed by GLINK_CONNECTED
+ * @disconnected:	completed by GLINK_LOCAL_DISCONNECTED
+ * @rx:			completed when a packet is received
+ * @tx_done:		completed when the remote is done with a packet
+ * @rx_ptr:		the received packet, returned with glink_rx_done()
+ * @rx_size:		size of the received packet
+ * @intent_size:	size of the intent the remote requested last
+ * @intent_work:	queues the requested intent in process context
+ */
+struct lbbench_ch {
+	void *handle;
+	struct completion connected;
+	struct completion disconnected;
+	struct completion rx;
+	struct completion tx_done;
+	const void *rx_ptr;
+	size_t rx_size;
+	size_t intent_size;
+	struct work_struct intent_work;
+};
+
+struct lbbench {
+	struct mutex lock;
+	struct lbbench_ch ctl;
+	struct lbbench_ch data;
+	struct req req;
+	uint32_t req_id;
+
+	char transport[GLINK_NAME_SIZE];
+	char edge[GLINK_NAME_SIZE];
+	char ctl_name[MAX_NAME_LEN];
+	u32 pkt_size;
+	u32 count;
+	u32 intents;
+	enum lbbench_mode mode;
+
+	int status;
+	u32 done;
+	u64 elapsed_ns;
+	u64 min_ns;
+	u64 max_ns;
+	u64 total_ns;
+	u32 hist[LBBENCH_HIST_BUCKETS];
+};
+
+static struct lbbench lbbench;
+
+static void glink_lbbench_notify_rx(void *handle, const void *priv,
+				    const void *pkt_priv, const void *ptr,
+				    size_t size)
+{
+	struct lbbench_ch *ch = (struct lbbench_ch *)priv;
+
+	ch->rx_ptr = ptr;
+	ch->rx_size = size;
+	complete(&ch->rx);
+}
+
+static void glink_lbbench_notify_tx_done(void *handle, const void *priv,
+					 const void *pkt_priv, const void *ptr)
+{
+	struct lbbench_ch *ch = (struct lbbench_ch *)priv;
+
+	complete(&ch->tx_done);
+}
+
+static void glink_lbbench_notify_state(void *handle, const void *priv,
+				       unsigned int event)
+{
+	struct lbbench_ch *ch = (struct lbbench_ch *)priv;
+
+	if (event == GLINK_CONNECTED)
+		complete(&ch->connected);
+	else if (event == GLINK_LOCAL_DISCONNECTED)
+		complete(&ch->disconnected);
+}
+
+static void glink_lbbench_intent_worker(struct work_struct *work)
+{
+	struct lbbench_ch *ch = container_of(work, struct lbbench_ch,
+					     intent_work);
+	size_t size = READ_ONCE(ch->intent_size);
+	int ret;
+
+	ret = glink_queue_rx_intent(ch->handle, ch, size);
+	if (ret)
+		LBBENCH_ERR("%s: Err %d q'ing intent size %zu\n", __func__,
+			    ret, size);
+}
+
+static bool glink_lbbench_rmt_rx_intent_req_cb(void *handle, const void *priv,
+					       size_t sz)
+{
+	struct lbbench_ch *ch = (struct lbbench_ch *)priv;
+
+	WRITE_ONCE(ch->intent_size, sz);
+	schedule_work(&ch->intent_work);
+	return true;
+}
+
+static int glink_lbbench_open(struct lbbench *b, struct lbbench_ch *ch,
+			      const char *name)
+{
+	struct glink_open_config open_cfg;
+
+	memset(&open_cfg, 0, sizeof(open_cfg));
+	open_cfg.transport = b->transport;
+	open_cfg.edge = b->edge;
+	open_cfg.name = name;
+	open_cfg.notify_rx = glink_lbbench_notify_rx;
+	open_cfg.notify_tx_done = glink_lbbench_notify_tx_done;
+	open_cfg.notify_state = glink_lbbench_notify_state;
+	open_cfg.notify_rx_intent_req = glink_lbbench_rmt_rx_intent_req_cb;
+	open_cfg.priv = ch;
+
+	reinit_completion(&ch->connected);
+	reinit_completion(&ch->disconnected);
+	reinit_completion(&ch->rx);
+	reinit_completion(&ch->tx_done);
+	ch->handle = glink_open(&open_cfg);
+	if (IS_ERR_OR_NULL(ch->handle)) {
+		LBBENCH_ERR("%s:%s:%s %s: unable to open channel\n",
+			    b->transport, b->edge, name, __func__);
+		return ch->handle ? PTR_ERR(ch->handle) : -ENODEV;
+	}
+
+	if (!wait_for_completion_timeout(&ch->connected, LBBENCH_TIMEOUT)) {
+		LBBENCH_ERR("%s:%s:%s %s: timeout waiting for remote open\n",
+			    b->transport, b->edge, name, __func__);
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+static void glink_lbbench_close(struct lbbench_ch *ch)
+{
+	if (IS_ERR_OR_NULL(ch->handle))
+		return;
+
+	cancel_work_sync(&ch->intent_work);
+	if (!glink_close(ch->handle))
+		wait_for_completion_timeout(&ch->disconnected,
+					    LBBENCH_TIMEOUT);
+	ch->handle = NULL;
+}
+
+/* Send a request on the control channel and wait for its response */
+static int glink_lbbench_req(struct lbbench *b, uint32_t type, size_t size)
+{
+	struct resp resp;
+	int ret;
+
+	b->req.hdr.req_id = ++b->req_id;
+	b->req.hdr.req_type = type;
+	b->req.hdr.req_size = size;
+
+	reinit_completion(&b->ctl.rx);
+	reinit_completion(&b->ctl.tx_done);
+	ret = glink_tx(b->ctl.handle, NULL, &b->req, sizeof(b->req),
+		       GLINK_TX_REQ_INTENT);
+	if (ret)
+		return ret;
+
+	if (!wait_for_completion_timeout(&b->ctl.rx, LBBENCH_TIMEOUT) ||
+	    !wait_for_completion_timeout(&b->ctl.tx_done, LBBENCH_TIMEOUT))
+		return -ETIMEDOUT;
+
+	resp = *(struct resp *)b->ctl.rx_ptr;
+	glink_rx_done(b->ctl.handle, b->ctl.rx_ptr, true);
+	if (resp.req_id != b->req_id || resp.req_type != type)
+		return -EPROTO;
+
+	return resp.response;
+}
+
+static int glink_lbbench_setup(struct lbbench *b)
+{
+	struct open_req *open = &b->req.payload.open;
+	struct queue_rx_intent_config_req *q_rx = &b->req.payload.q_rx_int_conf;
+	int ret;
+	u32 i;
+
+	ret = glink_lbbench_open(b, &b->ctl, b->ctl_name);
+	if (ret)
+		return ret;
+
+	ret = glink_queue_rx_intent(b->ctl.handle, &b->ctl,
+				    sizeof(struct resp));
+	if (ret)
+		return ret;
+
+	memset(&b->req.payload, 0, sizeof(b->req.payload));
+	open->name_len = strlcpy(open->ch_name, LBBENCH_DATA_CH_NAME,
+				 MAX_NAME_LEN);
+	ret = glink_lbbench_req(b, OPEN, sizeof(*open));
+	if (ret)
+		return ret;
+
+	ret = glink_lbbench_open(b, &b->data, LBBENCH_DATA_CH_NAME);
+	if (ret || b->mode == LBBENCH_ONDEMAND)
+		return ret;
+
+	memset(&b->req.payload, 0, sizeof(b->req.payload));
+	q_rx->num_intents = b->intents;
+	q_rx->intent_size = b->pkt_size;
+	q_rx->name_len = strlcpy(q_rx->ch_name, LBBENCH_DATA_CH_NAME,
+				 MAX_NAME_LEN);
+	ret = glink_lbbench_req(b, QUEUE_RX_INTENT_CONFIG, sizeof(*q_rx));
+	if (ret)
+		return ret;
+
+	for (i = 0; i < b->intents; i++) {
+		ret = glink_queue_rx_intent(b->data.handle, &b->data,
+					    b->pkt_size);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static void glink_lbbench_teardown(struct lbbench *b)
+{
+	struct close_req *close = &b->req.payload.close;
+
+	if (!IS_ERR_OR_NULL(b->data.handle)) {
+		memset(&b->req.payload, 0, sizeof(b->req.payload));
+		close->name_len = strlcpy(close->ch_name, LBBENCH_DATA_CH_NAME,
+					  MAX_NAME_LEN);
+		glink_lbbench_req(b, CLOSE, sizeof(*close));
+		glink_lbbench_close(&b->data);
+	}
+	glink_lbbench_close(&b->ctl);
+}
+
+static void glink_lbbench_record(struct lbbench *b, u64 ns)
+{
+	unsigned int bucket = 0;
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+
+	if (us)
+		bucket = min_t(unsigned int, ilog2(us) + 1,
+			       LBBENCH_HIST_BUCKETS - 1);
+	b->hist[bucket]++;
+	if (!b->done || ns < b->min_ns)
+		b->min_ns = ns;
+	if (ns > b->max_ns)
+		b->max_ns = ns;
+	b->total_ns += ns;
+	b->done++;
+}
+
+static int glink_lbbench_pingpong(struct lbbench *b, void *buf)
+{
+	struct lbbench_ch *ch = &b->data;
+	ktime_t start, run_start;
+	int ret = 0;
+	u32 i;
+
+	run_start = ktime_get();
+	for (i = 0; i < b->count; i++) {
+		memset(buf, i, b->pkt_size);
+		reinit_completion(&ch->rx);
+		reinit_completion(&ch->tx_done);
+
+		start = ktime_get();
+		ret = glink_tx(ch->handle, NULL, buf, b->pkt_size,
+			       GLINK_TX_REQ_INTENT);
+		if (ret)
+			break;
+		if (!wait_for_completion_timeout(&ch->rx, LBBENCH_TIMEOUT)) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+		glink_lbbench_record(b, ktime_to_ns(ktime_sub(ktime_get(),
+							      start)));
+
+		if (ch->rx_size != b->pkt_size ||
+		    memcmp(ch->rx_ptr, buf, b->pkt_size))
+			ret = -EILSEQ;
+		glink_rx_done(ch->handle, ch->rx_ptr, b->mode == LBBENCH_REUSE);
+		if (!ret && b->mode == LBBENCH_PREQUEUE)
+			ret = glink_queue_rx_intent(ch->handle, ch,
+						    b->pkt_size);
+
+		/* buf is reused for the next packet */
+		if (!wait_for_completion_timeout(&ch->tx_done,
+						 LBBENCH_TIMEOUT) && !ret)
+			ret = -ETIMEDOUT;
+		if (ret)
+			break;
+	}
+	b->elapsed_ns = ktime_to_ns(ktime_sub(ktime_get(), run_start));
+
+	return ret;
+}
+
+static int glink_lbbench_run(struct lbbench *b)
+{
+	void *buf;
+	int ret;
+
+	b->done = 0;
+	b->elapsed_ns = 0;
+	b->min_ns = 0;
+	b->max_ns = 0;
+	b->total_ns = 0;
+	memset(b->hist, 0, sizeof(b->hist));
+
+	buf = kmalloc(b->pkt_size, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	ret = glink_lbbench_setup(b);
+	if (!ret)
+		ret = glink_lbbench_pingpong(b, buf);
+	if (ret)
+		LBBENCH_ERR("%s:%s %s: run failed after %u packets, ret %d\n",
+			    b->transport, b->edge, __func__, b->done, ret);
+	glink_lbbench_teardown(b);
+
+	kfree(buf);
+	return ret;
+}
+
+/* The smallest power of two usec that bounds the given share of packets */
+static u64 glink_lbbench_percentile(struct lbbench *b, u32 pct)
+{
+	u64 target = DIV_ROUND_UP((u64)b->done * pct, 100);
+	u64 seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < LBBENCH_HIST_BUCKETS; i++) {
+		seen += b->hist[i];
+		if (seen >= target)
+			return 1ULL << i;
+	}
+
+	return 1ULL << LBBENCH_HIST_BUCKETS;
+}
+
+static int glink_lbbench_results_show(struct seq_file *s, void *unused)
+{
+	struct lbbench *b = s->private;
+	u64 elapsed, kbytes;
+	unsigned int i;
+
+	mutex_lock(&b->lock);
+	elapsed = max_t(u64, b->elapsed_ns, 1);
+	kbytes = ((u64)b->done * b->pkt_size) >> 10;
+	seq_printf(s, "transport=%s\nedge=%s\n", b->transport, b->edge);
+	seq_printf(s, "pkt_size=%u\nintents=%u\nmode=%s\n", b->pkt_size,
+		   b->intents, lbbench_mode_names[b->mode]);
+	seq_printf(s, "status=%d\npackets=%u\nelapsed_ns=%llu\n", b->status,
+		   b->done, b->elapsed_ns);
+	seq_printf(s, "rtt_min_ns=%llu\nrtt_avg_ns=%llu\nrtt_max_ns=%llu\n",
+		   b->min_ns, b->done ? div_u64(b->total_ns, b->done) : 0,
+		   b->max_ns);
+	seq_printf(s, "rtt_p50_us_le=%llu\nrtt_p99_us_le=%llu\n",
+		   glink_lbbench_percentile(b, 50),
+		   glink_lbbench_percentile(b, 99));
+	seq_printf(s, "echo_kbps=%llu\n",
+		   div64_u64(kbytes * NSEC_PER_SEC, elapsed));
+	for (i = 0; i < LBBENCH_HIST_BUCKETS; i++)
+		if (b->hist[i])
+			seq_printf(s, "hist_us_lt_%llu=%u\n", 1ULL << i,
+				   b->hist[i]);
+	mutex_unlock(&b->lock);
+
+	return 0;
+}
+
+static int glink_lbbench_results_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, glink_lbbench_results_show, inode->i_private);
+}
+
+static const struct file_operations glink_lbbench_results_fops = {
+	.open		= glink_lbbench_results_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static ssize_t glink_lbbench_run_write(struct file *file,
+				       const char __user *ubuf, size_t count,
+				       loff_t *ppos)
+{
+	struct lbbench *b = file->private_data;
+	char cmd[LBBENCH_CMD_LEN], mode[16];
+	char transport[GLINK_NAME_SIZE], edge[GLINK_NAME_SIZE];
+	char ctl_name[MAX_NAME_LEN];
+	u32 pkt_size, pkts, intents;
+	int i;
+
+	if (count >= sizeof(cmd))
+		return -EINVAL;
+	if (copy_from_user(cmd, ubuf, count))
+		return -EFAULT;
+	cmd[count] = '\0';
+
+	/* field widths follow GLINK_NAME_SIZE and MAX_NAME_LEN */
+	if (sscanf(cmd, "%31s %31s %31s %u %u %u %15s", transport, edge,
+		   ctl_name, &pkt_size, &pkts, &intents, mode) != 7)
+		return -EINVAL;
+
+	i = match_string(lbbench_mode_names, ARRAY_SIZE(lbbench_mode_names),
+			 mode);
+	if (i < 0 || !pkt_size || pkt_size > LBBENCH_MAX_PKT_SIZE || !pkts ||
+	    (i != LBBENCH_ONDEMAND && !intents) ||
+	    intents > LBBENCH_MAX_INTENTS)
+		return -EINVAL;
+
+	mutex_lock(&b->lock);
+	strlcpy(b->transport, transport, GLINK_NAME_SIZE);
+	strlcpy(b->edge, edge, GLINK_NAME_SIZE);
+	strlcpy(b->ctl_name, ctl_name, MAX_NAME_LEN);
+	b->pkt_size = pkt_size;
+	b->count = pkts;
+	b->intents = i == LBBENCH_ONDEMAND ? 0 : intents;
+	b->mode = i;
+	b->status = glink_lbbench_run(b);
+	mutex_unlock(&b->lock);
+
+	return count;
+}
+
+static const struct file_operations glink_lbbench_run_fops = {
+	.open		= simple_open,
+	.write		= glink_lbbench_run_write,
+};
+
+static void glink_lbbench_init_ch(struct lbbench_ch *ch)
+{
+	init_completion(&ch->connected);
+	init_completion(&ch->disconnected);
+	init_completion(&ch->rx);
+	init_completion(&ch->tx_done);
+	INIT_WORK(&ch->intent_work, glink_lbbench_intent_worker);
+}
+
+static int __init glink_loopback_bench_init(void)
+{
+	struct dentry *dir;
+
+	mutex_init(&lbbench.lock);
+	glink_lbbench_init_ch(&lbbench.ctl);
+	glink_lbbench_init_ch(&lbbench.data);
+
+	dir = debugfs_create_dir("glink_lbbench", NULL);
+	if (IS_ERR_OR_NULL(dir))
+		return 0;
+
+	debugfs_create_file("run", 0200, dir, &lbbench,
+			    &glink_lbbench_run_fops);
+	debugfs_create_file("results", 0444, dir, &lbbench,
+			    &glink_lbbench_results_fops);
+
+	return 0;
+}
+
+module_init(glink_loopback_bench_init);
+
+MODULE_DESCRIPTION("MSM Generic Link (G-Link) Loopback Benchmark Client");
+MODULE_LICENSE("GPL v2");
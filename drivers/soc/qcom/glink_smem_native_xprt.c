@@ -13,6 +13,7 @@
 #include <linux/err.h>
 #include <linux/fs.h>
 #include <linux/gfp.h>
+#include <linux/hrtimer.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/ipc_logging.h>
@@ -32,6 +33,7 @@
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/srcu.h>
+#include <linux/vmalloc.h>
 #include <linux/wait.h>
 #include <linux/cpumask.h>
 #include <soc/qcom/smem.h>
@@ -53,6 +55,7 @@
 #define RPM_FIFO_ADDR_ALIGN_BYTES 3
 #define TRACER_PKT_FEATURE BIT(2)
 #define DEFERRED_CMDS_THRESHOLD 25
+#define RX_VMALLOC_INTENT_MIN SZ_32K
 #define NUM_LOG_PAGES	4
 
 /**
@@ -191,6 +194,19 @@ struct mailbox_config_info {
  *				index position represents a power state.
  * @mailbox:			Mailbox transport channel description reference.
  * @log_ctx:			Pointer to log context.
+ * @tx_batch_us:		Time a data doorbell may be held back so that
+ *				back to back packets share one interrupt, 0 to
+ *				signal every write.
+ * @tx_batch_timer:		Raises the held back doorbell.
+ * @tx_irq_pending:		Data was written without signaling the remote.
+ *				Protected by @write_lock.
+ * @tx_irq_batched:		Number of doorbells saved by tx batching.
+ * @rx_coalesce_us:		Window after an rx interrupt during which
+ *				further interrupts are only acknowledged and the
+ *				fifo is drained once at the end, 0 to disable.
+ * @rx_coalesce_timer:		Drains the fifo at the end of the window.
+ * @rx_coalescing:		An rx coalescing window is open.
+ * @rx_irq_coalesced:		Number of rx interrupts folded into a window.
  */
 struct edge_info {
 	struct glink_transport_if xprt_if;
@@ -232,6 +248,14 @@ struct edge_info {
 	unsigned long *ramp_time_us;
 	struct mailbox_config_info *mailbox;
 	void *log_ctx;
+	uint32_t tx_batch_us;
+	struct hrtimer tx_batch_timer;
+	bool tx_irq_pending;
+	uint32_t tx_irq_batched;
+	uint32_t rx_coalesce_us;
+	struct hrtimer rx_coalesce_timer;
+	bool rx_coalescing;
+	uint32_t rx_irq_coalesced;
 };
 
 /**
@@ -301,6 +325,7 @@ static void send_irq(struct edge_info *einfo)
 	if (einfo->remote_proc_id != SMEM_SPSS)
 		writel_relaxed(0, einfo->out_irq_reg);
 	einfo->tx_irq_count++;
+	einfo->tx_irq_pending = false;
 }
 
 /**
@@ -567,6 +592,54 @@ static int fifo_write_body(struct edge_info *einfo, const void *_data,
 	return len;
 }
 
+/**
+ * send_irq_batched() - signal the remote of new data, batching doorbells
+ * @einfo:	The edge the data was written to.
+ *
+ * With tx batching enabled the doorbell for a data write is held back for up
+ * to @einfo->tx_batch_us, so the packets the glink core scheduler writes back
+ * to back are announced by a single interrupt.  Once half of the fifo is in
+ * use the doorbell is raised right away so the remote never sits on a filling
+ * fifo.  Called with the write_lock held.
+ */
+static void send_irq_batched(struct edge_info *einfo)
+{
+	if (!einfo->tx_batch_us ||
+	    fifo_write_avail(einfo) < einfo->tx_fifo_size / 2) {
+		send_irq(einfo);
+		return;
+	}
+
+	if (einfo->tx_irq_pending) {
+		einfo->tx_irq_batched++;
+		return;
+	}
+	einfo->tx_irq_pending = true;
+	hrtimer_start(&einfo->tx_batch_timer,
+		      ns_to_ktime((u64)einfo->tx_batch_us * NSEC_PER_USEC),
+		      HRTIMER_MODE_REL);
+}
+
+/**
+ * tx_batch_timer_fn() - raise a doorbell held back by send_irq_batched()
+ * @timer:	The tx batch timer of the edge.
+ *
+ * Return: HRTIMER_NORESTART.
+ */
+static enum hrtimer_restart tx_batch_timer_fn(struct hrtimer *timer)
+{
+	struct edge_info *einfo = container_of(timer, struct edge_info,
+					       tx_batch_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&einfo->write_lock, flags);
+	if (einfo->tx_irq_pending && !einfo->in_ssr)
+		send_irq(einfo);
+	spin_unlock_irqrestore(&einfo->write_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
 /**
  * fifo_write() - Write data into an edge
  * @einfo:	The concerned edge to write to.
@@ -615,6 +688,7 @@ static int fifo_write(struct edge_info *einfo, const void *data, int len)
  * This prevents the tx() usecase from calling fifo_write() multiple times.  The
  * alternative would be an allocation and additional memcpy to create a buffer
  * to copy all the data segments into one location before calling fifo_write().
+ * The doorbell for the write is subject to tx batching.
  *
  * Return: Number of bytes written to the edge.
  */
@@ -642,7 +716,7 @@ static int fifo_write_complex(struct edge_info *einfo,
 	 */
 	wmb();
 	einfo->tx_ch_desc->write_index = write_index;
-	send_irq(einfo);
+	send_irq_batched(einfo);
 
 	return orig_len - len1 - len2 - len3;
 }
@@ -1294,12 +1368,56 @@ irqreturn_t irq_handler(int irq, void *priv)
 	if (einfo->rx_reset_reg)
 		writel_relaxed(einfo->out_irq_mask, einfo->rx_reset_reg);
 
+	/*
+	 * The line may be shared, so rather than masking it the interrupts
+	 * that arrive while a coalescing window is open are only acknowledged
+	 * and the fifo is drained once when the window closes.
+	 */
+	if (irq && einfo->rx_coalesce_us) {
+		if (xchg(&einfo->rx_coalescing, true)) {
+			einfo->rx_irq_coalesced++;
+			einfo->rx_irq_count++;
+			return IRQ_HANDLED;
+		}
+		hrtimer_start(&einfo->rx_coalesce_timer,
+			ns_to_ktime((u64)einfo->rx_coalesce_us * NSEC_PER_USEC),
+			HRTIMER_MODE_REL);
+	}
+
 	__rx_worker(einfo, true);
 	einfo->rx_irq_count++;
 
 	return IRQ_HANDLED;
 }
 
+/**
+ * rx_coalesce_timer_fn() - close an rx coalescing window
+ * @timer:	The rx coalescing timer of the edge.
+ *
+ * Drains what arrived during the window.  If there was anything the window is
+ * kept open for another period, as the remote is likely still sending.
+ *
+ * Return: HRTIMER_RESTART to extend the window, HRTIMER_NORESTART otherwise.
+ */
+static enum hrtimer_restart rx_coalesce_timer_fn(struct hrtimer *timer)
+{
+	struct edge_info *einfo = container_of(timer, struct edge_info,
+					       rx_coalesce_timer);
+
+	/* pairs with the xchg() in irq_handler() */
+	WRITE_ONCE(einfo->rx_coalescing, false);
+	smp_mb();
+	if (einfo->in_ssr || !fifo_read_avail(einfo) ||
+	    xchg(&einfo->rx_coalescing, true))
+		return HRTIMER_NORESTART;
+
+	__rx_worker(einfo, true);
+	hrtimer_forward_now(timer,
+		ns_to_ktime((u64)einfo->rx_coalesce_us * NSEC_PER_USEC));
+
+	return HRTIMER_RESTART;
+}
+
 /**
  * tx_cmd_version() - convert a version cmd to wire format and transmit
  * @if_ptr:	The transport to transmit on.
@@ -1615,6 +1733,11 @@ static int ssr(struct glink_transport_if *if_ptr)
 
 	synchronize_srcu(&einfo->use_ref);
 
+	hrtimer_cancel(&einfo->tx_batch_timer);
+	einfo->tx_irq_pending = false;
+	hrtimer_cancel(&einfo->rx_coalesce_timer);
+	einfo->rx_coalescing = false;
+
 	while (!list_empty(&einfo->deferred_cmds)) {
 		cmd = list_first_entry(&einfo->deferred_cmds,
 						struct deferred_cmd, list_node);
@@ -1667,6 +1790,10 @@ int wait_link_down(struct glink_transport_if *if_ptr)
  * Note that returning NULL for the pointer is valid (it means that space has
  * been reserved, but the actual pointer will be provided later).
  *
+ * Large intents, as queued by bulk channels, are built from order-0 pages
+ * instead of one high order allocation.  Either way a physical buffer
+ * provider is set so vector clients can hand the pages on without copying.
+ *
  * Return: 0 on success or standard Linux error code.
  */
 static int allocate_rx_intent(struct glink_transport_if *if_ptr, size_t size,
@@ -1674,14 +1801,17 @@ static int allocate_rx_intent(struct glink_transport_if *if_ptr, size_t size,
 {
 	void *t;
 
-	t = kmalloc(size, GFP_KERNEL);
+	if (size >= RX_VMALLOC_INTENT_MIN)
+		t = vmalloc(size);
+	else
+		t = kmalloc(size, GFP_KERNEL);
 	if (!t)
 		return -ENOMEM;
 
 	intent->data = t;
 	intent->iovec = (void *)intent;
 	intent->vprovider = rx_linear_vbuf_provider;
-	intent->pprovider = NULL;
+	intent->pprovider = rx_linear_pbuf_provider;
 	return 0;
 }
 
@@ -1698,10 +1828,11 @@ static int deallocate_rx_intent(struct glink_transport_if *if_ptr,
 	if (!intent || !intent->data)
 		return -EINVAL;
 
-	kfree(intent->data);
+	kvfree(intent->data);
 	intent->data = NULL;
 	intent->iovec = NULL;
 	intent->vprovider = NULL;
+	intent->pprovider = NULL;
 	return 0;
 }
 
@@ -2324,6 +2455,28 @@ static void init_xprt_cfg(struct edge_info *einfo, const char *name)
 	einfo->xprt_cfg.max_iid = SZ_2G;
 }
 
+/**
+ * init_irq_coalescing() - set up tx doorbell batching and rx irq coalescing
+ * @einfo:	The edge to initialize.
+ * @node:	Device tree node of the edge.
+ *
+ * Both stay disabled unless "qcom,tx-batch-us" or "qcom,rx-coalesce-us" give
+ * the batching window for the edge in microseconds.
+ */
+static void init_irq_coalescing(struct edge_info *einfo,
+				struct device_node *node)
+{
+	hrtimer_init(&einfo->tx_batch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	einfo->tx_batch_timer.function = tx_batch_timer_fn;
+	hrtimer_init(&einfo->rx_coalesce_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	einfo->rx_coalesce_timer.function = rx_coalesce_timer_fn;
+
+	of_property_read_u32(node, "qcom,tx-batch-us", &einfo->tx_batch_us);
+	of_property_read_u32(node, "qcom,rx-coalesce-us",
+			     &einfo->rx_coalesce_us);
+}
+
 /**
  * parse_qos_dt_params() - Parse the power states from DT
  * @dev:	Reference to the platform device for a specific edge.
@@ -2495,6 +2648,7 @@ static int glink_smem_native_probe(struct platform_device *pdev)
 	init_xprt_if(einfo);
 	spin_lock_init(&einfo->write_lock);
 	init_waitqueue_head(&einfo->tx_blocked_queue);
+	init_irq_coalescing(einfo, node);
 	kthread_init_work(&einfo->kwork, rx_worker);
 	kthread_init_worker(&einfo->kworker);
 	einfo->read_from_fifo = read_from_fifo;
@@ -2707,6 +2861,7 @@ static int glink_rpm_native_probe(struct platform_device *pdev)
 	init_xprt_if(einfo);
 	spin_lock_init(&einfo->write_lock);
 	init_waitqueue_head(&einfo->tx_blocked_queue);
+	init_irq_coalescing(einfo, node);
 	kthread_init_work(&einfo->kwork, rx_worker);
 	kthread_init_worker(&einfo->kworker);
 	einfo->intentless = true;
@@ -3006,6 +3161,7 @@ static int glink_mailbox_probe(struct platform_device *pdev)
 	init_xprt_if(einfo);
 	spin_lock_init(&einfo->write_lock);
 	init_waitqueue_head(&einfo->tx_blocked_queue);
+	init_irq_coalescing(einfo, node);
 	kthread_init_work(&einfo->kwork, rx_worker);
 	kthread_init_worker(&einfo->kworker);
 	einfo->read_from_fifo = read_from_fifo;
@@ -3179,9 +3335,9 @@ ID|EDGE      |TX READ   |TX WRITE  |TX SIZE   |RX READ   |RX WRITE  |RX SIZE
 01|mpss      |0x00000128|0x00000128|0x00000800|0x00000256|0x00000256|0x00001000
  *
  * Interrupt information:
- * EDGE      |TX INT    |RX INT
- * --------------------------------
- * mpss      |0x00000006|0x00000008
+ * EDGE      |TX INT    |RX INT    |TX BATCHED|RX COALESC
+ * ------------------------------------------------------
+ * mpss      |0x00000006|0x00000008|0x00000002|0x00000003
  */
 	seq_puts(s, "TX/RX fifo information:\n");
 	seq_printf(s, "%2s|%-10s|%-10s|%-10s|%-10s|%-10s|%-10s|%-10s\n",
@@ -3212,11 +3368,15 @@ ID|EDGE      |TX READ   |TX WRITE  |TX SIZE   |RX READ   |RX WRITE  |RX SIZE
 						einfo->rx_fifo_size);
 
 	seq_puts(s, "\nInterrupt information:\n");
-	seq_printf(s, "%-10s|%-10s|%-10s\n", "EDGE", "TX INT", "RX INT");
-	seq_puts(s, "--------------------------------\n");
-	seq_printf(s, "%-10s|0x%08X|0x%08X\n", einfo->xprt_cfg.edge,
+	seq_printf(s, "%-10s|%-10s|%-10s|%-10s|%-10s\n", "EDGE", "TX INT",
+					"RX INT", "TX BATCHED", "RX COALESC");
+	seq_puts(s, "------------------------------------------------------\n");
+	seq_printf(s, "%-10s|0x%08X|0x%08X|0x%08X|0x%08X\n",
+						einfo->xprt_cfg.edge,
 						einfo->tx_irq_count,
-						einfo->rx_irq_count);
+						einfo->rx_irq_count,
+						einfo->tx_irq_batched,
+						einfo->rx_irq_coalesced);
 }
 
 /**
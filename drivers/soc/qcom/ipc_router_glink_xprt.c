@@ -326,6 +326,11 @@ static bool ipc_router_glink_xprt_latency_info(struct msm_ipc_router_xprt *xprt)
 	return glink_xprtp->low_latency_xprt;
 }
 
+/*
+ * The whole packet is copied into one linear skb sized from the intent:
+ * the router core then handles a single fragment, and a packet spread over
+ * several glink buffers costs one allocation instead of one per buffer.
+ */
 static struct rr_packet *glink_xprt_copy_data(struct read_work *rx_work)
 {
 	void *buf, *pbuf, *dest_buf;
@@ -339,6 +344,14 @@ static struct rr_packet *glink_xprt_copy_data(struct read_work *rx_work)
 		return NULL;
 	}
 
+	skb = alloc_skb(rx_work->iovec_size, GFP_KERNEL);
+	if (!skb) {
+		IPC_RTR_ERR("%s: Couldn't alloc skb of size %zu\n",
+			    __func__, rx_work->iovec_size);
+		release_pkt(pkt);
+		return NULL;
+	}
+
 	do {
 		buf_size = 0;
 		if (rx_work->vbuf_provider) {
@@ -352,18 +365,18 @@ static struct rr_packet *glink_xprt_copy_data(struct read_work *rx_work)
 		if (!buf_size || !buf)
 			break;
 
-		skb = alloc_skb(buf_size, GFP_KERNEL);
-		if (!skb) {
-			IPC_RTR_ERR("%s: Couldn't alloc skb of size %zu\n",
-				    __func__, buf_size);
+		if (buf_size > skb_tailroom(skb)) {
+			IPC_RTR_ERR("%s: %zu bytes past the %zu byte intent\n",
+				    __func__, buf_size, rx_work->iovec_size);
+			kfree_skb(skb);
 			release_pkt(pkt);
 			return NULL;
 		}
 		dest_buf = skb_put(skb, buf_size);
 		memcpy(dest_buf, buf, buf_size);
-		skb_queue_tail(pkt->pkt_fragment_q, skb);
 		pkt->length += buf_size;
 	} while (buf && buf_size);
+	skb_queue_tail(pkt->pkt_fragment_q, skb);
 	return pkt;
 }
 
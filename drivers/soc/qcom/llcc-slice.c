@@ -25,6 +25,7 @@
 #include <linux/err.h>
 #include <linux/mfd/syscon.h>
 #include <linux/regmap.h>
+#include <linux/workqueue.h>
 #include <linux/soc/qcom/llcc-qcom.h>
 
 #define ACTIVATE                      0x1
@@ -54,12 +55,49 @@
 #define LLCC_TRP_ATTR0_CFGn(n) (0x21000 + 0x8 * n)
 #define LLCC_TRP_ATTR1_CFGn(n) (0x21004 + 0x8 * n)
 
+#define LLCC_POLICY_MIN_CAP_DIV	4
+#define LLCC_POLICY_STEP_DIV	8
+
+/**
+ * Runtime sizing state of a slice managed by the policy engine
+ * @cfg: SCT entry of the slice
+ * @port: perfmon port the slice's traffic is counted on
+ * @access_ev: perfmon event counting accesses of the slice
+ * @miss_ev: perfmon event counting misses of the slice
+ * @cur_cap: currently programmed max capacity in KB
+ * @prev_access: access count at the previous evaluation
+ * @prev_miss: miss count at the previous evaluation
+ * @miss_pct: miss ratio seen in the last evaluation window
+ * @idle: number of consecutive windows without accesses
+ * @parked: slice was deactivated by the policy while a client holds it
+ */
+struct llcc_policy_slice {
+	const struct llcc_slice_config *cfg;
+	u32 port;
+	u32 access_ev;
+	u32 miss_ev;
+	u32 cur_cap;
+	u64 prev_access;
+	u64 prev_miss;
+	unsigned int miss_pct;
+	unsigned int idle;
+	bool parked;
+};
+
 /**
  * Driver data for llcc
  * @llcc_virt_base: base address for llcc controller
  * @slice_data: pointer to llcc slice config data
  * @sz: Size of the config data table
  * @llcc_slice_map: Bit map to track the active slice ids
+ * @client_slice_map: Bit map to track the slice ids activated by clients
+ * @policy: slices managed by the runtime sizing policy
+ * @policy_cnt: number of entries in @policy
+ * @policy_work: periodic evaluation of the managed slices
+ * @policy_ms: evaluation period, 0 disables the policy
+ * @grow_miss_pct: miss ratio above which a slice is grown
+ * @shrink_miss_pct: miss ratio below which a slice is shrunk
+ * @idle_windows: idle windows after which a slice is parked
  */
 struct llcc_drv_data {
 	struct regmap *llcc_map;
@@ -70,6 +108,14 @@ struct llcc_drv_data {
 	u32 b_off;
 	u32 no_banks;
 	unsigned long *llcc_slice_map;
+	unsigned long *client_slice_map;
+	struct llcc_policy_slice *policy;
+	u32 policy_cnt;
+	struct delayed_work policy_work;
+	unsigned int policy_ms;
+	unsigned int grow_miss_pct;
+	unsigned int shrink_miss_pct;
+	unsigned int idle_windows;
 };
 
 /* Get the slice entry by index */
@@ -229,6 +275,7 @@ int llcc_slice_activate(struct llcc_slice_desc *desc)
 	}
 
 	mutex_lock(&drv->slice_mutex);
+	__set_bit(desc->llcc_slice_id, drv->client_slice_map);
 	if (test_bit(desc->llcc_slice_id, drv->llcc_slice_map)) {
 		mutex_unlock(&drv->slice_mutex);
 		return 0;
@@ -272,6 +319,7 @@ int llcc_slice_deactivate(struct llcc_slice_desc *desc)
 	}
 
 	mutex_lock(&drv->slice_mutex);
+	__clear_bit(desc->llcc_slice_id, drv->client_slice_map);
 	if (!test_bit(desc->llcc_slice_id, drv->llcc_slice_map)) {
 		mutex_unlock(&drv->slice_mutex);
 		return 0;
@@ -321,6 +369,32 @@ size_t llcc_get_slice_size(struct llcc_slice_desc *desc)
 }
 EXPORT_SYMBOL(llcc_get_slice_size);
 
+static u32 llcc_attr1_val(struct llcc_drv_data *drv,
+			  const struct llcc_slice_config *cfg, u32 max_cap)
+{
+	u32 attr1_val;
+	u32 max_cap_cacheline;
+
+	attr1_val = cfg->cache_mode;
+	attr1_val |= (cfg->probe_target_ways << ATTR1_PROBE_TARGET_WAYS_SHIFT);
+	attr1_val |= (cfg->fixed_size << ATTR1_FIXED_SIZE_SHIFT);
+	attr1_val |= (cfg->priority << ATTR1_PRIORITY_SHIFT);
+
+	max_cap_cacheline = MAX_CAP_TO_BYTES(max_cap);
+
+	/* LLCC instances can vary for each target.
+	 * The SW writes to broadcast register which gets propagated
+	 * to each llcc instace (llcc0,.. llccN).
+	 * Since the size of the memory is divided equally amongst the
+	 * llcc instances, we need to configure the max cap accordingly.
+	 */
+	max_cap_cacheline = (max_cap_cacheline / drv->no_banks);
+	max_cap_cacheline >>= CACHE_LINE_SIZE_SHIFT;
+	attr1_val |= (max_cap_cacheline << ATTR1_MAX_CAP_SHIFT);
+
+	return attr1_val;
+}
+
 static void qcom_llcc_cfg_program(struct platform_device *pdev)
 {
 	int i;
@@ -328,7 +402,6 @@ static void qcom_llcc_cfg_program(struct platform_device *pdev)
 	u32 attr0_cfg;
 	u32 attr1_val;
 	u32 attr0_val;
-	u32 max_cap_cacheline;
 	u32 sz;
 	const struct llcc_slice_config *llcc_table;
 	struct llcc_drv_data *drv = platform_get_drvdata(pdev);
@@ -342,24 +415,8 @@ static void qcom_llcc_cfg_program(struct platform_device *pdev)
 		attr1_cfg = b_off + LLCC_TRP_ATTR1_CFGn(llcc_table[i].slice_id);
 		attr0_cfg = b_off + LLCC_TRP_ATTR0_CFGn(llcc_table[i].slice_id);
 
-		attr1_val = llcc_table[i].cache_mode;
-		attr1_val |= (llcc_table[i].probe_target_ways <<
-				ATTR1_PROBE_TARGET_WAYS_SHIFT);
-		attr1_val |= (llcc_table[i].fixed_size <<
-				ATTR1_FIXED_SIZE_SHIFT);
-		attr1_val |= (llcc_table[i].priority << ATTR1_PRIORITY_SHIFT);
-
-		max_cap_cacheline = MAX_CAP_TO_BYTES(llcc_table[i].max_cap);
-
-		/* LLCC instances can vary for each target.
-		 * The SW writes to broadcast register which gets propagated
-		 * to each llcc instace (llcc0,.. llccN).
-		 * Since the size of the memory is divided equally amongst the
-		 * llcc instances, we need to configure the max cap accordingly.
-		 */
-		max_cap_cacheline = (max_cap_cacheline / drv->no_banks);
-		max_cap_cacheline >>= CACHE_LINE_SIZE_SHIFT;
-		attr1_val |= (max_cap_cacheline << ATTR1_MAX_CAP_SHIFT);
+		attr1_val = llcc_attr1_val(drv, &llcc_table[i],
+					   llcc_table[i].max_cap);
 
 		attr0_val = llcc_table[i].res_ways & ATTR0_RES_WAYS_MASK;
 		attr0_val |= llcc_table[i].bonus_ways << ATR0_BONUS_WAYS_SHIFT;
@@ -381,6 +438,315 @@ static void qcom_llcc_cfg_program(struct platform_device *pdev)
 	}
 }
 
+static void llcc_policy_set_cap(struct llcc_drv_data *drv,
+				struct llcc_policy_slice *ps, u32 cap)
+{
+	u32 attr1_cfg = drv->b_off + LLCC_TRP_ATTR1_CFGn(ps->cfg->slice_id);
+
+	regmap_write(drv->llcc_map, attr1_cfg,
+		     llcc_attr1_val(drv, ps->cfg, cap));
+	ps->cur_cap = cap;
+}
+
+static void llcc_policy_park(struct llcc_drv_data *drv,
+			     struct llcc_policy_slice *ps, bool park)
+{
+	u32 sid = ps->cfg->slice_id;
+	u32 act_ctrl_val;
+	int rc;
+
+	if (park) {
+		if (!test_bit(sid, drv->llcc_slice_map))
+			return;
+		act_ctrl_val = ACT_CTRL_OPCODE_DEACTIVATE <<
+				ACT_CTRL_OPCODE_SHIFT;
+		act_ctrl_val |= ACT_CTRL_ACT_TRIG;
+		rc = llcc_update_act_ctrl(drv, sid, act_ctrl_val, ACTIVATE);
+		__clear_bit(sid, drv->llcc_slice_map);
+		ps->parked = true;
+	} else {
+		ps->parked = false;
+		/* The client may have let go of the slice meanwhile */
+		if (!test_bit(sid, drv->client_slice_map) ||
+		    test_bit(sid, drv->llcc_slice_map))
+			return;
+		act_ctrl_val = ACT_CTRL_OPCODE_ACTIVATE <<
+				ACT_CTRL_OPCODE_SHIFT;
+		act_ctrl_val |= ACT_CTRL_ACT_TRIG;
+		rc = llcc_update_act_ctrl(drv, sid, act_ctrl_val, DEACTIVATE);
+		__set_bit(sid, drv->llcc_slice_map);
+	}
+
+	if (rc)
+		pr_err("%s slice id: %d timed out\n",
+		       park ? "park" : "unpark", sid);
+}
+
+/*
+ * Each managed slice is sized between a quarter and all of its SCT
+ * capacity: a slice that keeps missing grows back towards its SCT size,
+ * one that hardly misses gives capacity back to the shared ways. Slices
+ * without any traffic for idle_windows periods are deactivated until
+ * their client touches them again.
+ */
+static void llcc_policy_eval(struct llcc_drv_data *drv,
+			     struct llcc_policy_slice *ps)
+{
+	u64 access, miss, d_access, d_miss;
+	u32 max_cap = ps->cfg->max_cap;
+	u32 min_cap = max_cap / LLCC_POLICY_MIN_CAP_DIV;
+	u32 step = max(max_cap / LLCC_POLICY_STEP_DIV, 1U);
+	u32 cap = ps->cur_cap;
+
+	if (llcc_perfmon_event_count(ps->port, ps->access_ev, &access) ||
+	    llcc_perfmon_event_count(ps->port, ps->miss_ev, &miss))
+		return;
+
+	/* Counters were reconfigured underneath us */
+	if (access < ps->prev_access || miss < ps->prev_miss) {
+		ps->prev_access = access;
+		ps->prev_miss = miss;
+		return;
+	}
+
+	d_access = access - ps->prev_access;
+	d_miss = min(miss - ps->prev_miss, d_access);
+	ps->prev_access = access;
+	ps->prev_miss = miss;
+
+	mutex_lock(&drv->slice_mutex);
+	if (!d_access) {
+		ps->miss_pct = 0;
+		if (ps->idle < drv->idle_windows)
+			ps->idle++;
+		if (drv->idle_windows && ps->idle >= drv->idle_windows &&
+		    !ps->parked)
+			llcc_policy_park(drv, ps, true);
+		goto out;
+	}
+
+	ps->idle = 0;
+	if (ps->parked)
+		llcc_policy_park(drv, ps, false);
+
+	ps->miss_pct = div64_u64(d_miss * 100, d_access);
+	if (ps->miss_pct > drv->grow_miss_pct)
+		cap = min(cap + step, max_cap);
+	else if (ps->miss_pct < drv->shrink_miss_pct)
+		cap = max(cap - min(cap, step), min_cap);
+
+	if (cap != ps->cur_cap)
+		llcc_policy_set_cap(drv, ps, cap);
+out:
+	mutex_unlock(&drv->slice_mutex);
+}
+
+static void llcc_policy_work(struct work_struct *work)
+{
+	struct llcc_drv_data *drv = container_of(to_delayed_work(work),
+					struct llcc_drv_data, policy_work);
+	unsigned int policy_ms = READ_ONCE(drv->policy_ms);
+	u32 i;
+
+	if (!policy_ms)
+		return;
+
+	for (i = 0; i < drv->policy_cnt; i++)
+		llcc_policy_eval(drv, &drv->policy[i]);
+
+	schedule_delayed_work(&drv->policy_work, msecs_to_jiffies(policy_ms));
+}
+
+/* Put every managed slice back to its SCT size and client state */
+static void llcc_policy_restore(struct llcc_drv_data *drv)
+{
+	struct llcc_policy_slice *ps;
+	u32 i;
+
+	mutex_lock(&drv->slice_mutex);
+	for (i = 0; i < drv->policy_cnt; i++) {
+		ps = &drv->policy[i];
+		if (ps->parked)
+			llcc_policy_park(drv, ps, false);
+		if (ps->cur_cap != ps->cfg->max_cap)
+			llcc_policy_set_cap(drv, ps, ps->cfg->max_cap);
+		ps->idle = 0;
+		ps->miss_pct = 0;
+	}
+	mutex_unlock(&drv->slice_mutex);
+}
+
+#define llcc_policy_attr(name, _max)					\
+static ssize_t name##_show(struct device *dev,				\
+		struct device_attribute *attr, char *buf)		\
+{									\
+	struct llcc_drv_data *drv = dev_get_drvdata(dev);		\
+									\
+	return snprintf(buf, PAGE_SIZE, "%u\n", drv->name);		\
+}									\
+static ssize_t name##_store(struct device *dev,				\
+		struct device_attribute *attr, const char *buf,		\
+		size_t count)						\
+{									\
+	struct llcc_drv_data *drv = dev_get_drvdata(dev);		\
+	unsigned int val;						\
+	int ret;							\
+									\
+	ret = kstrtouint(buf, 10, &val);				\
+	if (ret)							\
+		return ret;						\
+	drv->name = min(val, (unsigned int)(_max));			\
+	return count;							\
+}									\
+static DEVICE_ATTR_RW(name)
+
+llcc_policy_attr(grow_miss_pct, 100);
+llcc_policy_attr(shrink_miss_pct, 100);
+llcc_policy_attr(idle_windows, 1000);
+
+static ssize_t policy_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_drv_data *drv = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", drv->policy_ms);
+}
+
+static ssize_t policy_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct llcc_drv_data *drv = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &val);
+	if (ret)
+		return ret;
+
+	if (val && val < 10)
+		val = 10;
+
+	cancel_delayed_work_sync(&drv->policy_work);
+	WRITE_ONCE(drv->policy_ms, val);
+	if (val)
+		schedule_delayed_work(&drv->policy_work,
+				      msecs_to_jiffies(val));
+	else
+		llcc_policy_restore(drv);
+
+	return count;
+}
+static DEVICE_ATTR_RW(policy_ms);
+
+static ssize_t policy_status_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_drv_data *drv = dev_get_drvdata(dev);
+	struct llcc_policy_slice *ps;
+	ssize_t cnt = 0;
+	u32 i;
+
+	mutex_lock(&drv->slice_mutex);
+	for (i = 0; i < drv->policy_cnt; i++) {
+		ps = &drv->policy[i];
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				 "%-12s sid %2d cap %5u/%5u KB miss %3u%% %s\n",
+				 ps->cfg->name, ps->cfg->slice_id,
+				 ps->cur_cap, ps->cfg->max_cap, ps->miss_pct,
+				 ps->parked ? "parked" :
+				 test_bit(ps->cfg->slice_id,
+					  drv->llcc_slice_map) ?
+				 "active" : "inactive");
+	}
+	mutex_unlock(&drv->slice_mutex);
+
+	return cnt;
+}
+static DEVICE_ATTR_RO(policy_status);
+
+static struct attribute *llcc_policy_attrs[] = {
+	&dev_attr_policy_ms.attr,
+	&dev_attr_grow_miss_pct.attr,
+	&dev_attr_shrink_miss_pct.attr,
+	&dev_attr_idle_windows.attr,
+	&dev_attr_policy_status.attr,
+	NULL,
+};
+
+static struct attribute_group llcc_policy_group = {
+	.name = "policy",
+	.attrs = llcc_policy_attrs,
+};
+
+/*
+ * The slices to manage come from "qcom,llcc-policy-slices", a list of
+ * <slice-id perfmon-port access-event miss-event> tuples. The perfmon
+ * counters (with an SCID filter for the slice) are configured through
+ * the perfmon sysfs interface; until they are, the slice keeps its SCT
+ * size.
+ */
+static int llcc_policy_init(struct platform_device *pdev)
+{
+	struct llcc_drv_data *drv = platform_get_drvdata(pdev);
+	struct device_node *np = pdev->dev.of_node;
+	struct llcc_policy_slice *ps;
+	u32 i, j, ntuples, tuple[4];
+	int len;
+
+	INIT_DELAYED_WORK(&drv->policy_work, llcc_policy_work);
+	drv->grow_miss_pct = 30;
+	drv->shrink_miss_pct = 5;
+	drv->idle_windows = 10;
+
+	if (!of_find_property(np, "qcom,llcc-policy-slices", &len))
+		return 0;
+
+	ntuples = len / sizeof(tuple);
+	if (!ntuples || len % sizeof(tuple)) {
+		dev_err(&pdev->dev, "Invalid qcom,llcc-policy-slices entry\n");
+		return -EINVAL;
+	}
+
+	drv->policy = devm_kcalloc(&pdev->dev, ntuples, sizeof(*drv->policy),
+				   GFP_KERNEL);
+	if (!drv->policy)
+		return -ENOMEM;
+
+	for (i = 0; i < ntuples; i++) {
+		if (of_property_read_u32_index(np, "qcom,llcc-policy-slices",
+					       i * 4, &tuple[0]) ||
+		    of_property_read_u32_index(np, "qcom,llcc-policy-slices",
+					       i * 4 + 1, &tuple[1]) ||
+		    of_property_read_u32_index(np, "qcom,llcc-policy-slices",
+					       i * 4 + 2, &tuple[2]) ||
+		    of_property_read_u32_index(np, "qcom,llcc-policy-slices",
+					       i * 4 + 3, &tuple[3]))
+			return -EINVAL;
+
+		for (j = 0; j < drv->llcc_config_data_sz; j++)
+			if (drv->slice_data[j].slice_id == tuple[0])
+				break;
+		if (j == drv->llcc_config_data_sz ||
+		    drv->slice_data[j].fixed_size) {
+			dev_warn(&pdev->dev, "slice %u can't be resized\n",
+				 tuple[0]);
+			continue;
+		}
+
+		ps = &drv->policy[drv->policy_cnt++];
+		ps->cfg = &drv->slice_data[j];
+		ps->port = tuple[1];
+		ps->access_ev = tuple[2];
+		ps->miss_ev = tuple[3];
+		ps->cur_cap = ps->cfg->max_cap;
+	}
+
+	if (!drv->policy_cnt)
+		return 0;
+
+	return sysfs_create_group(&pdev->dev.kobj, &llcc_policy_group);
+}
+
 int qcom_llcc_probe(struct platform_device *pdev,
 		      const struct llcc_slice_config *llcc_cfg, u32 sz)
 {
@@ -428,6 +794,15 @@ int qcom_llcc_probe(struct platform_device *pdev,
 		return PTR_ERR(drv_data->llcc_slice_map);
 	}
 
+	drv_data->client_slice_map = devm_kcalloc(dev,
+				   BITS_TO_LONGS(drv_data->max_slices),
+				   sizeof(unsigned long), GFP_KERNEL);
+	if (!drv_data->client_slice_map) {
+		kfree(drv_data->llcc_slice_map);
+		devm_kfree(&pdev->dev, drv_data);
+		return -ENOMEM;
+	}
+
 	bitmap_zero(drv_data->llcc_slice_map, drv_data->max_slices);
 	drv_data->slice_data = llcc_cfg;
 	drv_data->llcc_config_data_sz = sz;
@@ -436,7 +811,11 @@ int qcom_llcc_probe(struct platform_device *pdev,
 
 	qcom_llcc_cfg_program(pdev);
 
-	return rc;
+	rc = llcc_policy_init(pdev);
+	if (rc)
+		dev_err(&pdev->dev, "llcc slice policy disabled (%d)\n", rc);
+
+	return 0;
 }
 EXPORT_SYMBOL(qcom_llcc_probe);
 
@@ -446,6 +825,13 @@ int qcom_llcc_remove(struct platform_device *pdev)
 
 	drv_data = platform_get_drvdata(pdev);
 
+	if (drv_data->policy_cnt) {
+		sysfs_remove_group(&pdev->dev.kobj, &llcc_policy_group);
+		cancel_delayed_work_sync(&drv_data->policy_work);
+		drv_data->policy_ms = 0;
+		llcc_policy_restore(drv_data);
+	}
+
 	mutex_destroy(&drv_data->slice_mutex);
 	kfree(drv_data->llcc_slice_map);
 	devm_kfree(&pdev->dev, drv_data);
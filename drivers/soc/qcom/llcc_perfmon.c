@@ -41,11 +41,14 @@
  * @port_sel:		Port selected for configured counter
  * @event_sel:		Event selected for configured counter
  * @counter_dump:	Cumulative counter dump
+ * @counter_total:	Cumulative count since configuration, not cleared
+ *			on read
  */
 struct llcc_perfmon_counter_map {
 	unsigned int port_sel;
 	unsigned int event_sel;
 	unsigned long long counter_dump;
+	unsigned long long counter_total;
 };
 
 struct llcc_perfmon_private;
@@ -96,6 +99,8 @@ struct llcc_perfmon_private {
 	ktime_t expires;
 };
 
+static struct llcc_perfmon_private *llcc_perfmon_priv;
+
 static inline void llcc_bcast_write(struct llcc_perfmon_private *llcc_priv,
 			unsigned int offset, uint32_t val)
 {
@@ -140,9 +145,47 @@ static void perfmon_counter_dump(struct llcc_perfmon_private *llcc_priv)
 		}
 
 		llcc_priv->configured[i].counter_dump += total;
+		llcc_priv->configured[i].counter_total += total;
 	}
 }
 
+/**
+ * llcc_perfmon_event_count - read a configured perfmon event
+ * @port:	Event port the counter was configured on
+ * @event:	Event number the counter was configured for
+ * @count:	Returns the count accumulated since the counter was configured
+ *
+ * Lets in-kernel consumers sample an event that was set up through the
+ * perfmon_configure interface. Reading dumps the counters, so the raw
+ * values shown by a non-periodic perfmon_counter_dump only cover the time
+ * since the last read.
+ */
+int llcc_perfmon_event_count(unsigned int port, unsigned int event, u64 *count)
+{
+	struct llcc_perfmon_private *llcc_priv = llcc_perfmon_priv;
+	unsigned int i;
+	int ret = -ENOENT;
+
+	if (!llcc_priv)
+		return -ENODEV;
+
+	mutex_lock(&llcc_priv->mutex);
+	perfmon_counter_dump(llcc_priv);
+	/* Last perfmon counter is the cycle counter */
+	for (i = 0; i + 1 < llcc_priv->configured_counters; i++) {
+		if (llcc_priv->configured[i].port_sel == port &&
+		    llcc_priv->configured[i].event_sel == event) {
+			*count = llcc_priv->configured[i].counter_total;
+			ret = 0;
+			break;
+		}
+	}
+	mutex_unlock(&llcc_priv->mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(llcc_perfmon_event_count);
+
 static ssize_t perfmon_counter_dump_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
@@ -281,6 +324,7 @@ static ssize_t perfmon_configure_store(struct device *dev,
 
 		llcc_priv->configured[j].port_sel = port_sel;
 		llcc_priv->configured[j].event_sel = event_sel;
+		llcc_priv->configured[j].counter_total = 0;
 		port_ops = llcc_priv->port_ops[port_sel];
 		pr_info("counter %d configured for event %ld from port %ld\n",
 				j, event_sel, port_sel);
@@ -1159,6 +1203,7 @@ static int llcc_perfmon_probe(struct platform_device *pdev)
 	hrtimer_init(&llcc_priv->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	llcc_priv->hrtimer.function = llcc_perfmon_timer_handler;
 	llcc_priv->expires.tv64 = 0;
+	llcc_perfmon_priv = llcc_priv;
 	return 0;
 }
 
@@ -1166,6 +1211,7 @@ static int llcc_perfmon_remove(struct platform_device *pdev)
 {
 	struct llcc_perfmon_private *llcc_priv = platform_get_drvdata(pdev);
 
+	llcc_perfmon_priv = NULL;
 	while (hrtimer_active(&llcc_priv->hrtimer))
 		hrtimer_cancel(&llcc_priv->hrtimer);
 
@@ -29,6 +29,8 @@
 
 #define MAX_STR_LEN 256
 #define MAX_TIME_LEN 20
+#define RATIO_BUCKETS 8
+#define EXIT_LAT_BUCKETS 12
 const char *lpm_stats_reset = "reset";
 const char *lpm_stats_suspend = "suspend";
 
@@ -46,6 +48,11 @@ struct level_stats {
 	int64_t max_time[CONFIG_MSM_IDLE_STATS_BUCKET_COUNT];
 	int success_count;
 	int failed_count;
+	int pred_count[LPM_PRED_TOO_SHALLOW + 1];
+	/* actual / expected residency, 1/8 to 8 in powers of two */
+	int ratio_bucket[RATIO_BUCKETS];
+	/* exit latency past the expected wakeup, powers of two in us */
+	int exit_lat_bucket[EXIT_LAT_BUCKETS];
 	uint64_t total_time;
 	uint64_t enter_time;
 };
@@ -100,6 +107,57 @@ static void update_level_stats(struct level_stats *stats, uint64_t t,
 		stats->max_time[i] = t;
 }
 
+static void update_level_hist(struct level_stats *stats, uint32_t expected_us,
+				uint32_t actual_us, int32_t exit_lat_us)
+{
+	uint64_t r;
+
+	if (expected_us) {
+		r = div_u64((uint64_t)actual_us << 3, expected_us);
+		stats->ratio_bucket[min_t(int, fls64(r), RATIO_BUCKETS - 1)]++;
+	}
+
+	if (exit_lat_us >= 0)
+		stats->exit_lat_bucket[min_t(int, fls(exit_lat_us),
+					EXIT_LAT_BUCKETS - 1)]++;
+}
+
+static bool hist_empty(const int *bucket, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (bucket[i])
+			return false;
+	return true;
+}
+
+static void level_hist_print(struct seq_file *m, struct level_stats *stats)
+{
+	static const char * const ratio_name[RATIO_BUCKETS] = {
+		"<1/8", "<1/4", "<1/2", "<1", "<2", "<4", "<8", ">=8",
+	};
+	int i;
+
+	if (!hist_empty(stats->ratio_bucket, RATIO_BUCKETS)) {
+		seq_puts(m, "  actual/expected residency:");
+		for (i = 0; i < RATIO_BUCKETS; i++)
+			seq_printf(m, " %s:%d", ratio_name[i],
+					stats->ratio_bucket[i]);
+		seq_puts(m, "\n");
+	}
+
+	if (!hist_empty(stats->exit_lat_bucket, EXIT_LAT_BUCKETS)) {
+		seq_printf(m, "  exit latency us: 0:%d",
+				stats->exit_lat_bucket[0]);
+		for (i = 1; i < EXIT_LAT_BUCKETS - 1; i++)
+			seq_printf(m, " <%u:%d", 1U << i,
+					stats->exit_lat_bucket[i]);
+		seq_printf(m, " >=%u:%d\n", 1U << (i - 1),
+				stats->exit_lat_bucket[i]);
+	}
+}
+
 static void level_stats_print(struct seq_file *m, struct level_stats *stats)
 {
 	int i = 0;
@@ -124,6 +182,19 @@ static void level_stats_print(struct seq_file *m, struct level_stats *stats)
 		seq_puts(m, seqs);
 	}
 
+	if (stats->pred_count[LPM_PRED_HIT] ||
+	    stats->pred_count[LPM_PRED_TOO_DEEP] ||
+	    stats->pred_count[LPM_PRED_TOO_SHALLOW]) {
+		snprintf(seqs, MAX_STR_LEN,
+			"  select hit: %7d too deep: %7d too shallow: %7d\n",
+			stats->pred_count[LPM_PRED_HIT],
+			stats->pred_count[LPM_PRED_TOO_DEEP],
+			stats->pred_count[LPM_PRED_TOO_SHALLOW]);
+		seq_puts(m, seqs);
+	}
+
+	level_hist_print(m, stats);
+
 	bucket_time = stats->first_bucket_time;
 	for (i = 0;
 		i < CONFIG_MSM_IDLE_STATS_BUCKET_COUNT - 1;
@@ -188,6 +259,9 @@ static void level_stats_reset(struct level_stats *stats)
 	memset(stats->bucket, 0, sizeof(stats->bucket));
 	memset(stats->min_time, 0, sizeof(stats->min_time));
 	memset(stats->max_time, 0, sizeof(stats->max_time));
+	memset(stats->pred_count, 0, sizeof(stats->pred_count));
+	memset(stats->ratio_bucket, 0, sizeof(stats->ratio_bucket));
+	memset(stats->exit_lat_bucket, 0, sizeof(stats->exit_lat_bucket));
 	stats->success_count = 0;
 	stats->failed_count = 0;
 	stats->total_time = 0;
@@ -855,6 +929,68 @@ void lpm_stats_cpu_exit(uint32_t index, uint64_t time, bool success)
 }
 EXPORT_SYMBOL(lpm_stats_cpu_exit);
 
+/**
+ * lpm_stats_cpu_predict() - API to account the quality of a level choice.
+ *
+ * @index:	cpu's lpm level index.
+ * @outcome:	Whether the residency matched the chosen level.
+ *
+ * Function to communicate whether the idle period that just ended fitted
+ * the level selected for it, was too short for it or long enough for a
+ * deeper one.
+ */
+void lpm_stats_cpu_predict(uint32_t index, enum lpm_pred_outcome outcome)
+{
+	struct lpm_stats *stats = &(*this_cpu_ptr(&(cpu_stats)));
+
+	if (!stats->time_stats || index >= stats->num_levels)
+		return;
+
+	stats->time_stats[index].pred_count[outcome]++;
+}
+EXPORT_SYMBOL(lpm_stats_cpu_predict);
+
+/**
+ * lpm_stats_cluster_residency() - API to account the residency and exit
+ * latency of a cluster low power mode.
+ *
+ * @stats:	Pointer to the cluster's lpm_stats object.
+ * @index:	Index of the cluster lpm level.
+ * @expected_us:	Residency expected when the level was selected, 0 if none.
+ * @actual_us:	Residency actually achieved.
+ * @exit_lat_us:	Time from the expected wakeup event to exit, or negative
+ *		if the wakeup came before it and cannot be measured.
+ */
+void lpm_stats_cluster_residency(struct lpm_stats *stats, uint32_t index,
+	uint32_t expected_us, uint32_t actual_us, int32_t exit_lat_us)
+{
+	if (IS_ERR_OR_NULL(stats) || !stats->time_stats ||
+			index >= stats->num_levels)
+		return;
+
+	update_level_hist(&stats->time_stats[index], expected_us, actual_us,
+				exit_lat_us);
+}
+EXPORT_SYMBOL(lpm_stats_cluster_residency);
+
+/**
+ * lpm_stats_cpu_residency() - API to account the residency and exit
+ * latency of a cpu low power mode.
+ *
+ * @index:	cpu's lpm level index.
+ * @expected_us:	Residency expected when the level was selected, 0 if none.
+ * @actual_us:	Residency actually achieved.
+ * @exit_lat_us:	Time from the expected wakeup event to exit, or negative
+ *		if the wakeup came before it and cannot be measured.
+ */
+void lpm_stats_cpu_residency(uint32_t index, uint32_t expected_us,
+	uint32_t actual_us, int32_t exit_lat_us)
+{
+	lpm_stats_cluster_residency(this_cpu_ptr(&cpu_stats), index,
+				expected_us, actual_us, exit_lat_us);
+}
+EXPORT_SYMBOL(lpm_stats_cpu_residency);
+
 /**
  * lpm_stats_suspend_enter() - API to communicate system entering suspend.
  *
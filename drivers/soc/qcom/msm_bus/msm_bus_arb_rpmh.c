@@ -15,6 +15,8 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/rtmutex.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 #include <linux/clk.h>
 #include <linux/msm-bus.h>
 #include <dt-bindings/msm/msm-bus-ids.h>
@@ -47,6 +49,19 @@ static LIST_HEAD(query_list);
 
 DEFINE_RT_MUTEX(msm_bus_adhoc_lock);
 
+/*
+ * Votes that only lower bandwidth are held back for up to
+ * commit_window_us so that updates from several clients land in a
+ * single TCS commit. Any vote that raises a node is committed right
+ * away, together with everything already pending.
+ */
+static unsigned int commit_window_us;
+module_param(commit_window_us, uint, 0644);
+
+static bool commit_urgent;
+static bool commit_pending;
+static struct hrtimer commit_timer;
+
 static bool chk_bl_list(struct list_head *black_list, unsigned int id)
 {
 	struct msm_bus_node_device_type *bus_node = NULL;
@@ -787,10 +802,48 @@ exit_agg_bus_req:
 
 static void commit_data(void)
 {
+	unsigned int window_us = READ_ONCE(commit_window_us);
+
+	if (window_us && !commit_urgent && !list_empty(&commit_list)) {
+		if (!commit_pending) {
+			commit_pending = true;
+			hrtimer_start(&commit_timer,
+				ns_to_ktime(window_us * NSEC_PER_USEC),
+				HRTIMER_MODE_REL);
+		}
+		return;
+	}
+
+	/* A stale flush finds nothing pending and does nothing */
+	if (commit_pending) {
+		commit_pending = false;
+		hrtimer_try_to_cancel(&commit_timer);
+	}
+	commit_urgent = false;
+
 	msm_bus_commit_data(&commit_list);
 	INIT_LIST_HEAD(&commit_list);
 }
 
+static void commit_work_fn(struct work_struct *work)
+{
+	rt_mutex_lock(&msm_bus_adhoc_lock);
+	if (commit_pending) {
+		commit_pending = false;
+		msm_bus_commit_data(&commit_list);
+		INIT_LIST_HEAD(&commit_list);
+	}
+	rt_mutex_unlock(&msm_bus_adhoc_lock);
+}
+
+static DECLARE_WORK(commit_work, commit_work_fn);
+
+static enum hrtimer_restart commit_timer_fn(struct hrtimer *timer)
+{
+	queue_work(system_highpri_wq, &commit_work);
+	return HRTIMER_NORESTART;
+}
+
 int commit_late_init_data(bool lock)
 {
 	int rc;
@@ -881,6 +934,12 @@ static int update_path(struct device *src_dev, int dest, uint64_t act_req_ib,
 			ret = -ENXIO;
 			goto exit_update_path;
 		}
+		if (act_req_ib > lnode->lnode_ib[ACTIVE_CTX] ||
+		    act_req_bw > lnode->lnode_ab[ACTIVE_CTX] ||
+		    slp_req_ib > lnode->lnode_ib[DUAL_CTX] ||
+		    slp_req_bw > lnode->lnode_ab[DUAL_CTX])
+			commit_urgent = true;
+
 		lnode->lnode_ib[ACTIVE_CTX] = act_req_ib;
 		lnode->lnode_ab[ACTIVE_CTX] = act_req_bw;
 		lnode->lnode_ib[DUAL_CTX] = slp_req_ib;
@@ -952,6 +1011,7 @@ static int update_alc_vote(struct device *alc_dev, uint64_t act_req_fa_lat,
 		bcm_update_alc_req(dev_info, i);
 
 	add_node_to_clist(dev_info);
+	commit_urgent = true;
 
 exit_update_alc_vote:
 	return ret;
@@ -2009,4 +2069,7 @@ void msm_bus_arb_setops_adhoc(struct msm_bus_arb_ops *arb_ops)
 	arb_ops->update_bw_context = update_bw_context;
 	arb_ops->query_usecase = query_client_usecase;
 	arb_ops->query_usecase_all = query_client_usecase_all;
+
+	hrtimer_init(&commit_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	commit_timer.function = commit_timer_fn;
 }
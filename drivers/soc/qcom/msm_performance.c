@@ -25,6 +25,10 @@
 #include <linux/module.h>
 #include <linux/input.h>
 #include <linux/kthread.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <soc/qcom/lmh_dcvs.h>
+#include <linux/msm_performance.h>
 
 
 /* To handle cpufreq min/max request */
@@ -42,6 +46,10 @@ struct events {
 static struct events events_group;
 static struct task_struct *events_notify_thread;
 
+/* Page shared read-only with userspace, see msm_performance.h */
+static struct msm_perf_status *perf_status;
+static DEFINE_SPINLOCK(perf_status_lock);
+
 /**************************sysfs start********************************/
 /*
  * Userspace sends cpu#:min_freq_value to vote for min_freq_value as the new
@@ -225,6 +233,131 @@ static struct attribute_group events_attr_group = {
 };
 /*******************************sysfs ends************************************/
 
+/****************************status page start*******************************/
+/* Caller must hold perf_status_lock */
+static struct msm_perf_cluster_status *perf_status_cluster(unsigned int cpu)
+{
+	unsigned int i;
+
+	for (i = 0; i < perf_status->nr_clusters; i++) {
+		if (perf_status->cluster[i].cpu_mask & BIT(cpu))
+			return &perf_status->cluster[i];
+	}
+
+	return NULL;
+}
+
+/* Writers hold perf_status_lock, readers in userspace retry on seq */
+static void perf_status_write_begin(void)
+{
+	perf_status->seq++;
+	smp_wmb();
+}
+
+static void perf_status_write_end(void)
+{
+	smp_wmb();
+	perf_status->seq++;
+}
+
+static void perf_status_update_policy(struct cpufreq_policy *policy)
+{
+	struct msm_perf_cluster_status *cl;
+	unsigned int first = cpumask_first(policy->related_cpus);
+	u32 mask = (u32)cpumask_bits(policy->related_cpus)[0];
+	u32 thermal_max;
+	unsigned long flags;
+
+	if (!perf_status || first >= 32)
+		return;
+
+	thermal_max = limits_dcvs_get_freq_limit(first);
+
+	spin_lock_irqsave(&perf_status_lock, flags);
+	perf_status_write_begin();
+	cl = perf_status_cluster(first);
+	if (!cl && perf_status->nr_clusters < MSM_PERF_MAX_CLUSTERS) {
+		cl = &perf_status->cluster[perf_status->nr_clusters++];
+		cl->first_cpu = first;
+		cl->cpu_mask = mask;
+		cl->online_mask = mask & (u32)cpumask_bits(cpu_online_mask)[0];
+	}
+	if (cl) {
+		cl->cur_freq = policy->cur;
+		cl->min_freq = policy->min;
+		cl->max_freq = policy->max;
+		cl->thermal_max = thermal_max;
+	}
+	perf_status_write_end();
+	spin_unlock_irqrestore(&perf_status_lock, flags);
+}
+
+static void perf_status_update_freq(unsigned int cpu, unsigned int freq)
+{
+	struct msm_perf_cluster_status *cl;
+	unsigned long flags;
+
+	if (!perf_status)
+		return;
+
+	spin_lock_irqsave(&perf_status_lock, flags);
+	cl = perf_status_cluster(cpu);
+	if (cl && cl->cur_freq != freq) {
+		perf_status_write_begin();
+		cl->cur_freq = freq;
+		perf_status_write_end();
+	}
+	spin_unlock_irqrestore(&perf_status_lock, flags);
+}
+
+static void perf_status_update_online(unsigned int cpu, bool online)
+{
+	struct msm_perf_cluster_status *cl;
+	unsigned long flags;
+
+	if (!perf_status)
+		return;
+
+	spin_lock_irqsave(&perf_status_lock, flags);
+	cl = perf_status_cluster(cpu);
+	if (cl) {
+		perf_status_write_begin();
+		if (online)
+			cl->online_mask |= BIT(cpu);
+		else
+			cl->online_mask &= ~BIT(cpu);
+		perf_status_write_end();
+	}
+	spin_unlock_irqrestore(&perf_status_lock, flags);
+}
+
+static int perf_status_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	return remap_pfn_range(vma, vma->vm_start,
+			       virt_to_phys(perf_status) >> PAGE_SHIFT,
+			       PAGE_SIZE, vma->vm_page_prot);
+}
+
+static const struct file_operations perf_status_fops = {
+	.owner = THIS_MODULE,
+	.mmap = perf_status_mmap,
+	.llseek = noop_llseek,
+};
+
+static struct miscdevice perf_status_dev = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name = "msm_perf_status",
+	.fops = &perf_status_fops,
+	.mode = 0444,
+};
+/*****************************status page ends*******************************/
+
 
 static int perf_adjust_notify(struct notifier_block *nb, unsigned long val,
 							void *data)
@@ -235,6 +368,9 @@ static int perf_adjust_notify(struct notifier_block *nb, unsigned long val,
 	unsigned int min = cpu_st->min, max = cpu_st->max;
 
 
+	if (val == CPUFREQ_NOTIFY)
+		perf_status_update_policy(policy);
+
 	if (val != CPUFREQ_ADJUST)
 		return NOTIFY_OK;
 
@@ -254,10 +390,34 @@ static struct notifier_block perf_cpufreq_nb = {
 	.notifier_call = perf_adjust_notify,
 };
 
+static int perf_transition_notify(struct notifier_block *nb,
+				  unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freqs = data;
+
+	if (val == CPUFREQ_POSTCHANGE)
+		perf_status_update_freq(freqs->cpu, freqs->new);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block perf_transition_nb = {
+	.notifier_call = perf_transition_notify,
+};
+
+static int hotplug_offline_notify(unsigned int cpu)
+{
+	perf_status_update_online(cpu, false);
+
+	return 0;
+}
+
 static int hotplug_notify(unsigned int cpu)
 {
 	unsigned long flags;
 
+	perf_status_update_online(cpu, true);
+
 	if (events_group.init_success) {
 		spin_lock_irqsave(&(events_group.cpu_hotplug_lock), flags);
 		events_group.cpu_hotplug = true;
@@ -336,12 +496,41 @@ static int init_events_group(void)
 	return 0;
 }
 
+static int init_perf_status(void)
+{
+	struct cpufreq_policy *policy;
+	unsigned int cpu;
+	int ret;
+
+	perf_status = (struct msm_perf_status *)get_zeroed_page(GFP_KERNEL);
+	if (!perf_status)
+		return -ENOMEM;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		policy = cpufreq_cpu_get(cpu);
+		if (!policy)
+			continue;
+		perf_status_update_policy(policy);
+		cpufreq_cpu_put(policy);
+	}
+	put_online_cpus();
+
+	ret = misc_register(&perf_status_dev);
+	if (ret)
+		pr_err("msm_perf: Failed to register status device\n");
+
+	return ret;
+}
+
 static int __init msm_performance_init(void)
 {
 	unsigned int cpu;
 	int rc;
 
 	cpufreq_register_notifier(&perf_cpufreq_nb, CPUFREQ_POLICY_NOTIFIER);
+	cpufreq_register_notifier(&perf_transition_nb,
+				  CPUFREQ_TRANSITION_NOTIFIER);
 
 	for_each_present_cpu(cpu)
 		per_cpu(cpu_stats, cpu).max = UINT_MAX;
@@ -349,9 +538,10 @@ static int __init msm_performance_init(void)
 	rc = cpuhp_setup_state_nocalls(CPUHP_AP_ONLINE,
 		"msm_performance_cpu_hotplug",
 		hotplug_notify,
-		NULL);
+		hotplug_offline_notify);
 
 	init_events_group();
+	init_perf_status();
 
 	return 0;
 }
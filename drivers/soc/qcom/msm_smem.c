@@ -21,6 +21,7 @@
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
 #include <linux/printk.h>
+#include <linux/seqlock.h>
 #include <linux/slab.h>
 #include <linux/stat.h>
 #include <soc/qcom/subsystem_notif.h>
@@ -87,6 +88,26 @@ static DEFINE_MUTEX(smem_module_init_notifier_lock);
 static bool probe_done;
 uint32_t smem_max_items;
 
+/*
+ * Items are never freed, so the address of an item found once stays
+ * valid and smem_get_entry() of a hot item need not walk the partition
+ * under the remote spinlock again. One slot per item id caches the last
+ * successful lookup; writers are serialized by smem_cache_lock and the
+ * readers are lockless.
+ */
+#define SMEM_CACHE_FLAGS (SMEM_ITEM_CACHED_FLAG | SMEM_ANY_HOST_FLAG)
+
+struct smem_cache_entry {
+	void *item;
+	uint32_t size;
+	uint16_t to_proc;
+	uint16_t flags;
+};
+
+static struct smem_cache_entry *smem_cache;
+static DEFINE_SPINLOCK(smem_cache_lock);
+static seqcount_t smem_cache_seq = SEQCNT_ZERO(smem_cache_seq);
+
 /* smem security feature components */
 #define SMEM_TOC_IDENTIFIER 0x434f5424 /* "$TOC" */
 #define SMEM_TOC_MAX_EXCLUSIONS 4
@@ -540,6 +561,70 @@ static void *__smem_get_entry_secure(unsigned int id,
 	return item;
 }
 
+static void *smem_cache_lookup(unsigned int id, unsigned int *size,
+				unsigned int to_proc, unsigned int flags)
+{
+	struct smem_cache_entry *e;
+	void *item = NULL;
+	unsigned int seq;
+
+	if (!smem_cache)
+		return NULL;
+
+	flags &= SMEM_CACHE_FLAGS;
+	e = &smem_cache[id];
+	do {
+		seq = read_seqcount_begin(&smem_cache_seq);
+		if (e->item && e->to_proc == to_proc && e->flags == flags) {
+			item = e->item;
+			*size = e->size;
+		} else {
+			item = NULL;
+		}
+	} while (read_seqcount_retry(&smem_cache_seq, seq));
+
+	return item;
+}
+
+static void smem_cache_fill(unsigned int id, void *item, unsigned int size,
+				unsigned int to_proc, unsigned int flags)
+{
+	struct smem_cache_entry *e;
+	unsigned long lflags;
+
+	if (!smem_cache || IS_ERR_OR_NULL(item))
+		return;
+
+	e = &smem_cache[id];
+	spin_lock_irqsave(&smem_cache_lock, lflags);
+	write_seqcount_begin(&smem_cache_seq);
+	e->item = item;
+	e->size = size;
+	e->to_proc = to_proc;
+	e->flags = flags & SMEM_CACHE_FLAGS;
+	write_seqcount_end(&smem_cache_seq);
+	spin_unlock_irqrestore(&smem_cache_lock, lflags);
+}
+
+/* drop the items shared with a restarting host, it may lay them out anew */
+static void smem_cache_invalidate(unsigned int to_proc)
+{
+	unsigned long lflags;
+	unsigned int id;
+
+	if (!smem_cache)
+		return;
+
+	spin_lock_irqsave(&smem_cache_lock, lflags);
+	write_seqcount_begin(&smem_cache_seq);
+	for (id = 0; id < smem_max_items; id++)
+		if (smem_cache[id].to_proc == to_proc &&
+		    !(smem_cache[id].flags & SMEM_ANY_HOST_FLAG))
+			smem_cache[id].item = NULL;
+	write_seqcount_end(&smem_cache_seq);
+	spin_unlock_irqrestore(&smem_cache_lock, lflags);
+}
+
 static void *__smem_find(unsigned int id, unsigned int size_in,
 							bool skip_init_check)
 {
@@ -871,6 +956,7 @@ void *smem_alloc(unsigned int id, unsigned int size_in, unsigned int to_proc,
 	}
 
 	remote_spin_unlock_irqrestore(&remote_spinlock, lflags);
+	smem_cache_fill(id, ret, a_size_in, to_proc, flags);
 	return ret;
 }
 EXPORT_SYMBOL(smem_alloc);
@@ -888,6 +974,8 @@ EXPORT_SYMBOL(smem_alloc);
 void *smem_get_entry(unsigned int id, unsigned int *size, unsigned int to_proc,
 							unsigned int flags)
 {
+	void *item;
+
 	SMEM_DBG("%s(%u, %u, %u)\n", __func__, id, to_proc, flags);
 
 	/*
@@ -900,7 +988,17 @@ void *smem_get_entry(unsigned int id, unsigned int *size, unsigned int to_proc,
 	if (!is_probe_done() && id != SMEM_SPINLOCK_ARRAY)
 		return ERR_PTR(-EPROBE_DEFER);
 
-	return __smem_get_entry_secure(id, size, to_proc, flags, false, true);
+	if (id < smem_max_items) {
+		item = smem_cache_lookup(id, size, to_proc, flags);
+		if (item)
+			return item;
+	}
+
+	item = __smem_get_entry_secure(id, size, to_proc, flags, false, true);
+	if (item)
+		smem_cache_fill(id, item, *size, to_proc, flags);
+
+	return item;
 }
 EXPORT_SYMBOL(smem_get_entry);
 
@@ -1142,6 +1240,7 @@ static int restart_notifier_cb(struct notifier_block *this,
 				notifier->name);
 		remote_spin_release(&remote_spinlock, notifier->processor);
 		remote_spin_release_all(notifier->processor);
+		smem_cache_invalidate(notifier->processor);
 		break;
 	case SUBSYS_SOC_RESET:
 		if (!(smem_ramdump_dev && notifdata->enable_mini_ramdumps))
@@ -1604,6 +1703,11 @@ smem_targ_info_done:
 		SMEM_INFO("smem security enabled\n");
 		smem_init_security();
 	}
+	smem_cache = kcalloc(smem_max_items, sizeof(*smem_cache), GFP_KERNEL);
+	if (!smem_cache)
+		LOG_ERR("%s: no item cache, lookups walk the partitions\n",
+								__func__);
+
 	smem_dev = &pdev->dev;
 	probe_done = true;
 
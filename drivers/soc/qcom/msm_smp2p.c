@@ -103,6 +103,8 @@ struct smp2p_in {
  * @in_item_lock_lhb1: Lock protecting all elements of the structure.
  * @list: List head for the entries on remote processor.
  * @smem_edge_in: Pointer to the remote smem item.
+ * @scanned_valid_entries: Valid remote entries when the entries not yet
+ *                         open were last looked up by name.
  */
 struct smp2p_in_list_item {
 	spinlock_t in_item_lock_lhb1;
@@ -110,6 +112,7 @@ struct smp2p_in_list_item {
 	struct smp2p_smem __iomem *smem_edge_in;
 	uint32_t item_size;
 	uint32_t safe_total_entries;
+	uint32_t scanned_valid_entries;
 };
 static struct smp2p_in_list_item in_list[SMP2P_NUM_PROCS];
 
@@ -1132,6 +1135,7 @@ static int smp2p_do_negotiation(int remote_pid,
 		(void)out_item->ops_ptr->validate_size(remote_pid, r_smem_ptr,
 				in_list[remote_pid].item_size);
 		in_list[remote_pid].smem_edge_in = r_smem_ptr;
+		in_list[remote_pid].scanned_valid_entries = 0;
 		spin_unlock(&in_list[remote_pid].in_item_lock_lhb1);
 	} else {
 		SMP2P_INFO("%s: negotiation pid %d: State %d->%d F0x%08x\n",
@@ -1626,6 +1630,11 @@ static void smp2p_send_interrupt(int remote_pid)
  * the list of the clients registered for the entries on the remote
  * processor and notifies them if  the data changes.
  *
+ * All changed entries are delivered in the one pass of the interrupt.
+ * Entries that are not open yet are looked up by name only when the
+ * remote side added entries since the last lookup, so an interrupt does
+ * not walk the remote item for every client waiting on an entry.
+ *
  * Note:  Edge state must be OPENED to avoid a race condition with
  *        out_list[pid].ops_ptr->find_entry.
  */
@@ -1636,6 +1645,8 @@ static void smp2p_in_edge_notify(int pid)
 	unsigned long flags;
 	struct smp2p_smem __iomem *smem_h_ptr;
 	uint32_t curr_data;
+	uint32_t valid_entries;
+	bool scan;
 	struct  msm_smp2p_update_notif data;
 
 	spin_lock_irqsave(&in_list[pid].in_item_lock_lhb1, flags);
@@ -1647,8 +1658,13 @@ static void smp2p_in_edge_notify(int pid)
 		return;
 	}
 
+	valid_entries = SMP2P_GET_ENT_VALID(
+				readl_relaxed(&smem_h_ptr->valid_total_ent));
+	scan = valid_entries != in_list[pid].scanned_valid_entries;
+	in_list[pid].scanned_valid_entries = valid_entries;
+
 	list_for_each_entry(pos, &in_list[pid].list, in_edge_list) {
-		if (pos->entry_ptr == NULL) {
+		if (pos->entry_ptr == NULL && scan) {
 			/* entry not open - try to open it */
 			out_list[pid].ops_ptr->find_entry(smem_h_ptr,
 				in_list[pid].safe_total_entries, pos->name,
@@ -1785,6 +1801,7 @@ int smp2p_reset_mock_edge(void)
 	in_list[rpid].smem_edge_in = NULL;
 	in_list[rpid].item_size = 0;
 	in_list[rpid].safe_total_entries = 0;
+	in_list[rpid].scanned_valid_entries = 0;
 
 fail:
 	spin_unlock(&in_list[rpid].in_item_lock_lhb1);
@@ -32,6 +32,8 @@
 #include <linux/of_address.h>
 #include <linux/io.h>
 #include <linux/dma-mapping.h>
+#include <linux/vmalloc.h>
+#include <linux/lz4.h>
 #include <soc/qcom/ramdump.h>
 #include <soc/qcom/subsystem_restart.h>
 #include <soc/qcom/secure_buffer.h>
@@ -73,6 +75,14 @@ module_param(proxy_timeout_ms, int, 0644);
 
 static bool disable_timeouts;
 
+/**
+ * fw_cache_bytes - Memory held by cached firmware images of all subsystems
+ * that set qcom,cache-fw-image, in bytes
+ */
+static unsigned long fw_cache_bytes;
+module_param(fw_cache_bytes, ulong, 0444);
+static DEFINE_SPINLOCK(fw_cache_lock);
+
 static struct workqueue_struct *pil_wq;
 
 /**
@@ -106,6 +116,20 @@ struct pil_seg {
 	bool relocated;
 };
 
+/**
+ * struct pil_cache_seg - cached copy of one segment blob
+ * @data: blob contents, lz4 compressed if @compressed is set
+ * @len: number of bytes at @data
+ * @filesz: size of the uncompressed blob
+ * @compressed: true if @data holds lz4 compressed contents
+ */
+struct pil_cache_seg {
+	void *data;
+	size_t len;
+	unsigned long filesz;
+	bool compressed;
+};
+
 /**
  * struct pil_priv - Private state for a pil_desc
  * @proxy: work item used to run the proxy unvoting routine
@@ -121,6 +145,12 @@ struct pil_seg {
  * non-relocatable images
  * @region: region allocated for relocatable images
  * @unvoted_flag: flag to keep track if we have unvoted or not.
+ * @cached_mdt: copy of the <name>.mdt file kept for restarts
+ * @cache_segs: per program header copies of the segment blobs
+ * @cache_nsegs: number of entries in @cache_segs
+ * @cache_filling: set while a boot is populating @cache_segs
+ * @cache_valid: set once a boot succeeded with a complete cache
+ * @cache_bytes: memory held by the cache of this descriptor
  *
  * This struct contains data for a pil_desc that should not be exposed outside
  * of this file. This structure points to the descriptor and the descriptor
@@ -143,6 +173,12 @@ struct pil_priv {
 	int id;
 	int unvoted_flag;
 	size_t region_size;
+	struct firmware cached_mdt;
+	struct pil_cache_seg *cache_segs;
+	int cache_nsegs;
+	bool cache_filling;
+	bool cache_valid;
+	size_t cache_bytes;
 };
 
 static int pil_do_minidump(struct pil_desc *desc, void *ramdump_dev)
@@ -496,6 +532,21 @@ static irqreturn_t proxy_unvote_intr_handler(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
+/*
+ * Record a step of a subsystem boot on the kernel boot timeline, so that the
+ * bring-up of subsystems loading in parallel can be told apart.
+ */
+static void pil_boot_marker(struct pil_desc *desc, const char *step)
+{
+	char name[40];
+
+	if (!boot_marker_enabled())
+		return;
+
+	snprintf(name, sizeof(name), "M - %s %s", desc->name, step);
+	place_marker(name);
+}
+
 static bool segment_is_relocatable(const struct elf32_phdr *p)
 {
 	return !!(p->p_flags & BIT(27));
@@ -725,7 +776,7 @@ static int pil_init_mmap(struct pil_desc *desc, const struct pil_mdt *mdt,
 	if (ret)
 		return ret;
 
-	place_marker("M - Modem Image Start Loading");
+	pil_boot_marker(desc, "Image Start Loading");
 	pil_info(desc, "loading from %pa to %pa\n", &priv->region_start,
 							&priv->region_end);
 
@@ -818,6 +869,152 @@ static void unmap_fw_mem(void *vaddr, size_t size, void *data)
 	dma_unremap(info->dev, vaddr, size);
 }
 
+static void pil_fw_cache_drop(struct pil_desc *desc)
+{
+	struct pil_priv *priv = desc->priv;
+	int i;
+
+	if (priv->cache_valid) {
+		spin_lock(&fw_cache_lock);
+		fw_cache_bytes -= priv->cache_bytes;
+		spin_unlock(&fw_cache_lock);
+	}
+
+	for (i = 0; i < priv->cache_nsegs; i++)
+		vfree(priv->cache_segs[i].data);
+	kfree(priv->cache_segs);
+	kfree(priv->cached_mdt.data);
+
+	memset(&priv->cached_mdt, 0, sizeof(priv->cached_mdt));
+	priv->cache_segs = NULL;
+	priv->cache_nsegs = 0;
+	priv->cache_filling = false;
+	priv->cache_valid = false;
+	priv->cache_bytes = 0;
+}
+
+static void pil_fw_cache_prepare(struct pil_desc *desc, int nsegs)
+{
+	struct pil_priv *priv = desc->priv;
+
+	pil_fw_cache_drop(desc);
+
+	priv->cache_segs = kcalloc(nsegs, sizeof(*priv->cache_segs),
+				   GFP_KERNEL);
+	if (!priv->cache_segs)
+		return;
+
+	priv->cache_nsegs = nsegs;
+	priv->cache_filling = true;
+}
+
+/*
+ * Keep a copy of a freshly loaded blob. The copy has to be taken while the
+ * region is still mapped to Linux: once it is handed over to the subsystem
+ * it can no longer be read back. Failing to cache a blob is not fatal, the
+ * cache is simply not committed at the end of the boot.
+ */
+static void pil_fw_cache_store(struct pil_desc *desc, struct pil_seg *seg,
+			       const void *buf)
+{
+	struct pil_cache_seg *cseg = &desc->priv->cache_segs[seg->num];
+	size_t len = lz4_compressbound(seg->filesz);
+	void *wrkmem, *dst, *data;
+
+	cseg->filesz = seg->filesz;
+
+	wrkmem = kmalloc(LZ4_MEM_COMPRESS, GFP_KERNEL);
+	dst = vmalloc(len);
+	if (!wrkmem || !dst)
+		goto store_raw;
+
+	if (lz4_compress(buf, seg->filesz, dst, &len, wrkmem) ||
+	    len >= seg->filesz)
+		goto store_raw;
+
+	data = vmalloc(len);
+	if (!data)
+		goto store_raw;
+
+	memcpy(data, dst, len);
+	cseg->compressed = true;
+	goto out;
+
+store_raw:
+	len = seg->filesz;
+	data = vmalloc(len);
+	if (!data)
+		goto free;
+	memcpy(data, buf, len);
+	cseg->compressed = false;
+out:
+	cseg->data = data;
+	cseg->len = len;
+free:
+	vfree(dst);
+	kfree(wrkmem);
+}
+
+static int pil_fw_cache_restore(struct pil_desc *desc, struct pil_seg *seg,
+				void *buf)
+{
+	struct pil_cache_seg *cseg = &desc->priv->cache_segs[seg->num];
+	size_t len = cseg->len;
+	int ret;
+
+	if (!cseg->data || cseg->filesz != seg->filesz)
+		return -EINVAL;
+
+	if (!cseg->compressed) {
+		memcpy(buf, cseg->data, cseg->len);
+		return 0;
+	}
+
+	ret = lz4_decompress(cseg->data, &len, buf, seg->filesz);
+	if (ret || len != cseg->len)
+		return -EIO;
+
+	return 0;
+}
+
+static void pil_fw_cache_commit(struct pil_desc *desc,
+				const struct firmware *fw)
+{
+	struct pil_priv *priv = desc->priv;
+	struct pil_seg *seg;
+	size_t bytes, raw = 0;
+
+	priv->cache_filling = false;
+
+	bytes = fw->size + priv->cache_nsegs * sizeof(*priv->cache_segs);
+	list_for_each_entry(seg, &priv->segs, list) {
+		if (!seg->filesz)
+			continue;
+		if (!priv->cache_segs[seg->num].data)
+			goto drop;
+		bytes += priv->cache_segs[seg->num].len;
+		raw += seg->filesz;
+	}
+
+	priv->cached_mdt.data = kmemdup(fw->data, fw->size, GFP_KERNEL);
+	if (!priv->cached_mdt.data)
+		goto drop;
+	priv->cached_mdt.size = fw->size;
+
+	priv->cache_bytes = bytes;
+	priv->cache_valid = true;
+	spin_lock(&fw_cache_lock);
+	fw_cache_bytes += bytes;
+	spin_unlock(&fw_cache_lock);
+
+	pil_info(desc, "Cached firmware image: %zu bytes (%zu uncompressed)\n",
+		 bytes, raw + fw->size);
+	return;
+drop:
+	pil_err(desc, "Failed to cache firmware image\n");
+	pil_fw_cache_drop(desc);
+}
+
 static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 {
 	int ret = 0, count;
@@ -844,8 +1041,21 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 			return -ENOMEM;
 		}
 
+		if (desc->priv->cache_valid) {
+			ret = pil_fw_cache_restore(desc, seg, firmware_buf);
+			desc->unmap_fw_mem(firmware_buf, seg->filesz,
+					   map_data);
+			if (ret)
+				pil_err(desc, "Failed to restore cached blob %s(rc:%d)\n",
+					fw_name, ret);
+			goto zero_trailing;
+		}
+
 		ret = request_firmware_into_buf(&fw, fw_name, desc->dev,
 						firmware_buf, seg->filesz);
+		if (!ret && fw->size == seg->filesz &&
+		    desc->priv->cache_filling)
+			pil_fw_cache_store(desc, seg, firmware_buf);
 		desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
 
 		if (ret) {
@@ -864,6 +1074,10 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 		release_firmware(fw);
 	}
 
+zero_trailing:
+	if (ret)
+		return ret;
+
 	/* Zero out trailing memory */
 	paddr = seg->paddr + seg->filesz;
 	count = seg->sz - seg->filesz;
@@ -933,6 +1147,7 @@ static int pil_parse_devicetree(struct pil_desc *desc)
 
 	desc->sequential_load = of_property_read_bool(ofnode,
 						"qcom,sequential-fw-load");
+	desc->cache_fw = of_property_read_bool(ofnode, "qcom,cache-fw-image");
 	return 0;
 }
 
@@ -1071,10 +1286,15 @@ int pil_boot(struct pil_desc *desc)
 
 	down_read(&pil_pm_rwsem);
 	snprintf(fw_name, sizeof(fw_name), "%s.mdt", desc->fw_name);
-	ret = request_firmware(&fw, fw_name, desc->dev);
-	if (ret) {
-		pil_err(desc, "Failed to locate %s(rc:%d)\n", fw_name, ret);
-		goto out;
+	if (priv->cache_valid) {
+		fw = &priv->cached_mdt;
+	} else {
+		ret = request_firmware(&fw, fw_name, desc->dev);
+		if (ret) {
+			pil_err(desc, "Failed to locate %s(rc:%d)\n", fw_name,
+				ret);
+			goto out;
+		}
 	}
 
 	if (fw->size < sizeof(*ehdr)) {
@@ -1108,6 +1328,9 @@ int pil_boot(struct pil_desc *desc)
 	if (ret)
 		goto release_fw;
 
+	if (desc->cache_fw && !priv->cache_valid)
+		pil_fw_cache_prepare(desc, ehdr->e_phnum);
+
 	desc->priv->unvoted_flag = 0;
 	ret = pil_proxy_vote(desc);
 	if (ret) {
@@ -1161,7 +1384,7 @@ int pil_boot(struct pil_desc *desc)
 
 	trace_pil_event("before_load_seg", desc);
 
-	if (desc->sequential_load) {
+	if (desc->sequential_load || !pil_wq) {
 		list_for_each_entry(seg, &desc->priv->segs, list) {
 			ret = pil_load_seg(desc, seg);
 			if (ret)
@@ -1173,6 +1396,8 @@ int pil_boot(struct pil_desc *desc)
 			goto err_deinit_image;
 	}
 
+	pil_boot_marker(desc, "Image Loaded");
+
 	if (desc->subsys_vmid > 0) {
 		trace_pil_event("before_reclaim_mem", desc);
 		ret =  pil_reclaim_mem(desc, priv->region_start,
@@ -1194,8 +1419,10 @@ int pil_boot(struct pil_desc *desc)
 	}
 	trace_pil_event("reset_done", desc);
 	pil_info(desc, "Brought out of reset\n");
-	place_marker("M - Modem out of reset");
+	pil_boot_marker(desc, "out of reset");
 	desc->modem_ssr = false;
+	if (priv->cache_filling)
+		pil_fw_cache_commit(desc, fw);
 err_auth_and_reset:
 	if (ret && desc->subsys_vmid > 0) {
 		pil_assign_mem_to_linux(desc, priv->region_start,
@@ -1210,10 +1437,13 @@ err_boot:
 		disable_irq(desc->proxy_unvote_irq);
 	pil_proxy_unvote(desc, ret);
 release_fw:
-	release_firmware(fw);
+	if (fw != &priv->cached_mdt)
+		release_firmware(fw);
 out:
 	up_read(&pil_pm_rwsem);
 	if (ret) {
+		if (priv->cache_filling || priv->cache_valid)
+			pil_fw_cache_drop(desc);
 		if (priv->region) {
 			if (desc->subsys_vmid > 0 && !mem_protect &&
 					hyp_assign) {
@@ -1404,6 +1634,7 @@ void pil_desc_release(struct pil_desc *desc)
 	struct pil_priv *priv = desc->priv;
 
 	if (priv) {
+		pil_fw_cache_drop(desc);
 		ida_simple_remove(&pil_ida, priv->id);
 		flush_delayed_work(&priv->proxy);
 		wakeup_source_trash(&priv->ws);
@@ -43,6 +43,8 @@ struct pil_priv;
  * @subsys_vmid: memprot id for the subsystem.
  * @sequential_load: Load the firmware blobs sequentially if set. Else, load
  * them in parallel.
+ * @cache_fw: Keep an lz4 compressed copy of the image in memory after the
+ * first successful boot and load restarts from it instead of the filesystem.
  */
 struct pil_desc {
 	const char *name;
@@ -70,6 +72,7 @@ struct pil_desc {
 	struct md_ss_toc *minidump_pdr;
 	int minidump_id;
 	bool sequential_load;
+	bool cache_fw;
 };
 
 /**
@@ -549,6 +549,7 @@ static void clnt_resume_tx_worker(struct work_struct *work)
 						pend_txn->resp_cb_data,
 						ret);
 				list_del(&pend_txn->list);
+				hash_del(&pend_txn->hash_node);
 				kfree(pend_txn);
 			} else if (pend_txn->type == QMI_SYNC_TXN) {
 				pend_txn->send_stat = ret;
@@ -750,6 +751,7 @@ struct qmi_handle *qmi_handle_create(
 
 	/* Initialize client specific elements */
 	INIT_LIST_HEAD(&temp_handle->txn_list);
+	hash_init(temp_handle->txn_hash);
 	INIT_LIST_HEAD(&temp_handle->pending_txn_list);
 
 	/* Initialize service specific elements */
@@ -800,6 +802,7 @@ static void clean_txn_info(struct qmi_handle *handle)
 					pend_txn->enc_data)->msg_id,
 					pend_txn->resp, pend_txn->resp_cb_data,
 					-ENETRESET);
+			hash_del(&pend_txn->hash_node);
 			kfree(pend_txn->enc_data);
 			kfree(pend_txn);
 		} else if (pend_txn->type == QMI_SYNC_TXN) {
@@ -811,6 +814,7 @@ static void clean_txn_info(struct qmi_handle *handle)
 				 &handle->txn_list, list) {
 		if (txn_handle->type == QMI_ASYNC_TXN) {
 			list_del(&txn_handle->list);
+			hash_del(&txn_handle->hash_node);
 			kfree(txn_handle);
 		} else if (txn_handle->type == QMI_SYNC_TXN) {
 			wake_up(&txn_handle->wait_q);
@@ -944,6 +948,7 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	if (!handle->next_txn_id)
 		handle->next_txn_id++;
 	txn_handle->txn_id = handle->next_txn_id++;
+	hash_add(handle->txn_hash, &txn_handle->hash_node, txn_handle->txn_id);
 	encode_qmi_header(encoded_req, QMI_REQUEST_CONTROL_FLAG,
 			  txn_handle->txn_id, req_desc->msg_id,
 			  encoded_req_len);
@@ -992,6 +997,7 @@ append_pend_txn:
 
 encode_and_send_req_err3:
 	list_del(&txn_handle->list);
+	hash_del(&txn_handle->hash_node);
 encode_and_send_req_err2:
 	kfree(encoded_req);
 encode_and_send_req_err1:
@@ -1000,16 +1006,19 @@ encode_and_send_req_err1:
 	return rc;
 }
 
-int qmi_send_req_wait(struct qmi_handle *handle,
-		      struct msg_desc *req_desc,
-		      void *req, unsigned int req_len,
-		      struct msg_desc *resp_desc,
-		      void *resp, unsigned int resp_len,
-		      unsigned long timeout_ms)
+int qmi_send_req_start(struct qmi_handle *handle,
+		       struct msg_desc *req_desc,
+		       void *req, unsigned int req_len,
+		       struct msg_desc *resp_desc,
+		       void *resp, unsigned int resp_len,
+		       void **txn)
 {
 	struct qmi_txn *txn_handle = NULL;
 	int rc;
 
+	if (!txn)
+		return -EINVAL;
+
 	/* Encode and send the request */
 	rc = qmi_encode_and_send_req(&txn_handle, handle, QMI_SYNC_TXN,
 				     req_desc, req, req_len,
@@ -1020,6 +1029,20 @@ int qmi_send_req_wait(struct qmi_handle *handle,
 		return rc;
 	}
 
+	*txn = txn_handle;
+	return 0;
+}
+EXPORT_SYMBOL(qmi_send_req_start);
+
+int qmi_send_req_finish(struct qmi_handle *handle, void *txn,
+			unsigned long timeout_ms)
+{
+	struct qmi_txn *txn_handle = txn;
+	int rc = 0;
+
+	if (!handle || !txn_handle)
+		return -EINVAL;
+
 	/* Wait for the response */
 	if (!timeout_ms) {
 		wait_event(txn_handle->wait_q,
@@ -1051,11 +1074,31 @@ int qmi_send_req_wait(struct qmi_handle *handle,
 
 send_req_wait_err:
 	list_del(&txn_handle->list);
+	hash_del(&txn_handle->hash_node);
 	kfree(txn_handle);
 	wake_up(&handle->reset_waitq);
 	mutex_unlock(&handle->handle_lock);
 	return rc;
 }
+EXPORT_SYMBOL(qmi_send_req_finish);
+
+int qmi_send_req_wait(struct qmi_handle *handle,
+		      struct msg_desc *req_desc,
+		      void *req, unsigned int req_len,
+		      struct msg_desc *resp_desc,
+		      void *resp, unsigned int resp_len,
+		      unsigned long timeout_ms)
+{
+	void *txn;
+	int rc;
+
+	rc = qmi_send_req_start(handle, req_desc, req, req_len,
+				resp_desc, resp, resp_len, &txn);
+	if (rc < 0)
+		return rc;
+
+	return qmi_send_req_finish(handle, txn, timeout_ms);
+}
 EXPORT_SYMBOL(qmi_send_req_wait);
 
 int qmi_send_req_nowait(struct qmi_handle *handle,
@@ -1569,7 +1612,7 @@ static struct qmi_txn *find_txn_handle(struct qmi_handle *handle,
 {
 	struct qmi_txn *txn_handle;
 
-	list_for_each_entry(txn_handle, &handle->txn_list, list) {
+	hash_for_each_possible(handle->txn_hash, txn_handle, hash_node, txn_id) {
 		if (txn_handle->txn_id == txn_id)
 			return txn_handle;
 	}
@@ -1600,6 +1643,7 @@ static int handle_qmi_response(struct qmi_handle *handle,
 		wake_up(&txn_handle->wait_q);
 		if (txn_handle->type == QMI_ASYNC_TXN) {
 			list_del(&txn_handle->list);
+			hash_del(&txn_handle->hash_node);
 			kfree(txn_handle);
 		}
 		return rc;
@@ -1619,6 +1663,7 @@ static int handle_qmi_response(struct qmi_handle *handle,
 					    txn_handle->resp,
 					    txn_handle->resp_cb_data, 0);
 		list_del(&txn_handle->list);
+		hash_del(&txn_handle->hash_node);
 		kfree(txn_handle);
 		rc = 0;
 		break;
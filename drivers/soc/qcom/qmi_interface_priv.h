@@ -39,6 +39,7 @@ enum handle_type {
 
 struct qmi_txn {
 	struct list_head list;
+	struct hlist_node hash_node;
 	uint16_t txn_id;
 	enum txn_type type;
 	struct qmi_handle *handle;
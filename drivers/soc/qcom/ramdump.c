@@ -27,6 +27,8 @@
 #include <soc/qcom/ramdump.h>
 #include <linux/dma-mapping.h>
 #include <linux/of.h>
+#include <linux/lz4.h>
+#include <linux/vmalloc.h>
 
 
 #define RAMDUMP_NUM_DEVICES	256
@@ -41,6 +43,16 @@ static bool ramdump_devnode_inited;
 #define MAX_STRTBL_SIZE 512
 #define MAX_NAME_LENGTH 16
 
+#ifdef CONFIG_MSM_RAMDUMP_LZ4
+static bool ramdump_compress;
+module_param_named(compress, ramdump_compress, bool, 0644);
+MODULE_PARM_DESC(compress, "Stream dumps compressed with lz4");
+#else
+#define ramdump_compress false
+#endif
+
+struct ramdump_lz4_ctx;
+
 struct ramdump_device {
 	char name[256];
 
@@ -59,14 +71,19 @@ struct ramdump_device {
 	char *elfcore_buf;
 	unsigned long attrs;
 	bool complete_ramdump;
+	bool compress;
+	struct ramdump_lz4_ctx *lz4;
 };
 
+static void ramdump_lz4_free(struct ramdump_device *rd_dev);
+
 static int ramdump_open(struct inode *inode, struct file *filep)
 {
 	struct ramdump_device *rd_dev = container_of(inode->i_cdev,
 					struct ramdump_device, cdev);
 	rd_dev->consumer_present = 1;
 	rd_dev->ramdump_status = 0;
+	rd_dev->compress = ramdump_compress;
 	filep->private_data = rd_dev;
 	return 0;
 }
@@ -76,6 +93,7 @@ static int ramdump_release(struct inode *inode, struct file *filep)
 
 	struct ramdump_device *rd_dev = container_of(inode->i_cdev,
 					struct ramdump_device, cdev);
+	ramdump_lz4_free(rd_dev);
 	rd_dev->consumer_present = 0;
 	rd_dev->data_ready = 0;
 	complete(&rd_dev->ramdump_complete);
@@ -116,15 +134,292 @@ static unsigned long offset_translate(loff_t user_offset,
 
 #define MAX_IOREMAP_SIZE SZ_1M
 
+static void ramdump_copy_from_dev(unsigned char *dst, void *device_mem,
+				  size_t size)
+{
+	unsigned long bytes_before, bytes_after;
+
+	if ((unsigned long)device_mem & 0x7) {
+		bytes_before = 8 - ((unsigned long)device_mem & 0x7);
+		memcpy_fromio(dst, device_mem, bytes_before);
+		device_mem += bytes_before;
+		dst += bytes_before;
+		size -= bytes_before;
+	}
+
+	if (size & 0x7) {
+		bytes_after = size & 0x7;
+		memcpy(dst, device_mem, size - bytes_after);
+		device_mem += size - bytes_after;
+		dst += (size - bytes_after);
+		size = bytes_after;
+		memcpy_fromio(dst, device_mem, size);
+	} else
+		memcpy(dst, device_mem, size);
+}
+
+#ifdef CONFIG_MSM_RAMDUMP_LZ4
+/*
+ * With compression on, the dump is read as a sequence of frames, each a
+ * header followed by raw_len bytes of the uncompressed stream, ELF header
+ * included, compressed by lz4_compress(). Data that doesn't compress is
+ * stored as is, with cmp_len equal to raw_len. Chunks are compressed by
+ * up to RAMDUMP_LZ4_MAX_JOBS workers ahead of the reader.
+ */
+#define RAMDUMP_LZ4_MAGIC	0x345a4452	/* "RDZ4" */
+#define RAMDUMP_LZ4_CHUNK	SZ_256K
+#define RAMDUMP_LZ4_MAX_JOBS	4
+
+struct ramdump_lz4_frame {
+	__le32 magic;
+	__le32 raw_len;
+	__le32 cmp_len;
+};
+
+struct ramdump_lz4_job {
+	struct work_struct work;
+	struct completion done;
+	struct ramdump_device *rd_dev;
+	loff_t raw_pos;
+	size_t raw_len;
+	unsigned char *raw;
+	unsigned char *out;
+	void *wrkmem;
+	size_t out_len;
+	size_t out_off;
+	int err;
+};
+
+struct ramdump_lz4_ctx {
+	loff_t total;
+	loff_t next_pos;
+	int head;
+	int njobs;
+	struct ramdump_lz4_job jobs[RAMDUMP_LZ4_MAX_JOBS];
+};
+
+/* copy len bytes of the dump at pos, the ELF header included */
+static int ramdump_fetch(struct ramdump_device *rd_dev, unsigned char *dst,
+			 loff_t pos, size_t len)
+{
+	unsigned long addr, data_left;
+	void *vaddr, *device_mem;
+	size_t n;
+
+	while (len) {
+		if (pos < rd_dev->elfcore_size) {
+			n = min_t(size_t, len, rd_dev->elfcore_size - pos);
+			memcpy(dst, rd_dev->elfcore_buf + pos, n);
+		} else {
+			addr = offset_translate(pos - rd_dev->elfcore_size,
+						rd_dev, &data_left, &vaddr);
+			if (!data_left)
+				return -EINVAL;
+
+			n = min_t(size_t, len, data_left);
+			n = min_t(size_t, n, MAX_IOREMAP_SIZE);
+			device_mem = vaddr ?: dma_remap(rd_dev->dev->parent,
+						NULL, addr, n,
+						DMA_ATTR_SKIP_ZEROING);
+			if (!device_mem) {
+				pr_err("Ramdump(%s): Unable to ioremap: addr %lx, size %zd\n",
+					rd_dev->name, addr, n);
+				return -ENOMEM;
+			}
+			ramdump_copy_from_dev(dst, device_mem, n);
+			if (!vaddr)
+				dma_unremap(rd_dev->dev->parent, device_mem, n);
+		}
+		dst += n;
+		pos += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static void ramdump_lz4_work(struct work_struct *work)
+{
+	struct ramdump_lz4_job *job = container_of(work,
+					struct ramdump_lz4_job, work);
+	struct ramdump_lz4_frame *frame = (struct ramdump_lz4_frame *)job->out;
+	unsigned char *payload = job->out + sizeof(*frame);
+	size_t cmp_len;
+
+	job->err = ramdump_fetch(job->rd_dev, job->raw, job->raw_pos,
+				 job->raw_len);
+	if (job->err)
+		goto out;
+
+	if (lz4_compress(job->raw, job->raw_len, payload, &cmp_len,
+			 job->wrkmem) || cmp_len >= job->raw_len) {
+		memcpy(payload, job->raw, job->raw_len);
+		cmp_len = job->raw_len;
+	}
+
+	frame->magic = cpu_to_le32(RAMDUMP_LZ4_MAGIC);
+	frame->raw_len = cpu_to_le32(job->raw_len);
+	frame->cmp_len = cpu_to_le32(cmp_len);
+	job->out_len = sizeof(*frame) + cmp_len;
+	job->out_off = 0;
+out:
+	complete(&job->done);
+}
+
+/* start compressing the next chunk of the dump, if any is left */
+static void ramdump_lz4_submit(struct ramdump_lz4_ctx *ctx,
+			       struct ramdump_lz4_job *job)
+{
+	job->raw_pos = ctx->next_pos;
+	job->raw_len = min_t(loff_t, RAMDUMP_LZ4_CHUNK,
+			     ctx->total - ctx->next_pos);
+	ctx->next_pos += job->raw_len;
+
+	reinit_completion(&job->done);
+	if (job->raw_len)
+		queue_work(system_unbound_wq, &job->work);
+}
+
+static void ramdump_lz4_free(struct ramdump_device *rd_dev)
+{
+	struct ramdump_lz4_ctx *ctx = rd_dev->lz4;
+	struct ramdump_lz4_job *job;
+	int i;
+
+	if (!ctx)
+		return;
+
+	for (i = 0; i < ctx->njobs; i++) {
+		job = &ctx->jobs[i];
+		cancel_work_sync(&job->work);
+		vfree(job->raw);
+		vfree(job->out);
+		vfree(job->wrkmem);
+	}
+	kfree(ctx);
+	rd_dev->lz4 = NULL;
+}
+
+static int ramdump_lz4_alloc(struct ramdump_device *rd_dev)
+{
+	struct ramdump_lz4_ctx *ctx;
+	struct ramdump_lz4_job *job;
+	int i;
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+	rd_dev->lz4 = ctx;
+
+	ctx->total = rd_dev->elfcore_size;
+	for (i = 0; i < rd_dev->nsegments; i++)
+		ctx->total += rd_dev->segments[i].size;
+
+	ctx->njobs = clamp_t(int, num_online_cpus(), 1, RAMDUMP_LZ4_MAX_JOBS);
+	for (i = 0; i < ctx->njobs; i++) {
+		job = &ctx->jobs[i];
+		INIT_WORK(&job->work, ramdump_lz4_work);
+		init_completion(&job->done);
+		job->rd_dev = rd_dev;
+		job->raw = vmalloc(RAMDUMP_LZ4_CHUNK);
+		job->out = vmalloc(sizeof(struct ramdump_lz4_frame) +
+				   lz4_compressbound(RAMDUMP_LZ4_CHUNK));
+		job->wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+		if (!job->raw || !job->out || !job->wrkmem) {
+			ctx->njobs = i + 1;
+			ramdump_lz4_free(rd_dev);
+			return -ENOMEM;
+		}
+	}
+
+	for (i = 0; i < ctx->njobs; i++)
+		ramdump_lz4_submit(ctx, &ctx->jobs[i]);
+
+	return 0;
+}
+
+static ssize_t ramdump_lz4_read(struct ramdump_device *rd_dev,
+				char __user *buf, size_t count, loff_t *pos)
+{
+	struct ramdump_lz4_ctx *ctx;
+	struct ramdump_lz4_job *job;
+	size_t copied = 0, n;
+	int ret;
+
+	if (!rd_dev->lz4) {
+		ret = ramdump_lz4_alloc(rd_dev);
+		if (ret)
+			goto ramdump_done;
+	}
+	ctx = rd_dev->lz4;
+
+	while (count) {
+		job = &ctx->jobs[ctx->head];
+		if (!job->raw_len)
+			break;
+
+		wait_for_completion(&job->done);
+		if (job->err) {
+			ret = job->err;
+			goto ramdump_done;
+		}
+
+		n = min(count, job->out_len - job->out_off);
+		if (copy_to_user(buf, job->out + job->out_off, n)) {
+			pr_err("Ramdump(%s): Couldn't copy all data to user.",
+				rd_dev->name);
+			ret = -EFAULT;
+			goto ramdump_done;
+		}
+		job->out_off += n;
+		buf += n;
+		count -= n;
+		copied += n;
+
+		if (job->out_off == job->out_len) {
+			ramdump_lz4_submit(ctx, job);
+			ctx->head = (ctx->head + 1) % ctx->njobs;
+		}
+	}
+
+	if (copied) {
+		*pos += copied;
+		return copied;
+	}
+
+	pr_debug("Ramdump(%s): Ramdump complete. %lld bytes compressed to %lld.",
+		 rd_dev->name, ctx->total, *pos);
+	ret = 0;
+
+ramdump_done:
+	ramdump_lz4_free(rd_dev);
+	rd_dev->ramdump_status = ret ? -1 : 0;
+	rd_dev->data_ready = 0;
+	*pos = 0;
+	complete(&rd_dev->ramdump_complete);
+	return ret;
+}
+#else
+static void ramdump_lz4_free(struct ramdump_device *rd_dev)
+{
+}
+
+static ssize_t ramdump_lz4_read(struct ramdump_device *rd_dev,
+				char __user *buf, size_t count, loff_t *pos)
+{
+	return -EINVAL;
+}
+#endif /* CONFIG_MSM_RAMDUMP_LZ4 */
+
 static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 			loff_t *pos)
 {
 	struct ramdump_device *rd_dev = filep->private_data;
 	void *device_mem = NULL, *origdevice_mem = NULL, *vaddr = NULL;
-	unsigned long data_left = 0, bytes_before, bytes_after;
+	unsigned long data_left = 0;
 	unsigned long addr = 0;
-	size_t copy_size = 0, alignsize;
-	unsigned char *alignbuf = NULL, *finalbuf = NULL;
+	size_t copy_size = 0;
+	unsigned char *finalbuf = NULL;
 	int ret = 0;
 	loff_t orig_pos = *pos;
 
@@ -135,6 +430,9 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	if (ret)
 		return ret;
 
+	if (rd_dev->compress)
+		return ramdump_lz4_read(rd_dev, buf, count, pos);
+
 	if (*pos < rd_dev->elfcore_size) {
 		copy_size = rd_dev->elfcore_size - *pos;
 		copy_size = min(copy_size, count);
@@ -179,8 +477,8 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		goto ramdump_done;
 	}
 
-	alignbuf = kzalloc(copy_size, GFP_KERNEL);
-	if (!alignbuf) {
+	finalbuf = kzalloc(copy_size, GFP_KERNEL);
+	if (!finalbuf) {
 		pr_err("Ramdump(%s): Unable to alloc mem for aligned buf\n",
 				rd_dev->name);
 		rd_dev->ramdump_status = -1;
@@ -188,26 +486,7 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		goto ramdump_done;
 	}
 
-	finalbuf = alignbuf;
-	alignsize = copy_size;
-
-	if ((unsigned long)device_mem & 0x7) {
-		bytes_before = 8 - ((unsigned long)device_mem & 0x7);
-		memcpy_fromio(alignbuf, device_mem, bytes_before);
-		device_mem += bytes_before;
-		alignbuf += bytes_before;
-		alignsize -= bytes_before;
-	}
-
-	if (alignsize & 0x7) {
-		bytes_after = alignsize & 0x7;
-		memcpy(alignbuf, device_mem, alignsize - bytes_after);
-		device_mem += alignsize - bytes_after;
-		alignbuf += (alignsize - bytes_after);
-		alignsize = bytes_after;
-		memcpy_fromio(alignbuf, device_mem, alignsize);
-	} else
-		memcpy(alignbuf, device_mem, alignsize);
+	ramdump_copy_from_dev(finalbuf, device_mem, copy_size);
 
 	if (copy_to_user(buf, finalbuf, copy_size)) {
 		pr_err("Ramdump(%s): Couldn't copy all data to user.",
@@ -52,10 +52,19 @@
 		.bit = -1,				\
 	}
 
+/*
+ * @active_val is the last active vote sent for the resource and
+ * @active_pending the number of those votes still in flight. A resource
+ * also written through the uncached rpmh_write_batch() is marked
+ * @passthru, its state is not known here.
+ */
 struct rpmh_req {
 	u32 addr;
 	u32 sleep_val;
 	u32 wake_val;
+	u32 active_val;
+	u32 active_pending;
+	bool passthru;
 	struct list_head list;
 };
 
@@ -67,6 +76,7 @@ struct rpmh_msg {
 	struct rpmh_client *rc;
 	int bit;
 	int err; /* relay error from mbox for sync calls */
+	bool tracked; /* counted in active_pending of its resources */
 };
 
 struct rpmh_mbox {
@@ -110,6 +120,15 @@ static struct rpmh_msg *get_msg_from_pool(struct rpmh_client *rc)
 	}
 	spin_unlock_irqrestore(&rpm->lock, flags);
 
+	/* A burst of async requests may exhaust the pool */
+	if (!msg) {
+		msg = kzalloc(sizeof(*msg), GFP_ATOMIC);
+		if (msg) {
+			msg->bit = RPMH_MAX_FAST_RES;
+			msg->rc = rc;
+		}
+	}
+
 	return msg;
 }
 
@@ -120,6 +139,8 @@ static void __free_msg_to_pool(struct rpmh_msg *rpm_msg)
 	/* If we allocated the pool, set it as available */
 	if (rpm_msg->bit >= 0 && rpm_msg->bit != RPMH_MAX_FAST_RES) {
 		bitmap_clear(rpm->fast_req, rpm_msg->bit, 1);
+	} else if (rpm_msg->bit == RPMH_MAX_FAST_RES) {
+		kfree(rpm_msg);
 	}
 }
 
@@ -140,6 +161,34 @@ static void rpmh_rx_cb(struct mbox_client *cl, void *msg)
 	atomic_dec(rpm_msg->wait_count);
 }
 
+static struct rpmh_req *__find_req(struct rpmh_client *rc, u32 addr);
+
+/*
+ * Drop an active message from the pending count of its resources. The
+ * resources of a failed message are in an unknown state and are not
+ * coalesced until the next successful vote.
+ */
+static void rpmh_untrack_active(struct rpmh_msg *rpm_msg, int r)
+{
+	struct rpmh_mbox *rpm = rpm_msg->rc->rpmh;
+	struct rpmh_req *req;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&rpm->lock, flags);
+	for (i = 0; i < rpm_msg->msg.num_payload; i++) {
+		req = __find_req(rpm_msg->rc, rpm_msg->msg.payload[i].addr);
+		if (!req)
+			continue;
+		if (req->active_pending)
+			req->active_pending--;
+		if (r)
+			req->active_val = UINT_MAX;
+	}
+	rpm_msg->tracked = false;
+	spin_unlock_irqrestore(&rpm->lock, flags);
+}
+
 static void rpmh_tx_done(struct mbox_client *cl, void *msg, int r)
 {
 	struct rpmh_msg *rpm_msg = container_of(msg, struct rpmh_msg, msg);
@@ -148,6 +197,9 @@ static void rpmh_tx_done(struct mbox_client *cl, void *msg, int r)
 
 	rpm_msg->err = r;
 
+	if (rpm_msg->tracked)
+		rpmh_untrack_active(rpm_msg, r);
+
 	if (r) {
 		dev_err(rpm_msg->rc->dev,
 			"RPMH TX fail in msg addr 0x%x, err=%d\n",
@@ -251,6 +303,7 @@ static struct rpmh_req *cache_rpm_request(struct rpmh_client *rc,
 
 	req->addr = cmd->addr;
 	req->sleep_val = req->wake_val = UINT_MAX;
+	req->active_val = UINT_MAX;
 	INIT_LIST_HEAD(&req->list);
 	list_add_tail(&req->list, &rpm->resources);
 
@@ -300,6 +353,79 @@ static int check_ctrlr_state(struct rpmh_client *rc, enum rpmh_state state)
 	return ret;
 }
 
+/*
+ * An active vote is redundant when every resource in it already holds the
+ * requested value: the last vote for it completed with that value, no
+ * other vote is in flight and waking up from sleep restores the same
+ * value. Otherwise the vote is counted as pending on its resources.
+ * Returns true if the message need not be sent.
+ */
+static bool rpmh_coalesce_active(struct rpmh_client *rc,
+				struct rpmh_msg *rpm_msg)
+{
+	struct rpmh_mbox *rpm = rc->rpmh;
+	struct tcs_mbox_msg *msg = &rpm_msg->msg;
+	struct rpmh_req *req;
+	unsigned long flags;
+	bool redundant = true;
+	int i;
+
+	spin_lock_irqsave(&rpm->lock, flags);
+	for (i = 0; i < msg->num_payload && redundant; i++) {
+		req = __find_req(rc, msg->payload[i].addr);
+		redundant = req && !req->passthru && !req->active_pending &&
+			req->active_val == msg->payload[i].data &&
+			(req->sleep_val == UINT_MAX ||
+			 req->wake_val == msg->payload[i].data);
+	}
+
+	if (!redundant) {
+		for (i = 0; i < msg->num_payload; i++) {
+			req = __find_req(rc, msg->payload[i].addr);
+			if (!req)
+				continue;
+			req->active_val = msg->payload[i].data;
+			req->active_pending++;
+		}
+		rpm_msg->tracked = true;
+	}
+	spin_unlock_irqrestore(&rpm->lock, flags);
+
+	return redundant;
+}
+
+/* votes sent around the cache leave the state of the resources unknown */
+static int rpmh_mark_passthru(struct rpmh_client *rc, struct tcs_cmd *cmd,
+				int n)
+{
+	struct rpmh_mbox *rpm = rc->rpmh;
+	struct rpmh_req *req;
+	unsigned long flags;
+	int ret = 0;
+	int i;
+
+	spin_lock_irqsave(&rpm->lock, flags);
+	for (i = 0; i < n; i++) {
+		req = __find_req(rc, cmd[i].addr);
+		if (!req) {
+			req = kzalloc(sizeof(*req), GFP_ATOMIC);
+			if (!req) {
+				ret = -ENOMEM;
+				break;
+			}
+			req->addr = cmd[i].addr;
+			req->sleep_val = req->wake_val = UINT_MAX;
+			INIT_LIST_HEAD(&req->list);
+			list_add_tail(&req->list, &rpm->resources);
+		}
+		req->passthru = true;
+		req->active_val = UINT_MAX;
+	}
+	spin_unlock_irqrestore(&rpm->lock, flags);
+
+	return ret;
+}
+
 /**
  * __rpmh_write: Cache and send the RPMH request
  *
@@ -310,6 +436,8 @@ static int check_ctrlr_state(struct rpmh_client *rc, enum rpmh_state state)
  * Cache the RPMH request and send if the state is ACTIVE_ONLY.
  * SLEEP/WAKE_ONLY requests are not sent to the controller at
  * this time. Use rpmh_flush() to send them to the controller.
+ * An active request that would not change any resource completes
+ * without a round trip to the accelerator.
  */
 int __rpmh_write(struct rpmh_client *rc, enum rpmh_state state,
 			struct rpmh_msg *rpm_msg)
@@ -329,9 +457,15 @@ int __rpmh_write(struct rpmh_client *rc, enum rpmh_state state,
 
 	/* Send to mailbox only if active or awake */
 	if (state == RPMH_ACTIVE_ONLY_STATE || state == RPMH_AWAKE_STATE) {
+		if (rpmh_coalesce_active(rc, rpm_msg)) {
+			rpmh_tx_done(&rc->client, &rpm_msg->msg, 0);
+			return 0;
+		}
 		ret = mbox_send_message(rc->chan, &rpm_msg->msg);
 		if (ret > 0)
 			ret = 0;
+		else if (ret < 0)
+			rpmh_untrack_active(rpm_msg, ret);
 	} else {
 		/* Clean up our call by spoofing tx_done */
 		rpmh_tx_done(&rc->client, &rpm_msg->msg, ret);
@@ -661,6 +795,12 @@ int rpmh_write_batch(struct rpmh_client *rc, enum rpmh_state state,
 		}
 	}
 
+	for (i = 0, k = 0; i < count; k += n[i], i++) {
+		ret = rpmh_mark_passthru(rc, cmd + k, n[i]);
+		if (ret)
+			return ret;
+	}
+
 	addr = cmd[0].addr;
 	data = cmd[0].data;
 	/* Create async request batches */
@@ -34,8 +34,38 @@
 #define DEFAULT_RQ_POLL_JIFFIES 1
 #define DEFAULT_DEF_TIMER_JIFFIES 5
 
+/* time constant of the cluster averages */
+#define CLUSTER_WINDOW_NS (10 * NSEC_PER_MSEC)
+/* change of the averages that wakes up pollers of cluster_load */
+#define CLUSTER_NOTIFY_NR 50
+#define CLUSTER_NOTIFY_LOAD 10
+
 struct notifier_block freq_transition;
 struct notifier_block cpu_hotplug;
+struct notifier_block cpu_idle;
+
+/*
+ * Per cluster busy cpu count and frequency scaled load, updated when a cpu
+ * of the cluster enters or leaves idle and on frequency changes. Both are
+ * moving averages over CLUSTER_WINDOW_NS, nr_avg in hundredths of a cpu
+ * and load_avg as the sum of the busy percent at max frequency of the
+ * cpus. Pollers of cluster_load are woken when either changed noticeably.
+ */
+struct rq_cluster {
+	raw_spinlock_t lock;
+	unsigned int first_cpu;
+	unsigned int nr_busy;
+	unsigned int freq_pct;
+	u64 last_ns;
+	int nr_avg;
+	int load_avg;
+	int nr_notified;
+	int load_notified;
+};
+
+static DEFINE_PER_CPU(struct rq_cluster *, rq_cluster);
+static DEFINE_PER_CPU(bool, rq_cpu_busy);
+static struct kernfs_node *cluster_load_kn;
 
 struct cpu_load_data {
 	cputime64_t prev_cpu_idle;
@@ -132,11 +162,129 @@ static int cpufreq_transition_handler(struct notifier_block *nb,
 			pcpu->cur_freq = freqs->new;
 			mutex_unlock(&pcpu->cpu_load_mutex);
 		}
+		rq_cluster_set_freq(freqs->cpu, freqs->new);
 		break;
 	}
 	return 0;
 }
 
+/* Caller must hold cl->lock */
+static void rq_cluster_accumulate(struct rq_cluster *cl, u64 now)
+{
+	int nr = cl->nr_busy * 100;
+	int load = cl->nr_busy * cl->freq_pct;
+	u64 dt = now - cl->last_ns;
+
+	cl->last_ns = now;
+	if (dt >= CLUSTER_WINDOW_NS) {
+		cl->nr_avg = nr;
+		cl->load_avg = load;
+		return;
+	}
+
+	cl->nr_avg += div_s64((s64)(nr - cl->nr_avg) * dt, CLUSTER_WINDOW_NS);
+	cl->load_avg += div_s64((s64)(load - cl->load_avg) * dt,
+				CLUSTER_WINDOW_NS);
+}
+
+/* Caller must hold cl->lock */
+static bool rq_cluster_changed(struct rq_cluster *cl)
+{
+	if (abs(cl->nr_avg - cl->nr_notified) < CLUSTER_NOTIFY_NR &&
+	    abs(cl->load_avg - cl->load_notified) < CLUSTER_NOTIFY_LOAD)
+		return false;
+
+	cl->nr_notified = cl->nr_avg;
+	cl->load_notified = cl->load_avg;
+	return true;
+}
+
+static void rq_cluster_notify(void)
+{
+	if (cluster_load_kn)
+		sysfs_notify_dirent(cluster_load_kn);
+}
+
+static int cpu_idle_handler(struct notifier_block *nb,
+			unsigned long val, void *data)
+{
+	struct rq_cluster *cl = this_cpu_read(rq_cluster);
+	bool busy = val == IDLE_END;
+	unsigned long flags;
+	bool notify;
+
+	if (!cl || (val != IDLE_START && val != IDLE_END) ||
+	    this_cpu_read(rq_cpu_busy) == busy)
+		return NOTIFY_OK;
+
+	this_cpu_write(rq_cpu_busy, busy);
+
+	raw_spin_lock_irqsave(&cl->lock, flags);
+	rq_cluster_accumulate(cl, sched_clock());
+	if (busy)
+		cl->nr_busy++;
+	else if (cl->nr_busy)
+		cl->nr_busy--;
+	notify = rq_cluster_changed(cl);
+	raw_spin_unlock_irqrestore(&cl->lock, flags);
+
+	if (notify)
+		rq_cluster_notify();
+
+	return NOTIFY_OK;
+}
+
+static void rq_cluster_set_freq(unsigned int cpu, unsigned int freq)
+{
+	struct rq_cluster *cl = per_cpu(rq_cluster, cpu);
+	struct cpu_load_data *pcpu = &per_cpu(cpuload, cpu);
+	unsigned long flags;
+	bool notify;
+
+	if (!cl || !pcpu->policy_max)
+		return;
+
+	raw_spin_lock_irqsave(&cl->lock, flags);
+	rq_cluster_accumulate(cl, sched_clock());
+	cl->freq_pct = min(100U, freq * 100 / pcpu->policy_max);
+	notify = rq_cluster_changed(cl);
+	raw_spin_unlock_irqrestore(&cl->lock, flags);
+
+	if (notify)
+		rq_cluster_notify();
+}
+
+static void init_rq_clusters(void)
+{
+	struct cpufreq_policy cpu_policy;
+	struct rq_cluster *cl;
+	unsigned int cpu, j, freq;
+
+	for_each_possible_cpu(cpu) {
+		if (per_cpu(rq_cluster, cpu))
+			continue;
+
+		cl = kzalloc(sizeof(*cl), GFP_KERNEL);
+		if (!cl)
+			return;
+
+		raw_spin_lock_init(&cl->lock);
+		cl->first_cpu = cpu;
+		cl->freq_pct = 100;
+		cl->last_ns = sched_clock();
+
+		if (cpufreq_get_policy(&cpu_policy, cpu)) {
+			per_cpu(rq_cluster, cpu) = cl;
+			continue;
+		}
+		for_each_cpu(j, cpu_policy.related_cpus)
+			per_cpu(rq_cluster, j) = cl;
+		freq = per_cpu(cpuload, cpu).cur_freq;
+		if (freq)
+			rq_cluster_set_freq(cpu, freq);
+	}
+}
+
 static void update_related_cpus(void)
 {
 	unsigned int cpu;
@@ -302,8 +450,40 @@ static struct kobj_attribute cpu_normalized_load_attr =
 	__ATTR(cpu_normalized_load, S_IWUSR | S_IRUSR, show_cpu_normalized_load,
 			NULL);
 
+static ssize_t show_cluster_load(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct rq_cluster *cl;
+	unsigned long flags;
+	unsigned int cpu;
+	int nr, load;
+	ssize_t len = 0;
+
+	for_each_possible_cpu(cpu) {
+		cl = per_cpu(rq_cluster, cpu);
+		if (!cl || cl->first_cpu != cpu)
+			continue;
+
+		raw_spin_lock_irqsave(&cl->lock, flags);
+		rq_cluster_accumulate(cl, sched_clock());
+		nr = cl->nr_avg;
+		load = cl->load_avg;
+		raw_spin_unlock_irqrestore(&cl->lock, flags);
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "cpu%u %d.%02d %d\n", cpu, nr / 100, nr % 100,
+				 load);
+	}
+
+	return len;
+}
+
+static struct kobj_attribute cluster_load_attr =
+	__ATTR(cluster_load, S_IRUSR, show_cluster_load, NULL);
+
 static struct attribute *rq_attrs[] = {
 	&cpu_normalized_load_attr.attr,
+	&cluster_load_attr.attr,
 	&def_timer_ms_attr.attr,
 	&run_queue_avg_attr.attr,
 	&run_queue_poll_ms_attr.attr,
@@ -329,10 +509,13 @@ static int init_rq_attribs(void)
 		return -ENOMEM;
 
 	err = sysfs_create_group(rq_info.kobj, rq_info.attr_group);
-	if (err)
+	if (err) {
 		kobject_put(rq_info.kobj);
-	else
+	} else {
+		cluster_load_kn = sysfs_get_dirent(rq_info.kobj->sd,
+						   "cluster_load");
 		kobject_uevent(rq_info.kobj, KOBJ_ADD);
+	}
 
 	return err;
 }
@@ -372,11 +555,15 @@ static int __init msm_rq_stats_init(void)
 			pcpu->cur_freq = cpufreq_quick_get(i);
 		cpumask_copy(pcpu->related_cpus, cpu_policy.cpus);
 	}
+	init_rq_clusters();
+
 	freq_transition.notifier_call = cpufreq_transition_handler;
 	cpu_hotplug.notifier_call = cpu_hotplug_handler;
+	cpu_idle.notifier_call = cpu_idle_handler;
 	cpufreq_register_notifier(&freq_transition,
 					CPUFREQ_TRANSITION_NOTIFIER);
 	register_hotcpu_notifier(&cpu_hotplug);
+	idle_notifier_register(&cpu_idle);
 
 	return ret;
 }
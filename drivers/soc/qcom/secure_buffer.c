@@ -215,26 +215,41 @@ populate_dest_info(int *dest_vmids, int nelements, int *dest_perms,
 	return dest_info;
 }
 
-/* Must hold secure_buffer_mutex while allocated buffer is in use */
+/*
+ * Must hold secure_buffer_mutex while allocated buffer is in use.
+ * Physically contiguous sg entries are merged into one section, so a batch
+ * covers up to BATCH_MAX_SIZE even when the table is made of small pages.
+ * Returns the number of sections, *nr_sgl is set to the entries consumed.
+ */
 static unsigned int get_batches_from_sgl(struct mem_prot_info *sg_table_copy,
 					 struct scatterlist *sgl,
-					 struct scatterlist **next_sgl)
+					 struct scatterlist **next_sgl,
+					 unsigned int *nr_sgl)
 {
 	u64 batch_size = 0;
-	unsigned int i = 0;
+	unsigned int i = 0, n = 0;
 	struct scatterlist *curr_sgl = sgl;
+	phys_addr_t addr;
 
 	/* Ensure no zero size batches */
 	do {
-		sg_table_copy[i].addr = page_to_phys(sg_page(curr_sgl));
-		sg_table_copy[i].size = curr_sgl->length;
-		batch_size += sg_table_copy[i].size;
+		addr = page_to_phys(sg_page(curr_sgl));
+		if (i && sg_table_copy[i - 1].addr +
+			 sg_table_copy[i - 1].size == addr) {
+			sg_table_copy[i - 1].size += curr_sgl->length;
+		} else {
+			sg_table_copy[i].addr = addr;
+			sg_table_copy[i].size = curr_sgl->length;
+			i++;
+		}
+		batch_size += curr_sgl->length;
 		curr_sgl = sg_next(curr_sgl);
-		i++;
+		n++;
 	} while (curr_sgl && i < BATCH_MAX_SECTIONS &&
 		 curr_sgl->length + batch_size < BATCH_MAX_SIZE);
 
 	*next_sgl = curr_sgl;
+	*nr_sgl = n;
 	return i;
 }
 
@@ -242,7 +257,7 @@ static int batched_hyp_assign(struct sg_table *table, struct scm_desc *desc)
 {
 	unsigned int entries_size;
 	unsigned int batch_start = 0;
-	unsigned int batches_processed;
+	unsigned int batches_processed, sgl_processed;
 	struct scatterlist *curr_sgl = table->sgl;
 	struct scatterlist *next_sgl;
 	int ret = 0;
@@ -255,7 +270,8 @@ static int batched_hyp_assign(struct sg_table *table, struct scm_desc *desc)
 
 	while (batch_start < table->nents) {
 		batches_processed = get_batches_from_sgl(sg_table_copy,
-							 curr_sgl, &next_sgl);
+							 curr_sgl, &next_sgl,
+							 &sgl_processed);
 		curr_sgl = next_sgl;
 		entries_size = batches_processed * sizeof(*sg_table_copy);
 		dmac_flush_range(sg_table_copy,
@@ -271,7 +287,7 @@ static int batched_hyp_assign(struct sg_table *table, struct scm_desc *desc)
 			break;
 		}
 
-		batch_start += batches_processed;
+		batch_start += sgl_processed;
 	}
 
 	kfree(sg_table_copy);
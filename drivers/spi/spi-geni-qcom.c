@@ -153,6 +153,10 @@ struct spi_geni_master {
 	int num_tx_eot;
 	int num_rx_eot;
 	int num_xfers;
+	atomic_t tx_done;
+	atomic_t rx_done;
+	int tx_expected;
+	int rx_expected;
 	void *ipc;
 	bool shared_se;
 	bool dis_autosuspend;
@@ -485,7 +489,9 @@ static void spi_gsi_rx_callback(void *cb)
 		if (cb_param->length == xfer->len) {
 			GENI_SE_DBG(mas->ipc, false, mas->dev,
 			"%s\n", __func__);
-			complete(&mas->rx_cb);
+			if (atomic_inc_return(&mas->rx_done) ==
+					READ_ONCE(mas->rx_expected))
+				complete(&mas->rx_cb);
 		} else {
 			GENI_SE_ERR(mas->ipc, true, mas->dev,
 			"%s: Length mismatch. Expected %d Callback %d\n",
@@ -511,7 +517,9 @@ static void spi_gsi_tx_callback(void *cb)
 		if (cb_param->length == xfer->len) {
 			GENI_SE_DBG(mas->ipc, false, mas->dev,
 			"%s\n", __func__);
-			complete(&mas->tx_cb);
+			if (atomic_inc_return(&mas->tx_done) ==
+					READ_ONCE(mas->tx_expected))
+				complete(&mas->tx_cb);
 		} else {
 			GENI_SE_ERR(mas->ipc, true, mas->dev,
 			"%s: Length mismatch. Expected %d Callback %d\n",
@@ -666,6 +674,52 @@ static int setup_gsi_xfer(struct spi_transfer *xfer,
 	return ret;
 }
 
+/*
+ * Transfers of a message are queued to the GSI channels back to back, up to
+ * NUM_SPI_XFER of them, so that e.g. a register write followed by a burst
+ * read runs without the CPU in between. The chain is waited for once:
+ * the callbacks only count completed transfers, and the last expected one
+ * wakes the transfer thread.
+ */
+static void spi_gsi_reset_chain(struct spi_geni_master *mas)
+{
+	mas->num_tx_eot = 0;
+	mas->num_rx_eot = 0;
+	mas->num_xfers = 0;
+	WRITE_ONCE(mas->tx_expected, 0);
+	WRITE_ONCE(mas->rx_expected, 0);
+	atomic_set(&mas->tx_done, 0);
+	atomic_set(&mas->rx_done, 0);
+	reinit_completion(&mas->tx_cb);
+	reinit_completion(&mas->rx_cb);
+}
+
+static int spi_gsi_wait_chain(struct spi_geni_master *mas, atomic_t *done,
+				int *expected, struct completion *cb, int nr)
+{
+	unsigned long timeout;
+
+	if (!nr)
+		return 0;
+
+	WRITE_ONCE(*expected, nr);
+	/* pairs with atomic_inc_return() in the callbacks */
+	smp_mb();
+	if (atomic_read(done) >= nr)
+		return 0;
+
+	timeout = wait_for_completion_timeout(cb,
+				msecs_to_jiffies(SPI_XFER_TIMEOUT_MS * nr));
+	if (!timeout && atomic_read(done) < nr) {
+		GENI_SE_ERR(mas->ipc, true, mas->dev,
+			"%s: %d of %d transfers done\n", __func__,
+			atomic_read(done), nr);
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
 static int spi_geni_map_buf(struct spi_geni_master *mas,
 				struct spi_message *msg)
 {
@@ -729,6 +783,7 @@ static int spi_geni_prepare_message(struct spi_master *spi,
 	} else if (mas->cur_xfer_mode == GSI_DMA) {
 		memset(mas->gsi, 0,
 				(sizeof(struct spi_geni_gsi) * NUM_SPI_XFER));
+		spi_gsi_reset_chain(mas);
 		geni_se_select_mode(mas->base, GSI_DMA);
 		ret = spi_geni_map_buf(mas, spi_msg);
 	} else {
@@ -1105,53 +1160,38 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 					xfer->rx_dma, xfer->len);
 		}
 	} else {
-		mas->num_tx_eot = 0;
-		mas->num_rx_eot = 0;
-		mas->num_xfers = 0;
-		reinit_completion(&mas->tx_cb);
-		reinit_completion(&mas->rx_cb);
+		ret = setup_gsi_xfer(xfer, mas, slv, spi);
+		if (ret)
+			goto err_gsi_geni_transfer_one;
 
-		setup_gsi_xfer(xfer, mas, slv, spi);
+		/*
+		 * Delays and chip select changes are done by the SPI core
+		 * after we return, so they end the chain too.
+		 */
 		if ((mas->num_xfers >= NUM_SPI_XFER) ||
+			xfer->cs_change || xfer->delay_usecs ||
 			(list_is_last(&xfer->transfer_list,
 					&spi->cur_msg->transfers))) {
-			int i;
-
-			for (i = 0 ; i < mas->num_tx_eot; i++) {
-				timeout =
-				wait_for_completion_timeout(
-					&mas->tx_cb,
-					msecs_to_jiffies(SPI_XFER_TIMEOUT_MS));
-				if (timeout <= 0) {
-					GENI_SE_ERR(mas->ipc, true, mas->dev,
-					"Tx[%d] timeout%lu\n", i, timeout);
-					ret = -ETIMEDOUT;
-					goto err_gsi_geni_transfer_one;
-				}
-			}
-			for (i = 0 ; i < mas->num_rx_eot; i++) {
-				timeout =
-				wait_for_completion_timeout(
-					&mas->rx_cb,
-					msecs_to_jiffies(SPI_XFER_TIMEOUT_MS));
-				if (timeout <= 0) {
-					GENI_SE_ERR(mas->ipc, true, mas->dev,
-					 "Rx[%d] timeout%lu\n", i, timeout);
-					ret = -ETIMEDOUT;
-					goto err_gsi_geni_transfer_one;
-				}
-			}
-			if (mas->qn_err) {
+			ret = spi_gsi_wait_chain(mas, &mas->tx_done,
+					&mas->tx_expected, &mas->tx_cb,
+					mas->num_tx_eot);
+			if (!ret)
+				ret = spi_gsi_wait_chain(mas, &mas->rx_done,
+						&mas->rx_expected, &mas->rx_cb,
+						mas->num_rx_eot);
+			if (!ret && mas->qn_err)
 				ret = -EIO;
-				mas->qn_err = false;
+			mas->qn_err = false;
+			if (ret)
 				goto err_gsi_geni_transfer_one;
-			}
+			spi_gsi_reset_chain(mas);
 		}
 	}
 	return ret;
 err_gsi_geni_transfer_one:
 	geni_se_dump_dbg_regs(&mas->spi_rsc, mas->base, mas->ipc);
 	dmaengine_terminate_all(mas->tx);
+	spi_gsi_reset_chain(mas);
 	return ret;
 err_fifo_geni_transfer_one:
 	handle_fifo_timeout(mas, xfer);
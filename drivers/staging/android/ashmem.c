@@ -32,6 +32,7 @@
 #include <linux/bitops.h>
 #include <linux/mutex.h>
 #include <linux/shmem_fs.h>
+#include <linux/interval_tree_generic.h>
 #include "ashmem.h"
 
 #define ASHMEM_NAME_PREFIX "dev/ashmem/"
@@ -41,7 +42,10 @@
 /**
  * struct ashmem_area - The anonymous shared memory area
  * @name:		The optional name in /proc/pid/maps
- * @unpinned_list:	The list of all ashmem areas
+ * @unpinned:		The interval tree of this area's unpinned ranges
+ * @lru:		This area's ranges on the LRU, least recently unpinned
+ *			first
+ * @area_lru:		The entry in ashmem_lru_list while @lru isn't empty
  * @file:		The shmem-based backing file
  * @size:		The size of the mapping, in bytes
  * @prot_mask:		The allowed protection bits, as vm_flags
@@ -53,7 +57,9 @@
  */
 struct ashmem_area {
 	char name[ASHMEM_FULL_NAME_LEN];
-	struct list_head unpinned_list;
+	struct rb_root unpinned;
+	struct list_head lru;
+	struct list_head area_lru;
 	struct file *file;
 	size_t size;
 	unsigned long prot_mask;
@@ -61,8 +67,9 @@ struct ashmem_area {
 
 /**
  * struct ashmem_range - A range of unpinned/evictable pages
- * @lru:	         The entry in the LRU list
- * @unpinned:	         The entry in its area's unpinned list
+ * @lru:	         The entry in its area's LRU list
+ * @rb:		         The node in its area's unpinned interval tree
+ * @subtree_last:        The last page of the ranges below @rb
  * @asma:	         The associated anonymous shared memory area.
  * @pgstart:	         The starting page (inclusive)
  * @pgend:	         The ending page (inclusive)
@@ -73,14 +80,19 @@ struct ashmem_area {
  */
 struct ashmem_range {
 	struct list_head lru;
-	struct list_head unpinned;
+	struct rb_node rb;
+	size_t subtree_last;
 	struct ashmem_area *asma;
 	size_t pgstart;
 	size_t pgend;
 	unsigned int purged;
 };
 
-/* LRU list of unpinned pages, protected by ashmem_mutex */
+/*
+ * LRU list of areas with unpinned pages, protected by ashmem_mutex. An area
+ * moves to the tail whenever one of its ranges is unpinned, and the
+ * shrinker purges the ranges of the area at the head in batches.
+ */
 static LIST_HEAD(ashmem_lru_list);
 
 /*
@@ -97,6 +109,16 @@ static unsigned long lru_count;
  */
 static DEFINE_MUTEX(ashmem_mutex);
 
+/*
+ * The shrinker punches holes without ashmem_mutex held. Pinning waits for
+ * those in flight, so a range is never purged after it was pinned again.
+ */
+static atomic_t ashmem_shrink_inflight = ATOMIC_INIT(0);
+static DECLARE_WAIT_QUEUE_HEAD(ashmem_shrink_wait);
+
+/* Ranges purged per drop of ashmem_mutex in the shrinker */
+#define ASHMEM_SHRINK_BATCH	16
+
 static struct kmem_cache *ashmem_area_cachep __read_mostly;
 static struct kmem_cache *ashmem_range_cachep __read_mostly;
 
@@ -118,22 +140,11 @@ static inline int page_range_subsumed_by_range(struct ashmem_range *range,
 	return (((range)->pgstart <= (start)) && ((range)->pgend >= (end)));
 }
 
-static inline int page_in_range(struct ashmem_range *range, size_t page)
-{
-	return (((range)->pgstart <= (page)) && ((range)->pgend >= (page)));
-}
-
-static inline int page_range_in_range(struct ashmem_range *range,
-				      size_t start, size_t end)
-{
-	return (page_in_range(range, start) || page_in_range(range, end) ||
-		page_range_subsumes_range(range, start, end));
-}
+#define range_start(range)	((range)->pgstart)
+#define range_last(range)	((range)->pgend)
 
-static inline int range_before_page(struct ashmem_range *range, size_t page)
-{
-	return ((range)->pgend < (page));
-}
+INTERVAL_TREE_DEFINE(struct ashmem_range, rb, size_t, subtree_last,
+		     range_start, range_last, static, range_tree)
 
 #define PROT_MASK		(PROT_EXEC | PROT_READ | PROT_WRITE)
 
@@ -141,12 +152,14 @@ static inline int range_before_page(struct ashmem_range *range, size_t page)
  * lru_add() - Adds a range of memory to the LRU list
  * @range:     The memory range being added.
  *
- * The range is first added to the end (tail) of the LRU list.
+ * The range is first added to the end (tail) of its area's LRU list, and
+ * the area to the end of the global one.
  * After this, the size of the range is added to @lru_count
  */
 static inline void lru_add(struct ashmem_range *range)
 {
-	list_add_tail(&range->lru, &ashmem_lru_list);
+	list_add_tail(&range->lru, &range->asma->lru);
+	list_move_tail(&range->asma->area_lru, &ashmem_lru_list);
 	lru_count += range_size(range);
 }
 
@@ -154,19 +167,21 @@ static inline void lru_add(struct ashmem_range *range)
  * lru_del() - Removes a range of memory from the LRU list
  * @range:     The memory range being removed
  *
- * The range is first deleted from the LRU list.
+ * The range is first deleted from its area's LRU list, and the area from
+ * the global one if it was its last range.
  * After this, the size of the range is removed from @lru_count
  */
 static inline void lru_del(struct ashmem_range *range)
 {
 	list_del(&range->lru);
+	if (list_empty(&range->asma->lru))
+		list_del_init(&range->asma->area_lru);
 	lru_count -= range_size(range);
 }
 
 /**
  * range_alloc() - Allocates and initializes a new ashmem_range structure
  * @asma:	   The associated ashmem_area
- * @prev_range:	   The previous ashmem_range in the sorted asma->unpinned list
  * @purged:	   Initial purge status (ASMEM_NOT_PURGED or ASHMEM_WAS_PURGED)
  * @start:	   The starting page (inclusive)
  * @end:	   The ending page (inclusive)
@@ -175,8 +190,7 @@ static inline void lru_del(struct ashmem_range *range)
  *
  * Return: 0 if successful, or -ENOMEM if there is an error
  */
-static int range_alloc(struct ashmem_area *asma,
-		       struct ashmem_range *prev_range, unsigned int purged,
+static int range_alloc(struct ashmem_area *asma, unsigned int purged,
 		       size_t start, size_t end)
 {
 	struct ashmem_range *range;
@@ -190,7 +204,7 @@ static int range_alloc(struct ashmem_area *asma,
 	range->pgend = end;
 	range->purged = purged;
 
-	list_add_tail(&range->unpinned, &prev_range->unpinned);
+	range_tree_insert(range, &asma->unpinned);
 
 	if (range_on_lru(range))
 		lru_add(range);
@@ -204,7 +218,7 @@ static int range_alloc(struct ashmem_area *asma,
  */
 static void range_del(struct ashmem_range *range)
 {
-	list_del(&range->unpinned);
+	range_tree_remove(range, &range->asma->unpinned);
 	if (range_on_lru(range))
 		lru_del(range);
 	kmem_cache_free(ashmem_range_cachep, range);
@@ -227,8 +241,10 @@ static inline void range_shrink(struct ashmem_range *range,
 {
 	size_t pre = range_size(range);
 
+	range_tree_remove(range, &range->asma->unpinned);
 	range->pgstart = start;
 	range->pgend = end;
+	range_tree_insert(range, &range->asma->unpinned);
 
 	if (range_on_lru(range))
 		lru_count -= pre - range_size(range);
@@ -257,7 +273,9 @@ static int ashmem_open(struct inode *inode, struct file *file)
 	if (unlikely(!asma))
 		return -ENOMEM;
 
-	INIT_LIST_HEAD(&asma->unpinned_list);
+	asma->unpinned = RB_ROOT;
+	INIT_LIST_HEAD(&asma->lru);
+	INIT_LIST_HEAD(&asma->area_lru);
 	memcpy(asma->name, ASHMEM_NAME_PREFIX, ASHMEM_NAME_PREFIX_LEN);
 	asma->prot_mask = PROT_MASK;
 	file->private_data = asma;
@@ -276,11 +294,11 @@ static int ashmem_open(struct inode *inode, struct file *file)
 static int ashmem_release(struct inode *ignored, struct file *file)
 {
 	struct ashmem_area *asma = file->private_data;
-	struct ashmem_range *range, *next;
+	struct rb_node *node;
 
 	mutex_lock(&ashmem_mutex);
-	list_for_each_entry_safe(range, next, &asma->unpinned_list, unpinned)
-		range_del(range);
+	while ((node = rb_first(&asma->unpinned)))
+		range_del(rb_entry(node, struct ashmem_range, rb));
 	mutex_unlock(&ashmem_mutex);
 
 	if (asma->file)
@@ -467,14 +485,23 @@ out:
  * proceed without risk of deadlock (due to gfp_mask).
  *
  * We approximate LRU via least-recently-unpinned, jettisoning unpinned partial
- * chunks of ashmem regions LRU-wise one-at-a-time until we hit 'nr_to_scan'
- * pages freed.
+ * chunks of the least recently unpinned ashmem region, up to
+ * ASHMEM_SHRINK_BATCH at a time, until we hit 'nr_to_scan' ranges. The holes
+ * are punched with ashmem_mutex dropped, so pin and unpin calls of other
+ * areas are not held up by reclaim.
  */
 static unsigned long
 ashmem_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 {
-	struct ashmem_range *range, *next;
+	struct {
+		loff_t start;
+		loff_t len;
+	} batch[ASHMEM_SHRINK_BATCH];
+	struct ashmem_area *asma;
+	struct ashmem_range *range;
+	struct file *f;
 	unsigned long freed = 0;
+	int i, n;
 
 	/* We might recurse into filesystem code, so bail out if necessary */
 	if (!(sc->gfp_mask & __GFP_FS))
@@ -483,19 +510,38 @@ ashmem_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 	if (!mutex_trylock(&ashmem_mutex))
 		return -1;
 
-	list_for_each_entry_safe(range, next, &ashmem_lru_list, lru) {
-		loff_t start = range->pgstart * PAGE_SIZE;
-		loff_t end = (range->pgend + 1) * PAGE_SIZE;
+	while (!list_empty(&ashmem_lru_list) && sc->nr_to_scan) {
+		asma = list_first_entry(&ashmem_lru_list, struct ashmem_area,
+					area_lru);
+		for (n = 0; n < ASHMEM_SHRINK_BATCH && sc->nr_to_scan; n++) {
+			if (list_empty(&asma->lru))
+				break;
+			range = list_first_entry(&asma->lru,
+						 struct ashmem_range, lru);
+			batch[n].start = range->pgstart * PAGE_SIZE;
+			batch[n].len = range_size(range) * PAGE_SIZE;
+			range->purged = ASHMEM_WAS_PURGED;
+			lru_del(range);
+
+			freed += range_size(range);
+			sc->nr_to_scan--;
+		}
+
+		f = asma->file;
+		get_file(f);
+		atomic_inc(&ashmem_shrink_inflight);
+		mutex_unlock(&ashmem_mutex);
 
-		range->asma->file->f_op->fallocate(range->asma->file,
+		for (i = 0; i < n; i++)
+			f->f_op->fallocate(f,
 				FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
-				start, end - start);
-		range->purged = ASHMEM_WAS_PURGED;
-		lru_del(range);
+				batch[i].start, batch[i].len);
+		fput(f);
 
-		freed += range_size(range);
-		if (--sc->nr_to_scan <= 0)
-			break;
+		if (atomic_dec_and_test(&ashmem_shrink_inflight))
+			wake_up_all(&ashmem_shrink_wait);
+		if (!mutex_trylock(&ashmem_mutex))
+			return freed;
 	}
 	mutex_unlock(&ashmem_mutex);
 	return freed;
@@ -622,10 +668,9 @@ static int ashmem_pin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
 	struct ashmem_range *range, *next;
 	int ret = ASHMEM_NOT_PURGED;
 
-	list_for_each_entry_safe(range, next, &asma->unpinned_list, unpinned) {
-		/* moved past last applicable page; we can short circuit */
-		if (range_before_page(range, pgstart))
-			break;
+	range = range_tree_iter_first(&asma->unpinned, pgstart, pgend);
+	for (; range; range = next) {
+		next = range_tree_iter_next(range, pgstart, pgend);
 
 		/*
 		 * The user can ask us to pin pages that span multiple ranges,
@@ -642,38 +687,34 @@ static int ashmem_pin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
 		 *    so we have to update one side of the range and then
 		 *    create a new range for the other side.
 		 */
-		if (page_range_in_range(range, pgstart, pgend)) {
-			ret |= range->purged;
-
-			/* Case #1: Easy. Just nuke the whole thing. */
-			if (page_range_subsumes_range(range, pgstart, pgend)) {
-				range_del(range);
-				continue;
-			}
-
-			/* Case #2: We overlap from the start, so adjust it */
-			if (range->pgstart >= pgstart) {
-				range_shrink(range, pgend + 1, range->pgend);
-				continue;
-			}
-
-			/* Case #3: We overlap from the rear, so adjust it */
-			if (range->pgend <= pgend) {
-				range_shrink(range, range->pgstart,
-					     pgstart - 1);
-				continue;
-			}
-
-			/*
-			 * Case #4: We eat a chunk out of the middle. A bit
-			 * more complicated, we allocate a new range for the
-			 * second half and adjust the first chunk's endpoint.
-			 */
-			range_alloc(asma, range, range->purged,
-				    pgend + 1, range->pgend);
+		ret |= range->purged;
+
+		/* Case #1: Easy. Just nuke the whole thing. */
+		if (page_range_subsumes_range(range, pgstart, pgend)) {
+			range_del(range);
+			continue;
+		}
+
+		/* Case #2: We overlap from the start, so adjust it */
+		if (range->pgstart >= pgstart) {
+			range_shrink(range, pgend + 1, range->pgend);
+			continue;
+		}
+
+		/* Case #3: We overlap from the rear, so adjust it */
+		if (range->pgend <= pgend) {
 			range_shrink(range, range->pgstart, pgstart - 1);
-			break;
+			continue;
 		}
+
+		/*
+		 * Case #4: We eat a chunk out of the middle. A bit
+		 * more complicated, we allocate a new range for the
+		 * second half and adjust the first chunk's endpoint.
+		 */
+		range_alloc(asma, range->purged, pgend + 1, range->pgend);
+		range_shrink(range, range->pgstart, pgstart - 1);
+		break;
 	}
 
 	return ret;
@@ -686,31 +727,24 @@ static int ashmem_pin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
  */
 static int ashmem_unpin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
 {
-	struct ashmem_range *range, *next;
+	struct ashmem_range *range;
 	unsigned int purged = ASHMEM_NOT_PURGED;
 
-restart:
-	list_for_each_entry_safe(range, next, &asma->unpinned_list, unpinned) {
-		/* short circuit: this is our insertion point */
-		if (range_before_page(range, pgstart))
-			break;
-
-		/*
-		 * The user can ask us to unpin pages that are already entirely
-		 * or partially pinned. We handle those two cases here.
-		 */
+	/*
+	 * The user can ask us to unpin pages that are already entirely
+	 * or partially unpinned. We handle those two cases here.
+	 */
+	while ((range = range_tree_iter_first(&asma->unpinned, pgstart,
+					      pgend))) {
 		if (page_range_subsumed_by_range(range, pgstart, pgend))
 			return 0;
-		if (page_range_in_range(range, pgstart, pgend)) {
-			pgstart = min(range->pgstart, pgstart);
-			pgend = max(range->pgend, pgend);
-			purged |= range->purged;
-			range_del(range);
-			goto restart;
-		}
+		pgstart = min(range->pgstart, pgstart);
+		pgend = max(range->pgend, pgend);
+		purged |= range->purged;
+		range_del(range);
 	}
 
-	return range_alloc(asma, range, purged, pgstart, pgend);
+	return range_alloc(asma, purged, pgstart, pgend);
 }
 
 /*
@@ -722,19 +756,10 @@ restart:
 static int ashmem_get_pin_status(struct ashmem_area *asma, size_t pgstart,
 				 size_t pgend)
 {
-	struct ashmem_range *range;
-	int ret = ASHMEM_IS_PINNED;
-
-	list_for_each_entry(range, &asma->unpinned_list, unpinned) {
-		if (range_before_page(range, pgstart))
-			break;
-		if (page_range_in_range(range, pgstart, pgend)) {
-			ret = ASHMEM_IS_UNPINNED;
-			break;
-		}
-	}
+	if (range_tree_iter_first(&asma->unpinned, pgstart, pgend))
+		return ASHMEM_IS_UNPINNED;
 
-	return ret;
+	return ASHMEM_IS_PINNED;
 }
 
 static int ashmem_pin_unpin(struct ashmem_area *asma, unsigned long cmd,
@@ -748,6 +773,7 @@ static int ashmem_pin_unpin(struct ashmem_area *asma, unsigned long cmd,
 		return -EFAULT;
 
 	mutex_lock(&ashmem_mutex);
+	wait_event(ashmem_shrink_wait, !atomic_read(&ashmem_shrink_inflight));
 
 	if (unlikely(!asma->file))
 		goto out_unlock;
@@ -155,6 +155,103 @@ static inline void ion_buffer_page_clean(struct page **page)
 	*page = (struct page *)((unsigned long)(*page) & ~(1UL));
 }
 
+/* this function should only be called while buffer->lock is held */
+static void ion_buffer_cpu_dirty(struct ion_buffer *buffer, size_t offset,
+				 size_t len)
+{
+	size_t end = min(offset + len, buffer->size);
+
+	if (buffer->cpu_dirty_start >= buffer->cpu_dirty_end) {
+		buffer->cpu_dirty_start = offset;
+		buffer->cpu_dirty_end = end;
+		return;
+	}
+	buffer->cpu_dirty_start = min(buffer->cpu_dirty_start, offset);
+	buffer->cpu_dirty_end = max(buffer->cpu_dirty_end, end);
+}
+
+/*
+ * this function should only be called while buffer->lock is held
+ * Returns false while the cpu has a mapping it can use without ion noticing.
+ */
+static bool ion_buffer_cpu_tracked(struct ion_buffer *buffer)
+{
+	return !(buffer->private_flags & ION_PRIV_FLAG_CPU_MAPPED) &&
+	       !buffer->kmap_cnt && list_empty(&buffer->vmas);
+}
+
+/*
+ * this function should only be called while buffer->lock is held
+ * Every cpu access ion sees goes through here, so an invalidate a device
+ * driver deferred is done before the cpu can read stale lines.
+ */
+static void ion_buffer_cpu_access(struct ion_buffer *buffer)
+{
+	buffer->cpu_access_seq++;
+	if (buffer->private_flags & ION_PRIV_FLAG_DEFERRED_INV) {
+		dma_sync_sg_for_cpu(NULL, buffer->sg_table->sgl,
+				    buffer->sg_table->nents, DMA_FROM_DEVICE);
+		buffer->private_flags &= ~ION_PRIV_FLAG_DEFERRED_INV;
+	}
+}
+
+/*
+ * this function should only be called while buffer->lock is held
+ * Same as ion_buffer_cpu_access() for a cpu that only reads
+ * [offset, offset + len): just that range is invalidated and the deferred
+ * invalidate stays pending for the rest. Invalidating the clean range again
+ * later is harmless, which is not true once the cpu may have written to it,
+ * so writers take the whole-buffer path.
+ */
+static void ion_buffer_cpu_access_range(struct ion_buffer *buffer,
+					size_t offset, size_t len,
+					enum dma_data_direction direction)
+{
+	struct scatterlist *sg, range;
+	size_t pos = 0, end = offset + len;
+	size_t start, stop;
+	int i;
+
+	if (direction != DMA_FROM_DEVICE) {
+		ion_buffer_cpu_access(buffer);
+		return;
+	}
+
+	buffer->cpu_access_seq++;
+	if (!(buffer->private_flags & ION_PRIV_FLAG_DEFERRED_INV))
+		return;
+
+	for_each_sg(buffer->sg_table->sgl, sg, buffer->sg_table->nents, i) {
+		if (pos >= end)
+			break;
+		if (pos + sg->length > offset) {
+			start = max(offset, pos) - pos;
+			stop = min(end, pos + sg->length) - pos;
+			sg_init_table(&range, 1);
+			sg_set_page(&range, sg_page(sg), stop - start,
+				    sg->offset + start);
+			sg_dma_address(&range) = sg_phys(&range);
+			dma_sync_sg_for_cpu(NULL, &range, 1, DMA_FROM_DEVICE);
+		}
+		pos += sg->length;
+	}
+}
+
+/*
+ * this function should only be called while buffer->lock is held
+ * Returns false if the whole buffer has to be treated as dirty.
+ */
+static bool ion_buffer_cpu_dirty_range(struct ion_buffer *buffer,
+				       size_t *start, size_t *end)
+{
+	if (!ion_buffer_cpu_tracked(buffer))
+		return false;
+
+	*start = buffer->cpu_dirty_start;
+	*end = buffer->cpu_dirty_end;
+	return true;
+}
+
 /* this function should only be called while dev->lock is held */
 static void ion_buffer_add(struct ion_device *dev,
 			   struct ion_buffer *buffer)
@@ -217,6 +314,12 @@ static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 	buffer->dev = dev;
 	buffer->size = len;
 	INIT_LIST_HEAD(&buffer->vmas);
+	/*
+	 * The system heap hands out pages already synced for device, other
+	 * heaps make no such promise so start them out dirty.
+	 */
+	if (heap->type != ION_HEAP_TYPE_SYSTEM)
+		buffer->cpu_dirty_end = len;
 
 	table = heap->ops->map_dma(heap, buffer);
 	if (WARN_ONCE(!table,
@@ -764,6 +867,7 @@ static void *ion_buffer_kmap_get(struct ion_buffer *buffer)
 {
 	void *vaddr;
 
+	ion_buffer_cpu_access(buffer);
 	if (buffer->kmap_cnt) {
 		if (buffer->kmap_cnt == INT_MAX)
 			return ERR_PTR(-EOVERFLOW);
@@ -807,6 +911,7 @@ static void ion_buffer_kmap_put(struct ion_buffer *buffer)
 	if (!buffer->kmap_cnt) {
 		buffer->heap->ops->unmap_kernel(buffer->heap, buffer);
 		buffer->vaddr = NULL;
+		ion_buffer_cpu_dirty(buffer, 0, buffer->size);
 	}
 }
 
@@ -1066,6 +1171,46 @@ int ion_handle_get_flags(struct ion_client *client, struct ion_handle *handle,
 }
 EXPORT_SYMBOL(ion_handle_get_flags);
 
+bool ion_handle_cpu_access_seq(struct ion_client *client,
+			       struct ion_handle *handle, unsigned int *seq)
+{
+	struct ion_buffer *buffer;
+	bool tracked;
+
+	mutex_lock(&client->lock);
+	if (!ion_handle_validate(client, handle)) {
+		mutex_unlock(&client->lock);
+		return false;
+	}
+	buffer = handle->buffer;
+	mutex_lock(&buffer->lock);
+	tracked = ion_buffer_cpu_tracked(buffer);
+	*seq = buffer->cpu_access_seq;
+	mutex_unlock(&buffer->lock);
+	mutex_unlock(&client->lock);
+
+	return tracked;
+}
+EXPORT_SYMBOL(ion_handle_cpu_access_seq);
+
+void ion_handle_defer_cpu_inv(struct ion_client *client,
+			      struct ion_handle *handle)
+{
+	struct ion_buffer *buffer;
+
+	mutex_lock(&client->lock);
+	if (!ion_handle_validate(client, handle)) {
+		mutex_unlock(&client->lock);
+		return;
+	}
+	buffer = handle->buffer;
+	mutex_lock(&buffer->lock);
+	buffer->private_flags |= ION_PRIV_FLAG_DEFERRED_INV;
+	mutex_unlock(&buffer->lock);
+	mutex_unlock(&client->lock);
+}
+EXPORT_SYMBOL(ion_handle_defer_cpu_inv);
+
 int ion_handle_get_size(struct ion_client *client, struct ion_handle *handle,
 			size_t *size)
 {
@@ -1258,7 +1403,9 @@ static int ion_vm_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	int ret;
 
 	mutex_lock(&buffer->lock);
+	ion_buffer_cpu_access(buffer);
 	ion_buffer_page_dirty(buffer->pages + vmf->pgoff);
+	ion_buffer_cpu_dirty(buffer, vmf->pgoff * PAGE_SIZE, PAGE_SIZE);
 	BUG_ON(!buffer->pages || !buffer->pages[vmf->pgoff]);
 
 	pfn = page_to_pfn(ion_buffer_page(buffer->pages[vmf->pgoff]));
@@ -1334,8 +1481,11 @@ static int ion_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 
 	mutex_lock(&buffer->lock);
+	ion_buffer_cpu_access(buffer);
 	/* now map it to userspace */
 	ret = buffer->heap->ops->map_user(buffer->heap, buffer, vma);
+	if (!ret)
+		buffer->private_flags |= ION_PRIV_FLAG_CPU_MAPPED;
 	mutex_unlock(&buffer->lock);
 
 	if (ret)
@@ -1388,6 +1538,29 @@ static void ion_dma_buf_kunmap(struct dma_buf *dmabuf, unsigned long offset,
 static int ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 					enum dma_data_direction direction)
 {
+	struct ion_buffer *buffer = dmabuf->priv;
+
+	mutex_lock(&buffer->lock);
+	ion_buffer_cpu_access(buffer);
+	/* A cpu that only reads leaves nothing to clean */
+	if (direction != DMA_FROM_DEVICE)
+		ion_buffer_cpu_dirty(buffer, 0, buffer->size);
+	mutex_unlock(&buffer->lock);
+	return 0;
+}
+
+static int ion_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
+						enum dma_data_direction direction,
+						unsigned int offset,
+						unsigned int len)
+{
+	struct ion_buffer *buffer = dmabuf->priv;
+
+	mutex_lock(&buffer->lock);
+	ion_buffer_cpu_access_range(buffer, offset, len, direction);
+	if (direction != DMA_FROM_DEVICE)
+		ion_buffer_cpu_dirty(buffer, offset, len);
+	mutex_unlock(&buffer->lock);
 	return 0;
 }
 
@@ -1404,6 +1577,7 @@ static struct dma_buf_ops dma_buf_ops = {
 	.release = ion_dma_buf_release,
 	.begin_cpu_access = ion_dma_buf_begin_cpu_access,
 	.end_cpu_access = ion_dma_buf_end_cpu_access,
+	.begin_cpu_access_partial = ion_dma_buf_begin_cpu_access_partial,
 	.kmap_atomic = ion_dma_buf_kmap,
 	.kunmap_atomic = ion_dma_buf_kunmap,
 	.kmap = ion_dma_buf_kmap,
@@ -1568,6 +1742,9 @@ static int ion_sync_for_device(struct ion_client *client, int fd)
 {
 	struct dma_buf *dmabuf;
 	struct ion_buffer *buffer;
+	struct scatterlist *sg;
+	size_t start, end, offset = 0;
+	int i;
 
 	dmabuf = dma_buf_get(fd);
 	if (IS_ERR(dmabuf))
@@ -1587,8 +1764,27 @@ static int ion_sync_for_device(struct ion_client *client, int fd)
 		dma_buf_put(dmabuf);
 		return -EINVAL;
 	}
-	dma_sync_sg_for_device(NULL, buffer->sg_table->sgl,
-			       buffer->sg_table->nents, DMA_BIDIRECTIONAL);
+
+	mutex_lock(&buffer->lock);
+	if (!ion_buffer_cpu_dirty_range(buffer, &start, &end)) {
+		dma_sync_sg_for_device(NULL, buffer->sg_table->sgl,
+				       buffer->sg_table->nents,
+				       DMA_BIDIRECTIONAL);
+	} else if (start < end) {
+		/* Only the entries overlapping what the cpu touched */
+		for_each_sg(buffer->sg_table->sgl, sg,
+			    buffer->sg_table->nents, i) {
+			if (offset < end && offset + sg->length > start)
+				dma_sync_sg_for_device(NULL, sg, 1,
+						       DMA_BIDIRECTIONAL);
+			offset += sg->length;
+			if (offset >= end)
+				break;
+		}
+	}
+	buffer->cpu_dirty_start = 0;
+	buffer->cpu_dirty_end = 0;
+	mutex_unlock(&buffer->lock);
 	dma_buf_put(dmabuf);
 	return 0;
 }
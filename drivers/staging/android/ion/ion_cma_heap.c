@@ -21,9 +21,14 @@
 #include <linux/slab.h>
 #include <linux/errno.h>
 #include <linux/err.h>
+#include <linux/cma.h>
+#include <linux/dma-contiguous.h>
 #include <linux/dma-mapping.h>
+#include <linux/ktime.h>
 #include <linux/msm_ion.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/workqueue.h>
 
 #include <asm/cacheflush.h>
 #include <soc/qcom/secure_buffer.h>
@@ -33,6 +38,11 @@
 
 #define ION_CMA_ALLOCATE_FAILED -1
 
+/* below 1ms, then doubling up to 1s and above */
+#define ION_CMA_LAT_BUCKETS		12
+/* how long a prefetched range is held for an allocation to use it */
+#define ION_CMA_PREFETCH_TIMEOUT	msecs_to_jiffies(5000)
+
 struct ion_cma_buffer_info {
 	void *cpu_addr;
 	dma_addr_t handle;
@@ -40,6 +50,46 @@ struct ion_cma_buffer_info {
 	bool is_cached;
 };
 
+/**
+ * struct ion_cma_heap - cma heap with allocation prefetch
+ * @heap:		the ion heap, priv is the device owning the cma area
+ * @cma:		the cma area of the device
+ * @lock:		protects everything below
+ * @prefetch_want:	pages requested by the last prefetch, 0 if none
+ * @prefetch_pages:	the prefetched range, NULL if none is held
+ * @prefetch_count:	pages in @prefetch_pages
+ * @prefetch_work:	migrates the movable pages out of the range
+ * @expire_work:	gives an unused range back to the cma area
+ * @prefetch_hits:	allocations made right after a prefetch
+ * @prefetch_expired:	prefetched ranges no allocation came for
+ * @lat:		allocation latency histogram
+ * @max_lat_us:		worst allocation latency
+ *
+ * Allocating from cma migrates the movable pages out of the chosen range
+ * first, which takes from milliseconds to hundreds of milliseconds for
+ * buffers of camera or secure video size. A prefetch hint, sent before
+ * the allocations are needed, does the migration in the background by
+ * allocating the range and holding it for ION_CMA_PREFETCH_TIMEOUT. The
+ * next allocation gives the range back right before allocating, so it
+ * finds the pages free and only has to isolate them.
+ */
+struct ion_cma_heap {
+	struct ion_heap heap;
+	struct cma *cma;
+	struct mutex lock;
+	unsigned long prefetch_want;
+	struct page *prefetch_pages;
+	unsigned long prefetch_count;
+	struct work_struct prefetch_work;
+	struct delayed_work expire_work;
+	unsigned long prefetch_hits;
+	unsigned long prefetch_expired;
+	unsigned long lat[ION_CMA_LAT_BUCKETS];
+	u64 max_lat_us;
+};
+
+#define to_cma_heap(x) container_of(x, struct ion_cma_heap, heap)
+
 static int cma_heap_has_outer_cache;
 /*
  * Create scatter-list for the already allocated DMA buffer.
@@ -73,6 +123,182 @@ static bool ion_cma_has_kernel_mapping(struct ion_heap *heap)
 	return !of_property_read_bool(mem_region, "no-map");
 }
 
+static void ion_cma_prefetch_work(struct work_struct *work)
+{
+	struct ion_cma_heap *cma_heap = container_of(work, struct ion_cma_heap,
+						     prefetch_work);
+	unsigned long count;
+	struct page *pages;
+
+	mutex_lock(&cma_heap->lock);
+	count = cma_heap->prefetch_want;
+	if (!count || cma_heap->prefetch_pages) {
+		mutex_unlock(&cma_heap->lock);
+		return;
+	}
+	mutex_unlock(&cma_heap->lock);
+
+	/* the migration, done without the lock so allocations never wait */
+	pages = cma_alloc(cma_heap->cma, count, 0);
+	if (!pages) {
+		pr_debug("%s: %s: prefetch of %lu pages failed\n", __func__,
+			 cma_heap->heap.name, count);
+		return;
+	}
+
+	mutex_lock(&cma_heap->lock);
+	if (cma_heap->prefetch_want != count || cma_heap->prefetch_pages) {
+		/* an allocation or a drain came first */
+		mutex_unlock(&cma_heap->lock);
+		cma_release(cma_heap->cma, pages, count);
+		return;
+	}
+	cma_heap->prefetch_pages = pages;
+	cma_heap->prefetch_count = count;
+	mod_delayed_work(system_wq, &cma_heap->expire_work,
+			 ION_CMA_PREFETCH_TIMEOUT);
+	mutex_unlock(&cma_heap->lock);
+}
+
+/*
+ * Take the prefetched range away, if any, and forget the request. Returns
+ * the number of pages the caller has to release.
+ */
+static unsigned long ion_cma_prefetch_take(struct ion_cma_heap *cma_heap,
+					   struct page **pages)
+{
+	unsigned long count = cma_heap->prefetch_count;
+
+	*pages = cma_heap->prefetch_pages;
+	cma_heap->prefetch_pages = NULL;
+	cma_heap->prefetch_count = 0;
+	cma_heap->prefetch_want = 0;
+
+	return *pages ? count : 0;
+}
+
+static void ion_cma_expire_work(struct work_struct *work)
+{
+	struct ion_cma_heap *cma_heap = container_of(to_delayed_work(work),
+						     struct ion_cma_heap,
+						     expire_work);
+	unsigned long count;
+	struct page *pages;
+
+	mutex_lock(&cma_heap->lock);
+	count = ion_cma_prefetch_take(cma_heap, &pages);
+	if (count)
+		cma_heap->prefetch_expired++;
+	mutex_unlock(&cma_heap->lock);
+
+	if (count)
+		cma_release(cma_heap->cma, pages, count);
+}
+
+/**
+ * ion_cma_heap_prefetch() - prepare the heap for allocations of len bytes
+ * @heap:	a cma heap
+ * @data:	the number of bytes, as in ion_prefetch_data.len
+ *
+ * Starts migrating movable pages out of a range of the cma area large
+ * enough for len bytes, sent ahead of a burst of allocations such as
+ * opening the camera. Returns at once; the range is held until the next
+ * allocation or for ION_CMA_PREFETCH_TIMEOUT.
+ */
+int ion_cma_heap_prefetch(struct ion_heap *heap, void *data)
+{
+	struct ion_cma_heap *cma_heap = to_cma_heap(heap);
+	unsigned long len = (unsigned long)data;
+
+	if (!cma_heap->cma || !len)
+		return -EINVAL;
+
+	len = min(PAGE_ALIGN(len), cma_get_size(cma_heap->cma));
+
+	mutex_lock(&cma_heap->lock);
+	if (!cma_heap->prefetch_pages)
+		cma_heap->prefetch_want = len >> PAGE_SHIFT;
+	mutex_unlock(&cma_heap->lock);
+
+	schedule_work(&cma_heap->prefetch_work);
+
+	return 0;
+}
+
+/**
+ * ion_cma_heap_drain() - give a prefetched range back to the cma area
+ * @heap:	a cma heap
+ * @unused:	unused
+ */
+int ion_cma_heap_drain(struct ion_heap *heap, void *unused)
+{
+	struct ion_cma_heap *cma_heap = to_cma_heap(heap);
+	unsigned long count;
+	struct page *pages;
+
+	mutex_lock(&cma_heap->lock);
+	count = ion_cma_prefetch_take(cma_heap, &pages);
+	mutex_unlock(&cma_heap->lock);
+
+	if (count)
+		cma_release(cma_heap->cma, pages, count);
+
+	return 0;
+}
+
+static void ion_cma_record_latency(struct ion_cma_heap *cma_heap,
+				   ktime_t start)
+{
+	u64 us = ktime_us_delta(ktime_get(), start);
+	int bucket = min_t(int, fls64(div_u64(us, USEC_PER_MSEC)),
+			   ION_CMA_LAT_BUCKETS - 1);
+
+	mutex_lock(&cma_heap->lock);
+	cma_heap->lat[bucket]++;
+	cma_heap->max_lat_us = max(cma_heap->max_lat_us, us);
+	mutex_unlock(&cma_heap->lock);
+}
+
+static void *ion_cma_alloc_dma(struct ion_heap *heap, unsigned long len,
+			       dma_addr_t *handle, unsigned long flags)
+{
+	struct ion_cma_heap *cma_heap = to_cma_heap(heap);
+	struct device *dev = heap->priv;
+	unsigned long count;
+	struct page *pages;
+	ktime_t start;
+	void *cpu_addr;
+
+	start = ktime_get();
+
+	/*
+	 * Hand the prefetched pages back, now free of movable pages, so
+	 * the allocation below finds them without migrating anything.
+	 */
+	mutex_lock(&cma_heap->lock);
+	count = ion_cma_prefetch_take(cma_heap, &pages);
+	if (count)
+		cma_heap->prefetch_hits++;
+	mutex_unlock(&cma_heap->lock);
+
+	if (count) {
+		cancel_delayed_work(&cma_heap->expire_work);
+		cma_release(cma_heap->cma, pages, count);
+	}
+
+	if (!ION_IS_CACHED(flags))
+		cpu_addr = dma_alloc_writecombine(dev, len, handle,
+						  GFP_KERNEL);
+	else
+		cpu_addr = dma_alloc_attrs(dev, len, handle, GFP_KERNEL,
+					   DMA_ATTR_FORCE_COHERENT);
+
+	if (cpu_addr)
+		ion_cma_record_latency(cma_heap, start);
+
+	return cpu_addr;
+}
+
 /* ION CMA heap operations functions */
 static int ion_cma_allocate(struct ion_heap *heap, struct ion_buffer *buffer,
 			    unsigned long len, unsigned long align,
@@ -91,15 +317,7 @@ static int ion_cma_allocate(struct ion_heap *heap, struct ion_buffer *buffer,
 		buffer->flags = flags;
 	}
 
-	if (!ION_IS_CACHED(flags))
-		info->cpu_addr = dma_alloc_writecombine(dev, len,
-							&info->handle,
-							GFP_KERNEL);
-	else
-		info->cpu_addr = dma_alloc_attrs(dev, len, &info->handle,
-						GFP_KERNEL,
-						DMA_ATTR_FORCE_COHERENT);
-
+	info->cpu_addr = ion_cma_alloc_dma(heap, len, &info->handle, flags);
 	if (!info->cpu_addr) {
 		dev_err(dev, "Fail to allocate buffer\n");
 		goto err;
@@ -234,6 +452,29 @@ static int ion_cma_print_debug(struct ion_heap *heap, struct seq_file *s,
 	return 0;
 }
 
+static int ion_cma_debug_show(struct ion_heap *heap, struct seq_file *s,
+			      void *unused)
+{
+	struct ion_cma_heap *cma_heap = to_cma_heap(heap);
+	int i;
+
+	if (!s)
+		return 0;
+
+	mutex_lock(&cma_heap->lock);
+	seq_printf(s, "prefetched pages: %lu hits: %lu expired: %lu\n",
+		   cma_heap->prefetch_count, cma_heap->prefetch_hits,
+		   cma_heap->prefetch_expired);
+	seq_puts(s, "allocation latency:\n");
+	for (i = 0; i < ION_CMA_LAT_BUCKETS - 1; i++)
+		seq_printf(s, "  < %4u ms: %lu\n", 1U << i, cma_heap->lat[i]);
+	seq_printf(s, "  >= %3u ms: %lu\n", 1U << (i - 1), cma_heap->lat[i]);
+	seq_printf(s, "  max: %llu us\n", cma_heap->max_lat_us);
+	mutex_unlock(&cma_heap->lock);
+
+	return 0;
+}
+
 static struct ion_heap_ops ion_cma_ops = {
 	.allocate = ion_cma_allocate,
 	.free = ion_cma_free,
@@ -246,29 +487,54 @@ static struct ion_heap_ops ion_cma_ops = {
 	.print_debug = ion_cma_print_debug,
 };
 
-struct ion_heap *ion_cma_heap_create(struct ion_platform_heap *data)
+static struct ion_heap *__ion_cma_heap_create(struct ion_platform_heap *data)
 {
-	struct ion_heap *heap;
+	struct ion_cma_heap *cma_heap;
 
-	heap = kzalloc(sizeof(*heap), GFP_KERNEL);
+	cma_heap = kzalloc(sizeof(*cma_heap), GFP_KERNEL);
 
-	if (!heap)
+	if (!cma_heap)
 		return ERR_PTR(-ENOMEM);
 
-	heap->ops = &ion_cma_ops;
 	/*
 	 * set device as private heaps data, later it will be
 	 * used to make the link with reserved CMA memory
 	 */
-	heap->priv = data->priv;
-	heap->type = (enum ion_heap_type)ION_HEAP_TYPE_DMA;
+	cma_heap->heap.priv = data->priv;
+	cma_heap->heap.debug_show = ion_cma_debug_show;
+	cma_heap->cma = dev_get_cma_area(data->priv);
+	mutex_init(&cma_heap->lock);
+	INIT_WORK(&cma_heap->prefetch_work, ion_cma_prefetch_work);
+	INIT_DELAYED_WORK(&cma_heap->expire_work, ion_cma_expire_work);
 	cma_heap_has_outer_cache = data->has_outer_cache;
+	return &cma_heap->heap;
+}
+
+static void __ion_cma_heap_destroy(struct ion_heap *heap)
+{
+	struct ion_cma_heap *cma_heap = to_cma_heap(heap);
+
+	cancel_work_sync(&cma_heap->prefetch_work);
+	cancel_delayed_work_sync(&cma_heap->expire_work);
+	ion_cma_heap_drain(heap, NULL);
+	kfree(cma_heap);
+}
+
+struct ion_heap *ion_cma_heap_create(struct ion_platform_heap *data)
+{
+	struct ion_heap *heap = __ion_cma_heap_create(data);
+
+	if (IS_ERR(heap))
+		return heap;
+
+	heap->ops = &ion_cma_ops;
+	heap->type = (enum ion_heap_type)ION_HEAP_TYPE_DMA;
 	return heap;
 }
 
 void ion_cma_heap_destroy(struct ion_heap *heap)
 {
-	kfree(heap);
+	__ion_cma_heap_destroy(heap);
 }
 
 static void ion_secure_cma_free(struct ion_buffer *buffer)
@@ -430,25 +696,17 @@ static struct ion_heap_ops ion_secure_cma_ops = {
 
 struct ion_heap *ion_cma_secure_heap_create(struct ion_platform_heap *data)
 {
-	struct ion_heap *heap;
+	struct ion_heap *heap = __ion_cma_heap_create(data);
 
-	heap = kzalloc(sizeof(*heap), GFP_KERNEL);
-
-	if (!heap)
-		return ERR_PTR(-ENOMEM);
+	if (IS_ERR(heap))
+		return heap;
 
 	heap->ops = &ion_secure_cma_ops;
-	/*
-	 *  set device as private heaps data, later it will be
-	 * used to make the link with reserved CMA memory
-	 */
-	heap->priv = data->priv;
 	heap->type = (enum ion_heap_type)ION_HEAP_TYPE_HYP_CMA;
-	cma_heap_has_outer_cache = data->has_outer_cache;
 	return heap;
 }
 
 void ion_cma_secure_heap_destroy(struct ion_heap *heap)
 {
-	kfree(heap);
+	__ion_cma_heap_destroy(heap);
 }
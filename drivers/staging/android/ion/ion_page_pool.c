@@ -55,9 +55,18 @@ static void ion_page_pool_free_pages(struct ion_page_pool *pool,
 	__free_pages(page, pool->order);
 }
 
-static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+static void ion_page_pool_account(struct ion_page_pool *pool,
+				  struct page *page, bool add)
+{
+	long bytes = 1 << (PAGE_SHIFT + pool->order);
+
+	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
+			    add ? bytes : -bytes);
+}
+
+/* Caller should hold pool->mutex */
+static void __ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
 {
-	mutex_lock(&pool->mutex);
 	if (PageHighMem(page)) {
 		list_add_tail(&page->lru, &pool->high_items);
 		pool->high_count++;
@@ -65,13 +74,17 @@ static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
 		list_add_tail(&page->lru, &pool->low_items);
 		pool->low_count++;
 	}
+}
 
-	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
-			    (1 << (PAGE_SHIFT + pool->order)));
+static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+{
+	mutex_lock(&pool->mutex);
+	__ion_page_pool_add(pool, page);
 	mutex_unlock(&pool->mutex);
 	return 0;
 }
 
+/* Caller should hold pool->mutex */
 static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 {
 	struct page *page;
@@ -87,11 +100,150 @@ static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 	}
 
 	list_del(&page->lru);
-	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
-			    -(1 << (PAGE_SHIFT + pool->order)));
 	return page;
 }
 
+/*
+ * Per-cpu front cache. Pages move between it and the pool lists in
+ * batches so the pool mutex is taken once per pcp_batch pages. The
+ * per-cpu lock is only ever contended by ion_page_pool_drain_pcp().
+ */
+static struct page *ion_page_pool_pcp_alloc(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	struct page *batch[ION_POOL_PCP_MAX_PAGES];
+	struct page *page = NULL;
+	int i, nr = 0;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (pcp->count) {
+		page = pcp->pages[--pcp->count];
+		pcp->hits++;
+	}
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+	if (page)
+		return page;
+
+	/* Don't wait behind a shrinker, the caller can fall back to buddy */
+	if (!mutex_trylock(&pool->mutex))
+		return NULL;
+	while (nr < pool->pcp_batch && (pool->high_count || pool->low_count))
+		batch[nr++] = ion_page_pool_remove(pool, !!pool->high_count);
+	mutex_unlock(&pool->mutex);
+
+	if (!nr)
+		return NULL;
+
+	page = batch[--nr];
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	pcp->refills++;
+	while (nr && pcp->count < pool->pcp_high)
+		pcp->pages[pcp->count++] = batch[--nr];
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	/* Someone else refilled this cpu meanwhile */
+	if (nr) {
+		mutex_lock(&pool->mutex);
+		for (i = 0; i < nr; i++)
+			__ion_page_pool_add(pool, batch[i]);
+		mutex_unlock(&pool->mutex);
+	}
+
+	return page;
+}
+
+static void ion_page_pool_pcp_free(struct ion_page_pool *pool,
+				   struct page *page)
+{
+	struct ion_page_pool_pcp *pcp;
+	struct page *batch[ION_POOL_PCP_MAX_PAGES];
+	int i, nr = 0;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (pcp->count >= pool->pcp_high) {
+		while (nr < pool->pcp_batch)
+			batch[nr++] = pcp->pages[--pcp->count];
+		pcp->drains++;
+	}
+	pcp->pages[pcp->count++] = page;
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	if (!nr)
+		return;
+
+	mutex_lock(&pool->mutex);
+	for (i = 0; i < nr; i++)
+		__ion_page_pool_add(pool, batch[i]);
+	mutex_unlock(&pool->mutex);
+}
+
+/* Flush every cpu's front cache back to the pool lists */
+static void ion_page_pool_drain_pcp(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	LIST_HEAD(pages);
+	struct page *page, *tmp;
+	int cpu;
+
+	if (!pool->pcp)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock(&pcp->lock);
+		while (pcp->count)
+			list_add(&pcp->pages[--pcp->count]->lru, &pages);
+		spin_unlock(&pcp->lock);
+	}
+
+	if (list_empty(&pages))
+		return;
+
+	mutex_lock(&pool->mutex);
+	list_for_each_entry_safe(page, tmp, &pages, lru) {
+		list_del(&page->lru);
+		__ion_page_pool_add(pool, page);
+	}
+	mutex_unlock(&pool->mutex);
+}
+
+int ion_page_pool_pcp_count(struct ion_page_pool *pool)
+{
+	int cpu, count = 0;
+
+	if (!pool->pcp)
+		return 0;
+
+	for_each_possible_cpu(cpu)
+		count += READ_ONCE(per_cpu_ptr(pool->pcp, cpu)->count);
+
+	return count;
+}
+
+void ion_page_pool_pcp_stats(struct ion_page_pool *pool, unsigned long *hits,
+			     unsigned long *refills, unsigned long *drains)
+{
+	struct ion_page_pool_pcp *pcp;
+	int cpu;
+
+	*hits = *refills = *drains = 0;
+	if (!pool->pcp)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		*hits += pcp->hits;
+		*refills += pcp->refills;
+		*drains += pcp->drains;
+	}
+}
+
 void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 {
 	struct page *page = NULL;
@@ -100,14 +252,19 @@ void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 
 	*from_pool = true;
 
-	if (mutex_trylock(&pool->mutex)) {
+	if (pool->pcp)
+		page = ion_page_pool_pcp_alloc(pool);
+
+	if (!page && mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_page_pool_remove(pool, true);
 		else if (pool->low_count)
 			page = ion_page_pool_remove(pool, false);
 		mutex_unlock(&pool->mutex);
 	}
-	if (!page) {
+	if (page) {
+		ion_page_pool_account(pool, page, false);
+	} else {
 		page = ion_page_pool_alloc_pages(pool);
 		*from_pool = false;
 	}
@@ -132,16 +289,25 @@ void *ion_page_pool_alloc_pool_only(struct ion_page_pool *pool)
 		mutex_unlock(&pool->mutex);
 	}
 
+	if (page)
+		ion_page_pool_account(pool, page, false);
+
 	return page;
 }
 
 void ion_page_pool_free(struct ion_page_pool *pool, struct page *page)
 {
-	int ret;
+	int ret = 0;
 
-	ret = ion_page_pool_add(pool, page);
-	if (ret)
+	ion_page_pool_account(pool, page, true);
+	if (pool->pcp)
+		ion_page_pool_pcp_free(pool, page);
+	else
+		ret = ion_page_pool_add(pool, page);
+	if (ret) {
+		ion_page_pool_account(pool, page, false);
 		ion_page_pool_free_pages(pool, page);
+	}
 }
 
 void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
@@ -149,6 +315,38 @@ void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 	ion_page_pool_free_pages(pool, page);
 }
 
+/*
+ * Top the pool up to @target order-0 pages with freshly zeroed pages. Never
+ * enters reclaim, so it stops early once free memory runs short. Returns
+ * the number of order-0 pages added.
+ */
+int ion_page_pool_refill(struct ion_page_pool *pool, int target)
+{
+	gfp_t gfp_mask = (pool->gfp_mask | __GFP_NOWARN | __GFP_NORETRY) &
+			 ~(__GFP_RECLAIM | __GFP_ZERO);
+	struct page *page;
+	int added = 0;
+
+	while (ion_page_pool_total(pool, true) < target) {
+		page = alloc_pages(gfp_mask, pool->order);
+		if (!page)
+			break;
+
+		if (msm_ion_heap_high_order_page_zero(pool->dev, page,
+						      pool->order)) {
+			__free_pages(page, pool->order);
+			break;
+		}
+
+		ion_page_pool_alloc_set_cache_policy(pool, page);
+		ion_page_pool_free(pool, page);
+		added += 1 << pool->order;
+		cond_resched();
+	}
+
+	return added;
+}
+
 int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
 	int count = pool->low_count;
@@ -156,6 +354,8 @@ int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 	if (high)
 		count += pool->high_count;
 
+	count += ion_page_pool_pcp_count(pool);
+
 	return count << pool->order;
 }
 
@@ -173,6 +373,8 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, high);
 
+	ion_page_pool_drain_pcp(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -186,6 +388,7 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 			break;
 		}
 		mutex_unlock(&pool->mutex);
+		ion_page_pool_account(pool, page, false);
 		ion_page_pool_free_pages(pool, page);
 		freed += (1 << pool->order);
 	}
@@ -209,12 +412,42 @@ struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
 	pool->order = order;
 	mutex_init(&pool->mutex);
 	plist_node_init(&pool->list, order);
+	pool->pcp = NULL;
+	pool->pcp_high = 0;
+	pool->pcp_batch = 0;
 
 	return pool;
 }
 
+/*
+ * Put a per-cpu front cache in front of the pool. Orders too large to
+ * hold at least two pages in ION_POOL_PCP_MAX_PAGES are left alone. Only
+ * pools whose pages are interchangeable between cpus may use this;
+ * ion_page_pool_alloc_pool_only() does not look at the front cache.
+ */
+int ion_page_pool_init_pcp(struct ion_page_pool *pool)
+{
+	int cpu, high = ION_POOL_PCP_MAX_PAGES >> pool->order;
+
+	if (high < 2)
+		return 0;
+
+	pool->pcp = alloc_percpu(struct ion_page_pool_pcp);
+	if (!pool->pcp)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(pool->pcp, cpu)->lock);
+	pool->pcp_high = high;
+	pool->pcp_batch = high / 2;
+
+	return 0;
+}
+
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
+	ion_page_pool_drain_pcp(pool);
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
 
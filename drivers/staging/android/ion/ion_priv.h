@@ -80,6 +80,11 @@ struct mem_map_data {
  * @pages:		flat array of pages in the buffer -- used by fault
  *			handler and only valid for buffers that are faulted in
  * @vmas:		list of vma's mapping this buffer
+ * @cpu_dirty_start:	start of the byte range the cpu may have dirtied
+ *			since the last sync for device
+ * @cpu_dirty_end:	end of that range, the range is empty when it is not
+ *			past @cpu_dirty_start
+ * @cpu_access_seq:	bumped on every tracked cpu access to the buffer
  * @handle_count:	count of handles referencing this buffer
  * @task_comm:		taskcomm of last client to reference this buffer in a
  *			handle, used for debugging
@@ -107,6 +112,9 @@ struct ion_buffer {
 	struct sg_table *sg_table;
 	struct page **pages;
 	struct list_head vmas;
+	size_t cpu_dirty_start;
+	size_t cpu_dirty_end;
+	unsigned int cpu_access_seq;
 	/* used to track orphaned buffers */
 	int handle_count;
 	char task_comm[TASK_COMM_LEN];
@@ -174,6 +182,18 @@ struct ion_heap_ops {
  */
 #define ION_PRIV_FLAG_SHRINKER_FREE (1 << 0)
 
+/*
+ * Buffer has been mapped into userspace without faulting, so the cpu may
+ * write to any of it at any time and dirty tracking can't be trusted.
+ */
+#define ION_PRIV_FLAG_CPU_MAPPED (1 << 1)
+
+/*
+ * A device wrote the buffer and its driver left the cpu invalidate to the
+ * next tracked cpu access, see ion_handle_defer_cpu_inv().
+ */
+#define ION_PRIV_FLAG_DEFERRED_INV (1 << 2)
+
 /**
  * struct ion_heap - represents a heap in the system
  * @node:		rb node to put the heap on the device's tree of heaps
@@ -459,12 +479,27 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  * @gfp_mask:		gfp_mask to use from alloc
  * @order:		order of pages in the pool
  * @list:		plist node for list of pools
+ * @pcp:		optional per-cpu front cache
+ * @pcp_high:		max pages held by one cpu's front cache
+ * @pcp_batch:		pages moved per refill or drain of a front cache
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
  * been invalidated from the cache, provides a significant performance benefit
  * on many systems
  */
+/* Front cache capacity per cpu, in order-0 pages */
+#define ION_POOL_PCP_MAX_PAGES	64
+
+struct ion_page_pool_pcp {
+	spinlock_t lock;
+	int count;
+	unsigned long hits;
+	unsigned long refills;
+	unsigned long drains;
+	struct page *pages[ION_POOL_PCP_MAX_PAGES];
+};
+
 struct ion_page_pool {
 	int high_count;
 	int low_count;
@@ -475,17 +510,26 @@ struct ion_page_pool {
 	gfp_t gfp_mask;
 	unsigned int order;
 	struct plist_node list;
+	struct ion_page_pool_pcp __percpu *pcp;
+	int pcp_high;
+	int pcp_batch;
 };
 
 struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
 					   unsigned int order);
 void ion_page_pool_destroy(struct ion_page_pool *);
+int ion_page_pool_init_pcp(struct ion_page_pool *pool);
+int ion_page_pool_pcp_count(struct ion_page_pool *pool);
+void ion_page_pool_pcp_stats(struct ion_page_pool *pool, unsigned long *hits,
+			     unsigned long *refills, unsigned long *drains);
 void *ion_page_pool_alloc(struct ion_page_pool *a, bool *from_pool);
 void *ion_page_pool_alloc_pool_only(struct ion_page_pool *a);
 void ion_page_pool_free(struct ion_page_pool *a, struct page *b);
 void ion_page_pool_free_immediate(struct ion_page_pool *, struct page *);
 int ion_page_pool_total(struct ion_page_pool *pool, bool high);
+int ion_page_pool_refill(struct ion_page_pool *pool, int target);
 size_t ion_system_heap_secure_page_pool_total(struct ion_heap *heap, int vmid);
+bool ion_system_heap_refill_backoff(struct ion_heap *heap);
 
 #ifdef CONFIG_ION_POOL_CACHE_POLICY
 static inline void ion_page_pool_alloc_set_cache_policy
@@ -18,9 +18,13 @@
 #include <asm/page.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/kthread.h>
 #include <linux/mm.h>
+#include <linux/moduleparam.h>
 #include <linux/msm_ion.h>
+#include <linux/sched.h>
 #include <linux/scatterlist.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
@@ -46,6 +50,17 @@ static const unsigned int orders[] = {0};
 #endif
 
 static const int num_orders = ARRAY_SIZE(orders);
+
+/*
+ * Order-0 pages the refill thread keeps in each uncached and cached pool,
+ * pre-zeroed and ready for dma. Zero leaves the pools to fill on free only.
+ */
+static unsigned int pool_refill_pages;
+module_param(pool_refill_pages, uint, 0644);
+
+/* How long refilling stays off after the shrinker took pages back */
+#define ION_POOL_REFILL_BACKOFF	(2 * HZ)
+
 static int order_to_index(unsigned int order)
 {
 	int i;
@@ -61,6 +76,16 @@ static unsigned int order_to_size(int order)
 	return PAGE_SIZE << order;
 }
 
+/*
+ * Outcome of each attempt at a given order: served from a pool, served
+ * by buddy, or neither so the allocation dropped to the next order.
+ */
+struct ion_system_heap_order_stats {
+	atomic_long_t pool_hits;
+	atomic_long_t buddy_hits;
+	atomic_long_t misses;
+};
+
 struct ion_system_heap {
 	struct ion_heap heap;
 	struct ion_page_pool **uncached_pools;
@@ -68,6 +93,11 @@ struct ion_system_heap {
 	struct ion_page_pool **secure_pools[VMID_LAST];
 	/* Prevents unnecessary page splitting */
 	struct mutex split_page_mutex;
+	struct task_struct *refill_task;
+	wait_queue_head_t refill_wq;
+	/* jiffies before which the refill thread leaves the pools alone */
+	unsigned long refill_backoff;
+	struct ion_system_heap_order_stats order_stats[ARRAY_SIZE(orders)];
 };
 
 struct page_info {
@@ -102,11 +132,84 @@ size_t ion_system_heap_secure_page_pool_total(struct ion_heap *heap,
 	return total << PAGE_SHIFT;
 }
 
+/*
+ * Used by ion_system_secure_heap only
+ * True while the shrinker recently took pages back from the pools.
+ */
+bool ion_system_heap_refill_backoff(struct ion_heap *heap)
+{
+	struct ion_system_heap *sys_heap;
+
+	sys_heap = container_of(heap, struct ion_system_heap, heap);
+	return time_before(jiffies, READ_ONCE(sys_heap->refill_backoff));
+}
+
 static int ion_heap_is_system_heap_type(enum ion_heap_type type)
 {
 	return type == ((enum ion_heap_type)ION_HEAP_TYPE_SYSTEM);
 }
 
+static bool ion_system_heap_need_refill(struct ion_system_heap *sys_heap)
+{
+	int target = READ_ONCE(pool_refill_pages);
+	int i;
+
+	if (!target ||
+	    time_before(jiffies, READ_ONCE(sys_heap->refill_backoff)))
+		return false;
+
+	for (i = 0; i < num_orders; i++) {
+		if (ion_page_pool_total(sys_heap->uncached_pools[i], true) <
+		    target ||
+		    ion_page_pool_total(sys_heap->cached_pools[i], true) <
+		    target)
+			return true;
+	}
+
+	return false;
+}
+
+static void ion_system_heap_refill_kick(struct ion_system_heap *sys_heap)
+{
+	if (sys_heap->refill_task && ion_system_heap_need_refill(sys_heap))
+		wake_up(&sys_heap->refill_wq);
+}
+
+/*
+ * Keeps the non-secure pools topped up with zeroed pages so allocations
+ * that would otherwise go to buddy and zero inline are served from the
+ * pools. Runs as SCHED_IDLE and never reclaims; if a pass can't reach
+ * the watermark it backs off rather than spinning against the shrinker.
+ */
+static int ion_system_heap_refill(void *data)
+{
+	struct ion_system_heap *sys_heap = data;
+	int target, i;
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(sys_heap->refill_wq,
+				     kthread_should_stop() ||
+				     ion_system_heap_need_refill(sys_heap));
+
+		target = READ_ONCE(pool_refill_pages);
+		for (i = 0; i < num_orders; i++) {
+			if (kthread_should_stop() ||
+			    !ion_system_heap_need_refill(sys_heap))
+				break;
+			ion_page_pool_refill(sys_heap->uncached_pools[i],
+					     target);
+			ion_page_pool_refill(sys_heap->cached_pools[i],
+					     target);
+		}
+
+		if (ion_system_heap_need_refill(sys_heap))
+			WRITE_ONCE(sys_heap->refill_backoff,
+				   jiffies + ION_POOL_REFILL_BACKOFF);
+	}
+
+	return 0;
+}
+
 static struct page *alloc_buffer_page(struct ion_system_heap *heap,
 				      struct ion_buffer *buffer,
 				      unsigned long order,
@@ -253,8 +356,15 @@ static struct page_info *alloc_largest_available(struct ion_system_heap *heap,
 			continue;
 		from_pool = !(buffer->flags & ION_FLAG_POOL_FORCE_ALLOC);
 		page = alloc_buffer_page(heap, buffer, orders[i], &from_pool);
-		if (!page)
+		if (!page) {
+			atomic_long_inc(&heap->order_stats[i].misses);
 			continue;
+		}
+
+		if (from_pool)
+			atomic_long_inc(&heap->order_stats[i].pool_hits);
+		else
+			atomic_long_inc(&heap->order_stats[i].buddy_hits);
 
 		info->page = page;
 		info->order = orders[i];
@@ -292,6 +402,7 @@ static struct page_info *alloc_from_pool_preferred(
 		if (!page)
 			continue;
 
+		atomic_long_inc(&heap->order_stats[i].pool_hits);
 		info->page = page;
 		info->order = orders[i];
 		info->from_pool = true;
@@ -481,6 +592,8 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 	if (nents_sync)
 		sg_free_table(&table_sync);
 	msm_ion_heap_free_pages_mem(&data);
+	if (vmid < 0)
+		ion_system_heap_refill_kick(sys_heap);
 	return 0;
 
 err_free_sg2:
@@ -629,6 +742,9 @@ static int ion_system_heap_shrink(struct ion_heap *heap, gfp_t gfp_mask,
 
 	if (!nr_to_scan)
 		only_scan = 1;
+	else
+		WRITE_ONCE(sys_heap->refill_backoff,
+			   jiffies + ION_POOL_REFILL_BACKOFF);
 
 	for (i = 0; i < num_orders; i++) {
 		nr_freed = 0;
@@ -668,6 +784,56 @@ static struct ion_heap_ops system_heap_ops = {
 	.shrink = ion_system_heap_shrink,
 };
 
+/* Report a pool's per-cpu front cache, returns the bytes it holds */
+static unsigned long ion_system_heap_pcp_show(struct seq_file *s,
+					      struct ion_page_pool *pool,
+					      const char *name)
+{
+	unsigned long hits, refills, drains;
+	int count;
+
+	if (!pool->pcp)
+		return 0;
+
+	count = ion_page_pool_pcp_count(pool);
+	if (s) {
+		ion_page_pool_pcp_stats(pool, &hits, &refills, &drains);
+		seq_printf(s,
+			   "%d order %u pages in %s pcp cache = %lu total, hits %lu refills %lu drains %lu\n",
+			   count, pool->order, name,
+			   (1 << pool->order) * PAGE_SIZE * count,
+			   hits, refills, drains);
+	}
+
+	return (1 << pool->order) * PAGE_SIZE * count;
+}
+
+static void ion_system_heap_order_stats_show(struct ion_system_heap *sys_heap,
+					     struct seq_file *s)
+{
+	struct ion_system_heap_order_stats *stats;
+	unsigned long pool, buddy, misses, tries;
+	int i;
+
+	for (i = 0; i < num_orders; i++) {
+		stats = &sys_heap->order_stats[i];
+		pool = atomic_long_read(&stats->pool_hits);
+		buddy = atomic_long_read(&stats->buddy_hits);
+		misses = atomic_long_read(&stats->misses);
+		tries = pool + buddy + misses;
+
+		if (s)
+			seq_printf(s,
+				   "order %u: pool hits %lu buddy hits %lu misses %lu hit rate %lu%%\n",
+				   orders[i], pool, buddy, misses,
+				   tries ? (pool + buddy) * 100 / tries : 0);
+		else
+			pr_info("order %u: pool hits %lu buddy hits %lu misses %lu hit rate %lu%%\n",
+				orders[i], pool, buddy, misses,
+				tries ? (pool + buddy) * 100 / tries : 0);
+	}
+}
+
 static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 				      void *unused)
 {
@@ -700,6 +866,8 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 			pool->high_count;
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		uncached_total += ion_system_heap_pcp_show(s, pool,
+							   "uncached");
 	}
 
 	for (i = 0; i < num_orders; i++) {
@@ -721,6 +889,7 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 			pool->high_count;
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		cached_total += ion_system_heap_pcp_show(s, pool, "cached");
 	}
 
 	for (i = 0; i < num_orders; i++) {
@@ -756,6 +925,7 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 		seq_printf(s, "pool total (uncached + cached + secure) = %lu\n",
 			   uncached_total + cached_total + secure_total);
 		seq_puts(s, "--------------------------------------------\n");
+		ion_system_heap_order_stats_show(sys_heap, s);
 	} else {
 		pr_info("-------------------------------------------------\n");
 		pr_info("uncached pool = %lu cached pool = %lu secure pool = %lu\n",
@@ -763,6 +933,7 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 		pr_info("pool total (uncached + cached + secure) = %lu\n",
 			uncached_total + cached_total + secure_total);
 		pr_info("-------------------------------------------------\n");
+		ion_system_heap_order_stats_show(sys_heap, NULL);
 	}
 
 	return 0;
@@ -783,10 +954,12 @@ static void ion_system_heap_destroy_pools(struct ion_page_pool **pools)
  *
  * If this fails you don't need to destroy any pools. It's all or
  * nothing. If it succeeds you'll eventually need to use
- * ion_system_heap_destroy_pools to destroy the pools.
+ * ion_system_heap_destroy_pools to destroy the pools. With @pcp set the
+ * pools also get a per-cpu front cache.
  */
 static int ion_system_heap_create_pools(struct device *dev,
-					struct ion_page_pool **pools)
+					struct ion_page_pool **pools,
+					bool pcp)
 {
 	int i;
 	for (i = 0; i < num_orders; i++) {
@@ -799,6 +972,8 @@ static int ion_system_heap_create_pools(struct device *dev,
 		if (!pool)
 			goto err_create_pool;
 		pools[i] = pool;
+		if (pcp && ion_page_pool_init_pcp(pool))
+			goto err_create_pool;
 	}
 	return 0;
 err_create_pool:
@@ -834,19 +1009,31 @@ struct ion_heap *ion_system_heap_create(struct ion_platform_heap *data)
 			if (!heap->secure_pools[i])
 				goto err_create_secure_pools;
 			if (ion_system_heap_create_pools(
-					dev, heap->secure_pools[i]))
+					dev, heap->secure_pools[i], false))
 				goto err_create_secure_pools;
 		}
 	}
 
-	if (ion_system_heap_create_pools(dev, heap->uncached_pools))
+	if (ion_system_heap_create_pools(dev, heap->uncached_pools, true))
 		goto err_create_uncached_pools;
 
-	if (ion_system_heap_create_pools(dev, heap->cached_pools))
+	if (ion_system_heap_create_pools(dev, heap->cached_pools, true))
 		goto err_create_cached_pools;
 
 	mutex_init(&heap->split_page_mutex);
 
+	init_waitqueue_head(&heap->refill_wq);
+	heap->refill_task = kthread_run(ion_system_heap_refill, heap,
+					"ion_pool_refill");
+	if (IS_ERR(heap->refill_task)) {
+		pr_err("%s: creating pool refill thread failed\n", __func__);
+		heap->refill_task = NULL;
+	} else {
+		struct sched_param param = { .sched_priority = 0 };
+
+		sched_setscheduler(heap->refill_task, SCHED_IDLE, &param);
+	}
+
 	heap->heap.debug_show = ion_system_heap_debug_show;
 	return &heap->heap;
 
@@ -875,6 +1062,9 @@ void ion_system_heap_destroy(struct ion_heap *heap)
 							heap);
 	int i, j;
 
+	if (sys_heap->refill_task)
+		kthread_stop(sys_heap->refill_task);
+
 	for (i = 0; i < VMID_LAST; i++) {
 		if (!is_secure_vmid_valid(i))
 			continue;
@@ -14,6 +14,7 @@
  */
 
 #include <linux/slab.h>
+#include <linux/module.h>
 #include <linux/msm_ion.h>
 #include <soc/qcom/secure_buffer.h>
 #include <linux/workqueue.h>
@@ -25,11 +26,13 @@ struct ion_system_secure_heap {
 	struct ion_heap *sys_heap;
 	struct ion_heap heap;
 
-	/* Protects prefetch_list */
+	/* Protects prefetch_list and reserve_pending */
 	spinlock_t work_lock;
 	bool destroy_heap;
 	struct list_head prefetch_list;
 	struct delayed_work prefetch_work;
+	/* VMIDs with a reserve refill on prefetch_list */
+	DECLARE_BITMAP(reserve_pending, VMID_LAST);
 };
 
 struct prefetch_info {
@@ -37,8 +40,24 @@ struct prefetch_info {
 	int vmid;
 	size_t size;
 	bool shrink;
+	bool reserve;
 };
 
+#define ION_SECURE_CP_FLAGS	(ION_FLAG_CP_TOUCH |		\
+				 ION_FLAG_CP_BITSTREAM |	\
+				 ION_FLAG_CP_PIXEL |		\
+				 ION_FLAG_CP_NON_PIXEL |	\
+				 ION_FLAG_CP_CAMERA)
+
+/*
+ * Memory kept assigned to each VMID in use, in KB. An allocation that
+ * leaves the secure pool of its VMID below half the reserve queues a
+ * refill to the full reserve, which is assigned with one hyp_assign_table
+ * call instead of one per buffer. Zero disables the reserve.
+ */
+static unsigned int secure_pool_reserve_kb;
+module_param(secure_pool_reserve_kb, uint, 0644);
+
 /*
  * The video client may not hold the last reference count on the
  * ion_buffer(s). Delay for a short time after the video client sends
@@ -49,11 +68,7 @@ struct prefetch_info {
 
 static bool is_cp_flag_present(unsigned long flags)
 {
-	return flags & (ION_FLAG_CP_TOUCH |
-			ION_FLAG_CP_BITSTREAM |
-			ION_FLAG_CP_PIXEL |
-			ION_FLAG_CP_NON_PIXEL |
-			ION_FLAG_CP_CAMERA);
+	return flags & ION_SECURE_CP_FLAGS;
 }
 
 int ion_system_secure_heap_unassign_sg(struct sg_table *sgt, int source_vmid)
@@ -96,6 +111,56 @@ int ion_system_secure_heap_assign_sg(struct sg_table *sgt, int dest_vmid)
 	return 0;
 }
 
+static size_t secure_pool_reserve_needed(struct ion_heap *sys_heap,
+					 unsigned long vmid_flags, bool low)
+{
+	size_t reserve = (size_t)READ_ONCE(secure_pool_reserve_kb) << 10;
+	size_t total;
+
+	if (!reserve || ion_system_heap_refill_backoff(sys_heap))
+		return 0;
+
+	total = ion_system_heap_secure_page_pool_total(sys_heap, vmid_flags);
+	if (total >= (low ? reserve / 2 : reserve))
+		return 0;
+
+	return PAGE_ALIGN(reserve - total);
+}
+
+static void ion_system_secure_heap_reserve_kick(
+			struct ion_system_secure_heap *secure_heap,
+			unsigned long flags)
+{
+	unsigned long vmid_flags = flags & ION_SECURE_CP_FLAGS;
+	int vmid = get_secure_vmid(vmid_flags);
+	struct prefetch_info *info;
+	unsigned long lflags;
+
+	if (!is_secure_vmid_valid(vmid) ||
+	    !secure_pool_reserve_needed(secure_heap->sys_heap, vmid_flags,
+					true))
+		return;
+
+	info = kzalloc(sizeof(*info), GFP_KERNEL);
+	if (!info)
+		return;
+
+	info->vmid = vmid_flags;
+	info->reserve = true;
+	INIT_LIST_HEAD(&info->list);
+
+	spin_lock_irqsave(&secure_heap->work_lock, lflags);
+	if (secure_heap->destroy_heap ||
+	    test_and_set_bit(vmid, secure_heap->reserve_pending)) {
+		spin_unlock_irqrestore(&secure_heap->work_lock, lflags);
+		kfree(info);
+		return;
+	}
+	list_add_tail(&info->list, &secure_heap->prefetch_list);
+	schedule_delayed_work(&secure_heap->prefetch_work, 0);
+	spin_unlock_irqrestore(&secure_heap->work_lock, lflags);
+}
+
 static void ion_system_secure_heap_free(struct ion_buffer *buffer)
 {
 	struct ion_heap *heap = buffer->heap;
@@ -131,6 +196,8 @@ static int ion_system_secure_heap_allocate(
 			__func__, heap->name, ret);
 		return ret;
 	}
+
+	ion_system_secure_heap_reserve_kick(secure_heap, flags);
 	return ret;
 }
 
@@ -211,11 +278,19 @@ static void ion_system_secure_heap_prefetch_work(struct work_struct *work)
 	list_for_each_entry_safe(info, tmp,
 				 &secure_heap->prefetch_list, list) {
 		list_del(&info->list);
+		if (info->reserve)
+			clear_bit(get_secure_vmid(info->vmid),
+				  secure_heap->reserve_pending);
 		spin_unlock_irqrestore(&secure_heap->work_lock, flags);
 
+		if (info->reserve)
+			info->size = secure_pool_reserve_needed(sys_heap,
+								info->vmid,
+								false);
+
 		if (info->shrink)
 			process_one_shrink(secure_heap, sys_heap, info);
-		else
+		else if (info->size)
 			process_one_prefetch(sys_heap, info);
 
 		kfree(info);
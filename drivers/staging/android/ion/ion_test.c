@@ -17,21 +17,28 @@
 
 #include <linux/dma-buf.h>
 #include <linux/dma-direction.h>
+#include <linux/dma-mapping.h>
 #include <linux/fs.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/miscdevice.h>
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/scatterlist.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/vmalloc.h>
 
 #include "ion.h"
+#include "msm/msm_ion.h"
 #include "../uapi/ion_test.h"
 
 #define u64_to_uptr(x) ((void __user *)(unsigned long)(x))
 
+#define ION_TEST_BENCH_MAX_THREADS	32
+
 struct ion_test_device {
 	struct miscdevice misc;
 };
@@ -41,6 +48,17 @@ struct ion_test_data {
 	struct device *dev;
 };
 
+struct ion_test_bench_thread {
+	const struct ion_test_bench_data *params;
+	struct device *dev;
+	struct ion_test_bench_stat alloc;
+	struct ion_test_bench_stat free;
+	struct ion_test_bench_stat map;
+	struct ion_test_bench_stat sync;
+	u32 failures;
+	struct completion done;
+};
+
 static int ion_handle_test_dma(struct device *dev, struct dma_buf *dma_buf,
 			       void __user *ptr, size_t offset, size_t size,
 			       bool write)
@@ -144,6 +162,168 @@ err:
 	return ret;
 }
 
+static void ion_test_bench_record(struct ion_test_bench_stat *stat,
+				  ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (!stat->count || ns < stat->min_ns)
+		stat->min_ns = ns;
+	if (ns > stat->max_ns)
+		stat->max_ns = ns;
+	stat->total_ns += ns;
+	stat->count++;
+}
+
+static void ion_test_bench_merge(struct ion_test_bench_stat *dst,
+				 const struct ion_test_bench_stat *src)
+{
+	if (!src->count)
+		return;
+
+	if (!dst->count || src->min_ns < dst->min_ns)
+		dst->min_ns = src->min_ns;
+	if (src->max_ns > dst->max_ns)
+		dst->max_ns = src->max_ns;
+	dst->total_ns += src->total_ns;
+	dst->count += src->count;
+}
+
+static int ion_test_bench_one(struct ion_test_bench_thread *t,
+			      struct ion_client *client)
+{
+	const struct ion_test_bench_data *p = t->params;
+	struct ion_handle *handle;
+	struct sg_table *table, sgt;
+	struct scatterlist *sg, *dst;
+	ktime_t start;
+	int i, nents, ret;
+
+	start = ktime_get();
+	handle = ion_alloc(client, p->size, PAGE_SIZE, p->heap_id_mask,
+			   p->flags);
+	if (IS_ERR(handle))
+		return PTR_ERR(handle);
+	ion_test_bench_record(&t->alloc, start);
+
+	table = ion_sg_table(client, handle);
+	if (IS_ERR(table)) {
+		ret = PTR_ERR(table);
+		goto free;
+	}
+
+	/*
+	 * Map a copy, as a dma-buf attachment would, the dma addresses of
+	 * the buffer's own table belong to the heap. A dma-buf is avoided
+	 * on purpose: its release is deferred from a kernel thread, and
+	 * ion_free() would then no longer free the buffer.
+	 */
+	ret = sg_alloc_table(&sgt, table->nents, GFP_KERNEL);
+	if (ret)
+		goto free;
+	dst = sgt.sgl;
+	for_each_sg(table->sgl, sg, table->nents, i) {
+		sg_set_page(dst, sg_page(sg), sg->length, sg->offset);
+		dst = sg_next(dst);
+	}
+
+	start = ktime_get();
+	nents = dma_map_sg(t->dev, sgt.sgl, sgt.nents, DMA_BIDIRECTIONAL);
+	if (!nents) {
+		ret = -ENOMEM;
+		goto free_table;
+	}
+	ion_test_bench_record(&t->map, start);
+
+	/* what a cpu access between two device accesses costs */
+	start = ktime_get();
+	dma_sync_sg_for_cpu(t->dev, sgt.sgl, sgt.nents, DMA_BIDIRECTIONAL);
+	dma_sync_sg_for_device(t->dev, sgt.sgl, sgt.nents, DMA_BIDIRECTIONAL);
+	ion_test_bench_record(&t->sync, start);
+
+	dma_unmap_sg(t->dev, sgt.sgl, sgt.nents, DMA_BIDIRECTIONAL);
+free_table:
+	sg_free_table(&sgt);
+free:
+	start = ktime_get();
+	ion_free(client, handle);
+	if (!ret)
+		ion_test_bench_record(&t->free, start);
+
+	return ret;
+}
+
+static int ion_test_bench_thread_fn(void *data)
+{
+	struct ion_test_bench_thread *t = data;
+	struct ion_client *client;
+	u32 i;
+
+	client = msm_ion_client_create("ion-test-bench");
+	if (IS_ERR_OR_NULL(client)) {
+		t->failures = t->params->iterations;
+		goto out;
+	}
+
+	for (i = 0; i < t->params->iterations; i++) {
+		if (ion_test_bench_one(t, client))
+			t->failures++;
+		cond_resched();
+	}
+
+	ion_client_destroy(client);
+out:
+	complete(&t->done);
+	return 0;
+}
+
+static int ion_test_bench(struct device *dev, struct ion_test_bench_data *p)
+{
+	struct ion_test_bench_thread *threads, *t;
+	struct task_struct *task;
+	u32 i, started;
+	int ret = 0;
+
+	if (!p->size || p->size > SIZE_MAX || !p->iterations ||
+	    !p->threads || p->threads > ION_TEST_BENCH_MAX_THREADS)
+		return -EINVAL;
+
+	threads = kcalloc(p->threads, sizeof(*threads), GFP_KERNEL);
+	if (!threads)
+		return -ENOMEM;
+
+	for (started = 0; started < p->threads; started++) {
+		t = &threads[started];
+		t->params = p;
+		t->dev = dev;
+		init_completion(&t->done);
+		task = kthread_run(ion_test_bench_thread_fn, t,
+				   "ion_test_bench/%u", started);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			break;
+		}
+	}
+
+	memset(&p->alloc, 0, sizeof(p->alloc));
+	memset(&p->free, 0, sizeof(p->free));
+	memset(&p->map, 0, sizeof(p->map));
+	memset(&p->sync, 0, sizeof(p->sync));
+	p->failures = 0;
+	for (i = 0; i < started; i++) {
+		t = &threads[i];
+		wait_for_completion(&t->done);
+		ion_test_bench_merge(&p->alloc, &t->alloc);
+		ion_test_bench_merge(&p->free, &t->free);
+		ion_test_bench_merge(&p->map, &t->map);
+		ion_test_bench_merge(&p->sync, &t->sync);
+		p->failures += t->failures;
+	}
+
+	kfree(threads);
+	return ret;
+}
+
 static long ion_test_ioctl(struct file *filp, unsigned int cmd,
 			   unsigned long arg)
 {
@@ -152,6 +332,7 @@ static long ion_test_ioctl(struct file *filp, unsigned int cmd,
 
 	union {
 		struct ion_test_rw_data test_rw;
+		struct ion_test_bench_data bench;
 	} data;
 
 	if (_IOC_SIZE(cmd) > sizeof(data))
@@ -195,12 +376,17 @@ static long ion_test_ioctl(struct file *filp, unsigned int cmd,
 					     data.test_rw.write);
 		break;
 	}
+	case ION_IOC_TEST_BENCH:
+	{
+		ret = ion_test_bench(test_data->dev, &data.bench);
+		break;
+	}
 	default:
 		return -ENOTTY;
 	}
 
 	if (_IOC_DIR(cmd) & _IOC_READ) {
-		if (copy_to_user((void __user *)arg, &data, sizeof(data)))
+		if (copy_to_user((void __user *)arg, &data, _IOC_SIZE(cmd)))
 			return -EFAULT;
 	}
 	return ret;
@@ -136,6 +136,32 @@ struct ion_client *msm_ion_client_create(const char *name);
 int ion_handle_get_flags(struct ion_client *client, struct ion_handle *handle,
 			 unsigned long *flags);
 
+/**
+ * ion_handle_cpu_access_seq - sample the cpu access count of a buffer
+ *
+ * @client - client who imported the handle
+ * @handle - handle of the buffer
+ * @seq - pointer to store the count
+ *
+ * Two equal samples with a true return in between mean the cpu didn't
+ * touch the buffer through ion.  Returns false while the buffer has a cpu
+ * mapping ion can't see accesses through, *seq is meaningless then.
+ */
+bool ion_handle_cpu_access_seq(struct ion_client *client,
+			       struct ion_handle *handle, unsigned int *seq);
+
+/**
+ * ion_handle_defer_cpu_inv - invalidate on next cpu access instead of now
+ *
+ * @client - client who imported the handle
+ * @handle - handle of the buffer
+ *
+ * For a device that just wrote a buffer that ion currently tracks: the cpu
+ * invalidate is done by ion when the cpu next accesses the buffer.
+ */
+void ion_handle_defer_cpu_inv(struct ion_client *client,
+			      struct ion_handle *handle);
+
 /**
  * ion_handle_get_size - get the allocated size of a given handle
  *
@@ -188,6 +214,16 @@ static inline int ion_handle_get_size(struct ion_client *client,
 	return -ENODEV;
 }
 
+static inline bool ion_handle_cpu_access_seq(struct ion_client *client,
+					     struct ion_handle *handle,
+					     unsigned int *seq)
+{
+	return false;
+}
+
+static inline void ion_handle_defer_cpu_inv(struct ion_client *client,
+					    struct ion_handle *handle) {}
+
 static inline int msm_ion_do_cache_op(
 			struct ion_client *client,
 			struct ion_handle *handle, void *vaddr,
@@ -56,6 +56,10 @@ int ion_secure_cma_prefetch(struct ion_heap *heap, void *data);
 
 int ion_secure_cma_drain_pool(struct ion_heap *heap, void *unused);
 
+int ion_cma_heap_prefetch(struct ion_heap *heap, void *data);
+
+int ion_cma_heap_drain(struct ion_heap *heap, void *unused);
+
 #else
 static inline int ion_secure_cma_prefetch(struct ion_heap *heap, void *data)
 {
@@ -67,6 +71,16 @@ static inline int ion_secure_cma_drain_pool(struct ion_heap *heap, void *unused)
 	return -ENODEV;
 }
 
+static inline int ion_cma_heap_prefetch(struct ion_heap *heap, void *data)
+{
+	return -ENODEV;
+}
+
+static inline int ion_cma_heap_drain(struct ion_heap *heap, void *unused)
+{
+	return -ENODEV;
+}
+
 #endif
 
 struct ion_heap *ion_removed_heap_create(struct ion_platform_heap *pheap);
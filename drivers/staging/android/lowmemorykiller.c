@@ -63,6 +63,8 @@
 #include <linux/proc_fs.h>
 #include <linux/slab.h>
 #include <linux/poll.h>
+#include <linux/psi.h>
+#include <linux/hashtable.h>
 
 #define CREATE_TRACE_POINTS
 #include "trace/lowmemorykiller.h"
@@ -122,11 +124,23 @@ struct lmk_event {
 	short oom_score_adj;
 	short min_score_adj;
 	unsigned long long start_time;
+	int reaped;
 	struct list_head list;
 };
 
+/*
+ * Kill counters, updated under scan_mutex. waits counts scans that backed
+ * off because an earlier victim had not released its memory yet.
+ */
+static unsigned long lmk_kill_count;
+module_param_named(kill_count, lmk_kill_count, ulong, 0444);
+static unsigned long lmk_reap_count;
+module_param_named(reap_count, lmk_reap_count, ulong, 0444);
+static unsigned long lmk_wait_count;
+module_param_named(wait_count, lmk_wait_count, ulong, 0444);
+
 void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
-		      short min_score_adj)
+		      short min_score_adj, int reaped)
 {
 	int head;
 	int tail;
@@ -161,6 +175,7 @@ void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
 	event->start_time = nsec_to_clock_t(selected->real_start_time);
 	event->rss_in_pages = selected_tasksize;
 	event->min_score_adj = min_score_adj;
+	event->reaped = reaped;
 
 	event_buffer.head = (head + 1) & (MAX_BUFFERED_EVENTS - 1);
 
@@ -188,11 +203,13 @@ static int lmk_event_show(struct seq_file *s, void *unused)
 
 	event = &events[tail];
 
-	seq_printf(s, "%lu %lu %lu %lu %lu %lu %hd %hd %llu\n%s\n",
+	seq_printf(s, "%lu %lu %lu %lu %lu %lu %hd %hd %llu %d %lu %lu %lu\n%s\n",
 		(unsigned long) event->pid, (unsigned long) event->uid,
 		(unsigned long) event->group_leader_pid, event->min_flt,
 		event->maj_flt, event->rss_in_pages, event->oom_score_adj,
-		event->min_score_adj, event->start_time, event->taskname);
+		event->min_score_adj, event->start_time, event->reaped,
+		READ_ONCE(lmk_kill_count), READ_ONCE(lmk_reap_count),
+		READ_ONCE(lmk_wait_count), event->taskname);
 
 	event_buffer.tail = (tail + 1) & (MAX_BUFFERED_EVENTS - 1);
 
@@ -269,9 +286,179 @@ static int vmpressure_file_min;
 module_param_named(vmpressure_file_min, vmpressure_file_min, int, 0644);
 
 /* User knob to enable/disable oom reaping feature */
-static int oom_reaper;
+static int oom_reaper = 1;
 module_param_named(oom_reaper, oom_reaper, int, 0644);
 
+#ifdef CONFIG_PSI
+/*
+ * Stall driven mode: kill when the share of time tasks spent stalled on
+ * memory (reclaim, compaction, refaults) over a window crosses a
+ * threshold, instead of comparing free memory against minfree. Victims
+ * are still picked by oom_score_adj, from the last lowmem_adj level when
+ * some tasks stall and from the second level when all of them do.
+ */
+static int lmk_psi_mode;
+module_param_named(psi_mode, lmk_psi_mode, int, 0644);
+
+/*
+ * PSI folds per-cpu stall times into psi_system once per averaging
+ * period (2s), so windows shorter than that see stalls in bursts.
+ */
+static int lmk_psi_window_ms = 3000;
+module_param_named(psi_window_ms, lmk_psi_window_ms, int, 0644);
+
+static int lmk_psi_some_pct = 40;
+module_param_named(psi_some_pct, lmk_psi_some_pct, int, 0644);
+
+static int lmk_psi_full_pct = 15;
+module_param_named(psi_full_pct, lmk_psi_full_pct, int, 0644);
+
+/* Window state, protected by scan_mutex */
+static u64 lmk_psi_win_start;
+static u64 lmk_psi_win_some;
+static u64 lmk_psi_win_full;
+static int lmk_psi_some_ratio;
+static int lmk_psi_full_ratio;
+
+static void lmk_psi_update(void)
+{
+	u64 now = ktime_get_ns();
+	u64 some = READ_ONCE(psi_system.total[PSI_AVGS][PSI_MEM_SOME]);
+	u64 full = READ_ONCE(psi_system.total[PSI_AVGS][PSI_MEM_FULL]);
+	u64 elapsed = now - lmk_psi_win_start;
+
+	if (lmk_psi_win_start &&
+	    elapsed < (u64)lmk_psi_window_ms * NSEC_PER_MSEC)
+		return;
+
+	if (lmk_psi_win_start) {
+		lmk_psi_some_ratio = div64_u64((some - lmk_psi_win_some) * 100,
+					       elapsed);
+		lmk_psi_full_ratio = div64_u64((full - lmk_psi_win_full) * 100,
+					       elapsed);
+	}
+	lmk_psi_win_start = now;
+	lmk_psi_win_some = some;
+	lmk_psi_win_full = full;
+}
+
+/* Start a fresh window so one stall episode only accounts for one kill */
+static void lmk_psi_reset(void)
+{
+	lmk_psi_win_start = 0;
+	lmk_psi_some_ratio = 0;
+	lmk_psi_full_ratio = 0;
+	lmk_psi_update();
+}
+
+static short lmk_psi_min_adj(int array_size)
+{
+	lmk_psi_update();
+
+	lowmem_print(3, "lowmem_scan psi some %d%% full %d%%\n",
+		     lmk_psi_some_ratio, lmk_psi_full_ratio);
+
+	if (lmk_psi_full_ratio >= lmk_psi_full_pct && array_size > 1)
+		return lowmem_adj[1];
+	if (lmk_psi_some_ratio >= lmk_psi_some_pct)
+		return lowmem_adj[array_size - 1];
+
+	return OOM_SCORE_ADJ_MAX + 1;
+}
+#else
+#define lmk_psi_mode 0
+
+static inline void lmk_psi_reset(void)
+{
+}
+
+static inline short lmk_psi_min_adj(int array_size)
+{
+	return OOM_SCORE_ADJ_MAX + 1;
+}
+#endif
+
+/*
+ * Victim index: processes whose oom_score_adj has been written are kept on
+ * per-adj-range buckets so a scan only visits the tasks at or above the
+ * adj it is allowed to kill, highest bucket first, instead of walking the
+ * whole process list. Entries pin the tgid struct pid and are pruned
+ * lazily once the process is gone.
+ */
+static int adj_index = 1;
+module_param_named(adj_index, adj_index, int, 0644);
+
+#define LMK_ADJ_BUCKET_SHIFT	4
+#define LMK_ADJ_BUCKETS		((OOM_SCORE_ADJ_MAX >> LMK_ADJ_BUCKET_SHIFT) + 1)
+#define LMK_ADJ_HASH_BITS	8
+
+struct lmk_adj_node {
+	struct hlist_node bucket;
+	struct hlist_node hash;
+	struct pid *pid;
+	short adj;
+};
+
+static DEFINE_SPINLOCK(lmk_adj_lock);
+static struct hlist_head lmk_adj_buckets[LMK_ADJ_BUCKETS];
+static DEFINE_HASHTABLE(lmk_adj_hash, LMK_ADJ_HASH_BITS);
+/* set once an update was dropped; the index can no longer be trusted */
+static bool lmk_adj_lossy;
+
+static void lmk_adj_node_free(struct lmk_adj_node *node)
+{
+	hlist_del(&node->bucket);
+	hash_del(&node->hash);
+	put_pid(node->pid);
+	kfree(node);
+}
+
+void lowmem_adj_index_update(struct task_struct *task)
+{
+	struct pid *pid = task_tgid(task);
+	short adj = task->signal->oom_score_adj;
+	struct lmk_adj_node *node, *found = NULL;
+	struct hlist_node *tmp;
+
+	rcu_read_lock();
+	spin_lock(&lmk_adj_lock);
+	hash_for_each_possible_safe(lmk_adj_hash, node, tmp, hash,
+				    (unsigned long)pid) {
+		if (node->pid == pid)
+			found = node;
+		else if (!pid_task(node->pid, PIDTYPE_PID))
+			lmk_adj_node_free(node);
+	}
+
+	if (adj < 0) {
+		if (found)
+			lmk_adj_node_free(found);
+		goto out;
+	}
+
+	if (!found) {
+		found = kmalloc(sizeof(*found), GFP_NOWAIT | __GFP_NOWARN);
+		if (!found) {
+			lmk_adj_lossy = true;
+			goto out;
+		}
+		found->pid = get_pid(pid);
+		hash_add(lmk_adj_hash, &found->hash, (unsigned long)pid);
+	} else if (found->adj >> LMK_ADJ_BUCKET_SHIFT ==
+		   adj >> LMK_ADJ_BUCKET_SHIFT) {
+		found->adj = adj;
+		goto out;
+	} else {
+		hlist_del(&found->bucket);
+	}
+	found->adj = adj;
+	hlist_add_head(&found->bucket,
+		       &lmk_adj_buckets[adj >> LMK_ADJ_BUCKET_SHIFT]);
+out:
+	spin_unlock(&lmk_adj_lock);
+	rcu_read_unlock();
+}
+
 enum {
 	VMPRESSURE_NO_ADJUST = 0,
 	VMPRESSURE_ADJUST_ENCROACH,
@@ -616,14 +803,131 @@ static int get_free_ram(int *other_free, int *other_file,
 }
 #endif
 
+struct lowmem_selection {
+	struct task_struct *task;
+	int tasksize;
+	short adj;
+};
+
+/*
+ * Consider @tsk as a victim and record it in @sel if it beats the current
+ * pick. Returns true when a previous victim is still dying and the scan
+ * should back off instead. Called under rcu_read_lock().
+ */
+static bool lowmem_consider_task(struct task_struct *tsk, short min_score_adj,
+				 struct lowmem_selection *sel)
+{
+	struct task_struct *p;
+	short oom_score_adj;
+	int tasksize;
+
+	if (tsk->flags & PF_KTHREAD)
+		return false;
+
+	/* if task no longer has any memory ignore it */
+	if (test_task_flag(tsk, TIF_MM_RELEASED))
+		return false;
+
+	if (oom_reaper) {
+		p = find_lock_task_mm(tsk);
+		if (!p)
+			return false;
+
+		if (test_bit(MMF_OOM_VICTIM, &p->mm->flags)) {
+			if (test_bit(MMF_OOM_SKIP, &p->mm->flags)) {
+				task_unlock(p);
+				return false;
+			} else if (time_before_eq(jiffies,
+					lowmem_deathpending_timeout)) {
+				task_unlock(p);
+				return true;
+			}
+		}
+	} else {
+		if (time_before_eq(jiffies, lowmem_deathpending_timeout))
+			if (test_task_lmk_waiting(tsk))
+				return true;
+
+		p = find_lock_task_mm(tsk);
+		if (!p)
+			return false;
+	}
+
+	oom_score_adj = p->signal->oom_score_adj;
+	if (oom_score_adj < min_score_adj) {
+		task_unlock(p);
+		return false;
+	}
+	tasksize = get_mm_rss(p->mm);
+	task_unlock(p);
+	if (tasksize <= 0)
+		return false;
+	if (sel->task) {
+		if (oom_score_adj < sel->adj)
+			return false;
+		if (oom_score_adj == sel->adj && tasksize <= sel->tasksize)
+			return false;
+	}
+	sel->task = p;
+	sel->tasksize = tasksize;
+	sel->adj = oom_score_adj;
+	lowmem_print(3, "select '%s' (%d), adj %hd, size %d, to kill\n",
+		     p->comm, p->pid, oom_score_adj, tasksize);
+	return false;
+}
+
+/*
+ * Pick a victim from the adj index, walking buckets from the highest adj
+ * down to @min_score_adj and stopping at the first bucket that yields one.
+ * Returns -EAGAIN to back off, -ENOENT if the index cannot answer (the
+ * caller falls back to a full process walk) or 0. Called under
+ * rcu_read_lock().
+ */
+static int lowmem_index_select(short min_score_adj,
+			       struct lowmem_selection *sel)
+{
+	struct lmk_adj_node *node;
+	struct hlist_node *tmp;
+	struct task_struct *tsk;
+	int b, ret = 0;
+
+	if (!adj_index || READ_ONCE(lmk_adj_lossy) || min_score_adj < 0)
+		return -ENOENT;
+
+	spin_lock(&lmk_adj_lock);
+	for (b = LMK_ADJ_BUCKETS - 1;
+	     b >= (min_score_adj >> LMK_ADJ_BUCKET_SHIFT); b--) {
+		hlist_for_each_entry_safe(node, tmp, &lmk_adj_buckets[b],
+					  bucket) {
+			tsk = pid_task(node->pid, PIDTYPE_PID);
+			if (!tsk) {
+				lmk_adj_node_free(node);
+				continue;
+			}
+			if (lowmem_consider_task(tsk, min_score_adj, sel)) {
+				ret = -EAGAIN;
+				goto out;
+			}
+		}
+		if (sel->task)
+			break;
+	}
+	if (!sel->task)
+		ret = -ENOENT;
+out:
+	spin_unlock(&lmk_adj_lock);
+	return ret;
+}
+
 static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 {
 	struct task_struct *tsk;
 	struct task_struct *selected = NULL;
+	struct lowmem_selection sel = { NULL };
 	unsigned long rem = 0;
-	int tasksize;
 	int i;
 	int ret = 0;
+	int err;
 	short min_score_adj = OOM_SCORE_ADJ_MAX + 1;
 	int minfree = 0;
 	int selected_tasksize = 0;
@@ -631,6 +935,7 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 	int array_size = ARRAY_SIZE(lowmem_adj);
 	int other_free;
 	int other_file;
+	int reaped = 0;
 
 	if (!mutex_trylock(&scan_mutex))
 		return 0;
@@ -660,11 +965,15 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		array_size = lowmem_adj_size;
 	if (lowmem_minfree_size < array_size)
 		array_size = lowmem_minfree_size;
-	for (i = 0; i < array_size; i++) {
-		minfree = lowmem_minfree[i];
-		if (other_free < minfree && other_file < minfree) {
-			min_score_adj = lowmem_adj[i];
-			break;
+	if (lmk_psi_mode) {
+		min_score_adj = lmk_psi_min_adj(array_size);
+	} else {
+		for (i = 0; i < array_size; i++) {
+			minfree = lowmem_minfree[i];
+			if (other_free < minfree && other_file < minfree) {
+				min_score_adj = lowmem_adj[i];
+				break;
+			}
 		}
 	}
 
@@ -682,73 +991,27 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		return 0;
 	}
 
-	selected_oom_score_adj = min_score_adj;
-
 	rcu_read_lock();
-	for_each_process(tsk) {
-		struct task_struct *p;
-		short oom_score_adj;
-
-		if (tsk->flags & PF_KTHREAD)
-			continue;
-
-		/* if task no longer has any memory ignore it */
-		if (test_task_flag(tsk, TIF_MM_RELEASED))
-			continue;
-
-		if (oom_reaper) {
-			p = find_lock_task_mm(tsk);
-			if (!p)
-				continue;
-
-			if (test_bit(MMF_OOM_VICTIM, &p->mm->flags)) {
-				if (test_bit(MMF_OOM_SKIP, &p->mm->flags)) {
-					task_unlock(p);
-					continue;
-				} else if (time_before_eq(jiffies,
-						lowmem_deathpending_timeout)) {
-					task_unlock(p);
-					rcu_read_unlock();
-					mutex_unlock(&scan_mutex);
-					return 0;
-				}
+	err = lowmem_index_select(min_score_adj, &sel);
+	if (err == -ENOENT) {
+		sel.task = NULL;
+		for_each_process(tsk) {
+			if (lowmem_consider_task(tsk, min_score_adj, &sel)) {
+				err = -EAGAIN;
+				break;
 			}
-		} else {
-			if (time_before_eq(jiffies,
-					   lowmem_deathpending_timeout))
-				if (test_task_lmk_waiting(tsk)) {
-					rcu_read_unlock();
-					mutex_unlock(&scan_mutex);
-					return 0;
-				}
-
-			p = find_lock_task_mm(tsk);
-			if (!p)
-				continue;
-		}
-
-		oom_score_adj = p->signal->oom_score_adj;
-		if (oom_score_adj < min_score_adj) {
-			task_unlock(p);
-			continue;
 		}
-		tasksize = get_mm_rss(p->mm);
-		task_unlock(p);
-		if (tasksize <= 0)
-			continue;
-		if (selected) {
-			if (oom_score_adj < selected_oom_score_adj)
-				continue;
-			if (oom_score_adj == selected_oom_score_adj &&
-			    tasksize <= selected_tasksize)
-				continue;
-		}
-		selected = p;
-		selected_tasksize = tasksize;
-		selected_oom_score_adj = oom_score_adj;
-		lowmem_print(3, "select '%s' (%d), adj %hd, size %d, to kill\n",
-			     p->comm, p->pid, oom_score_adj, tasksize);
 	}
+	if (err == -EAGAIN) {
+		rcu_read_unlock();
+		lmk_wait_count++;
+		mutex_unlock(&scan_mutex);
+		return 0;
+	}
+	selected = sel.task;
+	selected_tasksize = sel.tasksize;
+	selected_oom_score_adj = selected ? sel.adj : min_score_adj;
+
 	if (selected) {
 		long cache_size = other_file * (long)(PAGE_SIZE / 1024);
 		long cache_limit = minfree * (long)(PAGE_SIZE / 1024);
@@ -767,12 +1030,15 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		task_lock(selected);
 		get_task_struct(selected);
 		send_sig(SIGKILL, selected, 0);
+		lmk_kill_count++;
 		if (selected->mm) {
 			task_set_lmk_waiting(selected);
 			if (!test_bit(MMF_OOM_SKIP, &selected->mm->flags) &&
 			    oom_reaper) {
 				mark_lmk_victim(selected);
 				wake_oom_reaper(selected);
+				lmk_reap_count++;
+				reaped = 1;
 			}
 		}
 		task_unlock(selected);
@@ -810,6 +1076,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 
 		lowmem_deathpending_timeout = jiffies + HZ;
 		rem += selected_tasksize;
+		if (lmk_psi_mode)
+			lmk_psi_reset();
 
 		rcu_read_unlock();
 		/* give the system time to free up the memory */
@@ -827,7 +1095,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 	mutex_unlock(&scan_mutex);
 
 	if (selected) {
-		handle_lmk_event(selected, selected_tasksize, min_score_adj);
+		handle_lmk_event(selected, selected_tasksize, min_score_adj,
+				 reaped);
 		put_task_struct(selected);
 	}
 
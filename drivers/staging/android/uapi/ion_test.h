@@ -35,6 +35,48 @@ struct ion_test_rw_data {
 	int __padding;
 };
 
+/**
+ * struct ion_test_bench_stat - timing of one operation in a benchmark run
+ * @count:	number of successful operations
+ * @total_ns:	sum of their latencies
+ * @min_ns:	fastest operation
+ * @max_ns:	slowest operation
+ */
+struct ion_test_bench_stat {
+	__u64 count;
+	__u64 total_ns;
+	__u64 min_ns;
+	__u64 max_ns;
+};
+
+/**
+ * struct ion_test_bench_data - parameters and results of a benchmark run
+ * @heap_id_mask:	heaps to allocate from, as for ION_IOC_ALLOC
+ * @flags:		allocation flags, as for ION_IOC_ALLOC
+ * @size:		size of every buffer
+ * @iterations:		buffers each thread allocates and frees
+ * @threads:		number of threads allocating concurrently
+ * @alloc:		returns the ion_alloc() latency
+ * @free:		returns the latency of freeing the last reference
+ * @map:		returns the dma_map_sg() latency of the whole buffer
+ * @sync:		returns the latency of syncing the whole buffer for the
+ *			cpu and back for the device, i.e. cache maintenance
+ * @failures:		returns the number of iterations that failed
+ */
+struct ion_test_bench_data {
+	__u32 heap_id_mask;
+	__u32 flags;
+	__u64 size;
+	__u32 iterations;
+	__u32 threads;
+	struct ion_test_bench_stat alloc;
+	struct ion_test_bench_stat free;
+	struct ion_test_bench_stat map;
+	struct ion_test_bench_stat sync;
+	__u32 failures;
+	__u32 __padding;
+};
+
 #define ION_IOC_MAGIC		'I'
 
 /**
@@ -66,5 +108,17 @@ struct ion_test_rw_data {
 #define ION_IOC_TEST_KERNEL_MAPPING \
 			_IOW(ION_IOC_MAGIC, 0xf2, struct ion_test_rw_data)
 
+/**
+ * DOC: ION_IOC_TEST_BENCH - time allocation, mapping and freeing of buffers
+ *
+ * Allocates, maps for dma to the test device, cache maintains and frees
+ * buffers of one size from one or more kernel threads, each with its own
+ * client, and returns the latency of every step. Running it for each heap,
+ * size and thread count of interest validates changes to heaps and page
+ * pools.
+ */
+#define ION_IOC_TEST_BENCH \
+			_IOWR(ION_IOC_MAGIC, 0xf3, struct ion_test_bench_data)
+
 
 #endif /* _UAPI_LINUX_ION_H */
@@ -0,0 +1,262 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/thermal.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <trace/events/thermal.h>
+
+#include "thermal_core.h"
+
+/* Default mitigation band below the trip when it has no hysteresis, mC */
+#define PREDICTIVE_DEFAULT_BAND		5000
+/* Weight of the old slope in the moving average, out of this */
+#define PREDICTIVE_SLOPE_WEIGHT		4
+
+static int predictive_horizon_ms = 2000;
+module_param(predictive_horizon_ms, int, 0644);
+MODULE_PARM_DESC(predictive_horizon_ms, "How far ahead the temperature is predicted");
+
+static int predictive_tau_ms = 20000;
+module_param(predictive_tau_ms, int, 0644);
+MODULE_PARM_DESC(predictive_tau_ms, "Thermal time constant of the zone model");
+
+/**
+ * struct predictive_params - per thermal zone model state
+ * @last_temp:	temperature of the previous sample in mC
+ * @last_update:	time of the previous sample
+ * @slope:	smoothed temperature slope in mC per second
+ * @pred_temp:	temperature predicted for the current sample in mC
+ */
+struct predictive_params {
+	int last_temp;
+	ktime_t last_update;
+	int slope;
+	int pred_temp;
+};
+
+/*
+ * The zone is modelled as a first order RC network, so under the current
+ * power the temperature approaches its steady state exponentially with
+ * time constant tau. Over a horizon h the rise is slope * tau * (1 -
+ * exp(-h / tau)), approximated here by slope * tau * h / (tau + h).
+ */
+static void predictive_update_model(struct thermal_zone_device *tz,
+				struct predictive_params *params)
+{
+	ktime_t now = ktime_get();
+	s64 delta_ms, rate, rise;
+	int tau = max(predictive_tau_ms, 1);
+	int horizon = max(predictive_horizon_ms, 0);
+
+	if (!ktime_to_ns(params->last_update)) {
+		params->last_temp = tz->temperature;
+		params->last_update = now;
+		params->pred_temp = tz->temperature;
+		return;
+	}
+
+	delta_ms = ktime_ms_delta(now, params->last_update);
+	if (delta_ms <= 0)
+		return;
+
+	rate = div64_s64((s64)(tz->temperature - params->last_temp) *
+				MSEC_PER_SEC, delta_ms);
+	params->slope = div_s64((s64)params->slope *
+				(PREDICTIVE_SLOPE_WEIGHT - 1) + rate,
+				PREDICTIVE_SLOPE_WEIGHT);
+	params->last_temp = tz->temperature;
+	params->last_update = now;
+
+	rise = div64_s64((s64)params->slope * tau * horizon,
+			(s64)(tau + horizon) * MSEC_PER_SEC);
+	params->pred_temp = tz->temperature + (int)rise;
+
+	dev_dbg(&tz->device, "temp=%d slope=%d pred=%d\n",
+		tz->temperature, params->slope, params->pred_temp);
+}
+
+/*
+ * Map the predicted temperature linearly onto the cooling states of the
+ * instance across the band below the trip. Mitigation is applied at once
+ * and released one state per sample, so the cap follows the heat instead
+ * of the threshold crossings.
+ */
+static unsigned long get_target_state(struct thermal_instance *instance,
+				int pred_temp, int temp, int trip_temp,
+				int band)
+{
+	unsigned long target = instance->target;
+	unsigned long next_target;
+	int start = trip_temp - band;
+
+	if (pred_temp <= start) {
+		next_target = THERMAL_NO_TARGET;
+	} else {
+		next_target = instance->lower +
+			DIV_ROUND_UP((instance->upper - instance->lower) *
+				min(pred_temp - start, band), band);
+		next_target = min(next_target, instance->upper);
+	}
+
+	if (target == THERMAL_NO_TARGET || !instance->initialized)
+		return next_target;
+
+	if (next_target != THERMAL_NO_TARGET && next_target >= target)
+		return next_target;
+
+	/* Hold the current cap while the zone is above the trip */
+	if (temp >= trip_temp)
+		return target;
+
+	if (target > instance->lower)
+		return target - 1;
+
+	return next_target;
+}
+
+static void update_passive_instance(struct thermal_zone_device *tz,
+				enum thermal_trip_type type, int value)
+{
+	if (type == THERMAL_TRIP_PASSIVE)
+		tz->passive += value;
+}
+
+static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
+{
+	struct predictive_params *params = tz->governor_data;
+	int trip_temp, hyst = 0, band;
+	enum thermal_trip_type trip_type;
+	struct thermal_instance *instance;
+	int old_target;
+
+	tz->ops->get_trip_temp(tz, trip, &trip_temp);
+	tz->ops->get_trip_type(tz, trip, &trip_type);
+	if (tz->ops->get_trip_hyst)
+		tz->ops->get_trip_hyst(tz, trip, &hyst);
+	band = hyst > 0 ? hyst : PREDICTIVE_DEFAULT_BAND;
+
+	mutex_lock(&tz->lock);
+
+	/* handle_thermal_trip() walks every trip for each new sample */
+	if (trip == 0)
+		predictive_update_model(tz, params);
+
+	dev_dbg(&tz->device, "Trip%d[type=%d,temp=%d,band=%d]:pred=%d\n",
+		trip, trip_type, trip_temp, band, params->pred_temp);
+
+	list_for_each_entry(instance, &tz->thermal_instances, tz_node) {
+		if (instance->trip != trip)
+			continue;
+
+		old_target = instance->target;
+		instance->target = get_target_state(instance, params->pred_temp,
+					tz->temperature, trip_temp, band);
+		dev_dbg(&instance->cdev->device, "old_target=%d, target=%d\n",
+					old_target, (int)instance->target);
+
+		if (instance->initialized && old_target == instance->target)
+			continue;
+
+		if (!instance->initialized) {
+			if (instance->target != THERMAL_NO_TARGET) {
+				trace_thermal_zone_trip(tz, trip, trip_type,
+							true);
+				update_passive_instance(tz, trip_type, 1);
+			}
+		} else {
+			if (old_target == THERMAL_NO_TARGET &&
+				instance->target != THERMAL_NO_TARGET) {
+				trace_thermal_zone_trip(tz, trip, trip_type,
+							true);
+				update_passive_instance(tz, trip_type, 1);
+			} else if (old_target != THERMAL_NO_TARGET &&
+				instance->target == THERMAL_NO_TARGET) {
+				trace_thermal_zone_trip(tz, trip, trip_type,
+							false);
+				update_passive_instance(tz, trip_type, -1);
+			}
+		}
+
+		instance->initialized = true;
+		mutex_lock(&instance->cdev->lock);
+		instance->cdev->updated = false; /* cdev needs update */
+		mutex_unlock(&instance->cdev->lock);
+	}
+
+	mutex_unlock(&tz->lock);
+}
+
+static int predictive_bind(struct thermal_zone_device *tz)
+{
+	struct predictive_params *params;
+
+	params = kzalloc(sizeof(*params), GFP_KERNEL);
+	if (!params)
+		return -ENOMEM;
+
+	tz->governor_data = params;
+
+	return 0;
+}
+
+static void predictive_unbind(struct thermal_zone_device *tz)
+{
+	kfree(tz->governor_data);
+	tz->governor_data = NULL;
+}
+
+/**
+ * predictive_throttle - throttles devices associated with the given zone
+ * @tz - thermal_zone_device
+ * @trip - the trip point
+ *
+ * Throttling Logic: The temperature slope of the zone is tracked over its
+ * samples and used to predict the temperature a short horizon ahead. The
+ * cooling devices of a trip are capped in proportion to how far the
+ * predicted temperature has entered the band below the trip, so frequency
+ * is reduced ahead of the trip rather than after it is crossed. Once
+ * mitigation is applied the zone is polled at its passive delay.
+ */
+static int predictive_throttle(struct thermal_zone_device *tz, int trip)
+{
+	struct thermal_instance *instance;
+
+	thermal_zone_trip_update(tz, trip);
+
+	mutex_lock(&tz->lock);
+
+	list_for_each_entry(instance, &tz->thermal_instances, tz_node)
+		thermal_cdev_update(instance->cdev);
+
+	mutex_unlock(&tz->lock);
+
+	return 0;
+}
+
+static struct thermal_governor thermal_gov_predictive = {
+	.name		= "predictive",
+	.bind_to_tz	= predictive_bind,
+	.unbind_from_tz	= predictive_unbind,
+	.throttle	= predictive_throttle,
+};
+
+int thermal_gov_predictive_register(void)
+{
+	return thermal_register_governor(&thermal_gov_predictive);
+}
+
+void thermal_gov_predictive_unregister(void)
+{
+	thermal_unregister_governor(&thermal_gov_predictive);
+}
@@ -33,6 +33,8 @@
 #include <linux/string.h>
 #include <linux/thermal.h>
 #include <linux/list.h>
+#include <linux/atomic.h>
+#include <linux/ktime.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/thermal_virtual.h>
@@ -65,6 +67,8 @@ struct __thermal_bind_params {
  * @trip_low: last trip low value programmed in the sensor driver
  * @lock: mutex lock acquired before updating the trip temperatures
  * @first_tz: list head pointing the first thermal zone
+ * @cached_temp: last reading in the low word and its timestamp in
+ *		 microseconds in the high word, published without locks
  */
 struct __sensor_param {
 	void *sensor_data;
@@ -72,13 +76,19 @@ struct __sensor_param {
 	int trip_high, trip_low;
 	struct mutex lock;
 	struct list_head first_tz;
+	atomic64_t cached_temp;
 };
 
+/* Lifetime of a published sensor reading */
+#define OF_THERMAL_TEMP_CACHE_US	1000
+
 /**
  * struct __thermal_zone - internal representation of a thermal zone
  * @mode: current thermal zone device mode (enabled/disabled)
  * @passive_delay: polling interval while passive cooling is activated
  * @polling_delay: zone polling interval
+ * @polling_window: distance below the nearest trip, in mC, within which the
+ *		    polling interval shrinks towards @passive_delay
  * @slope: slope of the temperature adjustment curve
  * @offset: offset of the temperature adjustment curve
  * @default_disable: Keep the thermal zone disabled by default
@@ -96,6 +106,7 @@ struct __thermal_zone {
 	enum thermal_device_mode mode;
 	int passive_delay;
 	int polling_delay;
+	int polling_window;
 	int slope;
 	int offset;
 	struct thermal_zone_device *tzd;
@@ -146,6 +157,53 @@ struct thermal_message *tm = NULL;
 static int of_thermal_aggregate_trip_types(struct thermal_zone_device *tz,
 		unsigned int trip_type_mask, int *low, int *high);
 
+static int of_thermal_get_temp(struct thermal_zone_device *tz, int *temp);
+
+static u32 of_thermal_stamp(void)
+{
+	u32 stamp = (u32)ktime_to_us(ktime_get());
+
+	/* zero marks a sensor that was never read */
+	return stamp ? stamp : 1;
+}
+
+static bool of_thermal_read_cached(struct __sensor_param *senps, int *temp)
+{
+	u64 val = atomic64_read(&senps->cached_temp);
+	u32 stamp = val >> 32;
+
+	if (!stamp || of_thermal_stamp() - stamp >= OF_THERMAL_TEMP_CACHE_US)
+		return false;
+
+	*temp = (int)(u32)val;
+
+	return true;
+}
+
+static void of_thermal_publish_temp(struct __sensor_param *senps, int temp)
+{
+	atomic64_set(&senps->cached_temp,
+		((u64)of_thermal_stamp() << 32) | (u32)temp);
+}
+
+/*
+ * Lock free read of a zone referenced by a virtual sensor. Sensors sampled
+ * within OF_THERMAL_TEMP_CACHE_US, by any zone or virtual sensor, are
+ * served from the published reading without taking the zone lock.
+ */
+static int virt_sensor_get_zone_temp(struct thermal_zone_device *tz,
+					int *temp)
+{
+	struct __thermal_zone *data = tz->devdata;
+
+	if (tz->ops->get_temp == of_thermal_get_temp && data->senps &&
+		data->mode == THERMAL_DEVICE_ENABLED && !tz->emul_temperature &&
+		of_thermal_read_cached(data->senps, temp))
+		return 0;
+
+	return thermal_zone_get_temp(tz, temp);
+}
+
 /***   DT thermal zone device callbacks   ***/
 
 static int virt_sensor_read_temp(void *data, int *val)
@@ -156,7 +214,7 @@ static int virt_sensor_read_temp(void *data, int *val)
 	for (idx = 0; idx < sens->num_sensors; idx++) {
 		int sens_temp = 0;
 
-		ret = thermal_zone_get_temp(sens->tz[idx], &sens_temp);
+		ret = virt_sensor_get_zone_temp(sens->tz[idx], &sens_temp);
 		if (ret) {
 			pr_err("virt zone: sensor[%s] read error:%d\n",
 				sens->tz[idx]->type, ret);
@@ -193,10 +251,44 @@ static int virt_sensor_read_temp(void *data, int *val)
 	return 0;
 }
 
+/*
+ * Scale the polling interval with the distance to the nearest trip above
+ * @temp. Far from the trips a zone whose sensor programs thresholds is not
+ * polled at all and relies on the threshold interrupts, otherwise it keeps
+ * its polling-delay. Inside the window the interval shrinks linearly down
+ * to polling-delay-passive at the trip. Called with tz->lock held.
+ */
+static void of_thermal_adapt_polling(struct thermal_zone_device *tz, int temp)
+{
+	struct __thermal_zone *data = tz->devdata;
+	int margin = INT_MAX, trip, delay;
+
+	if (!data->polling_window || tz->tzp->tracks_low)
+		return;
+
+	for (trip = 0; trip < data->ntrips; trip++) {
+		int tt = data->trips[trip].temperature;
+
+		if (tt > temp && tt - temp < margin)
+			margin = tt - temp;
+	}
+
+	if (margin >= data->polling_window) {
+		delay = data->senps->ops->set_trips ? 0 : data->polling_delay;
+	} else {
+		delay = max(data->polling_delay, data->passive_delay);
+		delay = data->passive_delay + (delay - data->passive_delay) *
+				margin / data->polling_window;
+	}
+
+	tz->polling_delay = delay;
+}
+
 static int of_thermal_get_temp(struct thermal_zone_device *tz,
 			       int *temp)
 {
 	struct __thermal_zone *data = tz->devdata;
+	int ret;
 
 	if (!data->senps || !data->senps->ops->get_temp)
 		return -EINVAL;
@@ -207,7 +299,18 @@ static int of_thermal_get_temp(struct thermal_zone_device *tz,
 		return 0;
 	}
 
-	return data->senps->ops->get_temp(data->senps->sensor_data, temp);
+	if (of_thermal_read_cached(data->senps, temp)) {
+		ret = 0;
+	} else {
+		ret = data->senps->ops->get_temp(data->senps->sensor_data,
+						 temp);
+		if (!ret)
+			of_thermal_publish_temp(data->senps, *temp);
+	}
+	if (!ret)
+		of_thermal_adapt_polling(tz, *temp);
+
+	return ret;
 }
 
 static int of_thermal_set_trips(struct thermal_zone_device *tz,
@@ -222,6 +325,10 @@ static int of_thermal_set_trips(struct thermal_zone_device *tz,
 	mutex_lock(&data->senps->lock);
 	of_thermal_aggregate_trip_types(tz, GENMASK(THERMAL_TRIP_CRITICAL, 0),
 					&low, &high);
+	/* Interrupt on entering the polling window so polling can resume */
+	if (data->polling_window && !tz->tzp->tracks_low && high != INT_MAX &&
+		tz->temperature < high - data->polling_window)
+		high -= data->polling_window;
 	data->senps->trip_low = low;
 	data->senps->trip_high = high;
 	ret = data->senps->ops->set_trips(data->senps->sensor_data,
@@ -1264,6 +1371,9 @@ __init *thermal_of_build_thermal_zone(struct device_node *np)
 	}
 	tz->polling_delay = prop;
 
+	if (!of_property_read_u32(np, "polling-window", &prop))
+		tz->polling_window = prop;
+
 	tz->default_disable = of_property_read_bool(np,
 					"disable-thermal-zone");
 
@@ -35,6 +35,7 @@
 #include <asm/cacheflush.h>
 
 #include <soc/qcom/scm.h>
+#include <soc/qcom/lmh_dcvs.h>
 
 #include "../thermal_core.h"
 #include "lmh_dbg.h"
@@ -506,6 +507,22 @@ static void limits_isens_vref_ldo_init(struct platform_device *pdev,
 	}
 }
 
+u32 limits_dcvs_get_freq_limit(int cpu)
+{
+	struct limits_dcvs_hw *hw = get_dcvsh_hw_from_cpu(cpu);
+	unsigned long limit;
+
+	if (!hw)
+		return U32_MAX;
+
+	limit = READ_ONCE(hw->hw_freq_limit);
+	if (limit >= hw->max_freq)
+		return U32_MAX;
+
+	return limit;
+}
+EXPORT_SYMBOL(limits_dcvs_get_freq_limit);
+
 static ssize_t
 lmh_freq_limit_show(struct device *dev, struct device_attribute *devattr,
 		       char *buf)
@@ -20,6 +20,7 @@
 #include <linux/workqueue.h>
 #include <linux/io.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 
 #define DEBUG_SIZE				10
 #define TSENS_MAX_SENSORS			16
@@ -92,6 +93,8 @@ struct tsens_sensor {
 	struct tsens_context		thr_state;
 	int				offset;
 	int				slope;
+	int				cached_temp;
+	ktime_t				cached_time;
 };
 
 /**
@@ -157,6 +160,7 @@ struct tsens_device {
 	struct tsens_dbg_context	tsens_dbg;
 	spinlock_t			tsens_crit_lock;
 	spinlock_t			tsens_upp_low_lock;
+	spinlock_t			tsens_temp_lock;
 	const struct tsens_data		*ctrl_data;
 	struct tsens_mtc_sysfs  mtcsys;
 	struct tsens_sensor		sensor[0];
@@ -65,6 +65,7 @@
 #define TSENS_TM_TRDY(n)			((n) + 0xe4)
 #define TSENS_TM_TRDY_FIRST_ROUND_COMPLETE	BIT(3)
 #define TSENS_TM_TRDY_FIRST_ROUND_COMPLETE_SHIFT	3
+#define TSENS_TM_TEMP_CACHE_VALID_US		1000
 
 static void msm_tsens_convert_temp(int last_temp, int *temp)
 {
@@ -78,6 +79,44 @@ static void msm_tsens_convert_temp(int last_temp, int *temp)
 	*temp = last_temp * TSENS_TM_SCALE_DECI_MILLIDEG;
 }
 
+/*
+ * Readings are cached per sensor for a short while so that the interrupt
+ * scan, the zone update it triggers and sibling or virtual zones sharing
+ * the sensor do not each go back to the hardware.
+ */
+static bool tsens2xxx_get_cached_temp(struct tsens_sensor *sensor, int *temp)
+{
+	struct tsens_device *tmdev = sensor->tmdev;
+	unsigned long flags;
+	bool hit = false;
+
+	spin_lock_irqsave(&tmdev->tsens_temp_lock, flags);
+	if (ktime_to_ns(sensor->cached_time) &&
+		ktime_us_delta(ktime_get(), sensor->cached_time) <
+			TSENS_TM_TEMP_CACHE_VALID_US) {
+		*temp = sensor->cached_temp;
+		hit = true;
+	}
+	spin_unlock_irqrestore(&tmdev->tsens_temp_lock, flags);
+
+	return hit;
+}
+
+static void tsens2xxx_cache_temp(struct tsens_sensor *sensor, int temp)
+{
+	struct tsens_device *tmdev = sensor->tmdev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&tmdev->tsens_temp_lock, flags);
+	sensor->cached_temp = temp;
+	sensor->cached_time = ktime_get();
+	spin_unlock_irqrestore(&tmdev->tsens_temp_lock, flags);
+
+	if (tmdev->ops->dbg)
+		tmdev->ops->dbg(tmdev, (u32) sensor->hw_id,
+					TSENS_DBG_LOG_TEMP_READS, &temp);
+}
+
 static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 {
 	struct tsens_device *tmdev = NULL;
@@ -88,6 +127,9 @@ static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 	if (!sensor)
 		return -EINVAL;
 
+	if (tsens2xxx_get_cached_temp(sensor, temp))
+		return 0;
+
 	tmdev = sensor->tmdev;
 	sensor_addr = TSENS_TM_SN_STATUS(tmdev->tsens_tm_addr);
 	trdy = TSENS_TM_TRDY(tmdev->tsens_tm_addr);
@@ -135,9 +177,42 @@ static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 	msm_tsens_convert_temp(last_temp, temp);
 
 dbg:
-	if (tmdev->ops->dbg)
-		tmdev->ops->dbg(tmdev, (u32) sensor->hw_id,
-					TSENS_DBG_LOG_TEMP_READS, temp);
+	tsens2xxx_cache_temp(sensor, *temp);
+
+	return 0;
+}
+
+/*
+ * Sample the status of every channel in one pass. Channels with a valid
+ * reading refresh their cached temperature.
+ */
+static int tsens2xxx_read_all(struct tsens_device *tmdev, u32 *status)
+{
+	void __iomem *sensor_addr, *trdy;
+	unsigned int code;
+	int i, temp;
+
+	sensor_addr = TSENS_TM_SN_STATUS(tmdev->tsens_tm_addr);
+	trdy = TSENS_TM_TRDY(tmdev->tsens_tm_addr);
+
+	code = readl_relaxed_no_log(trdy);
+	if (!((code & TSENS_TM_TRDY_FIRST_ROUND_COMPLETE) >>
+			TSENS_TM_TRDY_FIRST_ROUND_COMPLETE_SHIFT)) {
+		pr_err("TSENS device first round not complete0x%x\n", code);
+		return -ENODATA;
+	}
+
+	for (i = 0; i < TSENS_MAX_SENSORS; i++) {
+		status[i] = readl_relaxed_no_log(sensor_addr +
+				(tmdev->sensor[i].hw_id <<
+				TSENS_STATUS_ADDR_OFFSET));
+		if (!(status[i] & TSENS_TM_SN_STATUS_VALID_BIT))
+			continue;
+
+		msm_tsens_convert_temp(status[i] & TSENS_TM_SN_LAST_TEMP_MASK,
+					&temp);
+		tsens2xxx_cache_temp(&tmdev->sensor[i], temp);
+	}
 
 	return 0;
 }
@@ -398,12 +473,14 @@ static irqreturn_t tsens_tm_irq_thread(int irq, void *data)
 	struct tsens_device *tm = data;
 	unsigned int i, status, threshold, temp;
 	unsigned long flags;
-	void __iomem *sensor_status_addr;
 	void __iomem *sensor_int_mask_addr;
 	void __iomem *sensor_upper_lower_addr;
 	u32 addr_offset = 0;
+	u32 sn_status[TSENS_MAX_SENSORS];
+
+	if (tsens2xxx_read_all(tm, sn_status))
+		goto done;
 
-	sensor_status_addr = TSENS_TM_SN_STATUS(tm->tsens_tm_addr);
 	sensor_int_mask_addr =
 		TSENS_TM_UPPER_LOWER_INT_MASK(tm->tsens_tm_addr);
 	sensor_upper_lower_addr =
@@ -425,7 +502,7 @@ static irqreturn_t tsens_tm_irq_thread(int irq, void *data)
 		spin_lock_irqsave(&tm->tsens_upp_low_lock, flags);
 		addr_offset = tm->sensor[i].hw_id *
 						TSENS_TM_SN_ADDR_OFFSET;
-		status = readl_relaxed(sensor_status_addr + addr_offset);
+		status = sn_status[i];
 		threshold = readl_relaxed(sensor_upper_lower_addr +
 								addr_offset);
 		int_mask = readl_relaxed(sensor_int_mask_addr);
@@ -509,6 +586,7 @@ static irqreturn_t tsens_tm_irq_thread(int irq, void *data)
 	/* Disable monitoring sensor trip threshold for triggered sensor */
 	mb();
 
+done:
 	if (tm->ops->dbg)
 		tm->ops->dbg(tm, 0, TSENS_DBG_LOG_INTERRUPT_TIMESTAMP, NULL);
 
@@ -587,6 +665,7 @@ static int tsens2xxx_hw_init(struct tsens_device *tmdev)
 
 	spin_lock_init(&tmdev->tsens_crit_lock);
 	spin_lock_init(&tmdev->tsens_upp_low_lock);
+	spin_lock_init(&tmdev->tsens_temp_lock);
 
 	if (tmdev->ctrl_data->mtc) {
 		if (tmdev->ops->dbg)
@@ -646,6 +646,7 @@ struct dwc3_ep {
 #define DWC3_EP_PENDING_REQUEST	(1 << 5)
 #define DWC3_EP_MISSED_ISOC	(1 << 6)
 #define DWC3_EP_TRANSFER_STARTED (1 << 8)
+#define DWC3_EP_COMPLETING	(1 << 9)
 
 	/* This last one is specific to EP0 */
 #define DWC3_EP0_DIR_IN		(1 << 31)
@@ -822,6 +823,7 @@ struct dwc3_hwparams {
  * @direction: IN or OUT direction flag
  * @mapped: true when request has been dma-mapped
  * @queued: true when request has been queued to HW
+ * @no_ioc: completion is reported by a later TRB of the same batch
  */
 struct dwc3_request {
 	struct usb_request	request;
@@ -838,6 +840,7 @@ struct dwc3_request {
 	unsigned		direction:1;
 	unsigned		mapped:1;
 	unsigned		started:1;
+	unsigned		no_ioc:1;
 };
 
 /*
@@ -37,6 +37,11 @@
 #include "gadget.h"
 #include "io.h"
 
+static unsigned int bulk_ioc_batch = 4;
+module_param(bulk_ioc_batch, uint, 0644);
+MODULE_PARM_DESC(bulk_ioc_batch,
+		"Bulk requests per completion interrupt, 0 or 1 for one each");
+
 static void dwc3_gadget_wakeup_interrupt(struct dwc3 *dwc, bool remote_wakeup);
 static int dwc3_gadget_wakeup_int(struct dwc3 *dwc);
 static void dwc3_stop_active_transfers(struct dwc3 *dwc);
@@ -1048,9 +1053,12 @@ static void dwc3_prepare_one_trb(struct dwc3_ep *dep,
 			trb->ctrl |= DWC3_TRB_CTRL_ISP_IMI;
 	}
 
-	if ((!req->request.no_interrupt && !chain) ||
+	if ((!req->request.no_interrupt && !req->no_ioc && !chain) ||
 			(dwc3_calc_trbs_left(dep) == 0))
 		trb->ctrl |= DWC3_TRB_CTRL_IOC;
+	/* a short packet ends the batch early, it must not go unnoticed */
+	else if (req->no_ioc && usb_endpoint_dir_out(dep->endpoint.desc))
+		trb->ctrl |= DWC3_TRB_CTRL_ISP_IMI;
 
 	if (chain)
 		trb->ctrl |= DWC3_TRB_CTRL_CHN;
@@ -1166,6 +1174,25 @@ static void dwc3_prepare_one_trb_linear(struct dwc3_ep *dep,
 			false, 0);
 }
 
+/*
+ * Bulk requests prepared together only interrupt on the last one of the
+ * batch, and at least every bulk_ioc_batch requests so the ring does not
+ * run dry before the completions are seen.
+ */
+static bool dwc3_gadget_defer_ioc(struct dwc3_ep *dep,
+		struct dwc3_request *req, unsigned int batched)
+{
+	unsigned int batch = READ_ONCE(bulk_ioc_batch);
+
+	if (batch < 2 || !usb_endpoint_xfer_bulk(dep->endpoint.desc))
+		return false;
+
+	if (list_is_last(&req->list, &dep->pending_list))
+		return false;
+
+	return batched % batch;
+}
+
 /*
  * dwc3_prepare_trbs - setup TRBs from requests
  * @dep: endpoint for which requests are being prepared
@@ -1177,6 +1204,7 @@ static void dwc3_prepare_one_trb_linear(struct dwc3_ep *dep,
 static void dwc3_prepare_trbs(struct dwc3_ep *dep)
 {
 	struct dwc3_request	*req, *n;
+	unsigned int		batched = 0;
 
 	BUILD_BUG_ON_NOT_POWER_OF_2(DWC3_TRB_NUM);
 
@@ -1184,6 +1212,8 @@ static void dwc3_prepare_trbs(struct dwc3_ep *dep)
 		return;
 
 	list_for_each_entry_safe(req, n, &dep->pending_list, list) {
+		req->no_ioc = dwc3_gadget_defer_ioc(dep, req, ++batched);
+
 		if (req->num_pending_sgs > 0)
 			dwc3_prepare_one_trb_sg(dep, req);
 		else
@@ -1395,6 +1425,14 @@ static int __dwc3_gadget_ep_queue(struct dwc3_ep *dep, struct dwc3_request *req)
 	if (!dwc3_calc_trbs_left(dep))
 		return 0;
 
+	/*
+	 * Requests queued from a completion handler are started together,
+	 * with one Update Transfer, once all completed requests were given
+	 * back. See dwc3_endpoint_transfer_complete().
+	 */
+	if (dep->flags & DWC3_EP_COMPLETING)
+		return 0;
+
 	ret = __dwc3_gadget_kick_transfer(dep, 0);
 	if (ret && ret != -EBUSY)
 		dwc3_trace(trace_dwc3_gadget,
@@ -2780,6 +2818,7 @@ static void dwc3_endpoint_transfer_complete(struct dwc3 *dwc,
 	unsigned		status = 0;
 	int			clean_busy;
 	u32			is_xfer_complete;
+	bool			batch;
 
 	is_xfer_complete = (event->endpoint_event == DWC3_DEPEVT_XFERCOMPLETE);
 
@@ -2795,7 +2834,16 @@ static void dwc3_endpoint_transfer_complete(struct dwc3 *dwc,
 		return;
 	}
 
+	/*
+	 * The kick at the end of this function is skipped by the U1/U2
+	 * workaround of old cores, which must not defer requeued requests.
+	 */
+	batch = usb_endpoint_xfer_bulk(dep->endpoint.desc) &&
+		dwc->revision >= DWC3_REVISION_183A;
+	if (batch)
+		dep->flags |= DWC3_EP_COMPLETING;
 	clean_busy = dwc3_cleanup_done_reqs(dwc, dep, event, status);
+	dep->flags &= ~DWC3_EP_COMPLETING;
 	if (clean_busy && (!dep->endpoint.desc || is_xfer_complete ||
 				usb_endpoint_xfer_isoc(dep->endpoint.desc)))
 		dep->flags &= ~DWC3_EP_BUSY;
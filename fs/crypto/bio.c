@@ -25,28 +25,30 @@
 #include <linux/namei.h>
 #include "fscrypt_private.h"
 
+static void __fscrypt_decrypt_bio_page(struct page *page, bool done)
+{
+	if (fscrypt_using_hardware_encryption(page->mapping->host)) {
+		SetPageUptodate(page);
+	} else {
+		int ret = fscrypt_decrypt_page(page->mapping->host,
+			page, PAGE_SIZE, 0, page->index);
+		if (ret) {
+			SetPageError(page);
+		} else if (done) {
+			SetPageUptodate(page);
+		}
+	}
+	if (done)
+		unlock_page(page);
+}
+
 static void __fscrypt_decrypt_bio(struct bio *bio, bool done)
 {
 	struct bio_vec *bv;
 	int i;
 
-	bio_for_each_segment_all(bv, bio, i) {
-		struct page *page = bv->bv_page;
-
-		if (fscrypt_using_hardware_encryption(page->mapping->host)) {
-			SetPageUptodate(page);
-		} else {
-			int ret = fscrypt_decrypt_page(page->mapping->host,
-				page, PAGE_SIZE, 0, page->index);
-			if (ret) {
-				SetPageError(page);
-			} else if (done) {
-				SetPageUptodate(page);
-			}
-		}
-		if (done)
-			unlock_page(page);
-	}
+	bio_for_each_segment_all(bv, bio, i)
+		__fscrypt_decrypt_bio_page(bv->bv_page, done);
 }
 
 void fscrypt_decrypt_bio(struct bio *bio)
@@ -55,6 +57,26 @@ void fscrypt_decrypt_bio(struct bio *bio)
 }
 EXPORT_SYMBOL(fscrypt_decrypt_bio);
 
+/**
+ * fscrypt_decrypt_bio_pages() - decrypt part of a read bio in place
+ * @bio: the bio, its pages must still be locked
+ * @first: index of the first bio_vec to decrypt
+ * @nr: number of bio_vecs to decrypt
+ *
+ * Lets a filesystem split the decryption of a large bio across several
+ * workers. Like fscrypt_decrypt_bio(), failures are reported by setting
+ * PG_error on the page and pages are neither marked uptodate nor unlocked.
+ */
+void fscrypt_decrypt_bio_pages(struct bio *bio, unsigned int first,
+			       unsigned int nr)
+{
+	unsigned int i, end = min_t(unsigned int, first + nr, bio->bi_vcnt);
+
+	for (i = first; i < end; i++)
+		__fscrypt_decrypt_bio_page(bio->bi_io_vec[i].bv_page, false);
+}
+EXPORT_SYMBOL(fscrypt_decrypt_bio_pages);
+
 static void completion_pages(struct work_struct *work)
 {
 	struct fscrypt_ctx *ctx =
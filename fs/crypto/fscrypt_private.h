@@ -187,6 +187,8 @@ struct fscrypt_mode {
 	int ivsize;
 	bool logged_impl_name;
 	bool needs_essiv;
+	/* single-pass ESSIV implementation, used instead when available */
+	const char *essiv_cipher_str;
 };
 
 extern void __exit fscrypt_essiv_cleanup(void);
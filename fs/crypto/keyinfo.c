@@ -148,6 +148,7 @@ static struct fscrypt_mode available_modes[] = {
 		.keysize = 16,
 		.ivsize = 16,
 		.needs_essiv = true,
+		.essiv_cipher_str = "essiv(cbc(aes),sha256)",
 	},
 	[FS_ENCRYPTION_MODE_AES_128_CTS] = {
 		.friendly_name = "AES-128-CTS-CBC",
@@ -240,17 +241,19 @@ static int find_and_derive_key(const struct inode *inode,
 
 /* Allocate and key a symmetric cipher object for the given encryption mode */
 static struct crypto_skcipher *
-allocate_skcipher_for_mode(struct fscrypt_mode *mode, const u8 *raw_key,
-			   const struct inode *inode)
+__allocate_skcipher_for_mode(struct fscrypt_mode *mode, const char *cipher_str,
+			     const u8 *raw_key, const struct inode *inode,
+			     bool quiet)
 {
 	struct crypto_skcipher *tfm;
 	int err;
 
-	tfm = crypto_alloc_skcipher(mode->cipher_str, 0, 0);
+	tfm = crypto_alloc_skcipher(cipher_str, 0, 0);
 	if (IS_ERR(tfm)) {
-		fscrypt_warn(inode->i_sb,
-			     "error allocating '%s' transform for inode %lu: %ld",
-			     mode->cipher_str, inode->i_ino, PTR_ERR(tfm));
+		if (!quiet)
+			fscrypt_warn(inode->i_sb,
+				     "error allocating '%s' transform for inode %lu: %ld",
+				     cipher_str, inode->i_ino, PTR_ERR(tfm));
 		return tfm;
 	}
 	if (unlikely(!mode->logged_impl_name)) {
@@ -278,6 +281,14 @@ err_free_tfm:
 	return ERR_PTR(err);
 }
 
+static struct crypto_skcipher *
+allocate_skcipher_for_mode(struct fscrypt_mode *mode, const u8 *raw_key,
+			   const struct inode *inode)
+{
+	return __allocate_skcipher_for_mode(mode, mode->cipher_str, raw_key,
+					    inode, false);
+}
+
 /* Master key referenced by FS_POLICY_FLAG_DIRECT_KEY policy */
 struct fscrypt_master_key {
 	struct hlist_node mk_node;
@@ -474,6 +485,7 @@ static int setup_crypto_transform(struct fscrypt_info *ci,
 {
 	struct fscrypt_master_key *mk;
 	struct crypto_skcipher *ctfm;
+	bool fused_essiv = false;
 	int err;
 
 	if (ci->ci_flags & FS_POLICY_FLAG_DIRECT_KEY) {
@@ -483,14 +495,23 @@ static int setup_crypto_transform(struct fscrypt_info *ci,
 		ctfm = mk->mk_ctfm;
 	} else {
 		mk = NULL;
-		ctfm = allocate_skcipher_for_mode(mode, raw_key, inode);
+		ctfm = ERR_PTR(-ENOENT);
+		/* the combined transform derives and applies the ESSIV itself */
+		if (mode->essiv_cipher_str)
+			ctfm = __allocate_skcipher_for_mode(mode,
+							    mode->essiv_cipher_str,
+							    raw_key, inode, true);
+		if (!IS_ERR(ctfm))
+			fused_essiv = true;
+		else
+			ctfm = allocate_skcipher_for_mode(mode, raw_key, inode);
 		if (IS_ERR(ctfm))
 			return PTR_ERR(ctfm);
 	}
 	ci->ci_master_key = mk;
 	ci->ci_ctfm = ctfm;
 
-	if (mode->needs_essiv) {
+	if (mode->needs_essiv && !fused_essiv) {
 		/* ESSIV implies 16-byte IVs which implies !DIRECT_KEY */
 		WARN_ON(mode->ivsize != AES_BLOCK_SIZE);
 		WARN_ON(ci->ci_flags & FS_POLICY_FLAG_DIRECT_KEY);
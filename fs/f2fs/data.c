@@ -76,11 +76,29 @@ enum bio_post_read_step {
 	STEP_DECRYPT,
 };
 
+/*
+ * Large read bios are decrypted by up to F2FS_DECRYPT_MAX_CHUNKS workers in
+ * parallel, each taking at least F2FS_DECRYPT_CHUNK_PAGES pages. The bio is
+ * completed by whichever chunk finishes last, so pages are still unlocked
+ * together and in order.
+ */
+#define F2FS_DECRYPT_MAX_CHUNKS		8
+#define F2FS_DECRYPT_CHUNK_PAGES	16
+
+struct bio_decrypt_chunk {
+	struct work_struct work;
+	struct bio_post_read_ctx *ctx;
+	unsigned int first;
+	unsigned int nr;
+};
+
 struct bio_post_read_ctx {
 	struct bio *bio;
 	struct work_struct work;
 	unsigned int cur_step;
 	unsigned int enabled_steps;
+	atomic_t chunks_left;
+	struct bio_decrypt_chunk chunks[F2FS_DECRYPT_MAX_CHUNKS];
 };
 
 static void __read_end_io(struct bio *bio)
@@ -120,13 +138,51 @@ static void decrypt_work(struct work_struct *work)
 	bio_post_read_processing(ctx);
 }
 
+static void decrypt_chunk_work(struct work_struct *work)
+{
+	struct bio_decrypt_chunk *chunk =
+		container_of(work, struct bio_decrypt_chunk, work);
+	struct bio_post_read_ctx *ctx = chunk->ctx;
+
+	fscrypt_decrypt_bio_pages(ctx->bio, chunk->first, chunk->nr);
+
+	if (atomic_dec_and_test(&ctx->chunks_left))
+		bio_post_read_processing(ctx);
+}
+
+static void f2fs_enqueue_decrypt(struct bio_post_read_ctx *ctx)
+{
+	unsigned int vcnt = ctx->bio->bi_vcnt;
+	unsigned int nr_chunks, per_chunk, first, i;
+
+	nr_chunks = min3(DIV_ROUND_UP(vcnt, F2FS_DECRYPT_CHUNK_PAGES),
+			(unsigned int)num_online_cpus(),
+			(unsigned int)F2FS_DECRYPT_MAX_CHUNKS);
+	if (nr_chunks <= 1) {
+		INIT_WORK(&ctx->work, decrypt_work);
+		fscrypt_enqueue_decrypt_work(&ctx->work);
+		return;
+	}
+
+	per_chunk = DIV_ROUND_UP(vcnt, nr_chunks);
+	atomic_set(&ctx->chunks_left, nr_chunks);
+	for (i = 0, first = 0; i < nr_chunks; i++, first += per_chunk) {
+		struct bio_decrypt_chunk *chunk = &ctx->chunks[i];
+
+		chunk->ctx = ctx;
+		chunk->first = first;
+		chunk->nr = min(per_chunk, vcnt - first);
+		INIT_WORK(&chunk->work, decrypt_chunk_work);
+		fscrypt_enqueue_decrypt_work(&chunk->work);
+	}
+}
+
 static void bio_post_read_processing(struct bio_post_read_ctx *ctx)
 {
 	switch (++ctx->cur_step) {
 	case STEP_DECRYPT:
 		if (ctx->enabled_steps & (1 << STEP_DECRYPT)) {
-			INIT_WORK(&ctx->work, decrypt_work);
-			fscrypt_enqueue_decrypt_work(&ctx->work);
+			f2fs_enqueue_decrypt(ctx);
 			return;
 		}
 		ctx->cur_step++;
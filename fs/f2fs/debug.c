@@ -60,6 +60,10 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 	si->vw_cnt = atomic_read(&sbi->vw_cnt);
 	si->max_aw_cnt = atomic_read(&sbi->max_aw_cnt);
 	si->max_vw_cnt = atomic_read(&sbi->max_vw_cnt);
+	si->aw_commit_cnt = atomic64_read(&sbi->aw_commit_cnt);
+	si->aw_commit_pages = atomic64_read(&sbi->aw_commit_pages);
+	si->aw_commit_time = atomic64_read(&sbi->aw_commit_time);
+	si->max_aw_commit_time = atomic64_read(&sbi->max_aw_commit_time);
 	si->nr_dio_read = get_pages(sbi, F2FS_DIO_READ);
 	si->nr_dio_write = get_pages(sbi, F2FS_DIO_WRITE);
 	si->nr_wb_cp_data = get_pages(sbi, F2FS_WB_CP_DATA);
@@ -403,6 +407,12 @@ static int stat_show(struct seq_file *s, void *v)
 			"volatile IO: %4d (Max. %4d)\n",
 			   si->inmem_pages, si->aw_cnt, si->max_aw_cnt,
 			   si->vw_cnt, si->max_vw_cnt);
+		seq_printf(s, "  - atomic commit: %llu, pages: %llu, "
+			"latency: avg %llu us (Max. %llu us)\n",
+			   si->aw_commit_cnt, si->aw_commit_pages,
+			   si->aw_commit_cnt ? div64_u64(si->aw_commit_time,
+						si->aw_commit_cnt) : 0,
+			   si->max_aw_commit_time);
 		seq_printf(s, "  - nodes: %4d in %4d\n",
 			   si->ndirty_node, si->node_pages);
 		seq_printf(s, "  - dents: %4d in dirs:%4d (%4d)\n",
@@ -510,6 +520,10 @@ int f2fs_build_stats(struct f2fs_sb_info *sbi)
 	atomic_set(&sbi->vw_cnt, 0);
 	atomic_set(&sbi->max_aw_cnt, 0);
 	atomic_set(&sbi->max_vw_cnt, 0);
+	atomic64_set(&sbi->aw_commit_cnt, 0);
+	atomic64_set(&sbi->aw_commit_pages, 0);
+	atomic64_set(&sbi->aw_commit_time, 0);
+	atomic64_set(&sbi->max_aw_commit_time, 0);
 
 	mutex_lock(&f2fs_stat_mutex);
 	list_add_tail(&si->stat_list, &f2fs_stat_list);
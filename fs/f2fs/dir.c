@@ -781,15 +781,13 @@ int f2fs_fill_dentries(struct dir_context *ctx, struct f2fs_dentry_ptr *d,
 	struct f2fs_dir_entry *de = NULL;
 	struct fscrypt_str de_name = FSTR_INIT(NULL, 0);
 	struct f2fs_sb_info *sbi = F2FS_I_SB(d->inode);
-	struct blk_plug plug;
+	nid_t ra_nids[MAX_DIR_RA_NODES];
+	int nr_ra = 0;
 	bool readdir_ra = sbi->readdir_ra == 1;
 	int err = 0;
 
 	bit_pos = ((unsigned long)ctx->pos % d->max);
 
-	if (readdir_ra)
-		blk_start_plug(&plug);
-
 	while (bit_pos < d->max) {
 		bit_pos = find_next_bit_le(d->bitmap, d->max, bit_pos);
 		if (bit_pos >= d->max)
@@ -841,14 +839,19 @@ int f2fs_fill_dentries(struct dir_context *ctx, struct f2fs_dentry_ptr *d,
 			goto out;
 		}
 
-		if (readdir_ra)
-			f2fs_ra_node_page(sbi, le32_to_cpu(de->ino));
+		if (readdir_ra) {
+			ra_nids[nr_ra++] = le32_to_cpu(de->ino);
+			if (nr_ra == MAX_DIR_RA_NODES) {
+				f2fs_ra_node_pages_batch(sbi, ra_nids, nr_ra);
+				nr_ra = 0;
+			}
+		}
 
 		ctx->pos = start_pos + bit_pos;
 	}
 out:
-	if (readdir_ra)
-		blk_finish_plug(&plug);
+	if (nr_ra)
+		f2fs_ra_node_pages_batch(sbi, ra_nids, nr_ra);
 	return err;
 }
 
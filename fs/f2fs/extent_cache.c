@@ -203,6 +203,7 @@ static struct extent_node *__attach_extent_node(struct f2fs_sb_info *sbi,
 	en->ei = *ei;
 	INIT_LIST_HEAD(&en->list);
 	en->et = et;
+	en->referenced = false;
 
 	rb_link_node(&en->rb_node, parent, p);
 	rb_insert_color(&en->rb_node, &et->root);
@@ -396,12 +397,13 @@ static bool f2fs_lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 		stat_inc_rbtree_node_hit(sbi);
 
 	*ei = en->ei;
-	spin_lock(&sbi->extent_lock);
-	if (!list_empty(&en->list)) {
-		list_move_tail(&en->list, &sbi->extent_list);
-		et->cached_en = en;
-	}
-	spin_unlock(&sbi->extent_lock);
+	/*
+	 * Don't take the global extent_lock on a hit, the shrinker gives
+	 * referenced nodes a second chance instead of keeping a strict LRU.
+	 */
+	if (!READ_ONCE(en->referenced))
+		WRITE_ONCE(en->referenced, true);
+	WRITE_ONCE(et->cached_en, en);
 	ret = true;
 out:
 	stat_inc_total_hit(sbi);
@@ -617,6 +619,7 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 	struct extent_tree *et, *next;
 	struct extent_node *en;
 	unsigned int node_cnt = 0, tree_cnt = 0;
+	unsigned int rescan;
 	int remained;
 
 	if (!test_opt(sbi, EXTENT_CACHE))
@@ -655,14 +658,24 @@ free_node:
 		goto out;
 
 	remained = nr_shrink - (node_cnt + tree_cnt);
+	/* bound the second chance walk done under extent_lock */
+	rescan = min_t(unsigned int, atomic_read(&sbi->total_ext_node),
+					EXTENT_CACHE_SHRINK_NUMBER * 8);
 
 	spin_lock(&sbi->extent_lock);
-	for (; remained > 0; remained--) {
-		if (list_empty(&sbi->extent_list))
-			break;
+	while (remained > 0 && !list_empty(&sbi->extent_list)) {
 		en = list_first_entry(&sbi->extent_list,
 					struct extent_node, list);
 		et = en->et;
+		/* hit since the last pass, keep hot mappings resident */
+		if (en->referenced && rescan) {
+			rescan--;
+			en->referenced = false;
+			list_move_tail(&en->list, &sbi->extent_list);
+			continue;
+		}
+
+		remained--;
 		if (!write_trylock(&et->lock)) {
 			/* refresh this extent node's position in extent list */
 			list_move_tail(&en->list, &sbi->extent_list);
@@ -1891,6 +1891,7 @@ out:
 static int f2fs_ioc_commit_atomic_write(struct file *filp)
 {
 	struct inode *inode = file_inode(filp);
+	ktime_t start;
 	int ret;
 
 	if (!inode_owner_or_capable(inode))
@@ -1910,13 +1911,21 @@ static int f2fs_ioc_commit_atomic_write(struct file *filp)
 	}
 
 	if (f2fs_is_atomic_file(inode)) {
+		start = ktime_get();
 		ret = f2fs_commit_inmem_pages(inode);
 		if (ret)
 			goto err_out;
 
+		/*
+		 * The last node block goes out with PREFLUSH | FUA, so an
+		 * atomic sync needs no separate cache flush.
+		 */
 		ret = f2fs_do_sync_file(filp, 0, LLONG_MAX, 0, true);
-		if (!ret)
+		if (!ret) {
 			f2fs_drop_inmem_pages(inode);
+			stat_update_atomic_commit(F2FS_I_SB(inode),
+					ktime_us_delta(ktime_get(), start));
+		}
 	} else {
 		ret = f2fs_do_sync_file(filp, 0, LLONG_MAX, 1, false);
 	}
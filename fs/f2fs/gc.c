@@ -284,6 +284,52 @@ static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 		return get_cb_cost(sbi, segno);
 }
 
+/*
+ * Cost-benefit selection from the victim tree. Utilization varies little
+ * within a bucket, so the oldest eligible section of each bucket is its
+ * best candidate and only those few need their cost computed.
+ */
+#define VICTIM_TREE_MAX_SKIP	8
+
+static void get_cb_victim_from_tree(struct f2fs_sb_info *sbi, int gc_type,
+					struct victim_sel_policy *p)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	struct victim_entry *ve;
+	struct rb_node *node;
+	unsigned int secno, segno;
+	unsigned long cost;
+	int i, skipped;
+
+	for (i = 0; i < VICTIM_BUCKETS; i++) {
+		skipped = 0;
+		for (node = rb_first(&dirty_i->victim_tree[i]);
+				node && skipped < VICTIM_TREE_MAX_SKIP;
+				node = rb_next(node), skipped++) {
+			ve = rb_entry(node, struct victim_entry, rb_node);
+			secno = ve - dirty_i->victim_entries;
+			segno = GET_SEG_FROM_SEC(sbi, secno);
+
+			if (sec_usage_check(sbi, secno))
+				continue;
+			/* Don't touch checkpointed data */
+			if (unlikely(is_sbi_flag_set(sbi, SBI_CP_DISABLED) &&
+					get_ckpt_valid_blocks(sbi, segno)))
+				continue;
+			if (gc_type == BG_GC &&
+					test_bit(secno, dirty_i->victim_secmap))
+				continue;
+
+			cost = get_cb_cost(sbi, segno);
+			if (p->min_cost > cost) {
+				p->min_segno = segno;
+				p->min_cost = cost;
+			}
+			break;
+		}
+	}
+}
+
 static unsigned int count_bits(const unsigned long *addr,
 				unsigned int offset, unsigned int len)
 {
@@ -356,6 +402,12 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto got_it;
 	}
 
+	if (p.alloc_mode == LFS && p.gc_mode == GC_CB &&
+			dirty_i->victim_entries) {
+		get_cb_victim_from_tree(sbi, gc_type, &p);
+		goto got_victim;
+	}
+
 	while (1) {
 		unsigned long cost;
 		unsigned int segno;
@@ -411,6 +463,7 @@ next:
 			break;
 		}
 	}
+got_victim:
 	if (p.min_segno != NULL_SEGNO) {
 got_it:
 		*result = (p.min_segno / p.ofs_unit) * p.ofs_unit;
@@ -85,7 +85,12 @@ bool f2fs_available_free_memory(struct f2fs_sb_info *sbi, int type)
 				sizeof(struct extent_tree) +
 				atomic_read(&sbi->total_ext_node) *
 				sizeof(struct extent_node)) >> PAGE_SHIFT;
-		res = mem_size < ((avail_ram * nm_i->ram_thresh / 100) >> 1);
+		if (sbi->extent_cache_budget)
+			res = mem_size < ((unsigned long)sbi->extent_cache_budget
+						<< (20 - PAGE_SHIFT));
+		else
+			res = mem_size <
+				((avail_ram * nm_i->ram_thresh / 100) >> 1);
 	} else if (type == INMEM_PAGES) {
 		/* it allows 20% / total_ram for inmemory pages */
 		mem_size = get_pages(sbi, F2FS_INMEM_PAGES);
@@ -1332,6 +1337,44 @@ void f2fs_ra_node_page(struct f2fs_sb_info *sbi, nid_t nid)
 	f2fs_put_page(apage, err ? 1 : 0);
 }
 
+/*
+ * Readahead the node pages of a batch of nids, e.g. the inodes named by one
+ * dentry block.  NAT blocks for nids missing from the nat cache are read
+ * ahead first, so read_node_page() does not stall on them one nid at a time.
+ */
+void f2fs_ra_node_pages_batch(struct f2fs_sb_info *sbi, nid_t *nids, int n)
+{
+	struct f2fs_nm_info *nm_i = NM_I(sbi);
+	struct blk_plug plug;
+	pgoff_t nat_blk, last_nat_blk = ULONG_MAX;
+	bool cached;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (!nids[i] || f2fs_check_nid_range(sbi, nids[i])) {
+			nids[i] = 0;
+			continue;
+		}
+
+		down_read(&nm_i->nat_tree_lock);
+		cached = __lookup_nat_cache(nm_i, nids[i]);
+		up_read(&nm_i->nat_tree_lock);
+		if (cached)
+			continue;
+
+		nat_blk = NAT_BLOCK_OFFSET(nids[i]);
+		if (nat_blk == last_nat_blk)
+			continue;
+		last_nat_blk = nat_blk;
+		f2fs_ra_meta_pages(sbi, nat_blk, 1, META_NAT, true);
+	}
+
+	blk_start_plug(&plug);
+	for (i = 0; i < n; i++)
+		f2fs_ra_node_page(sbi, nids[i]);
+	blk_finish_plug(&plug);
+}
+
 static struct page *__get_node_page(struct f2fs_sb_info *sbi, pgoff_t nid,
 					struct page *parent, int start)
 {
@@ -381,6 +381,7 @@ static int __f2fs_commit_inmem_pages(struct inode *inode)
 	};
 	struct list_head revoke_list;
 	bool submit_bio = false;
+	unsigned int committed = 0;
 	int err = 0;
 
 	INIT_LIST_HEAD(&revoke_list);
@@ -417,6 +418,7 @@ retry:
 			/* record old blkaddr for revoking */
 			cur->old_addr = fio.old_blkaddr;
 			submit_bio = true;
+			committed++;
 		}
 		unlock_page(page);
 		list_move_tail(&cur->list, &revoke_list);
@@ -424,6 +426,7 @@ retry:
 
 	if (submit_bio)
 		f2fs_submit_merged_write_cond(sbi, inode, NULL, 0, DATA);
+	stat_add_atomic_commit_pages(sbi, committed);
 
 	if (err) {
 		/*
@@ -452,6 +455,7 @@ int f2fs_commit_inmem_pages(struct inode *inode)
 {
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
 	struct f2fs_inode_info *fi = F2FS_I(inode);
+	struct blk_plug plug;
 	int err;
 
 	f2fs_balance_fs(sbi, true);
@@ -461,9 +465,12 @@ int f2fs_commit_inmem_pages(struct inode *inode)
 	f2fs_lock_op(sbi);
 	set_inode_flag(inode, FI_ATOMIC_COMMIT);
 
+	/* let the transaction reach the device as few large requests */
+	blk_start_plug(&plug);
 	mutex_lock(&fi->inmem_lock);
 	err = __f2fs_commit_inmem_pages(inode);
 	mutex_unlock(&fi->inmem_lock);
+	blk_finish_plug(&plug);
 
 	clear_inode_flag(inode, FI_ATOMIC_COMMIT);
 
@@ -764,6 +771,65 @@ int f2fs_flush_device_cache(struct f2fs_sb_info *sbi)
 	return ret;
 }
 
+/*
+ * Keep the section of @segno in the victim tree matching its utilization,
+ * keyed by its average mtime, as long as one of its segments is dirty.
+ * Must hold seglist_lock.
+ */
+static void __update_victim_entry(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
+	unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
+	unsigned int end = start + sbi->segs_per_sec;
+	unsigned int bucket = VICTIM_UNLINKED;
+	unsigned long long mtime = 0;
+	struct rb_node **p, *parent = NULL;
+	struct victim_entry *ve;
+	struct rb_root *root;
+	unsigned int i;
+
+	if (!dirty_i->victim_entries)
+		return;
+
+	ve = &dirty_i->victim_entries[secno];
+
+	if (find_next_bit(dirty_i->dirty_segmap[DIRTY], end, start) < end) {
+		for (i = start; i < end; i++)
+			mtime += get_seg_entry(sbi, i)->mtime;
+		mtime = div_u64(mtime, sbi->segs_per_sec);
+		bucket = div_u64((u64)get_valid_blocks(sbi, start, true) *
+					VICTIM_BUCKETS, BLKS_PER_SEC(sbi));
+		bucket = min_t(unsigned int, bucket, VICTIM_BUCKETS - 1);
+	}
+
+	/* valid blocks change on every write, the bucket rarely does */
+	if (bucket == ve->bucket && (bucket == VICTIM_UNLINKED ||
+						mtime == ve->mtime))
+		return;
+
+	if (ve->bucket != VICTIM_UNLINKED)
+		rb_erase(&ve->rb_node, &dirty_i->victim_tree[ve->bucket]);
+
+	ve->bucket = bucket;
+	ve->mtime = mtime;
+	if (bucket == VICTIM_UNLINKED)
+		return;
+
+	root = &dirty_i->victim_tree[bucket];
+	p = &root->rb_node;
+	while (*p) {
+		parent = *p;
+		if (mtime < rb_entry(parent, struct victim_entry,
+						rb_node)->mtime)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+	rb_link_node(&ve->rb_node, parent, p);
+	rb_insert_color(&ve->rb_node, root);
+}
+
 static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		enum dirty_type dirty_type)
 {
@@ -786,6 +852,8 @@ static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		}
 		if (!test_and_set_bit(segno, dirty_i->dirty_segmap[t]))
 			dirty_i->nr_dirty[t]++;
+
+		__update_victim_entry(sbi, segno);
 	}
 }
 
@@ -807,6 +875,8 @@ static void __remove_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		if (get_valid_blocks(sbi, segno, true) == 0)
 			clear_bit(GET_SEC_FROM_SEG(sbi, segno),
 						dirty_i->victim_secmap);
+
+		__update_victim_entry(sbi, segno);
 	}
 }
 
@@ -1052,6 +1122,26 @@ static void __check_sit_bitmap(struct f2fs_sb_info *sbi,
 #endif
 }
 
+/*
+ * Background discards smaller than what the device can actually unmap only
+ * cost a command slot, so don't go below the device's advertised unit.
+ */
+static unsigned int __device_discard_granularity(struct f2fs_sb_info *sbi)
+{
+	unsigned int gran = 0;
+	int i;
+
+	if (!f2fs_is_multi_device(sbi)) {
+		gran = bdev_get_queue(sbi->sb->s_bdev)->limits.discard_granularity;
+	} else {
+		for (i = 0; i < sbi->s_ndevs; i++)
+			gran = max(gran,
+				bdev_get_queue(FDEV(i).bdev)->limits.discard_granularity);
+	}
+
+	return min_t(unsigned int, F2FS_BYTES_TO_BLK(gran), MAX_PLIST_NUM);
+}
+
 static void __init_discard_policy(struct f2fs_sb_info *sbi,
 				struct discard_policy *dpolicy,
 				int discard_type, unsigned int granularity)
@@ -2026,7 +2116,8 @@ static int create_discard_cmd_control(struct f2fs_sb_info *sbi)
 	if (!dcc)
 		return -ENOMEM;
 
-	dcc->discard_granularity = DEFAULT_DISCARD_GRANULARITY;
+	dcc->discard_granularity = max_t(unsigned int, DEFAULT_DISCARD_GRANULARITY,
+					__device_discard_granularity(sbi));
 	INIT_LIST_HEAD(&dcc->entry_list);
 	for (i = 0; i < MAX_PLIST_NUM; i++)
 		INIT_LIST_HEAD(&dcc->pend_list[i]);
@@ -2996,6 +3087,45 @@ static int __get_segment_type_4(struct f2fs_io_info *fio)
 	}
 }
 
+/*
+ * Age the inode's write heat and account this block.  Only overwrites add
+ * heat, so a file written once in one go stays warm however large it is.
+ * Updates are racy on purpose: a lost increment merely skews the estimate.
+ */
+static int __get_data_heat_type(struct f2fs_io_info *fio, struct inode *inode)
+{
+	struct f2fs_sm_info *sm = SM_I(fio->sbi);
+	struct f2fs_inode_info *fi = F2FS_I(inode);
+	unsigned long period, now = jiffies;
+	unsigned int heat, idle = 0;
+	u64 nr_blocks;
+
+	if (!sm->data_heat_period || !S_ISREG(inode->i_mode))
+		return CURSEG_WARM_DATA;
+
+	period = msecs_to_jiffies(sm->data_heat_period * MSEC_PER_SEC);
+	heat = READ_ONCE(fi->i_write_heat);
+
+	if (!fi->i_heat_stamp) {
+		fi->i_heat_stamp = now;
+	} else if (time_after_eq(now, fi->i_heat_stamp + period)) {
+		idle = (now - fi->i_heat_stamp) / period;
+		heat = idle < 32 ? heat >> idle : 0;
+		fi->i_heat_stamp += idle * period;
+	}
+
+	if (__is_valid_data_blkaddr(fio->old_blkaddr) && heat < UINT_MAX)
+		heat++;
+	WRITE_ONCE(fi->i_write_heat, heat);
+
+	nr_blocks = max_t(u64, 1, F2FS_BLK_ALIGN(i_size_read(inode)));
+	if (heat >= nr_blocks * sm->data_heat_hot)
+		return CURSEG_HOT_DATA;
+	if (sm->data_heat_cold && idle >= sm->data_heat_cold)
+		return CURSEG_COLD_DATA;
+	return CURSEG_WARM_DATA;
+}
+
 static int __get_segment_type_6(struct f2fs_io_info *fio)
 {
 	if (fio->type == DATA) {
@@ -3009,7 +3139,7 @@ static int __get_segment_type_6(struct f2fs_io_info *fio)
 				f2fs_is_volatile_file(inode))
 			return CURSEG_HOT_DATA;
 		/* f2fs_rw_hint_to_seg_type(inode->i_write_hint); */
-		return CURSEG_WARM_DATA;
+		return __get_data_heat_type(fio, inode);
 	} else {
 		if (IS_DNODE(fio->page))
 			return is_cold_node(fio->page) ? CURSEG_WARM_NODE :
@@ -4245,10 +4375,28 @@ static int init_victim_secmap(struct f2fs_sb_info *sbi)
 	return 0;
 }
 
+static int init_victim_tree(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int i;
+
+	dirty_i->victim_entries = f2fs_kvzalloc(sbi, MAIN_SECS(sbi) *
+				sizeof(struct victim_entry), GFP_KERNEL);
+	if (!dirty_i->victim_entries)
+		return -ENOMEM;
+
+	for (i = 0; i < MAIN_SECS(sbi); i++)
+		dirty_i->victim_entries[i].bucket = VICTIM_UNLINKED;
+	for (i = 0; i < VICTIM_BUCKETS; i++)
+		dirty_i->victim_tree[i] = RB_ROOT;
+	return 0;
+}
+
 static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i;
 	unsigned int bitmap_size, i;
+	int err;
 
 	/* allocate memory for dirty segments list information */
 	dirty_i = f2fs_kzalloc(sbi, sizeof(struct dirty_seglist_info),
@@ -4268,6 +4416,10 @@ static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 			return -ENOMEM;
 	}
 
+	err = init_victim_tree(sbi);
+	if (err)
+		return err;
+
 	init_dirty_segmap(sbi);
 	return init_victim_secmap(sbi);
 }
@@ -4364,6 +4516,8 @@ int f2fs_build_segment_manager(struct f2fs_sb_info *sbi)
 	sm_info->min_fsync_blocks = DEF_MIN_FSYNC_BLOCKS;
 	sm_info->min_seq_blocks = sbi->blocks_per_seg * sbi->segs_per_sec;
 	sm_info->min_hot_blocks = DEF_MIN_HOT_BLOCKS;
+	sm_info->data_heat_hot = DEF_DATA_HEAT_HOT;
+	sm_info->data_heat_cold = DEF_DATA_HEAT_COLD;
 	sm_info->min_ssr_sections = reserved_sections(sbi);
 
 	INIT_LIST_HEAD(&sm_info->sit_entry_set);
@@ -4423,6 +4577,7 @@ static void destroy_victim_secmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
 	kvfree(dirty_i->victim_secmap);
+	kvfree(dirty_i->victim_entries);
 }
 
 static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
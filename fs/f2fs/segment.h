@@ -271,12 +271,27 @@ enum dirty_type {
 	NR_DIRTY_TYPE
 };
 
+/*
+ * Dirty sections indexed for cost-benefit victim selection: one rb-tree per
+ * utilization bucket, each sorted by the section's average mtime.
+ */
+#define VICTIM_BUCKETS		16
+#define VICTIM_UNLINKED		VICTIM_BUCKETS
+
+struct victim_entry {
+	struct rb_node rb_node;			/* linked in victim_tree[bucket] */
+	unsigned long long mtime;		/* average mtime of the section */
+	unsigned int bucket;			/* or VICTIM_UNLINKED */
+};
+
 struct dirty_seglist_info {
 	const struct victim_selection *v_ops;	/* victim selction operation */
 	unsigned long *dirty_segmap[NR_DIRTY_TYPE];
 	struct mutex seglist_lock;		/* lock for segment bitmaps */
 	int nr_dirty[NR_DIRTY_TYPE];		/* # of dirty segments */
 	unsigned long *victim_secmap;		/* background GC victims */
+	struct victim_entry *victim_entries;	/* one per section */
+	struct rb_root victim_tree[VICTIM_BUCKETS];
 };
 
 /* victim selection function for cleaning and SSR */
@@ -620,6 +635,15 @@ static inline int utilization(struct f2fs_sb_info *sbi)
 #define DEF_MIN_FSYNC_BLOCKS	8
 #define DEF_MIN_HOT_BLOCKS	16
 
+/*
+ * Write-frequency based data temperature, disabled while data_heat_period
+ * is 0.  An inode becomes hot once its decayed overwrite count reaches
+ * data_heat_hot times its size, and cold when it is rewritten after
+ * data_heat_cold idle periods.
+ */
+#define DEF_DATA_HEAT_HOT	4
+#define DEF_DATA_HEAT_COLD	8
+
 #define SMALL_VOLUME_SEGMENTS	(16 * 512)	/* 16GB */
 
 enum {
@@ -10,6 +10,7 @@
 
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/slab.h>
 
 #define FUSE_CTL_SUPER_MAGIC 0x65735543
 
@@ -170,6 +171,96 @@ static ssize_t fuse_conn_congestion_threshold_write(struct file *file,
 	return ret;
 }
 
+static ssize_t fuse_conn_cpu_queues_read(struct file *file, char __user *buf,
+					 size_t len, loff_t *ppos)
+{
+	struct fuse_conn *fc;
+	unsigned val;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	val = READ_ONCE(fc->cpu_queues);
+	fuse_conn_put(fc);
+
+	return fuse_conn_limit_read(file, buf, len, ppos, val);
+}
+
+static ssize_t fuse_conn_cpu_queues_write(struct file *file,
+					  const char __user *buf,
+					  size_t count, loff_t *ppos)
+{
+	unsigned uninitialized_var(val);
+	ssize_t ret;
+
+	ret = fuse_conn_limit_write(file, buf, count, ppos, &val, 1);
+	if (ret > 0) {
+		struct fuse_conn *fc;
+
+		if (val > 1)
+			return -EINVAL;
+
+		fc = fuse_ctl_file_conn_get(file);
+		if (fc) {
+			WRITE_ONCE(fc->cpu_queues, val);
+			fuse_conn_put(fc);
+		}
+	}
+
+	return ret;
+}
+
+static ssize_t fuse_conn_queues_read(struct file *file, char __user *buf,
+				     size_t len, loff_t *ppos)
+{
+	struct fuse_conn *fc;
+	size_t size, bufsize;
+	ssize_t ret;
+	char *tmp;
+	int cpu;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	ret = 0;
+	if (!fc->cpu_iq)
+		goto out;
+
+	ret = -ENOMEM;
+	bufsize = (num_possible_cpus() + 1) * 64;
+	tmp = kmalloc(bufsize, GFP_KERNEL);
+	if (!tmp)
+		goto out;
+
+	size = scnprintf(tmp, bufsize, "cpu readers depth max_depth queued\n");
+	for_each_possible_cpu(cpu) {
+		struct fuse_cpu_iqueue *ciq = per_cpu_ptr(fc->cpu_iq, cpu);
+		unsigned readers, depth, max_depth;
+		u64 queued;
+
+		spin_lock(&ciq->waitq.lock);
+		readers = ciq->nr_readers;
+		depth = ciq->depth;
+		max_depth = ciq->max_depth;
+		queued = ciq->queued;
+		spin_unlock(&ciq->waitq.lock);
+
+		if (!readers && !queued)
+			continue;
+		size += scnprintf(tmp + size, bufsize - size,
+				  "%d %u %u %u %llu\n", cpu, readers, depth,
+				  max_depth, queued);
+	}
+
+	ret = simple_read_from_buffer(buf, len, ppos, tmp, size);
+	kfree(tmp);
+ out:
+	fuse_conn_put(fc);
+	return ret;
+}
+
 static const struct file_operations fuse_ctl_abort_ops = {
 	.open = nonseekable_open,
 	.write = fuse_conn_abort_write,
@@ -196,6 +287,19 @@ static const struct file_operations fuse_conn_congestion_threshold_ops = {
 	.llseek = no_llseek,
 };
 
+static const struct file_operations fuse_conn_cpu_queues_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_cpu_queues_read,
+	.write = fuse_conn_cpu_queues_write,
+	.llseek = no_llseek,
+};
+
+static const struct file_operations fuse_conn_queues_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_queues_read,
+	.llseek = no_llseek,
+};
+
 static struct dentry *fuse_ctl_add_dentry(struct dentry *parent,
 					  struct fuse_conn *fc,
 					  const char *name,
@@ -264,7 +368,11 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 1, NULL, &fuse_conn_max_background_ops) ||
 	    !fuse_ctl_add_dentry(parent, fc, "congestion_threshold",
 				 S_IFREG | 0600, 1, NULL,
-				 &fuse_conn_congestion_threshold_ops))
+				 &fuse_conn_congestion_threshold_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "cpu_queues", S_IFREG | 0600,
+				 1, NULL, &fuse_conn_cpu_queues_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "queues", S_IFREG | 0400, 1,
+				 NULL, &fuse_conn_queues_ops))
 		goto err;
 
 	return 0;
@@ -318,7 +318,7 @@ static unsigned len_args(unsigned numargs, struct fuse_arg *args)
 
 static u64 fuse_get_unique(struct fuse_iqueue *fiq)
 {
-	return ++fiq->reqctr;
+	return atomic64_inc_return(&fiq->reqctr);
 }
 
 static void queue_request(struct fuse_iqueue *fiq, struct fuse_req *req)
@@ -330,6 +330,42 @@ static void queue_request(struct fuse_iqueue *fiq, struct fuse_req *req)
 	kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
 }
 
+/*
+ * Queue a synchronous request on the submitting CPU's own queue, if a
+ * daemon thread serves it, so concurrent submitters on different CPUs
+ * don't all serialize on fiq->waitq.lock.  The extra reference for
+ * __fuse_request_send() is taken before the request becomes visible.
+ */
+static bool queue_request_cpu(struct fuse_conn *fc, struct fuse_req *req)
+{
+	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_cpu_iqueue *ciq;
+
+	if (!fc->cpu_iq)
+		return false;
+
+	ciq = per_cpu_ptr(fc->cpu_iq, raw_smp_processor_id());
+	spin_lock(&ciq->waitq.lock);
+	/* fuse_abort_conn() drains the queue after clearing ->connected */
+	if (!ciq->nr_readers || !fiq->connected) {
+		spin_unlock(&ciq->waitq.lock);
+		return false;
+	}
+	req->in.h.unique = fuse_get_unique(fiq);
+	req->in.h.len = sizeof(struct fuse_in_header) +
+		len_args(req->in.numargs, (struct fuse_arg *) req->in.args);
+	req->ciq = ciq;
+	list_add_tail(&req->list, &ciq->pending);
+	if (++ciq->depth > ciq->max_depth)
+		ciq->max_depth = ciq->depth;
+	ciq->queued++;
+	__fuse_get_request(req);
+	wake_up_locked(&ciq->waitq);
+	spin_unlock(&ciq->waitq.lock);
+
+	return true;
+}
+
 void fuse_queue_forget(struct fuse_conn *fc, struct fuse_forget_link *forget,
 		       u64 nodeid, u64 nlookup)
 {
@@ -462,15 +498,27 @@ static void request_wait_answer(struct fuse_conn *fc, struct fuse_req *req)
 		if (!err)
 			return;
 
+		struct fuse_cpu_iqueue *ciq;
+
 		spin_lock(&fiq->waitq.lock);
+		/* ->ciq only changes under fiq->waitq.lock once queued */
+		ciq = req->ciq;
+		if (ciq)
+			spin_lock(&ciq->waitq.lock);
 		/* Request is not yet in userspace, bail out */
 		if (test_bit(FR_PENDING, &req->flags)) {
 			list_del(&req->list);
+			if (ciq) {
+				ciq->depth--;
+				spin_unlock(&ciq->waitq.lock);
+			}
 			spin_unlock(&fiq->waitq.lock);
 			__fuse_put_request(req);
 			req->out.h.error = -EINTR;
 			return;
 		}
+		if (ciq)
+			spin_unlock(&ciq->waitq.lock);
 		spin_unlock(&fiq->waitq.lock);
 	}
 
@@ -488,6 +536,13 @@ static void __fuse_request_send(struct fuse_conn *fc, struct fuse_req *req)
 	struct fuse_iqueue *fiq = &fc->iq;
 
 	BUG_ON(test_bit(FR_BACKGROUND, &req->flags));
+	if (queue_request_cpu(fc, req)) {
+		request_wait_answer(fc, req);
+		/* Pairs with smp_wmb() in request_end() */
+		smp_rmb();
+		return;
+	}
+
 	spin_lock(&fiq->waitq.lock);
 	if (!fiq->connected) {
 		spin_unlock(&fiq->waitq.lock);
@@ -1257,6 +1312,65 @@ __releases(fiq->waitq.lock)
 		return fuse_read_batch_forget(fiq, cs, nbytes);
 }
 
+/*
+ * A cloned device read by a thread pinned to a single CPU starts serving
+ * that CPU's queue once cpu_queues is enabled for the connection, and
+ * keeps doing so until it's released.
+ */
+static struct fuse_cpu_iqueue *fuse_dev_bind_cpu(struct fuse_dev *fud)
+{
+	struct fuse_conn *fc = fud->fc;
+	struct fuse_cpu_iqueue *ciq;
+	int cpu = READ_ONCE(fud->cpu);
+
+	if (cpu >= 0)
+		return per_cpu_ptr(fc->cpu_iq, cpu);
+
+	if (!fud->cloned || !fc->cpu_iq || !READ_ONCE(fc->cpu_queues) ||
+	    tsk_nr_cpus_allowed(current) != 1)
+		return NULL;
+
+	cpu = cpumask_first(tsk_cpus_allowed(current));
+	if (cmpxchg(&fud->cpu, -1, cpu) != -1)
+		return per_cpu_ptr(fc->cpu_iq, fud->cpu);
+
+	ciq = per_cpu_ptr(fc->cpu_iq, cpu);
+	spin_lock(&ciq->waitq.lock);
+	ciq->nr_readers++;
+	spin_unlock(&ciq->waitq.lock);
+
+	return ciq;
+}
+
+/*
+ * Hand requests left on a CPU queue without readers back to the shared
+ * queue, where the remaining daemon threads will pick them up.
+ */
+static void fuse_dev_unbind_cpu(struct fuse_dev *fud)
+{
+	struct fuse_conn *fc = fud->fc;
+	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_cpu_iqueue *ciq;
+	struct fuse_req *req;
+
+	if (fud->cpu < 0)
+		return;
+
+	ciq = per_cpu_ptr(fc->cpu_iq, fud->cpu);
+	spin_lock(&fiq->waitq.lock);
+	spin_lock(&ciq->waitq.lock);
+	if (!--ciq->nr_readers && !list_empty(&ciq->pending)) {
+		list_for_each_entry(req, &ciq->pending, list)
+			req->ciq = NULL;
+		list_splice_tail_init(&ciq->pending, &fiq->pending);
+		ciq->depth = 0;
+		wake_up_all_locked(&fiq->waitq);
+	}
+	spin_unlock(&ciq->waitq.lock);
+	spin_unlock(&fiq->waitq.lock);
+	fud->cpu = -1;
+}
+
 /*
  * Read a single request into the userspace filesystem's buffer.  This
  * function waits until a request is available, then removes it from
@@ -1273,11 +1387,37 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	struct fuse_conn *fc = fud->fc;
 	struct fuse_iqueue *fiq = &fc->iq;
 	struct fuse_pqueue *fpq = &fud->pq;
+	struct fuse_cpu_iqueue *ciq;
 	struct fuse_req *req;
 	struct fuse_in *in;
 	unsigned reqsize;
 
  restart:
+	ciq = fuse_dev_bind_cpu(fud);
+	if (ciq) {
+		spin_lock(&ciq->waitq.lock);
+		err = -EAGAIN;
+		if ((file->f_flags & O_NONBLOCK) && fiq->connected &&
+		    list_empty(&ciq->pending))
+			goto err_unlock_cpu;
+
+		err = wait_event_interruptible_exclusive_locked(ciq->waitq,
+				!fiq->connected || !list_empty(&ciq->pending));
+		if (err)
+			goto err_unlock_cpu;
+
+		err = -ENODEV;
+		if (!fiq->connected)
+			goto err_unlock_cpu;
+
+		req = list_entry(ciq->pending.next, struct fuse_req, list);
+		clear_bit(FR_PENDING, &req->flags);
+		list_del_init(&req->list);
+		ciq->depth--;
+		spin_unlock(&ciq->waitq.lock);
+		goto got_req;
+	}
+
 	spin_lock(&fiq->waitq.lock);
 	err = -EAGAIN;
 	if ((file->f_flags & O_NONBLOCK) && fiq->connected &&
@@ -1312,6 +1452,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	list_del_init(&req->list);
 	spin_unlock(&fiq->waitq.lock);
 
+ got_req:
 	in = &req->in;
 	reqsize = in->h.len;
 	/* If request is too large, reply with an error and restart the read */
@@ -1377,6 +1518,10 @@ out_end:
  err_unlock:
 	spin_unlock(&fiq->waitq.lock);
 	return err;
+
+ err_unlock_cpu:
+	spin_unlock(&ciq->waitq.lock);
+	return err;
 }
 
 static int fuse_dev_open(struct inode *inode, struct file *file)
@@ -2097,6 +2242,22 @@ static unsigned fuse_dev_poll(struct file *file, poll_table *wait)
 		return POLLERR;
 
 	fiq = &fud->fc->iq;
+	if (fud->cpu >= 0) {
+		struct fuse_cpu_iqueue *ciq;
+
+		ciq = per_cpu_ptr(fud->fc->cpu_iq, fud->cpu);
+		poll_wait(file, &ciq->waitq, wait);
+
+		spin_lock(&ciq->waitq.lock);
+		if (!fiq->connected)
+			mask = POLLERR;
+		else if (!list_empty(&ciq->pending))
+			mask |= POLLIN | POLLRDNORM;
+		spin_unlock(&ciq->waitq.lock);
+
+		return mask;
+	}
+
 	poll_wait(file, &fiq->waitq, wait);
 
 	spin_lock(&fiq->waitq.lock);
@@ -2198,6 +2359,20 @@ void fuse_abort_conn(struct fuse_conn *fc)
 		spin_lock(&fiq->waitq.lock);
 		fiq->connected = 0;
 		list_splice_init(&fiq->pending, &to_end2);
+		if (fc->cpu_iq) {
+			int cpu;
+
+			for_each_possible_cpu(cpu) {
+				struct fuse_cpu_iqueue *ciq;
+
+				ciq = per_cpu_ptr(fc->cpu_iq, cpu);
+				spin_lock(&ciq->waitq.lock);
+				list_splice_init(&ciq->pending, &to_end2);
+				ciq->depth = 0;
+				wake_up_all_locked(&ciq->waitq);
+				spin_unlock(&ciq->waitq.lock);
+			}
+		}
 		list_for_each_entry(req, &to_end2, list)
 			clear_bit(FR_PENDING, &req->flags);
 		while (forget_pending(fiq))
@@ -2237,6 +2412,8 @@ int fuse_dev_release(struct inode *inode, struct file *file)
 		struct fuse_pqueue *fpq = &fud->pq;
 		LIST_HEAD(to_end);
 
+		fuse_dev_unbind_cpu(fud);
+
 		spin_lock(&fpq->lock);
 		WARN_ON(!list_empty(&fpq->io));
 		list_splice_init(&fpq->processing, &to_end);
@@ -2277,6 +2454,7 @@ static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
 	if (!fud)
 		return -ENOMEM;
 
+	fud->cloned = true;
 	new->private_data = fud;
 	atomic_inc(&fc->dev_count);
 
@@ -35,7 +35,7 @@
 #define FUSE_NAME_MAX 1024
 
 /** Number of dentries for each connection in the control filesystem */
-#define FUSE_CTL_NUM_DENTRIES 5
+#define FUSE_CTL_NUM_DENTRIES 7
 
 /** Number of page pointers embedded in fuse_req */
 #define FUSE_REQ_INLINE_PAGES 1
@@ -320,6 +320,9 @@ struct fuse_req {
 	/** Unique ID for the interrupt request */
 	u64 intr_unique;
 
+	/** Per-CPU queue holding the request while it's pending, if any */
+	struct fuse_cpu_iqueue *ciq;
+
 	/* Request flags, updated with test/set/clear_bit() */
 	unsigned long flags;
 
@@ -404,7 +407,7 @@ struct fuse_iqueue {
 	wait_queue_head_t waitq;
 
 	/** The next unique request id */
-	u64 reqctr;
+	atomic64_t reqctr;
 
 	/** The list of pending requests */
 	struct list_head pending;
@@ -423,6 +426,29 @@ struct fuse_iqueue {
 	struct fasync_struct *fasync;
 };
 
+/**
+ * Input queue for synchronous requests submitted on one CPU.  Only used
+ * while a daemon thread pinned to that CPU is reading from it, so other
+ * CPUs never take its lock.
+ */
+struct fuse_cpu_iqueue {
+	/** Bound readers wait on this, its lock protects the queue */
+	wait_queue_head_t waitq;
+
+	/** The list of pending requests */
+	struct list_head pending;
+
+	/** Number of devices bound to this CPU */
+	unsigned nr_readers;
+
+	/** Current and maximum number of pending requests */
+	unsigned depth;
+	unsigned max_depth;
+
+	/** Total number of requests queued here */
+	u64 queued;
+};
+
 struct fuse_pqueue {
 	/** Connection established */
 	unsigned connected;
@@ -449,6 +475,12 @@ struct fuse_dev {
 
 	/** list entry on fc->devices */
 	struct list_head entry;
+
+	/** Created with FUSE_DEV_IOC_CLONE */
+	bool cloned;
+
+	/** CPU whose queue this device serves, or -1 */
+	int cpu;
 };
 
 /**
@@ -485,6 +517,12 @@ struct fuse_conn {
 	/** Input queue */
 	struct fuse_iqueue iq;
 
+	/** Per-CPU input queues, NULL if they couldn't be allocated */
+	struct fuse_cpu_iqueue __percpu *cpu_iq;
+
+	/** Let cloned devices pinned to one CPU serve that CPU's queue */
+	bool cpu_queues;
+
 	/** The next unique kernel file handle */
 	u64 khctr;
 
@@ -21,6 +21,7 @@
 #include <linux/sched.h>
 #include <linux/exportfs.h>
 #include <linux/posix_acl.h>
+#include <linux/percpu.h>
 
 MODULE_AUTHOR("Miklos Szeredi <miklos@szeredi.hu>");
 MODULE_DESCRIPTION("Filesystem in Userspace");
@@ -603,6 +604,22 @@ static void fuse_iqueue_init(struct fuse_iqueue *fiq)
 	fiq->connected = 1;
 }
 
+static void fuse_cpu_iqueue_init(struct fuse_conn *fc)
+{
+	int cpu;
+
+	fc->cpu_iq = alloc_percpu(struct fuse_cpu_iqueue);
+	if (!fc->cpu_iq)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct fuse_cpu_iqueue *ciq = per_cpu_ptr(fc->cpu_iq, cpu);
+
+		init_waitqueue_head(&ciq->waitq);
+		INIT_LIST_HEAD(&ciq->pending);
+	}
+}
+
 static void fuse_pqueue_init(struct fuse_pqueue *fpq)
 {
 	memset(fpq, 0, sizeof(struct fuse_pqueue));
@@ -622,6 +639,7 @@ void fuse_conn_init(struct fuse_conn *fc)
 	init_waitqueue_head(&fc->blocked_waitq);
 	init_waitqueue_head(&fc->reserved_req_waitq);
 	fuse_iqueue_init(&fc->iq);
+	fuse_cpu_iqueue_init(fc);
 	INIT_LIST_HEAD(&fc->bg_queue);
 	INIT_LIST_HEAD(&fc->entry);
 	INIT_LIST_HEAD(&fc->devices);
@@ -643,6 +661,7 @@ void fuse_conn_put(struct fuse_conn *fc)
 	if (atomic_dec_and_test(&fc->count)) {
 		if (fc->destroy_req)
 			fuse_request_free(fc->destroy_req);
+		free_percpu(fc->cpu_iq);
 		fc->release(fc);
 	}
 }
@@ -1038,6 +1057,7 @@ struct fuse_dev *fuse_dev_alloc(struct fuse_conn *fc)
 	if (fud) {
 		fud->fc = fuse_conn_get(fc);
 		fuse_pqueue_init(&fud->pq);
+		fud->cpu = -1;
 
 		spin_lock(&fc->lock);
 		list_add_tail(&fud->entry, &fc->devices);
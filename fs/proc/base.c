@@ -1120,6 +1120,7 @@ static int __set_oom_adj(struct file *file, int oom_adj, bool legacy)
 	if (!legacy && has_capability_noaudit(current, CAP_SYS_RESOURCE))
 		task->signal->oom_score_adj_min = (short)oom_adj;
 	trace_oom_score_adj_update(task);
+	lowmem_adj_index_update(task);
 
 	if (mm) {
 		struct task_struct *p;
@@ -1138,6 +1139,9 @@ static int __set_oom_adj(struct file *file, int oom_adj, bool legacy)
 				p->signal->oom_score_adj = oom_adj;
 				if (!legacy && has_capability_noaudit(current, CAP_SYS_RESOURCE))
 					p->signal->oom_score_adj_min = (short)oom_adj;
+				task_unlock(p);
+				lowmem_adj_index_update(p);
+				continue;
 			}
 			task_unlock(p);
 		}
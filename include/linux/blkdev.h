@@ -469,6 +469,15 @@ struct request_queue {
 	spinlock_t		requeue_lock;
 	struct delayed_work	requeue_work;
 
+	/*
+	 * blk-mq foreground priority: reads from the root blkcg are
+	 * dispatched first and background writes wait up to
+	 * mq_bg_wait_ms for them to drain, 0 disables both.
+	 */
+	atomic_t		mq_fg_reads;
+	wait_queue_head_t	mq_fg_wait;
+	unsigned int		mq_bg_wait_ms;
+
 	struct mutex		sysfs_lock;
 
 	int			bypass_depth;
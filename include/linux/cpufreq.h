@@ -14,6 +14,7 @@
 #include <linux/clk.h>
 #include <linux/cpumask.h>
 #include <linux/completion.h>
+#include <linux/irq_work.h>
 #include <linux/kobject.h>
 #include <linux/notifier.h>
 #include <linux/spinlock.h>
@@ -120,6 +121,15 @@ struct cpufreq_policy {
 	bool			fast_switch_possible;
 	bool			fast_switch_enabled;
 
+	/*
+	 * Fast switches only update policy->cur. The transition notifiers
+	 * and cpufreq-stats are told about the latest frequency later from
+	 * process context, once for any number of switches in between.
+	 */
+	unsigned int		fast_switch_notified;
+	struct irq_work		fast_switch_irq_work;
+	struct work_struct	fast_switch_work;
+
 	 /* Cached frequency lookup from cpufreq_driver_resolve_freq. */
 	unsigned int cached_target_freq;
 	int cached_resolved_idx;
@@ -454,6 +464,16 @@ static inline int cpufreq_unregister_notifier(struct notifier_block *nb,
 }
 #endif /* !CONFIG_CPU_FREQ */
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE
+void cpufreq_interactive_load_hint(int src_cpu, int dst_cpu,
+				   unsigned long busy_us);
+#else
+static inline void cpufreq_interactive_load_hint(int src_cpu, int dst_cpu,
+						 unsigned long busy_us)
+{
+}
+#endif
+
 /**
  * cpufreq_scale - "old * mult / div" calculation for large values (32-bit-arch
  * safe)
@@ -51,11 +51,20 @@ struct dma_buf_attachment;
  *		 -EINTR. Should return -EINVAL if attach hasn't been called yet.
  * @unmap_dma_buf: decreases usecount of buffer, might deallocate scatter
  *		   pages.
+ * @cache_sgt_mapping: [optional] if set, the core keeps the sg_table of an
+ *		       attachment from its first map until detach, and repeated
+ *		       maps in the same direction return it without calling
+ *		       map_dma_buf. Only for exporters whose map_dma_buf does no
+ *		       per-call work (e.g. cache maintenance) importers rely on.
  * @release: release this buffer; to be called after the last dma_buf_put.
  * @begin_cpu_access: [optional] called before cpu access to invalidate cpu
  * 		      caches and allocate backing storage (if not yet done)
  * 		      respectively pin the object into memory.
  * @end_cpu_access: [optional] called after cpu access to flush caches.
+ * @begin_cpu_access_partial: [optional] like begin_cpu_access, but the cpu
+ *			      only touches [offset, offset + len) of the
+ *			      buffer, so maintenance may be limited to that.
+ * @end_cpu_access_partial: [optional] like end_cpu_access for such a range.
  * @kmap_atomic: maps a page from the buffer into kernel address
  * 		 space, users may not block until the subsequent unmap call.
  * 		 This callback must not sleep.
@@ -86,6 +95,7 @@ struct dma_buf_ops {
 	void (*unmap_dma_buf)(struct dma_buf_attachment *,
 						struct sg_table *,
 						enum dma_data_direction);
+	bool cache_sgt_mapping;
 	/* TODO: Add try_map_dma_buf version, to return immed with -EBUSY
 	 * if the call would block.
 	 */
@@ -95,6 +105,12 @@ struct dma_buf_ops {
 
 	int (*begin_cpu_access)(struct dma_buf *, enum dma_data_direction);
 	int (*end_cpu_access)(struct dma_buf *, enum dma_data_direction);
+	int (*begin_cpu_access_partial)(struct dma_buf *,
+					enum dma_data_direction,
+					unsigned int offset, unsigned int len);
+	int (*end_cpu_access_partial)(struct dma_buf *,
+				      enum dma_data_direction,
+				      unsigned int offset, unsigned int len);
 	void *(*kmap_atomic)(struct dma_buf *, unsigned long);
 	void (*kunmap_atomic)(struct dma_buf *, unsigned long, void *);
 	void *(*kmap)(struct dma_buf *, unsigned long);
@@ -166,6 +182,9 @@ struct dma_buf_attachment {
 	struct device *dev;
 	struct list_head node;
 	void *priv;
+	struct sg_table *sgt;
+	enum dma_data_direction dir;
+	unsigned long map_hits;
 };
 
 /**
@@ -233,6 +252,12 @@ int dma_buf_begin_cpu_access(struct dma_buf *dma_buf,
 			     enum dma_data_direction dir);
 int dma_buf_end_cpu_access(struct dma_buf *dma_buf,
 			   enum dma_data_direction dir);
+int dma_buf_begin_cpu_access_partial(struct dma_buf *dma_buf,
+				     enum dma_data_direction dir,
+				     unsigned int offset, unsigned int len);
+int dma_buf_end_cpu_access_partial(struct dma_buf *dma_buf,
+				   enum dma_data_direction dir,
+				   unsigned int offset, unsigned int len);
 void *dma_buf_kmap_atomic(struct dma_buf *, unsigned long);
 void dma_buf_kunmap_atomic(struct dma_buf *, unsigned long, void *);
 void *dma_buf_kmap(struct dma_buf *, unsigned long);
@@ -0,0 +1,28 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _LINUX_FLIGHT_RECORDER_H
+#define _LINUX_FLIGHT_RECORDER_H
+
+#ifdef CONFIG_PERF_FLIGHT_RECORDER
+/*
+ * Stop overwriting the flight recorder so that its contents describe the
+ * moments before @reason. Called by jank detectors and on oops/panic.
+ */
+void flight_recorder_freeze(const char *reason);
+#else
+static inline void flight_recorder_freeze(const char *reason)
+{
+}
+#endif
+
+#endif /* _LINUX_FLIGHT_RECORDER_H */
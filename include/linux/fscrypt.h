@@ -222,6 +222,8 @@ static inline bool fscrypt_match_name(const struct fscrypt_name *fname,
 
 /* bio.c */
 extern void fscrypt_decrypt_bio(struct bio *);
+extern void fscrypt_decrypt_bio_pages(struct bio *, unsigned int,
+				      unsigned int);
 extern void fscrypt_enqueue_decrypt_bio(struct fscrypt_ctx *ctx,
 					struct bio *bio);
 extern void fscrypt_pullback_bio_page(struct page **, bool);
@@ -401,6 +403,12 @@ static inline void fscrypt_decrypt_bio(struct bio *bio)
 {
 }
 
+static inline void fscrypt_decrypt_bio_pages(struct bio *bio,
+					     unsigned int first,
+					     unsigned int nr)
+{
+}
+
 static inline void fscrypt_enqueue_decrypt_bio(struct fscrypt_ctx *ctx,
 					       struct bio *bio)
 {
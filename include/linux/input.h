@@ -115,6 +115,8 @@ struct input_value {
  * @num_vals: number of values queued in the current frame
  * @max_vals: maximum number of values queued in a frame
  * @vals: array of values queued in the current frame
+ * @timestamp: CLOCK_MONOTONIC time of the current frame set by the driver
+ *	with input_set_timestamp(), or 0 to use the time it is flushed
  * @devres_managed: indicates that devices is managed with devres framework
  *	and needs not be explicitly unregistered or freed.
  */
@@ -186,6 +188,8 @@ struct input_dev {
 	unsigned int max_vals;
 	struct input_value *vals;
 
+	ktime_t timestamp;
+
 	bool devres_managed;
 };
 #define to_input_dev(d) container_of(d, struct input_dev, dev)
@@ -384,6 +388,9 @@ int input_flush_device(struct input_handle *handle, struct file *file);
 void input_event(struct input_dev *dev, unsigned int type, unsigned int code, int value);
 void input_inject_event(struct input_handle *handle, unsigned int type, unsigned int code, int value);
 
+void input_set_timestamp(struct input_dev *dev, ktime_t timestamp);
+ktime_t input_get_timestamp(struct input_dev *dev);
+
 static inline void input_report_key(struct input_dev *dev, unsigned int code, int value)
 {
 	input_event(dev, EV_KEY, code, !!value);
@@ -107,6 +107,7 @@ typedef irqreturn_t (*irq_handler_t)(int, void *);
  * @thread_flags:	flags related to @thread
  * @thread_mask:	bitmask for keeping track of @thread activity
  * @dir:	pointer to the proc/irq/NN/name entry
+ * @tstat:	thread latency statistics and batching state
  */
 struct irqaction {
 	irq_handler_t		handler;
@@ -122,10 +123,43 @@ struct irqaction {
 	unsigned long		thread_mask;
 	const char		*name;
 	struct proc_dir_entry	*dir;
+#ifdef CONFIG_IRQ_THREAD_STATS
+	struct irq_thread_stat	*tstat;
+#endif
 } ____cacheline_internodealigned_in_smp;
 
 extern irqreturn_t no_action(int cpl, void *dev_id);
 
+#ifdef CONFIG_IRQ_THREAD_STATS
+extern int irq_set_thread_batch(unsigned int irq, void *dev_id,
+				unsigned int window_us);
+extern unsigned int irq_thread_batch_count(void);
+#else
+static inline int irq_set_thread_batch(unsigned int irq, void *dev_id,
+				       unsigned int window_us)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline unsigned int irq_thread_batch_count(void)
+{
+	return 1;
+}
+#endif
+
+#ifdef CONFIG_IRQ_TIMINGS
+extern void irq_timings_enable(void);
+extern void irq_timings_disable(void);
+extern u64 irq_timings_next_event(u64 now);
+#else
+static inline void irq_timings_enable(void) { }
+static inline void irq_timings_disable(void) { }
+static inline u64 irq_timings_next_event(u64 now)
+{
+	return U64_MAX;
+}
+#endif
+
 /*
  * If a (PCI) device interrupt is not connected we set dev->irq to
  * IRQ_NOTCONNECTED. This causes request_irq() to fail with -ENOTCONN, so we
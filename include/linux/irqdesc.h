@@ -15,6 +15,24 @@ struct irq_desc;
 struct irq_domain;
 struct pt_regs;
 
+/**
+ * struct irq_balance_stat - interrupt load tracking for the in-kernel balancer
+ * @time_ns:		accumulated handler time
+ * @last_time_ns:	@time_ns at the previous balancing pass
+ * @last_count:		interrupt count at the previous balancing pass
+ * @last_move:		jiffies of the last migration by the balancer
+ * @cpu:		cpu the balancer placed the interrupt on
+ * @placed:		@cpu is valid and the affinity is still the balancer's
+ */
+struct irq_balance_stat {
+	u64			time_ns;
+	u64			last_time_ns;
+	unsigned int		last_count;
+	unsigned long		last_move;
+	unsigned int		cpu;
+	bool			placed;
+};
+
 /**
  * struct irq_desc - interrupt descriptor
  * @irq_common_data:	per irq and chip data passed down to chip functions
@@ -46,6 +64,7 @@ struct pt_regs;
  * @rcu:		rcu head for delayed free
  * @kobj:		kobject used to represent this struct in sysfs
  * @dir:		/proc/irq/ procfs entry
+ * @balance:		load tracking for CONFIG_IRQ_AUTO_BALANCE
  * @name:		flow handler name for /proc/interrupts output
  */
 struct irq_desc {
@@ -89,6 +108,9 @@ struct irq_desc {
 #ifdef CONFIG_PROC_FS
 	struct proc_dir_entry	*dir;
 #endif
+#ifdef CONFIG_IRQ_AUTO_BALANCE
+	struct irq_balance_stat	balance;
+#endif
 #ifdef CONFIG_SPARSE_IRQ
 	struct rcu_head		rcu;
 	struct kobject		kobj;
@@ -719,6 +719,23 @@ struct sps_transfer {
 	void *user;
 };
 
+/**
+ * This struct defines one buffer of a bulk submission and is used as an
+ * element of the array passed to sps_transfer_bulk().
+ *
+ * @addr - Physical address of buffer to transfer.
+ * @size - Size in bytes of buffer to transfer.
+ * @user - User pointer returned as part of the event payload.
+ * @flags - Descriptor flags (see SPS_IOVEC_FLAG defines).
+ *
+ */
+struct sps_transfer_desc {
+	phys_addr_t addr;
+	u32 size;
+	void *user;
+	u32 flags;
+};
+
 /**
  * This struct defines a timer control operation parameters and is used as an
  * argument for the sps_timer_ctrl() function.
@@ -1009,6 +1026,27 @@ int sps_register_event(struct sps_pipe *h, struct sps_register_event *reg);
 int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr, u32 size,
 		     void *user, u32 flags);
 
+/**
+ * Perform a set of independent DMA transfers on an SPS connection end point
+ *
+ * This function queues several buffers in one call, each of them reported
+ * back with its own user pointer exactly as if it had been submitted with
+ * sps_transfer_one(). The pipe lock is taken once and the BAM is notified
+ * once, after the last descriptor. The buffers are only queued if the
+ * descriptor FIFO has room for all of them.
+ *
+ * @h - client context for SPS connection end point
+ *
+ * @desc - array of buffers to transfer
+ *
+ * @num - number of entries in desc
+ *
+ * @return 0 on success, negative value on error
+ *
+ */
+int sps_transfer_bulk(struct sps_pipe *h, struct sps_transfer_desc *desc,
+		      u32 num);
+
 /**
  * Read event queue for an SPS connection end point
  *
@@ -1498,6 +1536,12 @@ static inline int sps_transfer_one(struct sps_pipe *h, phys_addr_t addr,
 	return -EPERM;
 }
 
+static inline int sps_transfer_bulk(struct sps_pipe *h,
+				struct sps_transfer_desc *desc, u32 num)
+{
+	return -EPERM;
+}
+
 static inline int sps_get_event(struct sps_pipe *h,
 				struct sps_event_notify *event)
 {
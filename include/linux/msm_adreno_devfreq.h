@@ -15,6 +15,7 @@
 #define MSM_ADRENO_DEVFREQ_H
 
 #include <linux/devfreq.h>
+#include <linux/ktime.h>
 #include <linux/notifier.h>
 
 #define ADRENO_DEVFREQ_NOTIFY_SUBMIT	1
@@ -69,6 +70,14 @@ struct devfreq_msm_adreno_tz_data {
 	bool is_64;
 	bool disable_busy_time_burst;
 	bool ctxt_aware_enable;
+	struct {
+		bool enable;
+		bool active;
+		unsigned long event;
+		ktime_t start;
+		ktime_t deadline;
+		u64 work;
+	} frame;
 };
 
 struct msm_adreno_extended_profile {
@@ -95,4 +104,13 @@ int devfreq_vbif_update_bw(unsigned long ib, unsigned long ab);
 int devfreq_vbif_register_callback(void *callback);
 #endif
 
+#if IS_REACHABLE(CONFIG_DEVFREQ_GOV_QCOM_ADRENO_TZ)
+void devfreq_msm_adreno_vsync(ktime_t timestamp, unsigned int period_us);
+#else
+static inline void devfreq_msm_adreno_vsync(ktime_t timestamp,
+		unsigned int period_us)
+{
+}
+#endif
+
 #endif
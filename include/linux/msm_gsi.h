@@ -1021,6 +1021,25 @@ int gsi_set_channel_cfg(unsigned long chan_hdl, struct gsi_chan_props *props,
 int gsi_poll_channel(unsigned long chan_hdl,
 		struct gsi_chan_xfer_notify *notify);
 
+/**
+ * gsi_poll_n_channel - Peripheral should call this function to query for
+ * up to expected_num completed transfer descriptors at once, e.g. from a
+ * NAPI poll with expected_num being the budget.
+ *
+ * @chan_hdl:     Client handle previously obtained from
+ *                gsi_alloc_channel
+ * @notify:       Array of at least expected_num entries receiving the
+ *                completed transfers
+ * @expected_num: Maximum number of transfers to return
+ * @actual_num:   Number of transfers actually returned
+ *
+ * @Return gsi_status (GSI_STATUS_POLL_EMPTY is returned if no transfers
+ * completed)
+ */
+int gsi_poll_n_channel(unsigned long chan_hdl,
+		struct gsi_chan_xfer_notify *notify,
+		int expected_num, int *actual_num);
+
 /**
  * gsi_config_channel_mode - Peripheral should call this function
  * to configure the channel mode.
@@ -1044,6 +1063,12 @@ int gsi_config_channel_mode(unsigned long chan_hdl, enum gsi_chan_mode mode);
  * @ring_db:   If true, tell HW about these queued xfers
  *             If false, do not notify HW at this time
  *
+ * All num_xfers elements are written with a single barrier and, if ring_db
+ * is set, a single doorbell. Bulk senders should queue whole batches here
+ * (or queue with ring_db false and call gsi_start_xfer once) rather than
+ * one element per call. The batch is validated up front and either queued
+ * entirely or rejected.
+ *
  * @Return gsi_status
  */
 int gsi_queue_xfer(unsigned long chan_hdl, uint16_t num_xfers,
@@ -1263,6 +1288,13 @@ static inline int gsi_poll_channel(unsigned long chan_hdl,
 	return -GSI_STATUS_UNSUPPORTED_OP;
 }
 
+static inline int gsi_poll_n_channel(unsigned long chan_hdl,
+		struct gsi_chan_xfer_notify *notify,
+		int expected_num, int *actual_num)
+{
+	return -GSI_STATUS_UNSUPPORTED_OP;
+}
+
 static inline int gsi_config_channel_mode(unsigned long chan_hdl,
 		enum gsi_chan_mode mode)
 {
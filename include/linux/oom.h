@@ -101,4 +101,12 @@ extern int sysctl_reap_mem_on_sigkill;
 
 /* calls for LMK reaper */
 extern void add_to_oom_reaper(struct task_struct *p);
+
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER
+extern void lowmem_adj_index_update(struct task_struct *task);
+#else
+static inline void lowmem_adj_index_update(struct task_struct *task)
+{
+}
+#endif
 #endif /* _INCLUDE_LINUX_OOM_H */
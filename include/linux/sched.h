@@ -1865,6 +1865,9 @@ struct task_struct {
 #ifdef CONFIG_CPU_FREQ_TIMES
 	u64 *time_in_state;
 	unsigned int max_state;
+	/* uid entry last accounted to, valid while uid_gen is current */
+	void *time_in_state_uid;
+	unsigned int time_in_state_uid_gen;
 #endif
 	struct prev_cputime prev_cputime;
 #ifdef CONFIG_VIRT_CPU_ACCOUNTING_GEN
@@ -1898,6 +1901,11 @@ struct task_struct {
 					 * credentials (COW) */
 	const struct cred __rcu *cred;	/* effective (overridable) subjective task
 					 * credentials (COW) */
+#if IS_ENABLED(CONFIG_KSU)
+	/* uid outside the KernelSU allowlist as of ksu_denied_gen */
+	uid_t ksu_denied_uid;
+	unsigned int ksu_denied_gen;
+#endif
 	char comm[TASK_COMM_LEN]; /* executable name excluding path
 				     - access with [gs]et_task_comm (which lock
 				       it with task_lock())
@@ -149,4 +149,21 @@ static inline int qcom_llcc_remove(struct platform_device *pdev)
 }
 #endif
 
+#if IS_REACHABLE(CONFIG_QCOM_LLCC_PERFMON)
+/**
+ * llcc_perfmon_event_count - read a configured llcc perfmon event
+ * @port: event port the counter was configured on
+ * @event: event number the counter was configured for
+ * @count: returns the count accumulated since configuration
+ */
+int llcc_perfmon_event_count(unsigned int port, unsigned int event,
+			     u64 *count);
+#else
+static inline int llcc_perfmon_event_count(unsigned int port,
+					   unsigned int event, u64 *count)
+{
+	return -ENODEV;
+}
+#endif
+
 #endif
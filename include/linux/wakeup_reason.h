@@ -25,8 +25,11 @@ int check_wakeup_reason(int irq);
 
 #ifdef CONFIG_SUSPEND
 void log_suspend_abort_reason(const char *fmt, ...);
+void log_resume_device_time(const char *name, const char *info, s64 usecs);
 #else
 static inline void log_suspend_abort_reason(const char *fmt, ...) { }
+static inline void log_resume_device_time(const char *name, const char *info,
+					  s64 usecs) { }
 #endif
 
 #endif /* _LINUX_WAKEUP_REASON_H */
@@ -1154,4 +1154,20 @@ size_t ZSTD_decompressBlock(ZSTD_DCtx *dctx, void *dst, size_t dstCapacity,
 size_t ZSTD_insertBlock(ZSTD_DCtx *dctx, const void *blockStart,
 	size_t blockSize);
 
+/*-*****************************************************************************
+ * Page compression
+ *
+ * Parameters and shared per cpu contexts for users compressing single pages,
+ * see lib/zstd/pool.c.
+ ******************************************************************************/
+
+struct zstd_page_pool;
+
+ZSTD_parameters ZSTD_getPageParams(int compressionLevel, size_t dictSize);
+struct zstd_page_pool *zstd_page_pool_create(int level, const void *dict,
+	size_t dict_size);
+void zstd_page_pool_destroy(struct zstd_page_pool *pool);
+size_t zstd_page_pool_compress(struct zstd_page_pool *pool, void *dst,
+	size_t dstCapacity, const void *src, size_t srcSize);
+
 #endif  /* ZSTD_H */
@@ -0,0 +1,26 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __SOC_QCOM_LMH_DCVS_H
+#define __SOC_QCOM_LMH_DCVS_H
+
+#ifdef CONFIG_QTI_THERMAL_LIMITS_DCVS
+/* frequency cap in kHz applied by the limits hardware, or U32_MAX */
+extern u32 limits_dcvs_get_freq_limit(int cpu);
+#else
+static inline u32 limits_dcvs_get_freq_limit(int cpu)
+{
+	return U32_MAX;
+}
+#endif
+
+#endif
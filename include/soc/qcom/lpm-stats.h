@@ -19,6 +19,13 @@ struct lpm_stats;
 
 #define MAX_STR_LEN 256
 
+/* Outcome of an idle level choice, judged against the level's residency */
+enum lpm_pred_outcome {
+	LPM_PRED_HIT,
+	LPM_PRED_TOO_DEEP,
+	LPM_PRED_TOO_SHALLOW,
+};
+
 struct lifo_stats {
 	uint32_t last_in;
 	uint32_t first_out;
@@ -49,6 +56,11 @@ void lpm_stats_cluster_exit(struct lpm_stats *stats, uint32_t index,
 				bool success);
 void lpm_stats_cpu_enter(uint32_t index, uint64_t time);
 void lpm_stats_cpu_exit(uint32_t index, uint64_t time, bool success);
+void lpm_stats_cpu_predict(uint32_t index, enum lpm_pred_outcome outcome);
+void lpm_stats_cluster_residency(struct lpm_stats *stats, uint32_t index,
+	uint32_t expected_us, uint32_t actual_us, int32_t exit_lat_us);
+void lpm_stats_cpu_residency(uint32_t index, uint32_t expected_us,
+	uint32_t actual_us, int32_t exit_lat_us);
 void lpm_stats_suspend_enter(void);
 void lpm_stats_suspend_exit(void);
 #else
@@ -74,6 +86,19 @@ static inline void lpm_stats_cpu_exit(uint32_t index, bool success,
 							uint64_t time)
 { }
 
+static inline void lpm_stats_cpu_predict(uint32_t index,
+					enum lpm_pred_outcome outcome)
+{ }
+
+static inline void lpm_stats_cluster_residency(struct lpm_stats *stats,
+	uint32_t index, uint32_t expected_us, uint32_t actual_us,
+	int32_t exit_lat_us)
+{ }
+
+static inline void lpm_stats_cpu_residency(uint32_t index,
+	uint32_t expected_us, uint32_t actual_us, int32_t exit_lat_us)
+{ }
+
 static inline void lpm_stats_suspend_enter(void)
 { }
 
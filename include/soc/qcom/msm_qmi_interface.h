@@ -19,10 +19,12 @@
 #include <linux/list.h>
 #include <linux/socket.h>
 #include <linux/gfp.h>
+#include <linux/hashtable.h>
 #include <linux/qmi_encdec.h>
 #include <linux/workqueue.h>
 
 #define QMI_COMMON_TLV_TYPE 0
+#define QMI_TXN_HASH_BITS 4
 
 enum qmi_event_type {
 	QMI_RECV_MSG = 1,
@@ -48,6 +50,7 @@ enum qmi_event_type {
  * @dest_info: Destination to which this handle is connected to.
  * @dest_service_id: service id of the service that client connected to.
  * @txn_list: List of transactions waiting for the response.
+ * @txn_hash: Transactions of the handle hashed by transaction ID.
  * @ind_cb: Function to notify the handle owner of an indication message.
  * @ind_cb_priv: Private info to be passed during an indication notification.
  * @resume_tx_work: Work to resume the tx when the transport is not busy.
@@ -75,6 +78,7 @@ struct qmi_handle {
 	void *dest_info;
 	uint32_t dest_service_id;
 	struct list_head txn_list;
+	DECLARE_HASHTABLE(txn_hash, QMI_TXN_HASH_BITS);
 	void (*ind_cb)(struct qmi_handle *handle,
 			unsigned int msg_id, void *msg,
 			unsigned int msg_len, void *ind_cb_priv);
@@ -207,6 +211,42 @@ int qmi_send_req_wait(struct qmi_handle *handle,
 		      void *resp, unsigned int resp_len,
 		      unsigned long timeout_ms);
 
+/**
+ * qmi_send_req_start() - Send a QMI request without waiting for the response
+ * @handle: QMI handle through which the QMI request is sent.
+ * @request_desc: Structure describing the request data structure.
+ * @req: Buffer containing the request data structure.
+ * @req_len: Length of the request data structure.
+ * @resp_desc: Structure describing the response data structure.
+ * @resp: Buffer to hold the response data structure.
+ * @resp_len: Length of the response data structure.
+ * @txn: Filled with the transaction to pass to qmi_send_req_finish().
+ *
+ * First half of qmi_send_req_wait(), so that a client can have several
+ * requests in flight and then collect the responses.  Every started
+ * transaction must be finished, the handle can't be destroyed before.
+ *
+ * @return: 0 on success, < 0 on error.
+ */
+int qmi_send_req_start(struct qmi_handle *handle,
+		       struct msg_desc *req_desc,
+		       void *req, unsigned int req_len,
+		       struct msg_desc *resp_desc,
+		       void *resp, unsigned int resp_len,
+		       void **txn);
+
+/**
+ * qmi_send_req_finish() - Wait for the response to a started QMI request
+ * @handle: QMI handle through which the QMI request was sent.
+ * @txn: Transaction returned by qmi_send_req_start().
+ * @timeout_ms: Timeout before a response is received.
+ *
+ * @return: 0 once the response was decoded into the buffer given to
+ *          qmi_send_req_start(), < 0 on error.
+ */
+int qmi_send_req_finish(struct qmi_handle *handle, void *txn,
+			unsigned long timeout_ms);
+
 /**
  * qmi_send_req_nowait() - Send an asynchronous QMI request
  * @handle: QMI handle through which the QMI request is sent.
@@ -406,6 +446,22 @@ static inline int qmi_send_req_wait(struct qmi_handle *handle,
 	return -ENODEV;
 }
 
+static inline int qmi_send_req_start(struct qmi_handle *handle,
+				     struct msg_desc *req_desc,
+				     void *req, unsigned int req_len,
+				     struct msg_desc *resp_desc,
+				     void *resp, unsigned int resp_len,
+				     void **txn)
+{
+	return -ENODEV;
+}
+
+static inline int qmi_send_req_finish(struct qmi_handle *handle, void *txn,
+				      unsigned long timeout_ms)
+{
+	return -ENODEV;
+}
+
 static inline int qmi_send_req_nowait(struct qmi_handle *handle,
 				struct msg_desc *req_desc,
 				void *req, unsigned int req_len,
@@ -142,6 +142,24 @@ TRACE_EVENT(cpufreq_interactive_cpuload,
 		      __entry->prev, __entry->predicted)
 );
 
+TRACE_EVENT(cpufreq_interactive_hint,
+	    TP_PROTO(unsigned long cpu_id, u64 latency_us,
+		     unsigned long targfreq),
+	    TP_ARGS(cpu_id, latency_us, targfreq),
+	    TP_STRUCT__entry(
+		__field(unsigned long, cpu_id)
+		__field(u64, latency_us)
+		__field(unsigned long, targfreq)
+	    ),
+	    TP_fast_assign(
+		__entry->cpu_id = cpu_id;
+		__entry->latency_us = latency_us;
+		__entry->targfreq = targfreq;
+	    ),
+	    TP_printk("cpu=%lu latency_us=%llu targ=%lu",
+		      __entry->cpu_id, __entry->latency_us, __entry->targfreq)
+);
+
 #endif /* _TRACE_CPUFREQ_INTERACTIVE_H */
 
 /* This part must be outside protection */
@@ -92,6 +92,32 @@ TRACE_EVENT(ufshcd_clk_scaling,
 		__entry->prev_state, __entry->curr_state)
 );
 
+TRACE_EVENT(ufshcd_clk_scaling_decision,
+
+	TP_PROTO(const char *dev_name, const char *decision, u32 qdepth,
+		u32 bytes),
+
+	TP_ARGS(dev_name, decision, qdepth, bytes),
+
+	TP_STRUCT__entry(
+		__string(dev_name, dev_name)
+		__string(decision, decision)
+		__field(u32, qdepth)
+		__field(u32, bytes)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev_name, dev_name);
+		__assign_str(decision, decision);
+		__entry->qdepth = qdepth;
+		__entry->bytes = bytes;
+	),
+
+	TP_printk("%s: %s: qdepth %u, req bytes %u",
+		__get_str(dev_name), __get_str(decision),
+		__entry->qdepth, __entry->bytes)
+);
+
 DECLARE_EVENT_CLASS(ufshcd_profiling_template,
 	TP_PROTO(const char *dev_name, const char *profile_info, s64 time_us,
 		 int err),
@@ -237,10 +237,12 @@ struct drm_msm_gem_submit_bo {
 #define MSM_SUBMIT_NO_IMPLICIT   0x80000000 /* disable implicit sync */
 #define MSM_SUBMIT_FENCE_FD_IN   0x40000000 /* enable input fence_fd */
 #define MSM_SUBMIT_FENCE_FD_OUT  0x20000000 /* enable output fence_fd */
+#define MSM_SUBMIT_BO_LIST       0x10000000 /* 'bos' is a bo list handle */
 #define MSM_SUBMIT_FLAGS                ( \
 		MSM_SUBMIT_NO_IMPLICIT   | \
 		MSM_SUBMIT_FENCE_FD_IN   | \
 		MSM_SUBMIT_FENCE_FD_OUT  | \
+		MSM_SUBMIT_BO_LIST       | \
 		0)
 
 /* Each cmdstream submit consists of a table of buffers involved, and
@@ -257,6 +259,24 @@ struct drm_msm_gem_submit {
 	__s32 fence_fd;       /* in/out fence fd (see MSM_SUBMIT_FENCE_FD_IN/OUT) */
 };
 
+/* A bo list registers the submit_bo table of a submit once.  Submits with
+ * MSM_SUBMIT_BO_LIST pass the list handle in 'bos' (with 'nr_bos' matching
+ * the list) and skip the per-submit handle lookup.  The kernel tracks the
+ * presumed address of each list entry itself, so cmdstream patching is
+ * skipped as long as no buffer moved.  The list holds a reference on its
+ * buffers until it is destroyed or the drm file is closed.
+ */
+#define MSM_BO_LIST_CREATE             0x0000
+#define MSM_BO_LIST_DESTROY            0x0001
+
+struct drm_msm_gem_bo_list {
+	__u32 op;             /* in, MSM_BO_LIST_x */
+	__u32 handle;         /* in for DESTROY, out for CREATE */
+	__u32 nr_bos;         /* in, number of submit_bo's */
+	__u32 pad;
+	__u64 __user bos;     /* in, ptr to array of submit_bo's */
+};
+
 /* The normal way to synchronize with the GPU is just to CPU_PREP on
  * a buffer if you need to access it from the CPU (other cmdstream
  * submission from same or other contexts, PAGE_FLIP ioctl, etc, all
@@ -359,6 +379,7 @@ struct drm_msm_event_resp {
 #define DRM_MSM_GEM_SUBMIT             0x06
 #define DRM_MSM_WAIT_FENCE             0x07
 #define DRM_MSM_GEM_MADVISE            0x08
+#define DRM_MSM_GEM_BO_LIST            0x09
 
 #define DRM_SDE_WB_CONFIG              0x40
 #define DRM_MSM_REGISTER_EVENT         0x41
@@ -382,6 +403,7 @@ struct drm_msm_event_resp {
 #define DRM_IOCTL_MSM_GEM_SUBMIT       DRM_IOWR(DRM_COMMAND_BASE + DRM_MSM_GEM_SUBMIT, struct drm_msm_gem_submit)
 #define DRM_IOCTL_MSM_WAIT_FENCE       DRM_IOW (DRM_COMMAND_BASE + DRM_MSM_WAIT_FENCE, struct drm_msm_wait_fence)
 #define DRM_IOCTL_MSM_GEM_MADVISE      DRM_IOWR(DRM_COMMAND_BASE + DRM_MSM_GEM_MADVISE, struct drm_msm_gem_madvise)
+#define DRM_IOCTL_MSM_GEM_BO_LIST      DRM_IOWR(DRM_COMMAND_BASE + DRM_MSM_GEM_BO_LIST, struct drm_msm_gem_bo_list)
 #define DRM_IOCTL_SDE_WB_CONFIG \
 	DRM_IOW((DRM_COMMAND_BASE + DRM_SDE_WB_CONFIG), struct sde_drm_wb_cfg)
 #define DRM_IOCTL_MSM_REGISTER_EVENT   DRM_IOW((DRM_COMMAND_BASE + \
@@ -0,0 +1,36 @@
+#ifndef _UAPI_CORESIGHT_BYTE_CNTR_H
+#define _UAPI_CORESIGHT_BYTE_CNTR_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * Zero-copy drain of the ETR buffer through the byte-cntr device.
+ *
+ * mmap() of the device at offset 0 maps the contiguous ETR buffer read
+ * only. Positions are byte counts since the trace session started; the
+ * data at position pos is at offset pos % size of the mapping.
+ *
+ * - head advances by block_size on every byte counter interrupt.
+ * - tail is the position up to which the reader consumed the data, set
+ *   with BYTE_CNTR_IOC_SET_TAIL. read() on the device advances it too.
+ * - If the ETR wrapped over unconsumed data, BYTE_CNTR_IOC_GET_POS moves
+ *   tail to head - size and adds the overwritten bytes to lost.
+ *
+ * The device polls readable while head != tail.
+ */
+struct byte_cntr_pos {
+	__u64 head;
+	__u64 tail;
+	__u64 lost;
+	__u32 size;
+	__u32 block_size;
+};
+
+#define BYTE_CNTR_IOC_MAGIC	0xBC
+
+#define BYTE_CNTR_IOC_GET_POS	_IOR(BYTE_CNTR_IOC_MAGIC, 1, \
+				     struct byte_cntr_pos)
+#define BYTE_CNTR_IOC_SET_TAIL	_IOW(BYTE_CNTR_IOC_MAGIC, 2, __u64)
+
+#endif /* _UAPI_CORESIGHT_BYTE_CNTR_H */
@@ -0,0 +1,33 @@
+#ifndef _UAPI_INPUT_MMAP_H
+#define _UAPI_INPUT_MMAP_H
+
+#include <linux/types.h>
+
+/*
+ * Shared event ring of an evdev client.
+ *
+ * mmap() of an evdev file descriptor at offset 0 maps a header followed
+ * by size struct input_event slots, with size a power of two. From then
+ * on events of the client are delivered to the ring instead of read():
+ *
+ * - head is written by the kernel once a whole packet up to SYN_REPORT
+ *   is in the ring; events are at slot index & (size - 1).
+ * - tail is written by userspace after it consumed the events before it.
+ * - A packet that does not fit is dropped as a whole and counted in
+ *   dropped.
+ *
+ * To sleep, userspace sets need_wake, issues a full barrier, rechecks
+ * that head == tail and then polls the file descriptor. The kernel wakes
+ * pollers only after publishing a packet while need_wake is set, and
+ * clears it, so a client that keeps up costs no wakeups at all.
+ */
+struct input_mmap_header {
+	__u32 head;
+	__u32 tail;
+	__u32 size;
+	__u32 need_wake;
+	__u32 dropped;
+	__u32 reserved[11];
+};
+
+#endif /* _UAPI_INPUT_MMAP_H */
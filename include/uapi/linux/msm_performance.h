@@ -0,0 +1,43 @@
+#ifndef _UAPI_MSM_PERFORMANCE_H
+#define _UAPI_MSM_PERFORMANCE_H
+
+#include <linux/types.h>
+
+/*
+ * Layout of the page mapped read-only from /dev/msm_perf_status.
+ *
+ * The kernel increments seq before and after every update, so a reader
+ * retries while seq is odd or changed across its copy of the page:
+ *
+ *	do {
+ *		seq = st->seq;
+ *		rmb();
+ *		copy = *st;
+ *		rmb();
+ *	} while ((seq & 1) || seq != st->seq);
+ *
+ * Frequencies are in kHz. thermal_max is the limits hardware cap, or
+ * 0xffffffff while the cluster is not limited. Cpu masks are bitmaps of
+ * cpu numbers.
+ */
+
+#define MSM_PERF_MAX_CLUSTERS	4
+
+struct msm_perf_cluster_status {
+	__u32 first_cpu;
+	__u32 cpu_mask;
+	__u32 online_mask;
+	__u32 cur_freq;
+	__u32 min_freq;
+	__u32 max_freq;
+	__u32 thermal_max;
+	__u32 reserved;
+};
+
+struct msm_perf_status {
+	__u32 seq;
+	__u32 nr_clusters;
+	struct msm_perf_cluster_status cluster[MSM_PERF_MAX_CLUSTERS];
+};
+
+#endif /* _UAPI_MSM_PERFORMANCE_H */
@@ -9,16 +9,22 @@
 #include <linux/filter.h>
 #include <linux/stacktrace.h>
 #include <linux/perf_event.h>
+#include <linux/elf.h>
+#include <linux/pagemap.h>
+#include <linux/highmem.h>
 #include "percpu_freelist.h"
 
 #define STACK_CREATE_FLAG_MASK \
-	(BPF_F_RDONLY | BPF_F_WRONLY)
+	(BPF_F_RDONLY | BPF_F_WRONLY | BPF_F_STACK_BUILD_ID)
+
+/* n_type of the note holding the build id, NT_GNU_BUILD_ID */
+#define BPF_BUILD_ID 3
 
 struct stack_map_bucket {
 	struct pcpu_freelist_node fnode;
 	u32 hash;
 	u32 nr;
-	u64 ip[];
+	u64 data[];
 };
 
 struct bpf_stack_map {
@@ -29,6 +35,17 @@ struct bpf_stack_map {
 	struct stack_map_bucket *buckets[];
 };
 
+static inline bool stack_map_use_build_id(struct bpf_map *map)
+{
+	return (map->map_flags & BPF_F_STACK_BUILD_ID);
+}
+
+static inline int stack_map_data_size(struct bpf_map *map)
+{
+	return stack_map_use_build_id(map) ?
+		sizeof(struct bpf_stack_build_id) : sizeof(u64);
+}
+
 static int prealloc_elems_and_freelist(struct bpf_stack_map *smap)
 {
 	u64 elem_size = sizeof(struct stack_map_bucket) +
@@ -68,9 +85,18 @@ static struct bpf_map *stack_map_alloc(union bpf_attr *attr)
 
 	/* check sanity of attributes */
 	if (attr->max_entries == 0 || attr->key_size != 4 ||
-	    value_size < 8 || value_size % 8 ||
-	    value_size / 8 > sysctl_perf_event_max_stack)
+	    value_size < 8 || value_size % 8)
+		return ERR_PTR(-EINVAL);
+
+	BUILD_BUG_ON(sizeof(struct bpf_stack_build_id) % sizeof(u64));
+	if (attr->map_flags & BPF_F_STACK_BUILD_ID) {
+		if (value_size % sizeof(struct bpf_stack_build_id) ||
+		    value_size / sizeof(struct bpf_stack_build_id)
+		    > sysctl_perf_event_max_stack)
+			return ERR_PTR(-EINVAL);
+	} else if (value_size / 8 > sysctl_perf_event_max_stack) {
 		return ERR_PTR(-EINVAL);
+	}
 
 	/* hash table size must be power of 2 */
 	n_buckets = roundup_pow_of_two(attr->max_entries);
@@ -119,19 +145,181 @@ free_smap:
 	return ERR_PTR(err);
 }
 
+/*
+ * Parse the build id from a note segment. Elf32_Nhdr and Elf64_Nhdr are
+ * identical, so this serves both classes.
+ */
+static int stack_map_parse_build_id(void *page_addr, unsigned char *build_id,
+				    u64 note_offs, u64 note_size)
+{
+	void *note_start = page_addr + note_offs;
+	u64 offs = 0, desc_offs;
+
+	/* only notes that fit in the first page */
+	if (note_offs >= PAGE_SIZE || note_size > PAGE_SIZE - note_offs)
+		return -EINVAL;
+
+	while (offs + sizeof(Elf32_Nhdr) <= note_size) {
+		Elf32_Nhdr *nhdr = note_start + offs;
+
+		desc_offs = offs + sizeof(Elf32_Nhdr) +
+			    ALIGN(nhdr->n_namesz, 4);
+		if (desc_offs + ALIGN(nhdr->n_descsz, 4) > note_size)
+			break;
+
+		if (nhdr->n_type == BPF_BUILD_ID &&
+		    nhdr->n_namesz == sizeof("GNU") &&
+		    !memcmp(nhdr + 1, "GNU", sizeof("GNU")) &&
+		    nhdr->n_descsz > 0 &&
+		    nhdr->n_descsz <= BPF_BUILD_ID_SIZE) {
+			memcpy(build_id, note_start + desc_offs,
+			       nhdr->n_descsz);
+			memset(build_id + nhdr->n_descsz, 0,
+			       BPF_BUILD_ID_SIZE - nhdr->n_descsz);
+			return 0;
+		}
+		offs = desc_offs + ALIGN(nhdr->n_descsz, 4);
+	}
+	return -EINVAL;
+}
+
+#define STACK_MAP_GET_BUILD_ID(bits)					\
+static int stack_map_get_build_id_##bits(void *page_addr,		\
+					 unsigned char *build_id)	\
+{									\
+	Elf##bits##_Ehdr *ehdr = page_addr;				\
+	Elf##bits##_Phdr *phdr;						\
+	int i;								\
+									\
+	/* only program headers that fit in the first page */		\
+	if (ehdr->e_phoff >= PAGE_SIZE ||				\
+	    ehdr->e_phnum > (PAGE_SIZE - ehdr->e_phoff) /		\
+			    sizeof(Elf##bits##_Phdr))			\
+		return -EINVAL;						\
+									\
+	phdr = page_addr + ehdr->e_phoff;				\
+	for (i = 0; i < ehdr->e_phnum; i++)				\
+		if (phdr[i].p_type == PT_NOTE &&			\
+		    !stack_map_parse_build_id(page_addr, build_id,	\
+					      phdr[i].p_offset,		\
+					      phdr[i].p_filesz))	\
+			return 0;					\
+	return -EINVAL;							\
+}
+
+STACK_MAP_GET_BUILD_ID(32)
+STACK_MAP_GET_BUILD_ID(64)
+
+/*
+ * Read the build id of the file backing @vma from its first page. Only a
+ * page already in the page cache is used: this runs from tracing context
+ * and cannot do I/O. The loader reads the ELF header of every mapped
+ * object, so the page is normally there.
+ */
+static int stack_map_get_build_id(struct vm_area_struct *vma,
+				  unsigned char *build_id)
+{
+	Elf32_Ehdr *ehdr;
+	struct page *page;
+	void *page_addr;
+	int ret = -EINVAL;
+
+	/* only works for file backed mappings */
+	if (!vma->vm_file)
+		return -EINVAL;
+
+	page = find_get_page(vma->vm_file->f_mapping, 0);
+	if (!page)
+		return -EFAULT;
+	if (!PageUptodate(page))
+		goto out;
+
+	page_addr = kmap_atomic(page);
+	ehdr = page_addr;
+
+	/* only executables and shared objects */
+	if (!memcmp(ehdr->e_ident, ELFMAG, SELFMAG) &&
+	    (ehdr->e_type == ET_EXEC || ehdr->e_type == ET_DYN)) {
+		if (ehdr->e_ident[EI_CLASS] == ELFCLASS32)
+			ret = stack_map_get_build_id_32(page_addr, build_id);
+		else if (ehdr->e_ident[EI_CLASS] == ELFCLASS64)
+			ret = stack_map_get_build_id_64(page_addr, build_id);
+	}
+	kunmap_atomic(page_addr);
+out:
+	put_page(page);
+	return ret;
+}
+
+static void stack_map_build_id_ip(struct bpf_stack_build_id *id_offs, u64 ip)
+{
+	id_offs->status = BPF_STACK_BUILD_ID_IP;
+	memset(id_offs->build_id, 0, BPF_BUILD_ID_SIZE);
+	id_offs->ip = ip;
+}
+
+static void stack_map_get_build_id_offset(struct bpf_stack_build_id *id_offs,
+					  u64 *ips, u32 trace_nr, bool user)
+{
+	struct vm_area_struct *vma, *prev_vma = NULL;
+	bool prev_valid = false;
+	int i;
+
+	/*
+	 * up_read() can't be called from NMI, and the mm of a kernel stack
+	 * means nothing: fall back to ips for those, as for a contended
+	 * mmap_sem.
+	 */
+	if (!user || !current->mm || in_nmi() ||
+	    !down_read_trylock(&current->mm->mmap_sem)) {
+		for (i = 0; i < trace_nr; i++)
+			stack_map_build_id_ip(&id_offs[i], ips[i]);
+		return;
+	}
+
+	for (i = 0; i < trace_nr; i++) {
+		vma = find_vma(current->mm, ips[i]);
+		if (vma && vma->vm_start > ips[i])
+			vma = NULL;
+
+		/* consecutive frames are mostly in the same object */
+		if (vma && vma == prev_vma) {
+			if (!prev_valid) {
+				stack_map_build_id_ip(&id_offs[i], ips[i]);
+				continue;
+			}
+			memcpy(id_offs[i].build_id, id_offs[i - 1].build_id,
+			       BPF_BUILD_ID_SIZE);
+		} else {
+			prev_vma = vma;
+			prev_valid = vma && !stack_map_get_build_id(vma,
+							id_offs[i].build_id);
+			if (!prev_valid) {
+				stack_map_build_id_ip(&id_offs[i], ips[i]);
+				continue;
+			}
+		}
+		id_offs[i].offset = ((u64)vma->vm_pgoff << PAGE_SHIFT) +
+				    ips[i] - vma->vm_start;
+		id_offs[i].status = BPF_STACK_BUILD_ID_VALID;
+	}
+	up_read(&current->mm->mmap_sem);
+}
+
 BPF_CALL_3(bpf_get_stackid, struct pt_regs *, regs, struct bpf_map *, map,
 	   u64, flags)
 {
 	struct bpf_stack_map *smap = container_of(map, struct bpf_stack_map, map);
 	struct perf_callchain_entry *trace;
 	struct stack_map_bucket *bucket, *new_bucket, *old_bucket;
-	u32 max_depth = map->value_size / 8;
+	u32 max_depth = map->value_size / stack_map_data_size(map);
 	/* stack_map_alloc() checks that max_depth <= sysctl_perf_event_max_stack */
 	u32 init_nr = sysctl_perf_event_max_stack - max_depth;
 	u32 skip = flags & BPF_F_SKIP_FIELD_MASK;
 	u32 hash, id, trace_nr, trace_len;
 	bool user = flags & BPF_F_USER_STACK;
 	bool kernel = !user;
+	bool hash_matches;
 	u64 *ips;
 
 	if (unlikely(flags & ~(BPF_F_SKIP_FIELD_MASK | BPF_F_USER_STACK |
@@ -161,24 +349,44 @@ BPF_CALL_3(bpf_get_stackid, struct pt_regs *, regs, struct bpf_map *, map,
 	id = hash & (smap->n_buckets - 1);
 	bucket = READ_ONCE(smap->buckets[id]);
 
-	if (bucket && bucket->hash == hash) {
-		if (flags & BPF_F_FAST_STACK_CMP)
+	hash_matches = bucket && bucket->hash == hash;
+	if (hash_matches && (flags & BPF_F_FAST_STACK_CMP))
+		return id;
+
+	if (stack_map_use_build_id(map)) {
+		/* the entries to compare have to be built first */
+		new_bucket = (struct stack_map_bucket *)
+			pcpu_freelist_pop(&smap->freelist);
+		if (unlikely(!new_bucket))
+			return -ENOMEM;
+		stack_map_get_build_id_offset((void *)new_bucket->data, ips,
+					      trace_nr, user);
+		trace_len = trace_nr * sizeof(struct bpf_stack_build_id);
+		if (hash_matches && bucket->nr == trace_nr &&
+		    memcmp(bucket->data, new_bucket->data, trace_len) == 0) {
+			pcpu_freelist_push(&smap->freelist, &new_bucket->fnode);
 			return id;
-		if (bucket->nr == trace_nr &&
-		    memcmp(bucket->ip, ips, trace_len) == 0)
+		}
+		if (bucket && !(flags & BPF_F_REUSE_STACKID)) {
+			pcpu_freelist_push(&smap->freelist, &new_bucket->fnode);
+			return -EEXIST;
+		}
+	} else {
+		if (hash_matches && bucket->nr == trace_nr &&
+		    memcmp(bucket->data, ips, trace_len) == 0)
 			return id;
-	}
 
-	/* this call stack is not in the map, try to add it */
-	if (bucket && !(flags & BPF_F_REUSE_STACKID))
-		return -EEXIST;
+		/* this call stack is not in the map, try to add it */
+		if (bucket && !(flags & BPF_F_REUSE_STACKID))
+			return -EEXIST;
 
-	new_bucket = (struct stack_map_bucket *)
-		pcpu_freelist_pop(&smap->freelist);
-	if (unlikely(!new_bucket))
-		return -ENOMEM;
+		new_bucket = (struct stack_map_bucket *)
+			pcpu_freelist_pop(&smap->freelist);
+		if (unlikely(!new_bucket))
+			return -ENOMEM;
+		memcpy(new_bucket->data, ips, trace_len);
+	}
 
-	memcpy(new_bucket->ip, ips, trace_len);
 	new_bucket->hash = hash;
 	new_bucket->nr = trace_nr;
 
@@ -217,8 +425,8 @@ int bpf_stackmap_copy(struct bpf_map *map, void *key, void *value)
 	if (!bucket)
 		return -ENOENT;
 
-	trace_len = bucket->nr * sizeof(u64);
-	memcpy(value, bucket->ip, trace_len);
+	trace_len = bucket->nr * stack_map_data_size(map);
+	memcpy(value, bucket->data, trace_len);
 	memset(value + trace_len, 0, map->value_size - trace_len);
 
 	old_bucket = xchg(&smap->buckets[id], bucket);
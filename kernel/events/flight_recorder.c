@@ -0,0 +1,337 @@
+/*
+ * Always-on flight recorder for scheduling events.
+ *
+ * sched_switch, irq entry/exit and cpu_frequency are recorded into a per
+ * CPU ring buffer in overwrite mode, so the recorder costs one reserve and
+ * commit per event and needs no reader to drain it. When a jank detector
+ * calls flight_recorder_freeze(), or on oops and panic, recording stops and
+ * the buffer holds the last moments before the trigger. It is read back,
+ * from a live system or a ramdump, through debugfs:
+ *
+ *   cat <debugfs>/flight_recorder/trace
+ *   echo 1 > <debugfs>/flight_recorder/enable	# clear and rearm
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/ring_buffer.h>
+#include <linux/sizes.h>
+#include <linux/kmsg_dump.h>
+#include <linux/interrupt.h>
+#include <linux/sched.h>
+#include <linux/flight_recorder.h>
+#include <trace/events/sched.h>
+#include <trace/events/irq.h>
+#include <trace/events/power.h>
+
+enum fr_type {
+	FR_SCHED_SWITCH,
+	FR_IRQ_ENTRY,
+	FR_IRQ_EXIT,
+	FR_CPU_FREQ,
+};
+
+#define FR_EVENTS_ALL	(BIT(FR_SCHED_SWITCH) | BIT(FR_IRQ_ENTRY) | \
+			 BIT(FR_IRQ_EXIT) | BIT(FR_CPU_FREQ))
+
+struct fr_entry {
+	u32 type;
+	union {
+		struct {
+			pid_t prev_pid;
+			pid_t next_pid;
+			long prev_state;
+			char next_comm[TASK_COMM_LEN];
+		} sw;
+		struct {
+			int irq;
+			int ret;
+		} irq;
+		struct {
+			unsigned int cpu;
+			unsigned int freq;
+		} freq;
+	};
+};
+
+static unsigned int buf_size_kb = 64;
+module_param(buf_size_kb, uint, 0444);
+MODULE_PARM_DESC(buf_size_kb, "Per CPU buffer size in KB");
+
+static unsigned int events = FR_EVENTS_ALL;
+module_param(events, uint, 0644);
+MODULE_PARM_DESC(events, "Recorded events: 1 sched_switch, 2 irq entry, 4 irq exit, 8 cpu_frequency");
+
+static struct ring_buffer *fr_buffer;
+static atomic_t fr_frozen = ATOMIC_INIT(0);
+static char fr_reason[32];
+static u64 fr_freeze_time;
+static DEFINE_MUTEX(fr_lock);
+
+static void fr_write(struct fr_entry *entry, size_t len)
+{
+	ring_buffer_write(fr_buffer, len, entry);
+}
+
+#define fr_len(field)	(offsetof(struct fr_entry, field) + \
+			 sizeof(((struct fr_entry *)0)->field))
+
+static void fr_probe_sched_switch(void *ignore, bool preempt,
+				  struct task_struct *prev,
+				  struct task_struct *next)
+{
+	struct fr_entry entry;
+
+	if (!(READ_ONCE(events) & BIT(FR_SCHED_SWITCH)))
+		return;
+
+	entry.type = FR_SCHED_SWITCH;
+	entry.sw.prev_pid = prev->pid;
+	entry.sw.next_pid = next->pid;
+	entry.sw.prev_state = preempt ? TASK_RUNNING : prev->state;
+	memcpy(entry.sw.next_comm, next->comm, TASK_COMM_LEN);
+	fr_write(&entry, fr_len(sw));
+}
+
+static void fr_probe_irq_entry(void *ignore, int irq,
+			       struct irqaction *action)
+{
+	struct fr_entry entry;
+
+	if (!(READ_ONCE(events) & BIT(FR_IRQ_ENTRY)))
+		return;
+
+	entry.type = FR_IRQ_ENTRY;
+	entry.irq.irq = irq;
+	entry.irq.ret = 0;
+	fr_write(&entry, fr_len(irq));
+}
+
+static void fr_probe_irq_exit(void *ignore, int irq,
+			      struct irqaction *action, int ret)
+{
+	struct fr_entry entry;
+
+	if (!(READ_ONCE(events) & BIT(FR_IRQ_EXIT)))
+		return;
+
+	entry.type = FR_IRQ_EXIT;
+	entry.irq.irq = irq;
+	entry.irq.ret = ret;
+	fr_write(&entry, fr_len(irq));
+}
+
+static void fr_probe_cpu_frequency(void *ignore, unsigned int frequency,
+				   unsigned int cpu_id)
+{
+	struct fr_entry entry;
+
+	if (!(READ_ONCE(events) & BIT(FR_CPU_FREQ)))
+		return;
+
+	entry.type = FR_CPU_FREQ;
+	entry.freq.cpu = cpu_id;
+	entry.freq.freq = frequency;
+	fr_write(&entry, fr_len(freq));
+}
+
+void flight_recorder_freeze(const char *reason)
+{
+	if (!fr_buffer || atomic_cmpxchg(&fr_frozen, 0, 1))
+		return;
+
+	ring_buffer_record_disable(fr_buffer);
+	fr_freeze_time = ring_buffer_time_stamp(fr_buffer,
+						raw_smp_processor_id());
+	strlcpy(fr_reason, reason, sizeof(fr_reason));
+}
+EXPORT_SYMBOL(flight_recorder_freeze);
+
+static void fr_kmsg_dump(struct kmsg_dumper *dumper,
+			 enum kmsg_dump_reason reason)
+{
+	flight_recorder_freeze(reason == KMSG_DUMP_PANIC ? "panic" : "oops");
+}
+
+static struct kmsg_dumper fr_dumper = {
+	.dump = fr_kmsg_dump,
+	.max_reason = KMSG_DUMP_OOPS,
+};
+
+static void fr_show_entry(struct seq_file *m, int cpu, u64 ts,
+			  struct fr_entry *entry)
+{
+	unsigned long usecs_rem;
+
+	usecs_rem = do_div(ts, NSEC_PER_SEC) / NSEC_PER_USEC;
+	seq_printf(m, "%3d %5lu.%06lu ", cpu, (unsigned long)ts, usecs_rem);
+
+	switch (entry->type) {
+	case FR_SCHED_SWITCH:
+		seq_printf(m, "sched_switch prev_pid=%d prev_state=%ld next=%.*s:%d\n",
+			   entry->sw.prev_pid, entry->sw.prev_state,
+			   TASK_COMM_LEN, entry->sw.next_comm,
+			   entry->sw.next_pid);
+		break;
+	case FR_IRQ_ENTRY:
+		seq_printf(m, "irq_entry irq=%d\n", entry->irq.irq);
+		break;
+	case FR_IRQ_EXIT:
+		seq_printf(m, "irq_exit irq=%d ret=%d\n", entry->irq.irq,
+			   entry->irq.ret);
+		break;
+	case FR_CPU_FREQ:
+		seq_printf(m, "cpu_frequency cpu=%u freq=%u\n",
+			   entry->freq.cpu, entry->freq.freq);
+		break;
+	default:
+		seq_puts(m, "unknown\n");
+		break;
+	}
+}
+
+static int fr_trace_show(struct seq_file *m, void *v)
+{
+	struct ring_buffer_iter *iter;
+	struct ring_buffer_event *event;
+	u64 ts;
+	int cpu;
+
+	mutex_lock(&fr_lock);
+	if (atomic_read(&fr_frozen)) {
+		ts = fr_freeze_time;
+		do_div(ts, NSEC_PER_USEC);
+		seq_printf(m, "frozen: %s at %llu us\n", fr_reason, ts);
+	} else {
+		seq_puts(m, "recording\n");
+	}
+
+	for_each_possible_cpu(cpu) {
+		iter = ring_buffer_read_prepare(fr_buffer, cpu, GFP_KERNEL);
+		if (!iter)
+			continue;
+		ring_buffer_read_prepare_sync();
+		ring_buffer_read_start(iter);
+
+		while ((event = ring_buffer_read(iter, &ts)))
+			fr_show_entry(m, cpu, ts,
+				      ring_buffer_event_data(event));
+
+		ring_buffer_read_finish(iter);
+	}
+	mutex_unlock(&fr_lock);
+
+	return 0;
+}
+
+static int fr_trace_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fr_trace_show, NULL);
+}
+
+static const struct file_operations fr_trace_fops = {
+	.open		= fr_trace_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static ssize_t fr_enable_read(struct file *file, char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	char buf[3];
+
+	buf[0] = atomic_read(&fr_frozen) ? '0' : '1';
+	buf[1] = '\n';
+	buf[2] = '\0';
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf, 2);
+}
+
+static ssize_t fr_enable_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(ubuf, count, &enable);
+	if (ret)
+		return ret;
+
+	if (!enable) {
+		flight_recorder_freeze("user");
+		return count;
+	}
+
+	mutex_lock(&fr_lock);
+	if (atomic_read(&fr_frozen)) {
+		ring_buffer_reset(fr_buffer);
+		atomic_set(&fr_frozen, 0);
+		ring_buffer_record_enable(fr_buffer);
+	}
+	mutex_unlock(&fr_lock);
+
+	return count;
+}
+
+static const struct file_operations fr_enable_fops = {
+	.open		= simple_open,
+	.read		= fr_enable_read,
+	.write		= fr_enable_write,
+	.llseek		= default_llseek,
+};
+
+static int __init flight_recorder_init(void)
+{
+	struct dentry *dir;
+	int ret;
+
+	fr_buffer = ring_buffer_alloc(buf_size_kb * SZ_1K, RB_FL_OVERWRITE);
+	if (!fr_buffer)
+		return -ENOMEM;
+
+	ret = register_trace_sched_switch(fr_probe_sched_switch, NULL);
+	if (ret)
+		goto free_buffer;
+	ret = register_trace_irq_handler_entry(fr_probe_irq_entry, NULL);
+	if (ret)
+		goto unreg_sched_switch;
+	ret = register_trace_irq_handler_exit(fr_probe_irq_exit, NULL);
+	if (ret)
+		goto unreg_irq_entry;
+	ret = register_trace_cpu_frequency(fr_probe_cpu_frequency, NULL);
+	if (ret)
+		goto unreg_irq_exit;
+
+	kmsg_dump_register(&fr_dumper);
+
+	dir = debugfs_create_dir("flight_recorder", NULL);
+	if (!IS_ERR_OR_NULL(dir)) {
+		debugfs_create_file("trace", 0400, dir, NULL, &fr_trace_fops);
+		debugfs_create_file("enable", 0600, dir, NULL,
+				    &fr_enable_fops);
+	}
+
+	return 0;
+
+unreg_irq_exit:
+	unregister_trace_irq_handler_exit(fr_probe_irq_exit, NULL);
+unreg_irq_entry:
+	unregister_trace_irq_handler_entry(fr_probe_irq_entry, NULL);
+unreg_sched_switch:
+	unregister_trace_sched_switch(fr_probe_sched_switch, NULL);
+free_buffer:
+	ring_buffer_free(fr_buffer);
+	fr_buffer = NULL;
+	return ret;
+}
+late_initcall(flight_recorder_init);
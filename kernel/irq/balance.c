@@ -0,0 +1,273 @@
+/*
+ * Load aware interrupt affinity balancing.
+ *
+ * Device interrupts are routed to the first online cpu of their affinity
+ * mask, which with the default mask means every high rate interrupt of
+ * the system ends up on CPU0. Userspace irqbalance samples too slowly to
+ * follow bursty traffic, so this balancer runs in the kernel: every
+ * interval_ms it computes each interrupt's rate from kstat and its handler
+ * time as accounted by handle_irq_event_percpu(), and moves interrupts
+ * above min_rate to the cpu of the balance mask with the least interrupt
+ * load. The move goes through irq_set_affinity(), so chips that cannot
+ * be retargeted from process context are migrated by irq_move_irq() on
+ * the next interrupt.
+ *
+ * To avoid ping-ponging, an interrupt is only moved when the imbalance
+ * between its cpu and the target exceeds hysteresis_pct of its cpu's load
+ * and survives the move, and not within hold_ms of its last move.
+ * Interrupts that are per cpu, managed, marked IRQF_NOBALANCING or whose
+ * affinity was restricted by a driver or by /proc/irq/N/smp_affinity are
+ * left alone.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#include <linux/irq.h>
+#include <linux/interrupt.h>
+#include <linux/kernel_stat.h>
+#include <linux/moduleparam.h>
+#include <linux/workqueue.h>
+#include <linux/cpumask.h>
+#include <linux/percpu.h>
+#include <linux/jiffies.h>
+
+#include "internals.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "irq_balance."
+
+DEFINE_STATIC_KEY_FALSE(irq_balance_enabled);
+
+static DEFINE_PER_CPU(u64, irq_balance_cpu_ns);
+static DEFINE_PER_CPU(u64, irq_balance_cpu_last);
+static DEFINE_PER_CPU(u64, irq_balance_cpu_load);
+
+static struct cpumask irq_balance_cpus;
+static bool irq_balance_ready;
+static u64 irq_balance_last_run;
+
+static void irq_balance_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_balance_work, irq_balance_work_fn);
+
+static unsigned int min_rate = 1000;
+module_param(min_rate, uint, 0644);
+MODULE_PARM_DESC(min_rate, "Interrupts per second above which an irq is balanced");
+
+static unsigned int hysteresis_pct = 25;
+module_param(hysteresis_pct, uint, 0644);
+MODULE_PARM_DESC(hysteresis_pct, "Load imbalance, in percent, required to move an irq");
+
+static unsigned int hold_ms = 5000;
+module_param(hold_ms, uint, 0644);
+MODULE_PARM_DESC(hold_ms, "Minimum time an irq stays on the cpu it was moved to");
+
+static unsigned int interval_ms = 1000;
+
+static int irq_balance_set_interval(const char *val,
+				    const struct kernel_param *kp)
+{
+	unsigned int old = interval_ms;
+	int ret;
+
+	ret = param_set_uint(val, kp);
+	if (ret || !irq_balance_ready)
+		return ret;
+
+	if (interval_ms && !old) {
+		static_branch_enable(&irq_balance_enabled);
+		irq_balance_last_run = local_clock();
+		queue_delayed_work(system_power_efficient_wq, &irq_balance_work,
+				   msecs_to_jiffies(interval_ms));
+	} else if (!interval_ms && old) {
+		cancel_delayed_work_sync(&irq_balance_work);
+		static_branch_disable(&irq_balance_enabled);
+	}
+
+	return 0;
+}
+
+static const struct kernel_param_ops irq_balance_interval_ops = {
+	.set = irq_balance_set_interval,
+	.get = param_get_uint,
+};
+module_param_cb(interval_ms, &irq_balance_interval_ops, &interval_ms, 0644);
+MODULE_PARM_DESC(interval_ms, "Balancing interval, 0 disables the balancer");
+
+static int irq_balance_set_cpus(const char *val, const struct kernel_param *kp)
+{
+	cpumask_var_t mask;
+	int ret;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = cpulist_parse(val, mask);
+	if (!ret && cpumask_empty(mask))
+		ret = -EINVAL;
+	if (!ret)
+		cpumask_copy(&irq_balance_cpus, mask);
+
+	free_cpumask_var(mask);
+	return ret;
+}
+
+static int irq_balance_get_cpus(char *buf, const struct kernel_param *kp)
+{
+	return cpumap_print_to_pagebuf(true, buf, &irq_balance_cpus);
+}
+
+static const struct kernel_param_ops irq_balance_cpus_ops = {
+	.set = irq_balance_set_cpus,
+	.get = irq_balance_get_cpus,
+};
+module_param_cb(cpus, &irq_balance_cpus_ops, NULL, 0644);
+MODULE_PARM_DESC(cpus, "List of cpus interrupts are balanced across");
+
+void __irq_balance_account(struct irq_desc *desc, u64 start)
+{
+	u64 delta = local_clock() - start;
+
+	desc->balance.time_ns += delta;
+	__this_cpu_add(irq_balance_cpu_ns, delta);
+}
+
+static int irq_balance_find_cpu(const struct cpumask *allowed)
+{
+	u64 load, min_load = U64_MAX;
+	int cpu, best = -1;
+
+	for_each_cpu(cpu, allowed) {
+		load = per_cpu(irq_balance_cpu_load, cpu);
+		if (load < min_load) {
+			min_load = load;
+			best = cpu;
+		}
+	}
+
+	return best;
+}
+
+static void irq_balance_one(unsigned int irq, struct irq_desc *desc,
+			    const struct cpumask *allowed, u64 window_ns)
+{
+	struct irq_balance_stat *st = &desc->balance;
+	struct irq_data *data = &desc->irq_data;
+	const struct cpumask *aff;
+	unsigned int count = kstat_irqs(irq);
+	u64 time = READ_ONCE(st->time_ns);
+	u64 cur_load, best_load, rate, irq_load;
+	unsigned long flags;
+	int cur, best;
+	bool restricted;
+
+	rate = div64_u64((u64)(count - st->last_count) * NSEC_PER_SEC,
+			 window_ns);
+	irq_load = time - st->last_time_ns;
+	st->last_count = count;
+	st->last_time_ns = time;
+
+	if (rate < min_rate || !desc->action)
+		return;
+	if (irqd_is_per_cpu(data) || !irqd_can_balance(data) ||
+	    irqd_affinity_is_managed(data))
+		return;
+	if (st->placed && time_before(jiffies, st->last_move +
+				      msecs_to_jiffies(hold_ms)))
+		return;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	aff = irq_data_get_affinity_mask(data);
+	/* someone else changed the affinity since we placed the irq */
+	if (st->placed && !cpumask_equal(aff, cpumask_of(st->cpu)))
+		st->placed = false;
+	restricted = !st->placed && !cpumask_subset(allowed, aff);
+	cur = st->placed ? st->cpu : cpumask_first_and(aff, cpu_online_mask);
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	if (restricted || cur >= nr_cpu_ids)
+		return;
+
+	best = irq_balance_find_cpu(allowed);
+	if (best < 0 || best == cur)
+		return;
+
+	/* an irq outside the balance mask always moves in */
+	if (cpumask_test_cpu(cur, allowed)) {
+		cur_load = per_cpu(irq_balance_cpu_load, cur);
+		best_load = per_cpu(irq_balance_cpu_load, best);
+		if (best_load + irq_load >= cur_load)
+			return;
+		if ((cur_load - best_load) * 100 <= cur_load * hysteresis_pct)
+			return;
+	}
+
+	if (irq_set_affinity(irq, cpumask_of(best)))
+		return;
+
+	st->cpu = best;
+	st->placed = true;
+	st->last_move = jiffies;
+
+	/* account the move so the rest of this pass sees it */
+	per_cpu(irq_balance_cpu_load, cur) -=
+		min(per_cpu(irq_balance_cpu_load, cur), irq_load);
+	per_cpu(irq_balance_cpu_load, best) += irq_load;
+}
+
+static void irq_balance_work_fn(struct work_struct *work)
+{
+	struct irq_desc *desc;
+	cpumask_t allowed;
+	u64 now, window_ns;
+	unsigned int irq;
+	int cpu;
+
+	now = local_clock();
+	window_ns = now - irq_balance_last_run;
+	irq_balance_last_run = now;
+
+	for_each_possible_cpu(cpu) {
+		now = READ_ONCE(per_cpu(irq_balance_cpu_ns, cpu));
+		per_cpu(irq_balance_cpu_load, cpu) =
+			now - per_cpu(irq_balance_cpu_last, cpu);
+		per_cpu(irq_balance_cpu_last, cpu) = now;
+	}
+
+	get_online_cpus();
+	cpumask_and(&allowed, &irq_balance_cpus, cpu_online_mask);
+	if (window_ns && cpumask_weight(&allowed) > 1) {
+		irq_lock_sparse();
+		for_each_irq_desc(irq, desc)
+			irq_balance_one(irq, desc, &allowed, window_ns);
+		irq_unlock_sparse();
+	}
+	put_online_cpus();
+
+	if (READ_ONCE(interval_ms))
+		queue_delayed_work(system_power_efficient_wq, &irq_balance_work,
+				   msecs_to_jiffies(READ_ONCE(interval_ms)));
+}
+
+static int __init irq_balance_init(void)
+{
+	if (cpumask_empty(&irq_balance_cpus))
+		cpumask_copy(&irq_balance_cpus, cpu_possible_mask);
+
+	irq_balance_ready = true;
+	if (!interval_ms)
+		return 0;
+
+	static_branch_enable(&irq_balance_enabled);
+	irq_balance_last_run = local_clock();
+	queue_delayed_work(system_power_efficient_wq, &irq_balance_work,
+			   msecs_to_jiffies(interval_ms));
+
+	return 0;
+}
+late_initcall(irq_balance_init);
@@ -64,6 +64,10 @@ void __irq_wake_thread(struct irq_desc *desc, struct irqaction *action)
 	if (action->thread->flags & PF_EXITING)
 		return;
 
+	/* Batched threads are woken once per window, see threadstat.c */
+	if (irq_thread_stat_wake(desc, action))
+		return;
+
 	/*
 	 * Wake up the handler thread for this action. If the
 	 * RUNTHREAD bit is already set, nothing to do.
@@ -181,8 +185,11 @@ irqreturn_t handle_irq_event_percpu(struct irq_desc *desc)
 {
 	irqreturn_t retval;
 	unsigned int flags = 0;
+	u64 start = irq_balance_start();
 
+	irq_timings_record(desc);
 	retval = __handle_irq_event_percpu(desc, &flags);
+	irq_balance_account(desc, start);
 
 	add_interrupt_randomness(desc->irq_data.irq);
 
@@ -8,6 +8,9 @@
 #include <linux/irqdesc.h>
 #include <linux/kernel_stat.h>
 #include <linux/pm_runtime.h>
+#include <linux/jump_label.h>
+#include <linux/hrtimer.h>
+#include <linux/sched.h>
 
 #ifdef CONFIG_SPARSE_IRQ
 # define IRQ_BITMAP_BITS	(NR_IRQS + 8196)
@@ -88,6 +91,74 @@ irqreturn_t __handle_irq_event_percpu(struct irq_desc *desc, unsigned int *flags
 irqreturn_t handle_irq_event_percpu(struct irq_desc *desc);
 irqreturn_t handle_irq_event(struct irq_desc *desc);
 
+#ifdef CONFIG_IRQ_AUTO_BALANCE
+DECLARE_STATIC_KEY_FALSE(irq_balance_enabled);
+void __irq_balance_account(struct irq_desc *desc, u64 start);
+
+static inline u64 irq_balance_start(void)
+{
+	if (static_branch_unlikely(&irq_balance_enabled))
+		return local_clock() ? : 1;
+	return 0;
+}
+
+static inline void irq_balance_account(struct irq_desc *desc, u64 start)
+{
+	if (start)
+		__irq_balance_account(desc, start);
+}
+#else
+static inline u64 irq_balance_start(void) { return 0; }
+static inline void irq_balance_account(struct irq_desc *desc, u64 start) { }
+#endif
+
+#ifdef CONFIG_IRQ_THREAD_STATS
+/* log2 buckets of hardirq to thread latency: <1us, 1-2us, ... >=16ms */
+#define IRQ_THREAD_LAT_BUCKETS	16
+
+struct irq_thread_stat {
+	struct irqaction	*action;
+	u64			wake_ns;
+	u64			runs;
+	u64			lat_total_ns;
+	u64			lat_max_ns;
+	u64			hist[IRQ_THREAD_LAT_BUCKETS];
+	u64			batch_ns;
+	u64			batch_next_ns;
+	atomic_t		batch_pending;
+	unsigned int		batch_count;
+	struct hrtimer		batch_timer;
+};
+
+int irq_thread_stat_alloc(struct irqaction *action);
+void irq_thread_stat_free(struct irq_desc *desc, struct irqaction *action);
+bool irq_thread_stat_wake(struct irq_desc *desc, struct irqaction *action);
+void irq_thread_stat_run(struct irqaction *action);
+#else
+static inline int irq_thread_stat_alloc(struct irqaction *action) { return 0; }
+static inline void irq_thread_stat_free(struct irq_desc *desc,
+					struct irqaction *action) { }
+static inline bool irq_thread_stat_wake(struct irq_desc *desc,
+					struct irqaction *action)
+{
+	return false;
+}
+static inline void irq_thread_stat_run(struct irqaction *action) { }
+#endif
+
+#ifdef CONFIG_IRQ_TIMINGS
+DECLARE_STATIC_KEY_FALSE(irq_timing_enabled);
+void __irq_timings_record(unsigned int irq);
+
+static inline void irq_timings_record(struct irq_desc *desc)
+{
+	if (static_branch_unlikely(&irq_timing_enabled))
+		__irq_timings_record(desc->irq_data.irq);
+}
+#else
+static inline void irq_timings_record(struct irq_desc *desc) { }
+#endif
+
 /* Resending of interrupts :*/
 void check_irq_resend(struct irq_desc *desc);
 bool irq_wait_for_poll(struct irq_desc *desc);
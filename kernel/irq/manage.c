@@ -989,6 +989,7 @@ static int irq_thread(void *data)
 
 		irq_thread_check_affinity(desc, action);
 
+		irq_thread_stat_run(action);
 		action_ret = handler_fn(desc, action);
 		if (action_ret == IRQ_WAKE_THREAD)
 			irq_wake_secondary(desc, action);
@@ -1099,6 +1100,11 @@ setup_irq_thread(struct irqaction *new, unsigned int irq, bool secondary)
 	struct sched_param param = {
 		.sched_priority = MAX_USER_RT_PRIO/2,
 	};
+	int ret;
+
+	ret = irq_thread_stat_alloc(new);
+	if (ret)
+		return ret;
 
 	if (!secondary) {
 		t = kthread_create(irq_thread, new, "irq/%d-%s", irq,
@@ -1109,8 +1115,10 @@ setup_irq_thread(struct irqaction *new, unsigned int irq, bool secondary)
 		param.sched_priority -= 1;
 	}
 
-	if (IS_ERR(t))
+	if (IS_ERR(t)) {
+		irq_thread_stat_free(irq_to_desc(irq), new);
 		return PTR_ERR(t);
+	}
 
 	sched_setscheduler_nocheck(t, SCHED_FIFO, &param);
 
@@ -1431,6 +1439,7 @@ out_thread:
 		new->thread = NULL;
 		kthread_stop(t);
 		put_task_struct(t);
+		irq_thread_stat_free(desc, new);
 	}
 	if (new->secondary && new->secondary->thread) {
 		struct task_struct *t = new->secondary->thread;
@@ -1438,6 +1447,7 @@ out_thread:
 		new->secondary->thread = NULL;
 		kthread_stop(t);
 		put_task_struct(t);
+		irq_thread_stat_free(desc, new->secondary);
 	}
 out_mput:
 	module_put(desc->owner);
@@ -1556,9 +1566,11 @@ static struct irqaction *__free_irq(unsigned int irq, void *dev_id)
 
 	if (action->thread) {
 		kthread_stop(action->thread);
+		irq_thread_stat_free(desc, action);
 		put_task_struct(action->thread);
 		if (action->secondary && action->secondary->thread) {
 			kthread_stop(action->secondary->thread);
+			irq_thread_stat_free(desc, action->secondary);
 			put_task_struct(action->secondary->thread);
 		}
 	}
@@ -286,6 +286,49 @@ static const struct file_operations irq_spurious_proc_fops = {
 	.release	= single_release,
 };
 
+#ifdef CONFIG_IRQ_THREAD_STATS
+static int irq_thread_latency_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long) m->private);
+	struct irq_thread_stat *st;
+	struct irqaction *action;
+	unsigned long flags;
+	int i;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	for_each_action_of_desc(desc, action) {
+		st = action->tstat;
+		if (!st)
+			continue;
+
+		seq_printf(m, "%s: runs %llu max %llu ns total %llu ns batch %llu us\n",
+			   action->name ? : "-", st->runs, st->lat_max_ns,
+			   st->lat_total_ns, div_u64(st->batch_ns, NSEC_PER_USEC));
+		seq_printf(m, "  %8s us: %llu\n", "<1", st->hist[0]);
+		for (i = 1; i < IRQ_THREAD_LAT_BUCKETS - 1; i++)
+			seq_printf(m, "  %8u us: %llu\n", 1U << (i - 1),
+				   st->hist[i]);
+		seq_printf(m, "  >=%6u us: %llu\n",
+			   1U << (IRQ_THREAD_LAT_BUCKETS - 2), st->hist[i]);
+	}
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	return 0;
+}
+
+static int irq_thread_latency_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_thread_latency_proc_show, PDE_DATA(inode));
+}
+
+static const struct file_operations irq_thread_latency_proc_fops = {
+	.open		= irq_thread_latency_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
 #define MAX_NAMELEN 128
 
 static int name_unique(unsigned int irq, struct irqaction *new_action)
@@ -371,6 +414,11 @@ void register_irq_proc(unsigned int irq, struct irq_desc *desc)
 	proc_create_data("spurious", 0444, desc->dir,
 			 &irq_spurious_proc_fops, (void *)(long)irq);
 
+#ifdef CONFIG_IRQ_THREAD_STATS
+	proc_create_data("thread_latency", 0444, desc->dir,
+			 &irq_thread_latency_proc_fops, (void *)(long)irq);
+#endif
+
 out_unlock:
 	mutex_unlock(&register_lock);
 }
@@ -388,6 +436,9 @@ void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
 	remove_proc_entry("node", desc->dir);
 #endif
 	remove_proc_entry("spurious", desc->dir);
+#ifdef CONFIG_IRQ_THREAD_STATS
+	remove_proc_entry("thread_latency", desc->dir);
+#endif
 
 	sprintf(name, "%u", irq);
 	remove_proc_entry(name, root_irq_dir);
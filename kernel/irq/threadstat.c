@@ -0,0 +1,222 @@
+/*
+ * Threaded interrupt batching and hardirq to thread latency statistics.
+ *
+ * Every threaded action carries a struct irq_thread_stat which records
+ * the time from the first hardirq requesting a thread run until the
+ * thread handler starts, as a log2 histogram shown in
+ * /proc/irq/<n>/thread_latency.
+ *
+ * A driver can opt in to batching with irq_set_thread_batch(): the
+ * thread is then woken at most once per window and the handler reads the
+ * number of hardirqs it is serving with irq_thread_batch_count(). Oneshot
+ * lines stay masked while a wakeup is deferred, exactly as they would
+ * while the thread is running.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#include <linux/irq.h>
+#include <linux/interrupt.h>
+#include <linux/kthread.h>
+#include <linux/hrtimer.h>
+#include <linux/slab.h>
+#include <linux/log2.h>
+
+#include "internals.h"
+
+/* retry delay when the timer races with the hardirq of the line */
+#define IRQ_THREAD_BATCH_RETRY_NS	(10 * NSEC_PER_USEC)
+
+static enum hrtimer_restart irq_thread_batch_fn(struct hrtimer *timer)
+{
+	struct irq_thread_stat *st = container_of(timer, struct irq_thread_stat,
+						  batch_timer);
+	struct irqaction *action = st->action;
+	struct irq_desc *desc = irq_to_desc(action->irq);
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	/*
+	 * threads_oneshot is written locklessly by the hardirq path, which
+	 * is serialized against us only by IRQD_IRQ_INPROGRESS. See
+	 * __irq_wake_thread().
+	 */
+	if (irqd_irq_inprogress(&desc->irq_data)) {
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+		hrtimer_forward_now(timer,
+				    ns_to_ktime(IRQ_THREAD_BATCH_RETRY_NS));
+		return HRTIMER_RESTART;
+	}
+
+	if (!(action->thread->flags & PF_EXITING) &&
+	    !test_and_set_bit(IRQTF_RUNTHREAD, &action->thread_flags)) {
+		desc->threads_oneshot |= action->thread_mask;
+		atomic_inc(&desc->threads_active);
+		wake_up_process(action->thread);
+	}
+	st->batch_next_ns = local_clock() + st->batch_ns;
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+int irq_thread_stat_alloc(struct irqaction *action)
+{
+	struct irq_thread_stat *st;
+
+	st = kzalloc(sizeof(*st), GFP_KERNEL);
+	if (!st)
+		return -ENOMEM;
+
+	st->action = action;
+	hrtimer_init(&st->batch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	st->batch_timer.function = irq_thread_batch_fn;
+	action->tstat = st;
+
+	return 0;
+}
+
+void irq_thread_stat_free(struct irq_desc *desc, struct irqaction *action)
+{
+	struct irq_thread_stat *st = action->tstat;
+
+	if (!st)
+		return;
+
+	/* a cancelled deferred wakeup must not keep a oneshot line masked */
+	if (hrtimer_cancel(&st->batch_timer)) {
+		raw_spin_lock_irq(&desc->lock);
+		desc->threads_oneshot &= ~action->thread_mask;
+		raw_spin_unlock_irq(&desc->lock);
+	}
+
+	action->tstat = NULL;
+	kfree(st);
+}
+
+/*
+ * Called from __irq_wake_thread() in hardirq context. Returns true when
+ * the thread wakeup is deferred to the end of the batching window.
+ */
+bool irq_thread_stat_wake(struct irq_desc *desc, struct irqaction *action)
+{
+	struct irq_thread_stat *st = action->tstat;
+	u64 now, window;
+
+	if (!st)
+		return false;
+
+	now = local_clock();
+	if (!st->wake_ns)
+		st->wake_ns = now;
+
+	window = READ_ONCE(st->batch_ns);
+	if (!window)
+		return false;
+
+	atomic_inc(&st->batch_pending);
+	if (test_bit(IRQTF_RUNTHREAD, &action->thread_flags))
+		return false;
+
+	if (now >= st->batch_next_ns) {
+		st->batch_next_ns = now + window;
+		return false;
+	}
+
+	desc->threads_oneshot |= action->thread_mask;
+	if (!hrtimer_active(&st->batch_timer))
+		hrtimer_start(&st->batch_timer,
+			      ns_to_ktime(st->batch_next_ns - now),
+			      HRTIMER_MODE_REL);
+	return true;
+}
+
+/* Called from the irq thread right before the thread handler runs */
+void irq_thread_stat_run(struct irqaction *action)
+{
+	struct irq_thread_stat *st = action->tstat;
+	u64 wake, lat;
+	unsigned int bucket = 0;
+
+	if (!st)
+		return;
+
+	st->batch_count = st->batch_ns ? atomic_xchg(&st->batch_pending, 0) : 1;
+
+	wake = xchg(&st->wake_ns, 0);
+	if (!wake)
+		return;
+
+	lat = local_clock() - wake;
+	if (lat >= NSEC_PER_USEC)
+		bucket = min_t(unsigned int,
+			       ilog2(div_u64(lat, NSEC_PER_USEC)) + 1,
+			       IRQ_THREAD_LAT_BUCKETS - 1);
+
+	st->hist[bucket]++;
+	st->runs++;
+	st->lat_total_ns += lat;
+	if (lat > st->lat_max_ns)
+		st->lat_max_ns = lat;
+}
+
+/**
+ *	irq_set_thread_batch - batch the thread wakeups of a threaded irq
+ *	@irq: Interrupt line
+ *	@dev_id: Cookie the handler was requested with
+ *	@window_us: Minimum time between two thread wakeups, 0 disables
+ *
+ *	Hardirqs arriving within @window_us of the last thread wakeup are
+ *	accumulated and served by one thread run at the end of the window.
+ *	The thread handler gets their number from irq_thread_batch_count().
+ */
+int irq_set_thread_batch(unsigned int irq, void *dev_id,
+			 unsigned int window_us)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+	struct irqaction *action;
+	unsigned long flags;
+	int ret = -EINVAL;
+
+	if (!desc)
+		return -EINVAL;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	for_each_action_of_desc(desc, action) {
+		if (action->dev_id != dev_id || !action->tstat)
+			continue;
+		WRITE_ONCE(action->tstat->batch_ns,
+			   (u64)window_us * NSEC_PER_USEC);
+		ret = 0;
+		break;
+	}
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(irq_set_thread_batch);
+
+/**
+ *	irq_thread_batch_count - hardirqs served by the current thread run
+ *
+ *	Must only be called from a threaded interrupt handler. Returns 1
+ *	when batching is not enabled for the interrupt.
+ */
+unsigned int irq_thread_batch_count(void)
+{
+	struct irqaction *action;
+
+	if (WARN_ON_ONCE(!(current->flags & PF_KTHREAD)))
+		return 1;
+
+	action = kthread_data(current);
+	if (!action->tstat)
+		return 1;
+
+	return action->tstat->batch_count;
+}
+EXPORT_SYMBOL_GPL(irq_thread_batch_count);
@@ -0,0 +1,155 @@
+/*
+ * Interrupt inter-arrival timings for idle duration prediction.
+ *
+ * The next timer event bounds an idle period, but periodic device
+ * interrupts like touch reports, audio DMA or display vsync wake the cpu
+ * well before it and make deep idle states a loss. Each cpu tracks the
+ * last IRQ_TIMINGS_SIZE interrupts handled on it, with an exponentially
+ * weighted mean and variance of their inter-arrival time. An interrupt
+ * whose interval is stable predicts its next arrival, and the earliest
+ * such arrival is an upper bound on the coming idle period for cpuidle
+ * governors.
+ *
+ * The statistics only live on the cpu the interrupt is delivered to, so
+ * recording and prediction need no locking, and an interrupt moved to
+ * another cpu simply starts over there.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#include <linux/irq.h>
+#include <linux/interrupt.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+
+#include "internals.h"
+
+#define IRQ_TIMINGS_SIZE		8
+/* intervals above this mean the interrupt is not periodic */
+#define IRQ_TIMINGS_MAX_INTERVAL	NSEC_PER_SEC
+#define IRQ_TIMINGS_MIN_SAMPLES		4
+#define IRQ_TIMINGS_EWMA_SHIFT		3
+
+DEFINE_STATIC_KEY_FALSE(irq_timing_enabled);
+
+struct irqt_stat {
+	unsigned int	irq;
+	unsigned int	count;
+	u64		last_ts;
+	u64		avg;
+	u64		var;
+};
+
+struct irq_timings {
+	struct irqt_stat stat[IRQ_TIMINGS_SIZE];
+};
+
+static DEFINE_PER_CPU(struct irq_timings, irq_timings);
+
+/* Called from handle_irq_event_percpu() in hardirq context */
+void __irq_timings_record(unsigned int irq)
+{
+	struct irq_timings *t = this_cpu_ptr(&irq_timings);
+	struct irqt_stat *s, *victim = &t->stat[0];
+	u64 now = local_clock();
+	u64 interval;
+	s64 diff;
+	int i;
+
+	for (i = 0; i < IRQ_TIMINGS_SIZE; i++) {
+		s = &t->stat[i];
+		if (s->irq == irq && s->last_ts)
+			goto found;
+		if (s->last_ts < victim->last_ts)
+			victim = s;
+	}
+
+	/* replace the interrupt seen least recently */
+	victim->irq = irq;
+	victim->count = 0;
+	victim->last_ts = now;
+	return;
+
+found:
+	interval = now - s->last_ts;
+	s->last_ts = now;
+	if (interval > IRQ_TIMINGS_MAX_INTERVAL) {
+		s->count = 0;
+		return;
+	}
+
+	if (!s->count) {
+		s->avg = interval;
+		s->var = 0;
+	} else {
+		diff = interval - s->avg;
+		s->avg += diff >> IRQ_TIMINGS_EWMA_SHIFT;
+		s->var += (s64)(diff * diff - s->var) >> IRQ_TIMINGS_EWMA_SHIFT;
+	}
+	if (s->count < UINT_MAX)
+		s->count++;
+}
+
+/**
+ *	irq_timings_next_event - predict the next device interrupt on this cpu
+ *	@now: Current local_clock() time
+ *
+ *	Returns the local_clock() time of the earliest expected arrival of
+ *	an interrupt with a stable interval, or U64_MAX if there is none.
+ *	Must be called with interrupts disabled, normally from the cpuidle
+ *	governor's select callback.
+ */
+u64 irq_timings_next_event(u64 now)
+{
+	struct irq_timings *t = this_cpu_ptr(&irq_timings);
+	struct irqt_stat *s;
+	u64 next, next_evt = U64_MAX;
+	int i;
+
+	if (!static_branch_unlikely(&irq_timing_enabled))
+		return U64_MAX;
+
+	for (i = 0; i < IRQ_TIMINGS_SIZE; i++) {
+		s = &t->stat[i];
+		if (s->count < IRQ_TIMINGS_MIN_SAMPLES)
+			continue;
+		/* standard deviation above a quarter of the interval */
+		if (s->var > (s->avg * s->avg) >> 4)
+			continue;
+
+		next = s->last_ts + s->avg;
+		if (next <= now) {
+			/* overdue by more than an interval: it stopped */
+			if (now - s->last_ts > 2 * s->avg)
+				continue;
+			next = now;
+		}
+		next_evt = min(next_evt, next);
+	}
+
+	return next_evt;
+}
+EXPORT_SYMBOL_GPL(irq_timings_next_event);
+
+/**
+ *	irq_timings_enable - start recording interrupt timings
+ *
+ *	Recording adds a clock read to every device interrupt, so it is only
+ *	done while at least one user wants predictions. Must be balanced by
+ *	irq_timings_disable().
+ */
+void irq_timings_enable(void)
+{
+	static_branch_inc(&irq_timing_enabled);
+}
+EXPORT_SYMBOL_GPL(irq_timings_enable);
+
+void irq_timings_disable(void)
+{
+	static_branch_dec(&irq_timing_enabled);
+}
+EXPORT_SYMBOL_GPL(irq_timings_disable);
@@ -0,0 +1,209 @@
+/*
+ * kernel/locking/lock_sample.c
+ *
+ * Sampled lock contention profiling.
+ *
+ * One in every lock_sample_period contended acquisitions on a CPU is
+ * timed from slowpath entry until the lock is owned, and recorded
+ * together with its call chain into a per-CPU ring. Unlike lock_stat it
+ * needs neither lockdep nor a lock class map, so it can stay built into
+ * production kernels and be switched on when needed:
+ *
+ *   echo 100 > /proc/lock_contention	# sample one in 100, clears samples
+ *   cat /proc/lock_contention
+ *   echo 0 > /proc/lock_contention	# stop sampling
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/stacktrace.h>
+#include <linux/sched.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/irqflags.h>
+
+#include "lock_sample.h"
+
+#define LOCK_SAMPLE_ENTRIES	64
+#define LOCK_SAMPLE_DEPTH	4
+
+struct lock_sample {
+	void *lock;
+	u64 wait_ns;
+	enum lock_sample_type type;
+	unsigned long stack[LOCK_SAMPLE_DEPTH];
+};
+
+struct lock_sample_buf {
+	unsigned int head;
+	u64 nr[LOCK_SAMPLE_NR_TYPES];
+	u64 wait_total[LOCK_SAMPLE_NR_TYPES];
+	u64 wait_max[LOCK_SAMPLE_NR_TYPES];
+	struct lock_sample entries[LOCK_SAMPLE_ENTRIES];
+};
+
+static const char * const lock_sample_names[LOCK_SAMPLE_NR_TYPES] = {
+	[LOCK_SAMPLE_SPIN]		= "spin",
+	[LOCK_SAMPLE_MUTEX]		= "mutex",
+	[LOCK_SAMPLE_RWSEM_READ]	= "rwsem-read",
+	[LOCK_SAMPLE_RWSEM_WRITE]	= "rwsem-write",
+};
+
+DEFINE_STATIC_KEY_FALSE(lock_sample_enabled);
+
+static DEFINE_MUTEX(lock_sample_lock);
+static unsigned int lock_sample_period __read_mostly;
+static DEFINE_PER_CPU(int, lock_sample_countdown);
+static struct lock_sample_buf __percpu *lock_sample_bufs;
+
+u64 __lock_sample_begin(void)
+{
+	u64 now;
+
+	if (this_cpu_dec_return(lock_sample_countdown) > 0)
+		return 0;
+
+	this_cpu_write(lock_sample_countdown, READ_ONCE(lock_sample_period));
+	now = local_clock();
+
+	return now ? now : 1;
+}
+
+void __lock_sample_end(void *lock, u64 start, enum lock_sample_type type)
+{
+	struct lock_sample_buf *buf;
+	struct lock_sample *s;
+	struct stack_trace trace;
+	unsigned long flags;
+	s64 delta = local_clock() - start;
+	/* the waiter may have migrated to a CPU with a clock behind */
+	u64 wait = delta > 0 ? delta : 0;
+
+	local_irq_save(flags);
+	buf = this_cpu_ptr(lock_sample_bufs);
+	s = &buf->entries[buf->head++ % LOCK_SAMPLE_ENTRIES];
+
+	s->lock = lock;
+	s->wait_ns = wait;
+	s->type = type;
+	memset(s->stack, 0, sizeof(s->stack));
+	trace.nr_entries = 0;
+	trace.max_entries = LOCK_SAMPLE_DEPTH;
+	trace.entries = s->stack;
+	trace.skip = 2;
+	save_stack_trace(&trace);
+
+	buf->nr[type]++;
+	buf->wait_total[type] += wait;
+	if (wait > buf->wait_max[type])
+		buf->wait_max[type] = wait;
+	local_irq_restore(flags);
+}
+
+static int lock_sample_show(struct seq_file *m, void *v)
+{
+	struct lock_sample_buf *buf;
+	struct lock_sample *s;
+	u64 nr, total, wmax;
+	int cpu, type, i, j;
+
+	seq_printf(m, "period: %u\n\n", lock_sample_period);
+	seq_printf(m, "%-12s %12s %16s %16s\n", "type", "samples",
+		   "wait-total(ns)", "wait-max(ns)");
+
+	for (type = 0; type < LOCK_SAMPLE_NR_TYPES; type++) {
+		nr = total = wmax = 0;
+		for_each_possible_cpu(cpu) {
+			buf = per_cpu_ptr(lock_sample_bufs, cpu);
+			nr += buf->nr[type];
+			total += buf->wait_total[type];
+			wmax = max(wmax, buf->wait_max[type]);
+		}
+		seq_printf(m, "%-12s %12llu %16llu %16llu\n",
+			   lock_sample_names[type], nr, total, wmax);
+	}
+
+	seq_puts(m, "\ncpu type         wait(ns)     lock               call site\n");
+	for_each_possible_cpu(cpu) {
+		buf = per_cpu_ptr(lock_sample_bufs, cpu);
+		for (i = 0; i < min_t(unsigned int, buf->head,
+				      LOCK_SAMPLE_ENTRIES); i++) {
+			s = &buf->entries[i];
+			seq_printf(m, "%3d %-12s %12llu %pK",
+				   cpu, lock_sample_names[s->type],
+				   s->wait_ns, s->lock);
+			for (j = 0; j < LOCK_SAMPLE_DEPTH; j++) {
+				if (!s->stack[j] || s->stack[j] == ULONG_MAX)
+					break;
+				seq_printf(m, " %pS", (void *)s->stack[j]);
+			}
+			seq_putc(m, '\n');
+		}
+	}
+
+	return 0;
+}
+
+static ssize_t lock_sample_write(struct file *file, const char __user *ubuf,
+				 size_t count, loff_t *ppos)
+{
+	unsigned int period;
+	int cpu, ret;
+
+	ret = kstrtouint_from_user(ubuf, count, 0, &period);
+	if (ret)
+		return ret;
+
+	mutex_lock(&lock_sample_lock);
+	static_branch_disable(&lock_sample_enabled);
+	/* let slowpaths already sampling finish */
+	synchronize_sched();
+
+	for_each_possible_cpu(cpu) {
+		memset(per_cpu_ptr(lock_sample_bufs, cpu), 0,
+		       sizeof(struct lock_sample_buf));
+		per_cpu(lock_sample_countdown, cpu) = period;
+	}
+	WRITE_ONCE(lock_sample_period, period);
+
+	if (period)
+		static_branch_enable(&lock_sample_enabled);
+	mutex_unlock(&lock_sample_lock);
+
+	return count;
+}
+
+static int lock_sample_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lock_sample_show, NULL);
+}
+
+static const struct file_operations proc_lock_sample_operations = {
+	.open		= lock_sample_open,
+	.read		= seq_read,
+	.write		= lock_sample_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init lock_sample_init(void)
+{
+	lock_sample_bufs = alloc_percpu(struct lock_sample_buf);
+	if (!lock_sample_bufs)
+		return -ENOMEM;
+
+	proc_create("lock_contention", S_IRUSR | S_IWUSR, NULL,
+		    &proc_lock_sample_operations);
+
+	return 0;
+}
+late_initcall(lock_sample_init);
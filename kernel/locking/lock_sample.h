@@ -0,0 +1,67 @@
+/*
+ * kernel/locking/lock_sample.h
+ *
+ * Sampled lock contention profiling, hooked into the lock slowpaths.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+#ifndef __LOCKING_LOCK_SAMPLE_H
+#define __LOCKING_LOCK_SAMPLE_H
+
+#include <linux/types.h>
+#include <linux/compiler.h>
+#include <linux/jump_label.h>
+
+enum lock_sample_type {
+	LOCK_SAMPLE_SPIN,
+	LOCK_SAMPLE_MUTEX,
+	LOCK_SAMPLE_RWSEM_READ,
+	LOCK_SAMPLE_RWSEM_WRITE,
+	LOCK_SAMPLE_NR_TYPES,
+};
+
+#ifdef CONFIG_LOCK_CONTENTION_SAMPLE
+
+DECLARE_STATIC_KEY_FALSE(lock_sample_enabled);
+
+u64 __lock_sample_begin(void);
+void __lock_sample_end(void *lock, u64 start, enum lock_sample_type type);
+
+/*
+ * Returns the start timestamp when this contended acquisition is sampled
+ * and 0 otherwise. Costs a patched out branch while sampling is off.
+ */
+static __always_inline u64 lock_sample_begin(void)
+{
+	if (static_branch_unlikely(&lock_sample_enabled))
+		return __lock_sample_begin();
+
+	return 0;
+}
+
+static __always_inline void lock_sample_end(void *lock, u64 start,
+					    enum lock_sample_type type)
+{
+	if (unlikely(start))
+		__lock_sample_end(lock, start, type);
+}
+
+#else
+
+static inline u64 lock_sample_begin(void)
+{
+	return 0;
+}
+
+static inline void lock_sample_end(void *lock, u64 start,
+				   enum lock_sample_type type)
+{
+}
+
+#endif /* CONFIG_LOCK_CONTENTION_SAMPLE */
+
+#endif /* __LOCKING_LOCK_SAMPLE_H */
@@ -28,6 +28,8 @@
 #include <linux/osq_lock.h>
 #include <linux/delay.h>
 
+#include "lock_sample.h"
+
 /*
  * In the DEBUG case we are using the "NULL fastpath" for mutexes,
  * which forces all calls into the slowpath:
@@ -521,6 +523,7 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 	struct task_struct *task = current;
 	struct mutex_waiter waiter;
 	unsigned long flags;
+	u64 sample;
 	int ret;
 
 	if (use_ww_ctx) {
@@ -531,9 +534,11 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 
 	preempt_disable();
 	mutex_acquire_nest(&lock->dep_map, subclass, 0, nest_lock, ip);
+	sample = lock_sample_begin();
 
 	if (mutex_optimistic_spin(lock, ww_ctx, use_ww_ctx)) {
 		/* got the lock, yay! */
+		lock_sample_end(lock, sample, LOCK_SAMPLE_MUTEX);
 		preempt_enable();
 		return 0;
 	}
@@ -613,6 +618,7 @@ skip_wait:
 	}
 
 	spin_unlock_mutex(&lock->wait_lock, flags);
+	lock_sample_end(lock, sample, LOCK_SAMPLE_MUTEX);
 	preempt_enable();
 	return 0;
 
@@ -31,6 +31,8 @@
 #include <asm/byteorder.h>
 #include <asm/qspinlock.h>
 
+#include "lock_sample.h"
+
 /*
  * The basic principle of a queue-based spinlock can best be understood
  * by studying a classic queue-based spinlock implementation called the
@@ -419,6 +421,7 @@ void queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 {
 	struct mcs_spinlock *prev, *next, *node;
 	u32 old, tail;
+	u64 sample;
 	int idx;
 
 	BUILD_BUG_ON(CONFIG_NR_CPUS >= (1U << _Q_TAIL_CPU_BITS));
@@ -491,6 +494,7 @@ void queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	 * queuing.
 	 */
 queue:
+	sample = lock_sample_begin();
 	node = this_cpu_ptr(&mcs_nodes[0]);
 	idx = node->count++;
 	tail = encode_tail(smp_processor_id(), idx);
@@ -621,6 +625,7 @@ locked:
 	pv_kick_node(lock, next);
 
 release:
+	lock_sample_end(lock, sample, LOCK_SAMPLE_SPIN);
 	/*
 	 * release the node
 	 */
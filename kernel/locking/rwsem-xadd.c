@@ -15,8 +15,12 @@
 #include <linux/export.h>
 #include <linux/sched/rt.h>
 #include <linux/osq_lock.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "rwsem.h"
+#include "lock_sample.h"
 
 /*
  * Guide to the rw_semaphore's count field for common values.
@@ -85,6 +89,7 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 	INIT_LIST_HEAD(&sem->wait_list);
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	sem->owner = NULL;
+	sem->handoff = false;
 	osq_lock_init(&sem->osq);
 #endif
 #ifdef CONFIG_RWSEM_PRIO_AWARE
@@ -94,6 +99,34 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 
 EXPORT_SYMBOL(__init_rwsem);
 
+/*
+ * Contention counters, summed over all CPUs and reported through
+ * <debugfs>/rwsem_stat. Writing to the file resets them.
+ */
+enum rwsem_stat_item {
+	RWSEM_STAT_READ_SPIN_TAKEN,
+	RWSEM_STAT_READ_SLEEP,
+	RWSEM_STAT_WRITE_SPIN_TAKEN,
+	RWSEM_STAT_WRITE_SLEEP,
+	RWSEM_STAT_HANDOFF,
+	RWSEM_STAT_NR,
+};
+
+static const char * const rwsem_stat_names[RWSEM_STAT_NR] = {
+	[RWSEM_STAT_READ_SPIN_TAKEN]	= "read_spin_taken",
+	[RWSEM_STAT_READ_SLEEP]		= "read_sleep",
+	[RWSEM_STAT_WRITE_SPIN_TAKEN]	= "write_spin_taken",
+	[RWSEM_STAT_WRITE_SLEEP]	= "write_sleep",
+	[RWSEM_STAT_HANDOFF]		= "handoff",
+};
+
+static DEFINE_PER_CPU(unsigned long, rwsem_stats[RWSEM_STAT_NR]);
+
+static inline void rwsem_stat_inc(enum rwsem_stat_item item)
+{
+	this_cpu_inc(rwsem_stats[item]);
+}
+
 enum rwsem_wake_type {
 	RWSEM_WAKE_ANY,		/* Wake whatever's at head of wait list */
 	RWSEM_WAKE_READERS,	/* Wake readers only */
@@ -242,12 +275,21 @@ struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 	struct task_struct *tsk = current;
 	WAKE_Q(wake_q);
 	bool is_first_waiter = false;
+	bool was_empty;
+	u64 sample = lock_sample_begin();
+
+	if (rwsem_optimistic_spin_read(sem, &adjustment)) {
+		rwsem_stat_inc(RWSEM_STAT_READ_SPIN_TAKEN);
+		lock_sample_end(sem, sample, LOCK_SAMPLE_RWSEM_READ);
+		return sem;
+	}
 
 	waiter.task = tsk;
 	waiter.type = RWSEM_WAITING_FOR_READ;
 
 	raw_spin_lock_irq(&sem->wait_lock);
-	if (list_empty(&sem->wait_list))
+	was_empty = list_empty(&sem->wait_list);
+	if (was_empty)
 		adjustment += RWSEM_WAITING_BIAS;
 
 	/* is_first_waiter == true means we are first in the queue */
@@ -264,12 +306,12 @@ struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 	 */
 	if (count == RWSEM_WAITING_BIAS ||
 	    (count > RWSEM_WAITING_BIAS &&
-	     (adjustment != -RWSEM_ACTIVE_READ_BIAS ||
-	     is_first_waiter)))
+	     (was_empty || is_first_waiter)))
 		__rwsem_mark_wake(sem, RWSEM_WAKE_ANY, &wake_q);
 
 	raw_spin_unlock_irq(&sem->wait_lock);
 	wake_up_q(&wake_q);
+	rwsem_stat_inc(RWSEM_STAT_READ_SLEEP);
 
 	/* wait to be given the lock */
 	while (true) {
@@ -280,6 +322,7 @@ struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 	}
 
 	__set_task_state(tsk, TASK_RUNNING);
+	lock_sample_end(sem, sample, LOCK_SAMPLE_RWSEM_READ);
 	return sem;
 }
 EXPORT_SYMBOL(rwsem_down_read_failed);
@@ -315,6 +358,17 @@ static inline bool rwsem_try_write_lock(long count, struct rw_semaphore *sem)
 }
 
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
+static inline void rwsem_set_handoff(struct rw_semaphore *sem)
+{
+	WRITE_ONCE(sem->handoff, true);
+	rwsem_stat_inc(RWSEM_STAT_HANDOFF);
+}
+
+static inline void rwsem_clear_handoff(struct rw_semaphore *sem)
+{
+	WRITE_ONCE(sem->handoff, false);
+}
+
 /*
  * Try to acquire write lock before the writer has been put on wait queue.
  */
@@ -326,6 +380,10 @@ static inline bool rwsem_try_write_lock_unqueued(struct rw_semaphore *sem)
 		if (!(count == 0 || count == RWSEM_WAITING_BIAS))
 			return false;
 
+		/* the lock is being handed to the queued writer */
+		if (READ_ONCE(sem->handoff))
+			return false;
+
 		old = atomic_long_cmpxchg_acquire(&sem->count, count,
 				      count + RWSEM_ACTIVE_WRITE_BIAS);
 		if (old == count) {
@@ -337,12 +395,35 @@ static inline bool rwsem_try_write_lock_unqueued(struct rw_semaphore *sem)
 	}
 }
 
+/*
+ * Try to acquire read lock before the reader has been put on wait queue,
+ * only while no writer holds or waits for the lock so that spinning
+ * readers never overtake queued writers.
+ */
+static inline bool rwsem_try_read_lock_unqueued(struct rw_semaphore *sem)
+{
+	long old, count = atomic_long_read(&sem->count);
+
+	while (count >= 0) {
+		old = atomic_long_cmpxchg_acquire(&sem->count, count,
+				      count + RWSEM_ACTIVE_READ_BIAS);
+		if (old == count) {
+			rwsem_set_reader_owned(sem);
+			return true;
+		}
+
+		count = old;
+	}
+
+	return false;
+}
+
 static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 {
 	struct task_struct *owner;
 	bool ret = true;
 
-	if (need_resched())
+	if (need_resched() || READ_ONCE(sem->handoff))
 		return false;
 
 	rcu_read_lock();
@@ -450,6 +531,62 @@ done:
 	return taken;
 }
 
+/*
+ * Spin while a running writer owns the lock and take the read lock when
+ * it is released, instead of sleeping for as long as the writer section
+ * lasts. The reader stops actively locking first, as a spinning writer
+ * does, and *adjustment is updated accordingly for the sleeping path.
+ */
+static bool rwsem_optimistic_spin_read(struct rw_semaphore *sem,
+				       long *adjustment)
+{
+	bool taken = false;
+	long count;
+
+	preempt_disable();
+
+	/* with waiters queued the read lock can't be taken unqueued */
+	if (!list_empty(&sem->wait_list) || !rwsem_can_spin_on_owner(sem) ||
+	    !rwsem_owner_is_writer(READ_ONCE(sem->owner)))
+		goto done;
+
+	count = atomic_long_add_return(-RWSEM_ACTIVE_READ_BIAS, &sem->count);
+	*adjustment = 0;
+
+	/*
+	 * Like up_read(), dropping the last active bias with waiters queued
+	 * requires a wakeup, which the sleeping path does.
+	 */
+	if (count < 0 && !(count & RWSEM_ACTIVE_MASK))
+		goto done;
+
+	if (!osq_lock(&sem->osq))
+		goto done;
+
+	while (rwsem_spin_on_owner(sem)) {
+		if (rwsem_try_read_lock_unqueued(sem)) {
+			taken = true;
+			break;
+		}
+
+		if (!list_empty(&sem->wait_list))
+			break;
+
+		if (!sem->owner && (need_resched() || rt_task(current)))
+			break;
+
+		cpu_relax_lowlatency();
+	}
+	osq_unlock(&sem->osq);
+
+	/* the writer may have just handed over to other readers */
+	if (!taken)
+		taken = rwsem_try_read_lock_unqueued(sem);
+done:
+	preempt_enable();
+	return taken;
+}
+
 /*
  * Return true if the rwsem has active spinner
  */
@@ -459,11 +596,25 @@ static inline bool rwsem_has_spinner(struct rw_semaphore *sem)
 }
 
 #else
+static inline void rwsem_set_handoff(struct rw_semaphore *sem)
+{
+}
+
+static inline void rwsem_clear_handoff(struct rw_semaphore *sem)
+{
+}
+
 static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 {
 	return false;
 }
 
+static bool rwsem_optimistic_spin_read(struct rw_semaphore *sem,
+				       long *adjustment)
+{
+	return false;
+}
+
 static inline bool rwsem_has_spinner(struct rw_semaphore *sem)
 {
 	return false;
@@ -478,17 +629,22 @@ __rwsem_down_write_failed_common(struct rw_semaphore *sem, int state)
 {
 	long count;
 	bool waiting = true; /* any queued threads before us */
+	bool handoff = false;
 	struct rwsem_waiter waiter;
 	struct rw_semaphore *ret = sem;
 	WAKE_Q(wake_q);
 	bool is_first_waiter = false;
+	u64 sample = lock_sample_begin();
 
 	/* undo write bias from down_write operation, stop active locking */
 	count = atomic_long_sub_return(RWSEM_ACTIVE_WRITE_BIAS, &sem->count);
 
 	/* do optimistic spinning and steal lock if possible */
-	if (rwsem_optimistic_spin(sem))
+	if (rwsem_optimistic_spin(sem)) {
+		rwsem_stat_inc(RWSEM_STAT_WRITE_SPIN_TAKEN);
+		lock_sample_end(sem, sample, LOCK_SAMPLE_RWSEM_WRITE);
 		return sem;
+	}
 
 	/*
 	 * Optimistic spinning failed, proceed to the slowpath
@@ -496,6 +652,8 @@ __rwsem_down_write_failed_common(struct rw_semaphore *sem, int state)
 	 */
 	waiter.task = current;
 	waiter.type = RWSEM_WAITING_FOR_WRITE;
+	waiter.timeout = jiffies + RWSEM_WAIT_TIMEOUT;
+	rwsem_stat_inc(RWSEM_STAT_WRITE_SLEEP);
 
 	raw_spin_lock_irq(&sem->wait_lock);
 
@@ -552,10 +710,24 @@ __rwsem_down_write_failed_common(struct rw_semaphore *sem, int state)
 		} while ((count = atomic_long_read(&sem->count)) & RWSEM_ACTIVE_MASK);
 
 		raw_spin_lock_irq(&sem->wait_lock);
+
+		/*
+		 * Starved at the head of the queue, stop spinners from
+		 * stealing the lock until it has been handed to us.
+		 */
+		if (!handoff && time_after(jiffies, waiter.timeout) &&
+		    list_first_entry(&sem->wait_list, struct rwsem_waiter,
+				     list) == &waiter) {
+			rwsem_set_handoff(sem);
+			handoff = true;
+		}
 	}
 	__set_current_state(TASK_RUNNING);
 	list_del(&waiter.list);
+	if (handoff)
+		rwsem_clear_handoff(sem);
 	raw_spin_unlock_irq(&sem->wait_lock);
+	lock_sample_end(sem, sample, LOCK_SAMPLE_RWSEM_WRITE);
 
 	return ret;
 
@@ -563,6 +735,8 @@ out_nolock:
 	__set_current_state(TASK_RUNNING);
 	raw_spin_lock_irq(&sem->wait_lock);
 	list_del(&waiter.list);
+	if (handoff)
+		rwsem_clear_handoff(sem);
 	if (list_empty(&sem->wait_list))
 		atomic_long_add(-RWSEM_WAITING_BIAS, &sem->count);
 	else
@@ -689,3 +863,53 @@ struct rw_semaphore *rwsem_downgrade_wake(struct rw_semaphore *sem)
 	return sem;
 }
 EXPORT_SYMBOL(rwsem_downgrade_wake);
+
+#ifdef CONFIG_DEBUG_FS
+static int rwsem_stat_show(struct seq_file *m, void *v)
+{
+	unsigned long sum;
+	int i, cpu;
+
+	for (i = 0; i < RWSEM_STAT_NR; i++) {
+		sum = 0;
+		for_each_possible_cpu(cpu)
+			sum += per_cpu(rwsem_stats[i], cpu);
+		seq_printf(m, "%-18s %lu\n", rwsem_stat_names[i], sum);
+	}
+
+	return 0;
+}
+
+static ssize_t rwsem_stat_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	int i, cpu;
+
+	for_each_possible_cpu(cpu)
+		for (i = 0; i < RWSEM_STAT_NR; i++)
+			per_cpu(rwsem_stats[i], cpu) = 0;
+
+	return count;
+}
+
+static int rwsem_stat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rwsem_stat_show, NULL);
+}
+
+static const struct file_operations rwsem_stat_fops = {
+	.open		= rwsem_stat_open,
+	.read		= seq_read,
+	.write		= rwsem_stat_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init rwsem_stat_init(void)
+{
+	debugfs_create_file("rwsem_stat", 0600, NULL, NULL, &rwsem_stat_fops);
+
+	return 0;
+}
+fs_initcall(rwsem_stat_init);
+#endif /* CONFIG_DEBUG_FS */
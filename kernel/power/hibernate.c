@@ -233,8 +233,10 @@ static void platform_recover(int platform_mode)
  * @stop: Final event.
  * @nr_pages: Number of memory pages processed between @start and @stop.
  * @msg: Additional diagnostic message to print.
+ *
+ * Returns the throughput in kbytes per second.
  */
-void swsusp_show_speed(ktime_t start, ktime_t stop,
+unsigned int swsusp_show_speed(ktime_t start, ktime_t stop,
 		      unsigned nr_pages, char *msg)
 {
 	ktime_t diff;
@@ -254,6 +256,7 @@ void swsusp_show_speed(ktime_t start, ktime_t stop,
 			msg, k,
 			centisecs / 100, centisecs % 100,
 			kps / 1000, (kps % 1000) / 10);
+	return kps;
 }
 
 __weak int arch_resume_nosmt(void)
@@ -735,10 +738,13 @@ int hibernate(void)
 
 		if (hibernation_mode == HIBERNATION_PLATFORM)
 			flags |= SF_PLATFORM_MODE;
-		if (nocompress)
+		if (nocompress) {
 			flags |= SF_NOCOMPRESS_MODE;
-		else
+		} else {
 		        flags |= SF_CRC32_MODE;
+			if (IS_ENABLED(CONFIG_HIBERNATION_LZ4))
+				flags |= SF_LZ4_MODE;
+		}
 
 		pr_debug("PM: writing image.\n");
 		error = swsusp_write(flags);
@@ -169,6 +169,7 @@ extern int swsusp_swap_in_use(void);
 #define SF_PLATFORM_MODE	1
 #define SF_NOCOMPRESS_MODE	2
 #define SF_CRC32_MODE	        4
+#define SF_LZ4_MODE		8
 
 /* kernel/power/hibernate.c */
 extern int swsusp_check(void);
@@ -182,7 +183,7 @@ extern int swsusp_unmark(void);
 
 struct timeval;
 /* kernel/power/swsusp.c */
-extern void swsusp_show_speed(ktime_t, ktime_t, unsigned int, char *);
+extern unsigned int swsusp_show_speed(ktime_t, ktime_t, unsigned int, char *);
 
 #ifdef CONFIG_SUSPEND
 /* kernel/power/suspend.c */
@@ -267,12 +267,30 @@ static const struct file_operations pm_qos_debug_fops = {
 	.release        = single_release,
 };
 
+static inline void pm_qos_set_value_for_cpu(struct pm_qos_constraints *c,
+		int cpu, s32 value, struct cpumask *cpus)
+{
+	if (c->target_per_cpu[cpu] == value)
+		return;
+
+	/* idle entry reads the per cpu values without the lock */
+	WRITE_ONCE(c->target_per_cpu[cpu], value);
+	cpumask_set_cpu(cpu, cpus);
+}
+
+/*
+ * Recompute the per cpu values of the cpus in @dirty, only those can be
+ * affected by the request that was changed. The list is sorted, so for
+ * PM_QOS_MIN and PM_QOS_MAX a cpu is done with the first request, from the
+ * respective end, that covers it.
+ */
 static inline int pm_qos_set_value_for_cpus(struct pm_qos_constraints *c,
-		struct cpumask *cpus)
+		const struct cpumask *dirty, struct cpumask *cpus)
 {
 	struct pm_qos_request *req = NULL;
+	struct cpumask pending, affected;
+	s32 qos_val[NR_CPUS], val;
 	int cpu;
-	s32 qos_val[NR_CPUS] = { [0 ... (NR_CPUS - 1)] = c->default_value };
 
 	/*
 	 * pm_qos_constraints can be from different classes,
@@ -282,50 +300,66 @@ static inline int pm_qos_set_value_for_cpus(struct pm_qos_constraints *c,
 	if (c != pm_qos_array[PM_QOS_CPU_DMA_LATENCY]->constraints)
 		return -EINVAL;
 
-	plist_for_each_entry(req, &c->list, node) {
-		for_each_cpu(cpu, &req->cpus_affine) {
-			switch (c->type) {
-			case PM_QOS_MIN:
-				if (qos_val[cpu] > req->node.prio)
-					qos_val[cpu] = req->node.prio;
-				break;
-			case PM_QOS_MAX:
-				if (req->node.prio > qos_val[cpu])
-					qos_val[cpu] = req->node.prio;
-				break;
-			case PM_QOS_SUM:
-					qos_val[cpu] += req->node.prio;
+	cpumask_and(&pending, dirty, cpu_possible_mask);
+
+	switch (c->type) {
+	case PM_QOS_MIN:
+		plist_for_each_entry(req, &c->list, node) {
+			if (!cpumask_and(&affected, &pending,
+					 &req->cpus_affine))
+				continue;
+			val = min_t(s32, req->node.prio, c->default_value);
+			for_each_cpu(cpu, &affected)
+				pm_qos_set_value_for_cpu(c, cpu, val, cpus);
+			cpumask_andnot(&pending, &pending, &affected);
+			if (cpumask_empty(&pending))
 				break;
-			default:
-				BUG();
+		}
+		break;
+	case PM_QOS_MAX:
+		list_for_each_entry_reverse(req, &c->list.node_list,
+					    node.node_list) {
+			if (!cpumask_and(&affected, &pending,
+					 &req->cpus_affine))
+				continue;
+			val = max_t(s32, req->node.prio, c->default_value);
+			for_each_cpu(cpu, &affected)
+				pm_qos_set_value_for_cpu(c, cpu, val, cpus);
+			cpumask_andnot(&pending, &pending, &affected);
+			if (cpumask_empty(&pending))
 				break;
-			}
 		}
+		break;
+	case PM_QOS_SUM:
+		for_each_cpu(cpu, &pending)
+			qos_val[cpu] = c->default_value;
+		plist_for_each_entry(req, &c->list, node) {
+			if (!cpumask_and(&affected, &pending,
+					 &req->cpus_affine))
+				continue;
+			for_each_cpu(cpu, &affected)
+				qos_val[cpu] += req->node.prio;
+		}
+		for_each_cpu(cpu, &pending)
+			pm_qos_set_value_for_cpu(c, cpu, qos_val[cpu], cpus);
+		cpumask_clear(&pending);
+		break;
+	default:
+		BUG();
+		break;
 	}
 
-	for_each_possible_cpu(cpu) {
-		if (c->target_per_cpu[cpu] != qos_val[cpu])
-			cpumask_set_cpu(cpu, cpus);
-		c->target_per_cpu[cpu] = qos_val[cpu];
-	}
+	/* cpus without any request fall back to the default */
+	for_each_cpu(cpu, &pending)
+		pm_qos_set_value_for_cpu(c, cpu, c->default_value, cpus);
 
 	return 0;
 }
 
-/**
- * pm_qos_update_target - manages the constraints list and calls the notifiers
- *  if needed
- * @c: constraints data struct
- * @req: request to add to the list, to update or to remove
- * @action: action to take on the constraints list
- * @value: value of the request to add or update
- *
- * This function returns 1 if the aggregated constraint value has changed, 0
- *  otherwise.
- */
-int pm_qos_update_target(struct pm_qos_constraints *c,
-				struct pm_qos_request *req,
-				enum pm_qos_req_action action, int value)
+static int __pm_qos_update_target(struct pm_qos_constraints *c,
+				  struct pm_qos_request *req,
+				  enum pm_qos_req_action action, int value,
+				  const struct cpumask *dirty)
 {
 	unsigned long flags;
 	int prev_value, curr_value, new_value;
@@ -363,7 +397,7 @@ int pm_qos_update_target(struct pm_qos_constraints *c,
 	curr_value = pm_qos_get_value(c);
 	cpumask_clear(&cpus);
 	pm_qos_set_value(c, curr_value);
-	ret = pm_qos_set_value_for_cpus(c, &cpus);
+	ret = pm_qos_set_value_for_cpus(c, dirty, &cpus);
 
 	spin_unlock_irqrestore(&pm_qos_lock, flags);
 
@@ -386,6 +420,25 @@ int pm_qos_update_target(struct pm_qos_constraints *c,
 	return ret;
 }
 
+/**
+ * pm_qos_update_target - manages the constraints list and calls the notifiers
+ *  if needed
+ * @c: constraints data struct
+ * @req: request to add to the list, to update or to remove
+ * @action: action to take on the constraints list
+ * @value: value of the request to add or update
+ *
+ * This function returns 1 if the aggregated constraint value has changed, 0
+ *  otherwise.
+ */
+int pm_qos_update_target(struct pm_qos_constraints *c,
+				struct pm_qos_request *req,
+				enum pm_qos_req_action action, int value)
+{
+	return __pm_qos_update_target(c, req, action, value,
+				      &req->cpus_affine);
+}
+
 /**
  * pm_qos_flags_remove_req - Remove device PM QoS flags request.
  * @pqf: Device PM QoS flags set to remove the request from.
@@ -462,12 +515,21 @@ int pm_qos_request(int pm_qos_class)
 }
 EXPORT_SYMBOL_GPL(pm_qos_request);
 
+/**
+ * pm_qos_request_for_cpu - returns the current qos expectation of a cpu
+ * @pm_qos_class: identification of which qos value is requested
+ * @cpu: the cpu
+ *
+ * The value is aggregated on update, so this is cheap enough to be called
+ * on every idle entry.
+ */
 int pm_qos_request_for_cpu(int pm_qos_class, int cpu)
 {
 	if (cpu_isolated(cpu))
 		return INT_MAX;
 
-	return pm_qos_array[pm_qos_class]->constraints->target_per_cpu[cpu];
+	return READ_ONCE(
+		pm_qos_array[pm_qos_class]->constraints->target_per_cpu[cpu]);
 }
 EXPORT_SYMBOL(pm_qos_request_for_cpu);
 
@@ -477,34 +539,40 @@ int pm_qos_request_active(struct pm_qos_request *req)
 }
 EXPORT_SYMBOL_GPL(pm_qos_request_active);
 
+/**
+ * pm_qos_request_for_cpumask - returns the qos expectation of a set of cpus
+ * @pm_qos_class: identification of which qos value is requested
+ * @mask: the cpus, e.g. the online cpus of a cluster
+ *
+ * Aggregates the per cpu values without taking the lock, a concurrent
+ * update is seen either before or after for every cpu.
+ */
 int pm_qos_request_for_cpumask(int pm_qos_class, struct cpumask *mask)
 {
-	unsigned long irqflags;
 	int cpu;
 	struct pm_qos_constraints *c = NULL;
-	int val;
+	int val, cpu_val;
 
-	spin_lock_irqsave(&pm_qos_lock, irqflags);
 	c = pm_qos_array[pm_qos_class]->constraints;
 	val = c->default_value;
 
 	for_each_cpu(cpu, mask) {
+		cpu_val = READ_ONCE(c->target_per_cpu[cpu]);
 
 		switch (c->type) {
 		case PM_QOS_MIN:
-			if (c->target_per_cpu[cpu] < val)
-				val = c->target_per_cpu[cpu];
+			if (cpu_val < val)
+				val = cpu_val;
 			break;
 		case PM_QOS_MAX:
-			if (c->target_per_cpu[cpu] > val)
-				val = c->target_per_cpu[cpu];
+			if (cpu_val > val)
+				val = cpu_val;
 			break;
 		default:
 			BUG();
 			break;
 		}
 	}
-	spin_unlock_irqrestore(&pm_qos_lock, irqflags);
 
 	return val;
 }
@@ -562,12 +630,16 @@ static void pm_qos_irq_notify(struct irq_affinity_notify *notify,
 					struct pm_qos_request, irq_notify);
 	struct pm_qos_constraints *c =
 				pm_qos_array[req->pm_qos_class]->constraints;
+	struct cpumask dirty;
 
+	/* the cpus the irq moves away from need recomputing as well */
 	spin_lock_irqsave(&pm_qos_lock, flags);
+	cpumask_or(&dirty, &req->cpus_affine, mask);
 	cpumask_copy(&req->cpus_affine, mask);
 	spin_unlock_irqrestore(&pm_qos_lock, flags);
 
-	pm_qos_update_target(c, req, PM_QOS_UPDATE_REQ, req->node.prio);
+	__pm_qos_update_target(c, req, PM_QOS_UPDATE_REQ, req->node.prio,
+			       &dirty);
 }
 #endif
 
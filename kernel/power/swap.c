@@ -25,6 +25,7 @@
 #include <linux/pm.h>
 #include <linux/slab.h>
 #include <linux/lzo.h>
+#include <linux/lz4.h>
 #include <linux/vmalloc.h>
 #include <linux/cpumask.h>
 #include <linux/atomic.h>
@@ -44,6 +45,10 @@
 static bool clean_pages_on_read;
 static bool clean_pages_on_decompress;
 
+/* Throughput of the last image write, recorded in the image header. */
+static unsigned int hib_write_kbps;
+static unsigned int hib_read_kbps;
+
 /*
  *	The swap map is a data structure used for keeping track of each page
  *	written to a swap partition.  It consists of many swap_map_page
@@ -104,7 +109,8 @@ struct swap_map_handle {
 
 struct swsusp_header {
 	char reserved[PAGE_SIZE - 20 - sizeof(sector_t) - sizeof(int) -
-	              sizeof(u32)];
+	              2 * sizeof(u32)];
+	u32	write_kbps;	/* Throughput the image was saved with */
 	u32	crc32;
 	sector_t image;
 	unsigned int flags;	/* Flags to pass to the "boot" kernel */
@@ -315,6 +321,7 @@ static int mark_swapfiles(struct swap_map_handle *handle, unsigned int flags)
 		memcpy(swsusp_header->sig, HIBERNATE_SIG, 10);
 		swsusp_header->image = handle->first_sector;
 		swsusp_header->flags = flags;
+		swsusp_header->write_kbps = hib_write_kbps;
 		if (flags & SF_CRC32_MODE)
 			swsusp_header->crc32 = handle->crc32;
 		error = hib_submit_io(REQ_OP_WRITE, WRITE_SYNC,
@@ -517,6 +524,13 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 			             LZO_HEADER, PAGE_SIZE)
 #define LZO_CMP_SIZE	(LZO_CMP_PAGES * PAGE_SIZE)
 
+/*
+ * The LZ4 worst case is below the LZO one, so the buffers above fit both.
+ * The compression workspace has to fit both as well.
+ */
+#define LZO_WRK_SIZE	(LZO1X_1_MEM_COMPRESS > LZ4_MEM_COMPRESS ? \
+			 LZO1X_1_MEM_COMPRESS : LZ4_MEM_COMPRESS)
+
 /* Maximum number of threads for compression/decompression. */
 #define LZO_THREADS	3
 
@@ -568,7 +582,7 @@ static int save_image(struct swap_map_handle *handle,
 		ret = err2;
 	if (!ret)
 		printk(KERN_INFO "PM: Image saving done.\n");
-	swsusp_show_speed(start, stop, nr_to_write, "Wrote");
+	hib_write_kbps = swsusp_show_speed(start, stop, nr_to_write, "Wrote");
 	return ret;
 }
 
@@ -616,20 +630,21 @@ static int crc32_threadfn(void *data)
 	return 0;
 }
 /**
- * Structure used for LZO data compression.
+ * Structure used for LZO/LZ4 data compression.
  */
 struct cmp_data {
 	struct task_struct *thr;                  /* thread */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
+	bool lz4;                                 /* compress with LZ4 */
 	wait_queue_head_t go;                     /* start compression */
 	wait_queue_head_t done;                   /* compression done */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	unsigned char wrk[LZO_WRK_SIZE];          /* compression workspace */
 };
 
 /**
@@ -651,9 +666,14 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		if (d->lz4)
+			d->ret = lz4_compress(d->unc, d->unc_len,
+					      d->cmp + LZO_HEADER, &d->cmp_len,
+					      d->wrk);
+		else
+			d->ret = lzo1x_1_compress(d->unc, d->unc_len,
+						  d->cmp + LZO_HEADER,
+						  &d->cmp_len, d->wrk);
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -661,15 +681,18 @@ static int lzo_compress_threadfn(void *data)
 }
 
 /**
- * save_image_lzo - Save the suspend image data compressed with LZO.
+ * save_image_lzo - Save the suspend image data compressed with LZO or LZ4.
  * @handle: Swap map handle to use for saving the image.
  * @snapshot: Image to read data from.
  * @nr_to_write: Number of pages to save.
+ * @lz4: Compress with LZ4 instead of LZO.
  */
 static int save_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_write)
+                          unsigned int nr_to_write, bool lz4)
 {
+	const char *alg = lz4 ? "LZ4" : "LZO";
+	struct blk_plug plug;
 	unsigned int m;
 	int ret = 0;
 	int nr_pages;
@@ -705,8 +728,10 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct cmp_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -763,9 +788,9 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	handle->reqd_free_pages = reqd_free_pages();
 
 	printk(KERN_INFO
-		"PM: Using %u thread(s) for compression.\n"
+		"PM: Using %u thread(s) for %s compression.\n"
 		"PM: Compressing and saving image data (%u pages)...\n",
-		nr_threads, nr_to_write);
+		nr_threads, alg, nr_to_write);
 	m = nr_to_write / 10;
 	if (!m)
 		m = 1;
@@ -807,6 +832,11 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		atomic_set(&crc->ready, 1);
 		wake_up(&crc->go);
 
+		/*
+		 * Plug the writes of each round so that the consecutive pages
+		 * of the compressed chunks reach the device as large requests.
+		 */
+		blk_start_plug(&plug);
 		for (run_threads = thr, thr = 0; thr < run_threads; thr++) {
 			wait_event(data[thr].done,
 			           atomic_read(&data[thr].stop));
@@ -815,17 +845,19 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				printk(KERN_ERR "PM: LZO compression failed\n");
-				goto out_finish;
+				printk(KERN_ERR "PM: %s compression failed\n",
+				       alg);
+				break;
 			}
 
 			if (unlikely(!data[thr].cmp_len ||
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(data[thr].unc_len))) {
 				printk(KERN_ERR
-				       "PM: Invalid LZO compressed length\n");
+				       "PM: Invalid %s compressed length\n",
+				       alg);
 				ret = -1;
-				goto out_finish;
+				break;
 			}
 
 			*(size_t *)data[thr].cmp = data[thr].cmp_len;
@@ -845,9 +877,14 @@ static int save_image_lzo(struct swap_map_handle *handle,
 
 				ret = swap_write_page(handle, page, &hb);
 				if (ret)
-					goto out_finish;
+					break;
 			}
+			if (ret)
+				break;
 		}
+		blk_finish_plug(&plug);
+		if (ret)
+			goto out_finish;
 
 		wait_event(crc->done, atomic_read(&crc->stop));
 		atomic_set(&crc->stop, 0);
@@ -860,7 +897,7 @@ out_finish:
 		ret = err2;
 	if (!ret)
 		printk(KERN_INFO "PM: Image saving done.\n");
-	swsusp_show_speed(start, stop, nr_to_write, "Wrote");
+	hib_write_kbps = swsusp_show_speed(start, stop, nr_to_write, "Wrote");
 out_clean:
 	if (crc) {
 		if (crc->thr)
@@ -940,7 +977,8 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_image_lzo(&handle, &snapshot, pages - 1,
+				       flags & SF_LZ4_MODE);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -1104,18 +1142,19 @@ static int load_image(struct swap_map_handle *handle,
 		if (!snapshot_image_loaded(snapshot))
 			ret = -ENODATA;
 	}
-	swsusp_show_speed(start, stop, nr_to_read, "Read");
+	hib_read_kbps = swsusp_show_speed(start, stop, nr_to_read, "Read");
 	return ret;
 }
 
 /**
- * Structure used for LZO data decompression.
+ * Structure used for LZO/LZ4 data decompression.
  */
 struct dec_data {
 	struct task_struct *thr;                  /* thread */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
+	bool lz4;                                 /* decompress with LZ4 */
 	wait_queue_head_t go;                     /* start decompression */
 	wait_queue_head_t done;                   /* decompression done */
 	size_t unc_len;                           /* uncompressed length */
@@ -1144,8 +1183,14 @@ static int lzo_decompress_threadfn(void *data)
 		atomic_set(&d->ready, 0);
 
 		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		if (d->lz4)
+			d->ret = lz4_decompress_unknownoutputsize(
+					d->cmp + LZO_HEADER, d->cmp_len,
+					d->unc, &d->unc_len);
+		else
+			d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER,
+						       d->cmp_len, d->unc,
+						       &d->unc_len);
 		if (clean_pages_on_decompress)
 			flush_icache_range((unsigned long)d->unc,
 					   (unsigned long)d->unc + d->unc_len);
@@ -1157,15 +1202,19 @@ static int lzo_decompress_threadfn(void *data)
 }
 
 /**
- * load_image_lzo - Load compressed image data and decompress them with LZO.
+ * load_image_lzo - Load compressed image data and decompress them with LZO
+ * or LZ4.
  * @handle: Swap map handle to use for loading data.
  * @snapshot: Image to copy uncompressed data into.
  * @nr_to_read: Number of pages to load.
+ * @lz4: The image was compressed with LZ4 instead of LZO.
  */
 static int load_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_read)
+                          unsigned int nr_to_read, bool lz4)
 {
+	const char *alg = lz4 ? "LZ4" : "LZO";
+	struct blk_plug plug;
 	unsigned int m;
 	int ret = 0;
 	int eof = 0;
@@ -1204,8 +1253,10 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct dec_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -1289,9 +1340,9 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	want = ring_size = i;
 
 	printk(KERN_INFO
-		"PM: Using %u thread(s) for decompression.\n"
+		"PM: Using %u thread(s) for %s decompression.\n"
 		"PM: Loading and decompressing image data (%u pages)...\n",
-		nr_threads, nr_to_read);
+		nr_threads, alg, nr_to_read);
 	m = nr_to_read / 10;
 	if (!m)
 		m = 1;
@@ -1303,6 +1354,11 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		goto out_finish;
 
 	for(;;) {
+		/*
+		 * Plug the read-ahead so that consecutive swap pages reach the
+		 * device as large requests.
+		 */
+		blk_start_plug(&plug);
 		for (i = 0; !eof && i < want; i++) {
 			ret = swap_read_page(handle, page[ring], &hb);
 			if (ret) {
@@ -1312,6 +1368,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 				 */
 				if (handle->cur &&
 				    handle->cur->entries[handle->k]) {
+					blk_finish_plug(&plug);
 					goto out_finish;
 				} else {
 					eof = 1;
@@ -1321,6 +1378,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			if (++ring >= ring_size)
 				ring = 0;
 		}
+		blk_finish_plug(&plug);
 		asked += i;
 		want -= i;
 
@@ -1352,7 +1410,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(LZO_UNC_SIZE))) {
 				printk(KERN_ERR
-				       "PM: Invalid LZO compressed length\n");
+				       "PM: Invalid %s compressed length\n",
+				       alg);
 				ret = -1;
 				goto out_finish;
 			}
@@ -1404,7 +1463,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 
 			if (ret < 0) {
 				printk(KERN_ERR
-				       "PM: LZO decompression failed\n");
+				       "PM: %s decompression failed\n", alg);
 				goto out_finish;
 			}
 
@@ -1412,7 +1471,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			             data[thr].unc_len > LZO_UNC_SIZE ||
 			             data[thr].unc_len & (PAGE_SIZE - 1))) {
 				printk(KERN_ERR
-				       "PM: Invalid LZO uncompressed length\n");
+				       "PM: Invalid %s uncompressed length\n",
+				       alg);
 				ret = -1;
 				goto out_finish;
 			}
@@ -1466,7 +1526,7 @@ out_finish:
 			}
 		}
 	}
-	swsusp_show_speed(start, stop, nr_to_read, "Read");
+	hib_read_kbps = swsusp_show_speed(start, stop, nr_to_read, "Read");
 out_clean:
 	for (i = 0; i < ring_size; i++)
 		free_page((unsigned long)page[i]);
@@ -1509,15 +1569,28 @@ int swsusp_read(unsigned int *flags_p)
 		goto end;
 	if (!error)
 		error = swap_read_page(&handle, header, NULL);
+	if (!error && (*flags_p & SF_LZ4_MODE) &&
+	    !IS_ENABLED(CONFIG_HIBERNATION_LZ4)) {
+		printk(KERN_ERR "PM: Image is LZ4 compressed, "
+		       "LZ4 support is not enabled\n");
+		error = -EINVAL;
+	}
 	if (!error) {
 		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
 			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+			load_image_lzo(&handle, &snapshot, header->pages - 1,
+				       *flags_p & SF_LZ4_MODE);
 	}
 	swap_reader_finish(&handle);
 end:
-	if (!error)
+	if (!error) {
 		pr_debug("PM: Image successfully loaded\n");
+		printk(KERN_INFO "PM: Image written at %u.%02u MB/s, "
+		       "read at %u.%02u MB/s\n",
+		       swsusp_header->write_kbps / 1000,
+		       (swsusp_header->write_kbps % 1000) / 10,
+		       hib_read_kbps / 1000, (hib_read_kbps % 1000) / 10);
+	}
 	else
 		pr_debug("PM: Error %d resuming\n", error);
 	return error;
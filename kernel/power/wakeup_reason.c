@@ -29,6 +29,7 @@
 
 
 #define MAX_WAKEUP_REASON_IRQS 32
+#define MAX_RESUME_DEVICES 8
 static int irq_list[MAX_WAKEUP_REASON_IRQS];
 static int irqcount;
 static bool suspend_abort;
@@ -36,6 +37,17 @@ static char abort_reason[MAX_SUSPEND_ABORT_LEN];
 static struct kobject *wakeup_reason;
 static DEFINE_SPINLOCK(resume_reason_lock);
 
+/* slowest device resume callbacks of the last resume, slowest first */
+struct resume_device_time {
+	char name[32];
+	const char *info;
+	s64 usecs;
+};
+static struct resume_device_time resume_devices[MAX_RESUME_DEVICES];
+static int resume_device_count;
+static s64 resume_devices_total_us;
+static DEFINE_SPINLOCK(resume_device_lock);
+
 static ktime_t last_monotime; /* monotonic time before last suspend */
 static ktime_t curr_monotime; /* monotonic time after last suspend */
 static ktime_t last_stime; /* monotonic boottime offset before last suspend */
@@ -92,12 +104,31 @@ static ssize_t last_suspend_time_show(struct kobject *kobj,
 				sleep_time.tv_sec, sleep_time.tv_nsec);
 }
 
+static ssize_t last_resume_devices_show(struct kobject *kobj,
+			struct kobj_attribute *attr, char *buf)
+{
+	int i, buf_offset;
+	unsigned long flags;
+
+	spin_lock_irqsave(&resume_device_lock, flags);
+	buf_offset = sprintf(buf, "total %lld us\n", resume_devices_total_us);
+	for (i = 0; i < resume_device_count; i++)
+		buf_offset += sprintf(buf + buf_offset, "%lld us %s %sresume\n",
+				resume_devices[i].usecs, resume_devices[i].name,
+				resume_devices[i].info);
+	spin_unlock_irqrestore(&resume_device_lock, flags);
+	return buf_offset;
+}
+
 static struct kobj_attribute resume_reason = __ATTR_RO(last_resume_reason);
 static struct kobj_attribute suspend_time = __ATTR_RO(last_suspend_time);
+static struct kobj_attribute resume_devices_attr =
+	__ATTR_RO(last_resume_devices);
 
 static struct attribute *attrs[] = {
 	&resume_reason.attr,
 	&suspend_time.attr,
+	&resume_devices_attr.attr,
 	NULL,
 };
 static struct attribute_group attr_group = {
@@ -164,6 +195,35 @@ void log_suspend_abort_reason(const char *fmt, ...)
 	spin_unlock(&resume_reason_lock);
 }
 
+/*
+ * Called by the PM core after every resume callback of a device. Devices
+ * resumed asynchronously report from several threads at once, so the sum
+ * is the time spent in callbacks rather than the time the resume took.
+ */
+void log_resume_device_time(const char *name, const char *info, s64 usecs)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&resume_device_lock, flags);
+	resume_devices_total_us += usecs;
+	for (i = resume_device_count; i > 0; i--) {
+		if (resume_devices[i - 1].usecs >= usecs)
+			break;
+		if (i < MAX_RESUME_DEVICES)
+			resume_devices[i] = resume_devices[i - 1];
+	}
+	if (i < MAX_RESUME_DEVICES) {
+		strlcpy(resume_devices[i].name, name,
+			sizeof(resume_devices[i].name));
+		resume_devices[i].info = info ?: "";
+		resume_devices[i].usecs = usecs;
+		if (resume_device_count < MAX_RESUME_DEVICES)
+			resume_device_count++;
+	}
+	spin_unlock_irqrestore(&resume_device_lock, flags);
+}
+
 /* Detects a suspend and clears all the previous wake up reasons*/
 static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		unsigned long pm_event, void *unused)
@@ -174,6 +234,10 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		irqcount = 0;
 		suspend_abort = false;
 		spin_unlock(&resume_reason_lock);
+		spin_lock_irq(&resume_device_lock);
+		resume_device_count = 0;
+		resume_devices_total_us = 0;
+		spin_unlock_irq(&resume_device_lock);
 		/* monotonic time since boot */
 		last_monotime = ktime_get();
 		/* monotonic time since boot including the time spent in suspend */
@@ -184,6 +248,12 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		curr_monotime = ktime_get();
 		/* monotonic time since boot including the time spent in suspend */
 		curr_stime = ktime_get_boottime();
+		spin_lock_irq(&resume_device_lock);
+		if (resume_device_count)
+			pr_info("Resume slowest device %s: %lld us of %lld us\n",
+				resume_devices[0].name, resume_devices[0].usecs,
+				resume_devices_total_us);
+		spin_unlock_irq(&resume_device_lock);
 		break;
 	default:
 		break;
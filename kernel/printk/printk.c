@@ -42,6 +42,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/utsname.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
@@ -1734,6 +1735,25 @@ static size_t log_output(int facility, int level, enum log_flags lflags, const c
 	return log_store(facility, level, lflags, 0, dict, dictlen, text, text_len);
 }
 
+/*
+ * Console output is normally handed to the printk kthread, so that the
+ * caller of printk() never writes to slow consoles itself. Emergency
+ * messages, oopses and boot/shutdown output are still printed directly.
+ */
+static bool printk_offload = true;
+module_param_named(offload, printk_offload, bool, S_IRUGO | S_IWUSR);
+
+static struct task_struct *printk_kthread;
+
+static void printk_kick_console(void);
+
+static bool printk_can_offload(int level)
+{
+	return READ_ONCE(printk_offload) && printk_kthread &&
+		!oops_in_progress && system_state == SYSTEM_RUNNING &&
+		level != LOGLEVEL_EMERG;
+}
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -1858,7 +1878,9 @@ asmlinkage int vprintk_emit(int facility, int level,
 	local_irq_restore(flags);
 
 	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched) {
+	if (!in_sched && printk_can_offload(level)) {
+		printk_kick_console();
+	} else if (!in_sched) {
 		lockdep_off();
 		/*
 		 * Try to acquire and then immediately release the console
@@ -2840,14 +2862,20 @@ late_initcall(printk_late_init);
 
 static DEFINE_PER_CPU(int, printk_pending);
 
+static bool printk_kthread_pending;
+
 static void wake_up_klogd_work_func(struct irq_work *irq_work)
 {
 	int pending = __this_cpu_xchg(printk_pending, 0);
 
 	if (pending & PRINTK_PENDING_OUTPUT) {
-		/* If trylock fails, someone else is doing the printing */
-		if (console_trylock())
+		if (printk_kthread && READ_ONCE(printk_offload)) {
+			WRITE_ONCE(printk_kthread_pending, true);
+			wake_up_process(printk_kthread);
+		} else if (console_trylock()) {
+			/* If trylock fails, someone else is doing the printing */
 			console_unlock();
+		}
 	}
 
 	if (pending & PRINTK_PENDING_WAKEUP)
@@ -2869,6 +2897,50 @@ void wake_up_klogd(void)
 	preempt_enable();
 }
 
+/*
+ * Wakeups from printk() context are unsafe, the kthread is woken through
+ * the irq_work instead.
+ */
+static void printk_kick_console(void)
+{
+	preempt_disable();
+	this_cpu_or(printk_pending, PRINTK_PENDING_OUTPUT);
+	irq_work_queue(this_cpu_ptr(&wake_up_klogd_work));
+	preempt_enable();
+}
+
+static int printk_kthread_func(void *data)
+{
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!xchg(&printk_kthread_pending, false)) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		console_lock();
+		console_unlock();
+	}
+
+	return 0;
+}
+
+static int __init printk_kthread_init(void)
+{
+	struct task_struct *tsk;
+
+	tsk = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(tsk)) {
+		pr_err("printk: failed to start console kthread\n");
+		return PTR_ERR(tsk);
+	}
+	printk_kthread = tsk;
+
+	return 0;
+}
+late_initcall(printk_kthread_init);
+
 int printk_deferred(const char *fmt, ...)
 {
 	va_list args;
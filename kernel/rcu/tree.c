@@ -172,6 +172,13 @@ static int kthread_prio = IS_ENABLED(CONFIG_RCU_BOOST) ? 1 : 0;
 #endif /* #else #ifdef CONFIG_RCU_KTHREAD_PRIO */
 module_param(kthread_prio, int, 0644);
 
+/*
+ * Time in microseconds an expedited grace period waits before starting,
+ * so that concurrent synchronize_*_expedited() callers share its IPIs.
+ */
+static int exp_coalesce_us;
+module_param(exp_coalesce_us, int, 0644);
+
 /* Delay in jiffies for grace-period initialization delays, debug only. */
 
 #ifdef CONFIG_RCU_TORTURE_TEST_SLOW_PREINIT
@@ -292,6 +292,17 @@ fastpath:
 		mutex_unlock(&rsp->exp_mutex);
 		return true;
 	}
+
+	/*
+	 * Until the sequence number is advanced, new requesters snapshot
+	 * the same grace period as ours and will wait for it, so holding
+	 * off briefly folds a burst of requests into one round of IPIs.
+	 */
+	if (exp_coalesce_us > 0 &&
+	    rcu_scheduler_active == RCU_SCHEDULER_RUNNING)
+		usleep_range(exp_coalesce_us,
+			     exp_coalesce_us + exp_coalesce_us / 4 + 1);
+
 	rcu_exp_gp_seq_start(rsp);
 	trace_rcu_exp_grace_period(rsp->name, s, TPS("start"));
 	return false;
@@ -59,6 +59,8 @@ DEFINE_PER_CPU(char, rcu_cpu_has_work);
 static cpumask_var_t rcu_nocb_mask; /* CPUs to have callbacks offloaded. */
 static bool have_rcu_nocb_mask;	    /* Was rcu_nocb_mask allocated? */
 static bool __read_mostly rcu_nocb_poll;    /* Offload kthread are to poll. */
+static cpumask_var_t rcu_nocb_affinity; /* CPUs allowed to run rcuo kthreads. */
+static bool have_rcu_nocb_affinity;	/* Was rcu_nocb_affinity allocated? */
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 /*
@@ -1724,6 +1726,24 @@ static int __init parse_rcu_nocb_poll(char *arg)
 }
 early_param("rcu_nocb_poll", parse_rcu_nocb_poll);
 
+/*
+ * Parse the boot-time CPU list that rcuo kthreads are confined to, so
+ * that callbacks of offloaded CPUs are invoked on, for example, the
+ * little cluster instead of waking the big cores.
+ */
+static int __init rcu_nocb_affinity_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_affinity);
+	if (cpulist_parse(str, rcu_nocb_affinity) ||
+	    cpumask_empty(rcu_nocb_affinity)) {
+		pr_warn("rcu_nocb_affinity= %s ignored\n", str);
+		return 1;
+	}
+	have_rcu_nocb_affinity = true;
+	return 1;
+}
+__setup("rcu_nocb_affinity=", rcu_nocb_affinity_setup);
+
 /*
  * Wake up any no-CBs CPUs' kthreads that were waiting on the just-ended
  * grace period.
@@ -2265,6 +2285,9 @@ void __init rcu_init_nohz(void)
 		cpumask_pr_args(rcu_nocb_mask));
 	if (rcu_nocb_poll)
 		pr_info("\tPoll for callbacks from no-CBs CPUs.\n");
+	if (have_rcu_nocb_affinity)
+		pr_info("\tOffloaded callbacks run on CPUs: %*pbl.\n",
+			cpumask_pr_args(rcu_nocb_affinity));
 
 	for_each_rcu_flavor(rsp) {
 		for_each_cpu(cpu, rcu_nocb_mask)
@@ -2326,6 +2349,9 @@ static void rcu_spawn_one_nocb_kthread(struct rcu_state *rsp, int cpu)
 	t = kthread_run(rcu_nocb_kthread, rdp_spawn,
 			"rcuo%c/%d", rsp->abbr, cpu);
 	BUG_ON(IS_ERR(t));
+	if (have_rcu_nocb_affinity &&
+	    cpumask_intersects(rcu_nocb_affinity, cpu_online_mask))
+		set_cpus_allowed_ptr(t, rcu_nocb_affinity);
 	WRITE_ONCE(rdp_spawn->nocb_kthread, t);
 }
 
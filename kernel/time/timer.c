@@ -40,6 +40,7 @@
 #include <linux/irq_work.h>
 #include <linux/sched.h>
 #include <linux/sched/sysctl.h>
+#include <linux/topology.h>
 #include <linux/slab.h>
 #include <linux/compat.h>
 #include <linux/random.h>
@@ -210,6 +211,23 @@ struct timer_base {
 static DEFINE_PER_CPU(struct timer_base, timer_bases[NR_BASES]);
 struct timer_base timer_base_deferrable;
 static atomic_t deferrable_pending;
+/* This CPU owns the next run of timer_base_deferrable */
+static DEFINE_PER_CPU(bool, deferrable_claimed);
+
+/*
+ * Claim the expired global deferrable timers for the calling CPU. Called
+ * with interrupts disabled by any CPU that is awake, so they are run at the
+ * next tick of whichever CPU gets there first.
+ */
+static bool claim_deferrable_base(void)
+{
+	if (time_before(jiffies, timer_base_deferrable.clk) ||
+	    atomic_cmpxchg(&deferrable_pending, 0, 1))
+		return false;
+
+	this_cpu_write(deferrable_claimed, true);
+	return true;
+}
 
 #if defined(CONFIG_SMP) && defined(CONFIG_NO_HZ_COMMON)
 unsigned int sysctl_timer_migration = 1;
@@ -1500,20 +1518,83 @@ static u64 cmp_next_hrtimer_event(u64 basem, u64 expires)
  * are exipired or not. This function does not check cpu bounded
  * diferrable pending timers expiry.
  *
- * The function returns true when a cpu unbounded deferrable timer is expired.
+ * The function returns true when a cpu unbounded deferrable timer is expired
+ * and the current CPU has claimed running them.
  */
 bool check_pending_deferrable_timers(int cpu)
 {
-	if (cpu == tick_do_timer_cpu ||
-		tick_do_timer_cpu == TICK_DO_TIMER_NONE) {
-		if (time_after_eq(jiffies, timer_base_deferrable.clk)
-			&& !atomic_cmpxchg(&deferrable_pending, 0, 1)) {
-			return true;
+	return claim_deferrable_base();
+}
+#endif
+
+#ifdef CONFIG_SMP
+static int timer_find_busy_cpu(int this_cpu)
+{
+	int cpu;
+
+	for_each_cpu_and(cpu, topology_core_cpumask(this_cpu),
+			 cpu_online_mask) {
+		if (cpu == this_cpu || idle_cpu(cpu) ||
+		    READ_ONCE(per_cpu(timer_bases[BASE_STD].is_idle, cpu)))
+			continue;
+		return cpu;
+	}
+
+	return -1;
+}
+
+/*
+ * Called on the way into idle: hand the non-pinned timers of @base to a
+ * CPU of the same cluster that is busy anyway, so that this CPU is not
+ * woken from deep idle just to run them. Arming already prefers a busy
+ * CPU through get_nohz_timer_target(); this covers the timers that were
+ * armed while this CPU was still busy itself.
+ */
+static void timer_migrate_to_busy(struct timer_base *base)
+{
+	struct timer_base *new_base, *first, *second;
+	struct timer_list *timer;
+	struct hlist_node *n;
+	unsigned int i;
+	int cpu;
+
+	if (!base->migration_enabled ||
+	    bitmap_empty(base->pending_map, WHEEL_SIZE))
+		return;
+
+	cpu = timer_find_busy_cpu(base->cpu);
+	if (cpu < 0)
+		return;
+
+	new_base = per_cpu_ptr(&timer_bases[BASE_STD], cpu);
+
+	/* The target may be migrating towards us, lock in address order */
+	first = base < new_base ? base : new_base;
+	second = base < new_base ? new_base : base;
+	spin_lock(&first->lock);
+	spin_lock_nested(&second->lock, SINGLE_DEPTH_NESTING);
+
+	/* It may have gone idle meanwhile */
+	if (new_base->is_idle)
+		goto unlock;
+
+	forward_timer_base(new_base);
+	for_each_set_bit(i, base->pending_map, WHEEL_SIZE) {
+		hlist_for_each_entry_safe(timer, n, base->vectors + i, entry) {
+			if (timer->flags & TIMER_PINNED)
+				continue;
+
+			detach_if_pending(timer, base, false);
+			timer->flags = (timer->flags & ~TIMER_BASEMASK) | cpu;
+			internal_add_timer(new_base, timer);
 		}
 	}
-	return false;
+
+unlock:
+	spin_unlock(&second->lock);
+	spin_unlock(&first->lock);
 }
-#endif
+#endif /* CONFIG_SMP */
 
 /**
  * get_next_timer_interrupt - return the time (clock mono) of the next timer
@@ -1537,6 +1618,11 @@ u64 get_next_timer_interrupt(unsigned long basej, u64 basem)
 	if (cpu_is_offline(smp_processor_id()))
 		return expires;
 
+#ifdef CONFIG_SMP
+	if (is_idle_task(current))
+		timer_migrate_to_busy(base);
+#endif
+
 	spin_lock(&base->lock);
 	nextevt = __next_timer_interrupt(base);
 	is_max_delta = (nextevt == base->clk + NEXT_TIMER_MAX_DELTA);
@@ -1701,10 +1787,11 @@ static __latent_entropy void run_timer_softirq(struct softirq_action *h)
 	if (IS_ENABLED(CONFIG_NO_HZ_COMMON))
 		__run_timers(this_cpu_ptr(&timer_bases[BASE_DEF]));
 
-	if ((atomic_cmpxchg(&deferrable_pending, 1, 0) &&
-		tick_do_timer_cpu == TICK_DO_TIMER_NONE) ||
-		tick_do_timer_cpu == smp_processor_id())
+	if (this_cpu_read(deferrable_claimed)) {
+		this_cpu_write(deferrable_claimed, false);
 		__run_timers(&timer_base_deferrable);
+		atomic_set(&deferrable_pending, 0);
+	}
 }
 
 /*
@@ -1715,6 +1802,14 @@ void run_local_timers(void)
 	struct timer_base *base = this_cpu_ptr(&timer_bases[BASE_STD]);
 
 	hrtimer_run_queues();
+	/*
+	 * Whichever awake CPU ticks first runs the expired global
+	 * deferrable timers, they never wake an idle CPU on their own.
+	 */
+	if (IS_ENABLED(CONFIG_NO_HZ_COMMON) && claim_deferrable_base()) {
+		raise_softirq(TIMER_SOFTIRQ);
+		return;
+	}
 	/* Raise the softirq only if required. */
 	if (time_before(jiffies, base->clk)) {
 		if (!IS_ENABLED(CONFIG_NO_HZ_COMMON))
@@ -1933,6 +2028,12 @@ int timers_dead_cpu(unsigned int cpu)
 {
 	BUG_ON(cpu_online(cpu));
 	__migrate_timers(cpu, true);
+
+	/* Pass on a claim on the deferrable base the dead CPU never ran */
+	if (per_cpu(deferrable_claimed, cpu)) {
+		per_cpu(deferrable_claimed, cpu) = false;
+		atomic_set(&deferrable_pending, 0);
+	}
 	return 0;
 }
 
@@ -0,0 +1,182 @@
+/*
+ * LZ4 decompression microbenchmark
+ *
+ * Compresses a set of page sized samples resembling zram and squashfs
+ * content and reports the decompression throughput of the scalar loop
+ * and, where built, the NEON fast path. Results are printed when the
+ * module is loaded; loading fails if the two paths disagree.
+ *
+ *   insmod lz4_bench.ko [iterations=N]
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/random.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+
+#include "lz4defs.h"
+
+#define SAMPLE_SIZE	PAGE_SIZE
+
+static unsigned int iterations = 2000;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Decompressions per sample and path");
+
+enum sample_kind {
+	SAMPLE_SPARSE,
+	SAMPLE_TEXT,
+	SAMPLE_POINTERS,
+	SAMPLE_RUNS,
+	SAMPLE_RANDOM,
+	NR_SAMPLES,
+};
+
+static const char * const sample_names[NR_SAMPLES] = {
+	[SAMPLE_SPARSE]		= "sparse",
+	[SAMPLE_TEXT]		= "text",
+	[SAMPLE_POINTERS]	= "pointers",
+	[SAMPLE_RUNS]		= "short-runs",
+	[SAMPLE_RANDOM]		= "random",
+};
+
+static void lz4_bench_fill(u8 *buf, enum sample_kind kind)
+{
+	static const char words[] = "static int ret = -EINVAL; return 0; } ";
+	u64 *p = (u64 *)buf;
+	int i;
+
+	switch (kind) {
+	case SAMPLE_SPARSE:
+		/* mostly zero, as in freshly faulted anonymous memory */
+		memset(buf, 0, SAMPLE_SIZE);
+		for (i = 0; i < SAMPLE_SIZE; i += 256)
+			buf[i] = i >> 8;
+		break;
+	case SAMPLE_TEXT:
+		for (i = 0; i < SAMPLE_SIZE; i++)
+			buf[i] = words[(i * 7 / 3 + i / 97) % (sizeof(words) - 1)];
+		break;
+	case SAMPLE_POINTERS:
+		/* heap page with kernel pointers and small integers */
+		for (i = 0; i < SAMPLE_SIZE / 8; i++)
+			p[i] = (i & 3) ? 0xffffffc000000000ULL + (i << 6) : i;
+		break;
+	case SAMPLE_RUNS:
+		/* short distance repeats, the overlapping match case */
+		for (i = 0; i < SAMPLE_SIZE; i++)
+			buf[i] = (i % (1 + (i >> 9))) * 13;
+		break;
+	case SAMPLE_RANDOM:
+	default:
+		get_random_bytes(buf, SAMPLE_SIZE);
+		break;
+	}
+}
+
+static u64 lz4_bench_run(const u8 *cmp, size_t clen, u8 *out, int *err)
+{
+	size_t olen;
+	ktime_t start;
+	unsigned int i;
+
+	start = ktime_get();
+	for (i = 0; i < iterations; i++) {
+		olen = SAMPLE_SIZE;
+		*err = lz4_decompress_unknownoutputsize(cmp, clen, out, &olen);
+		if (*err || olen != SAMPLE_SIZE) {
+			*err = -EINVAL;
+			break;
+		}
+	}
+
+	return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+static u64 lz4_bench_mbps(u64 ns)
+{
+	return div64_u64((u64)iterations * SAMPLE_SIZE * NSEC_PER_SEC,
+			 max_t(u64, ns, 1) << 20);
+}
+
+static int __init lz4_bench_init(void)
+{
+	u8 *src, *cmp, *out, *wrk;
+	size_t clen;
+	u64 ns_scalar, ns_wide = 0;
+	int kind, err = -ENOMEM;
+#ifdef LZ4_WIDE_DECODE
+	bool neon = lz4_dec_neon;
+#endif
+
+	src = kmalloc(SAMPLE_SIZE, GFP_KERNEL);
+	out = kmalloc(SAMPLE_SIZE, GFP_KERNEL);
+	cmp = kmalloc(lz4_compressbound(SAMPLE_SIZE), GFP_KERNEL);
+	wrk = vmalloc(LZ4_MEM_COMPRESS);
+	if (!src || !out || !cmp || !wrk)
+		goto out_free;
+
+	pr_info("%-12s %8s %14s %14s\n", "sample", "ratio%", "scalar MB/s",
+		"neon MB/s");
+
+	for (kind = 0; kind < NR_SAMPLES; kind++) {
+		lz4_bench_fill(src, kind);
+		err = lz4_compress(src, SAMPLE_SIZE, cmp, &clen, wrk);
+		if (err)
+			goto out_free;
+
+#ifdef LZ4_WIDE_DECODE
+		lz4_dec_neon = false;
+#endif
+		ns_scalar = lz4_bench_run(cmp, clen, out, &err);
+		if (err || memcmp(src, out, SAMPLE_SIZE))
+			goto out_mismatch;
+
+#ifdef LZ4_WIDE_DECODE
+		lz4_dec_neon = true;
+		memset(out, 0, SAMPLE_SIZE);
+		ns_wide = lz4_bench_run(cmp, clen, out, &err);
+		if (err || memcmp(src, out, SAMPLE_SIZE))
+			goto out_mismatch;
+#endif
+
+		pr_info("%-12s %8zu %14llu %14llu\n", sample_names[kind],
+			clen * 100 / SAMPLE_SIZE, lz4_bench_mbps(ns_scalar),
+			ns_wide ? lz4_bench_mbps(ns_wide) : 0);
+	}
+	err = 0;
+	goto out_free;
+
+out_mismatch:
+	pr_err("%s: decompressed data mismatch\n", sample_names[kind]);
+	err = -EINVAL;
+out_free:
+#ifdef LZ4_WIDE_DECODE
+	lz4_dec_neon = neon;
+#endif
+	vfree(wrk);
+	kfree(cmp);
+	kfree(out);
+	kfree(src);
+	return err;
+}
+
+static void __exit lz4_bench_exit(void)
+{
+}
+
+module_init(lz4_bench_init);
+module_exit(lz4_bench_exit);
+
+MODULE_LICENSE("GPL v2");
+MODULE_DESCRIPTION("LZ4 decompression microbenchmark");
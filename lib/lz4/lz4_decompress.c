@@ -52,6 +52,133 @@ static const int dec32table[] = {0, 3, 2, 3, 0, 0, 0, 0};
 static const int dec64table[] = {0, 0, 0, -1, 0, 1, 2, 3};
 #endif
 
+#ifdef LZ4_WIDE_DECODE
+/*
+ * 16 byte NEON copies for literal runs and matches. A sequence is only
+ * decoded here if both buffers have enough slack for the copies to run
+ * past its end, so the first sequence near either end is left to the
+ * scalar loop, which then finishes the block.
+ */
+#define LZ4_WIDE_IN_SLACK	32
+#define LZ4_WIDE_OUT_SLACK	64
+
+bool lz4_dec_neon __read_mostly = true;
+EXPORT_SYMBOL_GPL(lz4_dec_neon);
+module_param_named(neon, lz4_dec_neon, bool, 0644);
+MODULE_PARM_DESC(neon, "Use the NEON decompression fast path");
+
+static __always_inline void lz4_wildcopy16(BYTE *d, const BYTE *s, BYTE *e)
+{
+	do {
+		asm volatile("ld1	{v16.16b}, [%1]\n\t"
+			     "st1	{v16.16b}, [%0]"
+			     : : "r" (d), "r" (s) : "v16", "memory");
+		d += 16;
+		s += 16;
+	} while (d < e);
+}
+
+/* Returns false if the input references data before the output buffer */
+static bool lz4_decode_wide(const BYTE **ipp, const BYTE *iend,
+			    BYTE **opp, BYTE *oend, const BYTE *dest)
+{
+	const BYTE *ip = *ipp;
+	BYTE *op = *opp;
+	const BYTE *ilimit, *ref, *seq_ip;
+	BYTE *olimit, *seq_op, *cpy;
+	size_t length, offset;
+	unsigned token, s;
+	bool ok = true;
+
+	if (iend - ip < LZ4_WIDE_IN_SLACK || oend - op < LZ4_WIDE_OUT_SLACK)
+		return true;
+	ilimit = iend - LZ4_WIDE_IN_SLACK;
+	olimit = oend - LZ4_WIDE_OUT_SLACK;
+
+	kernel_neon_begin();
+	while (ip < ilimit && op < olimit) {
+		seq_ip = ip;
+		seq_op = op;
+
+		/* literal run */
+		token = *ip++;
+		length = token >> ML_BITS;
+		if (length == RUN_MASK) {
+			do {
+				s = *ip++;
+				length += s;
+			} while (s == 255 && ip < ilimit);
+		}
+		if (ip >= ilimit || length >= (size_t)(ilimit - ip) ||
+		    length > (size_t)(olimit - op))
+			goto fallback;
+		cpy = op + length;
+		lz4_wildcopy16(op, ip, cpy);
+		ip += length;
+		op = cpy;
+
+		offset = get_unaligned_le16(ip);
+		ip += 2;
+		ref = op - offset;
+		if (unlikely(ref < dest)) {
+			ok = false;
+			break;
+		}
+
+		/* match */
+		length = token & ML_MASK;
+		if (length == ML_MASK) {
+			do {
+				s = *ip++;
+				length += s;
+			} while (s == 255 && ip < ilimit);
+			if (ip >= ilimit)
+				goto fallback;
+		}
+		length += MINMATCH;
+		if (length > (size_t)(olimit - op))
+			goto fallback;
+		cpy = op + length;
+
+		if (offset >= 16) {
+			lz4_wildcopy16(op, ref, cpy);
+			op = cpy;
+			continue;
+		}
+
+		/* overlapping match: spread the pattern 8 bytes apart first */
+		if (offset < STEPSIZE) {
+			int dec64 = dec64table[offset];
+
+			op[0] = ref[0];
+			op[1] = ref[1];
+			op[2] = ref[2];
+			op[3] = ref[3];
+			op += 4;
+			ref += 4;
+			ref -= dec32table[op - ref];
+			PUT4(ref, op);
+			op += STEPSIZE - 4;
+			ref -= dec64;
+		}
+		while (op < cpy)
+			LZ4_COPYSTEP(ref, op);
+		op = cpy;
+		continue;
+
+fallback:
+		ip = seq_ip;
+		op = seq_op;
+		break;
+	}
+	kernel_neon_end();
+
+	*ipp = ip;
+	*opp = op;
+	return ok;
+}
+#endif
+
 static int lz4_uncompress(const char *source, char *dest, int osize)
 {
 	const BYTE *ip = (const BYTE *) source;
@@ -182,6 +309,12 @@ static int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
 	BYTE * const oend = op + maxoutputsize;
 	BYTE *cpy;
 
+#ifdef LZ4_WIDE_DECODE
+	if (lz4_dec_neon && (elf_hwcap & HWCAP_ASIMD) &&
+	    !lz4_decode_wide(&ip, iend, &op, oend, (BYTE *)dest))
+		goto _output_error;
+#endif
+
 	/* Main Loop */
 	while (ip < iend) {
 
@@ -17,6 +17,18 @@
 #define LZ4_ARCH64 0
 #endif
 
+/*
+ * NEON decompression fast path, not for the boot time decompressor
+ */
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON) && \
+	!defined(STATIC)
+#define LZ4_WIDE_DECODE 1
+#include <asm/hwcap.h>
+#include <asm/neon.h>
+
+extern bool lz4_dec_neon;
+#endif
+
 /*
  * Architecture-specific macros
  */
@@ -0,0 +1,180 @@
+/*
+ * Shared per cpu zstd contexts for page compression.
+ *
+ * In-kernel users that compress single pages, like zram, used to set up
+ * one compression context per stream with the default parameters, whose
+ * window and tables are sized for large inputs. A zstd_page_pool instead
+ * holds one context per possible cpu sized by ZSTD_getPageParams(), so
+ * workspace memory scales with the number of cpus instead of the number
+ * of streams, and is a fraction of the default.
+ *
+ * An optional dictionary, e.g. one trained on anonymous memory of typical
+ * applications, is digested once and referenced by all cpus. Pages
+ * compressed with a dictionary need the same dictionary to decompress.
+ *
+ * Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/zstd.h>
+
+struct zstd_page_ctx {
+	ZSTD_CCtx *cctx;
+	void *wksp;
+};
+
+struct zstd_page_pool {
+	ZSTD_parameters params;
+	struct zstd_page_ctx __percpu *ctx;
+	ZSTD_CDict *cdict;
+	void *cdict_wksp;
+	void *dict;
+};
+
+/**
+ * ZSTD_getPageParams() - returns ZSTD_parameters for compressing pages
+ * @compressionLevel: The compression level from 1 to ZSTD_maxCLevel().
+ * @dictSize:         The dictionary size or 0 if a dictionary isn't being used.
+ *
+ * The window and tables are sized for a single page plus the dictionary.
+ * The frame header carries neither content size, checksum nor dictionary
+ * id: the caller knows all three, and they are a measurable part of a
+ * compressed page.
+ *
+ * Return:            The selected ZSTD_parameters.
+ */
+ZSTD_parameters ZSTD_getPageParams(int compressionLevel, size_t dictSize)
+{
+	ZSTD_parameters params;
+
+	params = ZSTD_getParams(compressionLevel, PAGE_SIZE, dictSize);
+	params.fParams.contentSizeFlag = 0;
+	params.fParams.checksumFlag = 0;
+	params.fParams.noDictIDFlag = 1;
+
+	return params;
+}
+EXPORT_SYMBOL(ZSTD_getPageParams);
+
+/**
+ * zstd_page_pool_create() - allocate per cpu contexts for page compression
+ * @level:     The compression level from 1 to ZSTD_maxCLevel().
+ * @dict:      Dictionary to compress with, or NULL. It is copied.
+ * @dict_size: The size of @dict.
+ *
+ * Return:     The pool or NULL if out of memory.
+ */
+struct zstd_page_pool *zstd_page_pool_create(int level, const void *dict,
+					     size_t dict_size)
+{
+	struct zstd_page_pool *pool;
+	struct zstd_page_ctx *ctx;
+	size_t size;
+	int cpu;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	pool->params = ZSTD_getPageParams(level, dict ? dict_size : 0);
+	pool->ctx = alloc_percpu(struct zstd_page_ctx);
+	if (!pool->ctx)
+		goto err;
+
+	size = ZSTD_CCtxWorkspaceBound(pool->params.cParams);
+	for_each_possible_cpu(cpu) {
+		ctx = per_cpu_ptr(pool->ctx, cpu);
+		ctx->wksp = vmalloc(size);
+		if (!ctx->wksp)
+			goto err;
+		ctx->cctx = ZSTD_initCCtx(ctx->wksp, size);
+		if (!ctx->cctx)
+			goto err;
+	}
+
+	if (!dict || !dict_size)
+		return pool;
+
+	pool->dict = vmalloc(dict_size);
+	size = ZSTD_CDictWorkspaceBound(pool->params.cParams);
+	pool->cdict_wksp = vmalloc(size);
+	if (!pool->dict || !pool->cdict_wksp)
+		goto err;
+
+	memcpy(pool->dict, dict, dict_size);
+	pool->cdict = ZSTD_initCDict(pool->dict, dict_size, pool->params,
+				     pool->cdict_wksp, size);
+	if (!pool->cdict)
+		goto err;
+
+	return pool;
+
+err:
+	zstd_page_pool_destroy(pool);
+	return NULL;
+}
+EXPORT_SYMBOL(zstd_page_pool_create);
+
+/**
+ * zstd_page_pool_destroy() - free a pool and its contexts
+ * @pool: The pool, may be NULL.
+ */
+void zstd_page_pool_destroy(struct zstd_page_pool *pool)
+{
+	int cpu;
+
+	if (!pool)
+		return;
+
+	if (pool->ctx) {
+		for_each_possible_cpu(cpu)
+			vfree(per_cpu_ptr(pool->ctx, cpu)->wksp);
+		free_percpu(pool->ctx);
+	}
+	vfree(pool->cdict_wksp);
+	vfree(pool->dict);
+	kfree(pool);
+}
+EXPORT_SYMBOL(zstd_page_pool_destroy);
+
+/**
+ * zstd_page_pool_compress() - compress src into dst with this cpu's context
+ * @pool:        The pool.
+ * @dst:         The buffer to compress src into.
+ * @dstCapacity: The size of the destination buffer.
+ * @src:         The data to compress, normally one page.
+ * @srcSize:     The size of the data to compress.
+ *
+ * The context is used with preemption disabled, as a zram stream is, so
+ * the caller must not sleep until this returns.
+ *
+ * Return:       The compressed size or an error, which can be checked using
+ *               ZSTD_isError().
+ */
+size_t zstd_page_pool_compress(struct zstd_page_pool *pool, void *dst,
+			       size_t dstCapacity, const void *src,
+			       size_t srcSize)
+{
+	struct zstd_page_ctx *ctx = get_cpu_ptr(pool->ctx);
+	size_t ret;
+
+	if (pool->cdict)
+		ret = ZSTD_compress_usingCDict(ctx->cctx, dst, dstCapacity,
+					       src, srcSize, pool->cdict);
+	else
+		ret = ZSTD_compressCCtx(ctx->cctx, dst, dstCapacity, src,
+					srcSize, pool->params);
+	put_cpu_ptr(pool->ctx);
+
+	return ret;
+}
+EXPORT_SYMBOL(zstd_page_pool_compress);
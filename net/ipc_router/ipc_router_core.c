@@ -1221,7 +1221,13 @@ static int post_pkt_to_port(struct msm_ipc_port *port_ptr,
 	if (pkt->ws_need)
 		__pm_stay_awake(port_ptr->port_rx_ws);
 	list_add_tail(&temp_pkt->list, &port_ptr->port_rx_q);
-	wake_up(&port_ptr->port_rx_wait_q);
+	/*
+	 * Readers drain the queue before sleeping again, so a burst of
+	 * messages to a busy port does not take the wait queue lock for
+	 * every message.
+	 */
+	if (wq_has_sleeper(&port_ptr->port_rx_wait_q))
+		wake_up(&port_ptr->port_rx_wait_q);
 	notify = port_ptr->notify;
 	pkt_type = temp_pkt->hdr.type;
 	sk = (struct sock *)port_ptr->endpoint;
@@ -876,6 +876,8 @@ int rmnet_associate_network_device(struct net_device *dev)
 	config->recycle = kfree_skb;
 	hrtimer_init(&conf->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	conf->hrtimer.function = rmnet_map_flush_packet_queue;
+	tasklet_init(&conf->agg_tasklet, rmnet_map_flush_packet_tasklet,
+		     (unsigned long)conf);
 	rc = netdev_rx_handler_register(dev, rmnet_rx_handler, config);
 
 	if (rc) {
@@ -1241,6 +1243,7 @@ static void rmnet_force_unassociate_device(struct net_device *dev)
 		unsigned long flags;
 
 		hrtimer_cancel(&config->hrtimer);
+		tasklet_kill(&config->agg_tasklet);
 		spin_lock_irqsave(&config->agg_lock, flags);
 		if (config->agg_state == RMNET_MAP_TXFER_SCHEDULED) {
 			if (config->agg_skb) {
@@ -17,6 +17,7 @@
 #include <linux/spinlock.h>
 #include <net/rmnet_config.h>
 #include <linux/hrtimer.h>
+#include <linux/interrupt.h>
 
 #ifndef _RMNET_DATA_CONFIG_H_
 #define _RMNET_DATA_CONFIG_H_
@@ -64,6 +65,8 @@ struct rmnet_logical_ep_conf_s {
  * @tail_spacing: Guaranteed padding (bytes) when de-aggregating ingress frames
  * @agg_time: Wall clock time when aggregated frame was created
  * @agg_last: Last time the aggregation routing was invoked
+ * @agg_gap_ns: Moving average of the time between egress packets
+ * @agg_tasklet: Transmits the aggregated frame when @hrtimer expires
  */
 struct rmnet_phys_ep_config {
 	struct net_device *dev;
@@ -86,7 +89,9 @@ struct rmnet_phys_ep_config {
 	u8 agg_count;
 	struct timespec agg_time;
 	struct timespec agg_last;
+	s64 agg_gap_ns;
 	struct hrtimer hrtimer;
+	struct tasklet_struct agg_tasklet;
 };
 
 int rmnet_config_init(void);
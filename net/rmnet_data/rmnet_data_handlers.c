@@ -20,6 +20,8 @@
 #include <linux/netdev_features.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/smp.h>
+#include <linux/cpumask.h>
 #include <net/rmnet_config.h>
 #include "rmnet_data_private.h"
 #include "rmnet_data_config.h"
@@ -66,6 +68,33 @@ unsigned int upper_byte_limit __read_mostly = 10500;
 module_param(upper_byte_limit, uint, 0644);
 MODULE_PARM_DESC(upper_byte_limit, "Max byte count for flushing GRO");
 
+static bool deagg_coalesce_on __read_mostly = 1;
+module_param(deagg_coalesce_on, bool, 0644);
+MODULE_PARM_DESC(deagg_coalesce_on, "Coalesce TCP segments on deaggregation");
+
+static unsigned int steer_cpu_mask __read_mostly;
+module_param(steer_cpu_mask, uint, 0644);
+MODULE_PARM_DESC(steer_cpu_mask, "CPUs to steer downlink flows to, 0 for none");
+
+#define RMNET_STEER_NAPI_WEIGHT 64
+
+/* struct rmnet_steer_queue - per-CPU backlog of steered packets
+ * @skbs:      packets waiting to be delivered on this CPU
+ * @napi:      context draining @skbs in softirq on this CPU
+ * @csd:       cross call used to schedule @napi from another CPU
+ * @scheduled: set while @napi is scheduled or @csd is in flight; protected
+ *             by the lock of @skbs
+ */
+struct rmnet_steer_queue {
+	struct sk_buff_head skbs;
+	struct napi_struct napi;
+	struct call_single_data csd;
+	bool scheduled;
+};
+
+static DEFINE_PER_CPU(struct rmnet_steer_queue, rmnet_steer_queues);
+static struct net_device rmnet_steer_dev;
+
 #define RMNET_DATA_IP_VERSION_4 0x40
 #define RMNET_DATA_IP_VERSION_6 0x60
 
@@ -200,7 +229,11 @@ static rx_handler_result_t rmnet_bridge_handler
  */
 static void rmnet_vnd_rx_fixup(struct sk_buff *skb, struct net_device *dev)
 {
-	dev->stats.rx_packets++;
+	/* Segments coalesced on deaggregation still count individually */
+	if (skb_is_gso(skb))
+		dev->stats.rx_packets += skb_shinfo(skb)->gso_segs;
+	else
+		dev->stats.rx_packets++;
 	dev->stats.rx_bytes += skb->len;
 }
 
@@ -325,6 +358,161 @@ static void rmnet_optional_gro_flush(struct napi_struct *napi,
 	}
 }
 
+/* rmnet_steer_skb() - Steer a packet to a CPU picked by its flow hash
+ * @skb:      Packet being delivered to a VND
+ *
+ * Packets of one flow always land on the same CPU of steer_cpu_mask, so
+ * ordering within a flow is preserved. Packets hashing to the current CPU
+ * are delivered inline.
+ *
+ * Return:
+ *      - 1 if the packet was queued to (or dropped at) another CPU
+ *      - 0 if the packet should be delivered on the current CPU
+ */
+static int rmnet_steer_skb(struct sk_buff *skb)
+{
+	struct rmnet_steer_queue *q;
+	unsigned long mask, flags;
+	unsigned int idx;
+	int cpu;
+	bool kick;
+
+	mask = READ_ONCE(steer_cpu_mask) & cpumask_bits(cpu_online_mask)[0];
+	if (!mask)
+		return 0;
+
+	idx = reciprocal_scale(skb_get_hash(skb), hweight_long(mask));
+	for_each_set_bit(cpu, &mask, BITS_PER_LONG)
+		if (!idx--)
+			break;
+
+	if (cpu == smp_processor_id())
+		return 0;
+
+	q = &per_cpu(rmnet_steer_queues, cpu);
+	spin_lock_irqsave(&q->skbs.lock, flags);
+	if (skb_queue_len(&q->skbs) >= netdev_max_backlog) {
+		spin_unlock_irqrestore(&q->skbs.lock, flags);
+		rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_STEER_BACKLOG);
+		return 1;
+	}
+	__skb_queue_tail(&q->skbs, skb);
+	kick = !q->scheduled;
+	q->scheduled = true;
+	spin_unlock_irqrestore(&q->skbs.lock, flags);
+
+	rmnet_stats_steer(cpu);
+	if (kick)
+		smp_call_function_single_async(cpu, &q->csd);
+
+	return 1;
+}
+
+static void rmnet_steer_kick(void *info)
+{
+	struct rmnet_steer_queue *q = info;
+
+	napi_schedule(&q->napi);
+}
+
+static int rmnet_steer_poll(struct napi_struct *napi, int budget)
+{
+	struct rmnet_steer_queue *q = container_of(napi,
+						   struct rmnet_steer_queue,
+						   napi);
+	struct sk_buff *skb;
+	int work = 0;
+	bool empty;
+
+	while (work < budget) {
+		spin_lock_irq(&q->skbs.lock);
+		skb = __skb_dequeue(&q->skbs);
+		spin_unlock_irq(&q->skbs.lock);
+		if (!skb)
+			break;
+
+		if (rmnet_check_skb_can_gro(skb) &&
+		    (skb->dev->features & NETIF_F_GRO))
+			napi_gro_receive(napi, skb);
+		else
+			netif_receive_skb(skb);
+		work++;
+	}
+
+	if (work == budget)
+		return work;
+
+	napi_complete_done(napi, work);
+
+	/* Packets queued while completing saw scheduled set and did not kick */
+	spin_lock_irq(&q->skbs.lock);
+	empty = skb_queue_empty(&q->skbs);
+	if (empty)
+		q->scheduled = false;
+	spin_unlock_irq(&q->skbs.lock);
+	if (!empty)
+		napi_schedule(napi);
+
+	return work;
+}
+
+/* rmnet_steer_purge_dev() - Drop steered packets still queued for a VND
+ * @dev:      Virtual network device going away
+ */
+void rmnet_steer_purge_dev(struct net_device *dev)
+{
+	struct rmnet_steer_queue *q;
+	struct sk_buff *skb, *tmp;
+	struct sk_buff_head purge;
+	int cpu;
+
+	__skb_queue_head_init(&purge);
+	for_each_possible_cpu(cpu) {
+		q = &per_cpu(rmnet_steer_queues, cpu);
+		spin_lock_irq(&q->skbs.lock);
+		skb_queue_walk_safe(&q->skbs, skb, tmp) {
+			if (skb->dev != dev)
+				continue;
+			__skb_unlink(skb, &q->skbs);
+			__skb_queue_tail(&purge, skb);
+		}
+		spin_unlock_irq(&q->skbs.lock);
+	}
+
+	__skb_queue_purge(&purge);
+}
+
+void rmnet_steer_init(void)
+{
+	struct rmnet_steer_queue *q;
+	int cpu;
+
+	init_dummy_netdev(&rmnet_steer_dev);
+	for_each_possible_cpu(cpu) {
+		q = &per_cpu(rmnet_steer_queues, cpu);
+		skb_queue_head_init(&q->skbs);
+		q->csd.func = rmnet_steer_kick;
+		q->csd.info = q;
+		netif_napi_add(&rmnet_steer_dev, &q->napi, rmnet_steer_poll,
+			       RMNET_STEER_NAPI_WEIGHT);
+		napi_enable(&q->napi);
+	}
+}
+
+void rmnet_steer_exit(void)
+{
+	struct rmnet_steer_queue *q;
+	int cpu;
+
+	steer_cpu_mask = 0;
+	for_each_possible_cpu(cpu) {
+		q = &per_cpu(rmnet_steer_queues, cpu);
+		napi_disable(&q->napi);
+		netif_napi_del(&q->napi);
+		skb_queue_purge(&q->skbs);
+	}
+}
+
 /* __rmnet_deliver_skb() - Deliver skb
  *
  * Determines where to deliver skb. Options are: consume by network stack,
@@ -351,6 +539,9 @@ static rx_handler_result_t __rmnet_deliver_skb
 		skb->pkt_type = PACKET_HOST;
 		skb_set_mac_header(skb, 0);
 
+		if (rmnet_steer_skb(skb))
+			return RX_HANDLER_CONSUMED;
+
 		if (rmnet_check_skb_can_gro(skb) &&
 		    (skb->dev->features & NETIF_F_GRO)) {
 			napi = get_current_napi_context();
@@ -378,6 +569,50 @@ static rx_handler_result_t __rmnet_deliver_skb
 	}
 }
 
+/* rmnet_map_coal_flush() - Deliver the flow held during deaggregation
+ * @coal:     Coalescing context of the aggregate
+ */
+static void rmnet_map_coal_flush(struct rmnet_map_coal_s *coal)
+{
+	struct sk_buff *skb;
+
+	if (!coal->head)
+		return;
+
+	skb = rmnet_map_coal_finalize(coal);
+	__rmnet_deliver_skb(skb, coal->ep);
+}
+
+/* rmnet_map_coal_deliver() - Deliver or hold a deaggregated packet
+ * @skb:      Packet being delivered, starting at the IP header
+ * @ep:       Logical endpoint configuration of the packet
+ * @coal:     Coalescing context of the aggregate
+ *
+ * Consecutive in order TCP segments of one flow are merged into a single
+ * skb before being handed to the stack. Anything that does not continue the
+ * held flow first flushes it, so packet order is preserved.
+ *
+ * Return:
+ *      - RX_HANDLER_CONSUMED if packet is held or merged
+ *      - result of __rmnet_deliver_skb() for all other cases
+ */
+static rx_handler_result_t rmnet_map_coal_deliver
+	(struct sk_buff *skb, struct rmnet_logical_ep_conf_s *ep,
+	 struct rmnet_map_coal_s *coal)
+{
+	if (coal->head && rmnet_map_coal_merge(coal, skb, ep))
+		return RX_HANDLER_CONSUMED;
+
+	rmnet_map_coal_flush(coal);
+
+	if (deagg_coalesce_on && ep->rmnet_mode == RMNET_EPMODE_VND &&
+	    (skb->dev->features & NETIF_F_GRO) &&
+	    rmnet_map_coal_start(coal, skb, ep))
+		return RX_HANDLER_CONSUMED;
+
+	return __rmnet_deliver_skb(skb, ep);
+}
+
 /* rmnet_ingress_deliver_packet() - Ingress handler for raw IP and bridged
  *                                  MAP packets.
  * @skb:     Packet needing a destination.
@@ -413,6 +648,7 @@ static rx_handler_result_t rmnet_ingress_deliver_packet
 /* _rmnet_map_ingress_handler() - Actual MAP ingress handler
  * @skb:        Packet being received
  * @config:     Physical endpoint configuration for the ingress device
+ * @coal:       Coalescing context when deaggregating, NULL otherwise
  *
  * Most MAP ingress functions are processed here. Packets are processed
  * individually; aggregated packets should use rmnet_map_ingress_handler()
@@ -422,7 +658,8 @@ static rx_handler_result_t rmnet_ingress_deliver_packet
  *      - result of __rmnet_deliver_skb() for all other cases
  */
 static rx_handler_result_t _rmnet_map_ingress_handler
-	(struct sk_buff *skb, struct rmnet_phys_ep_config *config)
+	(struct sk_buff *skb, struct rmnet_phys_ep_config *config,
+	 struct rmnet_map_coal_s *coal)
 {
 	struct rmnet_logical_ep_conf_s *ep;
 	u8 mux_id;
@@ -488,6 +725,8 @@ static rx_handler_result_t _rmnet_map_ingress_handler
 	skb_pull(skb, sizeof(struct rmnet_map_header_s));
 	skb_trim(skb, len);
 	__rmnet_data_set_skb_proto(skb);
+	if (coal)
+		return rmnet_map_coal_deliver(skb, ep, coal);
 	return __rmnet_deliver_skb(skb, ep);
 }
 
@@ -507,18 +746,20 @@ static rx_handler_result_t _rmnet_map_ingress_handler
 static rx_handler_result_t rmnet_map_ingress_handler
 	(struct sk_buff *skb, struct rmnet_phys_ep_config *config)
 {
+	struct rmnet_map_coal_s coal = { 0 };
 	struct sk_buff *skbn;
 	int rc;
 
 	if (config->ingress_data_format & RMNET_INGRESS_FORMAT_DEAGGREGATION) {
 		trace_rmnet_start_deaggregation(skb);
 		while ((skbn = rmnet_map_deaggregate(skb, config)) != 0) {
-			_rmnet_map_ingress_handler(skbn, config);
+			_rmnet_map_ingress_handler(skbn, config, &coal);
 		}
+		rmnet_map_coal_flush(&coal);
 		rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_MAPINGRESS_AGGBUF);
 		rc = RX_HANDLER_CONSUMED;
 	} else {
-		rc = _rmnet_map_ingress_handler(skb, config);
+		rc = _rmnet_map_ingress_handler(skb, config, NULL);
 	}
 
 	return rc;
@@ -31,6 +31,12 @@ enum rmnet_deagg_e {
 	RMNET_STATS_AGG_MAX
 };
 
+enum rmnet_coal_e {
+	RMNET_STATS_COAL_SKB,
+	RMNET_STATS_COAL_SEG,
+	RMNET_STATS_COAL_MAX
+};
+
 static DEFINE_SPINLOCK(rmnet_skb_free_lock);
 unsigned long int skb_free[RMNET_STATS_SKBFREE_MAX];
 module_param_array(skb_free, ulong, 0, 0444);
@@ -51,6 +57,16 @@ unsigned long int checksum_dl_stats[RMNET_MAP_CHECKSUM_ENUM_LENGTH];
 module_param_array(checksum_dl_stats, ulong, 0, 0444);
 MODULE_PARM_DESC(checksum_dl_stats, "Downlink Checksum Statistics");
 
+static DEFINE_SPINLOCK(rmnet_coal_count);
+unsigned long int coal_count[RMNET_STATS_COAL_MAX];
+module_param_array(coal_count, ulong, 0, 0444);
+MODULE_PARM_DESC(coal_count, "Downlink TCP segments coalesced");
+
+static DEFINE_SPINLOCK(rmnet_steer_count);
+unsigned long int steer_count[NR_CPUS];
+module_param_array(steer_count, ulong, 0, 0444);
+MODULE_PARM_DESC(steer_count, "Downlink packets steered to each CPU");
+
 static DEFINE_SPINLOCK(rmnet_checksum_ul_stats);
 unsigned long int checksum_ul_stats[RMNET_MAP_CHECKSUM_ENUM_LENGTH];
 module_param_array(checksum_ul_stats, ulong, 0, 0444);
@@ -106,6 +122,28 @@ void rmnet_stats_dl_checksum(unsigned int rc)
 	spin_unlock_irqrestore(&rmnet_checksum_dl_stats, flags);
 }
 
+void rmnet_stats_dl_coalesce(int segs)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&rmnet_coal_count, flags);
+	coal_count[RMNET_STATS_COAL_SKB]++;
+	coal_count[RMNET_STATS_COAL_SEG] += segs;
+	spin_unlock_irqrestore(&rmnet_coal_count, flags);
+}
+
+void rmnet_stats_steer(int cpu)
+{
+	unsigned long flags;
+
+	if (cpu < 0 || cpu >= NR_CPUS)
+		return;
+
+	spin_lock_irqsave(&rmnet_steer_count, flags);
+	steer_count[cpu]++;
+	spin_unlock_irqrestore(&rmnet_steer_count, flags);
+}
+
 void rmnet_stats_ul_checksum(unsigned int rc)
 {
 	unsigned long flags;
@@ -628,6 +628,7 @@ int rmnet_vnd_free_dev(int id)
 	rtnl_unlock();
 
 	if (dev) {
+		rmnet_steer_purge_dev(dev);
 		unregister_netdev(dev);
 		free_netdev(dev);
 		return 0;
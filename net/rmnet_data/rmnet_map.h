@@ -131,6 +131,32 @@ enum rmnet_map_agg_state_e {
 #define RMNET_MAP_NO_PAD_BYTES        0
 #define RMNET_MAP_ADD_PAD_BYTES       1
 
+struct rmnet_logical_ep_conf_s;
+
+/* struct rmnet_map_coal_s - TCP segments of one flow held while an aggregate
+ * is deaggregated
+ * @head:    first segment; the others are chained on its frag_list
+ * @tail:    last segment on the frag_list of @head
+ * @ep:      logical endpoint the segments are delivered to
+ * @next_seq: sequence number the next segment must carry
+ * @iphlen:  IP header length of the flow
+ * @thlen:   TCP header length of the flow
+ * @mss:     payload length of @head; no larger segment is merged
+ * @segs:    number of segments held
+ * @closed:  set once a short or PSH segment ended the train
+ */
+struct rmnet_map_coal_s {
+	struct sk_buff *head;
+	struct sk_buff *tail;
+	struct rmnet_logical_ep_conf_s *ep;
+	u32 next_seq;
+	u16 iphlen;
+	u16 thlen;
+	u16 mss;
+	u16 segs;
+	bool closed;
+};
+
 uint8_t rmnet_map_demultiplex(struct sk_buff *skb);
 struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 				      struct rmnet_phys_ep_config *config);
@@ -147,5 +173,11 @@ int rmnet_map_checksum_uplink_packet(struct sk_buff *skb,
 				     struct net_device *orig_dev,
 				     u32 egress_data_format);
 int rmnet_ul_aggregation_skip(struct sk_buff *skb, int offset);
+int rmnet_map_coal_start(struct rmnet_map_coal_s *coal, struct sk_buff *skb,
+			 struct rmnet_logical_ep_conf_s *ep);
+int rmnet_map_coal_merge(struct rmnet_map_coal_s *coal, struct sk_buff *skb,
+			 struct rmnet_logical_ep_conf_s *ep);
+struct sk_buff *rmnet_map_coal_finalize(struct rmnet_map_coal_s *coal);
 enum hrtimer_restart rmnet_map_flush_packet_queue(struct hrtimer *t);
+void rmnet_map_flush_packet_tasklet(unsigned long data);
 #endif /* _RMNET_MAP_H_ */
@@ -29,6 +29,7 @@
 #include <net/ip.h>
 #include <net/checksum.h>
 #include <net/ip6_checksum.h>
+#include <net/tcp.h>
 #include <net/rmnet_config.h>
 #include "rmnet_data_config.h"
 #include "rmnet_map.h"
@@ -48,10 +49,14 @@ long agg_bypass_time __read_mostly = 10000000L;
 module_param(agg_bypass_time, long, 0644);
 MODULE_PARM_DESC(agg_bypass_time, "Skip agg when apart spaced more than this");
 
-struct agg_work {
-	struct work_struct work;
-	struct rmnet_phys_ep_config *config;
-};
+static bool agg_adaptive_on __read_mostly = 1;
+module_param(agg_adaptive_on, bool, 0644);
+MODULE_PARM_DESC(agg_adaptive_on, "Size aggregates by the uplink packet rate");
+
+/* Weight of a new sample in the egress packet gap average, as a shift */
+#define RMNET_MAP_AGG_GAP_SHIFT 2
+/* Flush timeout when aggregates are not sized adaptively */
+#define RMNET_MAP_AGG_FLUSH_NS 3000000L
 
 #define RMNET_MAP_DEAGGR_SPACING  64
 #define RMNET_MAP_DEAGGR_HEADROOM (RMNET_MAP_DEAGGR_SPACING / 2)
@@ -165,16 +170,233 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 	return skbn;
 }
 
-static void rmnet_map_flush_packet_work(struct work_struct *work)
+/* rmnet_map_coal_tcp_hdr() - Checks whether a packet may be coalesced
+ * @skb:        Deaggregated packet, starting at the IP header
+ *
+ * Only plain, checksum validated TCP segments carrying payload qualify: no
+ * IPv4 options or fragments, no IPv6 extension headers and no TCP flags
+ * other than ACK and PSH.
+ *
+ * Return:
+ *     - Pointer to the TCP header of the packet
+ *     - 0 (null) if the packet cannot be coalesced
+ */
+static struct tcphdr *rmnet_map_coal_tcp_hdr(struct sk_buff *skb)
+{
+	struct iphdr *ip4h;
+	struct ipv6hdr *ip6h;
+	struct tcphdr *th;
+	unsigned int iphlen;
+
+	if (skb->ip_summed != CHECKSUM_UNNECESSARY || skb_is_nonlinear(skb))
+		return 0;
+
+	switch (skb->data[0] & 0xF0) {
+	case 0x40:
+		ip4h = (struct iphdr *)skb->data;
+		iphlen = sizeof(struct iphdr);
+		if (skb->len < iphlen || ip4h->ihl != 5 ||
+		    ip4h->protocol != IPPROTO_TCP ||
+		    ntohs(ip4h->tot_len) != skb->len ||
+		    (ip4h->frag_off & htons(IP_MF | IP_OFFSET)))
+			return 0;
+		break;
+	case 0x60:
+		ip6h = (struct ipv6hdr *)skb->data;
+		iphlen = sizeof(struct ipv6hdr);
+		if (skb->len < iphlen || ip6h->nexthdr != IPPROTO_TCP ||
+		    ntohs(ip6h->payload_len) + iphlen != skb->len)
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+
+	if (skb->len < iphlen + sizeof(struct tcphdr))
+		return 0;
+
+	th = (struct tcphdr *)(skb->data + iphlen);
+	if (th->doff < 5 || skb->len <= iphlen + th->doff * 4)
+		return 0;
+
+	if (!th->ack || (tcp_flag_word(th) & (TCP_FLAG_SYN | TCP_FLAG_FIN |
+					      TCP_FLAG_RST | TCP_FLAG_URG |
+					      TCP_FLAG_CWR | TCP_FLAG_ECE)))
+		return 0;
+
+	return th;
+}
+
+/* rmnet_map_coal_start() - Starts holding a new flow
+ * @coal:       Coalescing context of the aggregate being deaggregated
+ * @skb:        Deaggregated packet, starting at the IP header
+ * @ep:         Logical endpoint the packet is delivered to
+ *
+ * Return:
+ *     - 1 if the packet is now held in @coal
+ *     - 0 if the packet cannot be coalesced and must be delivered as is
+ */
+int rmnet_map_coal_start(struct rmnet_map_coal_s *coal, struct sk_buff *skb,
+			 struct rmnet_logical_ep_conf_s *ep)
+{
+	struct tcphdr *th;
+
+	th = rmnet_map_coal_tcp_hdr(skb);
+	if (!th)
+		return 0;
+
+	coal->head = skb;
+	coal->tail = 0;
+	coal->ep = ep;
+	coal->iphlen = (unsigned char *)th - skb->data;
+	coal->thlen = th->doff * 4;
+	coal->mss = skb->len - coal->iphlen - coal->thlen;
+	coal->next_seq = ntohl(th->seq) + coal->mss;
+	coal->segs = 1;
+	coal->closed = th->psh;
+
+	return 1;
+}
+
+/* rmnet_map_coal_merge() - Appends a packet to the held flow
+ * @coal:       Coalescing context holding a flow
+ * @skb:        Deaggregated packet, starting at the IP header
+ * @ep:         Logical endpoint the packet is delivered to
+ *
+ * The packet is merged if it is the in order continuation of the held flow
+ * with identical IP and TCP headers apart from length, id, sequence number
+ * and checksums. Its headers are pulled and the payload is chained on the
+ * frag_list of the held head, so no data is copied or allocated.
+ *
+ * Return:
+ *     - 1 if the packet was merged and is now owned by @coal
+ *     - 0 if the packet does not belong to the held flow
+ */
+int rmnet_map_coal_merge(struct rmnet_map_coal_s *coal, struct sk_buff *skb,
+			 struct rmnet_logical_ep_conf_s *ep)
+{
+	struct sk_buff *head = coal->head;
+	struct tcphdr *th, *hth;
+	unsigned int payload;
+	u8 *iph = skb->data, *hiph = head->data;
+
+	if (coal->closed || ep != coal->ep)
+		return 0;
+
+	th = rmnet_map_coal_tcp_hdr(skb);
+	if (!th || (unsigned char *)th - skb->data != coal->iphlen ||
+	    th->doff * 4 != coal->thlen)
+		return 0;
+
+	payload = skb->len - coal->iphlen - coal->thlen;
+	if (payload > coal->mss || ntohl(th->seq) != coal->next_seq ||
+	    head->len + payload > 0xFFFF)
+		return 0;
+
+	if (coal->iphlen == sizeof(struct iphdr)) {
+		/* version, tos, ttl, protocol and addresses */
+		if (iph[0] != hiph[0] || iph[1] != hiph[1] ||
+		    iph[8] != hiph[8] || iph[9] != hiph[9] ||
+		    memcmp(iph + 12, hiph + 12, 8))
+			return 0;
+	} else {
+		/* version, traffic class, flow label, hop limit, addresses */
+		if (memcmp(iph, hiph, 4) || iph[7] != hiph[7] ||
+		    memcmp(iph + 8, hiph + 8, 32))
+			return 0;
+	}
+
+	/* ports, ack, flags, window and options */
+	hth = (struct tcphdr *)(hiph + coal->iphlen);
+	if (memcmp(th, hth, 4) || th->ack_seq != hth->ack_seq ||
+	    th->window != hth->window ||
+	    memcmp(th + 1, hth + 1, coal->thlen - sizeof(struct tcphdr)))
+		return 0;
+
+	if (th->psh) {
+		hth->psh = 1;
+		coal->closed = true;
+	}
+	if (payload < coal->mss)
+		coal->closed = true;
+
+	skb_pull(skb, coal->iphlen + coal->thlen);
+	if (coal->tail)
+		coal->tail->next = skb;
+	else
+		skb_shinfo(head)->frag_list = skb;
+	coal->tail = skb;
+
+	head->len += payload;
+	head->data_len += payload;
+	head->truesize += skb->truesize;
+
+	coal->next_seq += payload;
+	coal->segs++;
+
+	return 1;
+}
+
+/* rmnet_map_coal_finalize() - Releases the held flow
+ * @coal:       Coalescing context holding a flow
+ *
+ * The IP and TCP headers of the head are rewritten to describe the whole
+ * train, the way tcp_gro_complete() does. The checksums validated by the
+ * hardware for each segment are carried over by marking the result
+ * CHECKSUM_PARTIAL, so neither the stack nor a later resegmentation for
+ * forwarding touch the payload again.
+ *
+ * Return:
+ *     - Pointer to the packet to deliver
+ */
+struct sk_buff *rmnet_map_coal_finalize(struct rmnet_map_coal_s *coal)
+{
+	struct sk_buff *head = coal->head;
+	struct iphdr *ip4h;
+	struct ipv6hdr *ip6h;
+	struct tcphdr *th;
+	unsigned int tcplen;
+
+	coal->head = 0;
+	if (coal->segs < 2)
+		return head;
+
+	th = (struct tcphdr *)(head->data + coal->iphlen);
+	tcplen = head->len - coal->iphlen;
+	if (coal->iphlen == sizeof(struct iphdr)) {
+		ip4h = (struct iphdr *)head->data;
+		ip4h->tot_len = htons(head->len);
+		ip_send_check(ip4h);
+		th->check = ~tcp_v4_check(tcplen, ip4h->saddr, ip4h->daddr, 0);
+		skb_shinfo(head)->gso_type = SKB_GSO_TCPV4;
+	} else {
+		ip6h = (struct ipv6hdr *)head->data;
+		ip6h->payload_len = htons(tcplen);
+		th->check = ~tcp_v6_check(tcplen, &ip6h->saddr,
+					  &ip6h->daddr, 0);
+		skb_shinfo(head)->gso_type = SKB_GSO_TCPV6;
+	}
+
+	skb_partial_csum_set(head, coal->iphlen,
+			     offsetof(struct tcphdr, check));
+	skb_shinfo(head)->gso_size = coal->mss;
+	skb_shinfo(head)->gso_segs = coal->segs;
+	rmnet_stats_dl_coalesce(coal->segs);
+
+	return head;
+}
+
+/* rmnet_map_flush_packet_tasklet() - Transmits aggregated frame on timeout
+ * @data:       Physical endpoint configuration of the egress device
+ */
+void rmnet_map_flush_packet_tasklet(unsigned long data)
 {
 	struct rmnet_phys_ep_config *config;
-	struct agg_work *real_work;
 	int rc, agg_count = 0;
 	unsigned long flags;
 	struct sk_buff *skb;
 
-	real_work = (struct agg_work *)work;
-	config = real_work->config;
+	config = (struct rmnet_phys_ep_config *)data;
 	skb = NULL;
 
 	LOGD("%s", "Entering flush thread");
@@ -200,35 +422,91 @@ static void rmnet_map_flush_packet_work(struct work_struct *work)
 		rc = dev_queue_xmit(skb);
 		rmnet_stats_queue_xmit(rc, RMNET_STATS_QUEUE_XMIT_AGG_TIMEOUT);
 	}
-
-	kfree(work);
 }
 
 /* rmnet_map_flush_packet_queue() - Transmits aggregeted frame on timeout
  *
  * This function is scheduled to run in a specified number of ns after
  * the last frame transmitted by the network stack. When run, the buffer
- * containing aggregated packets is finally transmitted on the underlying link.
+ * containing aggregated packets is finally transmitted on the underlying link
+ * from the aggregation tasklet.
  *
  */
 enum hrtimer_restart rmnet_map_flush_packet_queue(struct hrtimer *t)
 {
 	struct rmnet_phys_ep_config *config;
-	struct agg_work *work;
 
 	config = container_of(t, struct rmnet_phys_ep_config, hrtimer);
+	tasklet_schedule(&config->agg_tasklet);
 
-	work = kmalloc(sizeof(*work), GFP_ATOMIC);
-	if (!work) {
-		config->agg_state = RMNET_MAP_AGG_IDLE;
+	return HRTIMER_NORESTART;
+}
+
+/* rmnet_map_agg_update_gap() - Tracks the egress packet rate
+ * @config:     Physical endpoint configuration of the egress device
+ * @last:       Time the previous packet was aggregated
+ *
+ * Must be called with agg_lock held, after agg_last was updated.
+ */
+static void rmnet_map_agg_update_gap(struct rmnet_phys_ep_config *config,
+				     struct timespec *last)
+{
+	struct timespec diff;
+	s64 gap;
+
+	diff = timespec_sub(config->agg_last, *last);
+	gap = timespec_to_ns(&diff);
+	gap = clamp_t(s64, gap, 0, agg_bypass_time);
+
+	config->agg_gap_ns += (gap - config->agg_gap_ns) >>
+			      RMNET_MAP_AGG_GAP_SHIFT;
+}
 
-		return HRTIMER_NORESTART;
+/* rmnet_map_agg_target() - Number of packets worth aggregating
+ * @config:     Physical endpoint configuration of the egress device
+ *
+ * The number of packets expected to arrive within agg_time_limit at the
+ * current uplink rate, bounded by the configured aggregation count. Waiting
+ * for more would only hold the first packet longer than the bound.
+ *
+ * Must be called with agg_lock held.
+ */
+static int rmnet_map_agg_target(struct rmnet_phys_ep_config *config)
+{
+	s64 target;
+
+	if (!agg_adaptive_on)
+		return config->egress_agg_count;
+
+	target = div64_s64(agg_time_limit, max_t(s64, config->agg_gap_ns, 1));
+
+	return clamp_t(s64, target, 1, config->egress_agg_count);
+}
+
+/* rmnet_map_agg_arm_timer() - (Re)arms the aggregation flush timer
+ * @config:     Physical endpoint configuration of the egress device
+ *
+ * When sized adaptively, the frame is flushed agg_time_limit after it was
+ * started at the latest, or after twice the average packet gap so that an
+ * aggregate is not held waiting for packets once the stream pauses.
+ *
+ * Must be called with agg_lock held.
+ */
+static void rmnet_map_agg_arm_timer(struct rmnet_phys_ep_config *config)
+{
+	struct timespec diff;
+	s64 timeout = RMNET_MAP_AGG_FLUSH_NS;
+
+	if (agg_adaptive_on) {
+		diff = timespec_sub(config->agg_last, config->agg_time);
+		timeout = agg_time_limit - timespec_to_ns(&diff);
+		timeout = min_t(s64, timeout, config->agg_gap_ns * 2);
+		timeout = max_t(s64, timeout, 0);
 	}
 
-	INIT_WORK(&work->work, rmnet_map_flush_packet_work);
-	work->config = config;
-	schedule_work((struct work_struct *)work);
-	return HRTIMER_NORESTART;
+	config->agg_state = RMNET_MAP_TXFER_SCHEDULED;
+	hrtimer_start(&config->hrtimer, ns_to_ktime(timeout),
+		      HRTIMER_MODE_REL);
 }
 
 /* rmnet_map_aggregate() - Software aggregates multiple packets.
@@ -255,16 +533,18 @@ new_packet:
 	spin_lock_irqsave(&config->agg_lock, flags);
 	memcpy(&last, &config->agg_last, sizeof(struct timespec));
 	getnstimeofday(&config->agg_last);
+	rmnet_map_agg_update_gap(config, &last);
 
 	if (!config->agg_skb) {
 		/* Check to see if we should agg first. If the traffic is very
-		 * sparse, don't aggregate. We will need to tune this later
+		 * sparse, or too slow for a second packet to show up within
+		 * agg_time_limit, don't aggregate.
 		 */
 		diff = timespec_sub(config->agg_last, last);
 		size = config->egress_agg_size - skb->len;
 
 		if ((diff.tv_sec > 0) || (diff.tv_nsec > agg_bypass_time) ||
-		    (size <= 0)) {
+		    (size <= 0) || rmnet_map_agg_target(config) <= 1) {
 			spin_unlock_irqrestore(&config->agg_lock, flags);
 			LOGL("delta t: %ld.%09lu\tcount: bypass", diff.tv_sec,
 			     diff.tv_nsec);
@@ -324,12 +604,26 @@ new_packet:
 	config->agg_count++;
 	dev_kfree_skb_any(skb);
 
-schedule:
-	if (config->agg_state != RMNET_MAP_TXFER_SCHEDULED) {
-		config->agg_state = RMNET_MAP_TXFER_SCHEDULED;
-		hrtimer_start(&config->hrtimer, ns_to_ktime(3000000),
-			      HRTIMER_MODE_REL);
+	/* As many packets as the current rate allows: no point in waiting */
+	if (config->agg_count >= rmnet_map_agg_target(config)) {
+		rmnet_stats_agg_pkts(config->agg_count);
+		agg_skb = config->agg_skb;
+		agg_count = config->agg_count;
+		config->agg_skb = 0;
+		config->agg_count = 0;
+		memset(&config->agg_time, 0, sizeof(struct timespec));
+		config->agg_state = RMNET_MAP_AGG_IDLE;
+		spin_unlock_irqrestore(&config->agg_lock, flags);
+		hrtimer_cancel(&config->hrtimer);
+		trace_rmnet_map_aggregate(agg_skb, agg_count);
+		rc = dev_queue_xmit(agg_skb);
+		rmnet_stats_queue_xmit(rc, RMNET_STATS_QUEUE_XMIT_AGG_RATE);
+		return;
 	}
+
+schedule:
+	if (agg_adaptive_on || config->agg_state != RMNET_MAP_TXFER_SCHEDULED)
+		rmnet_map_agg_arm_timer(config);
 	spin_unlock_irqrestore(&config->agg_lock, flags);
 }
 
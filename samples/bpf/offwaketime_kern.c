@@ -14,12 +14,15 @@
 #define _(P) ({typeof(P) val; bpf_probe_read(&val, sizeof(val), &P); val;})
 
 #define MINBLOCK_US	1
+#define USER_STACK_DEPTH	32
 
 struct key_t {
 	char waker[TASK_COMM_LEN];
 	char target[TASK_COMM_LEN];
 	u32 wret;
 	u32 tret;
+	u32 wuret;
+	u32 turet;
 };
 
 struct bpf_map_def SEC("maps") counts = {
@@ -39,6 +42,7 @@ struct bpf_map_def SEC("maps") start = {
 struct wokeby_t {
 	char name[TASK_COMM_LEN];
 	u32 ret;
+	u32 uret;
 };
 
 struct bpf_map_def SEC("maps") wokeby = {
@@ -55,7 +59,17 @@ struct bpf_map_def SEC("maps") stackmap = {
 	.max_entries = 10000,
 };
 
+/* user frames as build id and file offset, symbolized off the device */
+struct bpf_map_def SEC("maps") ustackmap = {
+	.type = BPF_MAP_TYPE_STACK_TRACE,
+	.key_size = sizeof(u32),
+	.value_size = USER_STACK_DEPTH * sizeof(struct bpf_stack_build_id),
+	.max_entries = 10000,
+	.map_flags = BPF_F_STACK_BUILD_ID,
+};
+
 #define STACKID_FLAGS (0 | BPF_F_FAST_STACK_CMP)
+#define USTACKID_FLAGS (0 | BPF_F_FAST_STACK_CMP | BPF_F_USER_STACK)
 
 SEC("kprobe/try_to_wake_up")
 int waker(struct pt_regs *ctx)
@@ -68,6 +82,7 @@ int waker(struct pt_regs *ctx)
 
 	bpf_get_current_comm(&woke.name, sizeof(woke.name));
 	woke.ret = bpf_get_stackid(ctx, &stackmap, STACKID_FLAGS);
+	woke.uret = bpf_get_stackid(ctx, &ustackmap, USTACKID_FLAGS);
 
 	bpf_map_update_elem(&wokeby, &pid, &woke, BPF_ANY);
 	return 0;
@@ -82,11 +97,14 @@ static inline int update_counts(void *ctx, u32 pid, u64 delta)
 	__builtin_memset(&key.waker, 0, sizeof(key.waker));
 	bpf_get_current_comm(&key.target, sizeof(key.target));
 	key.tret = bpf_get_stackid(ctx, &stackmap, STACKID_FLAGS);
+	key.turet = bpf_get_stackid(ctx, &ustackmap, USTACKID_FLAGS);
 	key.wret = 0;
+	key.wuret = 0;
 
 	woke = bpf_map_lookup_elem(&wokeby, &pid);
 	if (woke) {
 		key.wret = woke->ret;
+		key.wuret = woke->uret;
 		__builtin_memcpy(&key.waker, woke->name, sizeof(key.waker));
 		bpf_map_delete_elem(&wokeby, &pid);
 	}
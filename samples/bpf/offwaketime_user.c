@@ -33,22 +33,48 @@ static void print_ksym(__u64 addr)
 		printf("%s;", sym->name);
 }
 
+/*
+ * User frames are printed as build id and offset, to be symbolized with
+ * the matching debug files off the device. Frames of objects without a
+ * build id fall back to the raw address.
+ */
+static void print_usym(struct bpf_stack_build_id *id)
+{
+	int i;
+
+	if (id->status == BPF_STACK_BUILD_ID_IP) {
+		printf("[%llx];", id->ip);
+		return;
+	}
+	for (i = 0; i < BPF_BUILD_ID_SIZE; i++)
+		printf("%02x", id->build_id[i]);
+	printf("+%llx;", id->offset);
+}
+
 #define TASK_COMM_LEN 16
+#define USER_STACK_DEPTH 32
 
 struct key_t {
 	char waker[TASK_COMM_LEN];
 	char target[TASK_COMM_LEN];
 	__u32 wret;
 	__u32 tret;
+	__u32 wuret;
+	__u32 turet;
 };
 
 static void print_stack(struct key_t *key, __u64 count)
 {
+	struct bpf_stack_build_id uip[USER_STACK_DEPTH] = {};
 	__u64 ip[PERF_MAX_STACK_DEPTH] = {};
 	static bool warned;
 	int i;
 
 	printf("%s;", key->target);
+	if (bpf_lookup_elem(map_fd[4], &key->turet, uip) == 0)
+		for (i = USER_STACK_DEPTH - 1; i >= 0; i--)
+			if (uip[i].status != BPF_STACK_BUILD_ID_EMPTY)
+				print_usym(&uip[i]);
 	if (bpf_lookup_elem(map_fd[3], &key->tret, ip) != 0) {
 		printf("---;");
 	} else {
@@ -62,6 +88,11 @@ static void print_stack(struct key_t *key, __u64 count)
 		for (i = 0; i < PERF_MAX_STACK_DEPTH; i++)
 			print_ksym(ip[i]);
 	}
+	memset(uip, 0, sizeof(uip));
+	if (bpf_lookup_elem(map_fd[4], &key->wuret, uip) == 0)
+		for (i = 0; i < USER_STACK_DEPTH; i++)
+			if (uip[i].status != BPF_STACK_BUILD_ID_EMPTY)
+				print_usym(&uip[i]);
 	printf(";%s %lld\n", key->waker, count);
 
 	if ((key->tret == -EEXIST || key->wret == -EEXIST) && !warned) {
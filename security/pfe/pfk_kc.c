@@ -21,6 +21,9 @@
  * cache eviction are simple, linear and based on last usage timestamp, i.e
  * the node that will be evicted is the one with the oldest timestamp.
  * Empty entries always have the oldest timestamp.
+ * The timestamp is a use sequence number rather than jiffies, so that keys
+ * touched within the same tick keep their relative order and the eviction
+ * is a true LRU. Entries with requests in flight are never evicted.
  */
 
 #include <linux/module.h>
@@ -33,6 +36,8 @@
 #include <linux/slab.h>
 #include <linux/printk.h>
 #include <linux/sched.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "pfk_kc.h"
 #include "pfk_ice.h"
@@ -59,6 +64,25 @@ static unsigned long flags;
 static bool kc_ready;
 static char *s_type = "sdcc";
 
+/* use sequence number for LRU ordering, protected by kc_lock */
+static u64 kc_use_seq;
+
+/**
+ * struct kc_stats - key cache effectiveness counters
+ * @hits: key found loaded in the cache, no key programming needed
+ * @misses: key had to be programmed to ICE
+ * @evictions: a loaded key was replaced to make room for another
+ * @busy: no slot could be taken as all of them had requests in flight
+ */
+static struct kc_stats {
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+	u64 busy;
+} kc_stats;
+
+static struct dentry *kc_debugfs;
+
 /**
  * enum pfk_kc_entry_state - state of the entry inside kc table
  *
@@ -243,7 +267,7 @@ static inline struct kc_entry *kc_min_entry(struct kc_entry *a,
 	if (!a)
 		return b;
 
-	if (time_before64(b->time_stamp, a->time_stamp))
+	if (b->time_stamp < a->time_stamp)
 		return b;
 
 	return a;
@@ -350,17 +374,18 @@ static struct kc_entry *kc_find_oldest_entry_non_locked(void)
 }
 
 /**
- * kc_update_timestamp() - updates timestamp of entry to current
+ * kc_update_timestamp() - marks entry as the most recently used one
  *
  * @entry: entry to update
  *
+ * Should be invoked under spinlock
  */
 static void kc_update_timestamp(struct kc_entry *entry)
 {
 	if (!entry)
 		return;
 
-	entry->time_stamp = get_jiffies_64();
+	entry->time_stamp = ++kc_use_seq;
 }
 
 /**
@@ -430,6 +455,43 @@ static int kc_update_entry(struct kc_entry *entry, const unsigned char *key,
 	return ret;
 }
 
+static int kc_stats_show(struct seq_file *s, void *data)
+{
+	struct kc_stats stats;
+	int in_use = 0;
+	int loaded = 0;
+	int i;
+
+	kc_spin_lock();
+	stats = kc_stats;
+	for (i = 0; i < PFK_KC_TABLE_SIZE; i++) {
+		if (kc_table[i].state == ACTIVE_ICE_LOADED)
+			in_use++;
+		else if (kc_table[i].state == INACTIVE)
+			loaded++;
+	}
+	kc_spin_unlock();
+
+	seq_printf(s, "slots: %d in_use: %d loaded: %d\n",
+		PFK_KC_TABLE_SIZE, in_use, loaded);
+	seq_printf(s, "hits: %llu misses: %llu evictions: %llu busy: %llu\n",
+		stats.hits, stats.misses, stats.evictions, stats.busy);
+
+	return 0;
+}
+
+static int kc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, kc_stats_show, NULL);
+}
+
+static const struct file_operations kc_stats_fops = {
+	.open		= kc_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 /**
  * pfk_kc_init() - init function
  *
@@ -530,9 +592,12 @@ int pfk_kc_load_key_start(const unsigned char *key, size_t key_size,
 			 * return EBUSY to upper layers so that the
 			 * request will be rescheduled
 			 */
+			kc_stats.busy++;
 			kc_spin_unlock();
 			return -EBUSY;
 		}
+		if (entry->state == INACTIVE)
+			kc_stats.evictions++;
 	} else {
 		entry_exists = true;
 	}
@@ -543,6 +608,7 @@ int pfk_kc_load_key_start(const unsigned char *key, size_t key_size,
 	switch (entry->state) {
 	case (INACTIVE):
 		if (entry_exists) {
+			kc_stats.hits++;
 			kc_update_timestamp(entry);
 			entry->state = ACTIVE_ICE_LOADED;
 
@@ -555,6 +621,7 @@ int pfk_kc_load_key_start(const unsigned char *key, size_t key_size,
 			break;
 		}
 	case (FREE):
+		kc_stats.misses++;
 		ret = kc_update_entry(entry, key, key_size, salt, salt_size,
 					data_unit, ice_rev);
 		if (ret) {
@@ -583,6 +650,7 @@ int pfk_kc_load_key_start(const unsigned char *key, size_t key_size,
 		ret = -EAGAIN;
 		break;
 	case (ACTIVE_ICE_LOADED):
+		kc_stats.hits++;
 		kc_update_timestamp(entry);
 
 		if (!strcmp(s_type, (char *)PFK_UFS)) {
@@ -904,11 +972,15 @@ static int pfk_kc_find_storage_type(char **device)
 
 static int __init pfk_kc_pre_init(void)
 {
+	kc_debugfs = debugfs_create_file("pfk_kc_stats", 0400, NULL, NULL,
+			&kc_stats_fops);
+
 	return pfk_kc_find_storage_type(&s_type);
 }
 
 static void __exit pfk_kc_exit(void)
 {
+	debugfs_remove(kc_debugfs);
 	s_type = NULL;
 }
 
@@ -168,6 +168,12 @@ struct wdsp_mgr_priv {
 	/* List of segments in image to be downloaded */
 	struct list_head *seg_list;
 
+	/*
+	 * Data segments kept loaded from filesystem across WDSP boots,
+	 * protected by ssr_mutex
+	 */
+	struct list_head *data_seg_list;
+
 	/* Base address of the image in memory */
 	u32 base_addr;
 
@@ -189,6 +195,7 @@ struct wdsp_mgr_priv {
 	/* Debugfs related */
 	struct dentry *entry;
 	bool panic_on_error;
+	bool cache_data_segs;
 };
 
 static char *wdsp_get_ssr_type_string(enum wdsp_ssr_type type)
@@ -382,9 +389,11 @@ static int wdsp_download_segments(struct wdsp_mgr_priv *wdsp,
 {
 	struct wdsp_cmpnt *ctl;
 	struct wdsp_img_segment *seg = NULL;
+	struct list_head *seg_list;
 	enum wdsp_event_type pre, post;
 	long status;
-	int ret;
+	bool keep = false;
+	int ret = 0;
 
 	ctl = WDSP_GET_COMPONENT(wdsp, WDSP_CMPNT_CONTROL);
 
@@ -392,22 +401,27 @@ static int wdsp_download_segments(struct wdsp_mgr_priv *wdsp,
 		pre = WDSP_EVENT_PRE_DLOAD_CODE;
 		post = WDSP_EVENT_POST_DLOAD_CODE;
 		status = WDSP_STATUS_CODE_DLOADED;
+		seg_list = wdsp->seg_list;
 	} else if (type == WDSP_ELF_FLAG_WRITE) {
 		pre = WDSP_EVENT_PRE_DLOAD_DATA;
 		post = WDSP_EVENT_POST_DLOAD_DATA;
 		status = WDSP_STATUS_DATA_DLOADED;
+		seg_list = wdsp->data_seg_list;
+		keep = wdsp->cache_data_segs;
 	} else {
 		WDSP_ERR(wdsp, "Invalid type %u", type);
 		return -EINVAL;
 	}
 
-	ret = wdsp_get_segment_list(ctl->cdev, wdsp->img_fname,
-				    type, wdsp->seg_list, &wdsp->base_addr);
+	/* Data segments may already be loaded by wdsp_prefetch_data_segs */
+	if (list_empty(seg_list))
+		ret = wdsp_get_segment_list(ctl->cdev, wdsp->img_fname,
+					    type, seg_list, &wdsp->base_addr);
 
 	pr_info("%s: downloading wdsp firmware: %s.\n", __func__, wdsp->img_fname);
 
 	if (ret < 0 ||
-	    list_empty(wdsp->seg_list)) {
+	    list_empty(seg_list)) {
 		WDSP_ERR(wdsp, "Error %d to get image segments for type %d",
 			 ret, type);
 		wdsp_broadcast_event_downseq(wdsp, WDSP_EVENT_DLOAD_FAILED,
@@ -419,14 +433,15 @@ static int wdsp_download_segments(struct wdsp_mgr_priv *wdsp,
 	wdsp_broadcast_event_upseq(wdsp, pre, NULL);
 
 	/* Go through the list of segments and download one by one */
-	list_for_each_entry(seg, wdsp->seg_list, list) {
+	list_for_each_entry(seg, seg_list, list) {
 		ret = wdsp_load_each_segment(wdsp, seg);
 		if (ret)
 			goto dload_error;
 	}
 
 	/* Flush the list before setting status and notifying components */
-	wdsp_flush_segment_list(wdsp->seg_list);
+	if (!keep)
+		wdsp_flush_segment_list(seg_list);
 
 	WDSP_SET_STATUS(wdsp, status);
 
@@ -436,11 +451,35 @@ done:
 	return ret;
 
 dload_error:
-	wdsp_flush_segment_list(wdsp->seg_list);
+	wdsp_flush_segment_list(seg_list);
 	wdsp_broadcast_event_downseq(wdsp, WDSP_EVENT_DLOAD_FAILED, NULL);
 	return ret;
 }
 
+/*
+ * Read the data segments from filesystem ahead of the first WDSP boot.
+ * Data sections have to be downloaded per boot, with this done the boot
+ * only performs the transfer to WDSP memory.
+ */
+static void wdsp_prefetch_data_segs(struct wdsp_mgr_priv *wdsp)
+{
+	struct wdsp_cmpnt *ctl;
+	u32 base_addr;
+	int ret;
+
+	ctl = WDSP_GET_COMPONENT(wdsp, WDSP_CMPNT_CONTROL);
+
+	WDSP_MGR_MUTEX_LOCK(wdsp, wdsp->ssr_mutex);
+	if (wdsp->cache_data_segs && list_empty(wdsp->data_seg_list)) {
+		ret = wdsp_get_segment_list(ctl->cdev, wdsp->img_fname,
+					    WDSP_ELF_FLAG_WRITE,
+					    wdsp->data_seg_list, &base_addr);
+		if (ret < 0)
+			WDSP_DBG(wdsp, "prefetch failed, err = %d", ret);
+	}
+	WDSP_MGR_MUTEX_UNLOCK(wdsp, wdsp->ssr_mutex);
+}
+
 static int wdsp_init_and_dload_code_sections(struct wdsp_mgr_priv *wdsp)
 {
 	int ret;
@@ -480,8 +519,12 @@ static void wdsp_load_fw_image(struct work_struct *work)
 	}
 
 	ret = wdsp_init_and_dload_code_sections(wdsp);
-	if (ret < 0)
+	if (ret < 0) {
 		WDSP_ERR(wdsp, "dload code sections failed, err = %d", ret);
+		return;
+	}
+
+	wdsp_prefetch_data_segs(wdsp);
 }
 
 static int wdsp_enable_dsp(struct wdsp_mgr_priv *wdsp)
@@ -1072,6 +1115,9 @@ static void wdsp_mgr_debugfs_init(struct wdsp_mgr_priv *wdsp)
 
 	debugfs_create_u32("wdsp_status", S_IRUGO,
 			    wdsp->entry, &wdsp->status);
+
+	debugfs_create_bool("cache_data_segs", 0644,
+			    wdsp->entry, &wdsp->cache_data_segs);
 }
 
 static void wdsp_mgr_debugfs_remove(struct wdsp_mgr_priv *wdsp)
@@ -1128,6 +1174,10 @@ static void wdsp_mgr_unbind(struct device *dev)
 
 	cancel_work_sync(&wdsp->load_fw_work);
 
+	WDSP_MGR_MUTEX_LOCK(wdsp, wdsp->ssr_mutex);
+	wdsp_flush_segment_list(wdsp->data_seg_list);
+	WDSP_MGR_MUTEX_UNLOCK(wdsp, wdsp->ssr_mutex);
+
 	component_unbind_all(dev, wdsp->ops);
 
 	wdsp_mgr_debugfs_remove(wdsp);
@@ -1263,6 +1313,13 @@ static int wdsp_mgr_probe(struct platform_device *pdev)
 		devm_kfree(mdev, wdsp);
 		return -ENOMEM;
 	}
+	wdsp->data_seg_list = devm_kzalloc(mdev, sizeof(struct list_head),
+					   GFP_KERNEL);
+	if (!wdsp->data_seg_list) {
+		devm_kfree(mdev, wdsp->seg_list);
+		devm_kfree(mdev, wdsp);
+		return -ENOMEM;
+	}
 
 	ret = wdsp_mgr_parse_dt_entries(wdsp);
 	if (ret)
@@ -1270,6 +1327,8 @@ static int wdsp_mgr_probe(struct platform_device *pdev)
 
 	INIT_WORK(&wdsp->load_fw_work, wdsp_load_fw_image);
 	INIT_LIST_HEAD(wdsp->seg_list);
+	INIT_LIST_HEAD(wdsp->data_seg_list);
+	wdsp->cache_data_segs = true;
 	mutex_init(&wdsp->api_mutex);
 	mutex_init(&wdsp->ssr_mutex);
 	wdsp->ssr_type = WDSP_SSR_TYPE_NO_SSR;
@@ -1292,6 +1351,7 @@ err_master_add:
 	mutex_destroy(&wdsp->api_mutex);
 	mutex_destroy(&wdsp->ssr_mutex);
 err_dt_parse:
+	devm_kfree(mdev, wdsp->data_seg_list);
 	devm_kfree(mdev, wdsp->seg_list);
 	devm_kfree(mdev, wdsp);
 	dev_set_drvdata(mdev, NULL);
@@ -1308,6 +1368,7 @@ static int wdsp_mgr_remove(struct platform_device *pdev)
 
 	mutex_destroy(&wdsp->api_mutex);
 	mutex_destroy(&wdsp->ssr_mutex);
+	devm_kfree(mdev, wdsp->data_seg_list);
 	devm_kfree(mdev, wdsp->seg_list);
 	devm_kfree(mdev, wdsp);
 	dev_set_drvdata(mdev, NULL);
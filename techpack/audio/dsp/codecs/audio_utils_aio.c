@@ -31,6 +31,16 @@
 #include <linux/qdsp6v2/audio_dev_ctl.h>
 #endif /*CONFIG_USE_DEV_CTRL_VOLUME*/
 static DEFINE_MUTEX(lock);
+
+/*
+ * In tunnel mode, wake up the client for WRITE_DONE only once half of the
+ * buffers it keeps queued are consumed, so that the returned buffers are
+ * refilled in one go instead of one wakeup per DSP ack.
+ */
+static bool coalesce_write_done = true;
+module_param(coalesce_write_done, bool, 0644);
+MODULE_PARM_DESC(coalesce_write_done,
+	"Coalesce tunnel mode WRITE_DONE wakeups");
 #ifdef CONFIG_DEBUG_FS
 
 int audio_aio_debug_open(struct inode *inode, struct file *file)
@@ -89,6 +99,9 @@ static long audio_aio_compat_ioctl(struct file *file, unsigned int cmd,
 #else
 #define audio_aio_compat_ioctl NULL
 #endif
+static void __audio_aio_post_event(struct q6audio_aio *audio, int type,
+			union msm_audio_event_payload payload, bool wake);
+
 int insert_eos_buf(struct q6audio_aio *audio,
 		struct audio_aio_buffer_node *buf_node)
 {
@@ -280,6 +293,7 @@ void audio_aio_async_write_ack(struct q6audio_aio *audio, uint32_t token,
 	unsigned long flags;
 	union msm_audio_event_payload event_payload;
 	struct audio_aio_buffer_node *used_buf;
+	bool wake;
 
 	/* No active flush in progress */
 	if (audio->wflush)
@@ -295,11 +309,15 @@ void audio_aio_async_write_ack(struct q6audio_aio *audio, uint32_t token,
 					struct audio_aio_buffer_node, list);
 	if (token == used_buf->token) {
 		list_del(&used_buf->list);
+		audio->out_count--;
+		wake = audio->feedback != TUNNEL_MODE ||
+			!coalesce_write_done ||
+			audio->out_count <= audio->out_count_max / 2;
 		spin_unlock_irqrestore(&audio->dsp_lock, flags);
 		pr_debug("%s[%pK]:consumed buffer\n", __func__, audio);
 		event_payload.aio_buf = used_buf->buf;
-		audio_aio_post_event(audio, AUDIO_EVENT_WRITE_DONE,
-					event_payload);
+		__audio_aio_post_event(audio, AUDIO_EVENT_WRITE_DONE,
+					event_payload, wake);
 		kfree(used_buf);
 		if (list_empty(&audio->out_queue) &&
 			(audio->drv_status & ADRV_STATUS_FSYNC)) {
@@ -346,6 +364,8 @@ void audio_aio_async_out_flush(struct q6audio_aio *audio)
 		pr_debug("%s[%pK]: Propagate WRITE_DONE during flush\n",
 				__func__, audio);
 	}
+	audio->out_count = 0;
+	audio->out_count_max = 0;
 }
 
 void audio_aio_async_in_flush(struct q6audio_aio *audio)
@@ -1111,8 +1131,8 @@ static int audio_aio_async_write(struct q6audio_aio *audio,
 	return rc;
 }
 
-void audio_aio_post_event(struct q6audio_aio *audio, int type,
-			union msm_audio_event_payload payload)
+static void __audio_aio_post_event(struct q6audio_aio *audio, int type,
+			union msm_audio_event_payload payload, bool wake)
 {
 	struct audio_aio_event *e_node = NULL;
 	unsigned long flags;
@@ -1136,7 +1156,14 @@ void audio_aio_post_event(struct q6audio_aio *audio, int type,
 
 	list_add_tail(&e_node->list, &audio->event_queue);
 	spin_unlock_irqrestore(&audio->event_queue_lock, flags);
-	wake_up(&audio->event_wait);
+	if (wake)
+		wake_up(&audio->event_wait);
+}
+
+void audio_aio_post_event(struct q6audio_aio *audio, int type,
+			union msm_audio_event_payload payload)
+{
+	__audio_aio_post_event(audio, type, payload, true);
 }
 
 static int audio_aio_async_read(struct q6audio_aio *audio,
@@ -1191,6 +1218,8 @@ static int audio_aio_buf_add_shared(struct q6audio_aio *audio, u32 dir,
 			ret = audio_aio_async_write(audio, buf_node);
 			/* EOS buffer handled in driver */
 			list_add_tail(&buf_node->list, &audio->out_queue);
+			if (++audio->out_count > audio->out_count_max)
+				audio->out_count_max = audio->out_count;
 			spin_unlock_irqrestore(&audio->dsp_lock, flags);
 		} else if (buf_node->meta_info.meta_in.nflags
 				   & AUDIO_DEC_EOS_SET) {
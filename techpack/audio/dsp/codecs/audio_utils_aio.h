@@ -178,6 +178,8 @@ struct q6audio_aio {
 	struct dentry *dentry;
 #endif
 	struct list_head out_queue;     /* queue to retain output buffers */
+	uint32_t out_count;             /* buffers in out_queue */
+	uint32_t out_count_max;         /* out_count high watermark */
 	struct list_head in_queue;      /* queue to retain input buffers */
 	struct list_head free_event_queue;
 	struct list_head event_queue;
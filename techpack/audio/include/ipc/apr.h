@@ -171,6 +171,7 @@ inline int apr_fill_hdr(void *handle, uint32_t *buf, uint16_t src_port,
 			uint32_t token, uint32_t opcode, uint16_t len);
 
 int apr_send_pkt(void *handle, uint32_t *buf);
+int apr_send_pkts(void *handle, uint32_t **bufs, int num);
 int apr_deregister(void *handle);
 void subsys_notif_register(char *client_name, int domain,
 			   struct notifier_block *nb);
@@ -351,21 +351,8 @@ struct apr_client *apr_get_client(int dest_id, int client_id)
 	return &client[dest_id][client_id];
 }
 
-int apr_send_pkt(void *handle, uint32_t *buf)
+static int apr_check_svc_up(struct apr_svc *svc)
 {
-	struct apr_svc *svc = handle;
-	struct apr_client *clnt;
-	struct apr_hdr *hdr;
-	uint16_t dest_id;
-	uint16_t client_id;
-	uint16_t w_len;
-	int rc;
-	unsigned long flags;
-
-	if (!handle || !buf) {
-		pr_err("APR: Wrong parameters\n");
-		return -EINVAL;
-	}
 	if (svc->need_reset) {
 		pr_err_ratelimited("apr: send_pkt service need reset\n");
 		return -ENETRESET;
@@ -381,16 +368,17 @@ int apr_send_pkt(void *handle, uint32_t *buf)
 		return -ENETRESET;
 	}
 
-	spin_lock_irqsave(&svc->w_lock, flags);
-	dest_id = svc->dest_id;
-	client_id = svc->client_id;
-	clnt = &client[dest_id][client_id];
+	return 0;
+}
+
+/* called with svc->w_lock held */
+static int __apr_send_pkt(struct apr_svc *svc, struct apr_client *clnt,
+			  uint32_t *buf)
+{
+	struct apr_hdr *hdr;
+	uint16_t w_len;
+	int rc;
 
-	if (!client[dest_id][client_id].handle) {
-		pr_err("APR: Still service is not yet opened\n");
-		spin_unlock_irqrestore(&svc->w_lock, flags);
-		return -EINVAL;
-	}
 	hdr = (struct apr_hdr *)buf;
 
 	hdr->src_domain = APR_DOMAIN_APPS;
@@ -420,11 +408,91 @@ int apr_send_pkt(void *handle, uint32_t *buf)
 		pr_err("%s: Write APR pkt failed with error %d\n",
 			__func__, rc);
 	}
+
+	return rc;
+}
+
+int apr_send_pkt(void *handle, uint32_t *buf)
+{
+	struct apr_svc *svc = handle;
+	struct apr_client *clnt;
+	int rc;
+	unsigned long flags;
+
+	if (!handle || !buf) {
+		pr_err("APR: Wrong parameters\n");
+		return -EINVAL;
+	}
+
+	rc = apr_check_svc_up(svc);
+	if (rc)
+		return rc;
+
+	spin_lock_irqsave(&svc->w_lock, flags);
+	clnt = &client[svc->dest_id][svc->client_id];
+
+	if (!clnt->handle) {
+		pr_err("APR: Still service is not yet opened\n");
+		spin_unlock_irqrestore(&svc->w_lock, flags);
+		return -EINVAL;
+	}
+
+	rc = __apr_send_pkt(svc, clnt, buf);
 	spin_unlock_irqrestore(&svc->w_lock, flags);
 
 	return rc;
 }
 
+/**
+ * apr_send_pkts - send several APR packets back to back
+ * @handle: APR service handle
+ * @bufs: array of APR packets, each starting with struct apr_hdr
+ * @num: number of packets in @bufs
+ *
+ * Packets are sent in order under a single service lock hold, so that the
+ * caller can issue independent commands and then wait for all responses
+ * at once, matching them by token. The DSP routes APR on packet
+ * boundaries, so each packet is still one transport transfer.
+ *
+ * Returns number of packets sent; a short count means the packet at that
+ * index failed and the following ones were not sent. Returns negative
+ * error if none was sent.
+ */
+int apr_send_pkts(void *handle, uint32_t **bufs, int num)
+{
+	struct apr_svc *svc = handle;
+	struct apr_client *clnt;
+	int i, rc;
+	unsigned long flags;
+
+	if (!handle || !bufs || num <= 0) {
+		pr_err("APR: Wrong parameters\n");
+		return -EINVAL;
+	}
+
+	rc = apr_check_svc_up(svc);
+	if (rc)
+		return rc;
+
+	spin_lock_irqsave(&svc->w_lock, flags);
+	clnt = &client[svc->dest_id][svc->client_id];
+
+	if (!clnt->handle) {
+		pr_err("APR: Still service is not yet opened\n");
+		spin_unlock_irqrestore(&svc->w_lock, flags);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < num; i++) {
+		rc = __apr_send_pkt(svc, clnt, bufs[i]);
+		if (rc < 0)
+			break;
+	}
+	spin_unlock_irqrestore(&svc->w_lock, flags);
+
+	return i ? i : rc;
+}
+
 int apr_pkt_config(void *handle, struct apr_pkt_cfg *cfg)
 {
 	struct apr_svc *svc = (struct apr_svc *)handle;
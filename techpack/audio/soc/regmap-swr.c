@@ -21,6 +21,27 @@
 #include <soc/internal.h>
 
 
+static int regmap_swr_bulk_gather_write(struct swr_device *swr,
+					u16 reg_addr, const u8 *val,
+					size_t num_regs)
+{
+	u16 *reg;
+	int i, ret;
+
+	reg = kcalloc(num_regs, sizeof(u16), GFP_KERNEL);
+	if (!reg)
+		return -ENOMEM;
+
+	for (i = 0; i < num_regs; i++)
+		reg[i] = reg_addr + i;
+
+	/* queue all commands to the master FIFO and wait once */
+	ret = swr_bulk_write(swr, swr->dev_num, reg, val, num_regs);
+
+	kfree(reg);
+	return ret;
+}
+
 static int regmap_swr_gather_write(void *context,
 				const void *reg, size_t reg_size,
 				const void *val, size_t val_len)
@@ -50,6 +71,15 @@ static int regmap_swr_gather_write(void *context,
 	}
 	reg_addr = *(u16 *)reg;
 	val_bytes = map->format.val_bytes;
+	if (val_bytes == 1 && swr->dev_num && val_len > 1) {
+		ret = regmap_swr_bulk_gather_write(swr, reg_addr, val, val_len);
+		if (ret != -EOPNOTSUPP) {
+			if (ret)
+				dev_err(dev, "%s: bulk write reg 0x%x failed, err %d\n",
+					__func__, reg_addr, ret);
+			return ret;
+		}
+	}
 	/* val_len = val_bytes * val_count */
 	for (i = 0; i < (val_len / val_bytes); i++) {
 		value = (u8 *)val + (val_bytes * i);
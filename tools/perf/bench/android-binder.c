@@ -0,0 +1,411 @@
+/*
+ * android-binder.c
+ *
+ * binder: Benchmark for binder transactions
+ *
+ * A server process registers as the context manager of a binder device
+ * and answers every transaction with a reply of the same size. Client
+ * threads send synchronous transactions to handle 0 and time each round
+ * trip, with 1, 2, 4, ... threads up to the number of cpus.
+ *
+ * The device must not have a context manager yet. On Android, add a spare
+ * device with the binder.devices= kernel parameter.
+ */
+#include "../perf.h"
+#include "../util/util.h"
+#include <subcmd/parse-options.h>
+#include "../builtin.h"
+#include "bench.h"
+#include "android.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <linux/android/binder.h>
+
+#define BINDER_BENCH_MAP_SIZE	(1024 * 1024)
+#define BINDER_BENCH_READ_SIZE	256
+
+static const char	*device = "/dev/binder";
+static unsigned int	nthreads;
+static unsigned int	loops = 10000;
+static unsigned int	size = 64;
+
+static const struct option options[] = {
+	OPT_STRING('d', "device", &device, "path", "Binder device without a context manager"),
+	OPT_UINTEGER('t', "threads", &nthreads, "Specify amount of client threads, default 1 up to nr cpus"),
+	OPT_UINTEGER('l', "loops", &loops, "Specify number of transactions per thread"),
+	OPT_UINTEGER('s', "size", &size, "Specify transaction and reply size in bytes"),
+	OPT_END()
+};
+
+static const char * const bench_android_binder_usage[] = {
+	"perf bench android binder <options>",
+	NULL
+};
+
+struct binder_cmd_txn {
+	__u32				cmd;
+	struct binder_transaction_data	txn;
+} __attribute__((packed));
+
+struct binder_cmd_free {
+	__u32				cmd;
+	binder_uintptr_t		buffer;
+} __attribute__((packed));
+
+struct client_data {
+	pthread_t			thread;
+	u64				*samples;
+	int				err;
+};
+
+static int	binder_fd = -1;
+static void	*payload;
+
+static int binder_open(void)
+{
+	struct binder_version version;
+	void *map;
+	int fd;
+
+	fd = open(device, O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	if (ioctl(fd, BINDER_VERSION, &version) < 0 ||
+	    version.protocol_version != BINDER_CURRENT_PROTOCOL_VERSION) {
+		close(fd);
+		return -EPROTO;
+	}
+
+	map = mmap(NULL, BINDER_BENCH_MAP_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		close(fd);
+		return -ENOMEM;
+	}
+
+	return fd;
+}
+
+static int binder_write_read(struct binder_write_read *bwr)
+{
+	while (ioctl(binder_fd, BINDER_WRITE_READ, bwr) < 0) {
+		if (errno != EINTR)
+			return -errno;
+	}
+
+	return 0;
+}
+
+static void binder_put_free(u8 *wbuf, size_t *wlen, binder_uintptr_t buffer)
+{
+	struct binder_cmd_free cmd = {
+		.cmd	= BC_FREE_BUFFER,
+		.buffer	= buffer,
+	};
+
+	memcpy(wbuf + *wlen, &cmd, sizeof(cmd));
+	*wlen += sizeof(cmd);
+}
+
+static void binder_put_txn(u8 *wbuf, size_t *wlen, __u32 bc)
+{
+	struct binder_cmd_txn cmd;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cmd = bc;
+	cmd.txn.target.handle = 0;
+	cmd.txn.code = 1;
+	cmd.txn.data_size = size;
+	cmd.txn.data.ptr.buffer = (binder_uintptr_t)payload;
+
+	memcpy(wbuf + *wlen, &cmd, sizeof(cmd));
+	*wlen += sizeof(cmd);
+}
+
+/* answer every transaction, until the parent kills the process */
+static void *server_thread(void *arg __maybe_unused)
+{
+	struct binder_transaction_data *tr;
+	u8 wbuf[sizeof(struct binder_cmd_free) + sizeof(struct binder_cmd_txn)];
+	u8 rbuf[BINDER_BENCH_READ_SIZE];
+	struct binder_write_read bwr;
+	size_t wlen = 0, pos;
+	__u32 cmd;
+
+	cmd = BC_ENTER_LOOPER;
+	memcpy(wbuf, &cmd, sizeof(cmd));
+	wlen = sizeof(cmd);
+
+	for (;;) {
+		memset(&bwr, 0, sizeof(bwr));
+		bwr.write_size = wlen;
+		bwr.write_buffer = (binder_uintptr_t)wbuf;
+		bwr.read_size = sizeof(rbuf);
+		bwr.read_buffer = (binder_uintptr_t)rbuf;
+		if (binder_write_read(&bwr))
+			err(EXIT_FAILURE, "server BINDER_WRITE_READ");
+		wlen = 0;
+
+		for (pos = 0; pos + sizeof(cmd) <= bwr.read_consumed; ) {
+			memcpy(&cmd, rbuf + pos, sizeof(cmd));
+			pos += sizeof(cmd);
+
+			switch (cmd) {
+			case BR_NOOP:
+			case BR_TRANSACTION_COMPLETE:
+			case BR_SPAWN_LOOPER:
+				break;
+			case BR_INCREFS:
+			case BR_ACQUIRE:
+			case BR_RELEASE:
+			case BR_DECREFS:
+				pos += sizeof(struct binder_ptr_cookie);
+				break;
+			case BR_TRANSACTION:
+				tr = (struct binder_transaction_data *)(rbuf + pos);
+				pos += sizeof(*tr);
+				binder_put_free(wbuf, &wlen, tr->data.ptr.buffer);
+				binder_put_txn(wbuf, &wlen, BC_REPLY);
+				break;
+			default:
+				errx(EXIT_FAILURE, "server: unexpected binder return 0x%x", cmd);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* become the context manager, then tell the parent through @ready */
+static void server_run(int ready, unsigned int nr)
+{
+	pthread_t *threads;
+	unsigned int i;
+	int ret = 0;
+
+	binder_fd = binder_open();
+	if (binder_fd < 0)
+		ret = -binder_fd;
+	else if (ioctl(binder_fd, BINDER_SET_CONTEXT_MGR, 0) < 0)
+		ret = errno;
+
+	threads = calloc(nr, sizeof(*threads));
+	if (!ret && !threads)
+		ret = ENOMEM;
+
+	for (i = 0; !ret && i < nr; i++)
+		if (pthread_create(&threads[i], NULL, server_thread, NULL))
+			ret = EAGAIN;
+
+	if (write(ready, &ret, sizeof(ret)) != sizeof(ret) || ret)
+		exit(EXIT_FAILURE);
+
+	for (i = 0; i < nr; i++)
+		pthread_join(threads[i], NULL);
+	exit(EXIT_SUCCESS);
+}
+
+/* one synchronous transaction, freeing the previous reply on the way */
+static int client_transact(binder_uintptr_t *reply)
+{
+	struct binder_transaction_data *tr;
+	u8 wbuf[sizeof(struct binder_cmd_free) + sizeof(struct binder_cmd_txn)];
+	u8 rbuf[BINDER_BENCH_READ_SIZE];
+	struct binder_write_read bwr;
+	size_t wlen = 0, pos;
+	__u32 cmd;
+	int ret;
+
+	if (*reply)
+		binder_put_free(wbuf, &wlen, *reply);
+	binder_put_txn(wbuf, &wlen, BC_TRANSACTION);
+	*reply = 0;
+
+	memset(&bwr, 0, sizeof(bwr));
+	bwr.write_size = wlen;
+	bwr.write_buffer = (binder_uintptr_t)wbuf;
+	bwr.read_size = sizeof(rbuf);
+	bwr.read_buffer = (binder_uintptr_t)rbuf;
+
+	for (;;) {
+		ret = binder_write_read(&bwr);
+		if (ret)
+			return ret;
+
+		for (pos = 0; pos + sizeof(cmd) <= bwr.read_consumed; ) {
+			memcpy(&cmd, rbuf + pos, sizeof(cmd));
+			pos += sizeof(cmd);
+
+			switch (cmd) {
+			case BR_NOOP:
+			case BR_TRANSACTION_COMPLETE:
+				break;
+			case BR_REPLY:
+				tr = (struct binder_transaction_data *)(rbuf + pos);
+				*reply = tr->data.ptr.buffer;
+				return 0;
+			case BR_DEAD_REPLY:
+			case BR_FAILED_REPLY:
+				return -EPIPE;
+			default:
+				return -EPROTO;
+			}
+		}
+
+		bwr.write_size = 0;
+		bwr.write_consumed = 0;
+		bwr.read_consumed = 0;
+	}
+}
+
+static void *client_thread(void *arg)
+{
+	struct client_data *cd = arg;
+	binder_uintptr_t reply = 0;
+	size_t wlen = 0;
+	u8 wbuf[sizeof(struct binder_cmd_free)];
+	struct binder_write_read bwr;
+	unsigned int i;
+	u64 start;
+
+	for (i = 0; i < loops; i++) {
+		start = android_bench_now();
+		cd->err = client_transact(&reply);
+		if (cd->err)
+			return NULL;
+		cd->samples[i] = android_bench_now() - start;
+	}
+
+	binder_put_free(wbuf, &wlen, reply);
+	memset(&bwr, 0, sizeof(bwr));
+	bwr.write_size = wlen;
+	bwr.write_buffer = (binder_uintptr_t)wbuf;
+	cd->err = binder_write_read(&bwr);
+
+	return NULL;
+}
+
+static int run_clients(unsigned int nr, u64 *samples)
+{
+	struct client_data *cd;
+	unsigned int i;
+	u64 start, runtime;
+	int ret = 0;
+
+	cd = calloc(nr, sizeof(*cd));
+	if (!cd)
+		err(EXIT_FAILURE, "calloc");
+
+	start = android_bench_now();
+	for (i = 0; i < nr; i++) {
+		cd[i].samples = samples + (u64)i * loops;
+		if (pthread_create(&cd[i].thread, NULL, client_thread, &cd[i]))
+			err(EXIT_FAILURE, "pthread_create");
+	}
+
+	for (i = 0; i < nr; i++) {
+		pthread_join(cd[i].thread, NULL);
+		if (cd[i].err && !ret)
+			ret = cd[i].err;
+	}
+	runtime = android_bench_now() - start;
+
+	if (ret) {
+		fprintf(stderr, "binder transaction failed: %s\n", strerror(-ret));
+		goto out;
+	}
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u threads: %.0f transactions/sec\n", nr,
+		       (double)nr * loops * NSEC_PER_SEC / runtime);
+	else
+		printf("%u %.0f\n", nr, (double)nr * loops * NSEC_PER_SEC / runtime);
+	android_bench_print_latency("round trip", samples, nr * loops);
+
+out:
+	free(cd);
+	return ret;
+}
+
+int bench_android_binder(int argc, const char **argv, const char *prefix __maybe_unused)
+{
+	unsigned int ncpus, max_threads, nr;
+	int ready[2], ret;
+	u64 *samples;
+	pid_t pid;
+
+	argc = parse_options(argc, argv, options, bench_android_binder_usage, 0);
+	if (argc) {
+		usage_with_options(bench_android_binder_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	max_threads = nthreads ?: ncpus;
+
+	payload = calloc(1, size ?: 1);
+	samples = calloc((u64)max_threads * loops, sizeof(*samples));
+	if (!payload || !samples)
+		err(EXIT_FAILURE, "calloc");
+
+	if (pipe(ready))
+		err(EXIT_FAILURE, "pipe");
+
+	pid = fork();
+	if (pid < 0)
+		err(EXIT_FAILURE, "fork");
+	if (!pid) {
+		close(ready[0]);
+		server_run(ready[1], max_threads);
+	}
+
+	close(ready[1]);
+	if (read(ready[0], &ret, sizeof(ret)) != sizeof(ret))
+		ret = EPIPE;
+	close(ready[0]);
+	if (ret) {
+		fprintf(stderr, "%s: can't become context manager: %s\n",
+			device, strerror(ret));
+		goto out;
+	}
+
+	binder_fd = binder_open();
+	if (binder_fd < 0) {
+		ret = -binder_fd;
+		fprintf(stderr, "%s: %s\n", device, strerror(ret));
+		goto out;
+	}
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u transactions per thread, %u bytes each way, on %s\n\n",
+		       loops, size, device);
+
+	if (nthreads) {
+		ret = run_clients(nthreads, samples);
+	} else {
+		for (nr = 1; nr < ncpus && !ret; nr *= 2)
+			ret = run_clients(nr, samples);
+		if (!ret)
+			ret = run_clients(ncpus, samples);
+	}
+
+	close(binder_fd);
+out:
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+	free(samples);
+	free(payload);
+	return ret ? EXIT_FAILURE : 0;
+}
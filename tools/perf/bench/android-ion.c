@@ -0,0 +1,171 @@
+/*
+ * android-ion.c
+ *
+ * ion: Benchmark for ION buffer allocate, map and free cycles
+ *
+ * Each cycle allocates a buffer from the chosen heaps, exports it as a
+ * dma-buf, maps it and touches every page, then unmaps and frees it, the
+ * way a camera or graphics buffer is used. The three steps are timed
+ * separately, so the page pools and the heap allocators can be told apart.
+ */
+#include "../perf.h"
+#include "../util/util.h"
+#include <subcmd/parse-options.h>
+#include "../builtin.h"
+#include "bench.h"
+#include "android.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+/* the legacy ION ABI, from drivers/staging/android/uapi/ion.h */
+typedef int ion_user_handle_t;
+
+struct ion_allocation_data {
+	size_t			len;
+	size_t			align;
+	unsigned int		heap_id_mask;
+	unsigned int		flags;
+	ion_user_handle_t	handle;
+};
+
+struct ion_fd_data {
+	ion_user_handle_t	handle;
+	int			fd;
+};
+
+struct ion_handle_data {
+	ion_user_handle_t	handle;
+};
+
+#define ION_IOC_MAGIC		'I'
+#define ION_IOC_ALLOC		_IOWR(ION_IOC_MAGIC, 0, struct ion_allocation_data)
+#define ION_IOC_FREE		_IOWR(ION_IOC_MAGIC, 1, struct ion_handle_data)
+#define ION_IOC_SHARE		_IOWR(ION_IOC_MAGIC, 4, struct ion_fd_data)
+#define ION_FLAG_CACHED		1
+
+/* ION_SYSTEM_HEAP_ID on msm */
+#define ION_BENCH_DEFAULT_HEAPS	(1U << 25)
+
+static const char	*device = "/dev/ion";
+static unsigned int	heap_mask = ION_BENCH_DEFAULT_HEAPS;
+static unsigned int	loops = 1000;
+static unsigned int	size_kb = 1024;
+static bool		cached;
+
+static const struct option options[] = {
+	OPT_STRING('d', "device", &device, "path", "ION device"),
+	OPT_UINTEGER('H', "heaps", &heap_mask, "Specify the heap id mask to allocate from"),
+	OPT_UINTEGER('l', "loops", &loops, "Specify number of allocate/map/free cycles"),
+	OPT_UINTEGER('s', "size", &size_kb, "Specify buffer size in KB"),
+	OPT_BOOLEAN('c', "cached", &cached, "Allocate cached buffers"),
+	OPT_END()
+};
+
+static const char * const bench_android_ion_usage[] = {
+	"perf bench android ion <options>",
+	NULL
+};
+
+int bench_android_ion(int argc, const char **argv, const char *prefix __maybe_unused)
+{
+	struct ion_allocation_data alloc;
+	struct ion_handle_data handle;
+	struct ion_fd_data share;
+	u64 *alloc_ns, *map_ns, *free_ns;
+	size_t len, off, page_size;
+	unsigned int i;
+	u64 t0, t1, t2;
+	int ion_fd, ret = 0;
+	char *map;
+
+	argc = parse_options(argc, argv, options, bench_android_ion_usage, 0);
+	if (argc || !loops || !size_kb) {
+		usage_with_options(bench_android_ion_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	ion_fd = open(device, O_RDONLY | O_CLOEXEC);
+	if (ion_fd < 0) {
+		fprintf(stderr, "%s: %s\n", device, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	alloc_ns = calloc(loops, sizeof(*alloc_ns));
+	map_ns = calloc(loops, sizeof(*map_ns));
+	free_ns = calloc(loops, sizeof(*free_ns));
+	if (!alloc_ns || !map_ns || !free_ns)
+		err(EXIT_FAILURE, "calloc");
+
+	len = (size_t)size_kb * 1024;
+	page_size = sysconf(_SC_PAGESIZE);
+
+	for (i = 0; i < loops; i++) {
+		t0 = android_bench_now();
+
+		memset(&alloc, 0, sizeof(alloc));
+		alloc.len = len;
+		alloc.align = page_size;
+		alloc.heap_id_mask = heap_mask;
+		alloc.flags = cached ? ION_FLAG_CACHED : 0;
+		if (ioctl(ion_fd, ION_IOC_ALLOC, &alloc) < 0) {
+			ret = errno;
+			fprintf(stderr, "ION_IOC_ALLOC: %s\n", strerror(ret));
+			break;
+		}
+
+		share.handle = alloc.handle;
+		handle.handle = alloc.handle;
+		if (ioctl(ion_fd, ION_IOC_SHARE, &share) < 0) {
+			ret = errno;
+			fprintf(stderr, "ION_IOC_SHARE: %s\n", strerror(ret));
+			ioctl(ion_fd, ION_IOC_FREE, &handle);
+			break;
+		}
+		t1 = android_bench_now();
+
+		map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   share.fd, 0);
+		if (map == MAP_FAILED) {
+			ret = errno;
+			fprintf(stderr, "mmap: %s\n", strerror(ret));
+			close(share.fd);
+			ioctl(ion_fd, ION_IOC_FREE, &handle);
+			break;
+		}
+		for (off = 0; off < len; off += page_size)
+			map[off] = 1;
+		t2 = android_bench_now();
+
+		munmap(map, len);
+		close(share.fd);
+		ioctl(ion_fd, ION_IOC_FREE, &handle);
+
+		alloc_ns[i] = t1 - t0;
+		map_ns[i] = t2 - t1;
+		free_ns[i] = android_bench_now() - t2;
+	}
+
+	if (!ret) {
+		if (bench_format == BENCH_FORMAT_DEFAULT)
+			printf("# %u cycles of %u KB %s buffers, heap mask 0x%x\n\n",
+			       loops, size_kb, cached ? "cached" : "uncached",
+			       heap_mask);
+		android_bench_print_latency("alloc", alloc_ns, loops);
+		android_bench_print_latency("map+touch", map_ns, loops);
+		android_bench_print_latency("free", free_ns, loops);
+	}
+
+	free(free_ns);
+	free(map_ns);
+	free(alloc_ns);
+	close(ion_fd);
+	return ret ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * android-zram.c
+ *
+ * zram: Benchmark for zram swap-out and swap-in
+ *
+ * Writes a corpus of pages resembling anonymous memory of Android apps to
+ * a zram device, one page per direct write as swap does, then reads them
+ * back in random order and checks them. Each write times a compression,
+ * each read a decompression. The corpus mixes zero, sparse, text, pointer
+ * heavy and random pages, and no two pages are identical so that
+ * deduplication doesn't skew the result.
+ *
+ * The device is overwritten: use one that isn't swap or mounted. Opening
+ * it exclusively fails if it is.
+ */
+#include "../perf.h"
+#include "../util/util.h"
+#include <subcmd/parse-options.h>
+#include "../builtin.h"
+#include "bench.h"
+#include "android.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+static const char	*device;
+static unsigned int	nr_pages = 16384;
+
+static const struct option options[] = {
+	OPT_STRING('d', "device", &device, "path", "Unused zram device, it is overwritten"),
+	OPT_UINTEGER('n', "pages", &nr_pages, "Specify number of pages to swap out and in"),
+	OPT_END()
+};
+
+static const char * const bench_android_zram_usage[] = {
+	"perf bench android zram -d <device> <options>",
+	NULL
+};
+
+enum page_kind {
+	PAGE_ZERO,
+	PAGE_SPARSE,
+	PAGE_TEXT,
+	PAGE_POINTERS,
+	PAGE_RANDOM,
+};
+
+/* rough share of each kind in a swapped out app heap, per 16 pages */
+static const enum page_kind corpus[16] = {
+	PAGE_ZERO, PAGE_ZERO, PAGE_ZERO, PAGE_ZERO,
+	PAGE_SPARSE, PAGE_SPARSE, PAGE_SPARSE,
+	PAGE_TEXT, PAGE_TEXT, PAGE_TEXT,
+	PAGE_POINTERS, PAGE_POINTERS, PAGE_POINTERS, PAGE_POINTERS,
+	PAGE_RANDOM, PAGE_RANDOM,
+};
+
+static size_t page_size;
+
+static u64 corpus_rand(u64 *state)
+{
+	/* xorshift64, the same sequence for a page on write and on check */
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+static void corpus_fill(u8 *buf, unsigned int index)
+{
+	static const char words[] = "android.view.View mContext = null; return true; ";
+	u64 state = 0x9e3779b97f4a7c15ULL * (index + 1);
+	u64 *p = (u64 *)buf;
+	size_t i;
+
+	memset(buf, 0, page_size);
+
+	switch (corpus[index % ARRAY_SIZE(corpus)]) {
+	case PAGE_ZERO:
+		/* a freshly faulted page, zram keeps only a flag */
+		break;
+	case PAGE_SPARSE:
+		for (i = 0; i < page_size / 8; i += 32)
+			p[i] = corpus_rand(&state);
+		break;
+	case PAGE_TEXT:
+		for (i = 0; i < page_size; i++)
+			buf[i] = words[(i + index) % (sizeof(words) - 1)];
+		p[0] = index;
+		break;
+	case PAGE_POINTERS:
+		for (i = 0; i < page_size / 8; i++)
+			p[i] = (i & 3) ? 0x7f00000000ULL + ((corpus_rand(&state) & 0xffff) << 4)
+				       : i;
+		break;
+	case PAGE_RANDOM:
+	default:
+		for (i = 0; i < page_size / 8; i++)
+			p[i] = corpus_rand(&state);
+		break;
+	}
+}
+
+static int read_mm_stat(u64 *orig, u64 *compr)
+{
+	const char *name = strrchr(device, '/');
+	char path[PATH_MAX];
+	unsigned long long o = 0, c = 0;
+	FILE *f;
+	int ret;
+
+	snprintf(path, sizeof(path), "/sys/block/%s/mm_stat",
+		 name ? name + 1 : device);
+	f = fopen(path, "r");
+	if (!f)
+		return -errno;
+
+	ret = fscanf(f, "%llu %llu", &o, &c) == 2 ? 0 : -EINVAL;
+	fclose(f);
+
+	*orig = o;
+	*compr = c;
+	return ret;
+}
+
+int bench_android_zram(int argc, const char **argv, const char *prefix __maybe_unused)
+{
+	u64 *out_ns, *in_ns, start, runtime_out = 0, runtime_in = 0;
+	u64 orig0 = 0, compr0 = 0, orig1 = 0, compr1 = 0;
+	unsigned int *order, i, j, tmp;
+	u8 *wbuf, *rbuf, *check;
+	u64 range[2], state = 1;
+	int fd, ret = 0;
+	off_t off;
+
+	argc = parse_options(argc, argv, options, bench_android_zram_usage, 0);
+	if (argc || !nr_pages) {
+		usage_with_options(bench_android_zram_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	if (!device) {
+		fprintf(stderr, "zram: specify an unused zram device with -d\n");
+		return EXIT_FAILURE;
+	}
+
+	fd = open(device, O_RDWR | O_DIRECT | O_EXCL | O_CLOEXEC);
+	if (fd < 0) {
+		fprintf(stderr, "%s: %s\n", device, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+	out_ns = calloc(nr_pages, sizeof(*out_ns));
+	in_ns = calloc(nr_pages, sizeof(*in_ns));
+	order = calloc(nr_pages, sizeof(*order));
+	check = malloc(page_size);
+	if (!out_ns || !in_ns || !order || !check ||
+	    posix_memalign((void **)&wbuf, page_size, page_size) ||
+	    posix_memalign((void **)&rbuf, page_size, page_size))
+		err(EXIT_FAILURE, "alloc");
+
+	read_mm_stat(&orig0, &compr0);
+
+	for (i = 0; i < nr_pages; i++) {
+		corpus_fill(wbuf, i);
+		off = (off_t)i * page_size;
+
+		start = android_bench_now();
+		if (pwrite(fd, wbuf, page_size, off) != (ssize_t)page_size) {
+			ret = errno ?: ENOSPC;
+			fprintf(stderr, "write of page %u: %s\n", i, strerror(ret));
+			goto out;
+		}
+		out_ns[i] = android_bench_now() - start;
+		runtime_out += out_ns[i];
+	}
+
+	read_mm_stat(&orig1, &compr1);
+
+	/* swap-in faults come in any order */
+	for (i = 0; i < nr_pages; i++)
+		order[i] = i;
+	for (i = nr_pages - 1; i > 0; i--) {
+		j = corpus_rand(&state) % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+
+	for (i = 0; i < nr_pages; i++) {
+		off = (off_t)order[i] * page_size;
+
+		start = android_bench_now();
+		if (pread(fd, rbuf, page_size, off) != (ssize_t)page_size) {
+			ret = errno ?: EIO;
+			fprintf(stderr, "read of page %u: %s\n", order[i], strerror(ret));
+			goto out;
+		}
+		in_ns[i] = android_bench_now() - start;
+		runtime_in += in_ns[i];
+
+		corpus_fill(check, order[i]);
+		if (memcmp(rbuf, check, page_size)) {
+			fprintf(stderr, "page %u read back corrupted\n", order[i]);
+			ret = EIO;
+			goto out;
+		}
+	}
+
+	if (bench_format == BENCH_FORMAT_DEFAULT) {
+		printf("# %u pages on %s", nr_pages, device);
+		if (compr1 > compr0)
+			printf(", compressed to %.1f%%",
+			       (compr1 - compr0) * 100.0 / (orig1 - orig0 ?: 1));
+		printf("\n\n");
+		printf(" swap-out %12.3f MB/sec\n",
+		       (double)nr_pages * page_size * NSEC_PER_SEC / runtime_out / (1 << 20));
+		printf(" swap-in  %12.3f MB/sec\n\n",
+		       (double)nr_pages * page_size * NSEC_PER_SEC / runtime_in / (1 << 20));
+	}
+	android_bench_print_latency("swap-out", out_ns, nr_pages);
+	android_bench_print_latency("swap-in", in_ns, nr_pages);
+
+out:
+	/* give the memory back */
+	range[0] = 0;
+	range[1] = (u64)nr_pages * page_size;
+	ioctl(fd, BLKDISCARD, range);
+
+	free(rbuf);
+	free(wbuf);
+	free(check);
+	free(order);
+	free(in_ns);
+	free(out_ns);
+	close(fd);
+	return ret ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Helpers shared by the Android kernel subsystem benchmarks: a monotonic
+ * clock and latency percentile reports.
+ */
+
+#ifndef _ANDROID_BENCH_H
+#define _ANDROID_BENCH_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <linux/types.h>
+#include <linux/time64.h>
+#include "bench.h"
+
+static inline u64 android_bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int android_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* the sample below which per_mille of the sorted samples fall */
+static inline u64 android_bench_pct(const u64 *samples, unsigned int nr,
+				    unsigned int per_mille)
+{
+	return samples[(u64)(nr - 1) * per_mille / 1000];
+}
+
+/**
+ * android_bench_print_latency() - report percentiles of latency samples
+ * @what:	what was measured
+ * @samples:	latencies in nsecs, sorted in place
+ * @nr:		number of samples
+ *
+ * The simple format prints what, then p50 p90 p99 p99.9 and max in usecs,
+ * on one line for scripts.
+ */
+static inline void android_bench_print_latency(const char *what, u64 *samples,
+					       unsigned int nr)
+{
+	if (!nr)
+		return;
+
+	qsort(samples, nr, sizeof(*samples), android_bench_cmp);
+
+	if (bench_format == BENCH_FORMAT_SIMPLE) {
+		printf("%s %.3f %.3f %.3f %.3f %.3f\n", what,
+		       android_bench_pct(samples, nr, 500) / (double)NSEC_PER_USEC,
+		       android_bench_pct(samples, nr, 900) / (double)NSEC_PER_USEC,
+		       android_bench_pct(samples, nr, 990) / (double)NSEC_PER_USEC,
+		       android_bench_pct(samples, nr, 999) / (double)NSEC_PER_USEC,
+		       samples[nr - 1] / (double)NSEC_PER_USEC);
+		return;
+	}
+
+	printf(" %-14s p50 %9.3f  p90 %9.3f  p99 %9.3f  p99.9 %9.3f  max %9.3f usecs (%u samples)\n",
+	       what,
+	       android_bench_pct(samples, nr, 500) / (double)NSEC_PER_USEC,
+	       android_bench_pct(samples, nr, 900) / (double)NSEC_PER_USEC,
+	       android_bench_pct(samples, nr, 990) / (double)NSEC_PER_USEC,
+	       android_bench_pct(samples, nr, 999) / (double)NSEC_PER_USEC,
+	       samples[nr - 1] / (double)NSEC_PER_USEC, nr);
+}
+
+#endif /* _ANDROID_BENCH_H */
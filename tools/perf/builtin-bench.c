@@ -13,6 +13,7 @@
  *  mem   ... memory access performance
  *  numa  ... NUMA scheduling and MM performance
  *  futex ... Futex performance
+ *  android ... Android kernel subsystem performance
  */
 #include "perf.h"
 #include "util/util.h"
@@ -66,6 +67,14 @@ static struct bench futex_benchmarks[] = {
 	{ NULL,		NULL,						NULL			}
 };
 
+static struct bench android_benchmarks[] = {
+	{ "binder",	"Benchmark for binder transaction latency and throughput", bench_android_binder },
+	{ "ion",	"Benchmark for ION allocate, map and free cycles",	bench_android_ion	},
+	{ "zram",	"Benchmark for zram swap-out and swap-in",	bench_android_zram	},
+	{ "all",	"Run all Android benchmarks",			NULL			},
+	{ NULL,		NULL,						NULL			}
+};
+
 struct collection {
 	const char	*name;
 	const char	*summary;
@@ -79,6 +88,7 @@ static struct collection collections[] = {
 	{ "numa",	"NUMA scheduling and MM benchmarks",		numa_benchmarks		},
 #endif
 	{"futex",       "Futex stressing benchmarks",                   futex_benchmarks        },
+	{ "android",	"Android kernel subsystem benchmarks",		android_benchmarks	},
 	{ "all",	"All benchmarks",				NULL			},
 	{ NULL,		NULL,						NULL			}
 };
@@ -7,6 +7,7 @@ include/uapi/linux/stat.h
 include/linux/bits.h
 include/linux/hash.h
 include/uapi/linux/hw_breakpoint.h
+include/uapi/linux/android/binder.h
 arch/x86/include/asm/disabled-features.h
 arch/x86/include/asm/required-features.h
 arch/x86/include/asm/cpufeatures.h